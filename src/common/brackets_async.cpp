@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#include "common/brackets_async.h"
+#include "common/brackets_fs.h"
+
+namespace Brackets {
+
+namespace {
+
+class FlushCompletionsTask : public CefTask
+{
+public:
+    virtual void Execute(CefThreadId threadId)
+    {
+        RequestRegistry::GetInstance().FlushCompletions();
+    }
+
+    IMPLEMENT_REFCOUNTING(FlushCompletionsTask);
+};
+
+class DeliverProgressTask : public CefTask
+{
+public:
+    explicit DeliverProgressTask(int id) : m_id(id) {}
+
+    virtual void Execute(CefThreadId threadId)
+    {
+        RequestRegistry::GetInstance().DeliverProgress(m_id);
+    }
+
+private:
+    int m_id;
+
+    IMPLEMENT_REFCOUNTING(DeliverProgressTask);
+};
+
+class ExpireRequestTask : public CefTask
+{
+public:
+    explicit ExpireRequestTask(int id) : m_id(id) {}
+
+    virtual void Execute(CefThreadId threadId)
+    {
+        RequestRegistry::GetInstance().Expire(m_id);
+    }
+
+private:
+    int m_id;
+
+    IMPLEMENT_REFCOUNTING(ExpireRequestTask);
+};
+
+} // namespace
+
+bool InvokeCallback(CefRefPtr<CefV8Context> context,
+                    CefRefPtr<CefV8Value> callback,
+                    const CefV8ValueList& arguments)
+{
+    if (!context.get() || !callback.get() || !callback->IsFunction())
+        return false;
+
+    CefRefPtr<CefV8Value> objectForThis = context->GetGlobal();
+    CefRefPtr<CefV8Value> r;
+    CefRefPtr<CefV8Exception> e;
+
+    return callback->ExecuteFunctionWithContext(context, objectForThis, arguments, r, e, false);
+}
+
+///
+// AsyncOperation
+///
+AsyncOperation::AsyncOperation() : m_id(0), m_error(NO_ERROR), m_progressPosted(false)
+{
+}
+
+AsyncOperation::~AsyncOperation()
+{
+}
+
+int AsyncOperation::Start(const CefV8ValueList& arguments, size_t callbackIndex,
+                          CefRefPtr<CefV8Value>& retval)
+{
+    return Start(arguments, arguments.size(), callbackIndex, retval);
+}
+
+int AsyncOperation::Start(const CefV8ValueList& arguments, size_t progressIndex, size_t callbackIndex,
+                          CefRefPtr<CefV8Value>& retval)
+{
+    if (arguments.size() <= callbackIndex || !arguments[callbackIndex]->IsFunction())
+        return ERR_INVALID_PARAMS;
+
+    // progressIndex is past the end when there is no progress callback
+    CefRefPtr<CefV8Value> progress;
+    if (progressIndex < arguments.size()) {
+        if (!arguments[progressIndex]->IsFunction())
+            return ERR_INVALID_PARAMS;
+        progress = arguments[progressIndex];
+    }
+
+    int timeoutMs = 0;
+    if (arguments.size() > callbackIndex + 1) {
+        if (arguments.size() > callbackIndex + 2 || !arguments[callbackIndex + 1]->IsInt())
+            return ERR_INVALID_PARAMS;
+        timeoutMs = arguments[callbackIndex + 1]->GetIntValue();
+    }
+
+    m_id = RequestRegistry::GetInstance().Add(this, arguments[callbackIndex],
+                                              CefV8Context::GetCurrentContext(), timeoutMs, progress);
+    WorkerPool::GetInstance().PostTask(this);
+
+    retval = CefV8Value::CreateInt(m_id);
+    return NO_ERROR;
+}
+
+void AsyncOperation::Execute(CefThreadId threadId)
+{
+    m_error = IsCancelled() ? ERR_CANCELLED : Run();
+    RequestRegistry::GetInstance().PostCompletion(this);
+}
+
+void AsyncOperation::PostProgress(int delayMs)
+{
+    AutoLock lock(m_progressLock);
+    if (m_progressPosted)
+        return;
+
+    m_progressPosted = true;
+    CefPostDelayedTask(TID_UI, new DeliverProgressTask(m_id), delayMs);
+}
+
+///
+// RequestRegistry
+///
+RequestRegistry::RequestRegistry() : m_nextId(1), m_flushPosted(false)
+{
+}
+
+RequestRegistry& RequestRegistry::GetInstance()
+{
+    // Created on the UI thread by the first AsyncOperation::Start
+    static RequestRegistry* s_instance = NULL;
+    if (!s_instance)
+        s_instance = new RequestRegistry();
+    return *s_instance;
+}
+
+int RequestRegistry::Add(CefRefPtr<AsyncOperation> operation,
+                         CefRefPtr<CefV8Value> callback,
+                         CefRefPtr<CefV8Context> context,
+                         int timeoutMs,
+                         CefRefPtr<CefV8Value> progress)
+{
+    int id = m_nextId++;
+    if (m_nextId <= 0)
+        m_nextId = 1;
+
+    Request& request = m_requests[id];
+    request.operation = operation;
+    request.callback = callback;
+    request.progress = progress;
+    request.context = context;
+
+    if (timeoutMs > 0)
+        CefPostDelayedTask(TID_UI, new ExpireRequestTask(id), timeoutMs);
+
+    return id;
+}
+
+bool RequestRegistry::Cancel(int id)
+{
+    std::map<int, Request>::iterator it = m_requests.find(id);
+    if (it == m_requests.end())
+        return false;
+
+    it->second.operation->Cancel();
+    Finish(id, ERR_CANCELLED);
+    return true;
+}
+
+void RequestRegistry::Expire(int id)
+{
+    std::map<int, Request>::iterator it = m_requests.find(id);
+    if (it == m_requests.end())
+        return;
+
+    it->second.operation->Cancel();
+    Finish(id, ERR_TIMEOUT);
+}
+
+void RequestRegistry::DeliverProgress(int id)
+{
+    // Finished, cancelled and released requests are already gone
+    std::map<int, Request>::iterator it = m_requests.find(id);
+    if (it == m_requests.end())
+        return;
+
+    // Progress queued from here on needs a new delivery
+    Request request = it->second;
+    {
+        AutoLock lock(request.operation->m_progressLock);
+        request.operation->m_progressPosted = false;
+    }
+
+    // This is a posted task, not a V8 callback, so the context has to be
+    // entered before the arguments can be made
+    if (!request.context->Enter())
+        return;
+
+    // The callback may cancel the request, or release the context
+    CefV8ValueList args;
+    while (request.operation->TakeProgress(args)) {
+        InvokeCallback(request.context, request.progress, args);
+        args.clear();
+        if (m_requests.find(id) == m_requests.end())
+            break;
+    }
+    request.context->Exit();
+}
+
+void RequestRegistry::ReleaseContext(CefRefPtr<CefV8Context> context)
+{
+    std::map<int, Request>::iterator it = m_requests.begin();
+    while (it != m_requests.end()) {
+        if (it->second.context->IsSame(context)) {
+            it->second.operation->Cancel();
+            m_requests.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void RequestRegistry::PostCompletion(CefRefPtr<AsyncOperation> operation)
+{
+    AutoLock lock(m_completedLock);
+    m_completed.push_back(operation);
+
+    // One task per batch. Operations that finish before it runs ride along.
+    if (!m_flushPosted) {
+        m_flushPosted = true;
+        CefPostTask(TID_UI, new FlushCompletionsTask());
+    }
+}
+
+void RequestRegistry::FlushCompletions()
+{
+    std::vector<CefRefPtr<AsyncOperation> > completed;
+    {
+        AutoLock lock(m_completedLock);
+        completed.swap(m_completed);
+        m_flushPosted = false;
+    }
+
+    for (size_t i = 0; i < completed.size(); i++) {
+        // Cancelled, expired and released requests are already gone
+        if (m_requests.find(completed[i]->GetId()) != m_requests.end())
+            Finish(completed[i]->GetId(), completed[i]->GetError());
+    }
+}
+
+void RequestRegistry::Finish(int id, int error)
+{
+    std::map<int, Request>::iterator it = m_requests.find(id);
+    Request request = it->second;
+    m_requests.erase(it);
+
+    // Completions, progress and timeouts arrive as posted tasks, outside any
+    // V8 callback, so results are built inside the request's own context
+    if (!request.context->Enter())
+        return;
+
+    // Progress still queued comes first
+    CefV8ValueList args;
+    if (error == NO_ERROR && request.progress.get()) {
+        while (request.operation->TakeProgress(args)) {
+            InvokeCallback(request.context, request.progress, args);
+            args.clear();
+        }
+    }
+
+    args.push_back(CefV8Value::CreateInt(error));
+    if (error == NO_ERROR) {
+        CefRefPtr<CefV8Value> result = request.operation->GetResult();
+        if (result.get())
+            args.push_back(result);
+    }
+
+    InvokeCallback(request.context, request.callback, args);
+    request.context->Exit();
+}
+
+int ExecuteCancelRequest(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+{
+    if (arguments.size() != 1 || !arguments[0]->IsInt())
+        return ERR_INVALID_PARAMS;
+
+    retval = CefV8Value::CreateBool(RequestRegistry::GetInstance().Cancel(arguments[0]->GetIntValue()));
+    return NO_ERROR;
+}
+
+} // namespace Brackets
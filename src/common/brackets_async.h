@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#ifndef _BRACKETS_ASYNC_H
+#define _BRACKETS_ASYNC_H
+
+#include "include/cef.h"
+#include "common/brackets_thread.h"
+
+#include <map>
+#include <vector>
+
+namespace Brackets {
+
+// Calls the JS function |callback| with |arguments|, using the global object
+// of |context| as 'this'. Must be called on the UI thread.
+bool InvokeCallback(CefRefPtr<CefV8Context> context,
+                    CefRefPtr<CefV8Value> callback,
+                    const CefV8ValueList& arguments);
+
+/**
+ * Base class for native functions that do their work off the UI thread and
+ * report back to a JS callback as callback(err, result).
+ *
+ * Start() is called by the V8 handler on the UI thread. It registers the
+ * callback with the RequestRegistry and posts the operation to the
+ * WorkerPool, where Run() executes. Run() must only use the plain C++ members
+ * of the subclass, never V8 values. When it is done the registry delivers the
+ * result on the UI thread: GetResult() converts it to a V8 value and the
+ * callback is invoked.
+ *
+ * Operations that produce results bit by bit can also have a progress
+ * callback. Run() queues what it has and calls PostProgress(); on the UI
+ * thread TakeProgress() turns the queue into arguments for the progress
+ * callback. Whatever is still queued when Run() returns is delivered before
+ * the final callback.
+ */
+class AsyncOperation : public CefTask
+{
+public:
+    AsyncOperation();
+    virtual ~AsyncOperation();
+
+    // Starts the operation with the JS function in arguments[callbackIndex]
+    // as its callback. An optional timeout in milliseconds may follow the
+    // callback. On success |retval| is set to the request id, which JS can
+    // pass to CancelRequest. Returns NO_ERROR, or ERR_INVALID_PARAMS if the
+    // callback or the timeout is missing or of the wrong type.
+    int Start(const CefV8ValueList& arguments, size_t callbackIndex,
+              CefRefPtr<CefV8Value>& retval);
+
+    // Same, with the JS function in arguments[progressIndex] as the progress
+    // callback
+    int Start(const CefV8ValueList& arguments, size_t progressIndex, size_t callbackIndex,
+              CefRefPtr<CefV8Value>& retval);
+
+    // Runs the operation on a worker thread
+    virtual void Execute(CefThreadId threadId);
+
+    // Stops the operation from running if it has not started yet. Called by
+    // the registry when the request is cancelled or times out.
+    void Cancel() { m_cancelled.Set(); }
+    bool IsCancelled() const { return m_cancelled.IsSet(); }
+
+    int GetId() const { return m_id; }
+    int GetError() const { return m_error; }
+
+    // Builds the second callback argument on the UI thread. Only called when
+    // Run() succeeded. Returns NULL to pass the error code alone.
+    virtual CefRefPtr<CefV8Value> GetResult() { return NULL; }
+
+    // Builds the arguments of one call to the progress callback from what
+    // Run() has queued, on the UI thread. Returns false when nothing is left.
+    virtual bool TakeProgress(CefV8ValueList& arguments) { return false; }
+
+protected:
+    // Does the work on a worker thread. Returns a brackets error code.
+    // Long-running operations should check IsCancelled() now and then.
+    virtual int Run() =0;
+
+    // Has the progress callback called with what Run() queued, |delayMs|
+    // from now. Calls made before that are covered by the same delivery, so
+    // progress arrives in batches.
+    void PostProgress(int delayMs);
+
+private:
+    friend class RequestRegistry;
+
+    int m_id;
+    int m_error;
+    AtomicFlag m_cancelled;
+
+    Lock m_progressLock;
+    bool m_progressPosted;
+
+    IMPLEMENT_REFCOUNTING(AsyncOperation);
+};
+
+/**
+ * Keeps track of the async operations that JS is waiting for.
+ *
+ * Each request maps an id to the operation, the JS callback and the V8
+ * context it was started from. The callback is invoked exactly once: with the
+ * result of the operation, with ERR_CANCELLED after CancelRequest, or with
+ * ERR_TIMEOUT if the request had a timeout and it ran out first. Requests of
+ * a context that is released are dropped without calling back.
+ *
+ * Worker threads report finished operations with PostCompletion. Completions
+ * are queued and delivered to JS in batches, with a single UI-thread task for
+ * everything that finished since the last batch, instead of one task each.
+ * Results and progress arguments are built after entering the request's
+ * context, since those tasks do not run inside a V8 callback.
+ *
+ * All other methods must be called on the UI thread.
+ */
+class RequestRegistry
+{
+public:
+    static RequestRegistry& GetInstance();
+
+    // Registers |operation| and returns its request id
+    int Add(CefRefPtr<AsyncOperation> operation,
+            CefRefPtr<CefV8Value> callback,
+            CefRefPtr<CefV8Context> context,
+            int timeoutMs,
+            CefRefPtr<CefV8Value> progress = NULL);
+
+    // Calls back request |id| with ERR_CANCELLED. Returns false if it is no
+    // longer pending.
+    bool Cancel(int id);
+
+    // Drops every request started from |context| without calling back
+    void ReleaseContext(CefRefPtr<CefV8Context> context);
+
+    size_t GetPendingCount() const { return m_requests.size(); }
+
+    // Called on a worker thread when |operation| is done
+    void PostCompletion(CefRefPtr<AsyncOperation> operation);
+
+    // Delivers the queued completions. Runs as a UI-thread task.
+    void FlushCompletions();
+
+    // Calls back request |id| with ERR_TIMEOUT if it is still pending
+    void Expire(int id);
+
+    // Calls the progress callback of request |id| with what its operation
+    // has queued. Runs as a UI-thread task, see AsyncOperation::PostProgress.
+    void DeliverProgress(int id);
+
+private:
+    RequestRegistry();
+
+    struct Request {
+        CefRefPtr<AsyncOperation> operation;
+        CefRefPtr<CefV8Value> callback;
+        CefRefPtr<CefV8Value> progress;
+        CefRefPtr<CefV8Context> context;
+    };
+
+    // Removes request |id| and calls it back with |error|, plus the result
+    // of the operation on success
+    void Finish(int id, int error);
+
+    std::map<int, Request> m_requests;
+    int m_nextId;
+
+    // Shared with the worker threads
+    Lock m_completedLock;
+    std::vector<CefRefPtr<AsyncOperation> > m_completed;
+    bool m_flushPosted;
+};
+
+// CancelRequest(id): cancels the async request |id|. Returns true if it was
+// still pending, in which case its callback has been called with
+// ERR_CANCELLED.
+int ExecuteCancelRequest(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception);
+
+} // namespace Brackets
+
+#endif // _BRACKETS_ASYNC_H
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_content_cache.h"
+#include "common/brackets_fs_extension.h"
+
+#include <time.h>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+// Files modified this recently are read but not kept, see ContentCache
+const long long kRacySeconds = 2;
+
+bool IsUTF8Encoding(const ExtensionString& encoding)
+{
+#if defined(OS_WIN)
+    return encoding == L"utf8";
+#else
+    return encoding == "utf8";
+#endif
+}
+
+bool IsSameFile(const FileInfo& a, const FileInfo& b)
+{
+    return a.isDirectory == b.isDirectory && a.size == b.size && a.mtimeSec == b.mtimeSec &&
+           a.mtimeNsec == b.mtimeNsec;
+}
+
+} // namespace
+
+ContentCache& ContentCache::GetInstance()
+{
+    // Never deleted: worker threads may still be using it while the process exits
+    static ContentCache* s_instance = NULL;
+    if (!s_instance)
+        s_instance = new ContentCache();
+    return *s_instance;
+}
+
+int ContentCache::ReadFile(const ExtensionString& path, const ExtensionString& encoding, std::string& contents,
+                           TextLayout* layout, TextEncoding* detected)
+{
+    if (!IsUTF8Encoding(encoding))
+        return FileSystem::ReadFile(path, encoding, contents, layout, detected);
+    if (detected)
+        *detected = ENCODING_UTF8;
+
+    unsigned long long budget;
+    {
+        AutoLock lock(m_lock);
+        budget = m_budget;
+    }
+    if (budget == 0)
+        return FileSystem::ReadFile(path, encoding, contents, layout);
+
+    FileInfo info;
+    int statError = GetFileInfo(path, info);
+
+    CefRefPtr<Contents> cached;
+    {
+        AutoLock lock(m_lock);
+        EntryMap::iterator it = m_paths.find(path);
+        if (it != m_paths.end()) {
+            if (statError == NO_ERROR && IsSameFile(it->second->info, info)) {
+                m_entries.splice(m_entries.begin(), m_entries, it->second);
+                cached = it->second->contents;
+                m_stats.hits++;
+            } else {
+                Erase(it);
+                m_stats.stale++;
+            }
+        }
+        if (!cached.get())
+            m_stats.misses++;
+    }
+
+    // The copy is made outside the lock; the entry may be evicted meanwhile,
+    // but |cached| keeps its contents alive
+    if (cached.get()) {
+        contents = cached->text;
+        if (layout) {
+            layout->Feed(contents.data(), contents.size());
+            layout->Finish();
+        }
+        return NO_ERROR;
+    }
+
+    int error = FileSystem::ReadFile(path, encoding, contents, layout);
+    if (error != NO_ERROR)
+        return error;
+
+    // Only contents that match the file before and after the read are kept
+    if (statError == NO_ERROR && !info.isDirectory && contents.size() == info.size &&
+        info.mtimeSec < (long long)time(NULL) - kRacySeconds) {
+        FileInfo after;
+        if (GetFileInfo(path, after) == NO_ERROR && IsSameFile(after, info))
+            Add(path, info, contents);
+    }
+    return NO_ERROR;
+}
+
+void ContentCache::Add(const ExtensionString& path, const FileInfo& info, const std::string& text)
+{
+    {
+        AutoLock lock(m_lock);
+        if (text.size() > m_budget / 4)
+            return;
+    }
+
+    Entry entry;
+    entry.path = path;
+    entry.info = info;
+    entry.contents = new Contents();
+    entry.contents->text = text;
+
+    AutoLock lock(m_lock);
+    EntryMap::iterator it = m_paths.find(path);
+    if (it != m_paths.end())
+        Erase(it);
+    m_entries.push_front(entry);
+    m_paths[path] = m_entries.begin();
+    m_bytes += text.size();
+    Evict(m_budget);
+}
+
+void ContentCache::PathChanged(const ExtensionString& path)
+{
+    AutoLock lock(m_lock);
+    EntryMap::iterator it = m_paths.lower_bound(path);
+    while (it != m_paths.end() && it->first.compare(0, path.length(), path) == 0) {
+        const ExtensionString& key = it->first;
+        if (key.length() == path.length() || key[path.length()] == '/' || key[path.length()] == '\\')
+            Erase(it++);
+        else
+            ++it;
+    }
+}
+
+void ContentCache::SetBudget(unsigned long long budget)
+{
+    AutoLock lock(m_lock);
+    m_budget = budget;
+    Evict(budget);
+}
+
+void ContentCache::Erase(EntryMap::iterator it)
+{
+    m_bytes -= it->second->contents->text.size();
+    m_entries.erase(it->second);
+    m_paths.erase(it);
+}
+
+void ContentCache::Evict(unsigned long long budget)
+{
+    while (m_bytes > budget && !m_entries.empty()) {
+        Erase(m_paths.find(m_entries.back().path));
+        m_stats.evictions++;
+    }
+}
+
+ContentCache::Stats ContentCache::GetStats() const
+{
+    AutoLock lock(m_lock);
+    Stats stats = m_stats;
+    stats.bytes = m_bytes;
+    stats.budget = m_budget;
+    stats.entries = m_paths.size();
+    return stats;
+}
+
+int ExecuteSetContentCacheBudget(const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefString& exception)
+{
+    unsigned long long budget;
+    if (arguments.size() != 1 || !GetNumberValue(arguments[0], budget))
+        return ERR_INVALID_PARAMS;
+
+    ContentCache::GetInstance().SetBudget(budget);
+    return NO_ERROR;
+}
+
+int ExecuteGetContentCacheStats(const CefV8ValueList& arguments,
+                                CefRefPtr<CefV8Value>& retval,
+                                CefString& exception)
+{
+    if (arguments.size() != 0)
+        return ERR_INVALID_PARAMS;
+
+    ContentCache::Stats stats = ContentCache::GetInstance().GetStats();
+    unsigned long long reads = stats.hits + stats.misses;
+
+    retval = CefV8Value::CreateObject(NULL);
+    retval->SetValue("hits", CefV8Value::CreateDouble((double)stats.hits), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("misses", CefV8Value::CreateDouble((double)stats.misses), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("hitRatio", CefV8Value::CreateDouble(reads ? (double)stats.hits / reads : 0.0),
+                     V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("stale", CefV8Value::CreateDouble((double)stats.stale), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("evictions", CefV8Value::CreateDouble((double)stats.evictions), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("bytes", CefV8Value::CreateDouble((double)stats.bytes), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("budget", CefV8Value::CreateDouble((double)stats.budget), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("entries", CefV8Value::CreateDouble((double)stats.entries), V8_PROPERTY_ATTRIBUTE_NONE);
+    return NO_ERROR;
+}
+
+} // namespace FileSystem
+} // namespace Brackets
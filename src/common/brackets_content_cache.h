@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_CONTENT_CACHE_H
+#define _BRACKETS_CONTENT_CACHE_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_thread.h"
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace Brackets {
+namespace FileSystem {
+
+/**
+ * Keeps the contents of the files read last, so that switching back to a
+ * file or reopening a project doesn't read them from disk again. There is
+ * one cache for the process, shared by every browser window.
+ *
+ * Each entry is checked against the size and modification time, to the
+ * nanosecond where the file system has them, of the file on every lookup,
+ * which costs a stat. Like the HashCache, a file is only kept once its
+ * modification time is a couple of seconds old, so that a write within the
+ * same tick of the file system's clock can't go unnoticed; files saved
+ * through the native functions are dropped right away.
+ *
+ * Contents are held as validated UTF-8, within a budget in bytes. When it
+ * runs out the entries used longest ago are evicted, and a file larger than
+ * a quarter of the budget is not kept at all. Thread safe.
+ */
+class ContentCache
+{
+public:
+    static ContentCache& GetInstance();
+
+    // Same as FileSystem::ReadFile, from the cache if the file hasn't changed
+    // since it was read. A hit feeds |layout| the cached contents. Only
+    // files read as 'utf8', whose text is the file itself, are cached.
+    int ReadFile(const ExtensionString& path, const ExtensionString& encoding, std::string& contents,
+                 TextLayout* layout = NULL, TextEncoding* detected = NULL);
+
+    // Drops |path|, and everything under it, after the native functions
+    // wrote or deleted it
+    void PathChanged(const ExtensionString& path);
+
+    // Evicts entries until the cache holds at most |budget| bytes. 0 turns
+    // the cache off.
+    void SetBudget(unsigned long long budget);
+
+    static const unsigned long long kDefaultBudget = 64 * 1024 * 1024;
+
+    struct Stats {
+        Stats() : hits(0), misses(0), stale(0), evictions(0), bytes(0), budget(0), entries(0) {}
+
+        unsigned long long hits;            // reads answered from the cache
+        unsigned long long misses;          // reads that went to the disk
+        unsigned long long stale;           // entries found changed on disk
+        unsigned long long evictions;       // entries dropped to stay in the budget
+        unsigned long long bytes;           // contents cached now
+        unsigned long long budget;
+        size_t entries;
+    };
+
+    Stats GetStats() const;
+
+private:
+    ContentCache() : m_budget(kDefaultBudget), m_bytes(0) {}
+
+    // Contents shared between the cache and the readers copying them out, so
+    // that the copy is made without holding the lock
+    class Contents : public CefBase
+    {
+    public:
+        std::string text;
+
+        IMPLEMENT_REFCOUNTING(Contents);
+    };
+
+    struct Entry {
+        ExtensionString path;
+        FileInfo info;
+        CefRefPtr<Contents> contents;
+    };
+
+    // Most recently used first
+    typedef std::list<Entry> EntryList;
+    typedef std::map<ExtensionString, EntryList::iterator> EntryMap;
+
+    // Adds |text|, read from |path| when it had |info|, unless it is too
+    // large for the budget
+    void Add(const ExtensionString& path, const FileInfo& info, const std::string& text);
+
+    // Called with m_lock held
+    void Erase(EntryMap::iterator it);
+    void Evict(unsigned long long budget);
+
+    mutable Lock m_lock;
+    EntryList m_entries;
+    EntryMap m_paths;
+    unsigned long long m_budget;
+    unsigned long long m_bytes;
+    Stats m_stats;
+
+    ContentCache(const ContentCache&);
+    ContentCache& operator=(const ContentCache&);
+};
+
+// Native functions for the cache, registered by brackets_fs_extension.cpp
+int ExecuteSetContentCacheBudget(const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefString& exception);
+int ExecuteGetContentCacheStats(const CefV8ValueList& arguments,
+                                CefRefPtr<CefV8Value>& retval,
+                                CefString& exception);
+
+} // namespace FileSystem
+} // namespace Brackets
+
+#endif // _BRACKETS_CONTENT_CACHE_H
@@ -0,0 +1,456 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_diff.h"
+#include "common/brackets_async.h"
+#include "common/brackets_content_cache.h"
+#include "common/brackets_fs_extension.h"
+
+#include <string.h>
+#include <algorithm>
+#include <utility>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+const unsigned long long kHashSeed = 14695981039346656037ULL;
+const unsigned long long kHashPrime = 1099511628211ULL;
+
+inline unsigned int FoldHash(unsigned long long hash)
+{
+    return (unsigned int)(hash ^ (hash >> 32));
+}
+
+// Entry of the table NumberLines looks lines up in
+struct LineSlot {
+    unsigned int hash;
+    int id;                 // index of the line in the distinct lines, -1 if empty
+};
+
+} // namespace
+
+void LineDiff::SplitLines(const std::string& text, std::vector<Line>& lines)
+{
+    const unsigned long ones = (unsigned long)-1 / 0xFF;
+    const unsigned long highs = ones * 0x80;
+    const char* begin = text.data();
+    const char* p = begin;
+    const char* end = p + text.size();
+
+    lines.clear();
+    while (p < end) {
+        const char* start = p;
+        Line line;
+        line.offset = (unsigned int)(start - begin);
+        unsigned long long hash = kHashSeed;
+
+        // Whole words with no LF go into the hash at once. A zero byte in
+        // word ^ '\n'... borrows in the subtraction and sets its high bit.
+        // Equal lines are cut into the same words, so they hash the same.
+        while ((size_t)(end - p) >= sizeof(unsigned long)) {
+            unsigned long word;
+            memcpy(&word, p, sizeof(word));
+            unsigned long lf = word ^ (ones * '\n');
+            if ((lf - ones) & ~lf & highs)
+                break;
+            hash = (hash ^ word) * kHashPrime;
+            p += sizeof(word);
+        }
+        while (p < end) {
+            unsigned char c = (unsigned char)*p++;
+            hash = (hash ^ c) * kHashPrime;
+            if (c == '\n')
+                break;
+        }
+
+        line.length = (unsigned int)(p - start);
+        line.hash = FoldHash(hash);
+        lines.push_back(line);
+    }
+}
+
+bool LineDiff::Equals(const char* aText, const Line& a, const char* bText, const Line& b)
+{
+    return a.hash == b.hash && a.length == b.length && memcmp(aText + a.offset, bText + b.offset, a.length) == 0;
+}
+
+void LineDiff::NumberLines(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd)
+{
+    size_t count = (oldEnd - oldBegin) + (newEnd - newBegin);
+    std::vector<LineSlot> slots;
+    std::vector<std::pair<const char*, const Line*> > distinct;
+    std::vector<unsigned int> ids(count);
+    std::vector<char> sides;        // of each distinct line: 1 if the old text has it, 2 the new, or both
+
+    for (size_t i = 0; i < count; i++) {
+        // Keep the table at most half full
+        if (distinct.size() * 2 >= slots.size()) {
+            LineSlot empty = { 0, -1 };
+            slots.assign(std::max(slots.size() * 2, (size_t)1024), empty);
+            for (size_t j = 0; j < distinct.size(); j++) {
+                unsigned int hash = distinct[j].second->hash;
+                size_t slot = hash & (slots.size() - 1);
+                while (slots[slot].id != -1)
+                    slot = (slot + 1) & (slots.size() - 1);
+                slots[slot].hash = hash;
+                slots[slot].id = (int)j;
+            }
+        }
+
+        bool isNew = i >= oldEnd - oldBegin;
+        const char* text = isNew ? m_newText : m_oldText;
+        const Line& line = isNew ? m_newLines[newBegin + i - (oldEnd - oldBegin)] : m_oldLines[oldBegin + i];
+        size_t slot = line.hash & (slots.size() - 1);
+        while (slots[slot].id != -1 &&
+               (slots[slot].hash != line.hash ||
+                !Equals(distinct[slots[slot].id].first, *distinct[slots[slot].id].second, text, line)))
+            slot = (slot + 1) & (slots.size() - 1);
+        if (slots[slot].id == -1) {
+            slots[slot].hash = line.hash;
+            slots[slot].id = (int)distinct.size();
+            distinct.push_back(std::make_pair(text, &line));
+            sides.push_back(0);
+        }
+        ids[i] = (unsigned int)slots[slot].id;
+        sides[ids[i]] |= isNew ? 2 : 1;
+    }
+
+    // A line that is only in one of the texts is a change whatever else is.
+    // Only the others go through the diff, which then has a lot less to do
+    // when the texts have little in common.
+    m_oldIds.clear();
+    m_newIds.clear();
+    m_oldIndexes.clear();
+    m_newIndexes.clear();
+    for (size_t i = 0; i < count; i++) {
+        bool isNew = i >= oldEnd - oldBegin;
+        size_t line = isNew ? newBegin + i - (oldEnd - oldBegin) : oldBegin + i;
+        if (sides[ids[i]] != 3) {
+            (isNew ? m_newChanged : m_oldChanged)[line] = 1;
+        } else {
+            (isNew ? m_newIds : m_oldIds).push_back(ids[i]);
+            (isNew ? m_newIndexes : m_oldIndexes).push_back((unsigned int)line);
+        }
+    }
+}
+
+void LineDiff::MarkChanged(size_t aBegin, size_t aEnd, size_t bBegin, size_t bEnd)
+{
+    for (size_t i = aBegin; i < aEnd; i++)
+        m_oldChanged[m_oldIndexes[i]] = 1;
+    for (size_t i = bBegin; i < bEnd; i++)
+        m_newChanged[m_newIndexes[i]] = 1;
+}
+
+bool LineDiff::FindMiddleSnake(size_t aBegin, size_t aEnd, size_t bBegin, size_t bEnd, size_t& aMiddle,
+                               size_t& bMiddle)
+{
+    // Paths run forward from the start and backward from the end at once,
+    // one more edit each round, until they overlap. x is the number of old
+    // lines a path has gone through on diagonal k = x - y, the backward ones
+    // counting from the end. When the difference in lengths is odd the
+    // paths meet in a forward round, otherwise in a backward one.
+    const unsigned int* a = &m_oldIds[aBegin];
+    const unsigned int* b = &m_newIds[bBegin];
+    const int n = (int)(aEnd - aBegin);
+    const int m = (int)(bEnd - bBegin);
+    const int delta = n - m;
+    const bool front = (delta & 1) != 0;
+
+    int maxD = (n + m + 1) / 2;
+    if (maxD > m_maxCost)
+        maxD = m_maxCost;
+    const int offset = maxD + 1;
+    const int length = 2 * maxD + 3;
+    m_forward.assign(length, -1);
+    m_backward.assign(length, -1);
+    m_forward[offset + 1] = 0;
+    m_backward[offset + 1] = 0;
+
+    // Diagonals whose paths have run off the bottom or the right are skipped
+    int forwardStart = 0, forwardEnd = 0, backwardStart = 0, backwardEnd = 0;
+    for (int d = 0; d < maxD; d++) {
+        if (IsCancelled())
+            return false;
+
+        for (int k = -d + forwardStart; k <= d - forwardEnd; k += 2) {
+            int index = offset + k;
+            int x;
+            if (k == -d || (k != d && m_forward[index - 1] < m_forward[index + 1]))
+                x = m_forward[index + 1];
+            else
+                x = m_forward[index - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && a[x] == b[y]) {
+                x++;
+                y++;
+            }
+            m_forward[index] = x;
+
+            if (x > n) {
+                forwardEnd += 2;
+            } else if (y > m) {
+                forwardStart += 2;
+            } else if (front) {
+                int other = offset + delta - k;
+                if (other >= 0 && other < length && m_backward[other] != -1 && x >= n - m_backward[other]) {
+                    aMiddle = aBegin + x;
+                    bMiddle = bBegin + y;
+                    return true;
+                }
+            }
+        }
+
+        for (int k = -d + backwardStart; k <= d - backwardEnd; k += 2) {
+            int index = offset + k;
+            int x;
+            if (k == -d || (k != d && m_backward[index - 1] < m_backward[index + 1]))
+                x = m_backward[index + 1];
+            else
+                x = m_backward[index - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && a[n - x - 1] == b[m - y - 1]) {
+                x++;
+                y++;
+            }
+            m_backward[index] = x;
+
+            if (x > n) {
+                backwardEnd += 2;
+            } else if (y > m) {
+                backwardStart += 2;
+            } else if (!front) {
+                int other = offset + delta - k;
+                if (other >= 0 && other < length && m_forward[other] != -1) {
+                    int forwardX = m_forward[other];
+                    if (forwardX >= n - x) {
+                        aMiddle = aBegin + forwardX;
+                        bMiddle = bBegin + (forwardX - (other - offset));
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    // Past m_maxCost edits, settle for the end of the forward path that got
+    // furthest. The path to it is found exactly and the rest is diffed
+    // again, so the edits may not be the fewest but the time stays bounded.
+    int best = -1;
+    for (int index = 0; index < length; index++) {
+        int x = m_forward[index];
+        int y = x - (index - offset);
+        if (x >= 0 && x <= n && y >= 0 && y <= m && x + y > best) {
+            best = x + y;
+            aMiddle = aBegin + x;
+            bMiddle = bBegin + y;
+        }
+    }
+    return !IsCancelled() && best > 0;
+}
+
+bool LineDiff::DiffRange(size_t aBegin, size_t aEnd, size_t bBegin, size_t bEnd)
+{
+    while (aBegin < aEnd && bBegin < bEnd && m_oldIds[aBegin] == m_newIds[bBegin]) {
+        aBegin++;
+        bBegin++;
+    }
+    while (aBegin < aEnd && bBegin < bEnd && m_oldIds[aEnd - 1] == m_newIds[bEnd - 1]) {
+        aEnd--;
+        bEnd--;
+    }
+
+    size_t aMiddle, bMiddle;
+    if (aBegin == aEnd || bBegin == bEnd ||
+        !FindMiddleSnake(aBegin, aEnd, bBegin, bEnd, aMiddle, bMiddle) ||
+        (aMiddle == aBegin && bMiddle == bBegin) || (aMiddle == aEnd && bMiddle == bEnd)) {
+        if (IsCancelled())
+            return false;
+        MarkChanged(aBegin, aEnd, bBegin, bEnd);
+        return true;
+    }
+
+    return DiffRange(aBegin, aMiddle, bBegin, bMiddle) && DiffRange(aMiddle, aEnd, bMiddle, bEnd);
+}
+
+int LineDiff::Diff(const std::string& oldText, const std::string& newText, std::vector<DiffHunk>& hunks)
+{
+    hunks.clear();
+    m_oldText = oldText.data();
+    m_newText = newText.data();
+    SplitLines(oldText, m_oldLines);
+    SplitLines(newText, m_newLines);
+
+    // The lines both texts start and end with never take part
+    size_t oldCount = m_oldLines.size();
+    size_t newCount = m_newLines.size();
+    size_t prefix = 0;
+    while (prefix < oldCount && prefix < newCount &&
+           Equals(m_oldText, m_oldLines[prefix], m_newText, m_newLines[prefix]))
+        prefix++;
+    size_t suffix = 0;
+    while (suffix < oldCount - prefix && suffix < newCount - prefix &&
+           Equals(m_oldText, m_oldLines[oldCount - suffix - 1], m_newText, m_newLines[newCount - suffix - 1]))
+        suffix++;
+
+    m_oldChanged.assign(oldCount, 0);
+    m_newChanged.assign(newCount, 0);
+    NumberLines(prefix, oldCount - suffix, prefix, newCount - suffix);
+
+    // As in git, the search for a shortest path gives up at about the
+    // square root of the number of lines
+    size_t lines = m_oldIds.size() + m_newIds.size();
+    m_maxCost = kMinMaxCost;
+    while ((size_t)m_maxCost * m_maxCost < lines)
+        m_maxCost *= 2;
+    if (!DiffRange(0, m_oldIds.size(), 0, m_newIds.size()))
+        return ERR_CANCELLED;
+
+    // Runs of changed lines on either side, with no unchanged line between
+    // them, make one hunk
+    size_t i = prefix, j = prefix;
+    while (i < oldCount - suffix || j < newCount - suffix) {
+        if ((i < oldCount && m_oldChanged[i]) || (j < newCount && m_newChanged[j])) {
+            DiffHunk hunk;
+            hunk.oldStart = (unsigned int)i;
+            hunk.newStart = (unsigned int)j;
+            for (;;) {
+                if (i < oldCount && m_oldChanged[i])
+                    i++;
+                else if (j < newCount && m_newChanged[j])
+                    j++;
+                else
+                    break;
+            }
+            hunk.oldCount = (unsigned int)(i - hunk.oldStart);
+            hunk.newCount = (unsigned int)(j - hunk.newStart);
+            hunks.push_back(hunk);
+        } else {
+            i++;
+            j++;
+        }
+    }
+
+    std::vector<unsigned int>().swap(m_oldIds);
+    std::vector<unsigned int>().swap(m_newIds);
+    std::vector<unsigned int>().swap(m_oldIndexes);
+    std::vector<unsigned int>().swap(m_newIndexes);
+    std::vector<int>().swap(m_forward);
+    std::vector<int>().swap(m_backward);
+    return NO_ERROR;
+}
+
+void LineDiff::GetNewText(const DiffHunk& hunk, std::string& text) const
+{
+    text.clear();
+    if (hunk.newCount == 0)
+        return;
+    const Line& first = m_newLines[hunk.newStart];
+    const Line& last = m_newLines[hunk.newStart + hunk.newCount - 1];
+    text.assign(m_newText + first.offset, last.offset + last.length - first.offset);
+}
+
+namespace {
+
+class DiffFileOperation : public AsyncOperation, public LineDiff
+{
+public:
+    // Takes over |text|, which is left empty
+    DiffFileOperation(const ExtensionString& path, std::string& text, const ExtensionString& encoding)
+        : m_path(path), m_encoding(encoding)
+    {
+        m_oldText.swap(text);
+    }
+
+    // LineDiff
+    virtual bool IsCancelled() const { return AsyncOperation::IsCancelled(); }
+
+    virtual CefRefPtr<CefV8Value> GetResult();
+
+protected:
+    virtual int Run();
+
+private:
+    ExtensionString m_path;
+    ExtensionString m_encoding;
+    std::string m_oldText;
+    std::string m_newText;
+    std::vector<DiffHunk> m_hunks;
+};
+
+int DiffFileOperation::Run()
+{
+    int error = ContentCache::GetInstance().ReadFile(m_path, m_encoding, m_newText);
+    if (error != NO_ERROR)
+        return error;
+    return Diff(m_oldText, m_newText, m_hunks);
+}
+
+CefRefPtr<CefV8Value> DiffFileOperation::GetResult()
+{
+    CefRefPtr<CefV8Value> hunks = CefV8Value::CreateArray();
+    CefRefPtr<CefV8Value> texts = CefV8Value::CreateArray();
+    std::string text;
+    for (size_t i = 0; i < m_hunks.size(); i++) {
+        const DiffHunk& hunk = m_hunks[i];
+        hunks->SetValue((int)(i * 4), CefV8Value::CreateInt((int)hunk.oldStart));
+        hunks->SetValue((int)(i * 4 + 1), CefV8Value::CreateInt((int)hunk.oldCount));
+        hunks->SetValue((int)(i * 4 + 2), CefV8Value::CreateInt((int)hunk.newStart));
+        hunks->SetValue((int)(i * 4 + 3), CefV8Value::CreateInt((int)hunk.newCount));
+        GetNewText(hunk, text);
+        texts->SetValue((int)i, CefV8Value::CreateString(text));
+    }
+
+    CefRefPtr<CefV8Value> result = CefV8Value::CreateObject(NULL);
+    result->SetValue("hunks", hunks, V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("texts", texts, V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("oldLines", CefV8Value::CreateInt((int)GetOldLineCount()), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("newLines", CefV8Value::CreateInt((int)GetNewLineCount()), V8_PROPERTY_ATTRIBUTE_NONE);
+    return result;
+}
+
+} // namespace
+
+int ExecuteDiffFileAsync(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+{
+    if (arguments.size() < 4 || !arguments[1]->IsString() || !arguments[2]->IsString())
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    std::string text;
+    GetUTF8StringValue(arguments[1], text);
+    ExtensionString encoding = arguments[2]->GetStringValue();
+
+    CefRefPtr<AsyncOperation> operation = new DiffFileOperation(*path, text, encoding);
+    return operation->Start(arguments, 3, retval);
+}
+
+} // namespace FileSystem
+} // namespace Brackets
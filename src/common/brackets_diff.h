@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_DIFF_H
+#define _BRACKETS_DIFF_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+
+#include <string>
+#include <vector>
+
+namespace Brackets {
+namespace FileSystem {
+
+// A run of lines that differs between two texts: |oldCount| lines of the old
+// text from line |oldStart| become |newCount| lines of the new text from
+// line |newStart|. Lines count from 0.
+struct DiffHunk {
+    unsigned int oldStart;
+    unsigned int oldCount;
+    unsigned int newStart;
+    unsigned int newCount;
+};
+
+/**
+ * Finds the lines that differ between two texts. Lines end after each LF and
+ * include it, so a change from CRLF to LF changes every line it is on.
+ *
+ * Both texts are split into lines and each line is hashed in the same pass,
+ * a word at a time. The lines the texts start and end with in common are
+ * set aside, which leaves little to compare when a file changed in a few
+ * places. The lines left are numbered through a hash table, equal lines
+ * getting the same number, and lines only one text has are changes without
+ * further ado. The rest go through Myers' O(ND) diff, in linear space by way
+ * of the middle snake. Like git, once the search for a region has taken
+ * about the square root of the number of lines in edits, the region is split
+ * where the search got furthest, so that texts with many changes cost
+ * bounded time at the price of a diff that may not be the shortest.
+ *
+ * Subclasses can stop a long diff by overriding IsCancelled.
+ */
+class LineDiff
+{
+public:
+    virtual ~LineDiff() {}
+
+    // Fills |hunks| with the changes from |oldText| to |newText|, in order.
+    // Returns NO_ERROR, or ERR_CANCELLED. Both texts must stay alive and
+    // unchanged for GetNewText.
+    int Diff(const std::string& oldText, const std::string& newText, std::vector<DiffHunk>& hunks);
+
+    size_t GetOldLineCount() const { return m_oldLines.size(); }
+    size_t GetNewLineCount() const { return m_newLines.size(); }
+
+    // The lines of the new text that |hunk| puts in, with their line endings
+    void GetNewText(const DiffHunk& hunk, std::string& text) const;
+
+    virtual bool IsCancelled() const { return false; }
+
+    // Least number of edits the search for a region may take before the
+    // region is split at a point that may not be on a shortest path
+    static const int kMinMaxCost = 256;
+
+private:
+    // Offsets are 32-bit to keep lines small; V8 strings are shorter than
+    // 4 GB anyway
+    struct Line {
+        unsigned int offset;
+        unsigned int length;
+        unsigned int hash;
+    };
+
+    static void SplitLines(const std::string& text, std::vector<Line>& lines);
+    // Whether line |a| of |aText| is the same as line |b| of |bText|
+    static bool Equals(const char* aText, const Line& a, const char* bText, const Line& b);
+
+    // Numbers the lines in [oldBegin, oldEnd) and [newBegin, newEnd), marks
+    // those only one side has as changed and lists the others in m_oldIds
+    // and m_newIds
+    void NumberLines(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd);
+
+    // Marks what changed between m_oldIds [aBegin, aEnd) and m_newIds
+    // [bBegin, bEnd). Returns false if cancelled.
+    bool DiffRange(size_t aBegin, size_t aEnd, size_t bBegin, size_t bEnd);
+
+    // Finds a point on a shortest edit path through the region, past its
+    // first edit and before its last, or a point m_maxCost edits along some
+    // path if the shortest takes more. Returns false if cancelled.
+    bool FindMiddleSnake(size_t aBegin, size_t aEnd, size_t bBegin, size_t bEnd, size_t& aMiddle,
+                         size_t& bMiddle);
+
+    void MarkChanged(size_t aBegin, size_t aEnd, size_t bBegin, size_t bEnd);
+
+    const char* m_oldText;
+    const char* m_newText;
+    std::vector<Line> m_oldLines;
+    std::vector<Line> m_newLines;
+    // Numbers of the lines both texts have, and where each one is
+    std::vector<unsigned int> m_oldIds;
+    std::vector<unsigned int> m_newIds;
+    std::vector<unsigned int> m_oldIndexes;
+    std::vector<unsigned int> m_newIndexes;
+
+    std::vector<char> m_oldChanged;
+    std::vector<char> m_newChanged;
+    int m_maxCost;
+
+    // Furthest reaching paths forward and backward, by diagonal
+    std::vector<int> m_forward;
+    std::vector<int> m_backward;
+};
+
+// DiffFileAsync, registered by brackets_fs_extension.cpp
+int ExecuteDiffFileAsync(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception);
+
+} // namespace FileSystem
+} // namespace Brackets
+
+#endif // _BRACKETS_DIFF_H
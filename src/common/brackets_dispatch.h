@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#ifndef _BRACKETS_DISPATCH_H
+#define _BRACKETS_DISPATCH_H
+
+#include "include/cef.h"
+
+#include <string.h>
+#include <vector>
+
+namespace Brackets {
+
+/**
+ * Maps the names of native functions to the code that runs them.
+ *
+ * CEF calls a single CefV8Handler::Execute for every `native function`
+ * declared in brackets_extensions.js and passes the name along. Instead of
+ * comparing that name against each function in turn, handlers register their
+ * functions once and look them up here. The table is a perfect hash: when a
+ * function is added, a hash seed is chosen so that every registered name has
+ * a slot of its own, and Find() costs one hash and one name compare.
+ *
+ * Function is whatever the handler calls, usually a pointer to a member or a
+ * free function taking (arguments, retval, exception). Names must be ASCII.
+ */
+template <class Function>
+class NativeFunctionTable
+{
+public:
+    NativeFunctionTable() : m_seed(0), m_mask(0) {}
+
+    // Registers |function| as |name|, replacing any earlier registration
+    void Add(const char* name, Function function)
+    {
+        for (size_t i = 0; i < m_entries.size(); i++) {
+            if (Equals(m_entries[i], name, strlen(name))) {
+                m_entries[i].function = function;
+                return;
+            }
+        }
+
+        Entry entry;
+        entry.name = name;
+        entry.length = strlen(name);
+        entry.function = function;
+        m_entries.push_back(entry);
+        Rehash();
+    }
+
+    // Returns the function registered as |name|, or a null Function
+    Function Find(const CefString& name) const
+    {
+        if (m_slots.empty())
+            return Function();
+
+        int index = m_slots[Hash(name.c_str(), name.length(), m_seed) & m_mask];
+        if (index < 0 || !Equals(m_entries[index], name.c_str(), name.length()))
+            return Function();
+
+        return m_entries[index].function;
+    }
+
+    size_t size() const { return m_entries.size(); }
+    const char* GetName(size_t index) const { return m_entries[index].name; }
+
+private:
+    struct Entry {
+        const char* name;
+        size_t length;
+        Function function;
+    };
+
+    // FNV-1a over the characters of the name, whatever their width
+    template <class Char>
+    static unsigned int Hash(const Char* chars, size_t length, unsigned int seed)
+    {
+        unsigned int hash = 2166136261U ^ seed;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (unsigned int)chars[i];
+            hash *= 16777619U;
+        }
+        return hash;
+    }
+
+    template <class Char>
+    static bool Equals(const Entry& entry, const Char* chars, size_t length)
+    {
+        if (entry.length != length)
+            return false;
+        for (size_t i = 0; i < length; i++) {
+            if ((unsigned int)chars[i] != (unsigned char)entry.name[i])
+                return false;
+        }
+        return true;
+    }
+
+    // Finds a table size and seed for which no two names share a slot
+    void Rehash()
+    {
+        size_t size = 4;
+        while (size < m_entries.size() * 4)
+            size *= 2;
+
+        for (;;) {
+            for (unsigned int seed = 0; seed < 256; seed++) {
+                std::vector<int> slots(size, -1);
+                bool collision = false;
+                for (size_t i = 0; i < m_entries.size() && !collision; i++) {
+                    int& slot = slots[Hash(m_entries[i].name, m_entries[i].length, seed) & (size - 1)];
+                    if (slot >= 0)
+                        collision = true;
+                    else
+                        slot = (int)i;
+                }
+                if (!collision) {
+                    m_slots.swap(slots);
+                    m_seed = seed;
+                    m_mask = (unsigned int)(size - 1);
+                    return;
+                }
+            }
+            size *= 2;
+        }
+    }
+
+    std::vector<Entry> m_entries;
+    std::vector<int> m_slots;
+    unsigned int m_seed;
+    unsigned int m_mask;
+};
+
+} // namespace Brackets
+
+#endif // _BRACKETS_DISPATCH_H
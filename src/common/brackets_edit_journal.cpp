@@ -0,0 +1,840 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_edit_journal.h"
+#include "common/brackets_async.h"
+#include "common/brackets_fs_extension.h"
+#include "common/brackets_hash.h"
+
+#include <algorithm>
+
+#include <stddef.h>
+#include <string.h>
+
+namespace Brackets {
+namespace FileSystem {
+
+/**
+ * Layout of a journal, in the byte order of the machine that wrote it:
+ *
+ *   JournalHeader
+ *   records, each a RecordHeader, the id of its document and the rest of
+ *   its payload:
+ *     RECORD_DOCUMENT  the path of the document, UTF-8; comes before any
+ *                      other record of the document
+ *     RECORD_SNAPSHOT  the text of the document, UTF-8
+ *     RECORD_BASE      the xxh3 digest of the file the document is the same
+ *                      as, as hex
+ *     RECORD_EDIT      offset and removed, 64 bits each, in UTF-16 code
+ *                      units, then the inserted text, UTF-8
+ *     RECORD_CLEAN     nothing; the document has no unsaved changes
+ */
+namespace {
+
+struct JournalHeader {
+    char magic[4];
+    unsigned int version;
+};
+
+struct RecordHeader {
+    unsigned int length;            // of the whole record
+    unsigned int type;
+    unsigned long long checksum;    // HashXXH3 of the record with this field 0
+};
+
+enum RecordType {
+    RECORD_DOCUMENT = 1,
+    RECORD_SNAPSHOT,
+    RECORD_BASE,
+    RECORD_EDIT,
+    RECORD_CLEAN
+};
+
+const char kJournalMagic[4] = { 'B', 'R', 'E', 'J' };
+const unsigned int kJournalVersion = 1;
+
+// Records must fit the 32-bit length
+const size_t kMaxRecordText = 0x7FFFFFFF;
+
+std::string ToUTF8(const ExtensionString& path)
+{
+#if defined(OS_WIN)
+    return CefString(path).ToString();
+#else
+    return path;
+#endif
+}
+
+ExtensionString FromUTF8(const std::string& path)
+{
+#if defined(OS_WIN)
+    return CefString(path).ToWString();
+#else
+    return path;
+#endif
+}
+
+// The directory that holds |path|, whichever separator it uses
+ExtensionString GetDirectory(const ExtensionString& path)
+{
+    size_t i = path.length();
+    while (i > 0 && path[i - 1] != '/' && path[i - 1] != '\\')
+        i--;
+    if (i == 0)
+        return ExtensionString(1, '.');
+    return path.substr(0, i > 1 ? i - 1 : 1);
+}
+
+// Appends the UTF-16 code units of |length| bytes of UTF-8 to |units|.
+// Malformed bytes become U+FFFD.
+void AppendUTF16(const char* text, size_t length, std::vector<unsigned short>& units)
+{
+    const unsigned char* bytes = (const unsigned char*)text;
+    size_t i = 0;
+    while (i < length) {
+        unsigned int c = bytes[i];
+        int extra = c < 0x80 ? 0 : c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : -1;
+        bool valid = extra >= 0 && (size_t)extra < length - i;
+        for (int k = 1; valid && k <= extra; k++)
+            valid = (bytes[i + k] & 0xC0) == 0x80;
+        if (!valid) {
+            units.push_back(0xFFFD);
+            i++;
+            continue;
+        }
+        c &= extra == 0 ? 0x7F : 0x3F >> extra;
+        for (int k = 1; k <= extra; k++)
+            c = (c << 6) | (bytes[i + k] & 0x3F);
+        i += extra + 1;
+        if (c >= 0x10000) {
+            units.push_back((unsigned short)(0xD800 + ((c - 0x10000) >> 10)));
+            units.push_back((unsigned short)(0xDC00 + ((c - 0x10000) & 0x3FF)));
+        } else {
+            units.push_back((unsigned short)c);
+        }
+    }
+}
+
+/**
+ * Text as UTF-16 code units, the unit of the offsets in edit records, with a
+ * gap where the last edit was made. Edits close to each other, which is how
+ * typing makes them, only move the text between them.
+ */
+class GapBuffer
+{
+public:
+    GapBuffer() : m_gapStart(0), m_gapEnd(0) {}
+
+    void Assign(const char* text, size_t length)
+    {
+        m_units.clear();
+        AppendUTF16(text, length, m_units);
+        m_gapStart = m_gapEnd = m_units.size();
+    }
+
+    void Clear()
+    {
+        std::vector<unsigned short>().swap(m_units);
+        m_gapStart = m_gapEnd = 0;
+    }
+
+    size_t GetLength() const { return m_units.size() - (m_gapEnd - m_gapStart); }
+
+    // Replaces |removed| units from |offset| with the UTF-8 |text|. The
+    // range must be within the text.
+    void Replace(size_t offset, size_t removed, const char* text, size_t length);
+
+    void GetText(std::string& text);
+
+private:
+    void MoveGap(size_t offset);
+
+    std::vector<unsigned short> m_units;
+    size_t m_gapStart;
+    size_t m_gapEnd;
+};
+
+void GapBuffer::Replace(size_t offset, size_t removed, const char* text, size_t length)
+{
+    std::vector<unsigned short> inserted;
+    AppendUTF16(text, length, inserted);
+
+    MoveGap(offset);
+    m_gapEnd += removed;
+    if (m_gapEnd - m_gapStart < inserted.size()) {
+        // Leave room for as much again as the text after this edit
+        size_t tail = m_units.size() - m_gapEnd;
+        size_t gap = inserted.size() + std::max(GetLength(), (size_t)4096);
+        std::vector<unsigned short> units(m_gapStart + gap + tail);
+        if (m_gapStart)
+            memcpy(&units[0], &m_units[0], m_gapStart * sizeof(unsigned short));
+        if (tail)
+            memcpy(&units[m_gapStart + gap], &m_units[m_gapEnd], tail * sizeof(unsigned short));
+        m_units.swap(units);
+        m_gapEnd = m_gapStart + gap;
+    }
+    if (!inserted.empty())
+        memcpy(&m_units[m_gapStart], &inserted[0], inserted.size() * sizeof(unsigned short));
+    m_gapStart += inserted.size();
+}
+
+void GapBuffer::MoveGap(size_t offset)
+{
+    if (offset < m_gapStart) {
+        size_t count = m_gapStart - offset;
+        memmove(&m_units[m_gapEnd - count], &m_units[offset], count * sizeof(unsigned short));
+        m_gapStart -= count;
+        m_gapEnd -= count;
+    } else if (offset > m_gapStart) {
+        size_t count = offset - m_gapStart;
+        memmove(&m_units[m_gapStart], &m_units[m_gapEnd], count * sizeof(unsigned short));
+        m_gapStart += count;
+        m_gapEnd += count;
+    }
+}
+
+void GapBuffer::GetText(std::string& text)
+{
+    // With the gap at the end the text is in one piece, so a surrogate pair
+    // is never split by it
+    MoveGap(GetLength());
+    UTF16ToUTF8(m_gapStart ? &m_units[0] : NULL, m_gapStart, text);
+}
+
+class JournalFlushTask : public CefTask
+{
+public:
+    virtual void Execute(CefThreadId threadId) { EditJournal::GetInstance().FlushPending(); }
+
+    IMPLEMENT_REFCOUNTING(JournalFlushTask);
+};
+
+// Waits out the commit delay on TID_FILE and hands the flush, which may
+// wait on the disk for a while, to the WorkerPool
+class JournalCommitTask : public CefTask
+{
+public:
+    virtual void Execute(CefThreadId threadId) { WorkerPool::GetInstance().PostTask(new JournalFlushTask()); }
+
+    IMPLEMENT_REFCOUNTING(JournalCommitTask);
+};
+
+} // namespace
+
+EditJournal& EditJournal::GetInstance()
+{
+    // Never deleted: a flush may still be running while the process exits
+    static EditJournal* s_instance = NULL;
+    if (!s_instance)
+        s_instance = new EditJournal();
+    return *s_instance;
+}
+
+int EditJournal::Open(const ExtensionString& path, int commitDelayMs)
+{
+    Close(false);
+
+    AutoLock fileLock(m_fileLock);
+    PlatformFile file;
+    int error = CreateFileForAppending(path, file);
+    if (error != NO_ERROR)
+        return error;
+
+    // The file itself has to survive a crash too
+    JournalHeader header;
+    memcpy(header.magic, kJournalMagic, sizeof(header.magic));
+    header.version = kJournalVersion;
+    error = AppendToFile(file, (const char*)&header, sizeof(header));
+    if (error == NO_ERROR)
+        error = SyncFile(file);
+    if (error != NO_ERROR) {
+        CloseFile(file);
+        return error;
+    }
+    SyncDirectory(GetDirectory(path));
+
+    AutoLock lock(m_lock);
+    m_file = file;
+    m_path = path;
+    m_isOpen = true;
+    m_commitDelayMs = commitDelayMs;
+    m_error = NO_ERROR;
+    m_buffer.clear();
+    m_added = 0;
+    m_durable = 0;
+    m_pendingRecords = 0;
+    m_nextDocumentId = 1;
+    m_documents.clear();
+    m_stats = Stats();
+    return NO_ERROR;
+}
+
+int EditJournal::Close(bool discard)
+{
+    unsigned long long target;
+    {
+        AutoLock lock(m_lock);
+        target = m_added;
+    }
+
+    AutoLock fileLock(m_fileLock);
+    int error = WriteBuffered(target);
+
+    ExtensionString path;
+    {
+        AutoLock lock(m_lock);
+        if (!m_isOpen)
+            return NO_ERROR;
+        m_isOpen = false;
+        path = m_path;
+        m_buffer.clear();
+        m_documents.clear();
+    }
+
+    CloseFile(m_file);
+    if (discard)
+        return DeleteFileOrDirectory(path);
+    return error;
+}
+
+int EditJournal::AddSnapshot(const ExtensionString& document, const std::string& text)
+{
+    AutoLock lock(m_lock);
+    Document* added = NULL;
+    int error = AddRecord(RECORD_SNAPSHOT, document, std::string(), text.data(), text.size(), &added);
+    if (error == NO_ERROR)
+        added->sinceSnapshot = 0;
+    return error;
+}
+
+int EditJournal::AddBase(const ExtensionString& document, const std::string& digest)
+{
+    AutoLock lock(m_lock);
+    Document* added = NULL;
+    int error = AddRecord(RECORD_BASE, document, std::string(), digest.data(), digest.size(), &added);
+    if (error == NO_ERROR)
+        added->sinceSnapshot = 0;
+    return error;
+}
+
+int EditJournal::AddClean(const ExtensionString& document)
+{
+    AutoLock lock(m_lock);
+    Document* added = NULL;
+    int error = AddRecord(RECORD_CLEAN, document, std::string(), NULL, 0, &added);
+    if (error == NO_ERROR)
+        added->sinceSnapshot = 0;
+    return error;
+}
+
+int EditJournal::AddEdit(const ExtensionString& document, unsigned long long offset, unsigned long long removed,
+                         const std::string& text, unsigned long long& sinceSnapshot)
+{
+    std::string fields;
+    fields.append((const char*)&offset, sizeof(offset));
+    fields.append((const char*)&removed, sizeof(removed));
+
+    AutoLock lock(m_lock);
+    Document* added = NULL;
+    int error = AddRecord(RECORD_EDIT, document, fields, text.data(), text.size(), &added);
+    if (error == NO_ERROR)
+        sinceSnapshot = added->sinceSnapshot;
+    return error;
+}
+
+int EditJournal::AddRecord(unsigned int type, const ExtensionString& document, const std::string& fields,
+                           const char* text, size_t length, Document** added)
+{
+    if (!m_isOpen)
+        return ERR_CANT_WRITE;
+    if (m_error != NO_ERROR)
+        return m_error;
+    if (length > kMaxRecordText)
+        return ERR_CANT_WRITE;
+
+    Document& entry = m_documents[document];
+    if (entry.id == 0) {
+        entry.id = m_nextDocumentId++;
+        std::string path = ToUTF8(document);
+        AppendRecord(RECORD_DOCUMENT, entry.id, std::string(), path.data(), path.size());
+    }
+
+    unsigned long long before = m_added;
+    AppendRecord(type, entry.id, fields, text, length);
+    entry.sinceSnapshot += m_added - before;
+    if (added)
+        *added = &entry;
+
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        CefPostDelayedTask(TID_FILE, new JournalCommitTask(), m_commitDelayMs);
+    }
+    return NO_ERROR;
+}
+
+void EditJournal::AppendRecord(unsigned int type, unsigned int id, const std::string& fields, const char* text,
+                               size_t length)
+{
+    RecordHeader header;
+    header.length = (unsigned int)(sizeof(header) + sizeof(id) + fields.size() + length);
+    header.type = type;
+    header.checksum = 0;
+
+    size_t start = m_buffer.size();
+    m_buffer.append((const char*)&header, sizeof(header));
+    m_buffer.append((const char*)&id, sizeof(id));
+    m_buffer.append(fields);
+    m_buffer.append(text, length);
+
+    unsigned long long checksum = HashXXH3(m_buffer.data() + start, header.length);
+    memcpy(&m_buffer[start + offsetof(RecordHeader, checksum)], &checksum, sizeof(checksum));
+
+    m_added += header.length;
+    m_pendingRecords++;
+    m_stats.records++;
+    m_stats.bytes += header.length;
+}
+
+int EditJournal::Flush()
+{
+    unsigned long long target;
+    {
+        AutoLock lock(m_lock);
+        target = m_added;
+    }
+
+    // A flush already under way holds the file lock. Whatever was added
+    // while it ran goes out with the next one, for every caller waiting.
+    AutoLock fileLock(m_fileLock);
+    return WriteBuffered(target);
+}
+
+void EditJournal::FlushPending()
+{
+    {
+        AutoLock lock(m_lock);
+        m_flushScheduled = false;
+    }
+    Flush();
+}
+
+int EditJournal::WriteBuffered(unsigned long long target)
+{
+    std::string batch;
+    unsigned long long end;
+    unsigned long long records;
+    {
+        AutoLock lock(m_lock);
+        if (!m_isOpen || m_durable >= target)
+            return NO_ERROR;
+        if (m_error != NO_ERROR)
+            return m_error;
+        batch.swap(m_buffer);
+        end = m_added;
+        records = m_pendingRecords;
+        m_pendingRecords = 0;
+    }
+
+    long long start = GetMonotonicTimeUs();
+    int error = AppendToFile(m_file, batch.data(), batch.size());
+    if (error == NO_ERROR)
+        error = SyncFile(m_file);
+    long long elapsed = GetMonotonicTimeUs() - start;
+
+    // A failed write may have left part of a record behind. Replaying stops
+    // there, so nothing more is written after it.
+    AutoLock lock(m_lock);
+    if (error != NO_ERROR) {
+        m_error = error;
+        return error;
+    }
+    m_durable = end;
+    m_stats.flushes++;
+    m_stats.flushedRecords += records;
+    m_stats.microseconds += elapsed;
+    return NO_ERROR;
+}
+
+EditJournal::Stats EditJournal::GetStats() const
+{
+    AutoLock lock(m_lock);
+    Stats stats = m_stats;
+    stats.pendingBytes = m_buffer.size();
+    return stats;
+}
+
+namespace {
+
+// A document while its records are replayed
+struct ReplayedDocument {
+    ReplayedDocument() : hasText(false), dirty(false), damaged(false), edits(0) {}
+
+    ExtensionString path;
+    GapBuffer text;
+    bool hasText;
+    bool dirty;
+    bool damaged;
+    unsigned long long edits;
+};
+
+void ReplayBase(ReplayedDocument& document, const std::string& digest)
+{
+    std::string contents;
+    document.hasText = ReadFile(document.path, CefString("utf8"), contents) == NO_ERROR &&
+                       HashData(HASH_XXH3, contents.data(), contents.size()) == digest;
+    if (document.hasText)
+        document.text.Assign(contents.data(), contents.size());
+    else
+        document.text.Clear();
+    document.damaged = !document.hasText;
+}
+
+void ReplayEdit(ReplayedDocument& document, const char* payload, size_t length)
+{
+    unsigned long long offset;
+    unsigned long long removed;
+    if (!document.hasText || length < sizeof(offset) + sizeof(removed))
+        return;
+    memcpy(&offset, payload, sizeof(offset));
+    memcpy(&removed, payload + sizeof(offset), sizeof(removed));
+
+    // An edit that doesn't fit the text means a record is missing
+    unsigned long long textLength = document.text.GetLength();
+    if (offset > textLength || removed > textLength - offset) {
+        document.text.Clear();
+        document.hasText = false;
+        document.damaged = true;
+        return;
+    }
+    document.text.Replace((size_t)offset, (size_t)removed, payload + sizeof(offset) + sizeof(removed),
+                          length - sizeof(offset) - sizeof(removed));
+    document.edits++;
+}
+
+} // namespace
+
+int ReplayEditJournal(const ExtensionString& path, std::vector<RecoveredDocument>& documents, bool& truncated)
+{
+    truncated = false;
+
+    PlatformFile file;
+    int error = OpenFileForReading(path, file);
+    if (error != NO_ERROR)
+        return error;
+
+    unsigned long long size;
+    error = GetOpenFileSize(file, size);
+    std::string data;
+    if (error == NO_ERROR && size > (unsigned long long)data.max_size())
+        error = ERR_CANT_READ;
+    if (error == NO_ERROR) {
+        data.resize((size_t)size);
+        size_t bytesRead = 0;
+        if (size)
+            error = ReadFileAt(file, 0, &data[0], data.size(), bytesRead);
+        data.resize(bytesRead);
+    }
+    CloseFile(file);
+    if (error != NO_ERROR)
+        return error;
+
+    JournalHeader header;
+    if (data.size() < sizeof(header))
+        return ERR_CANT_READ;
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, kJournalMagic, sizeof(header.magic)) != 0 || header.version != kJournalVersion)
+        return ERR_CANT_READ;
+
+    std::vector<ReplayedDocument> replayed;
+    std::map<unsigned int, size_t> ids;
+    size_t position = sizeof(header);
+    while (position < data.size()) {
+        RecordHeader record;
+        unsigned int id;
+        if (data.size() - position < sizeof(record) + sizeof(id)) {
+            truncated = true;
+            break;
+        }
+        memcpy(&record, data.data() + position, sizeof(record));
+        if (record.length < sizeof(record) + sizeof(id) || record.length > data.size() - position) {
+            truncated = true;
+            break;
+        }
+        memset(&data[position + offsetof(RecordHeader, checksum)], 0, sizeof(record.checksum));
+        if (HashXXH3(data.data() + position, record.length) != record.checksum) {
+            truncated = true;
+            break;
+        }
+
+        memcpy(&id, data.data() + position + sizeof(record), sizeof(id));
+        const char* payload = data.data() + position + sizeof(record) + sizeof(id);
+        size_t length = record.length - sizeof(record) - sizeof(id);
+        position += record.length;
+
+        if (record.type == RECORD_DOCUMENT) {
+            ids[id] = replayed.size();
+            replayed.push_back(ReplayedDocument());
+            replayed.back().path = FromUTF8(std::string(payload, length));
+            continue;
+        }
+
+        std::map<unsigned int, size_t>::const_iterator it = ids.find(id);
+        if (it == ids.end())
+            continue;
+        ReplayedDocument& document = replayed[it->second];
+        switch (record.type) {
+        case RECORD_SNAPSHOT:
+            document.text.Assign(payload, length);
+            document.hasText = true;
+            document.damaged = false;
+            document.dirty = true;
+            document.edits = 0;
+            break;
+        case RECORD_BASE:
+            ReplayBase(document, std::string(payload, length));
+            document.dirty = true;
+            document.edits = 0;
+            break;
+        case RECORD_EDIT:
+            ReplayEdit(document, payload, length);
+            break;
+        case RECORD_CLEAN:
+            document.text.Clear();
+            document.hasText = false;
+            document.damaged = false;
+            document.dirty = false;
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < replayed.size(); i++) {
+        if (!replayed[i].dirty)
+            continue;
+        documents.push_back(RecoveredDocument());
+        RecoveredDocument& document = documents.back();
+        document.path = replayed[i].path;
+        document.edits = replayed[i].edits;
+        document.damaged = replayed[i].damaged;
+        if (replayed[i].hasText)
+            replayed[i].text.GetText(document.text);
+        replayed[i].text.Clear();
+    }
+    return NO_ERROR;
+}
+
+namespace {
+
+class FlushEditJournalOperation : public AsyncOperation
+{
+protected:
+    virtual int Run() { return EditJournal::GetInstance().Flush(); }
+};
+
+class ReplayEditJournalOperation : public AsyncOperation
+{
+public:
+    explicit ReplayEditJournalOperation(const ExtensionString& path) : m_path(path), m_truncated(false) {}
+
+    virtual CefRefPtr<CefV8Value> GetResult()
+    {
+        CefRefPtr<CefV8Value> documents = CefV8Value::CreateArray();
+        for (size_t i = 0; i < m_documents.size(); i++) {
+            const RecoveredDocument& document = m_documents[i];
+            CefRefPtr<CefV8Value> value = CefV8Value::CreateObject(NULL);
+            value->SetValue("path", CefV8Value::CreateString(document.path), V8_PROPERTY_ATTRIBUTE_NONE);
+            value->SetValue("text", document.damaged ? CefV8Value::CreateNull() :
+                            CefV8Value::CreateString(document.text), V8_PROPERTY_ATTRIBUTE_NONE);
+            value->SetValue("edits", CefV8Value::CreateDouble((double)document.edits), V8_PROPERTY_ATTRIBUTE_NONE);
+            value->SetValue("damaged", CefV8Value::CreateBool(document.damaged), V8_PROPERTY_ATTRIBUTE_NONE);
+            documents->SetValue((int)i, value);
+        }
+
+        CefRefPtr<CefV8Value> result = CefV8Value::CreateObject(NULL);
+        result->SetValue("documents", documents, V8_PROPERTY_ATTRIBUTE_NONE);
+        result->SetValue("truncated", CefV8Value::CreateBool(m_truncated), V8_PROPERTY_ATTRIBUTE_NONE);
+        return result;
+    }
+
+protected:
+    virtual int Run() { return ReplayEditJournal(m_path, m_documents, m_truncated); }
+
+private:
+    ExtensionString m_path;
+    std::vector<RecoveredDocument> m_documents;
+    bool m_truncated;
+};
+
+// Reads the (document, text, ...) arguments the record functions start with
+const ExtensionString* GetDocumentArguments(const CefV8ValueList& arguments, size_t count,
+                                            ExtensionString& storage)
+{
+    if (arguments.size() != count)
+        return NULL;
+    if (count > 1 && !arguments[count - 1]->IsString())
+        return NULL;
+    return GetPathValue(arguments[0], storage);
+}
+
+} // namespace
+
+int ExecuteOpenEditJournal(const CefV8ValueList& arguments,
+                           CefRefPtr<CefV8Value>& retval,
+                           CefString& exception)
+{
+    int commitDelayMs = EditJournal::kDefaultCommitDelayMs;
+    if (arguments.size() < 1 || arguments.size() > 2)
+        return ERR_INVALID_PARAMS;
+    if (arguments.size() == 2) {
+        if (!arguments[1]->IsInt() || arguments[1]->GetIntValue() < 0)
+            return ERR_INVALID_PARAMS;
+        commitDelayMs = arguments[1]->GetIntValue();
+    }
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+
+    return EditJournal::GetInstance().Open(*path, commitDelayMs);
+}
+
+int ExecuteCloseEditJournal(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception)
+{
+    if (arguments.size() > 1 || (arguments.size() == 1 && !arguments[0]->IsBool()))
+        return ERR_INVALID_PARAMS;
+
+    bool discard = arguments.size() == 1 && arguments[0]->GetBoolValue();
+    return EditJournal::GetInstance().Close(discard);
+}
+
+int ExecuteJournalSnapshot(const CefV8ValueList& arguments,
+                           CefRefPtr<CefV8Value>& retval,
+                           CefString& exception)
+{
+    ExtensionString storage;
+    const ExtensionString* document = GetDocumentArguments(arguments, 2, storage);
+    if (!document)
+        return ERR_INVALID_PARAMS;
+
+    std::string text;
+    GetUTF8StringValue(arguments[1], text);
+    return EditJournal::GetInstance().AddSnapshot(*document, text);
+}
+
+int ExecuteJournalBase(const CefV8ValueList& arguments,
+                       CefRefPtr<CefV8Value>& retval,
+                       CefString& exception)
+{
+    ExtensionString storage;
+    const ExtensionString* document = GetDocumentArguments(arguments, 2, storage);
+    if (!document)
+        return ERR_INVALID_PARAMS;
+
+    std::string digest;
+    GetUTF8StringValue(arguments[1], digest);
+    return EditJournal::GetInstance().AddBase(*document, digest);
+}
+
+int ExecuteJournalEdit(const CefV8ValueList& arguments,
+                       CefRefPtr<CefV8Value>& retval,
+                       CefString& exception)
+{
+    ExtensionString storage;
+    const ExtensionString* document = GetDocumentArguments(arguments, 4, storage);
+    unsigned long long offset;
+    unsigned long long removed;
+    if (!document || !GetNumberValue(arguments[1], offset) || !GetNumberValue(arguments[2], removed))
+        return ERR_INVALID_PARAMS;
+
+    std::string text;
+    GetUTF8StringValue(arguments[3], text);
+    unsigned long long sinceSnapshot = 0;
+    int error = EditJournal::GetInstance().AddEdit(*document, offset, removed, text, sinceSnapshot);
+    if (error != NO_ERROR)
+        return error;
+
+    retval = CefV8Value::CreateDouble((double)sinceSnapshot);
+    return NO_ERROR;
+}
+
+int ExecuteJournalClean(const CefV8ValueList& arguments,
+                        CefRefPtr<CefV8Value>& retval,
+                        CefString& exception)
+{
+    ExtensionString storage;
+    const ExtensionString* document = GetDocumentArguments(arguments, 1, storage);
+    if (!document)
+        return ERR_INVALID_PARAMS;
+
+    return EditJournal::GetInstance().AddClean(*document);
+}
+
+int ExecuteFlushEditJournalAsync(const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefString& exception)
+{
+    CefRefPtr<AsyncOperation> operation = new FlushEditJournalOperation();
+    return operation->Start(arguments, 0, retval);
+}
+
+int ExecuteReplayEditJournalAsync(const CefV8ValueList& arguments,
+                                  CefRefPtr<CefV8Value>& retval,
+                                  CefString& exception)
+{
+    if (arguments.size() < 2)
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<AsyncOperation> operation = new ReplayEditJournalOperation(*path);
+    return operation->Start(arguments, 1, retval);
+}
+
+int ExecuteGetEditJournalStats(const CefV8ValueList& arguments,
+                               CefRefPtr<CefV8Value>& retval,
+                               CefString& exception)
+{
+    if (arguments.size() != 0)
+        return ERR_INVALID_PARAMS;
+
+    EditJournal::Stats stats = EditJournal::GetInstance().GetStats();
+
+    retval = CefV8Value::CreateObject(NULL);
+    retval->SetValue("records", CefV8Value::CreateDouble((double)stats.records), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("bytes", CefV8Value::CreateDouble((double)stats.bytes), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("flushes", CefV8Value::CreateDouble((double)stats.flushes), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("recordsPerFlush",
+                     CefV8Value::CreateDouble(stats.flushes ? (double)stats.flushedRecords / stats.flushes : 0.0),
+                     V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("time", CefV8Value::CreateDouble(stats.microseconds / 1000.0), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("pending", CefV8Value::CreateDouble((double)stats.pendingBytes), V8_PROPERTY_ATTRIBUTE_NONE);
+    return NO_ERROR;
+}
+
+} // namespace FileSystem
+} // namespace Brackets
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_EDIT_JOURNAL_H
+#define _BRACKETS_EDIT_JOURNAL_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_thread.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Brackets {
+namespace FileSystem {
+
+/**
+ * Log of the unsaved changes to open documents, so that they can be brought
+ * back after a crash. Rather than saving each document whole, the editor
+ * records where it started from, a snapshot of its text or the digest of
+ * the file it was opened from, and then each edit as it is made, so that
+ * what is written grows with the size of the edits, not of the documents.
+ * A document that is saved or closed is marked clean and is not recovered.
+ *
+ * Records are appended to a buffer in memory, which never blocks the
+ * caller on the disk. A flush on the WorkerPool, started a short commit
+ * delay after the first record, writes everything buffered by then with a
+ * single write and a single sync; records added while a flush is under way
+ * go in the next one, so however fast edits come there is at most one sync
+ * in progress. Flush waits until what was added before it is on disk.
+ *
+ * There is one journal per process, shared by every window, normally in a
+ * file named after the session. Each record carries its own length and
+ * checksum, so replaying a journal cut short by a crash recovers everything
+ * up to the last complete record. Thread safe.
+ */
+class EditJournal
+{
+public:
+    static EditJournal& GetInstance();
+
+    // Starts a new journal at |path|, replacing any file there, after
+    // closing the current one. Records are flushed |commitDelayMs| after the
+    // first one that follows a flush.
+    int Open(const ExtensionString& path, int commitDelayMs);
+
+    // Flushes and closes the journal. With |discard|, after a clean exit,
+    // the file is deleted as well.
+    int Close(bool discard);
+
+    // Records for the document at |document|. They return the error of the
+    // last flush, if it failed, as the records would not survive a crash.
+    int AddSnapshot(const ExtensionString& document, const std::string& text);
+    int AddBase(const ExtensionString& document, const std::string& digest);
+    int AddClean(const ExtensionString& document);
+
+    // Replaces |removed| UTF-16 code units from |offset| with |text|.
+    // |sinceSnapshot| is set to the bytes recorded for the document since
+    // its last snapshot or base, to tell when a new snapshot would be
+    // smaller than replaying the edits.
+    int AddEdit(const ExtensionString& document, unsigned long long offset, unsigned long long removed,
+                const std::string& text, unsigned long long& sinceSnapshot);
+
+    // Waits until every record added so far is on disk. Called on a
+    // background thread.
+    int Flush();
+
+    // Flushes on behalf of the commit delay. Runs on the WorkerPool.
+    void FlushPending();
+
+    static const int kDefaultCommitDelayMs = 50;
+
+    struct Stats {
+        Stats() : records(0), bytes(0), flushes(0), flushedRecords(0), microseconds(0), pendingBytes(0) {}
+
+        unsigned long long records;         // added since the journal was opened
+        unsigned long long bytes;           // their size on disk
+        unsigned long long flushes;         // writes and syncs
+        unsigned long long flushedRecords;  // records they carried
+        long long microseconds;             // spent in them
+        unsigned long long pendingBytes;    // buffered now
+    };
+
+    Stats GetStats() const;
+
+private:
+    EditJournal() : m_isOpen(false), m_commitDelayMs(kDefaultCommitDelayMs), m_flushScheduled(false),
+                    m_error(NO_ERROR), m_added(0), m_durable(0), m_pendingRecords(0), m_nextDocumentId(1) {}
+
+    struct Document {
+        Document() : id(0), sinceSnapshot(0) {}
+
+        unsigned int id;
+        unsigned long long sinceSnapshot;
+    };
+
+    // Appends a record with the id of |document| and |fields| and |text| as
+    // its payload, numbering the document first if it is new. Called with
+    // m_lock held.
+    int AddRecord(unsigned int type, const ExtensionString& document, const std::string& fields,
+                  const char* text, size_t length, Document** added = NULL);
+
+    // Appends one record to m_buffer. Called with m_lock held.
+    void AppendRecord(unsigned int type, unsigned int id, const std::string& fields, const char* text,
+                      size_t length);
+
+    // Writes and syncs what is buffered, unless the first |target| bytes
+    // added are already on disk. Called with m_fileLock held.
+    int WriteBuffered(unsigned long long target);
+
+    // Guards the file; flushes and Open and Close hold it while they write
+    Lock m_fileLock;
+    PlatformFile m_file;
+    ExtensionString m_path;
+
+    // Guards everything below
+    mutable Lock m_lock;
+    bool m_isOpen;
+    int m_commitDelayMs;
+    bool m_flushScheduled;
+    int m_error;                        // of the last flush
+    std::string m_buffer;
+    unsigned long long m_added;         // bytes added since the journal was opened
+    unsigned long long m_durable;       // of those, bytes on disk
+    unsigned long long m_pendingRecords;
+    unsigned int m_nextDocumentId;
+    std::map<ExtensionString, Document> m_documents;
+    Stats m_stats;
+
+    EditJournal(const EditJournal&);
+    EditJournal& operator=(const EditJournal&);
+};
+
+// A document with unsaved changes found in a journal
+struct RecoveredDocument {
+    RecoveredDocument() : edits(0), damaged(false) {}
+
+    ExtensionString path;
+    std::string text;           // UTF-8, empty when |damaged|
+    unsigned long long edits;   // replayed since the last snapshot or base
+    bool damaged;               // its text could not be rebuilt
+};
+
+// Replays the journal at |path| and returns the documents it left unsaved,
+// in the order they first appear. A document recorded from the digest of
+// its file is rebuilt from the file, and is damaged if the file no longer
+// has that digest. |truncated| is set if the journal ends in an incomplete
+// or corrupt record, as after a crash in the middle of a write. Returns
+// ERR_CANT_READ if the file is not a journal.
+int ReplayEditJournal(const ExtensionString& path, std::vector<RecoveredDocument>& documents, bool& truncated);
+
+// Native functions for the journal, registered by brackets_fs_extension.cpp
+int ExecuteOpenEditJournal(const CefV8ValueList& arguments,
+                           CefRefPtr<CefV8Value>& retval,
+                           CefString& exception);
+int ExecuteCloseEditJournal(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception);
+int ExecuteJournalSnapshot(const CefV8ValueList& arguments,
+                           CefRefPtr<CefV8Value>& retval,
+                           CefString& exception);
+int ExecuteJournalBase(const CefV8ValueList& arguments,
+                       CefRefPtr<CefV8Value>& retval,
+                       CefString& exception);
+int ExecuteJournalEdit(const CefV8ValueList& arguments,
+                       CefRefPtr<CefV8Value>& retval,
+                       CefString& exception);
+int ExecuteJournalClean(const CefV8ValueList& arguments,
+                        CefRefPtr<CefV8Value>& retval,
+                        CefString& exception);
+int ExecuteFlushEditJournalAsync(const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefString& exception);
+int ExecuteReplayEditJournalAsync(const CefV8ValueList& arguments,
+                                  CefRefPtr<CefV8Value>& retval,
+                                  CefString& exception);
+int ExecuteGetEditJournalStats(const CefV8ValueList& arguments,
+                               CefRefPtr<CefV8Value>& retval,
+                               CefString& exception);
+
+} // namespace FileSystem
+} // namespace Brackets
+
+#endif // _BRACKETS_EDIT_JOURNAL_H
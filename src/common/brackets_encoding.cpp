@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_encoding.h"
+
+#include <string.h>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+typedef unsigned long long Word;
+
+const Word kHighBits = 0x8080808080808080ULL;
+
+// Returned by DecodeUTF8 for a malformed sequence
+const unsigned int kInvalid = 0xFFFFFFFF;
+
+const char kUTF8Mark[] = "\xEF\xBB\xBF";
+
+// A word with the bytes of |pattern| in memory order, for testing words read
+// with memcpy whatever the byte order of the machine
+Word MakeMask(const unsigned char* pattern)
+{
+    Word mask;
+    memcpy(&mask, pattern, sizeof(mask));
+    return mask;
+}
+
+// Decodes the UTF-8 sequence at |p|, which is before |end|, and moves |p|
+// past it. Returns kInvalid, without moving |p|, for overlong forms,
+// surrogates, values past U+10FFFF and sequences cut short.
+inline unsigned int DecodeUTF8(const unsigned char*& p, const unsigned char* end)
+{
+    unsigned int c = *p;
+    if (c < 0x80) {
+        p++;
+        return c;
+    }
+
+    int extra;
+    unsigned int minimum;
+    if ((c & 0xE0) == 0xC0) {
+        extra = 1;
+        c &= 0x1F;
+        minimum = 0x80;
+    } else if ((c & 0xF0) == 0xE0) {
+        extra = 2;
+        c &= 0x0F;
+        minimum = 0x800;
+    } else if ((c & 0xF8) == 0xF0) {
+        extra = 3;
+        c &= 0x07;
+        minimum = 0x10000;
+    } else {
+        return kInvalid;
+    }
+    if (end - p <= extra)
+        return kInvalid;
+    for (int k = 1; k <= extra; k++) {
+        if ((p[k] & 0xC0) != 0x80)
+            return kInvalid;
+        c = (c << 6) | (p[k] & 0x3F);
+    }
+    if (c < minimum || (c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF)
+        return kInvalid;
+    p += extra + 1;
+    return c;
+}
+
+inline char* EncodeUTF8(unsigned int c, char* out)
+{
+    if (c < 0x80) {
+        *out++ = (char)c;
+    } else if (c < 0x800) {
+        *out++ = (char)(0xC0 | (c >> 6));
+        *out++ = (char)(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        *out++ = (char)(0xE0 | (c >> 12));
+        *out++ = (char)(0x80 | ((c >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (c & 0x3F));
+    } else {
+        *out++ = (char)(0xF0 | (c >> 18));
+        *out++ = (char)(0x80 | ((c >> 12) & 0x3F));
+        *out++ = (char)(0x80 | ((c >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (c & 0x3F));
+    }
+    return out;
+}
+
+// Copies the run of ASCII at |in| a word at a time. Stops at the word with
+// the first byte that is not ASCII, or less than a word before |end|.
+inline void CopyASCII(const unsigned char*& in, const unsigned char* end, char*& out)
+{
+    while (end - in >= (long)sizeof(Word)) {
+        Word word;
+        memcpy(&word, in, sizeof(word));
+        if (word & kHighBits)
+            break;
+        memcpy(out, &word, sizeof(word));
+        in += sizeof(word);
+        out += sizeof(word);
+    }
+}
+
+bool Latin1ToUTF8(const char* data, size_t length, std::string& text)
+{
+    if (length > text.max_size() / 2)
+        return false;
+    text.resize(length * 2);
+    char* start = length ? &text[0] : NULL;
+    char* out = start;
+    const unsigned char* in = (const unsigned char*)data;
+    const unsigned char* end = in + length;
+    while (in < end) {
+        CopyASCII(in, end, out);
+        if (in < end)
+            out = EncodeUTF8(*in++, out);
+    }
+    text.resize(out - start);
+    return true;
+}
+
+bool UTF16ToUTF8(const char* data, size_t length, bool bigEndian, std::string& text)
+{
+    if (length % 2)
+        return false;
+
+    // Each unit takes at most 3 bytes, and a surrogate pair 4
+    text.resize(length / 2 * 3);
+    char* start = length ? &text[0] : NULL;
+    char* out = start;
+
+    // Four units are ASCII if their high bytes are 0 and their low bytes
+    // have no high bit
+    const unsigned char littleMask[] = { 0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF };
+    const unsigned char bigMask[] = { 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80 };
+    const Word mask = MakeMask(bigEndian ? bigMask : littleMask);
+    const int low = bigEndian ? 1 : 0;
+    const int high = 1 - low;
+
+    const unsigned char* in = (const unsigned char*)data;
+    const unsigned char* end = in + length;
+    while (in < end) {
+        while (end - in >= (long)sizeof(Word)) {
+            Word word;
+            memcpy(&word, in, sizeof(word));
+            if (word & mask)
+                break;
+            out[0] = (char)in[low];
+            out[1] = (char)in[2 + low];
+            out[2] = (char)in[4 + low];
+            out[3] = (char)in[6 + low];
+            in += sizeof(word);
+            out += 4;
+        }
+        if (in == end)
+            break;
+
+        unsigned int c = in[low] | (in[high] << 8);
+        in += 2;
+        if (c >= 0xD800 && c <= 0xDFFF) {
+            if (c >= 0xDC00 || end - in < 2)
+                return false;
+            unsigned int next = in[low] | (in[high] << 8);
+            if (next < 0xDC00 || next > 0xDFFF)
+                return false;
+            in += 2;
+            c = 0x10000 + ((c - 0xD800) << 10) + (next - 0xDC00);
+        }
+        out = EncodeUTF8(c, out);
+    }
+    text.resize(out - start);
+    return true;
+}
+
+bool UTF8ToUTF16(const std::string& text, bool bigEndian, std::string& bytes)
+{
+    if (text.size() > (bytes.max_size() - 2) / 2)
+        return false;
+
+    // Every character takes 2 bytes, or 4 from 4 bytes of UTF-8
+    bytes.resize(2 + text.size() * 2);
+    char* start = &bytes[0];
+    char* out = start;
+    const int low = bigEndian ? 1 : 0;
+    const int high = 1 - low;
+    out[low] = (char)0xFF;
+    out[high] = (char)0xFE;
+    out += 2;
+
+    const unsigned char* in = (const unsigned char*)text.data();
+    const unsigned char* end = in + text.size();
+    while (in < end) {
+        while (end - in >= (long)sizeof(Word)) {
+            Word word;
+            memcpy(&word, in, sizeof(word));
+            if (word & kHighBits)
+                break;
+            for (size_t k = 0; k < sizeof(word); k++) {
+                out[2 * k + low] = (char)in[k];
+                out[2 * k + high] = 0;
+            }
+            in += sizeof(word);
+            out += 2 * sizeof(word);
+        }
+        if (in == end)
+            break;
+
+        unsigned int c = DecodeUTF8(in, end);
+        if (c == kInvalid)
+            return false;
+        if (c >= 0x10000) {
+            unsigned int lead = 0xD800 + ((c - 0x10000) >> 10);
+            out[low] = (char)(lead & 0xFF);
+            out[high] = (char)(lead >> 8);
+            out += 2;
+            c = 0xDC00 + ((c - 0x10000) & 0x3FF);
+        }
+        out[low] = (char)(c & 0xFF);
+        out[high] = (char)(c >> 8);
+        out += 2;
+    }
+    bytes.resize(out - start);
+    return true;
+}
+
+bool UTF8ToLatin1(const std::string& text, std::string& bytes)
+{
+    bytes.resize(text.size());
+    char* start = text.empty() ? NULL : &bytes[0];
+    char* out = start;
+    const unsigned char* in = (const unsigned char*)text.data();
+    const unsigned char* end = in + text.size();
+    while (in < end) {
+        CopyASCII(in, end, out);
+        if (in == end)
+            break;
+        unsigned int c = DecodeUTF8(in, end);
+        if (c == kInvalid || c > 0xFF)
+            return false;
+        *out++ = (char)c;
+    }
+    bytes.resize(out - start);
+    return true;
+}
+
+} // namespace
+
+size_t DetectByteOrderMark(const char* data, size_t length, TextEncoding& encoding)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    if (length >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF) {
+        encoding = ENCODING_UTF8_BOM;
+        return 3;
+    }
+    if (length >= 2 && p[0] == 0xFF && p[1] == 0xFE) {
+        encoding = ENCODING_UTF16LE;
+        return 2;
+    }
+    if (length >= 2 && p[0] == 0xFE && p[1] == 0xFF) {
+        encoding = ENCODING_UTF16BE;
+        return 2;
+    }
+    return 0;
+}
+
+bool DecodeText(std::string& bytes, TextEncoding encoding, std::string& text, TextEncoding& detected)
+{
+    TextEncoding marked = ENCODING_AUTO;
+    size_t mark = DetectByteOrderMark(bytes.data(), bytes.size(), marked);
+
+    bool isAuto = encoding == ENCODING_AUTO;
+    if (isAuto) {
+        if (mark) {
+            encoding = marked;
+        } else if (IsValidUTF8(bytes.data(), bytes.size())) {
+            detected = ENCODING_UTF8;
+            text.swap(bytes);
+            return true;
+        } else {
+            encoding = ENCODING_LATIN1;
+        }
+    }
+    if (marked != encoding)
+        mark = 0;
+
+    detected = encoding;
+    const char* data = bytes.data() + mark;
+    size_t length = bytes.size() - mark;
+    bool decoded = false;
+    switch (encoding) {
+    case ENCODING_UTF8:
+    case ENCODING_UTF8_BOM:
+        decoded = IsValidUTF8(data, length);
+        if (decoded) {
+            if (!mark)
+                detected = ENCODING_UTF8;
+            text.swap(bytes);
+            text.erase(0, mark);
+        }
+        break;
+    case ENCODING_UTF16LE:
+    case ENCODING_UTF16BE:
+        decoded = UTF16ToUTF8(data, length, encoding == ENCODING_UTF16BE, text);
+        break;
+    case ENCODING_LATIN1:
+        decoded = Latin1ToUTF8(data, length, text);
+        break;
+    default:
+        break;
+    }
+
+    // A byte order mark can be a coincidence; Latin-1 reads anything
+    if (!decoded && isAuto) {
+        detected = ENCODING_LATIN1;
+        return Latin1ToUTF8(bytes.data(), bytes.size(), text);
+    }
+    return decoded;
+}
+
+bool EncodeText(const std::string& text, TextEncoding encoding, std::string& bytes)
+{
+    switch (encoding) {
+    case ENCODING_UTF8:
+    case ENCODING_UTF8_BOM:
+        if (!IsValidUTF8(text.data(), text.size()))
+            return false;
+        bytes.clear();
+        if (encoding == ENCODING_UTF8_BOM) {
+            bytes.reserve(text.size() + 3);
+            bytes.append(kUTF8Mark, 3);
+        }
+        bytes.append(text);
+        return true;
+    case ENCODING_UTF16LE:
+    case ENCODING_UTF16BE:
+        return UTF8ToUTF16(text, encoding == ENCODING_UTF16BE, bytes);
+    case ENCODING_LATIN1:
+        return UTF8ToLatin1(text, bytes);
+    default:
+        return false;
+    }
+}
+
+} // namespace FileSystem
+} // namespace Brackets
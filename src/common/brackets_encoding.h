@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_ENCODING_H
+#define _BRACKETS_ENCODING_H
+
+#include "common/brackets_fs.h"
+
+#include <string>
+
+namespace Brackets {
+namespace FileSystem {
+
+/**
+ * Transcoding between UTF-8, the encoding of the text ReadFile returns and
+ * WriteFile takes, and the encodings files are kept in. Each direction is a
+ * single pass over the input into an output sized for the worst case, and
+ * runs of ASCII, which most source is, go through a word at a time. Input is
+ * validated as it is converted: malformed UTF-8 and UTF-16, such as an
+ * unpaired surrogate or an odd number of bytes, is refused rather than
+ * replaced, so that a file that is read and saved again is never changed
+ * behind the user's back.
+ */
+
+// Sets |encoding| to the encoding of the byte order mark |data| starts with
+// and returns its length, or returns 0 if it starts with none
+size_t DetectByteOrderMark(const char* data, size_t length, TextEncoding& encoding);
+
+// Turns |bytes|, in |encoding|, into UTF-8 in |text|. A byte order mark is
+// removed if it marks |encoding|, except with ENCODING_UTF8. |bytes| may be
+// swapped into |text| when it already is UTF-8. |detected| is set to the
+// encoding the bytes were in, which for ENCODING_AUTO is the one its rules
+// pick, and for ENCODING_UTF8_BOM is ENCODING_UTF8 if the mark was missing.
+// Returns false if the bytes are not valid in that encoding.
+bool DecodeText(std::string& bytes, TextEncoding encoding, std::string& text, TextEncoding& detected);
+
+// Turns UTF-8 |text| into |bytes| in |encoding|, which must not be
+// ENCODING_AUTO, starting with a byte order mark for ENCODING_UTF8_BOM and
+// UTF-16. Returns false if |text| is not valid UTF-8 or has characters the
+// encoding can't hold.
+bool EncodeText(const std::string& text, TextEncoding encoding, std::string& bytes);
+
+} // namespace FileSystem
+} // namespace Brackets
+
+#endif // _BRACKETS_ENCODING_H
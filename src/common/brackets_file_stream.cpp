@@ -0,0 +1,560 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#include "common/brackets_file_stream.h"
+#include "common/brackets_async.h"
+#include "common/brackets_fs_extension.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+// Every kLinesPerCheckpoint'th line start goes in the line index
+const long long kLinesPerCheckpoint = 1024;
+
+// Block size for scanning the file for line breaks
+const size_t kScanBlockSize = 64 * 1024;
+
+inline bool IsContinuationByte(char c)
+{
+    return ((unsigned char)c & 0xC0) == 0x80;
+}
+
+// Length of the UTF-8 sequence that starts with |c|, or 1 if |c| can't start one
+inline size_t SequenceLength(char c)
+{
+    unsigned char b = (unsigned char)c;
+    if ((b & 0xE0) == 0xC0)
+        return 2;
+    if ((b & 0xF0) == 0xE0)
+        return 3;
+    if ((b & 0xF8) == 0xF0)
+        return 4;
+    return 1;
+}
+
+// Moves |end| back to the start of a character cut off at the end of
+// data[begin, end)
+size_t TrimPartialCharacter(const std::string& data, size_t begin, size_t end)
+{
+    size_t i = end;
+    while (i > begin && end - i < 4) {
+        i--;
+        if (!IsContinuationByte(data[i])) {
+            if (end - i < SequenceLength(data[i]))
+                return i;
+            break;
+        }
+    }
+    return end;
+}
+
+} // namespace
+
+FileStream::FileStream(PlatformFile file)
+    : m_file(file), m_open(true), m_scannedLines(0), m_scannedOffset(0)
+{
+    m_checkpoints.push_back(0);
+}
+
+FileStream::~FileStream()
+{
+    Close();
+}
+
+int FileStream::Open(const ExtensionString& path, CefRefPtr<FileStream>& stream)
+{
+    PlatformFile file;
+    int error = OpenFileForReading(path, file);
+    if (error != NO_ERROR)
+        return error;
+
+    stream = new FileStream(file);
+    return NO_ERROR;
+}
+
+void FileStream::Close()
+{
+    AutoLock lock(m_lock);
+    if (m_open) {
+        CloseFile(m_file);
+        m_open = false;
+    }
+}
+
+int FileStream::Read(unsigned long long offset, size_t maxBytes, bool wholeLines, FileChunk& chunk)
+{
+    AutoLock lock(m_lock);
+    return ReadRange(offset, maxBytes, wholeLines, chunk);
+}
+
+int FileStream::ReadLines(long long firstLine, long long lineCount, size_t maxBytes, FileChunk& chunk)
+{
+    AutoLock lock(m_lock);
+
+    unsigned long long offset = 0;
+    bool found = false;
+    int error = FindLine(firstLine, offset, found);
+    if (error != NO_ERROR)
+        return error;
+
+    // Read a block and count lines in it, and read a larger one if that
+    // wasn't enough, so that a few lines don't cost a |maxBytes| read. Past
+    // the last line |offset| is the end of the file, which gives an empty
+    // chunk.
+    size_t attempt = std::min(maxBytes, kScanBlockSize);
+    long long lines;
+    const char* p;
+    for (;;) {
+        error = ReadRange(offset, attempt, true, chunk);
+        if (error != NO_ERROR)
+            return error;
+
+        lines = 0;
+        p = chunk.data.data();
+        const char* end = p + chunk.data.size();
+        while (lines < lineCount && p < end) {
+            const char* lineBreak = (const char*)memchr(p, '\n', end - p);
+            if (!lineBreak) {
+                // A last line without a line break counts only at the end
+                if (chunk.eof) {
+                    lines++;
+                    p = end;
+                }
+                break;
+            }
+            lines++;
+            p = lineBreak + 1;
+        }
+
+        if (lines == lineCount || chunk.eof || attempt == maxBytes)
+            break;
+        attempt = std::min(maxBytes, attempt * 4);
+    }
+
+    // Keep |lineCount| lines at most
+    size_t kept = p - chunk.data.data();
+    if (lines == lineCount && kept < chunk.data.size()) {
+        chunk.data.resize(kept);
+        chunk.end = chunk.start + kept;
+        chunk.eof = false;
+    }
+
+    chunk.firstLine = found ? firstLine : -1;
+    chunk.lineCount = lines;
+    return NO_ERROR;
+}
+
+int FileStream::ReadTail(size_t maxBytes, FileChunk& chunk)
+{
+    AutoLock lock(m_lock);
+    if (!m_open)
+        return ERR_CANT_READ;
+
+    unsigned long long size;
+    int error = GetOpenFileSize(m_file, size);
+    if (error != NO_ERROR)
+        return error;
+
+    unsigned long long offset = size > maxBytes ? size - maxBytes : 0;
+    error = ReadRange(offset, maxBytes, false, chunk);
+    if (error != NO_ERROR || chunk.start == 0)
+        return error;
+
+    // Start on the first whole line, unless there isn't one
+    size_t lineBreak = chunk.data.find('\n');
+    if (lineBreak != std::string::npos && lineBreak + 1 < chunk.data.size()) {
+        chunk.data.erase(0, lineBreak + 1);
+        chunk.start += lineBreak + 1;
+    }
+    return NO_ERROR;
+}
+
+int FileStream::ReadRange(unsigned long long offset, size_t maxBytes, bool wholeLines, FileChunk& chunk)
+{
+    if (!m_open)
+        return ERR_CANT_READ;
+    if (maxBytes < 4)
+        return ERR_INVALID_PARAMS;
+
+    unsigned long long size;
+    int error = GetOpenFileSize(m_file, size);
+    if (error != NO_ERROR)
+        return error;
+
+    offset = std::min(offset, size);
+    size_t wanted = (size_t)std::min((unsigned long long)maxBytes, size - offset);
+
+    chunk = FileChunk();
+    chunk.fileSize = size;
+    chunk.data.resize(wanted);
+
+    size_t bytesRead = 0;
+    if (wanted > 0) {
+        error = ReadFileAt(m_file, offset, &chunk.data[0], wanted, bytesRead);
+        if (error != NO_ERROR)
+            return error;
+    }
+    bool reachedEnd = offset + bytesRead >= size;
+
+    // An offset in the middle of a character skips the rest of it. The end
+    // is moved back to a character boundary even at the end of the file,
+    // where a writer may not have finished the character yet.
+    size_t begin = 0;
+    while (begin < bytesRead && begin < 3 && IsContinuationByte(chunk.data[begin]))
+        begin++;
+    size_t end = TrimPartialCharacter(chunk.data, begin, bytesRead);
+
+    if (wholeLines && !reachedEnd && end > begin) {
+        size_t lineBreak = chunk.data.rfind('\n', end - 1);
+        if (lineBreak != std::string::npos && lineBreak >= begin)
+            end = lineBreak + 1;
+    }
+
+    chunk.data.resize(end);
+    chunk.data.erase(0, begin);
+    if (!IsValidUTF8(chunk.data.data(), chunk.data.size()))
+        return ERR_UNSUPPORTED_ENCODING;
+
+    chunk.start = offset + begin;
+    chunk.end = offset + end;
+    chunk.eof = reachedEnd && end == bytesRead;
+    if (chunk.start == 0)
+        chunk.firstLine = 0;
+    return NO_ERROR;
+}
+
+int FileStream::FindLine(long long line, unsigned long long& offset, bool& found)
+{
+    if (!m_open)
+        return ERR_CANT_READ;
+
+    unsigned long long size;
+    int error = GetOpenFileSize(m_file, size);
+    if (error != NO_ERROR)
+        return error;
+
+    // The file was truncated or replaced, so the index no longer applies
+    if (size < m_scannedOffset) {
+        m_checkpoints.assign(1, 0);
+        m_scannedLines = 0;
+        m_scannedOffset = 0;
+    }
+
+    // Start from the closest checkpoint, or from where the last scan stopped
+    long long currentLine;
+    if (line <= m_scannedLines) {
+        size_t checkpoint = (size_t)(line / kLinesPerCheckpoint);
+        currentLine = checkpoint * kLinesPerCheckpoint;
+        offset = m_checkpoints[checkpoint];
+    } else {
+        currentLine = m_scannedLines;
+        offset = m_scannedOffset;
+    }
+
+    found = currentLine == line;
+    std::vector<char> block(kScanBlockSize);
+    while (!found && offset < size) {
+        size_t bytesRead = 0;
+        error = ReadFileAt(m_file, offset, &block[0], block.size(), bytesRead);
+        if (error != NO_ERROR)
+            return error;
+        if (bytesRead == 0)
+            break;
+
+        const char* start = &block[0];
+        const char* p = start;
+        const char* end = start + bytesRead;
+        unsigned long long blockOffset = offset;
+        offset += bytesRead;
+        while (p < end) {
+            const char* lineBreak = (const char*)memchr(p, '\n', end - p);
+            if (!lineBreak)
+                break;
+            p = lineBreak + 1;
+            currentLine++;
+
+            unsigned long long lineStart = blockOffset + (p - start);
+            if (currentLine > m_scannedLines) {
+                m_scannedLines = currentLine;
+                m_scannedOffset = lineStart;
+                if (currentLine % kLinesPerCheckpoint == 0)
+                    m_checkpoints.push_back(lineStart);
+            }
+            if (currentLine == line) {
+                offset = lineStart;
+                found = true;
+                break;
+            }
+        }
+    }
+
+    if (!found)
+        offset = size;
+    return NO_ERROR;
+}
+
+} // namespace FileSystem
+
+///
+// FileStreamRegistry
+///
+FileStreamRegistry& FileStreamRegistry::GetInstance()
+{
+    static FileStreamRegistry instance;
+    return instance;
+}
+
+FileStreamRegistry::FileStreamRegistry() : m_nextHandle(1)
+{
+}
+
+int FileStreamRegistry::Add(CefRefPtr<FileSystem::FileStream> stream, CefRefPtr<CefV8Context> context)
+{
+    int handle = m_nextHandle++;
+    Entry& entry = m_streams[handle];
+    entry.stream = stream;
+    entry.context = context;
+    return handle;
+}
+
+CefRefPtr<FileSystem::FileStream> FileStreamRegistry::Get(int handle) const
+{
+    std::map<int, Entry>::const_iterator it = m_streams.find(handle);
+    if (it == m_streams.end())
+        return NULL;
+    return it->second.stream;
+}
+
+bool FileStreamRegistry::Close(int handle)
+{
+    std::map<int, Entry>::iterator it = m_streams.find(handle);
+    if (it == m_streams.end())
+        return false;
+
+    it->second.stream->Close();
+    m_streams.erase(it);
+    return true;
+}
+
+void FileStreamRegistry::ReleaseContext(CefRefPtr<CefV8Context> context)
+{
+    std::map<int, Entry>::iterator it = m_streams.begin();
+    while (it != m_streams.end()) {
+        if (it->second.context->IsSame(context)) {
+            it->second.stream->Close();
+            m_streams.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+namespace {
+
+using FileSystem::FileChunk;
+using FileSystem::FileStream;
+using FileSystem::GetNumberValue;
+
+// Largest chunk JS may ask for at once
+const size_t kMaxChunkSize = 64 * 1024 * 1024;
+
+bool GetChunkSizeArgument(CefRefPtr<CefV8Value> value, size_t& result)
+{
+    unsigned long long number;
+    if (!GetNumberValue(value, number) || number < 4 || number > kMaxChunkSize)
+        return false;
+
+    result = (size_t)number;
+    return true;
+}
+
+// Looks up the stream whose handle is in |value|
+CefRefPtr<FileStream> GetStreamArgument(CefRefPtr<CefV8Value> value)
+{
+    if (!value->IsInt())
+        return NULL;
+    return FileStreamRegistry::GetInstance().Get(value->GetIntValue());
+}
+
+CefRefPtr<CefV8Value> FileChunkToV8Object(FileChunk& chunk)
+{
+    CefRefPtr<CefV8Value> result = CefV8Value::CreateObject(NULL);
+    result->SetValue("data", FileSystem::FileContentsToResult(chunk.data), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("start", CefV8Value::CreateDouble((double)chunk.start), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("end", CefV8Value::CreateDouble((double)chunk.end), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("size", CefV8Value::CreateDouble((double)chunk.fileSize), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("eof", CefV8Value::CreateBool(chunk.eof), V8_PROPERTY_ATTRIBUTE_NONE);
+    if (chunk.firstLine >= 0)
+        result->SetValue("firstLine", CefV8Value::CreateDouble((double)chunk.firstLine), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("lineCount", CefV8Value::CreateDouble((double)chunk.lineCount), V8_PROPERTY_ATTRIBUTE_NONE);
+    return result;
+}
+
+// Base for the stream reads, which all return a FileChunk
+class ReadFileStreamOperation : public AsyncOperation
+{
+public:
+    explicit ReadFileStreamOperation(CefRefPtr<FileStream> stream) : m_stream(stream) {}
+
+protected:
+    virtual CefRefPtr<CefV8Value> GetResult() { return FileChunkToV8Object(m_chunk); }
+
+    CefRefPtr<FileStream> m_stream;
+    FileChunk m_chunk;
+};
+
+class ReadRangeOperation : public ReadFileStreamOperation
+{
+public:
+    ReadRangeOperation(CefRefPtr<FileStream> stream, unsigned long long offset, size_t maxBytes, bool wholeLines)
+        : ReadFileStreamOperation(stream), m_offset(offset), m_maxBytes(maxBytes), m_wholeLines(wholeLines) {}
+
+protected:
+    virtual int Run() { return m_stream->Read(m_offset, m_maxBytes, m_wholeLines, m_chunk); }
+
+private:
+    unsigned long long m_offset;
+    size_t m_maxBytes;
+    bool m_wholeLines;
+};
+
+class ReadLinesOperation : public ReadFileStreamOperation
+{
+public:
+    ReadLinesOperation(CefRefPtr<FileStream> stream, long long firstLine, long long lineCount, size_t maxBytes)
+        : ReadFileStreamOperation(stream), m_firstLine(firstLine), m_lineCount(lineCount), m_maxBytes(maxBytes) {}
+
+protected:
+    virtual int Run() { return m_stream->ReadLines(m_firstLine, m_lineCount, m_maxBytes, m_chunk); }
+
+private:
+    long long m_firstLine;
+    long long m_lineCount;
+    size_t m_maxBytes;
+};
+
+class ReadTailOperation : public ReadFileStreamOperation
+{
+public:
+    ReadTailOperation(CefRefPtr<FileStream> stream, size_t maxBytes)
+        : ReadFileStreamOperation(stream), m_maxBytes(maxBytes) {}
+
+protected:
+    virtual int Run() { return m_stream->ReadTail(m_maxBytes, m_chunk); }
+
+private:
+    size_t m_maxBytes;
+};
+
+} // namespace
+
+int ExecuteOpenFileStream(const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception)
+{
+    if (arguments.size() != 1 || !arguments[0]->IsString())
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString pathStr = arguments[0]->GetStringValue();
+    CefRefPtr<FileStream> stream;
+    int error = FileStream::Open(pathStr, stream);
+    if (error != NO_ERROR)
+        return error;
+
+    int handle = FileStreamRegistry::GetInstance().Add(stream, CefV8Context::GetCurrentContext());
+    retval = CefV8Value::CreateInt(handle);
+    return NO_ERROR;
+}
+
+int ExecuteCloseFileStream(const CefV8ValueList& arguments,
+                           CefRefPtr<CefV8Value>& retval,
+                           CefString& exception)
+{
+    if (arguments.size() != 1 || !arguments[0]->IsInt())
+        return ERR_INVALID_PARAMS;
+
+    retval = CefV8Value::CreateBool(FileStreamRegistry::GetInstance().Close(arguments[0]->GetIntValue()));
+    return NO_ERROR;
+}
+
+int ExecuteReadFileStreamAsync(const CefV8ValueList& arguments,
+                               CefRefPtr<CefV8Value>& retval,
+                               CefString& exception)
+{
+    unsigned long long offset;
+    size_t maxBytes;
+    if (arguments.size() < 5 || !GetNumberValue(arguments[1], offset) ||
+        !GetChunkSizeArgument(arguments[2], maxBytes) || !arguments[3]->IsBool())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<FileStream> stream = GetStreamArgument(arguments[0]);
+    if (!stream.get())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<AsyncOperation> operation =
+        new ReadRangeOperation(stream, offset, maxBytes, arguments[3]->GetBoolValue());
+    return operation->Start(arguments, 4, retval);
+}
+
+int ExecuteReadFileStreamLinesAsync(const CefV8ValueList& arguments,
+                                    CefRefPtr<CefV8Value>& retval,
+                                    CefString& exception)
+{
+    unsigned long long firstLine, lineCount;
+    size_t maxBytes;
+    if (arguments.size() < 5 || !GetNumberValue(arguments[1], firstLine) ||
+        !GetNumberValue(arguments[2], lineCount) || !GetChunkSizeArgument(arguments[3], maxBytes))
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<FileStream> stream = GetStreamArgument(arguments[0]);
+    if (!stream.get())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<AsyncOperation> operation =
+        new ReadLinesOperation(stream, (long long)firstLine, (long long)lineCount, maxBytes);
+    return operation->Start(arguments, 4, retval);
+}
+
+int ExecuteReadFileStreamTailAsync(const CefV8ValueList& arguments,
+                                   CefRefPtr<CefV8Value>& retval,
+                                   CefString& exception)
+{
+    size_t maxBytes;
+    if (arguments.size() < 3 || !GetChunkSizeArgument(arguments[1], maxBytes))
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<FileStream> stream = GetStreamArgument(arguments[0]);
+    if (!stream.get())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<AsyncOperation> operation = new ReadTailOperation(stream, maxBytes);
+    return operation->Start(arguments, 2, retval);
+}
+
+} // namespace Brackets
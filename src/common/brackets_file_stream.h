@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#ifndef _BRACKETS_FILE_STREAM_H
+#define _BRACKETS_FILE_STREAM_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_thread.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Brackets {
+namespace FileSystem {
+
+// A range of a file read by FileStream
+struct FileChunk {
+    FileChunk() : start(0), end(0), fileSize(0), firstLine(-1), lineCount(0), eof(false) {}
+
+    std::string data;               // UTF-8, never starts or ends inside a character
+    unsigned long long start;       // offset of the first byte of |data|
+    unsigned long long end;         // offset just past |data|, where the next read starts
+    unsigned long long fileSize;    // size of the file when it was read
+    long long firstLine;            // zero-based line number of |data|, or -1 if unknown
+    long long lineCount;            // lines in |data|, set by ReadLines only
+    bool eof;                       // |data| reaches the end of the file
+};
+
+/**
+ * An open file that JS reads a range at a time, for files that are too large
+ * to be read whole with ReadFile.
+ *
+ * Ranges are read at an offset with ReadFileAt, so the file may keep growing
+ * while it is open and a viewer can follow it by reading again from the end
+ * of the last chunk. Chunks are trimmed so that they never split a UTF-8
+ * character, and optionally so that they end on a line break.
+ *
+ * Lines are located with a sparse index: the offset of every 1024th line is
+ * recorded the first time the file is scanned past it, so reading line N only scans from the closest checkpoint. The
+ * index is dropped if the file shrinks.
+ *
+ * Streams are reference counted so that worker threads can read while JS
+ * holds the handle. All methods are thread safe.
+ */
+class FileStream : public CefBase
+{
+public:
+    static int Open(const ExtensionString& path, CefRefPtr<FileStream>& stream);
+    virtual ~FileStream();
+
+    // Reads up to |maxBytes| (at least 4) at |offset|. An offset inside a
+    // character skips to the next one. With |wholeLines|, the chunk ends
+    // after the last line break that fits unless the end of the file is
+    // reached or a single line is longer than |maxBytes|.
+    int Read(unsigned long long offset, size_t maxBytes, bool wholeLines, FileChunk& chunk);
+
+    // Reads up to |lineCount| lines starting with line |firstLine|, and no
+    // more than |maxBytes|. Past the last line the chunk is empty.
+    int ReadLines(long long firstLine, long long lineCount, size_t maxBytes, FileChunk& chunk);
+
+    // Reads up to the last |maxBytes| of the file, starting on a line
+    int ReadTail(size_t maxBytes, FileChunk& chunk);
+
+    // Closes the file. Later reads fail with ERR_CANT_READ.
+    void Close();
+
+private:
+    explicit FileStream(PlatformFile file);
+
+    int ReadRange(unsigned long long offset, size_t maxBytes, bool wholeLines, FileChunk& chunk);
+    int FindLine(long long line, unsigned long long& offset, bool& found);
+
+    Lock m_lock;
+    PlatformFile m_file;
+    bool m_open;
+
+    // m_checkpoints[i] is the offset of line i * kLinesPerCheckpoint. The
+    // file has been scanned up to line m_scannedLines, at m_scannedOffset.
+    std::vector<unsigned long long> m_checkpoints;
+    long long m_scannedLines;
+    unsigned long long m_scannedOffset;
+
+    IMPLEMENT_REFCOUNTING(FileStream);
+};
+
+} // namespace FileSystem
+
+/**
+ * The FileStreams that JS has open, by handle. Streams belong to the V8
+ * context that opened them and are closed with it. UI thread only.
+ */
+class FileStreamRegistry
+{
+public:
+    static FileStreamRegistry& GetInstance();
+
+    // Registers |stream| and returns its handle
+    int Add(CefRefPtr<FileSystem::FileStream> stream, CefRefPtr<CefV8Context> context);
+
+    // Returns the stream for |handle|, or NULL if it is not open
+    CefRefPtr<FileSystem::FileStream> Get(int handle) const;
+
+    // Closes |handle|. Returns false if it was not open.
+    bool Close(int handle);
+
+    // Closes every stream opened from |context|
+    void ReleaseContext(CefRefPtr<CefV8Context> context);
+
+    size_t GetOpenCount() const { return m_streams.size(); }
+
+private:
+    FileStreamRegistry();
+
+    struct Entry {
+        CefRefPtr<FileSystem::FileStream> stream;
+        CefRefPtr<CefV8Context> context;
+    };
+
+    std::map<int, Entry> m_streams;
+    int m_nextHandle;
+};
+
+// Native functions for file streams, registered by brackets_fs_extension.cpp
+int ExecuteOpenFileStream(const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception);
+int ExecuteCloseFileStream(const CefV8ValueList& arguments,
+                           CefRefPtr<CefV8Value>& retval,
+                           CefString& exception);
+int ExecuteReadFileStreamAsync(const CefV8ValueList& arguments,
+                               CefRefPtr<CefV8Value>& retval,
+                               CefString& exception);
+int ExecuteReadFileStreamLinesAsync(const CefV8ValueList& arguments,
+                                    CefRefPtr<CefV8Value>& retval,
+                                    CefString& exception);
+int ExecuteReadFileStreamTailAsync(const CefV8ValueList& arguments,
+                                   CefRefPtr<CefV8Value>& retval,
+                                   CefString& exception);
+
+} // namespace Brackets
+
+#endif // _BRACKETS_FILE_STREAM_H
@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_fs.h"
+#include "common/brackets_encoding.h"
+
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+inline unsigned int FoldCase(unsigned int c)
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+inline unsigned int FoldCase(char c)
+{
+    return FoldCase((unsigned int)(unsigned char)c);
+}
+
+inline unsigned int FoldCase(wchar_t c)
+{
+    return FoldCase((unsigned int)c);
+}
+
+bool CompareDirEntries(const DirEntry& a, const DirEntry& b)
+{
+    if (a.info.isDirectory != b.info.isDirectory)
+        return a.info.isDirectory;
+
+    size_t length = std::min(a.name.size(), b.name.size());
+    for (size_t i = 0; i < length; i++) {
+        if (FoldCase(a.name[i]) != FoldCase(b.name[i]))
+            return FoldCase(a.name[i]) < FoldCase(b.name[i]);
+    }
+    if (a.name.size() != b.name.size())
+        return a.name.size() < b.name.size();
+
+    // Names that only differ by case keep a stable order
+    return a.name < b.name;
+}
+
+// Number of bytes of |word| with their high bit set, given that no other bit is
+inline size_t CountHighBytes(unsigned long word)
+{
+    return (size_t)(((word >> 7) * ((unsigned long)-1 / 0xFF)) >> ((sizeof(word) - 1) * 8));
+}
+
+const char* const kEncodingNames[] = { "utf8", "utf8bom", "utf16le", "utf16be", "latin1", "auto" };
+
+// Compares a name from JS, which is a wide string on Windows, to an ASCII one
+bool IsName(const ExtensionString& name, const char* ascii)
+{
+    size_t i = 0;
+    for (; i < name.length() && ascii[i]; i++) {
+        if ((unsigned int)name[i] != (unsigned char)ascii[i])
+            return false;
+    }
+    return i == name.length() && !ascii[i];
+}
+
+} // namespace
+
+void SortDirEntries(std::vector<DirEntry>& entries)
+{
+    std::sort(entries.begin(), entries.end(), CompareDirEntries);
+}
+
+int ConvertErrnoCode(int errorCode, bool isReading)
+{
+    switch (errorCode) {
+    case NO_ERROR:
+        return NO_ERROR;
+    case EINVAL:
+        return ERR_INVALID_PARAMS;
+    case ENOENT:
+        return ERR_NOT_FOUND;
+    case EPERM:
+    case EACCES:
+        return isReading ? ERR_CANT_READ : ERR_CANT_WRITE;
+    case EROFS:
+        return ERR_CANT_WRITE;
+    case ENOSPC:
+        return ERR_OUT_OF_SPACE;
+    case EISDIR:
+        return ERR_NOT_FILE;
+    case ENOTDIR:
+        return ERR_NOT_DIRECTORY;
+    default:
+        return ERR_UNKNOWN;
+    }
+}
+
+bool ParseEncoding(const ExtensionString& name, TextEncoding& encoding)
+{
+    for (size_t i = 0; i < sizeof(kEncodingNames) / sizeof(kEncodingNames[0]); i++) {
+        if (IsName(name, kEncodingNames[i])) {
+            encoding = (TextEncoding)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* GetEncodingName(TextEncoding encoding)
+{
+    return kEncodingNames[encoding];
+}
+
+int ReadFile(const ExtensionString& path, const ExtensionString& encoding, std::string& contents,
+             TextLayout* layout, TextEncoding* detected)
+{
+    TextEncoding textEncoding;
+    if (!ParseEncoding(encoding, textEncoding))
+        return ERR_UNSUPPORTED_ENCODING;
+
+    if (textEncoding == ENCODING_UTF8) {
+        if (detected)
+            *detected = ENCODING_UTF8;
+        return ReadFileBytes(path, contents, true, layout);
+    }
+
+    std::string bytes;
+    int error = ReadFileBytes(path, bytes, false, NULL);
+    if (error != NO_ERROR)
+        return error;
+
+    TextEncoding found;
+    if (!DecodeText(bytes, textEncoding, contents, found))
+        return ERR_UNSUPPORTED_ENCODING;
+    if (detected)
+        *detected = found;
+    if (layout) {
+        layout->Feed(contents.data(), contents.size());
+        layout->Finish();
+    }
+    return NO_ERROR;
+}
+
+int BeginWrite(const ExtensionString& path, const std::string& contents, const ExtensionString& encoding,
+               PendingWrite& write)
+{
+    TextEncoding textEncoding;
+    if (!ParseEncoding(encoding, textEncoding) || textEncoding == ENCODING_AUTO)
+        return ERR_UNSUPPORTED_ENCODING;
+    if (textEncoding == ENCODING_UTF8)
+        return BeginWriteBytes(path, contents, write);
+
+    std::string bytes;
+    if (!EncodeText(contents, textEncoding, bytes))
+        return ERR_UNSUPPORTED_ENCODING;
+    return BeginWriteBytes(path, bytes, write);
+}
+
+int WriteFile(const ExtensionString& path, const std::string& contents, const ExtensionString& encoding,
+              Durability durability)
+{
+    PendingWrite write;
+    int error = BeginWrite(path, contents, encoding, write);
+    if (error == NO_ERROR)
+        error = SyncWrite(write, durability);
+    if (error == NO_ERROR)
+        error = CommitWrite(write, durability);
+
+    if (error != NO_ERROR) {
+        AbortWrite(write);
+        return error;
+    }
+
+    // Make the rename itself durable
+    if (durability == DURABILITY_FULL)
+        SyncDirectory(write.directory);
+    return NO_ERROR;
+}
+
+bool UTF8Validator::Feed(const char* data, size_t length)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    const unsigned char* end = p + length;
+
+    while (m_valid && p < end) {
+        if (m_remaining == 0) {
+            // Skip runs of ASCII a word at a time, the common case for source
+            while ((size_t)(end - p) >= sizeof(unsigned long)) {
+                unsigned long word;
+                memcpy(&word, p, sizeof(word));
+                if (word & ((unsigned long)-1 / 0xFF * 0x80))
+                    break;
+                p += sizeof(word);
+            }
+            if (p == end)
+                break;
+
+            unsigned char c = *p++;
+            if (c < 0x80) {
+                continue;
+            } else if ((c & 0xE0) == 0xC0) {
+                m_remaining = 1;
+                m_codePoint = c & 0x1F;
+                m_minimum = 0x80;
+            } else if ((c & 0xF0) == 0xE0) {
+                m_remaining = 2;
+                m_codePoint = c & 0x0F;
+                m_minimum = 0x800;
+            } else if ((c & 0xF8) == 0xF0) {
+                m_remaining = 3;
+                m_codePoint = c & 0x07;
+                m_minimum = 0x10000;
+            } else {
+                m_valid = false;
+            }
+            continue;
+        }
+
+        unsigned char c = *p++;
+        if ((c & 0xC0) != 0x80) {
+            m_valid = false;
+            break;
+        }
+        m_codePoint = (m_codePoint << 6) | (c & 0x3F);
+
+        // Reject overlong forms, surrogates and values past U+10FFFF
+        if (--m_remaining == 0 &&
+            (m_codePoint < m_minimum ||
+             (m_codePoint >= 0xD800 && m_codePoint <= 0xDFFF) ||
+             m_codePoint > 0x10FFFF))
+            m_valid = false;
+    }
+
+    return m_valid;
+}
+
+bool IsValidUTF8(const char* data, size_t length)
+{
+    UTF8Validator validator;
+    validator.Feed(data, length);
+    return validator.Finish();
+}
+
+TextLayout::TextLayout()
+    : m_units(0), m_pendingCR(false), m_previousSpaces(0), m_tabLines(0), m_spaceLines(0)
+{
+    memset(m_endings, 0, sizeof(m_endings));
+    memset(m_steps, 0, sizeof(m_steps));
+    StartLine();
+}
+
+void TextLayout::StartLine()
+{
+    m_lineStarts.push_back((unsigned int)m_units);
+    m_inIndent = true;
+    m_indentChar = 0;
+    m_indentSpaces = 0;
+}
+
+// Called with the first character of a line that is not white space
+void TextLayout::EndIndent(unsigned char c)
+{
+    m_inIndent = false;
+    if (c == '\n' || c == '\r')
+        return;     // blank lines say nothing about indentation
+
+    if (m_indentChar == '\t') {
+        m_tabLines++;
+        m_previousSpaces = -1;
+    } else if (m_indentChar == ' ') {
+        m_spaceLines++;
+        int step = m_indentSpaces - m_previousSpaces;
+        if (m_indentSpaces >= 0 && m_previousSpaces >= 0 && step > 0 && step <= kMaxIndentSize)
+            m_steps[step]++;
+        m_previousSpaces = m_indentSpaces;
+    } else {
+        m_previousSpaces = 0;
+    }
+}
+
+void TextLayout::Feed(const char* data, size_t length)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    const unsigned char* end = p + length;
+    const unsigned long ones = (unsigned long)-1 / 0xFF;
+    const unsigned long highs = ones * 0x80;
+
+    while (p < end) {
+        unsigned char c = *p;
+        if (m_pendingCR) {
+            m_pendingCR = false;
+            if (c == '\n') {
+                m_endings[LINE_ENDING_CRLF]++;
+                m_units++;
+                p++;
+            } else {
+                m_endings[LINE_ENDING_CR]++;
+            }
+            StartLine();
+            continue;
+        }
+
+        if (m_inIndent) {
+            if (c == ' ' || c == '\t') {
+                if (!m_indentChar)
+                    m_indentChar = c;
+                if (c == '\t')
+                    m_indentSpaces = -1;
+                else if (m_indentSpaces >= 0)
+                    m_indentSpaces++;
+                m_units++;
+                p++;
+                continue;
+            }
+            EndIndent(c);
+        }
+
+        if (c == '\n' || c == '\r') {
+            m_units++;
+            p++;
+            if (c == '\r') {
+                m_pendingCR = true;
+            } else {
+                m_endings[LINE_ENDING_LF]++;
+                StartLine();
+            }
+            continue;
+        }
+
+        // Skip the rest of the line a word at a time up to the word with the
+        // line ending. A zero byte in word ^ '\n'... borrows in the subtraction
+        // and sets its high bit. In a multibyte character, continuation bytes
+        // add no code units and the lead byte of a surrogate pair adds two.
+        while ((size_t)(end - p) >= sizeof(unsigned long)) {
+            unsigned long word;
+            memcpy(&word, p, sizeof(word));
+            unsigned long lf = word ^ (ones * '\n');
+            unsigned long cr = word ^ (ones * '\r');
+            if ((((lf - ones) & ~lf) | ((cr - ones) & ~cr)) & highs)
+                break;
+            m_units += sizeof(word);
+            if (word & highs) {
+                m_units -= CountHighBytes(word & ~(word << 1) & highs);
+                m_units += CountHighBytes(word & (word << 1) & (word << 2) & (word << 3) & highs);
+            }
+            p += sizeof(word);
+        }
+        while (p < end && *p != '\n' && *p != '\r') {
+            c = *p++;
+            if (c < 0x80)
+                m_units++;
+            else if ((c & 0xC0) != 0x80)
+                m_units += c >= 0xF0 ? 2 : 1;
+        }
+    }
+}
+
+void TextLayout::Finish()
+{
+    if (m_pendingCR) {
+        m_pendingCR = false;
+        m_endings[LINE_ENDING_CR]++;
+        StartLine();
+    }
+}
+
+TextLayout::LineEnding TextLayout::GetLineEnding() const
+{
+    LineEnding result = LINE_ENDING_NONE;
+    unsigned int count = 0;
+    const LineEnding order[] = { LINE_ENDING_LF, LINE_ENDING_CRLF, LINE_ENDING_CR };
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        if (m_endings[order[i]] > count) {
+            count = m_endings[order[i]];
+            result = order[i];
+        }
+    }
+    return result;
+}
+
+int TextLayout::GetIndentSize() const
+{
+    int result = 0;
+    for (int step = 1; step <= kMaxIndentSize; step++) {
+        if (m_steps[step] > m_steps[result])
+            result = step;
+    }
+    return result;
+}
+
+} // namespace FileSystem
+} // namespace Brackets
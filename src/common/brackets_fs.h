@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_FS_H
+#define _BRACKETS_FS_H
+
+#include "include/internal/cef_build.h"
+
+#include <string>
+#include <vector>
+
+#if defined(OS_WIN)
+#include <windows.h>
+#endif
+
+// Error values. These MUST be in sync with the error values
+// in brackets_extensions.js
+#if !defined(OS_WIN)
+static const int NO_ERROR                   = 0;
+#endif
+static const int ERR_UNKNOWN                = 1;
+static const int ERR_INVALID_PARAMS         = 2;
+static const int ERR_NOT_FOUND              = 3;
+static const int ERR_CANT_READ              = 4;
+static const int ERR_UNSUPPORTED_ENCODING   = 5;
+static const int ERR_CANT_WRITE             = 6;
+static const int ERR_OUT_OF_SPACE           = 7;
+static const int ERR_NOT_FILE               = 8;
+static const int ERR_NOT_DIRECTORY          = 9;
+static const int ERR_CANCELLED              = 10;
+static const int ERR_TIMEOUT                = 11;
+
+// Paths are passed to the file system core in the native string type of
+// the platform: UTF-16 on Windows, UTF-8 everywhere else.
+#if defined(OS_WIN)
+typedef std::wstring ExtensionString;
+#else
+typedef std::string ExtensionString;
+#endif
+
+// Type, size and modification time of a file or directory
+struct FileInfo {
+    FileInfo() : isDirectory(false), size(0), mtimeSec(0), mtimeNsec(0) {}
+
+    bool isDirectory;
+    unsigned long long size;
+    long long mtimeSec;     // seconds since the epoch
+    long mtimeNsec;         // nanoseconds within mtimeSec
+};
+
+// One entry returned by ReadDirWithStats
+struct DirEntry {
+    ExtensionString name;
+    FileInfo info;
+};
+
+// Identity of a file or directory: the same for every path that leads to it,
+// through symlinks, junctions or hard links. |index| is 0 when unknown.
+struct FileId {
+    FileId() : device(0), index(0) {}
+
+    bool operator==(const FileId& other) const { return device == other.device && index == other.index; }
+
+    unsigned long long device;
+    unsigned long long index;
+};
+
+/**
+ * Platform-neutral file system core used by BracketsExtensionHandler.
+ *
+ * Every function returns one of the error values above. The Win32
+ * implementation lives in brackets_fs_win.cpp and the POSIX one (Mac, Linux)
+ * in brackets_fs_posix.cpp. None of these functions touch V8, so they can be
+ * driven from any thread and from the headless host in src/linux.
+ */
+namespace Brackets {
+namespace FileSystem {
+
+// Names of the entries in |path|, not including '.' and '..'.
+int ReadDir(const ExtensionString& path, std::vector<ExtensionString>& contents);
+
+// Names and FileInfo of the entries in |path|, not including '.' and '..',
+// sorted by SortDirEntries. Entries that disappear while the directory is
+// being read are left out.
+int ReadDirWithStats(const ExtensionString& path, std::vector<DirEntry>& entries);
+
+// Sorts directories before files, then by case-insensitive name
+void SortDirEntries(std::vector<DirEntry>& entries);
+
+// Entries of |path| for walking a tree. Like ReadDirWithStats, but unless
+// |withStats| is set only info.isDirectory is filled in, and files are not
+// stat'ed where the listing itself tells them from directories (d_type,
+// FindFirstFile). Symlinks are followed. Entries are not sorted. |id| is set
+// to the identity of |path|.
+int ListDirectory(const ExtensionString& path, bool withStats, std::vector<DirEntry>& entries, FileId& id);
+
+int IsDirectory(const ExtensionString& path, bool& isDirectory);
+
+// Type, size and modification time of |path|, following symlinks
+int GetFileInfo(const ExtensionString& path, FileInfo& info);
+
+// GetFileInfo of several entries of |directory|, with one error per name in
+// |errors|. On Linux the directory is opened once and each entry is
+// stat'ed relative to it, so the directory's path is only walked once.
+void GetFileInfosAt(const ExtensionString& directory, const std::vector<ExtensionString>& names,
+                    std::vector<FileInfo>& infos, std::vector<int>& errors);
+
+// Modification time in seconds since the epoch
+int GetFileModificationTime(const ExtensionString& path, double& modTime);
+
+// Encodings ReadFile and WriteFile take, by the names brackets_extensions.js
+// uses for them. Text is always UTF-8 on this side; see brackets_encoding.h.
+enum TextEncoding {
+    ENCODING_UTF8 = 0,  // "utf8": a byte order mark is kept as part of the text
+    ENCODING_UTF8_BOM,  // "utf8bom": with a byte order mark, which is not
+    ENCODING_UTF16LE,   // "utf16le", with a byte order mark when written
+    ENCODING_UTF16BE,   // "utf16be", likewise
+    ENCODING_LATIN1,    // "latin1": ISO-8859-1, one byte per character
+    ENCODING_AUTO       // "auto", reading only: the byte order mark's
+                        // encoding, else UTF-8 if valid, else Latin-1
+};
+
+bool ParseEncoding(const ExtensionString& name, TextEncoding& encoding);
+const char* GetEncodingName(TextEncoding encoding);
+
+// |contents| is UTF-8, transcoded from |encoding|. With 'utf8' the file is
+// read straight into |contents| and validated as it is read, so peak memory
+// is about the size of the file; other encodings are read whole and then
+// transcoded. Sizes are 64-bit; files that do not fit in memory fail with
+// ERR_CANT_READ. Files that are not valid in |encoding| fail with
+// ERR_UNSUPPORTED_ENCODING. If |layout| is given, it is fed the text. If
+// |detected| is given, it is set to the encoding the file turned out to be
+// in, which is what WriteFile should be given to save it the same way.
+class TextLayout;
+int ReadFile(const ExtensionString& path, const ExtensionString& encoding, std::string& contents,
+             TextLayout* layout = NULL, TextEncoding* detected = NULL);
+
+// The platform part of ReadFile: reads the bytes of |path| into |contents|.
+// With |validateUTF8| it fails with ERR_UNSUPPORTED_ENCODING unless they are
+// UTF-8, and feeds |layout| each chunk as it is read.
+int ReadFileBytes(const ExtensionString& path, std::string& contents, bool validateUTF8, TextLayout* layout);
+
+// How far WriteFile goes to make sure the new contents survive a crash or a
+// power failure. Values are shared with brackets_extensions.js.
+enum Durability {
+    DURABILITY_NONE = 0,    // the system writes the data back when it likes
+    DURABILITY_DATA = 1,    // the data is flushed to disk before the rename
+    DURABILITY_FULL = 2,    // file and directory are flushed, through disk caches
+};
+
+// Writes |contents| to a temporary file next to |path| and renames it over
+// |path|, so a crash leaves either the old file or the new one, never a
+// truncated mix. Symlinks are written through, even to a target that doesn't
+// exist yet, and the permissions of an existing file are kept. Where a rename
+// would change more than the contents (a file with hard links, one whose
+// owner or permissions can't be copied, or a directory that can't be written
+// to) the file is rewritten in place instead. |contents| is UTF-8 and is
+// written in |encoding|; text that |encoding| can't hold fails with
+// ERR_UNSUPPORTED_ENCODING.
+int WriteFile(const ExtensionString& path, const std::string& contents, const ExtensionString& encoding,
+              Durability durability);
+
+int SetPosixPermissions(const ExtensionString& path, int mode);
+
+// Deletes a file. On Mac and Linux a directory is deleted too, along with
+// everything in it; on Windows only files can be deleted.
+int DeleteFileOrDirectory(const ExtensionString& path);
+
+// Open file, for reading a range at a time with ReadFileAt
+#if defined(OS_WIN)
+typedef HANDLE PlatformFile;
+#else
+typedef int PlatformFile;
+#endif
+
+// Opens |path| for reading. Other processes may keep writing to the file,
+// which is what following a log needs.
+int OpenFileForReading(const ExtensionString& path, PlatformFile& file);
+
+// Current size of an open file, in bytes
+int GetOpenFileSize(PlatformFile file, unsigned long long& size);
+
+// FileInfo and identity of an open file
+int GetOpenFileInfo(PlatformFile file, FileInfo& info, FileId& id);
+
+// Reads up to |length| bytes at |offset| without moving a shared file
+// position. |bytesRead| is less than |length| only at the end of the file.
+int ReadFileAt(PlatformFile file, unsigned long long offset, char* buffer, size_t length, size_t& bytesRead);
+
+void CloseFile(PlatformFile file);
+
+// Creates |path|, or empties it if it exists, and opens it for writing at
+// the end with AppendToFile. A new file can only be read by the current user
+// on POSIX systems.
+int CreateFileForAppending(const ExtensionString& path, PlatformFile& file);
+
+// Writes all |length| bytes at |data| at the end of |file|
+int AppendToFile(PlatformFile file, const char* data, size_t length);
+
+// Flushes what was written to |file| to the disk, the data without the
+// metadata where the system can
+int SyncFile(PlatformFile file);
+
+// Read-only view of the start of an open file, for scanning it without
+// copying it into a buffer first. Another process that truncates the file
+// while it is mapped makes the missing pages fault, so only map files that
+// are worth it.
+struct MappedFile {
+    MappedFile() : data(NULL), length(0) {}
+
+    const char* data;   // NULL when |length| is 0
+    size_t length;
+};
+
+// Maps the first |length| bytes of |file|. The mapping stays valid after the
+// file is closed.
+int MapFile(PlatformFile file, size_t length, MappedFile& mapped);
+void UnmapFile(MappedFile& mapped);
+
+// A WriteFile in progress. WriteFile is also available as separate steps so
+// that a batch of files can share one round of flushes: BeginWrite writes the
+// contents to a temporary file, SyncWrite flushes it, CommitWrite puts it in
+// place of the original and AbortWrite throws it away. For a file that is
+// rewritten in place, BeginWrite already replaces the contents.
+struct PendingWrite {
+    PendingWrite() : exists(false), isOpen(false) {}
+
+    ExtensionString target;     // file being replaced, with symlinks resolved
+    ExtensionString tempPath;   // empty when the file is rewritten in place
+    ExtensionString directory;  // directory that holds |target|
+    bool exists;                // |target| existed before the write
+    bool isOpen;
+    PlatformFile file;
+};
+
+int BeginWrite(const ExtensionString& path, const std::string& contents, const ExtensionString& encoding,
+               PendingWrite& write);
+
+// The platform part of BeginWrite, given the bytes to write
+int BeginWriteBytes(const ExtensionString& path, const std::string& contents, PendingWrite& write);
+int SyncWrite(PendingWrite& write, Durability durability);
+int CommitWrite(PendingWrite& write, Durability durability);
+void AbortWrite(PendingWrite& write);
+
+// Flushes the entries of |directory|, so that renames in it survive a crash
+void SyncDirectory(const ExtensionString& directory);
+
+// Maps errors from errno.h to the brackets error codes
+int ConvertErrnoCode(int errorCode, bool isReading = true);
+
+#if defined(OS_WIN)
+// Maps errors from WinError.h to the brackets error codes
+int ConvertWinErrorCode(int errorCode, bool isReading = true);
+#endif
+
+// Checks that a stream of bytes is well-formed UTF-8 as it arrives, so that
+// ReadFile can validate each chunk right after reading it instead of making a
+// second pass over the whole file. Sequences may be split across chunks.
+//
+// Runs of ASCII are skipped a word at a time. The other scanners in common/
+// (TextLayout, the transcoders, LineDiff, Hasher, LiteralMatcher) work the
+// same way rather than with SIMD intrinsics: this code is C++03 that has to
+// build unchanged with MSVC, GCC and Xcode for every target, so it stays
+// with word-sized arithmetic and leaves byte searches to memchr, which the C
+// library already vectorizes.
+class UTF8Validator
+{
+public:
+    UTF8Validator() : m_codePoint(0), m_minimum(0), m_remaining(0), m_valid(true) {}
+
+    // Checks the next |length| bytes. Returns false once anything fed so far
+    // is invalid.
+    bool Feed(const char* data, size_t length);
+
+    // True if everything fed so far is valid and no sequence was cut short
+    bool Finish() const { return m_valid && m_remaining == 0; }
+
+private:
+    unsigned int m_codePoint;   // bits of the sequence being decoded
+    unsigned int m_minimum;     // smallest code point its length may encode
+    int m_remaining;            // continuation bytes still expected
+    bool m_valid;
+};
+
+// True if |length| bytes at |data| are well-formed UTF-8
+bool IsValidUTF8(const char* data, size_t length);
+
+// Finds where the lines of a text start, which line endings it uses and how
+// it is indented, fed one chunk at a time like UTF8Validator so that ReadFile
+// can do it while each chunk is still in the cache. Offsets are in UTF-16
+// code units, the unit of a JS string index. The text is assumed to be valid
+// UTF-8.
+class TextLayout
+{
+public:
+    enum LineEnding {
+        LINE_ENDING_NONE = 0,
+        LINE_ENDING_LF,
+        LINE_ENDING_CRLF,
+        LINE_ENDING_CR
+    };
+
+    TextLayout();
+
+    void Feed(const char* data, size_t length);
+
+    // Ends the last line. Call once, after the last Feed.
+    void Finish();
+
+    // Offset of the first character of each line, starting with 0. A text
+    // that ends with a line ending has an empty last line, as with split.
+    const std::vector<unsigned int>& GetLineStarts() const { return m_lineStarts; }
+
+    unsigned int GetLineEndingCount(LineEnding ending) const { return m_endings[ending]; }
+
+    // The most common line ending, LF on a tie, or LINE_ENDING_NONE if the
+    // text is a single line
+    LineEnding GetLineEnding() const;
+
+    // Number of lines indented with a tab first and with a space first
+    unsigned int GetTabIndentedLines() const { return m_tabLines; }
+    unsigned int GetSpaceIndentedLines() const { return m_spaceLines; }
+
+    // The most common increase in indentation between lines indented with
+    // spaces, or 0 if there is none
+    int GetIndentSize() const;
+
+private:
+    void StartLine();
+    void EndIndent(unsigned char c);
+
+    static const int kMaxIndentSize = 8;
+
+    std::vector<unsigned int> m_lineStarts;
+    size_t m_units;                 // UTF-16 code units so far
+    bool m_pendingCR;               // the last byte was a CR, which may start a CRLF
+    bool m_inIndent;                // still in the leading white space of the line
+    unsigned char m_indentChar;     // first character of the line's indentation
+    int m_indentSpaces;             // spaces in it, if it has no tabs
+    int m_previousSpaces;           // same for the last indented line, -1 for tabs
+    unsigned int m_endings[4];
+    unsigned int m_tabLines;
+    unsigned int m_spaceLines;
+    unsigned int m_steps[kMaxIndentSize + 1];
+};
+
+} // namespace FileSystem
+} // namespace Brackets
+
+#endif // _BRACKETS_FS_H
@@ -0,0 +1,1695 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_fs_extension.h"
+#include "common/brackets_async.h"
+#include "common/brackets_content_cache.h"
+#include "common/brackets_dispatch.h"
+#include "common/brackets_diff.h"
+#include "common/brackets_edit_journal.h"
+#include "common/brackets_file_stream.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_hash.h"
+#include "common/brackets_path_handles.h"
+#include "common/brackets_path_matcher.h"
+#include "common/brackets_path_store.h"
+#include "common/brackets_search.h"
+#include "common/brackets_search_index.h"
+#include "common/brackets_stat_cache.h"
+#include "common/brackets_project_snapshot.h"
+#include "common/brackets_walker.h"
+#include "common/brackets_watcher.h"
+
+#include <math.h>
+#include <set>
+
+namespace Brackets {
+namespace FileSystem {
+
+CefRefPtr<CefV8Value> StringListToV8Array(const std::vector<ExtensionString>& list)
+{
+    CefRefPtr<CefV8Value> result = CefV8Value::CreateArray();
+    for (size_t i = 0; i < list.size(); i++)
+        result->SetValue((int)i, CefV8Value::CreateString(list[i]));
+    return result;
+}
+
+void SetFileInfoValues(CefRefPtr<CefV8Value> object, const FileInfo& info)
+{
+    object->SetValue("isDirectory", CefV8Value::CreateBool(info.isDirectory), V8_PROPERTY_ATTRIBUTE_NONE);
+    object->SetValue("size", CefV8Value::CreateDouble((double)info.size), V8_PROPERTY_ATTRIBUTE_NONE);
+    object->SetValue("mtime", CefV8Value::CreateDate(CefTime(info.mtimeSec + info.mtimeNsec / 1e9)),
+                     V8_PROPERTY_ATTRIBUTE_NONE);
+    object->SetValue("mtimeNsec", CefV8Value::CreateInt((int)info.mtimeNsec), V8_PROPERTY_ATTRIBUTE_NONE);
+}
+
+CefRefPtr<CefV8Value> DirEntriesToV8Array(const std::vector<DirEntry>& entries)
+{
+    CefRefPtr<CefV8Value> result = CefV8Value::CreateArray();
+    for (size_t i = 0; i < entries.size(); i++) {
+        const DirEntry& entry = entries[i];
+        CefRefPtr<CefV8Value> item = CefV8Value::CreateObject(NULL);
+        item->SetValue("name", CefV8Value::CreateString(entry.name), V8_PROPERTY_ATTRIBUTE_NONE);
+        SetFileInfoValues(item, entry.info);
+        result->SetValue((int)i, item);
+    }
+    return result;
+}
+
+namespace {
+
+// Strings that are already UTF-8 are copied as they are
+void ToUTF8(const char* chars, size_t length, std::string& result)
+{
+    result.assign(chars, length);
+}
+
+// Decodes the code point at chars[i] and moves |i| past it. Unpaired
+// surrogates become U+FFFD, as in CEF's own conversion.
+template <class Char>
+unsigned int NextCodePoint(const Char* chars, size_t length, size_t& i)
+{
+    unsigned int c = (unsigned int)chars[i++];
+    if (c >= 0xD800 && c <= 0xDBFF && i < length) {
+        unsigned int low = (unsigned int)chars[i];
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            i++;
+            return 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+        }
+    }
+    if ((c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF)
+        return 0xFFFD;
+    return c;
+}
+
+template <class Char>
+void ToUTF8(const Char* chars, size_t length, std::string& result)
+{
+    // Measure first, so that |result| is allocated exactly once
+    size_t size = 0;
+    for (size_t i = 0; i < length; ) {
+        unsigned int c = NextCodePoint(chars, length, i);
+        size += c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+    }
+
+    result.resize(size);
+    char* out = size ? &result[0] : NULL;
+    for (size_t i = 0; i < length; ) {
+        unsigned int c = NextCodePoint(chars, length, i);
+        if (c < 0x80) {
+            *out++ = (char)c;
+        } else if (c < 0x800) {
+            *out++ = (char)(0xC0 | (c >> 6));
+            *out++ = (char)(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            *out++ = (char)(0xE0 | (c >> 12));
+            *out++ = (char)(0x80 | ((c >> 6) & 0x3F));
+            *out++ = (char)(0x80 | (c & 0x3F));
+        } else {
+            *out++ = (char)(0xF0 | (c >> 18));
+            *out++ = (char)(0x80 | ((c >> 12) & 0x3F));
+            *out++ = (char)(0x80 | ((c >> 6) & 0x3F));
+            *out++ = (char)(0x80 | (c & 0x3F));
+        }
+    }
+}
+
+bool GetDurabilityArgument(CefRefPtr<CefV8Value> value, Durability& durability)
+{
+    if (!value->IsInt())
+        return false;
+
+    int mode = value->GetIntValue();
+    if (mode < DURABILITY_NONE || mode > DURABILITY_FULL)
+        return false;
+
+    durability = (Durability)mode;
+    return true;
+}
+
+// A path argument is a string, or a handle from InternPaths
+bool IsPathValue(CefRefPtr<CefV8Value> value)
+{
+    return value->IsString() || value->IsInt();
+}
+
+// Checks the (path[, bypassCache]) arguments of the functions that go
+// through the StatCache
+bool GetPathArguments(const CefV8ValueList& arguments, bool& bypassCache)
+{
+    if (arguments.size() < 1 || arguments.size() > 2 || !IsPathValue(arguments[0]))
+        return false;
+
+    if (arguments.size() == 2) {
+        if (!arguments[1]->IsBool())
+            return false;
+        bypassCache = arguments[1]->GetBoolValue();
+    }
+    return true;
+}
+
+// Checks the (path[, bypassCache], callback, ...) arguments of an Async
+// lookup and finds the callback, which moves up when bypassCache is left out
+bool GetAsyncPathArguments(const CefV8ValueList& arguments, bool& bypassCache, size_t& callbackIndex)
+{
+    if (arguments.size() < 2 || !IsPathValue(arguments[0]))
+        return false;
+
+    callbackIndex = 1;
+    if (!arguments[1]->IsFunction()) {
+        if (!arguments[1]->IsBool())
+            return false;
+        bypassCache = arguments[1]->GetBoolValue();
+        callbackIndex = 2;
+    }
+    return true;
+}
+
+} // namespace
+
+void GetUTF8StringValue(CefRefPtr<CefV8Value> value, std::string& result)
+{
+    CefString str = value->GetStringValue();
+    ToUTF8(str.c_str(), str.length(), result);
+}
+
+void UTF16ToUTF8(const unsigned short* units, size_t length, std::string& result)
+{
+    ToUTF8(units, length, result);
+}
+
+const ExtensionString* GetPathValue(CefRefPtr<CefV8Value> value, ExtensionString& storage)
+{
+    if (value->IsInt())
+        return PathHandleRegistry::GetInstance().Get(value->GetIntValue());
+    if (!value->IsString())
+        return NULL;
+
+#if defined(OS_WIN)
+    storage = value->GetStringValue();
+#else
+    GetUTF8StringValue(value, storage);
+#endif
+    return &storage;
+}
+
+bool GetNumberValue(CefRefPtr<CefV8Value> value, unsigned long long& result)
+{
+    double number;
+    if (value->IsInt())
+        number = value->GetIntValue();
+    else if (value->IsDouble())
+        number = value->GetDoubleValue();
+    else
+        return false;
+
+    // Integers are exact in a double up to 2^53
+    if (!(number >= 0 && number <= 9007199254740992.0) || floor(number) != number)
+        return false;
+
+    result = (unsigned long long)number;
+    return true;
+}
+
+CefRefPtr<CefV8Value> FileContentsToResult(std::string& contents)
+{
+    CefString result(contents);
+    std::string().swap(contents);
+    return CefV8Value::CreateString(result);
+}
+
+CefRefPtr<CefV8Value> TextLayoutToResult(std::string& contents, const TextLayout& layout)
+{
+    CefRefPtr<CefV8Value> result = CefV8Value::CreateObject(NULL);
+    result->SetValue("data", FileContentsToResult(contents), V8_PROPERTY_ATTRIBUTE_NONE);
+
+    const std::vector<unsigned int>& starts = layout.GetLineStarts();
+    CefRefPtr<CefV8Value> lineStarts = CefV8Value::CreateArray();
+    for (size_t i = 0; i < starts.size(); i++)
+        lineStarts->SetValue((int)i, CefV8Value::CreateInt((int)starts[i]));
+    result->SetValue("lineStarts", lineStarts, V8_PROPERTY_ATTRIBUTE_NONE);
+
+    const char* const endings[] = { NULL, "\n", "\r\n", "\r" };
+    TextLayout::LineEnding ending = layout.GetLineEnding();
+    result->SetValue("lineEnding", endings[ending] ? CefV8Value::CreateString(endings[ending]) :
+                     CefV8Value::CreateNull(), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("lf", CefV8Value::CreateInt((int)layout.GetLineEndingCount(TextLayout::LINE_ENDING_LF)),
+                     V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("crlf", CefV8Value::CreateInt((int)layout.GetLineEndingCount(TextLayout::LINE_ENDING_CRLF)),
+                     V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("cr", CefV8Value::CreateInt((int)layout.GetLineEndingCount(TextLayout::LINE_ENDING_CR)),
+                     V8_PROPERTY_ATTRIBUTE_NONE);
+
+    unsigned int tabLines = layout.GetTabIndentedLines();
+    unsigned int spaceLines = layout.GetSpaceIndentedLines();
+    CefRefPtr<CefV8Value> indent = CefV8Value::CreateNull();
+    if (tabLines > spaceLines)
+        indent = CefV8Value::CreateString("tabs");
+    else if (spaceLines > 0)
+        indent = CefV8Value::CreateString("spaces");
+    result->SetValue("indent", indent, V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("indentSize", CefV8Value::CreateInt(layout.GetIndentSize()), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("tabLines", CefV8Value::CreateInt((int)tabLines), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("spaceLines", CefV8Value::CreateInt((int)spaceLines), V8_PROPERTY_ATTRIBUTE_NONE);
+    return result;
+}
+
+namespace {
+
+typedef int (*FileSystemFunction)(const CefV8ValueList& arguments,
+                                  CefRefPtr<CefV8Value>& retval,
+                                  CefString& exception);
+
+// Native functions implemented here, registered by name
+NativeFunctionTable<FileSystemFunction> CreateFunctionTable()
+{
+    NativeFunctionTable<FileSystemFunction> functions;
+
+    // ReadDir(path[, bypassCache])
+    //
+    // Inputs:
+    //  path - full path of directory to be read
+    //  bypassCache - true to read the directory even if the StatCache has it
+    //
+    // Outputs:
+    //  Array of the names of the files in the directory, not including '.' and '..'.
+    //
+    // Error:
+    //   NO_ERROR - no error
+    //   ERR_UNKNOWN - unknown error
+    //   ERR_INVALID_PARAMS - invalid parameters
+    //   ERR_NOT_FOUND - directory could not be found
+    //   ERR_CANT_READ - could not read directory
+    functions.Add("ReadDir", ExecuteReadDir);
+
+    // ReadDirWithStats(path[, bypassCache])
+    //
+    // Inputs:
+    //  path - full path of directory to be read
+    //  bypassCache - true to read the directory even if the StatCache has it
+    //
+    // Outputs:
+    //  Array with one object per entry, not including '.' and '..':
+    //    { name, isDirectory, size, mtime, mtimeNsec }
+    //  Directories are listed first, then files, each sorted by name.
+    //
+    // Error:
+    //   NO_ERROR - no error
+    //   ERR_UNKNOWN - unknown error
+    //   ERR_INVALID_PARAMS - invalid parameters
+    //   ERR_NOT_FOUND - directory could not be found
+    //   ERR_CANT_READ - could not read directory
+    functions.Add("ReadDirWithStats", ExecuteReadDirWithStats);
+
+    // IsDirectory(path[, bypassCache])
+    //
+    // Inputs:
+    //  path - full path of directory to test
+    //  bypassCache - true to ask the file system even if the StatCache knows
+    //
+    // Outputs:
+    //  true if path is a directory, false if error or it is a file
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_NOT_FOUND - file/directory could not be found
+    functions.Add("IsDirectory", ExecuteIsDirectory);
+
+    // GetFileInfo(path[, bypassCache])
+    //
+    // Inputs:
+    //  path - full path of file or directory
+    //  bypassCache - true to ask the file system even if the StatCache knows
+    //
+    // Output:
+    //  { isDirectory, size, mtime, mtimeNsec }, as in ReadDirWithStats.
+    //  One call instead of IsDirectory plus GetFileModificationTime.
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_NOT_FOUND - file/directory could not be found
+    functions.Add("GetFileInfo", ExecuteGetFileInfo);
+
+    // ReadFile(path, encoding[, withLayout])
+    //
+    // Inputs:
+    //  path - full path of file to read
+    //  encoding - 'utf8', 'utf8bom', 'utf16le', 'utf16be', 'latin1', or
+    //             'auto' to go by the byte order mark, else UTF-8 if the
+    //             file is valid UTF-8, else Latin-1
+    //  withLayout - true to also find the lines of the file and how it is
+    //               laid out, in the same pass as the read
+    //
+    // Output:
+    //  String - contents of the file, for 'utf8' without withLayout
+    //  Otherwise an object:
+    //   data - contents of the file
+    //   encoding - what the file was found to be in, to save it in
+    //   lineStarts - offset in data of the start of each line, as a list
+    //   lineEnding - most common line ending, "\n", "\r\n" or "\r", or null
+    //   lf, crlf, cr - number of each line ending, to tell mixed endings
+    //   indent - "tabs" or "spaces", whichever starts more lines, or null
+    //   indentSize - most common indentation step in spaces, or 0
+    //   tabLines, spaceLines - number of lines indented with each
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_UNKNOWN - unknown error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_NOT_FOUND - file could not be found
+    //  ERR_CANT_READ - file could not be read
+    //  ERR_UNSUPPORTED_ENCODING - unsupported encoding value, or the file
+    //      is not valid in it
+    functions.Add("ReadFile", ExecuteReadFile);
+
+    // WriteFile(path, data, encoding[, durability])
+    //
+    // Inputs:
+    //  path - full path of file to write
+    //  data - data to write to file
+    //  encoding - any encoding ReadFile takes but 'auto'. 'utf8bom' and
+    //             UTF-16 are written with a byte order mark.
+    //  durability - DURABILITY_NONE, DURABILITY_DATA (the default) or
+    //      DURABILITY_FULL. The file is always replaced atomically; this says
+    //      how much is flushed to disk before the call returns.
+    //
+    // Output:
+    //  none
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_UNKNOWN - unknown error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_UNSUPPORTED_ENCODING - unsupported encoding value, or data
+    //      the encoding can't hold
+    //  ERR_CANT_WRITE - file could not be written
+    //  ERR_OUT_OF_SPACE - no more space for file
+    functions.Add("WriteFile", ExecuteWriteFile);
+
+    // SetPosixPermissions(path, mode)
+    //
+    // Inputs:
+    //  path - full path of file or directory
+    //  mode - permissions for file or directory, in numeric format
+    //
+    // Output:
+    //  none
+    //
+    // Errors
+    //  NO_ERROR - no error
+    //  ERR_UNKNOWN - unknown error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_NOT_FOUND - can't file file/directory
+    //  ERR_UNSUPPORTED_ENCODING - unsupported encoding value
+    //  ERR_CANT_WRITE - permissions could not be written
+    functions.Add("SetPosixPermissions", ExecuteSetPosixPermissions);
+
+    // Returns the time stamp for a file or directory
+    //
+    // Inputs:
+    //  path - full path of file or directory
+    //  bypassCache - optional, true to ask the file system even if the
+    //      StatCache knows
+    //
+    // Outputs:
+    // Date - timestamp of file
+    //
+    // Possible error values:
+    //    NO_ERROR
+    //    ERR_UNKNOWN
+    //    ERR_INVALID_PARAMS
+    //    ERR_NOT_FOUND
+    functions.Add("GetFileModificationTime", ExecuteGetFileModificationTime);
+
+    // DeleteFileOrDirectory(path)
+    //
+    // Inputs:
+    //  path - full path of file or directory
+    //
+    // Ouput:
+    //  none
+    //
+    // Errors
+    //  NO_ERROR - no error
+    //  ERR_UNKNOWN - unknown error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_NOT_FOUND - can't file file/directory
+    functions.Add("DeleteFileOrDirectory", ExecuteDeleteFileOrDirectory);
+
+    // ReadDirAsync(path[, bypassCache], callback[, timeout])
+    // ReadDirWithStatsAsync(path[, bypassCache], callback[, timeout])
+    // ReadFileAsync(path, encoding[, withLayout], callback[, timeout])
+    // WriteFileAsync(path, data, encoding[, durability], callback[, timeout])
+    //
+    // Same as the functions above, but the work is done off the UI thread.
+    // They return a request id right away; callback(err, result) is called
+    // on the UI thread when the operation is done. result is the value the
+    // synchronous function would have returned, and is left out for
+    // WriteFileAsync and when err is not NO_ERROR. If timeout (in
+    // milliseconds) is given and runs out first, err is ERR_TIMEOUT.
+    //
+    // Error (from GetLastError, right after the call):
+    //  NO_ERROR - the operation has started
+    //  ERR_INVALID_PARAMS - invalid parameters, callback will not be called
+    functions.Add("ReadDirAsync", ExecuteReadDirAsync);
+    functions.Add("ReadDirWithStatsAsync", ExecuteReadDirWithStatsAsync);
+    functions.Add("ReadFileAsync", ExecuteReadFileAsync);
+    functions.Add("WriteFileAsync", ExecuteWriteFileAsync);
+
+    // WriteFilesAsync(paths, datas, encoding[, durability], callback[, timeout])
+    //
+    // Saves several files at once, like calling WriteFileAsync for each
+    // paths[i] and datas[i], but with one flush barrier for the whole batch:
+    // every file is written and flushed, in parallel, before any of them
+    // replaces its original. callback(err, errors) gets an array with the
+    // error code of each file; err is NO_ERROR even if some files failed.
+    //
+    // Error (from GetLastError, right after the call):
+    //  NO_ERROR - the operation has started
+    //  ERR_INVALID_PARAMS - invalid parameters, callback will not be called
+    functions.Add("WriteFilesAsync", ExecuteWriteFilesAsync);
+
+    // DiffFileAsync(path, text, encoding, callback[, timeout])
+    //
+    // Compares text, the contents of an open document, with the file at
+    // path as it is on disk now, line by line, off the UI thread. Lines end
+    // after each "\n" and include it. callback(err, result) gets
+    //  hunks - four numbers per hunk: oldStart, oldCount, newStart, newCount.
+    //      oldCount lines of text from line oldStart (from 0) are replaced by
+    //      newCount lines of the file from line newStart.
+    //  texts - the lines of the file each hunk puts in
+    //  oldLines, newLines - number of lines in text and in the file
+    // Only what changed crosses over to JS; applying the hunks to text, last
+    // first, gives the contents of the file. Hunks are the fewest lines
+    // that change, except in regions with thousands of changes.
+    //
+    // Error (from GetLastError, right after the call):
+    //  NO_ERROR - the operation has started
+    //  ERR_INVALID_PARAMS - invalid parameters, callback will not be called
+    //
+    // Error (passed to callback): as for ReadFileAsync
+    functions.Add("DiffFileAsync", ExecuteDiffFileAsync);
+
+    // HashFileAsync(path, algorithm[, options], callback[, timeout])
+    // HashFilesAsync(paths, algorithm[, options], callback[, timeout])
+    //
+    // Hashes a file, or each file in the array paths, off the UI thread
+    // without bringing its contents over to JS. algorithm is "xxh3" (fast,
+    // for telling whether a file changed), "sha1" or "sha256". options may
+    // have:
+    //  offset, length - the range of bytes to hash (default the whole
+    //      file). It is cut to the end of the file.
+    //  bypassCache - read the file even if its digest is cached
+    //
+    // Digests are cached by the identity, size and modification time of
+    // the file, so hashing a file that hasn't changed doesn't read it
+    // again. See HashCache. The result of a file is
+    // { hash, offset, length, isDirectory, size, mtime, mtimeNsec, cached,
+    // time }: the digest as hex, the range hashed, the file's stats when it
+    // was opened, whether the digest came from the cache and the time spent
+    // reading and hashing, in milliseconds. HashFilesAsync passes an array
+    // with the result of each file, or its error number.
+    //
+    // Error (from GetLastError, right after the call):
+    //  NO_ERROR - the operation has started
+    //  ERR_INVALID_PARAMS - invalid parameters, callback will not be called
+    //
+    // Error (passed to callback of HashFileAsync):
+    //  NO_ERROR - no error
+    //  ERR_NOT_FOUND - file does not exist
+    //  ERR_CANT_READ - file could not be read, or is a directory
+    functions.Add("HashFileAsync", ExecuteHashFileAsync);
+    functions.Add("HashFilesAsync", ExecuteHashFilesAsync);
+
+    // HashText(text, algorithm)
+    //
+    // Output:
+    //  digest of the UTF-8 encoding of text, as hex. It is the same as the
+    //  digest of a UTF-8 file with that text, so a document can be compared
+    //  with its file, or with other documents, by digest.
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    functions.Add("HashText", ExecuteHashText);
+
+    // GetHashCacheStats()
+    //
+    // Output:
+    //  { hits, misses, bypassed, bytes, time, entries }: digests taken from
+    //  the cache, files read, files read with bypassCache, the bytes they
+    //  had and the milliseconds spent on them since the process started,
+    //  and how many digests are cached now. bytes / time is the throughput.
+    functions.Add("GetHashCacheStats", ExecuteGetHashCacheStats);
+
+    // WalkTreeAsync(roots, options, progress, callback[, timeout])
+    //
+    // Lists everything under each directory in the array roots, in
+    // parallel. options may have:
+    //  ignore - array of .gitignore-style patterns to leave out under every
+    //      root, such as ".git" or "node_modules/"
+    //  gitignore - apply the .gitignore files found in the tree (default true)
+    //  stats - fill in size and modification time, at the cost of a stat per
+    //      file (default false)
+    //  maxDepth - directories below this depth are not listed (default 64)
+    //
+    // progress(root, entries) is called with batches of entries as they are
+    // found. Paths in entries are relative to root. Without stats they are
+    // names, directories ending with '/'; with stats they are objects as in
+    // ReadDirWithStats.
+    // Symlinks are followed, except back to a directory above them.
+    //
+    // callback(err, summary) comes after the last batch, with summary
+    // { files, directories, excluded, unreadable, cycles, rootErrors }.
+    // rootErrors has the error code of each root, NO_ERROR if it was listed.
+    //
+    // Error (from GetLastError, right after the call):
+    //  NO_ERROR - the walk has started
+    //  ERR_INVALID_PARAMS - invalid parameters, callback will not be called
+    functions.Add("WalkTreeAsync", ExecuteWalkTreeAsync);
+
+    // SearchFilesAsync(paths, query, options, progress, callback[, timeout])
+    //
+    // Finds the literal string query, or the regular expression with the
+    // regex option, in the files under each directory in the array paths,
+    // and in each file listed there directly. Files are searched in
+    // parallel, without going through JS strings; files with a NUL byte
+    // near the start are skipped as binary. The query can't contain a
+    // newline, and matches don't span lines. options may have:
+    //  caseSensitive - default false; only ASCII letters are case-folded
+    //  wholeWord - default false; matches must not have a letter, digit or
+    //      '_' right before or after them
+    //  regex - default false; query is a JS regular expression, without
+    //      backreferences or lookaround, see brackets_regex.h
+    //  include - array of globs, only matching files are searched. Globs
+    //      with a '/' match the path below the directory, others the name.
+    //  maxMatches - stop after this many matches (default 10000)
+    //  index - path of an index written by BuildSearchIndexAsync. Files it
+    //      shows can't match, or are binary, are not read; files changed
+    //      since it was built are searched as usual. A missing or damaged
+    //      index is ignored.
+    //  ignore, gitignore, maxDepth - which files to visit, as in
+    //      WalkTreeAsync
+    //
+    // progress(results, searched, total) is called with batches of results,
+    // each { path, matches }, and the number of files searched so far out
+    // of total. Each match is { line, ch, length, preview, previewCh }:
+    // line and ch count from 0, ch and length in UTF-16 code units, and
+    // preview is the text of the line, cut around the match when it is
+    // long, with the match at previewCh.
+    //
+    // callback(err, summary) comes after the last batch, with summary
+    // { files, matchedFiles, matches, binary, unreadable, ruledOut,
+    // limitReached }. Files that have matches but are not UTF-8 count as
+    // binary. ruledOut is the number of files the index answered for, which
+    // are counted in files but not in the progress totals.
+    //
+    // Error (from GetLastError, right after the call):
+    //  NO_ERROR - the search has started
+    //  ERR_INVALID_PARAMS - invalid parameters or a regex that is invalid or
+    //      not supported, callback will not be called
+    functions.Add("SearchFilesAsync", ExecuteSearchFilesAsync);
+
+    // BuildSearchIndexAsync(root, indexPath, options, progress, callback[, timeout])
+    //
+    // Writes a trigram index of the files under the directory root to
+    // indexPath, for the index option of SearchFilesAsync. If indexPath
+    // already has an index of root, only the files whose size or
+    // modification time changed since are read again. The index is mapped
+    // when a search uses it, so it is ready as soon as the project opens.
+    // options may have:
+    //  maxFileSize - larger files are listed but not indexed, and always
+    //      searched (default 1 MB)
+    //  ignore, gitignore, maxDepth - which files to index, as in
+    //      WalkTreeAsync
+    //
+    // progress(done, total) is called now and then with the number of files
+    // indexed so far.
+    //
+    // callback(err, summary) comes at the end, with summary
+    // { files, read, reused, skipped, trigrams, size }: read files were read
+    // and reused ones taken from the previous index; skipped ones were too
+    // large or could not be read. size is the size of the index in bytes.
+    // On Windows the index can't be replaced while a search is reading it,
+    // and the callback gets ERR_CANT_WRITE.
+    //
+    // Error (from GetLastError, right after the call):
+    //  NO_ERROR - the build has started
+    //  ERR_INVALID_PARAMS - invalid parameters, callback will not be called
+    functions.Add("BuildSearchIndexAsync", ExecuteBuildSearchIndexAsync);
+
+    // CancelRequest(id)
+    //
+    // Inputs:
+    //  id - request id returned by one of the Async functions
+    //
+    // Output:
+    //  true if the request was still pending. Its callback has been called
+    //  with ERR_CANCELLED.
+    //
+    // Error:
+    //  NO_ERROR
+    //  ERR_INVALID_PARAMS - invalid parameters
+    functions.Add("CancelRequest", ExecuteCancelRequest);
+
+    // OpenFileStream(path)
+    //
+    // Opens a file for reading a range at a time, for files too large for
+    // ReadFile. The stream stays open until CloseFileStream or until the
+    // page is unloaded.
+    //
+    // Output:
+    //  handle of the stream
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_NOT_FOUND - file does not exist
+    //  ERR_CANT_READ - file could not be opened, or is a directory
+    functions.Add("OpenFileStream", ExecuteOpenFileStream);
+
+    // CloseFileStream(handle)
+    //
+    // Output:
+    //  true if the stream was open
+    functions.Add("CloseFileStream", ExecuteCloseFileStream);
+
+    // ReadFileStreamAsync(handle, offset, maxBytes, wholeLines, callback[, timeout])
+    // ReadFileStreamLinesAsync(handle, firstLine, lineCount, maxBytes, callback[, timeout])
+    // ReadFileStreamTailAsync(handle, maxBytes, callback[, timeout])
+    //
+    // Read up to maxBytes (4 bytes to 64 MB) of an open stream: at a byte
+    // offset, starting with a line, or at the end of the file. Like the other
+    // Async functions they return a request id. The result is an object:
+    //  data - the text read. It never splits a UTF-8 character, and with
+    //         wholeLines or when reading lines it ends on a line break unless
+    //         it reaches the end of the file.
+    //  start, end - byte offsets of data in the file. Reading again from end
+    //         continues where this chunk stopped, and follows a growing file.
+    //  size - size of the file when it was read
+    //  eof - true if data reaches the end of the file
+    //  firstLine - line number of data, when it is known
+    //  lineCount - number of lines in data, for ReadFileStreamLinesAsync
+    //
+    // Error (passed to callback):
+    //  NO_ERROR - no error
+    //  ERR_CANT_READ - the stream was closed or could not be read
+    //  ERR_UNSUPPORTED_ENCODING - the range is not UTF-8 text
+    functions.Add("ReadFileStreamAsync", ExecuteReadFileStreamAsync);
+    functions.Add("ReadFileStreamLinesAsync", ExecuteReadFileStreamLinesAsync);
+    functions.Add("ReadFileStreamTailAsync", ExecuteReadFileStreamTailAsync);
+
+    // WatchPath(path, callback[, latency[, polling]])
+    //
+    // Watches the directory path and everything below it, and calls
+    // callback(changes, polling) with batches of changes until UnwatchPath
+    // or until the page is unloaded. changes is an array of {path, kind},
+    // kind being one of the CHANGE_* values in brackets_extensions.js.
+    // Changes are gathered for latency milliseconds (0 to 60000, default
+    // 100) after the first one. polling is true when the system's change
+    // notifications can't be used and the tree is scanned instead; pass
+    // polling true to scan from the start, for file systems whose
+    // notifications miss changes made elsewhere, such as network shares.
+    //
+    // Output:
+    //  handle of the watcher
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_NOT_FOUND - directory does not exist
+    //  ERR_NOT_DIRECTORY - path is not a directory
+    functions.Add("WatchPath", ExecuteWatchPath);
+
+    // UnwatchPath(handle)
+    //
+    // Output:
+    //  true if the watcher was running
+    functions.Add("UnwatchPath", ExecuteUnwatchPath);
+
+    // SetStatCacheRoot(path)
+    //
+    // Caches what IsDirectory, GetFileInfo, GetFileModificationTime, ReadDir
+    // and ReadDirWithStats return for paths under path, normally the project
+    // root, and keeps the cache in step with the disk through native change
+    // notifications. Replaces the previous root; an empty path turns the
+    // cache off. See StatCache.
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_NOT_FOUND - directory could not be found
+    //  ERR_NOT_DIRECTORY - path is not a directory
+    functions.Add("SetStatCacheRoot", ExecuteSetStatCacheRoot);
+
+    // GetStatCacheStats()
+    //
+    // Output:
+    //  { hits, misses, bypassed, invalidations, entries, active }: lookup
+    //  counts since the process started, how many changes dropped entries,
+    //  how many entries are cached now and whether the cache is in use.
+    functions.Add("GetStatCacheStats", ExecuteGetStatCacheStats);
+
+    // SetContentCacheBudget(bytes)
+    //
+    // Sets how much memory the cache of file contents that ReadFile,
+    // ReadFileAsync and DiffFileAsync share may use (64 MB by default),
+    // evicting the files read longest ago until it fits. 0 turns the cache
+    // off. See ContentCache.
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    functions.Add("SetContentCacheBudget", ExecuteSetContentCacheBudget);
+
+    // GetContentCacheStats()
+    //
+    // Output:
+    //  { hits, misses, hitRatio, stale, evictions, bytes, budget, entries }:
+    //  reads answered from memory and from the disk since the process
+    //  started, the share of them from memory, entries dropped because the
+    //  file had changed and to stay within the budget, and how many bytes
+    //  and files are cached now.
+    functions.Add("GetContentCacheStats", ExecuteGetContentCacheStats);
+
+    // OpenEditJournal(path[, commitDelay])
+    //
+    // Starts a journal of unsaved edits at path, replacing any file there
+    // and closing the journal open before. Records are written and synced
+    // together, commitDelay milliseconds (50 by default) after the first
+    // one since the last write. See EditJournal.
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_CANT_WRITE - journal could not be created
+    functions.Add("OpenEditJournal", ExecuteOpenEditJournal);
+
+    // CloseEditJournal([discard])
+    //
+    // Writes what is left and closes the journal. With discard, after every
+    // document was saved or closed, the file is deleted too.
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_CANT_WRITE - the last records could not be written
+    functions.Add("CloseEditJournal", ExecuteCloseEditJournal);
+
+    // JournalSnapshot(document, text)
+    // JournalBase(document, digest)
+    // JournalEdit(document, offset, removed, text)
+    // JournalClean(document)
+    //
+    // Record the text of the document at path document, that its text is
+    // that of the file whose xxh3 digest (see HashFileAsync) is digest, an
+    // edit replacing removed UTF-16 code units from offset with text, and
+    // that it has no unsaved changes. The records are buffered and written
+    // by a background flush.
+    //
+    // Output:
+    //  JournalEdit: bytes recorded for the document since its last snapshot
+    //  or base
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_CANT_WRITE - no journal is open, or the last write failed
+    functions.Add("JournalSnapshot", ExecuteJournalSnapshot);
+    functions.Add("JournalBase", ExecuteJournalBase);
+    functions.Add("JournalEdit", ExecuteJournalEdit);
+    functions.Add("JournalClean", ExecuteJournalClean);
+
+    // FlushEditJournalAsync(callback[, timeout])
+    //
+    // Calls callback(error) once every record made so far is on disk.
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_CANT_WRITE - records could not be written
+    functions.Add("FlushEditJournalAsync", ExecuteFlushEditJournalAsync);
+
+    // ReplayEditJournalAsync(path, callback[, timeout])
+    //
+    // Replays the journal at path, normally one left by a session that
+    // crashed, and calls callback(error, result).
+    //
+    // Output:
+    //  { documents: [{ path, text, edits, damaged }], truncated }: the
+    //  documents with unsaved changes, in the order they were first
+    //  recorded, with their text, or null if it could not be rebuilt, and
+    //  whether the journal ended in a record cut short.
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    //  ERR_NOT_FOUND - file could not be found
+    //  ERR_CANT_READ - file could not be read or is not a journal
+    functions.Add("ReplayEditJournalAsync", ExecuteReplayEditJournalAsync);
+
+    // GetEditJournalStats()
+    //
+    // Output:
+    //  { records, bytes, flushes, recordsPerFlush, time, pending }: records
+    //  made since the journal was opened and their size, how many writes
+    //  carried them, the milliseconds those took, and the bytes waiting for
+    //  the next one.
+    functions.Add("GetEditJournalStats", ExecuteGetEditJournalStats);
+
+    // CreatePathMatcher(paths)
+    // CreatePathMatcher(store, id)
+    //
+    // Keeps the array of strings paths, normally every file of the
+    // project, for MatchPaths to score against what is typed in Quick Open.
+    // The second form takes the files below id in the path store store
+    // instead. The matcher lasts until ClosePathMatcher or until the page
+    // is unloaded. See PathMatcher.
+    //
+    // Output:
+    //  handle of the matcher
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or store
+    //  ERR_NOT_FOUND - id is not in the store
+    functions.Add("CreatePathMatcher", ExecuteCreatePathMatcher);
+
+    // UpdatePathMatcher(handle, added, removed)
+    //
+    // Adds the array of paths added and removes the array removed, as files
+    // are created and deleted.
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or handle
+    functions.Add("UpdatePathMatcher", ExecuteUpdatePathMatcher);
+
+    // RecordPathOpened(handle, path[, time])
+    //
+    // Notes that path was opened, at time in milliseconds since the epoch
+    // or now, so that it ranks higher the more recently and often it is
+    // opened. Pass times to replay opens remembered from earlier sessions.
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or handle
+    functions.Add("RecordPathOpened", ExecuteRecordPathOpened);
+
+    // MatchPaths(handle, query, maxResults)
+    //
+    // Finds the paths that have the characters of query in order, ignoring
+    // ASCII case, and returns the best maxResults (1 to 10000) of them,
+    // best first. Typing more of the same query, or deleting from its end,
+    // only looks at paths that could still match.
+    //
+    // Output:
+    //  array of { path, score, matches }, matches being the UTF-16 offsets
+    //  of the matched characters in path, for highlighting. An empty query
+    //  returns the paths that were opened, with no matches.
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or handle, or a query longer
+    //      than 256 bytes
+    functions.Add("MatchPaths", ExecuteMatchPaths);
+
+    // ClosePathMatcher(handle)
+    //
+    // Output:
+    //  true if the matcher was open
+    functions.Add("ClosePathMatcher", ExecuteClosePathMatcher);
+
+    // CreatePathStore()
+    //
+    // Makes an empty path store, which holds the paths of a project tree
+    // as a trie of path segments and gives each path an integer id. The
+    // store lasts until ClosePathStore or until the page is unloaded. See
+    // PathStore.
+    //
+    // Output:
+    //  handle of the store
+    functions.Add("CreatePathStore", ExecuteCreatePathStore);
+
+    // AddStorePaths(handle, paths)
+    //
+    // Adds the array of paths, and the directories above them. A trailing
+    // '/' marks a directory.
+    //
+    // Output:
+    //  array of the ids of paths, -1 for empty strings
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or handle
+    functions.Add("AddStorePaths", ExecuteAddStorePaths);
+
+    // RemoveStorePaths(handle, ids)
+    //
+    // Removes the paths of the array ids and everything below them. Ids
+    // are not reused.
+    //
+    // Output:
+    //  number of paths removed
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or handle
+    functions.Add("RemoveStorePaths", ExecuteRemoveStorePaths);
+
+    // FindStorePaths(handle, paths)
+    //
+    // Output:
+    //  array of the ids of paths, -1 for those that are not in the store
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or handle
+    functions.Add("FindStorePaths", ExecuteFindStorePaths);
+
+    // GetStorePaths(handle, ids)
+    //
+    // Output:
+    //  array of the paths of ids, directories ending with '/', and '' for
+    //  ids that are not in the store
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or handle
+    functions.Add("GetStorePaths", ExecuteGetStorePaths);
+
+    // ListStoreChildren(handle, id)
+    //
+    // Output:
+    //  { ids, names } of the paths right below id, in no particular order,
+    //  the names of directories ending with '/'. Id 0 is the root above
+    //  every path.
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or handle
+    //  ERR_NOT_FOUND - id is not in the store
+    functions.Add("ListStoreChildren", ExecuteListStoreChildren);
+
+    // ListStoreFiles(handle, id)
+    //
+    // Output:
+    //  array of the ids of the files anywhere below id
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or handle
+    //  ERR_NOT_FOUND - id is not in the store
+    functions.Add("ListStoreFiles", ExecuteListStoreFiles);
+
+    // GetPathStoreStats(handle)
+    //
+    // Output:
+    //  { paths, names, bytes }: paths in the store, distinct segment names
+    //  and the memory the store holds
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or handle
+    functions.Add("GetPathStoreStats", ExecuteGetPathStoreStats);
+
+    // LoadPathStoreAsync(handle, path, options, progress, callback)
+    //
+    // Walks the directory path on the worker threads, with the ignore,
+    // gitignore and maxDepth options of WalkTreeAsync, and adds everything
+    // it finds to the store. The store can be read while it fills;
+    // progress(paths) is called with the number of paths added so far.
+    //
+    // Output (to callback):
+    //  { id, files, directories }: the id of path, and what was added
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or handle
+    //  ERR_NOT_FOUND - directory could not be found
+    //  ERR_NOT_DIRECTORY - path is not a directory
+    //  ERR_CANCELLED - the page was unloaded
+    functions.Add("LoadPathStoreAsync", ExecuteLoadPathStoreAsync);
+
+    // ClosePathStore(handle)
+    //
+    // Output:
+    //  true if the store was open
+    functions.Add("ClosePathStore", ExecuteClosePathStore);
+
+    // SyncProjectSnapshotAsync(handle, path, snapshotPath, options, progress, callback)
+    //
+    // Fills the PathStore handle with the tree under path the way
+    // LoadPathStoreAsync does, starting from the snapshot at snapshotPath
+    // that an earlier call left: its paths are added first and progress is
+    // called once they are in. The tree is then walked, taking the entries
+    // of directories that haven't changed since from the snapshot, and
+    // progress is called with what was added and removed. The snapshot is
+    // written again if anything changed. Options are those of
+    // WalkTreeAsync, without stats. See ProjectSnapshot.
+    //
+    // progress(paths, added, removed):
+    //  paths - number of paths in the store below path so far
+    //  added, removed - arrays of the ids added and removed since the last
+    //  call, null when there was no snapshot to start from
+    //
+    // Output:
+    //  { id, files, directories, snapshot, reused, listed, added, removed,
+    //  hash, written, size }: the id of path, what the tree holds, whether
+    //  there was a snapshot, the directories taken from it and the ones
+    //  read, the number of paths added and removed, a hash of the tree as a
+    //  hex string, whether the snapshot was written and its size
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or handle
+    //  ERR_NOT_FOUND - path does not exist
+    //  ERR_NOT_DIRECTORY - path is not a directory
+    //  ERR_CANT_WRITE - the snapshot could not be written
+    functions.Add("SyncProjectSnapshotAsync", ExecuteSyncProjectSnapshotAsync);
+
+    // InternPaths(paths)
+    //
+    // Converts the array of strings paths once and returns a handle for
+    // each, the same one every time a page interns the same path. ReadDir,
+    // ReadDirWithStats, IsDirectory, GetFileInfo, ReadFile, WriteFile,
+    // SetPosixPermissions, GetFileModificationTime, DeleteFileOrDirectory,
+    // their Async versions, WriteFilesAsync and StatPaths take a handle
+    // wherever they take a path, which saves converting the path on every
+    // call. Handles last until ReleasePathHandles or until the page is
+    // unloaded. See PathHandleRegistry.
+    //
+    // Output:
+    //  array of handles
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or an empty path
+    functions.Add("InternPaths", ExecuteInternPaths);
+
+    // ReleasePathHandles(handles)
+    //
+    // Output:
+    //  number of handles that were interned
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters
+    functions.Add("ReleasePathHandles", ExecuteReleasePathHandles);
+
+    // StatPaths(paths[, bypassCache])
+    //
+    // GetFileInfo for every path or handle in the array paths, in one call.
+    // Goes through the StatCache like GetFileInfo; when the cache is not in
+    // use, or with bypassCache, entries of the same directory are stat'ed
+    // together.
+    //
+    // Output:
+    //  array with { isDirectory, size, mtime, mtimeNsec } for each path,
+    //  or the error number for paths that could not be stat'ed
+    //
+    // Error:
+    //  NO_ERROR - no error
+    //  ERR_INVALID_PARAMS - invalid parameters or a released handle
+    functions.Add("StatPaths", ExecuteStatPaths);
+
+    return functions;
+}
+
+NativeFunctionTable<FileSystemFunction> s_functions = CreateFunctionTable();
+
+} // namespace
+
+int Execute(const CefString& name,
+            const CefV8ValueList& arguments,
+            CefRefPtr<CefV8Value>& retval,
+            CefString& exception)
+{
+    FileSystemFunction function = s_functions.Find(name);
+    if (!function)
+        return -1;
+
+    return function(arguments, retval, exception);
+}
+
+int ExecuteReadDir(const CefV8ValueList& arguments,
+                   CefRefPtr<CefV8Value>& retval,
+                   CefString& exception)
+{
+    bool bypassCache = false;
+    if (!GetPathArguments(arguments, bypassCache))
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+    std::vector<ExtensionString> contents;
+
+    int error = StatCache::GetInstance().ReadDir(pathStr, contents, bypassCache);
+    if (error != NO_ERROR)
+        return error;
+
+    retval = StringListToV8Array(contents);
+    return NO_ERROR;
+}
+
+int ExecuteReadDirWithStats(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception)
+{
+    bool bypassCache = false;
+    if (!GetPathArguments(arguments, bypassCache))
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+    std::vector<DirEntry> entries;
+
+    int error = StatCache::GetInstance().ReadDirWithStats(pathStr, entries, bypassCache);
+    if (error != NO_ERROR)
+        return error;
+
+    retval = DirEntriesToV8Array(entries);
+    return NO_ERROR;
+}
+
+int ExecuteIsDirectory(const CefV8ValueList& arguments,
+                       CefRefPtr<CefV8Value>& retval,
+                       CefString& exception)
+{
+    bool bypassCache = false;
+    if (!GetPathArguments(arguments, bypassCache))
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+    FileInfo info;
+
+    int error = StatCache::GetInstance().GetFileInfo(pathStr, info, bypassCache);
+    if (error != NO_ERROR)
+        return error;
+
+    retval = CefV8Value::CreateBool(info.isDirectory);
+    return NO_ERROR;
+}
+
+int ExecuteGetFileInfo(const CefV8ValueList& arguments,
+                       CefRefPtr<CefV8Value>& retval,
+                       CefString& exception)
+{
+    bool bypassCache = false;
+    if (!GetPathArguments(arguments, bypassCache))
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+    FileInfo info;
+
+    int error = StatCache::GetInstance().GetFileInfo(pathStr, info, bypassCache);
+    if (error != NO_ERROR)
+        return error;
+
+    retval = CefV8Value::CreateObject(NULL);
+    SetFileInfoValues(retval, info);
+    return NO_ERROR;
+}
+
+// The result of ReadFile: the text alone, as ever, for 'utf8' without the
+// layout, otherwise an object with the text as data, the encoding the file
+// was found in and the layout if it was asked for
+CefRefPtr<CefV8Value> ReadFileToResult(std::string& contents, const ExtensionString& encoding,
+                                       const TextLayout* layout, TextEncoding detected)
+{
+    TextEncoding requested;
+    if (!layout && ParseEncoding(encoding, requested) && requested == ENCODING_UTF8)
+        return FileContentsToResult(contents);
+
+    CefRefPtr<CefV8Value> result;
+    if (layout) {
+        result = TextLayoutToResult(contents, *layout);
+    } else {
+        result = CefV8Value::CreateObject(NULL);
+        result->SetValue("data", FileContentsToResult(contents), V8_PROPERTY_ATTRIBUTE_NONE);
+    }
+    result->SetValue("encoding", CefV8Value::CreateString(GetEncodingName(detected)), V8_PROPERTY_ATTRIBUTE_NONE);
+    return result;
+}
+
+int ExecuteReadFile(const CefV8ValueList& arguments,
+                    CefRefPtr<CefV8Value>& retval,
+                    CefString& exception)
+{
+    if (arguments.size() < 2 || arguments.size() > 3 ||
+        !IsPathValue(arguments[0]) || !arguments[1]->IsString() ||
+        (arguments.size() == 3 && !arguments[2]->IsBool()))
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+    ExtensionString encodingStr = arguments[1]->GetStringValue();
+    bool withLayout = arguments.size() == 3 && arguments[2]->GetBoolValue();
+    std::string contents;
+    TextLayout layout;
+    TextEncoding detected = ENCODING_UTF8;
+
+    int error = ContentCache::GetInstance().ReadFile(pathStr, encodingStr, contents, withLayout ? &layout : NULL,
+                                                     &detected);
+    if (error != NO_ERROR)
+        return error;
+
+    retval = ReadFileToResult(contents, encodingStr, withLayout ? &layout : NULL, detected);
+    return NO_ERROR;
+}
+
+int ExecuteWriteFile(const CefV8ValueList& arguments,
+                     CefRefPtr<CefV8Value>& retval,
+                     CefString& exception)
+{
+    Durability durability = DURABILITY_DATA;
+    if (arguments.size() < 3 || arguments.size() > 4 ||
+        !IsPathValue(arguments[0]) || !arguments[1]->IsString() || !arguments[2]->IsString() ||
+        (arguments.size() == 4 && !GetDurabilityArgument(arguments[3], durability)))
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+    ExtensionString encodingStr = arguments[2]->GetStringValue();
+    std::string contentsStr;
+    GetUTF8StringValue(arguments[1], contentsStr);
+
+    int error = WriteFile(pathStr, contentsStr, encodingStr, durability);
+    StatCache::GetInstance().PathChanged(pathStr, CHANGE_CREATED);
+    ContentCache::GetInstance().PathChanged(pathStr);
+    return error;
+}
+
+int ExecuteSetPosixPermissions(const CefV8ValueList& arguments,
+                               CefRefPtr<CefV8Value>& retval,
+                               CefString& exception)
+{
+    if (arguments.size() != 2 || !IsPathValue(arguments[0]) || !arguments[1]->IsInt())
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+    int mode = arguments[1]->GetIntValue();
+
+    return SetPosixPermissions(pathStr, mode);
+}
+
+int ExecuteGetFileModificationTime(const CefV8ValueList& arguments,
+                                   CefRefPtr<CefV8Value>& retval,
+                                   CefString& exception)
+{
+    bool bypassCache = false;
+    if (!GetPathArguments(arguments, bypassCache))
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+    FileInfo info;
+
+    int error = StatCache::GetInstance().GetFileInfo(pathStr, info, bypassCache);
+    if (error != NO_ERROR)
+        return error;
+
+    retval = CefV8Value::CreateDate(CefTime(info.mtimeSec + info.mtimeNsec / 1e9));
+    return NO_ERROR;
+}
+
+int ExecuteDeleteFileOrDirectory(const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefString& exception)
+{
+    if (arguments.size() != 1 || !IsPathValue(arguments[0]))
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+
+    int error = DeleteFileOrDirectory(pathStr);
+    StatCache::GetInstance().PathChanged(pathStr, CHANGE_DELETED);
+    ContentCache::GetInstance().PathChanged(pathStr);
+    return error;
+}
+
+namespace {
+
+class ReadDirOperation : public AsyncOperation
+{
+public:
+    ReadDirOperation(const ExtensionString& path, bool bypassCache) : m_path(path), m_bypassCache(bypassCache) {}
+
+protected:
+    virtual int Run() { return StatCache::GetInstance().ReadDir(m_path, m_contents, m_bypassCache); }
+    virtual CefRefPtr<CefV8Value> GetResult() { return StringListToV8Array(m_contents); }
+
+private:
+    ExtensionString m_path;
+    bool m_bypassCache;
+    std::vector<ExtensionString> m_contents;
+};
+
+class ReadDirWithStatsOperation : public AsyncOperation
+{
+public:
+    ReadDirWithStatsOperation(const ExtensionString& path, bool bypassCache)
+        : m_path(path), m_bypassCache(bypassCache) {}
+
+protected:
+    virtual int Run() { return StatCache::GetInstance().ReadDirWithStats(m_path, m_entries, m_bypassCache); }
+    virtual CefRefPtr<CefV8Value> GetResult() { return DirEntriesToV8Array(m_entries); }
+
+private:
+    ExtensionString m_path;
+    bool m_bypassCache;
+    std::vector<DirEntry> m_entries;
+};
+
+class ReadFileOperation : public AsyncOperation
+{
+public:
+    ReadFileOperation(const ExtensionString& path, const ExtensionString& encoding, bool withLayout)
+        : m_path(path), m_encoding(encoding), m_withLayout(withLayout), m_detected(ENCODING_UTF8) {}
+
+protected:
+    virtual int Run()
+    {
+        return ContentCache::GetInstance().ReadFile(m_path, m_encoding, m_contents, m_withLayout ? &m_layout : NULL,
+                                                    &m_detected);
+    }
+    virtual CefRefPtr<CefV8Value> GetResult()
+    {
+        return ReadFileToResult(m_contents, m_encoding, m_withLayout ? &m_layout : NULL, m_detected);
+    }
+
+private:
+    ExtensionString m_path;
+    ExtensionString m_encoding;
+    bool m_withLayout;
+    std::string m_contents;
+    TextLayout m_layout;
+    TextEncoding m_detected;
+};
+
+class WriteFileOperation : public AsyncOperation
+{
+public:
+    // Takes over |contents|, which is left empty
+    WriteFileOperation(const ExtensionString& path, std::string& contents, const ExtensionString& encoding,
+                       Durability durability)
+        : m_path(path), m_encoding(encoding), m_durability(durability)
+    {
+        m_contents.swap(contents);
+    }
+
+protected:
+    virtual int Run()
+    {
+        int error = WriteFile(m_path, m_contents, m_encoding, m_durability);
+        StatCache::GetInstance().PathChanged(m_path, CHANGE_CREATED);
+        ContentCache::GetInstance().PathChanged(m_path);
+        return error;
+    }
+
+private:
+    ExtensionString m_path;
+    std::string m_contents;
+    ExtensionString m_encoding;
+    Durability m_durability;
+};
+
+// Saves a batch of files with one round of flushes for the whole batch.
+// Every file is written to its temporary copy and flushed in parallel; only
+// when all the data is on disk are the copies renamed into place. Each file
+// gets its own error code, and a file that fails leaves its original alone.
+class WriteFilesOperation : public AsyncOperation, public ParallelWork
+{
+public:
+    WriteFilesOperation(const ExtensionString& encoding, Durability durability)
+        : m_encoding(encoding), m_durability(durability) {}
+
+    // Takes over |contents|, which is left empty
+    void AddFile(const ExtensionString& path, std::string& contents)
+    {
+        m_paths.push_back(path);
+        m_contents.push_back(std::string());
+        m_contents.back().swap(contents);
+    }
+
+    virtual CefRefPtr<CefV8Value> GetResult()
+    {
+        CefRefPtr<CefV8Value> result = CefV8Value::CreateArray();
+        for (size_t i = 0; i < m_errors.size(); i++)
+            result->SetValue((int)i, CefV8Value::CreateInt(m_errors[i]));
+        return result;
+    }
+
+protected:
+    virtual int Run()
+    {
+        m_writes.resize(m_paths.size());
+        m_errors.assign(m_paths.size(), NO_ERROR);
+
+        // Flushes are mostly waiting on the disk, so they overlap well
+        ParallelFor(*this, m_paths.size(), kMaxWriteThreads);
+
+        std::set<ExtensionString> directories;
+        for (size_t i = 0; i < m_writes.size(); i++) {
+            if (m_errors[i] == NO_ERROR && IsCancelled())
+                m_errors[i] = ERR_CANCELLED;
+            if (m_errors[i] == NO_ERROR) {
+                m_errors[i] = CommitWrite(m_writes[i], m_durability);
+                StatCache::GetInstance().PathChanged(m_paths[i], CHANGE_CREATED);
+                ContentCache::GetInstance().PathChanged(m_paths[i]);
+            }
+
+            if (m_errors[i] == NO_ERROR)
+                directories.insert(m_writes[i].directory);
+            else
+                AbortWrite(m_writes[i]);
+        }
+
+        if (m_durability == DURABILITY_FULL) {
+            for (std::set<ExtensionString>::const_iterator it = directories.begin(); it != directories.end(); ++it)
+                SyncDirectory(*it);
+        }
+
+        // The contents are no longer needed while the result waits for the
+        // UI thread
+        std::vector<std::string>().swap(m_contents);
+        return NO_ERROR;
+    }
+
+    virtual void RunItem(size_t index)
+    {
+        if (IsCancelled()) {
+            m_errors[index] = ERR_CANCELLED;
+            return;
+        }
+
+        PendingWrite& write = m_writes[index];
+        int error = BeginWrite(m_paths[index], m_contents[index], m_encoding, write);
+        if (error == NO_ERROR)
+            error = SyncWrite(write, m_durability);
+        m_errors[index] = error;
+    }
+
+private:
+    static const int kMaxWriteThreads = 8;
+
+    std::vector<ExtensionString> m_paths;
+    std::vector<std::string> m_contents;
+    ExtensionString m_encoding;
+    Durability m_durability;
+    std::vector<PendingWrite> m_writes;
+    std::vector<int> m_errors;
+};
+
+} // namespace
+
+int ExecuteReadDirAsync(const CefV8ValueList& arguments,
+                        CefRefPtr<CefV8Value>& retval,
+                        CefString& exception)
+{
+    bool bypassCache = false;
+    size_t callbackIndex;
+    if (!GetAsyncPathArguments(arguments, bypassCache, callbackIndex))
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+
+    CefRefPtr<AsyncOperation> operation = new ReadDirOperation(pathStr, bypassCache);
+    return operation->Start(arguments, callbackIndex, retval);
+}
+
+int ExecuteReadDirWithStatsAsync(const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefString& exception)
+{
+    bool bypassCache = false;
+    size_t callbackIndex;
+    if (!GetAsyncPathArguments(arguments, bypassCache, callbackIndex))
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+
+    CefRefPtr<AsyncOperation> operation = new ReadDirWithStatsOperation(pathStr, bypassCache);
+    return operation->Start(arguments, callbackIndex, retval);
+}
+
+int ExecuteReadFileAsync(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+{
+    if (arguments.size() < 3 || !IsPathValue(arguments[0]) || !arguments[1]->IsString())
+        return ERR_INVALID_PARAMS;
+
+    // withLayout is optional and comes before the callback
+    bool withLayout = false;
+    size_t callbackIndex = 2;
+    if (!arguments[2]->IsFunction()) {
+        if (!arguments[2]->IsBool())
+            return ERR_INVALID_PARAMS;
+        withLayout = arguments[2]->GetBoolValue();
+        callbackIndex = 3;
+    }
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+    ExtensionString encodingStr = arguments[1]->GetStringValue();
+
+    CefRefPtr<AsyncOperation> operation = new ReadFileOperation(pathStr, encodingStr, withLayout);
+    return operation->Start(arguments, callbackIndex, retval);
+}
+
+int ExecuteWriteFileAsync(const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception)
+{
+    if (arguments.size() < 4 || !IsPathValue(arguments[0]) || !arguments[1]->IsString() || !arguments[2]->IsString())
+        return ERR_INVALID_PARAMS;
+
+    // The durability is optional and comes before the callback
+    Durability durability = DURABILITY_DATA;
+    size_t callbackIndex = 3;
+    if (!arguments[3]->IsFunction()) {
+        if (!GetDurabilityArgument(arguments[3], durability))
+            return ERR_INVALID_PARAMS;
+        callbackIndex = 4;
+    }
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+    const ExtensionString& pathStr = *path;
+    ExtensionString encodingStr = arguments[2]->GetStringValue();
+    std::string contentsStr;
+    GetUTF8StringValue(arguments[1], contentsStr);
+
+    CefRefPtr<AsyncOperation> operation = new WriteFileOperation(pathStr, contentsStr, encodingStr, durability);
+    return operation->Start(arguments, callbackIndex, retval);
+}
+
+int ExecuteWriteFilesAsync(const CefV8ValueList& arguments,
+                           CefRefPtr<CefV8Value>& retval,
+                           CefString& exception)
+{
+    if (arguments.size() < 4 || !arguments[0]->IsArray() || !arguments[1]->IsArray() || !arguments[2]->IsString())
+        return ERR_INVALID_PARAMS;
+
+    // The durability is optional and comes before the callback
+    Durability durability = DURABILITY_DATA;
+    size_t callbackIndex = 3;
+    if (!arguments[3]->IsFunction()) {
+        if (!GetDurabilityArgument(arguments[3], durability))
+            return ERR_INVALID_PARAMS;
+        callbackIndex = 4;
+    }
+
+    CefRefPtr<CefV8Value> paths = arguments[0];
+    CefRefPtr<CefV8Value> contents = arguments[1];
+    int count = paths->GetArrayLength();
+    if (contents->GetArrayLength() != count)
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<WriteFilesOperation> operation =
+        new WriteFilesOperation(arguments[2]->GetStringValue(), durability);
+    for (int i = 0; i < count; i++) {
+        CefRefPtr<CefV8Value> path = paths->GetValue(i);
+        CefRefPtr<CefV8Value> data = contents->GetValue(i);
+        ExtensionString storage;
+        const ExtensionString* pathStr = path.get() ? GetPathValue(path, storage) : NULL;
+        if (!pathStr || !data.get() || !data->IsString())
+            return ERR_INVALID_PARAMS;
+
+        std::string contentsStr;
+        GetUTF8StringValue(data, contentsStr);
+        operation->AddFile(*pathStr, contentsStr);
+    }
+
+    return operation->Start(arguments, callbackIndex, retval);
+}
+
+} // namespace FileSystem
+} // namespace Brackets
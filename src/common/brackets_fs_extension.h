@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_FS_EXTENSION_H
+#define _BRACKETS_FS_EXTENSION_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+
+/**
+ * V8 bindings for the file system functions in brackets_fs.h. These are shared
+ * by the Windows and Mac BracketsExtensionHandler and by the headless host, so
+ * argument checking and result marshalling is the same everywhere.
+ */
+namespace Brackets {
+namespace FileSystem {
+
+// Runs the native file system function |name|. Returns the brackets error
+// code, or -1 if |name| is not a file system function.
+int Execute(const CefString& name,
+            const CefV8ValueList& arguments,
+            CefRefPtr<CefV8Value>& retval,
+            CefString& exception);
+
+// Results are built directly as V8 arrays and objects, so JS gets them
+// without a JSON.parse. Directory entries have a Date as their mtime, as in
+// GetFileInfo.
+CefRefPtr<CefV8Value> StringListToV8Array(const std::vector<ExtensionString>& list);
+CefRefPtr<CefV8Value> DirEntriesToV8Array(const std::vector<DirEntry>& entries);
+
+// Returns the UTF-8 |contents| of a file as a V8 string. CefString is UTF-16,
+// so the contents are converted first and |contents| is released before V8
+// copies the string; no more than two copies of the file are alive at once.
+CefRefPtr<CefV8Value> FileContentsToResult(std::string& contents);
+
+// Returns an object with |contents|, converted as by FileContentsToResult, as
+// its data and what |layout| found in it
+CefRefPtr<CefV8Value> TextLayoutToResult(std::string& contents, const TextLayout& layout);
+
+// Converts the string |value| to UTF-8 straight into |result|, which is
+// allocated once, instead of through the temporary buffers of CefString's
+// own conversion
+void GetUTF8StringValue(CefRefPtr<CefV8Value> value, std::string& result);
+
+// Converts |length| UTF-16 code units to UTF-8, the same way
+void UTF16ToUTF8(const unsigned short* units, size_t length, std::string& result);
+
+// Reads a path argument, which is either a string or a handle from
+// InternPaths. Returns the path, or NULL if |value| is neither or the handle
+// was released. A string is converted into |storage|; the path of a handle
+// is not copied and stays valid until the handle is released.
+const ExtensionString* GetPathValue(CefRefPtr<CefV8Value> value, ExtensionString& storage);
+
+// Reads a non-negative whole number, which may be larger than an int.
+// Returns false if |value| is anything else.
+bool GetNumberValue(CefRefPtr<CefV8Value> value, unsigned long long& result);
+
+// Sets isDirectory, size, mtime and mtimeNsec on |object|
+void SetFileInfoValues(CefRefPtr<CefV8Value> object, const FileInfo& info);
+
+int ExecuteReadDir(const CefV8ValueList& arguments,
+                   CefRefPtr<CefV8Value>& retval,
+                   CefString& exception);
+
+int ExecuteReadDirWithStats(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception);
+
+int ExecuteIsDirectory(const CefV8ValueList& arguments,
+                       CefRefPtr<CefV8Value>& retval,
+                       CefString& exception);
+
+int ExecuteGetFileInfo(const CefV8ValueList& arguments,
+                       CefRefPtr<CefV8Value>& retval,
+                       CefString& exception);
+
+int ExecuteReadFile(const CefV8ValueList& arguments,
+                    CefRefPtr<CefV8Value>& retval,
+                    CefString& exception);
+
+int ExecuteWriteFile(const CefV8ValueList& arguments,
+                     CefRefPtr<CefV8Value>& retval,
+                     CefString& exception);
+
+int ExecuteSetPosixPermissions(const CefV8ValueList& arguments,
+                               CefRefPtr<CefV8Value>& retval,
+                               CefString& exception);
+
+int ExecuteGetFileModificationTime(const CefV8ValueList& arguments,
+                                   CefRefPtr<CefV8Value>& retval,
+                                   CefString& exception);
+
+int ExecuteDeleteFileOrDirectory(const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefString& exception);
+
+// Asynchronous versions. They take a callback and an optional timeout after
+// the regular arguments, return a request id right away and do the file
+// system work on the WorkerPool. See AsyncOperation.
+int ExecuteReadDirAsync(const CefV8ValueList& arguments,
+                        CefRefPtr<CefV8Value>& retval,
+                        CefString& exception);
+
+int ExecuteReadDirWithStatsAsync(const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefString& exception);
+
+int ExecuteReadFileAsync(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception);
+
+int ExecuteWriteFileAsync(const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception);
+
+int ExecuteWriteFilesAsync(const CefV8ValueList& arguments,
+                           CefRefPtr<CefV8Value>& retval,
+                           CefString& exception);
+
+} // namespace FileSystem
+} // namespace Brackets
+
+#endif // _BRACKETS_FS_EXTENSION_H
@@ -0,0 +1,839 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_fs.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <algorithm>
+
+#if defined(OS_LINUX)
+#include <sys/syscall.h>
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+// ReadFile validates the file a chunk at a time, right after reading it
+const size_t kReadChunkSize = 1024 * 1024;
+
+// Symlinks followed before a save gives up with ELOOP, as the kernel does
+const int kMaxSymlinkHops = 40;
+
+// Closes a file descriptor when it goes out of scope
+class StFileDescriptor {
+public:
+    explicit StFileDescriptor(int fd) : m_fd(fd) {}
+    ~StFileDescriptor() {
+        if (m_fd >= 0)
+            close(m_fd);
+    }
+    int Get() const { return m_fd; }
+
+private:
+    int m_fd;
+};
+
+bool IsDotOrDotDot(const char* name)
+{
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+#if defined(OS_LINUX)
+
+// Layout of the records returned by getdents64(2). glibc does not export it.
+struct LinuxDirent64 {
+    ino64_t         d_ino;
+    off64_t         d_off;
+    unsigned short  d_reclen;
+    unsigned char   d_type;
+    char            d_name[1];
+};
+
+// Reads the names in the directory open at |fd| with getdents64 so a whole
+// batch of entries comes back per syscall. With |types|, the d_type of each
+// name is added to it.
+int ReadDirEntries(int fd, std::vector<ExtensionString>& contents, std::vector<unsigned char>* types = NULL)
+{
+    // The kernel pads each record to 8 bytes; the union aligns the first
+    union {
+        LinuxDirent64 first;
+        char bytes[32 * 1024];
+    } buffer;
+
+    for (;;) {
+        long bytesRead = syscall(SYS_getdents64, fd, buffer.bytes, sizeof(buffer.bytes));
+        if (bytesRead == 0)
+            return NO_ERROR;
+        if (bytesRead < 0) {
+            if (errno == EINTR)
+                continue;
+            return ConvertErrnoCode(errno);
+        }
+
+        for (long offset = 0; offset < bytesRead;) {
+            const LinuxDirent64* entry = (const LinuxDirent64*)(buffer.bytes + offset);
+            if (!IsDotOrDotDot(entry->d_name)) {
+                contents.push_back(entry->d_name);
+                if (types)
+                    types->push_back(entry->d_type);
+            }
+            offset += entry->d_reclen;
+        }
+    }
+}
+
+#endif // OS_LINUX
+
+void FillFileInfo(const struct stat& buffer, FileInfo& info)
+{
+    info.isDirectory = S_ISDIR(buffer.st_mode);
+    info.size = (unsigned long long)buffer.st_size;
+#if defined(OS_MACOSX)
+    info.mtimeSec = buffer.st_mtimespec.tv_sec;
+    info.mtimeNsec = buffer.st_mtimespec.tv_nsec;
+#else
+    info.mtimeSec = buffer.st_mtim.tv_sec;
+    info.mtimeNsec = buffer.st_mtim.tv_nsec;
+#endif
+}
+
+#if defined(OS_LINUX)
+
+// Stats |name| relative to the directory open at |dirFd|, so the kernel does
+// not walk the full path again for every entry. statx() is asked only for the
+// fields FileInfo needs and is allowed to skip syncing with remote servers.
+int StatAt(int dirFd, const char* name, int flags, FileInfo& info)
+{
+#if defined(STATX_MTIME)
+    struct statx extended;
+    if (statx(dirFd, name, flags | AT_STATX_DONT_SYNC,
+              STATX_TYPE | STATX_SIZE | STATX_MTIME, &extended) == 0) {
+        info.isDirectory = S_ISDIR(extended.stx_mode);
+        info.size = extended.stx_size;
+        info.mtimeSec = extended.stx_mtime.tv_sec;
+        info.mtimeNsec = extended.stx_mtime.tv_nsec;
+        return NO_ERROR;
+    }
+    if (errno != ENOSYS)
+        return ConvertErrnoCode(errno);
+#endif
+
+    struct stat buffer;
+    if (fstatat(dirFd, name, &buffer, flags) == -1)
+        return ConvertErrnoCode(errno);
+
+    FillFileInfo(buffer, info);
+    return NO_ERROR;
+}
+
+#endif // OS_LINUX
+
+int StatPath(const ExtensionString& path, struct stat& buffer)
+{
+#if defined(OS_LINUX)
+    if (fstatat(AT_FDCWD, path.c_str(), &buffer, 0) == -1)
+        return ConvertErrnoCode(errno);
+#else
+    if (stat(path.c_str(), &buffer) == -1)
+        return ConvertErrnoCode(errno);
+#endif
+
+    return NO_ERROR;
+}
+
+// Numbers the temporary files WriteFile creates
+int s_tempFileCounter = 0;
+
+// Reserves |length| bytes for |fd| so that a full disk is found before
+// anything is written and the file is laid out in one piece. Only running out
+// of space is an error; file systems that can't preallocate are fine.
+int PreallocateFile(int fd, size_t length)
+{
+    if (length == 0)
+        return NO_ERROR;
+
+#if defined(OS_LINUX)
+    // Unlike posix_fallocate, fallocate fails instead of writing zeros when
+    // the file system has no support for it
+    if (fallocate(fd, 0, 0, (off_t)length) == -1 && errno == ENOSPC)
+        return ERR_OUT_OF_SPACE;
+#elif defined(OS_MACOSX)
+    fstore_t store;
+    memset(&store, 0, sizeof(store));
+    store.fst_flags = F_ALLOCATECONTIG;
+    store.fst_posmode = F_PEOFPOSMODE;
+    store.fst_length = (off_t)length;
+    if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+        store.fst_flags = F_ALLOCATEALL;
+        if (fcntl(fd, F_PREALLOCATE, &store) == -1 && errno == ENOSPC)
+            return ERR_OUT_OF_SPACE;
+    }
+#endif
+
+    return NO_ERROR;
+}
+
+// Writes all of |contents| at the current position of |fd|
+// Follows |path| through any symlinks to the file they end at, which
+// doesn't have to exist: saving through a dangling link creates its target,
+// as writing to it from a shell would
+int ResolveSymlinks(const ExtensionString& path, ExtensionString& target)
+{
+    target = path;
+    for (int hops = 0; hops < kMaxSymlinkHops; hops++) {
+        struct stat buffer;
+        if (lstat(target.c_str(), &buffer) == -1 || !S_ISLNK(buffer.st_mode))
+            return NO_ERROR;
+
+        char link[PATH_MAX];
+        ssize_t length = readlink(target.c_str(), link, sizeof(link));
+        if (length == -1)
+            return ConvertErrnoCode(errno, false);
+        if (length == sizeof(link))
+            return ERR_CANT_WRITE;
+
+        // A relative link is relative to the directory it is in
+        ExtensionString next(link, length);
+        size_t slash = target.rfind('/');
+        if (next[0] != '/' && slash != ExtensionString::npos)
+            next = target.substr(0, slash + 1) + next;
+        target = next;
+    }
+    return ConvertErrnoCode(ELOOP, false);
+}
+
+int WriteContents(int fd, const std::string& contents)
+{
+    int error = PreallocateFile(fd, contents.size());
+    if (error != NO_ERROR)
+        return error;
+
+    size_t totalWritten = 0;
+    while (totalWritten < contents.size()) {
+        ssize_t bytesWritten = write(fd, contents.data() + totalWritten, contents.size() - totalWritten);
+        if (bytesWritten < 0) {
+            if (errno == EINTR)
+                continue;
+            return ConvertErrnoCode(errno, false);
+        }
+        totalWritten += bytesWritten;
+    }
+    return NO_ERROR;
+}
+
+} // namespace
+
+int ReadDir(const ExtensionString& path, std::vector<ExtensionString>& contents)
+{
+#if defined(OS_LINUX)
+    StFileDescriptor fd(open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd.Get() < 0)
+        return ConvertErrnoCode(errno);
+
+    return ReadDirEntries(fd.Get(), contents);
+#else
+    DIR* dir = opendir(path.c_str());
+    if (!dir)
+        return ConvertErrnoCode(errno);
+
+    struct dirent* entry;
+    errno = 0;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!IsDotOrDotDot(entry->d_name))
+            contents.push_back(entry->d_name);
+    }
+    int error = errno;
+    closedir(dir);
+
+    return ConvertErrnoCode(error);
+#endif
+}
+
+int ReadDirWithStats(const ExtensionString& path, std::vector<DirEntry>& entries)
+{
+    std::vector<ExtensionString> names;
+
+#if defined(OS_LINUX)
+    StFileDescriptor fd(open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd.Get() < 0)
+        return ConvertErrnoCode(errno);
+
+    int error = ReadDirEntries(fd.Get(), names);
+    if (error != NO_ERROR)
+        return error;
+
+    entries.reserve(entries.size() + names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        DirEntry entry;
+        entry.name = names[i];
+
+        // Fall back to the link itself for dangling symlinks. Anything else
+        // that fails was removed since getdents() and is skipped.
+        if (StatAt(fd.Get(), names[i].c_str(), 0, entry.info) != NO_ERROR &&
+            StatAt(fd.Get(), names[i].c_str(), AT_SYMLINK_NOFOLLOW, entry.info) != NO_ERROR)
+            continue;
+
+        entries.push_back(entry);
+    }
+#else
+    int error = ReadDir(path, names);
+    if (error != NO_ERROR)
+        return error;
+
+    entries.reserve(entries.size() + names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        ExtensionString entryPath = path + "/" + names[i];
+        struct stat buffer;
+        if (stat(entryPath.c_str(), &buffer) == -1 && lstat(entryPath.c_str(), &buffer) == -1)
+            continue;
+
+        DirEntry entry;
+        entry.name = names[i];
+        FillFileInfo(buffer, entry.info);
+        entries.push_back(entry);
+    }
+#endif
+
+    SortDirEntries(entries);
+    return NO_ERROR;
+}
+
+int ListDirectory(const ExtensionString& path, bool withStats, std::vector<DirEntry>& entries, FileId& id)
+{
+    std::vector<ExtensionString> names;
+    std::vector<unsigned char> types;
+
+#if defined(OS_LINUX)
+    StFileDescriptor fd(open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd.Get() < 0)
+        return ConvertErrnoCode(errno);
+    int dirFd = fd.Get();
+
+    int error = ReadDirEntries(dirFd, names, &types);
+    if (error != NO_ERROR)
+        return error;
+#else
+    DIR* dir = opendir(path.c_str());
+    if (!dir)
+        return ConvertErrnoCode(errno);
+    int dirFd = dirfd(dir);
+
+    struct dirent* entry;
+    errno = 0;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!IsDotOrDotDot(entry->d_name)) {
+            names.push_back(entry->d_name);
+            types.push_back(entry->d_type);
+        }
+    }
+    int error = ConvertErrnoCode(errno);
+    if (error != NO_ERROR) {
+        closedir(dir);
+        return error;
+    }
+#endif
+
+    struct stat buffer;
+    if (fstat(dirFd, &buffer) == 0) {
+        id.device = (unsigned long long)buffer.st_dev;
+        id.index = (unsigned long long)buffer.st_ino;
+    }
+
+    entries.reserve(entries.size() + names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        DirEntry entry;
+        entry.name = names[i];
+
+        // Only symlinks and file systems that leave d_type empty need a stat
+        // to tell directories from files
+        if (withStats || types[i] == DT_LNK || types[i] == DT_UNKNOWN) {
+#if defined(OS_LINUX)
+            if (StatAt(dirFd, names[i].c_str(), 0, entry.info) != NO_ERROR &&
+                StatAt(dirFd, names[i].c_str(), AT_SYMLINK_NOFOLLOW, entry.info) != NO_ERROR)
+                continue;
+#else
+            ExtensionString entryPath = path + "/" + names[i];
+            struct stat entryBuffer;
+            if (stat(entryPath.c_str(), &entryBuffer) == -1 && lstat(entryPath.c_str(), &entryBuffer) == -1)
+                continue;
+            FillFileInfo(entryBuffer, entry.info);
+#endif
+        } else {
+            entry.info.isDirectory = types[i] == DT_DIR;
+        }
+
+        entries.push_back(entry);
+    }
+
+#if !defined(OS_LINUX)
+    closedir(dir);
+#endif
+    return NO_ERROR;
+}
+
+int IsDirectory(const ExtensionString& path, bool& isDirectory)
+{
+    struct stat buffer;
+    int error = StatPath(path, buffer);
+    if (error != NO_ERROR)
+        return error;
+
+    isDirectory = S_ISDIR(buffer.st_mode);
+    return NO_ERROR;
+}
+
+int GetFileInfo(const ExtensionString& path, FileInfo& info)
+{
+#if defined(OS_LINUX)
+    return StatAt(AT_FDCWD, path.c_str(), 0, info);
+#else
+    struct stat buffer;
+    int error = StatPath(path, buffer);
+    if (error != NO_ERROR)
+        return error;
+
+    FillFileInfo(buffer, info);
+    return NO_ERROR;
+#endif
+}
+
+void GetFileInfosAt(const ExtensionString& directory, const std::vector<ExtensionString>& names,
+                    std::vector<FileInfo>& infos, std::vector<int>& errors)
+{
+    infos.assign(names.size(), FileInfo());
+    errors.assign(names.size(), NO_ERROR);
+
+#if defined(OS_LINUX)
+    StFileDescriptor fd(open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd.Get() >= 0) {
+        for (size_t i = 0; i < names.size(); i++)
+            errors[i] = StatAt(fd.Get(), names[i].c_str(), 0, infos[i]);
+        return;
+    }
+#endif
+
+    // Each entry on its own, which also gives each one the error it would
+    // get from GetFileInfo if the directory can't be opened
+    ExtensionString prefix = directory;
+    if (prefix.empty() || prefix[prefix.length() - 1] != '/')
+        prefix += '/';
+    for (size_t i = 0; i < names.size(); i++)
+        errors[i] = GetFileInfo(prefix + names[i], infos[i]);
+}
+
+int GetFileModificationTime(const ExtensionString& path, double& modTime)
+{
+    struct stat buffer;
+    int error = StatPath(path, buffer);
+    if (error != NO_ERROR)
+        return error;
+
+    FileInfo info;
+    FillFileInfo(buffer, info);
+    modTime = info.mtimeSec + info.mtimeNsec / 1e9;
+    return NO_ERROR;
+}
+
+int ReadFileBytes(const ExtensionString& path, std::string& contents, bool validateUTF8, TextLayout* layout)
+{
+    StFileDescriptor fd(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd.Get() < 0)
+        return ConvertErrnoCode(errno);
+
+    struct stat buffer;
+    if (fstat(fd.Get(), &buffer) == -1)
+        return ConvertErrnoCode(errno);
+
+    if (S_ISDIR(buffer.st_mode))
+        return ERR_CANT_READ;
+
+    if ((unsigned long long)buffer.st_size > (unsigned long long)contents.max_size())
+        return ERR_CANT_READ;
+
+    // Read straight into |contents| and validate each chunk while it is still
+    // in the cache. st_size is only a hint: files in /proc report 0 and a file
+    // that is being appended to can grow, so reads go on until EOF. Anything
+    // past the expected size goes through |overflow| so that |contents| is
+    // not reallocated just to find out that the file has ended.
+    contents.resize((size_t)buffer.st_size);
+    UTF8Validator validator;
+    char overflow[16 * 1024];
+    size_t totalRead = 0;
+    for (;;) {
+        char* target = overflow;
+        size_t wanted = sizeof(overflow);
+        if (totalRead < contents.size()) {
+            target = &contents[totalRead];
+            wanted = std::min(contents.size() - totalRead, kReadChunkSize);
+        }
+
+        ssize_t bytesRead = read(fd.Get(), target, wanted);
+        if (bytesRead < 0) {
+            if (errno == EINTR)
+                continue;
+            return ConvertErrnoCode(errno);
+        }
+        if (bytesRead == 0)
+            break;
+
+        if (validateUTF8) {
+            if (!validator.Feed(target, bytesRead))
+                return ERR_UNSUPPORTED_ENCODING;
+            if (layout)
+                layout->Feed(target, bytesRead);
+        }
+        if (target == overflow)
+            contents.append(overflow, bytesRead);
+        totalRead += bytesRead;
+    }
+    contents.resize(totalRead);
+
+    if (validateUTF8) {
+        if (!validator.Finish())
+            return ERR_UNSUPPORTED_ENCODING;
+        if (layout)
+            layout->Finish();
+    }
+
+    return NO_ERROR;
+}
+
+int BeginWriteBytes(const ExtensionString& path, const std::string& contents, PendingWrite& write)
+{
+    // Replace the target of a symlink, not the link
+    int error = ResolveSymlinks(path, write.target);
+    if (error != NO_ERROR)
+        return error;
+    struct stat targetStat;
+    write.exists = lstat(write.target.c_str(), &targetStat) == 0;
+
+    size_t slash = write.target.rfind('/');
+    write.directory = slash == ExtensionString::npos ? "." : write.target.substr(0, std::max(slash, (size_t)1));
+    ExtensionString name = slash == ExtensionString::npos ? write.target : write.target.substr(slash + 1);
+
+    bool inPlace = false;
+    if (write.exists) {
+        if (S_ISDIR(targetStat.st_mode))
+            return ERR_NOT_FILE;
+
+        // rename() ignores the permissions of the file it replaces, but
+        // saving over a read-only file must still fail
+        if (access(write.target.c_str(), W_OK) == -1)
+            return ConvertErrnoCode(errno, false);
+
+        // Replacing one of several hard links would split it from the others
+        inPlace = targetStat.st_nlink > 1;
+    }
+
+    int fd = -1;
+    for (int attempt = 0; !inPlace && fd < 0 && attempt < 100; attempt++) {
+        char suffix[64];
+        snprintf(suffix, sizeof(suffix), ".%ld.%d.tmp", (long)getpid(), __sync_add_and_fetch(&s_tempFileCounter, 1));
+        write.tempPath = write.directory + "/." + name + suffix;
+        fd = open(write.tempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        if (fd < 0 && errno != EEXIST) {
+            // The file may be writable in a directory that isn't
+            if (errno != EACCES && errno != EPERM && errno != EROFS)
+                return ConvertErrnoCode(errno, false);
+            inPlace = true;
+        }
+    }
+
+    // The new file takes on the permissions and owner of the old one. Where
+    // it can't, the old one is rewritten in place instead.
+    if (!inPlace && fd >= 0 && write.exists) {
+        bool copied = fchmod(fd, targetStat.st_mode & 07777) == 0;
+        if (copied && (targetStat.st_uid != geteuid() || targetStat.st_gid != getegid()))
+            copied = fchown(fd, targetStat.st_uid, targetStat.st_gid) == 0;
+        if (!copied) {
+            close(fd);
+            unlink(write.tempPath.c_str());
+            inPlace = true;
+        }
+    }
+
+    if (inPlace) {
+        write.tempPath.clear();
+        fd = open(write.target.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    }
+
+    if (fd < 0) {
+        write.tempPath.clear();
+        return ConvertErrnoCode(errno, false);
+    }
+
+    write.file = fd;
+    write.isOpen = true;
+    return WriteContents(fd, contents);
+}
+
+int SyncWrite(PendingWrite& write, Durability durability)
+{
+    int result = 0;
+    switch (durability) {
+    case DURABILITY_NONE:
+        break;
+    case DURABILITY_DATA:
+#if defined(OS_LINUX)
+        result = fdatasync(write.file);
+#else
+        result = fsync(write.file);
+#endif
+        break;
+    case DURABILITY_FULL:
+#if defined(OS_MACOSX)
+        // fsync only gets the data as far as the drive's cache on the Mac
+        if (fcntl(write.file, F_FULLFSYNC) != -1)
+            break;
+#endif
+        result = fsync(write.file);
+        break;
+    }
+
+    if (result == -1)
+        return ConvertErrnoCode(errno, false);
+    return NO_ERROR;
+}
+
+int CommitWrite(PendingWrite& write, Durability durability)
+{
+    write.isOpen = false;
+    if (close(write.file) == -1)
+        return ConvertErrnoCode(errno, false);
+
+    if (!write.tempPath.empty()) {
+        if (rename(write.tempPath.c_str(), write.target.c_str()) == -1)
+            return ConvertErrnoCode(errno, false);
+        write.tempPath.clear();
+    }
+    return NO_ERROR;
+}
+
+void AbortWrite(PendingWrite& write)
+{
+    if (write.isOpen) {
+        close(write.file);
+        write.isOpen = false;
+    }
+    if (!write.tempPath.empty()) {
+        unlink(write.tempPath.c_str());
+        write.tempPath.clear();
+    }
+}
+
+void SyncDirectory(const ExtensionString& directory)
+{
+    StFileDescriptor fd(open(directory.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd.Get() >= 0)
+        fsync(fd.Get());
+}
+
+int SetPosixPermissions(const ExtensionString& path, int mode)
+{
+    if (chmod(path.c_str(), mode) == -1)
+        return ConvertErrnoCode(errno, false);
+
+    return NO_ERROR;
+}
+
+int DeleteFileOrDirectory(const ExtensionString& path)
+{
+    if (unlink(path.c_str()) == 0)
+        return NO_ERROR;
+
+    // unlink() refuses directories with EISDIR on Linux and EPERM on Mac
+    int error = errno;
+    struct stat buffer;
+    if ((error != EISDIR && error != EPERM) || lstat(path.c_str(), &buffer) == -1 ||
+        !S_ISDIR(buffer.st_mode))
+        return ConvertErrnoCode(error, false);
+
+    // A directory goes with everything in it, as removeItemAtPath did. Links
+    // inside are removed, not followed.
+    std::vector<ExtensionString> names;
+    error = ReadDir(path, names);
+    if (error != NO_ERROR)
+        return error;
+
+    ExtensionString prefix = path;
+    if (prefix[prefix.length() - 1] != '/')
+        prefix += '/';
+    for (size_t i = 0; i < names.size(); i++) {
+        error = DeleteFileOrDirectory(prefix + names[i]);
+        if (error != NO_ERROR)
+            return error;
+    }
+
+    if (rmdir(path.c_str()) == -1)
+        return ConvertErrnoCode(errno, false);
+
+    return NO_ERROR;
+}
+
+int OpenFileForReading(const ExtensionString& path, PlatformFile& file)
+{
+    // O_NONBLOCK keeps a FIFO found in a project tree from blocking the open;
+    // it makes no difference to regular files
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0)
+        return ConvertErrnoCode(errno);
+
+    struct stat buffer;
+    if (fstat(fd, &buffer) == -1) {
+        int error = ConvertErrnoCode(errno);
+        close(fd);
+        return error;
+    }
+    if (!S_ISREG(buffer.st_mode)) {
+        close(fd);
+        return ERR_CANT_READ;
+    }
+
+    file = fd;
+    return NO_ERROR;
+}
+
+int GetOpenFileSize(PlatformFile file, unsigned long long& size)
+{
+    struct stat buffer;
+    if (fstat(file, &buffer) == -1)
+        return ConvertErrnoCode(errno);
+
+    size = (unsigned long long)buffer.st_size;
+    return NO_ERROR;
+}
+
+int GetOpenFileInfo(PlatformFile file, FileInfo& info, FileId& id)
+{
+    struct stat buffer;
+    if (fstat(file, &buffer) == -1)
+        return ConvertErrnoCode(errno);
+
+    FillFileInfo(buffer, info);
+    id.device = (unsigned long long)buffer.st_dev;
+    id.index = (unsigned long long)buffer.st_ino;
+    return NO_ERROR;
+}
+
+int ReadFileAt(PlatformFile file, unsigned long long offset, char* buffer, size_t length, size_t& bytesRead)
+{
+    bytesRead = 0;
+    while (bytesRead < length) {
+        ssize_t result = pread(file, buffer + bytesRead, length - bytesRead, (off_t)(offset + bytesRead));
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            return ConvertErrnoCode(errno);
+        }
+        if (result == 0)
+            break;
+        bytesRead += result;
+    }
+    return NO_ERROR;
+}
+
+void CloseFile(PlatformFile file)
+{
+    close(file);
+}
+
+int CreateFileForAppending(const ExtensionString& path, PlatformFile& file)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0)
+        return ConvertErrnoCode(errno, false);
+
+    file = fd;
+    return NO_ERROR;
+}
+
+int AppendToFile(PlatformFile file, const char* data, size_t length)
+{
+    size_t totalWritten = 0;
+    while (totalWritten < length) {
+        ssize_t bytesWritten = write(file, data + totalWritten, length - totalWritten);
+        if (bytesWritten < 0) {
+            if (errno == EINTR)
+                continue;
+            return ConvertErrnoCode(errno, false);
+        }
+        totalWritten += bytesWritten;
+    }
+    return NO_ERROR;
+}
+
+int SyncFile(PlatformFile file)
+{
+#if defined(OS_LINUX)
+    int result = fdatasync(file);
+#else
+    int result = fsync(file);
+#endif
+    if (result == -1)
+        return ConvertErrnoCode(errno, false);
+    return NO_ERROR;
+}
+
+int MapFile(PlatformFile file, size_t length, MappedFile& mapped)
+{
+    mapped = MappedFile();
+    if (length == 0)
+        return NO_ERROR;
+
+    void* data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, file, 0);
+    if (data == MAP_FAILED)
+        return ConvertErrnoCode(errno);
+
+    // Read ahead aggressively, the mapping is scanned from start to end
+    posix_madvise(data, length, POSIX_MADV_SEQUENTIAL);
+
+    mapped.data = (const char*)data;
+    mapped.length = length;
+    return NO_ERROR;
+}
+
+void UnmapFile(MappedFile& mapped)
+{
+    if (mapped.data)
+        munmap((void*)mapped.data, mapped.length);
+    mapped = MappedFile();
+}
+
+} // namespace FileSystem
+} // namespace Brackets
@@ -0,0 +1,660 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_fs.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <wchar.h>
+#include <algorithm>
+#include <functional>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+// ReadFile validates the file a chunk at a time, right after reading it
+const size_t kReadChunkSize = 1024 * 1024;
+
+void FixFilename(ExtensionString& filename)
+{
+    // Convert '/' to '\'
+    std::replace_if(filename.begin(), filename.end(), std::bind2nd(std::equal_to<wchar_t>(), '/'), '\\');
+}
+
+// Converts a FILETIME (100ns ticks since 1601) to seconds and nanoseconds
+// since the Unix epoch
+void FileTimeToUnixTime(const FILETIME& fileTime, long long& seconds, long& nanoseconds)
+{
+    const unsigned long long epochOffset = 116444736000000000ULL;
+    unsigned long long ticks = ((unsigned long long)fileTime.dwHighDateTime << 32) | fileTime.dwLowDateTime;
+    long long sinceEpoch = (long long)(ticks - epochOffset);
+
+    seconds = sinceEpoch / 10000000;
+    nanoseconds = (long)(sinceEpoch % 10000000) * 100;
+    if (nanoseconds < 0) {
+        seconds--;
+        nanoseconds += 1000000000;
+    }
+}
+
+// Writes all of |contents| to |hFile|. The file is extended to its final size
+// first so that a full disk is found before anything is written.
+int WriteContents(HANDLE hFile, const std::string& contents)
+{
+    LARGE_INTEGER size;
+    size.QuadPart = (LONGLONG)contents.size();
+    if (size.QuadPart > 0) {
+        if (!SetFilePointerEx(hFile, size, NULL, FILE_BEGIN) || !SetEndOfFile(hFile)) {
+            if (GetLastError() == ERROR_DISK_FULL || GetLastError() == ERROR_HANDLE_DISK_FULL)
+                return ERR_OUT_OF_SPACE;
+        }
+        LARGE_INTEGER start;
+        start.QuadPart = 0;
+        SetFilePointerEx(hFile, start, NULL, FILE_BEGIN);
+    }
+
+    size_t totalWritten = 0;
+    while (totalWritten < contents.size()) {
+        DWORD wanted = (DWORD)std::min(contents.size() - totalWritten, kReadChunkSize);
+        DWORD dwBytesWritten = 0;
+        if (!::WriteFile(hFile, contents.data() + totalWritten, wanted, &dwBytesWritten, NULL))
+            return ConvertWinErrorCode(GetLastError(), false);
+        totalWritten += dwBytesWritten;
+    }
+    return NO_ERROR;
+}
+
+bool HasHardLinks(const ExtensionString& path)
+{
+    HANDLE hFile = CreateFile(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == hFile)
+        return false;
+
+    BY_HANDLE_FILE_INFORMATION info;
+    bool linked = GetFileInformationByHandle(hFile, &info) && info.nNumberOfLinks > 1;
+    CloseHandle(hFile);
+    return linked;
+}
+
+} // namespace
+
+int ConvertWinErrorCode(int errorCode, bool isReading)
+{
+    switch (errorCode) {
+    case NO_ERROR:
+        return NO_ERROR;
+    case ERROR_PATH_NOT_FOUND:
+    case ERROR_FILE_NOT_FOUND:
+        return ERR_NOT_FOUND;
+    case ERROR_ACCESS_DENIED:
+        return isReading ? ERR_CANT_READ : ERR_CANT_WRITE;
+    case ERROR_WRITE_PROTECT:
+        return ERR_CANT_WRITE;
+    case ERROR_HANDLE_DISK_FULL:
+        return ERR_OUT_OF_SPACE;
+    default:
+        return ERR_UNKNOWN;
+    }
+}
+
+int ReadDir(const ExtensionString& path, std::vector<ExtensionString>& contents)
+{
+    ExtensionString pathStr = path;
+    FixFilename(pathStr);
+    pathStr += L"\\*";
+
+    WIN32_FIND_DATA ffd;
+    HANDLE hFind = FindFirstFile(pathStr.c_str(), &ffd);
+    if (hFind == INVALID_HANDLE_VALUE)
+        return ConvertWinErrorCode(GetLastError());
+
+    // On Windows, list directories first, then files
+    std::vector<ExtensionString> files;
+    do {
+        // Ignore '.' and '..'
+        if (!wcscmp(ffd.cFileName, L".") || !wcscmp(ffd.cFileName, L".."))
+            continue;
+
+        if (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            contents.push_back(ffd.cFileName);
+        else
+            files.push_back(ffd.cFileName);
+    } while (FindNextFile(hFind, &ffd) != 0);
+
+    FindClose(hFind);
+
+    contents.insert(contents.end(), files.begin(), files.end());
+    return NO_ERROR;
+}
+
+int ReadDirWithStats(const ExtensionString& path, std::vector<DirEntry>& entries)
+{
+    ExtensionString pathStr = path;
+    FixFilename(pathStr);
+    pathStr += L"\\*";
+
+    // FindFirstFile already returns the attributes, size and write time of
+    // every entry, so no extra calls are needed per file
+    WIN32_FIND_DATA ffd;
+    HANDLE hFind = FindFirstFile(pathStr.c_str(), &ffd);
+    if (hFind == INVALID_HANDLE_VALUE)
+        return ConvertWinErrorCode(GetLastError());
+
+    do {
+        // Ignore '.' and '..'
+        if (!wcscmp(ffd.cFileName, L".") || !wcscmp(ffd.cFileName, L".."))
+            continue;
+
+        DirEntry entry;
+        entry.name = ffd.cFileName;
+        entry.info.isDirectory = (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        entry.info.size = ((unsigned long long)ffd.nFileSizeHigh << 32) | ffd.nFileSizeLow;
+        FileTimeToUnixTime(ffd.ftLastWriteTime, entry.info.mtimeSec, entry.info.mtimeNsec);
+        entries.push_back(entry);
+    } while (FindNextFile(hFind, &ffd) != 0);
+
+    FindClose(hFind);
+
+    SortDirEntries(entries);
+    return NO_ERROR;
+}
+
+int ListDirectory(const ExtensionString& path, bool withStats, std::vector<DirEntry>& entries, FileId& id)
+{
+    ExtensionString pathStr = path;
+    FixFilename(pathStr);
+
+    // FindFirstFile has the stats anyway, so |withStats| costs nothing extra
+    WIN32_FIND_DATA ffd;
+    HANDLE hFind = FindFirstFile((pathStr + L"\\*").c_str(), &ffd);
+    if (hFind == INVALID_HANDLE_VALUE)
+        return ConvertWinErrorCode(GetLastError());
+
+    do {
+        // Ignore '.' and '..'
+        if (!wcscmp(ffd.cFileName, L".") || !wcscmp(ffd.cFileName, L".."))
+            continue;
+
+        DirEntry entry;
+        entry.name = ffd.cFileName;
+        entry.info.isDirectory = (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        entry.info.size = ((unsigned long long)ffd.nFileSizeHigh << 32) | ffd.nFileSizeLow;
+        FileTimeToUnixTime(ffd.ftLastWriteTime, entry.info.mtimeSec, entry.info.mtimeNsec);
+        entries.push_back(entry);
+    } while (FindNextFile(hFind, &ffd) != 0);
+
+    FindClose(hFind);
+
+    // Opening the directory follows junctions and symlinks, so the index is
+    // that of the target
+    HANDLE hDir = CreateFile(pathStr.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+    if (hDir != INVALID_HANDLE_VALUE) {
+        BY_HANDLE_FILE_INFORMATION info;
+        if (GetFileInformationByHandle(hDir, &info)) {
+            id.device = info.dwVolumeSerialNumber;
+            id.index = ((unsigned long long)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+        }
+        CloseHandle(hDir);
+    }
+
+    return NO_ERROR;
+}
+
+int IsDirectory(const ExtensionString& path, bool& isDirectory)
+{
+    ExtensionString pathStr = path;
+    FixFilename(pathStr);
+
+    DWORD dwAttr = GetFileAttributes(pathStr.c_str());
+    if (dwAttr == INVALID_FILE_ATTRIBUTES)
+        return ConvertWinErrorCode(GetLastError());
+
+    isDirectory = (dwAttr & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    return NO_ERROR;
+}
+
+int GetFileInfo(const ExtensionString& path, FileInfo& info)
+{
+    ExtensionString pathStr = path;
+    FixFilename(pathStr);
+
+    // Remove trailing "\", if present, as GetFileModificationTime does
+    if (!pathStr.empty() && pathStr[pathStr.length() - 1] == '\\')
+        pathStr.erase(pathStr.length() - 1);
+
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesEx(pathStr.c_str(), GetFileExInfoStandard, &data))
+        return ConvertWinErrorCode(GetLastError());
+
+    info.isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    info.size = ((unsigned long long)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    FileTimeToUnixTime(data.ftLastWriteTime, info.mtimeSec, info.mtimeNsec);
+    return NO_ERROR;
+}
+
+void GetFileInfosAt(const ExtensionString& directory, const std::vector<ExtensionString>& names,
+                    std::vector<FileInfo>& infos, std::vector<int>& errors)
+{
+    infos.assign(names.size(), FileInfo());
+    errors.assign(names.size(), NO_ERROR);
+
+    ExtensionString prefix = directory;
+    if (prefix.empty() || (prefix[prefix.length() - 1] != '/' && prefix[prefix.length() - 1] != '\\'))
+        prefix += L'/';
+    for (size_t i = 0; i < names.size(); i++)
+        errors[i] = GetFileInfo(prefix + names[i], infos[i]);
+}
+
+int GetFileModificationTime(const ExtensionString& path, double& modTime)
+{
+    ExtensionString pathStr = path;
+    FixFilename(pathStr);
+
+    // Remove trailing "\", if present. _wstat will fail with a "file not found"
+    // error if a directory has a trailing '\' in the name.
+    if (!pathStr.empty() && pathStr[pathStr.length() - 1] == '\\')
+        pathStr.erase(pathStr.length() - 1);
+
+    struct _stat buffer;
+    if (_wstat(pathStr.c_str(), &buffer) == -1)
+        return ConvertErrnoCode(errno);
+
+    modTime = (double)buffer.st_mtime;
+    return NO_ERROR;
+}
+
+int ReadFileBytes(const ExtensionString& path, std::string& contents, bool validateUTF8, TextLayout* layout)
+{
+    ExtensionString pathStr = path;
+    FixFilename(pathStr);
+
+    DWORD dwAttr = GetFileAttributes(pathStr.c_str());
+    if (INVALID_FILE_ATTRIBUTES == dwAttr)
+        return ConvertWinErrorCode(GetLastError());
+
+    if (dwAttr & FILE_ATTRIBUTE_DIRECTORY)
+        return ERR_CANT_READ;
+
+    HANDLE hFile = CreateFile(pathStr.c_str(), GENERIC_READ,
+        0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == hFile)
+        return ConvertWinErrorCode(GetLastError());
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize)) {
+        int error = ConvertWinErrorCode(GetLastError());
+        CloseHandle(hFile);
+        return error;
+    }
+    if ((unsigned long long)fileSize.QuadPart > (unsigned long long)contents.max_size()) {
+        CloseHandle(hFile);
+        return ERR_CANT_READ;
+    }
+
+    // Read straight into |contents| in chunks that fit a DWORD and validate
+    // each one right after reading it. Reads go on until EOF in case the file
+    // grew; anything past the expected size goes through |overflow|.
+    int error = NO_ERROR;
+    contents.resize((size_t)fileSize.QuadPart);
+    UTF8Validator validator;
+    char overflow[16 * 1024];
+    size_t totalRead = 0;
+    for (;;) {
+        char* target = overflow;
+        DWORD wanted = sizeof(overflow);
+        if (totalRead < contents.size()) {
+            target = &contents[totalRead];
+            wanted = (DWORD)std::min(contents.size() - totalRead, kReadChunkSize);
+        }
+
+        DWORD dwBytesRead = 0;
+        if (!::ReadFile(hFile, target, wanted, &dwBytesRead, NULL)) {
+            error = ConvertWinErrorCode(GetLastError());
+            break;
+        }
+        if (dwBytesRead == 0)
+            break;
+
+        if (validateUTF8) {
+            if (!validator.Feed(target, dwBytesRead)) {
+                error = ERR_UNSUPPORTED_ENCODING;
+                break;
+            }
+            if (layout)
+                layout->Feed(target, dwBytesRead);
+        }
+        if (target == overflow)
+            contents.append(overflow, dwBytesRead);
+        totalRead += dwBytesRead;
+    }
+
+    CloseHandle(hFile);
+    if (error != NO_ERROR)
+        return error;
+
+    contents.resize(totalRead);
+    if (validateUTF8) {
+        if (!validator.Finish())
+            return ERR_UNSUPPORTED_ENCODING;
+        if (layout)
+            layout->Finish();
+    }
+
+    return NO_ERROR;
+}
+
+int BeginWriteBytes(const ExtensionString& path, const std::string& contents, PendingWrite& write)
+{
+    write.target = path;
+    FixFilename(write.target);
+
+    // The temp file goes next to the target, so a relative path is made full
+    // to find its directory
+    wchar_t fullPath[MAX_PATH];
+    wchar_t* name = NULL;
+    DWORD length = GetFullPathName(write.target.c_str(), MAX_PATH, fullPath, &name);
+    if (length == 0)
+        return ConvertWinErrorCode(GetLastError(), false);
+    if (length >= MAX_PATH)
+        return ERR_CANT_WRITE;
+    if (!name)
+        return ERR_NOT_FILE;
+    write.directory.assign(fullPath, name - fullPath);
+
+    DWORD dwAttr = GetFileAttributes(write.target.c_str());
+    write.exists = dwAttr != INVALID_FILE_ATTRIBUTES;
+    bool inPlace = false;
+    if (write.exists) {
+        if (dwAttr & FILE_ATTRIBUTE_DIRECTORY)
+            return ERR_NOT_FILE;
+
+        // ReplaceFile would swap out a read-only file, but saving over one
+        // must still fail
+        if (dwAttr & FILE_ATTRIBUTE_READONLY)
+            return ERR_CANT_WRITE;
+
+        // Symlinks and files with several hard links are rewritten in place;
+        // replacing them would cut them off from the files they are linked to
+        inPlace = (dwAttr & FILE_ATTRIBUTE_REPARSE_POINT) || HasHardLinks(write.target);
+    }
+
+    wchar_t tempPath[MAX_PATH];
+    if (!inPlace && !GetTempFileName(write.directory.c_str(), L"brk", 0, tempPath)) {
+        // The file may be writable in a directory that isn't
+        if (GetLastError() != ERROR_ACCESS_DENIED)
+            return ConvertWinErrorCode(GetLastError(), false);
+        inPlace = true;
+    }
+
+    HANDLE hFile;
+    if (inPlace) {
+        hFile = CreateFile(write.target.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    } else {
+        write.tempPath = tempPath;
+        hFile = CreateFile(tempPath, GENERIC_WRITE, 0, NULL, TRUNCATE_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    }
+    if (INVALID_HANDLE_VALUE == hFile)
+        return ConvertWinErrorCode(GetLastError(), false);
+
+    write.file = hFile;
+    write.isOpen = true;
+    return WriteContents(hFile, contents);
+}
+
+int SyncWrite(PendingWrite& write, Durability durability)
+{
+    // Windows has no separate data-only flush
+    if (durability != DURABILITY_NONE && !FlushFileBuffers(write.file))
+        return ConvertWinErrorCode(GetLastError(), false);
+    return NO_ERROR;
+}
+
+int CommitWrite(PendingWrite& write, Durability durability)
+{
+    write.isOpen = false;
+    CloseHandle(write.file);
+    if (write.tempPath.empty())
+        return NO_ERROR;
+
+    // ReplaceFile keeps the attributes, ACLs and creation time of the old
+    // file. MoveFileEx covers new files.
+    BOOL replaced;
+    if (write.exists)
+        replaced = ReplaceFile(write.target.c_str(), write.tempPath.c_str(), NULL,
+                               REPLACEFILE_IGNORE_MERGE_ERRORS, NULL, NULL);
+    else
+        replaced = MoveFileEx(write.tempPath.c_str(), write.target.c_str(), MOVEFILE_REPLACE_EXISTING |
+                              (durability == DURABILITY_FULL ? MOVEFILE_WRITE_THROUGH : 0));
+    if (!replaced)
+        return ConvertWinErrorCode(GetLastError(), false);
+
+    write.tempPath.clear();
+    return NO_ERROR;
+}
+
+void AbortWrite(PendingWrite& write)
+{
+    if (write.isOpen) {
+        CloseHandle(write.file);
+        write.isOpen = false;
+    }
+    if (!write.tempPath.empty()) {
+        DeleteFile(write.tempPath.c_str());
+        write.tempPath.clear();
+    }
+}
+
+void SyncDirectory(const ExtensionString& directory)
+{
+    // NTFS journals renames itself, and directories can't be flushed
+    // without administrator rights
+}
+
+int SetPosixPermissions(const ExtensionString& path, int mode)
+{
+    ExtensionString pathStr = path;
+    FixFilename(pathStr);
+
+    // Note, Windows cannot set read-only on directories.
+    // See http://support.microsoft.com/kb/326549
+    DWORD dwAttr = GetFileAttributes(pathStr.c_str());
+    if (dwAttr == INVALID_FILE_ATTRIBUTES)
+        return ConvertWinErrorCode(GetLastError());
+
+    if (dwAttr & FILE_ATTRIBUTE_DIRECTORY)
+        return NO_ERROR;
+
+    // For now only extract permissions for "owner"
+    bool write = (mode & 0200) != 0;
+    bool read = (mode & 0400) != 0;
+    int mask = (write ? _S_IWRITE : 0) | (read ? _S_IREAD : 0);
+
+    // Note _wchmod only supports setting FILE_ATTRIBUTE_READONLY so
+    // _S_IREAD is ignored.
+    if (_wchmod(pathStr.c_str(), mask) == -1)
+        return ConvertErrnoCode(errno);
+
+    return NO_ERROR;
+}
+
+int DeleteFileOrDirectory(const ExtensionString& path)
+{
+    ExtensionString pathStr = path;
+    FixFilename(pathStr);
+
+    if (!DeleteFile(pathStr.c_str()))
+        return ConvertWinErrorCode(GetLastError());
+
+    return NO_ERROR;
+}
+
+int OpenFileForReading(const ExtensionString& path, PlatformFile& file)
+{
+    ExtensionString pathStr = path;
+    FixFilename(pathStr);
+
+    DWORD dwAttr = GetFileAttributes(pathStr.c_str());
+    if (INVALID_FILE_ATTRIBUTES == dwAttr)
+        return ConvertWinErrorCode(GetLastError());
+
+    if (dwAttr & FILE_ATTRIBUTE_DIRECTORY)
+        return ERR_CANT_READ;
+
+    // Share everything so that the file can still be written, renamed or
+    // deleted while it is being paged through
+    HANDLE hFile = CreateFile(pathStr.c_str(), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == hFile)
+        return ConvertWinErrorCode(GetLastError());
+
+    file = hFile;
+    return NO_ERROR;
+}
+
+int GetOpenFileSize(PlatformFile file, unsigned long long& size)
+{
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+        return ConvertWinErrorCode(GetLastError());
+
+    size = (unsigned long long)fileSize.QuadPart;
+    return NO_ERROR;
+}
+
+int GetOpenFileInfo(PlatformFile file, FileInfo& info, FileId& id)
+{
+    BY_HANDLE_FILE_INFORMATION data;
+    if (!GetFileInformationByHandle(file, &data))
+        return ConvertWinErrorCode(GetLastError());
+
+    info.isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    info.size = ((unsigned long long)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    FileTimeToUnixTime(data.ftLastWriteTime, info.mtimeSec, info.mtimeNsec);
+    id.device = data.dwVolumeSerialNumber;
+    id.index = ((unsigned long long)data.nFileIndexHigh << 32) | data.nFileIndexLow;
+    return NO_ERROR;
+}
+
+int ReadFileAt(PlatformFile file, unsigned long long offset, char* buffer, size_t length, size_t& bytesRead)
+{
+    bytesRead = 0;
+    while (bytesRead < length) {
+        unsigned long long position = offset + bytesRead;
+        OVERLAPPED overlapped;
+        memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.Offset = (DWORD)position;
+        overlapped.OffsetHigh = (DWORD)(position >> 32);
+
+        DWORD wanted = (DWORD)std::min(length - bytesRead, kReadChunkSize);
+        DWORD dwBytesRead = 0;
+        if (!::ReadFile(file, buffer + bytesRead, wanted, &dwBytesRead, &overlapped)) {
+            if (GetLastError() == ERROR_HANDLE_EOF)
+                break;
+            return ConvertWinErrorCode(GetLastError());
+        }
+        if (dwBytesRead == 0)
+            break;
+        bytesRead += dwBytesRead;
+    }
+    return NO_ERROR;
+}
+
+void CloseFile(PlatformFile file)
+{
+    CloseHandle(file);
+}
+
+int CreateFileForAppending(const ExtensionString& path, PlatformFile& file)
+{
+    ExtensionString pathStr = path;
+    FixFilename(pathStr);
+
+    // Readers may open it while it is being written, as with a log
+    HANDLE hFile = CreateFile(pathStr.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, NULL,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == hFile)
+        return ConvertWinErrorCode(GetLastError(), false);
+
+    file = hFile;
+    return NO_ERROR;
+}
+
+int AppendToFile(PlatformFile file, const char* data, size_t length)
+{
+    size_t totalWritten = 0;
+    while (totalWritten < length) {
+        DWORD wanted = (DWORD)std::min(length - totalWritten, kReadChunkSize);
+        DWORD dwBytesWritten = 0;
+        if (!::WriteFile(file, data + totalWritten, wanted, &dwBytesWritten, NULL))
+            return ConvertWinErrorCode(GetLastError(), false);
+        totalWritten += dwBytesWritten;
+    }
+    return NO_ERROR;
+}
+
+int SyncFile(PlatformFile file)
+{
+    // Windows has no separate data-only flush
+    if (!FlushFileBuffers(file))
+        return ConvertWinErrorCode(GetLastError(), false);
+    return NO_ERROR;
+}
+
+int MapFile(PlatformFile file, size_t length, MappedFile& mapped)
+{
+    mapped = MappedFile();
+    if (length == 0)
+        return NO_ERROR;
+
+    HANDLE hMapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!hMapping)
+        return ConvertWinErrorCode(GetLastError());
+
+    // The view keeps the mapping object alive on its own
+    LPVOID data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, length);
+    DWORD dwError = GetLastError();
+    CloseHandle(hMapping);
+    if (!data)
+        return ConvertWinErrorCode(dwError);
+
+    mapped.data = (const char*)data;
+    mapped.length = length;
+    return NO_ERROR;
+}
+
+void UnmapFile(MappedFile& mapped)
+{
+    if (mapped.data)
+        UnmapViewOfFile(mapped.data);
+    mapped = MappedFile();
+}
+
+} // namespace FileSystem
+} // namespace Brackets
@@ -0,0 +1,1027 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_hash.h"
+#include "common/brackets_fs_extension.h"
+
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+// Files are read and hashed this much at a time
+const size_t kHashChunkSize = 1024 * 1024;
+
+// Past this many entries the cache is emptied and starts over
+const size_t kMaxCacheEntries = 100000;
+
+// A file modified less than this long before it was hashed may still change
+// within the same modification time, see HashCache
+const long long kRacySeconds = 2;
+
+// Batches are read by a few threads at once, which helps most on SSDs
+const int kMaxHashThreads = 4;
+
+// Every platform Brackets runs on is little-endian
+inline unsigned long long ReadLE64(const unsigned char* p)
+{
+    unsigned long long value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline unsigned int ReadLE32(const unsigned char* p)
+{
+    unsigned int value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline unsigned int ReadBE32(const unsigned char* p)
+{
+    return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+}
+
+inline void WriteBE32(unsigned char* p, unsigned int value)
+{
+    p[0] = (unsigned char)(value >> 24);
+    p[1] = (unsigned char)(value >> 16);
+    p[2] = (unsigned char)(value >> 8);
+    p[3] = (unsigned char)value;
+}
+
+inline unsigned int RotateLeft32(unsigned int value, int bits)
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+inline unsigned int RotateRight32(unsigned int value, int bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+inline unsigned long long RotateLeft64(unsigned long long value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+std::string ToHex(const unsigned char* bytes, size_t length)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    std::string result(length * 2, '0');
+    for (size_t i = 0; i < length; i++) {
+        result[2 * i] = hexDigits[bytes[i] >> 4];
+        result[2 * i + 1] = hexDigits[bytes[i] & 0xF];
+    }
+    return result;
+}
+
+// XXH3, 64-bit, with the default secret and seed 0. Inputs of up to 240
+// bytes are mixed whole; longer ones go through eight 64-bit lanes a 64-byte
+// stripe at a time, with the lanes scrambled after every 16 stripes.
+
+const unsigned int kPrime32_1 = 0x9E3779B1U;
+const unsigned int kPrime32_2 = 0x85EBCA77U;
+const unsigned int kPrime32_3 = 0xC2B2AE3DU;
+const unsigned long long kPrime64_1 = 0x9E3779B185EBCA87ULL;
+const unsigned long long kPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+const unsigned long long kPrime64_3 = 0x165667B19E3779F9ULL;
+const unsigned long long kPrime64_4 = 0x85EBCA77C2B2AE63ULL;
+const unsigned long long kPrime64_5 = 0x27D4EB2F165667C5ULL;
+
+const size_t kSecretSize = 192;
+const unsigned char kSecret[kSecretSize] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+const size_t kStripeLength = 64;
+const size_t kStripesPerBlock = (kSecretSize - kStripeLength) / 8;
+const size_t kMidSizeMax = 240;
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 UInt128;
+#endif
+
+// Low and high halves of the 128-bit product, xor'ed together
+inline unsigned long long Mul128Fold64(unsigned long long a, unsigned long long b)
+{
+#if defined(__SIZEOF_INT128__)
+    UInt128 product = (UInt128)a * b;
+    return (unsigned long long)product ^ (unsigned long long)(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long long high;
+    unsigned long long low = _umul128(a, b, &high);
+    return low ^ high;
+#else
+    unsigned long long loLo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+    unsigned long long hiLo = (a >> 32) * (b & 0xFFFFFFFF);
+    unsigned long long loHi = (a & 0xFFFFFFFF) * (b >> 32);
+    unsigned long long hiHi = (a >> 32) * (b >> 32);
+    unsigned long long cross = (loLo >> 32) + (hiLo & 0xFFFFFFFF) + loHi;
+    unsigned long long high = (hiLo >> 32) + (cross >> 32) + hiHi;
+    unsigned long long low = (cross << 32) | (loLo & 0xFFFFFFFF);
+    return low ^ high;
+#endif
+}
+
+inline unsigned long long XXH64Avalanche(unsigned long long hash)
+{
+    hash ^= hash >> 33;
+    hash *= kPrime64_2;
+    hash ^= hash >> 29;
+    hash *= kPrime64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+inline unsigned long long XXH3Avalanche(unsigned long long hash)
+{
+    hash ^= hash >> 37;
+    hash *= 0x165667919E3779F9ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+inline unsigned long long Mix16(const unsigned char* input, const unsigned char* secret)
+{
+    return Mul128Fold64(ReadLE64(input) ^ ReadLE64(secret), ReadLE64(input + 8) ^ ReadLE64(secret + 8));
+}
+
+// XXH3 of inputs of up to kMidSizeMax bytes
+unsigned long long XXH3Short(const unsigned char* input, size_t length)
+{
+    if (length > 128) {
+        unsigned long long acc = length * kPrime64_1;
+        for (size_t i = 0; i < 8; i++)
+            acc += Mix16(input + 16 * i, kSecret + 16 * i);
+        acc = XXH3Avalanche(acc);
+
+        unsigned long long accEnd = Mix16(input + length - 16, kSecret + 136 - 17);
+        for (size_t i = 8; i < length / 16; i++)
+            accEnd += Mix16(input + 16 * i, kSecret + 16 * (i - 8) + 3);
+        return XXH3Avalanche(acc + accEnd);
+    }
+
+    if (length > 16) {
+        unsigned long long acc = length * kPrime64_1;
+        if (length > 32) {
+            if (length > 64) {
+                if (length > 96) {
+                    acc += Mix16(input + 48, kSecret + 96);
+                    acc += Mix16(input + length - 64, kSecret + 112);
+                }
+                acc += Mix16(input + 32, kSecret + 64);
+                acc += Mix16(input + length - 48, kSecret + 80);
+            }
+            acc += Mix16(input + 16, kSecret + 32);
+            acc += Mix16(input + length - 32, kSecret + 48);
+        }
+        acc += Mix16(input, kSecret);
+        acc += Mix16(input + length - 16, kSecret + 16);
+        return XXH3Avalanche(acc);
+    }
+
+    if (length > 8) {
+        unsigned long long low = ReadLE64(input) ^ (ReadLE64(kSecret + 24) ^ ReadLE64(kSecret + 32));
+        unsigned long long high = ReadLE64(input + length - 8) ^ (ReadLE64(kSecret + 40) ^ ReadLE64(kSecret + 48));
+        unsigned long long swapped = low;
+        swapped = ((swapped & 0x00000000FFFFFFFFULL) << 32) | ((swapped & 0xFFFFFFFF00000000ULL) >> 32);
+        swapped = ((swapped & 0x0000FFFF0000FFFFULL) << 16) | ((swapped & 0xFFFF0000FFFF0000ULL) >> 16);
+        swapped = ((swapped & 0x00FF00FF00FF00FFULL) << 8) | ((swapped & 0xFF00FF00FF00FF00ULL) >> 8);
+        return XXH3Avalanche(length + swapped + high + Mul128Fold64(low, high));
+    }
+
+    if (length >= 4) {
+        unsigned long long input64 = ReadLE32(input + length - 4) + ((unsigned long long)ReadLE32(input) << 32);
+        unsigned long long hash = input64 ^ (ReadLE64(kSecret + 8) ^ ReadLE64(kSecret + 16));
+        hash ^= RotateLeft64(hash, 49) ^ RotateLeft64(hash, 24);
+        hash *= 0x9FB21C651E98DF25ULL;
+        hash ^= (hash >> 35) + length;
+        hash *= 0x9FB21C651E98DF25ULL;
+        return hash ^ (hash >> 28);
+    }
+
+    if (length > 0) {
+        unsigned int combined = ((unsigned int)input[0] << 16) | ((unsigned int)input[length >> 1] << 24) |
+                                input[length - 1] | ((unsigned int)length << 8);
+        return XXH64Avalanche(combined ^ (unsigned long long)(ReadLE32(kSecret) ^ ReadLE32(kSecret + 4)));
+    }
+
+    return XXH64Avalanche(ReadLE64(kSecret + 56) ^ ReadLE64(kSecret + 64));
+}
+
+inline void Accumulate512(unsigned long long* acc, const unsigned char* input, const unsigned char* secret)
+{
+    for (int i = 0; i < 8; i++) {
+        unsigned long long value = ReadLE64(input + 8 * i);
+        unsigned long long key = value ^ ReadLE64(secret + 8 * i);
+        acc[i ^ 1] += value;
+        acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+    }
+}
+
+inline void ScrambleAcc(unsigned long long* acc, const unsigned char* secret)
+{
+    for (int i = 0; i < 8; i++) {
+        unsigned long long value = acc[i];
+        value ^= value >> 47;
+        value ^= ReadLE64(secret + 8 * i);
+        acc[i] = value * kPrime32_1;
+    }
+}
+
+class XXH3Hasher : public Hasher
+{
+public:
+    XXH3Hasher() : m_bufferLength(0), m_stripesInBlock(0), m_totalLength(0)
+    {
+        m_acc[0] = kPrime32_3;
+        m_acc[1] = kPrime64_1;
+        m_acc[2] = kPrime64_2;
+        m_acc[3] = kPrime64_3;
+        m_acc[4] = kPrime64_4;
+        m_acc[5] = kPrime32_2;
+        m_acc[6] = kPrime64_5;
+        m_acc[7] = kPrime32_1;
+    }
+
+    virtual void Update(const char* data, size_t length);
+    virtual std::string Finish();
+
+    // The digest as a number, for Finish and HashXXH3
+    unsigned long long FinishValue();
+
+private:
+    void ConsumeStripes(const unsigned char* input, size_t count);
+
+    // The last stripe of the input is mixed differently, so input is only
+    // consumed once more of it has arrived. The buffer also keeps short
+    // inputs whole for XXH3Short.
+    static const size_t kBufferSize = 4 * kStripeLength;
+
+    unsigned long long m_acc[8];
+    unsigned char m_buffer[kBufferSize];
+    size_t m_bufferLength;
+    size_t m_stripesInBlock;
+    unsigned long long m_totalLength;
+};
+
+void XXH3Hasher::ConsumeStripes(const unsigned char* input, size_t count)
+{
+    // A local copy of the lanes can stay in registers; stores to m_acc would
+    // have to be reloaded after every read of the input
+    unsigned long long acc[8];
+    memcpy(acc, m_acc, sizeof(acc));
+    for (size_t i = 0; i < count; i++) {
+        Accumulate512(acc, input + i * kStripeLength, kSecret + m_stripesInBlock * 8);
+        if (++m_stripesInBlock == kStripesPerBlock) {
+            ScrambleAcc(acc, kSecret + kSecretSize - kStripeLength);
+            m_stripesInBlock = 0;
+        }
+    }
+    memcpy(m_acc, acc, sizeof(acc));
+}
+
+void XXH3Hasher::Update(const char* data, size_t length)
+{
+    const unsigned char* input = (const unsigned char*)data;
+    m_totalLength += length;
+
+    if (m_bufferLength + length <= kBufferSize) {
+        memcpy(m_buffer + m_bufferLength, input, length);
+        m_bufferLength += length;
+        return;
+    }
+
+    // More input follows, so the buffer is not the end
+    if (m_bufferLength > 0) {
+        size_t fill = kBufferSize - m_bufferLength;
+        memcpy(m_buffer + m_bufferLength, input, fill);
+        input += fill;
+        length -= fill;
+        ConsumeStripes(m_buffer, kBufferSize / kStripeLength);
+        m_bufferLength = 0;
+    }
+
+    // Consume the input in place, keeping at least a byte of it back. The
+    // stripe before what is kept goes at the end of the buffer, where Finish
+    // finds it if fewer than a stripe's worth of bytes are kept.
+    if (length > kBufferSize) {
+        size_t stripes = (length - 1) / kStripeLength;
+        ConsumeStripes(input, stripes);
+        input += stripes * kStripeLength;
+        length -= stripes * kStripeLength;
+        memcpy(m_buffer + kBufferSize - kStripeLength, input - kStripeLength, kStripeLength);
+    }
+
+    memcpy(m_buffer, input, length);
+    m_bufferLength = length;
+}
+
+unsigned long long XXH3Hasher::FinishValue()
+{
+    unsigned long long hash;
+    if (m_totalLength <= kMidSizeMax) {
+        hash = XXH3Short(m_buffer, m_bufferLength);
+    } else {
+        unsigned char lastStripe[kStripeLength];
+        const unsigned char* last;
+        if (m_bufferLength >= kStripeLength) {
+            ConsumeStripes(m_buffer, (m_bufferLength - 1) / kStripeLength);
+            last = m_buffer + m_bufferLength - kStripeLength;
+        } else {
+            size_t catchUp = kStripeLength - m_bufferLength;
+            memcpy(lastStripe, m_buffer + kBufferSize - catchUp, catchUp);
+            memcpy(lastStripe + catchUp, m_buffer, m_bufferLength);
+            last = lastStripe;
+        }
+        Accumulate512(m_acc, last, kSecret + kSecretSize - kStripeLength - 7);
+
+        hash = m_totalLength * kPrime64_1;
+        for (int i = 0; i < 4; i++) {
+            hash += Mul128Fold64(m_acc[2 * i] ^ ReadLE64(kSecret + 11 + 16 * i),
+                                 m_acc[2 * i + 1] ^ ReadLE64(kSecret + 11 + 16 * i + 8));
+        }
+        hash = XXH3Avalanche(hash);
+    }
+    return hash;
+}
+
+std::string XXH3Hasher::Finish()
+{
+    unsigned long long hash = FinishValue();
+
+    // Big-endian, as xxhsum prints it
+    unsigned char digest[8];
+    WriteBE32(digest, (unsigned int)(hash >> 32));
+    WriteBE32(digest + 4, (unsigned int)hash);
+    return ToHex(digest, sizeof(digest));
+}
+
+// SHA-1 and SHA-256 share their padding: the input is processed in 64-byte
+// blocks, the last one followed by a 1 bit, zeros and the length in bits.
+class BlockHasher : public Hasher
+{
+public:
+    BlockHasher() : m_bufferLength(0), m_totalLength(0) {}
+
+    virtual void Update(const char* data, size_t length);
+    virtual std::string Finish();
+
+protected:
+    static const size_t kBlockSize = 64;
+
+    virtual void ProcessBlocks(const unsigned char* blocks, size_t count) =0;
+
+    // Writes the digest to |digest| and returns its length
+    virtual size_t GetDigest(unsigned char* digest) const =0;
+
+private:
+    unsigned char m_buffer[kBlockSize];
+    size_t m_bufferLength;
+    unsigned long long m_totalLength;
+};
+
+void BlockHasher::Update(const char* data, size_t length)
+{
+    const unsigned char* input = (const unsigned char*)data;
+    m_totalLength += length;
+
+    if (m_bufferLength > 0) {
+        size_t fill = std::min(kBlockSize - m_bufferLength, length);
+        memcpy(m_buffer + m_bufferLength, input, fill);
+        m_bufferLength += fill;
+        input += fill;
+        length -= fill;
+        if (m_bufferLength < kBlockSize)
+            return;
+        ProcessBlocks(m_buffer, 1);
+        m_bufferLength = 0;
+    }
+
+    size_t blocks = length / kBlockSize;
+    if (blocks > 0)
+        ProcessBlocks(input, blocks);
+    input += blocks * kBlockSize;
+    length -= blocks * kBlockSize;
+
+    memcpy(m_buffer, input, length);
+    m_bufferLength = length;
+}
+
+std::string BlockHasher::Finish()
+{
+    unsigned long long bits = m_totalLength * 8;
+
+    unsigned char padding[2 * kBlockSize];
+    memset(padding, 0, sizeof(padding));
+    padding[0] = 0x80;
+    size_t paddingLength = (m_bufferLength < kBlockSize - 8 ? kBlockSize : 2 * kBlockSize) - m_bufferLength;
+    WriteBE32(padding + paddingLength - 8, (unsigned int)(bits >> 32));
+    WriteBE32(padding + paddingLength - 4, (unsigned int)bits);
+    Update((const char*)padding, paddingLength);
+
+    unsigned char digest[32];
+    return ToHex(digest, GetDigest(digest));
+}
+
+class SHA1Hasher : public BlockHasher
+{
+public:
+    SHA1Hasher()
+    {
+        m_state[0] = 0x67452301U;
+        m_state[1] = 0xEFCDAB89U;
+        m_state[2] = 0x98BADCFEU;
+        m_state[3] = 0x10325476U;
+        m_state[4] = 0xC3D2E1F0U;
+    }
+
+protected:
+    virtual void ProcessBlocks(const unsigned char* blocks, size_t count);
+
+    virtual size_t GetDigest(unsigned char* digest) const
+    {
+        for (int i = 0; i < 5; i++)
+            WriteBE32(digest + 4 * i, m_state[i]);
+        return 20;
+    }
+
+private:
+    unsigned int m_state[5];
+};
+
+void SHA1Hasher::ProcessBlocks(const unsigned char* blocks, size_t count)
+{
+    for (size_t block = 0; block < count; block++) {
+        const unsigned char* input = blocks + block * kBlockSize;
+
+        // The message schedule is kept as a ring of 16 words
+        unsigned int w[16];
+        for (int i = 0; i < 16; i++)
+            w[i] = ReadBE32(input + 4 * i);
+
+        unsigned int a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3], e = m_state[4];
+        for (int i = 0; i < 80; i++) {
+            if (i >= 16)
+                w[i & 15] = RotateLeft32(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15], 1);
+
+            unsigned int f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999U;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1U;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDCU;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6U;
+            }
+
+            unsigned int temp = RotateLeft32(a, 5) + f + e + k + w[i & 15];
+            e = d;
+            d = c;
+            c = RotateLeft32(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        m_state[0] += a;
+        m_state[1] += b;
+        m_state[2] += c;
+        m_state[3] += d;
+        m_state[4] += e;
+    }
+}
+
+const unsigned int kSHA256RoundConstants[64] = {
+    0x428a2f98U, 0x71374491U, 0xb5c0fbcfU, 0xe9b5dba5U, 0x3956c25bU, 0x59f111f1U, 0x923f82a4U, 0xab1c5ed5U,
+    0xd807aa98U, 0x12835b01U, 0x243185beU, 0x550c7dc3U, 0x72be5d74U, 0x80deb1feU, 0x9bdc06a7U, 0xc19bf174U,
+    0xe49b69c1U, 0xefbe4786U, 0x0fc19dc6U, 0x240ca1ccU, 0x2de92c6fU, 0x4a7484aaU, 0x5cb0a9dcU, 0x76f988daU,
+    0x983e5152U, 0xa831c66dU, 0xb00327c8U, 0xbf597fc7U, 0xc6e00bf3U, 0xd5a79147U, 0x06ca6351U, 0x14292967U,
+    0x27b70a85U, 0x2e1b2138U, 0x4d2c6dfcU, 0x53380d13U, 0x650a7354U, 0x766a0abbU, 0x81c2c92eU, 0x92722c85U,
+    0xa2bfe8a1U, 0xa81a664bU, 0xc24b8b70U, 0xc76c51a3U, 0xd192e819U, 0xd6990624U, 0xf40e3585U, 0x106aa070U,
+    0x19a4c116U, 0x1e376c08U, 0x2748774cU, 0x34b0bcb5U, 0x391c0cb3U, 0x4ed8aa4aU, 0x5b9cca4fU, 0x682e6ff3U,
+    0x748f82eeU, 0x78a5636fU, 0x84c87814U, 0x8cc70208U, 0x90befffaU, 0xa4506cebU, 0xbef9a3f7U, 0xc67178f2U,
+};
+
+class SHA256Hasher : public BlockHasher
+{
+public:
+    SHA256Hasher()
+    {
+        m_state[0] = 0x6a09e667U;
+        m_state[1] = 0xbb67ae85U;
+        m_state[2] = 0x3c6ef372U;
+        m_state[3] = 0xa54ff53aU;
+        m_state[4] = 0x510e527fU;
+        m_state[5] = 0x9b05688cU;
+        m_state[6] = 0x1f83d9abU;
+        m_state[7] = 0x5be0cd19U;
+    }
+
+protected:
+    virtual void ProcessBlocks(const unsigned char* blocks, size_t count);
+
+    virtual size_t GetDigest(unsigned char* digest) const
+    {
+        for (int i = 0; i < 8; i++)
+            WriteBE32(digest + 4 * i, m_state[i]);
+        return 32;
+    }
+
+private:
+    unsigned int m_state[8];
+};
+
+void SHA256Hasher::ProcessBlocks(const unsigned char* blocks, size_t count)
+{
+    for (size_t block = 0; block < count; block++) {
+        const unsigned char* input = blocks + block * kBlockSize;
+
+        unsigned int w[64];
+        for (int i = 0; i < 16; i++)
+            w[i] = ReadBE32(input + 4 * i);
+        for (int i = 16; i < 64; i++) {
+            unsigned int s0 = RotateRight32(w[i - 15], 7) ^ RotateRight32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            unsigned int s1 = RotateRight32(w[i - 2], 17) ^ RotateRight32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        unsigned int a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+        unsigned int e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+        for (int i = 0; i < 64; i++) {
+            unsigned int s1 = RotateRight32(e, 6) ^ RotateRight32(e, 11) ^ RotateRight32(e, 25);
+            unsigned int choice = (e & f) ^ (~e & g);
+            unsigned int temp1 = h + s1 + choice + kSHA256RoundConstants[i] + w[i];
+            unsigned int s0 = RotateRight32(a, 2) ^ RotateRight32(a, 13) ^ RotateRight32(a, 22);
+            unsigned int majority = (a & b) ^ (a & c) ^ (b & c);
+            unsigned int temp2 = s0 + majority;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        m_state[0] += a;
+        m_state[1] += b;
+        m_state[2] += c;
+        m_state[3] += d;
+        m_state[4] += e;
+        m_state[5] += f;
+        m_state[6] += g;
+        m_state[7] += h;
+    }
+}
+
+} // namespace
+
+bool GetHashAlgorithm(const std::string& name, HashAlgorithm& algorithm)
+{
+    if (name == "xxh3")
+        algorithm = HASH_XXH3;
+    else if (name == "sha1")
+        algorithm = HASH_SHA1;
+    else if (name == "sha256")
+        algorithm = HASH_SHA256;
+    else
+        return false;
+    return true;
+}
+
+Hasher* Hasher::Create(HashAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case HASH_SHA1:     return new SHA1Hasher();
+    case HASH_SHA256:   return new SHA256Hasher();
+    default:            return new XXH3Hasher();
+    }
+}
+
+std::string HashData(HashAlgorithm algorithm, const char* data, size_t length)
+{
+    Hasher* hasher = Hasher::Create(algorithm);
+    hasher->Update(data, length);
+    std::string digest = hasher->Finish();
+    delete hasher;
+    return digest;
+}
+
+unsigned long long HashXXH3(const char* data, size_t length)
+{
+    XXH3Hasher hasher;
+    hasher.Update(data, length);
+    return hasher.FinishValue();
+}
+
+bool HashCache::Key::operator<(const Key& other) const
+{
+    if (id.device != other.id.device)
+        return id.device < other.id.device;
+    if (id.index != other.id.index)
+        return id.index < other.id.index;
+    if (size != other.size)
+        return size < other.size;
+    if (mtimeSec != other.mtimeSec)
+        return mtimeSec < other.mtimeSec;
+    if (mtimeNsec != other.mtimeNsec)
+        return mtimeNsec < other.mtimeNsec;
+    if (algorithm != other.algorithm)
+        return algorithm < other.algorithm;
+    if (offset != other.offset)
+        return offset < other.offset;
+    return length < other.length;
+}
+
+HashCache& HashCache::GetInstance()
+{
+    // Never deleted: worker threads may still be using it while the process exits
+    static HashCache* s_instance = NULL;
+    if (!s_instance)
+        s_instance = new HashCache();
+    return *s_instance;
+}
+
+int HashCache::HashFile(const ExtensionString& path, HashAlgorithm algorithm, unsigned long long offset,
+                        unsigned long long length, bool bypass, FileHash& result,
+                        const AsyncOperation* operation)
+{
+    PlatformFile file;
+    int error = OpenFileForReading(path, file);
+    if (error != NO_ERROR)
+        return error;
+
+    error = HashOpenFile(file, algorithm, offset, length, bypass, result, operation);
+    CloseFile(file);
+    return error;
+}
+
+int HashCache::HashOpenFile(PlatformFile file, HashAlgorithm algorithm, unsigned long long offset,
+                            unsigned long long length, bool bypass, FileHash& result,
+                            const AsyncOperation* operation)
+{
+    FileId id;
+    int error = GetOpenFileInfo(file, result.info, id);
+    if (error != NO_ERROR)
+        return error;
+
+    // The range is cut to the end of the file, like a read
+    const FileInfo& info = result.info;
+    result.offset = std::min(offset, info.size);
+    result.length = std::min(length, info.size - result.offset);
+
+    Key key;
+    key.id = id;
+    key.size = info.size;
+    key.mtimeSec = info.mtimeSec;
+    key.mtimeNsec = info.mtimeNsec;
+    key.algorithm = algorithm;
+    key.offset = result.offset;
+    key.length = result.length;
+
+    long long startSec = (long long)time(NULL);
+    bool cacheable = !bypass && id.index != 0 && info.mtimeSec < startSec - kRacySeconds;
+    {
+        AutoLock lock(m_lock);
+        if (bypass) {
+            m_stats.bypassed++;
+        } else {
+            std::map<Key, std::string>::const_iterator it = m_digests.find(key);
+            if (it != m_digests.end()) {
+                m_stats.hits++;
+                result.digest = it->second;
+                result.cached = true;
+                return NO_ERROR;
+            }
+            m_stats.misses++;
+        }
+    }
+
+    long long start = GetMonotonicTimeUs();
+    Hasher* hasher = Hasher::Create(algorithm);
+    std::vector<char> buffer((size_t)std::min(result.length, (unsigned long long)kHashChunkSize));
+    unsigned long long position = result.offset;
+    unsigned long long end = result.offset + result.length;
+    while (position < end) {
+        if (operation && operation->IsCancelled()) {
+            error = ERR_CANCELLED;
+            break;
+        }
+
+        size_t bytesRead;
+        error = ReadFileAt(file, position, &buffer[0], (size_t)std::min(end - position, (unsigned long long)buffer.size()),
+                           bytesRead);
+        if (error != NO_ERROR)
+            break;
+        if (bytesRead == 0) {
+            // The file shrank since it was opened
+            result.length = position - result.offset;
+            cacheable = false;
+            break;
+        }
+        hasher->Update(&buffer[0], bytesRead);
+        position += bytesRead;
+    }
+    result.digest = hasher->Finish();
+    delete hasher;
+    result.microseconds = GetMonotonicTimeUs() - start;
+
+    if (error != NO_ERROR)
+        return error;
+
+    // A file written while it was read may have been hashed half old, half
+    // new. That digest still tells the file changed, but it is not kept.
+    FileInfo after;
+    if (cacheable && GetOpenFileInfo(file, after, id) == NO_ERROR &&
+        (after.size != info.size || after.mtimeSec != info.mtimeSec || after.mtimeNsec != info.mtimeNsec))
+        cacheable = false;
+
+    AutoLock lock(m_lock);
+    m_stats.bytes += result.length;
+    m_stats.microseconds += result.microseconds;
+    if (cacheable) {
+        if (m_digests.size() >= kMaxCacheEntries)
+            m_digests.clear();
+        m_digests[key] = result.digest;
+    }
+    return NO_ERROR;
+}
+
+HashCache::Stats HashCache::GetStats() const
+{
+    AutoLock lock(m_lock);
+    Stats stats = m_stats;
+    stats.entries = m_digests.size();
+    return stats;
+}
+
+namespace {
+
+// Reads the options of HashFileAsync and HashFilesAsync
+bool GetHashOptions(CefRefPtr<CefV8Value> options, unsigned long long& offset, unsigned long long& length,
+                    bool& bypassCache)
+{
+    if (!options->IsObject())
+        return false;
+
+    if (options->HasValue("offset") && !GetNumberValue(options->GetValue("offset"), offset))
+        return false;
+    if (options->HasValue("length") && !GetNumberValue(options->GetValue("length"), length))
+        return false;
+    if (options->HasValue("bypassCache")) {
+        if (!options->GetValue("bypassCache")->IsBool())
+            return false;
+        bypassCache = options->GetValue("bypassCache")->GetBoolValue();
+    }
+    return true;
+}
+
+// Reads the (..., algorithm[, options], callback) arguments that follow the
+// path or paths. Returns the index of the callback, or 0 if the arguments
+// are invalid.
+size_t GetHashArguments(const CefV8ValueList& arguments, HashAlgorithm& algorithm, unsigned long long& offset,
+                        unsigned long long& length, bool& bypassCache)
+{
+    if (arguments.size() < 3 || !arguments[1]->IsString())
+        return 0;
+
+    std::string name;
+    GetUTF8StringValue(arguments[1], name);
+    if (!GetHashAlgorithm(name, algorithm))
+        return 0;
+
+    // options is optional and comes before the callback
+    if (arguments[2]->IsFunction())
+        return 2;
+    if (!GetHashOptions(arguments[2], offset, length, bypassCache))
+        return 0;
+    return 3;
+}
+
+CefRefPtr<CefV8Value> FileHashToV8Value(const FileHash& hash)
+{
+    CefRefPtr<CefV8Value> result = CefV8Value::CreateObject(NULL);
+    result->SetValue("hash", CefV8Value::CreateString(hash.digest), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("offset", CefV8Value::CreateDouble((double)hash.offset), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("length", CefV8Value::CreateDouble((double)hash.length), V8_PROPERTY_ATTRIBUTE_NONE);
+    SetFileInfoValues(result, hash.info);
+    result->SetValue("cached", CefV8Value::CreateBool(hash.cached), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("time", CefV8Value::CreateDouble(hash.microseconds / 1000.0), V8_PROPERTY_ATTRIBUTE_NONE);
+    return result;
+}
+
+class HashFileOperation : public AsyncOperation
+{
+public:
+    HashFileOperation(const ExtensionString& path, HashAlgorithm algorithm, unsigned long long offset,
+                      unsigned long long length, bool bypassCache)
+        : m_path(path), m_algorithm(algorithm), m_offset(offset), m_length(length), m_bypassCache(bypassCache) {}
+
+protected:
+    virtual int Run()
+    {
+        return HashCache::GetInstance().HashFile(m_path, m_algorithm, m_offset, m_length, m_bypassCache,
+                                                 m_hash, this);
+    }
+
+    virtual CefRefPtr<CefV8Value> GetResult() { return FileHashToV8Value(m_hash); }
+
+private:
+    ExtensionString m_path;
+    HashAlgorithm m_algorithm;
+    unsigned long long m_offset;
+    unsigned long long m_length;
+    bool m_bypassCache;
+    FileHash m_hash;
+};
+
+// Hashes a batch of files, a few at a time. Each file gets its own result or
+// error code.
+class HashFilesOperation : public AsyncOperation, public ParallelWork
+{
+public:
+    HashFilesOperation(const std::vector<ExtensionString>& paths, HashAlgorithm algorithm,
+                       unsigned long long offset, unsigned long long length, bool bypassCache)
+        : m_paths(paths), m_algorithm(algorithm), m_offset(offset), m_length(length), m_bypassCache(bypassCache) {}
+
+    virtual CefRefPtr<CefV8Value> GetResult()
+    {
+        CefRefPtr<CefV8Value> result = CefV8Value::CreateArray();
+        for (size_t i = 0; i < m_hashes.size(); i++) {
+            if (m_errors[i] == NO_ERROR)
+                result->SetValue((int)i, FileHashToV8Value(m_hashes[i]));
+            else
+                result->SetValue((int)i, CefV8Value::CreateInt(m_errors[i]));
+        }
+        return result;
+    }
+
+protected:
+    virtual int Run()
+    {
+        m_hashes.resize(m_paths.size());
+        m_errors.assign(m_paths.size(), NO_ERROR);
+        ParallelFor(*this, m_paths.size(), kMaxHashThreads);
+        return IsCancelled() ? ERR_CANCELLED : NO_ERROR;
+    }
+
+    virtual void RunItem(size_t index)
+    {
+        if (IsCancelled()) {
+            m_errors[index] = ERR_CANCELLED;
+            return;
+        }
+
+        m_errors[index] = HashCache::GetInstance().HashFile(m_paths[index], m_algorithm, m_offset, m_length,
+                                                            m_bypassCache, m_hashes[index], this);
+    }
+
+private:
+    std::vector<ExtensionString> m_paths;
+    HashAlgorithm m_algorithm;
+    unsigned long long m_offset;
+    unsigned long long m_length;
+    bool m_bypassCache;
+    std::vector<FileHash> m_hashes;
+    std::vector<int> m_errors;
+};
+
+} // namespace
+
+int ExecuteHashFileAsync(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+{
+    HashAlgorithm algorithm;
+    unsigned long long offset = 0;
+    unsigned long long length = HashCache::kToEnd;
+    bool bypassCache = false;
+    size_t callbackIndex = GetHashArguments(arguments, algorithm, offset, length, bypassCache);
+    if (callbackIndex == 0)
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString storage;
+    const ExtensionString* path = GetPathValue(arguments[0], storage);
+    if (!path)
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<AsyncOperation> operation = new HashFileOperation(*path, algorithm, offset, length, bypassCache);
+    return operation->Start(arguments, callbackIndex, retval);
+}
+
+int ExecuteHashFilesAsync(const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception)
+{
+    HashAlgorithm algorithm;
+    unsigned long long offset = 0;
+    unsigned long long length = HashCache::kToEnd;
+    bool bypassCache = false;
+    size_t callbackIndex = GetHashArguments(arguments, algorithm, offset, length, bypassCache);
+    if (callbackIndex == 0 || !arguments[0]->IsArray())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<CefV8Value> pathsValue = arguments[0];
+    std::vector<ExtensionString> paths;
+    for (int i = 0; i < pathsValue->GetArrayLength(); i++) {
+        CefRefPtr<CefV8Value> path = pathsValue->GetValue(i);
+        ExtensionString storage;
+        const ExtensionString* pathStr = path.get() ? GetPathValue(path, storage) : NULL;
+        if (!pathStr)
+            return ERR_INVALID_PARAMS;
+        paths.push_back(*pathStr);
+    }
+
+    CefRefPtr<AsyncOperation> operation = new HashFilesOperation(paths, algorithm, offset, length, bypassCache);
+    return operation->Start(arguments, callbackIndex, retval);
+}
+
+int ExecuteHashText(const CefV8ValueList& arguments,
+                    CefRefPtr<CefV8Value>& retval,
+                    CefString& exception)
+{
+    if (arguments.size() != 2 || !arguments[0]->IsString() || !arguments[1]->IsString())
+        return ERR_INVALID_PARAMS;
+
+    std::string name;
+    GetUTF8StringValue(arguments[1], name);
+    HashAlgorithm algorithm;
+    if (!GetHashAlgorithm(name, algorithm))
+        return ERR_INVALID_PARAMS;
+
+    std::string text;
+    GetUTF8StringValue(arguments[0], text);
+    retval = CefV8Value::CreateString(HashData(algorithm, text.data(), text.size()));
+    return NO_ERROR;
+}
+
+int ExecuteGetHashCacheStats(const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception)
+{
+    if (arguments.size() != 0)
+        return ERR_INVALID_PARAMS;
+
+    HashCache::Stats stats = HashCache::GetInstance().GetStats();
+
+    retval = CefV8Value::CreateObject(NULL);
+    retval->SetValue("hits", CefV8Value::CreateDouble((double)stats.hits), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("misses", CefV8Value::CreateDouble((double)stats.misses), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("bypassed", CefV8Value::CreateDouble((double)stats.bypassed), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("bytes", CefV8Value::CreateDouble((double)stats.bytes), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("time", CefV8Value::CreateDouble(stats.microseconds / 1000.0), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("entries", CefV8Value::CreateDouble((double)stats.entries), V8_PROPERTY_ATTRIBUTE_NONE);
+    return NO_ERROR;
+}
+
+} // namespace FileSystem
+} // namespace Brackets
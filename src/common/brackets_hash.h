@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_HASH_H
+#define _BRACKETS_HASH_H
+
+#include "include/cef.h"
+#include "common/brackets_async.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_thread.h"
+
+#include <map>
+#include <string>
+
+namespace Brackets {
+namespace FileSystem {
+
+enum HashAlgorithm {
+    HASH_XXH3 = 0,      // XXH3, 64 bits, seed 0; fast, for change detection
+    HASH_SHA1,
+    HASH_SHA256
+};
+
+// Looks up an algorithm by the name JS uses for it: "xxh3", "sha1" or
+// "sha256". Returns false for any other name.
+bool GetHashAlgorithm(const std::string& name, HashAlgorithm& algorithm);
+
+/**
+ * Computes a digest a chunk at a time, so that a file can be hashed while it
+ * is read. All three algorithms work on 64-bit words where the algorithm
+ * allows it; digests are the same as those of xxhsum -H3, sha1sum and
+ * sha256sum, as lowercase hex.
+ */
+class Hasher
+{
+public:
+    static Hasher* Create(HashAlgorithm algorithm);
+
+    virtual ~Hasher() {}
+
+    virtual void Update(const char* data, size_t length) =0;
+
+    // Digest of everything fed so far, as hex. Call once, after the last
+    // Update.
+    virtual std::string Finish() =0;
+};
+
+// Digest of |length| bytes at |data|, as hex
+std::string HashData(HashAlgorithm algorithm, const char* data, size_t length);
+
+// XXH3 of |length| bytes at |data| as a number, for checksums that are
+// stored rather than shown
+unsigned long long HashXXH3(const char* data, size_t length);
+
+// Digest of part of a file, and what it took to get it
+struct FileHash {
+    FileHash() : offset(0), length(0), cached(false), microseconds(0) {}
+
+    std::string digest;
+    unsigned long long offset;  // of the bytes hashed
+    unsigned long long length;  // bytes hashed, less than asked for past the end of the file
+    FileInfo info;              // of the file when it was opened
+    bool cached;                // the digest came from the HashCache
+    long long microseconds;     // spent reading and hashing, 0 when cached
+};
+
+/**
+ * Remembers digests of files by the identity, size and modification time of
+ * the file (inode and device, or file index and volume on Windows), and the
+ * range and algorithm hashed. A file that hasn't changed since it was hashed
+ * is not read again, whatever path it is reached through; a file that was
+ * written, renamed over or replaced no longer matches its entry. Nothing
+ * needs to be told about changes, at the cost of an fstat per lookup.
+ *
+ * Like git's index, a digest is only kept when the file's modification time
+ * is a couple of seconds older than the hash, so that a file written again
+ * within the same tick of its clock, with the same size, can't be mistaken
+ * for the one that was hashed. Nor is it kept if the file changed while it
+ * was read, or when the file system has no file ids. Thread safe.
+ */
+class HashCache
+{
+public:
+    static HashCache& GetInstance();
+
+    // Hashes |length| bytes of |path| from |offset|, or up to the end of the
+    // file if |length| is kToEnd. With |bypass| the file is always read and
+    // the cache is left alone. Returns ERR_CANCELLED if |operation| is
+    // cancelled while the file is read.
+    int HashFile(const ExtensionString& path, HashAlgorithm algorithm, unsigned long long offset,
+                 unsigned long long length, bool bypass, FileHash& result,
+                 const AsyncOperation* operation = NULL);
+
+    static const unsigned long long kToEnd = ~0ULL;
+
+    struct Stats {
+        Stats() : hits(0), misses(0), bypassed(0), bytes(0), microseconds(0), entries(0) {}
+
+        unsigned long long hits;            // digests answered from the cache
+        unsigned long long misses;          // files that were read
+        unsigned long long bypassed;        // files read with |bypass| set
+        unsigned long long bytes;           // bytes read and hashed
+        long long microseconds;             // spent reading and hashing them
+        size_t entries;                     // digests cached now
+    };
+
+    Stats GetStats() const;
+
+private:
+    HashCache() {}
+
+    struct Key {
+        bool operator<(const Key& other) const;
+
+        FileId id;
+        unsigned long long size;
+        long long mtimeSec;
+        long mtimeNsec;
+        HashAlgorithm algorithm;
+        unsigned long long offset;
+        unsigned long long length;
+    };
+
+    int HashOpenFile(PlatformFile file, HashAlgorithm algorithm, unsigned long long offset,
+                     unsigned long long length, bool bypass, FileHash& result,
+                     const AsyncOperation* operation);
+
+    mutable Lock m_lock;
+    std::map<Key, std::string> m_digests;
+    Stats m_stats;
+
+    HashCache(const HashCache&);
+    HashCache& operator=(const HashCache&);
+};
+
+// Native functions for hashing, registered by brackets_fs_extension.cpp
+int ExecuteHashFileAsync(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception);
+int ExecuteHashFilesAsync(const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception);
+int ExecuteHashText(const CefV8ValueList& arguments,
+                    CefRefPtr<CefV8Value>& retval,
+                    CefString& exception);
+int ExecuteGetHashCacheStats(const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception);
+
+} // namespace FileSystem
+} // namespace Brackets
+
+#endif // _BRACKETS_HASH_H
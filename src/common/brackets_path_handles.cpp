@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_path_handles.h"
+#include "common/brackets_fs_extension.h"
+#include "common/brackets_stat_cache.h"
+
+namespace Brackets {
+
+///
+// PathHandleRegistry
+///
+PathHandleRegistry& PathHandleRegistry::GetInstance()
+{
+    static PathHandleRegistry instance;
+    return instance;
+}
+
+PathHandleRegistry::PathHandleRegistry() : m_handleCount(0)
+{
+}
+
+int PathHandleRegistry::Intern(const ExtensionString& path, CefRefPtr<CefV8Context> context)
+{
+    std::map<ExtensionString, int>::iterator it = m_byPath.find(path);
+    if (it != m_byPath.end() && m_entries[it->second - 1].context->IsSame(context))
+        return it->second;
+
+    // Another context's handle for the path stays valid, but is no longer
+    // the one lookups find
+    m_entries.push_back(Entry());
+    m_entries.back().path = path;
+    m_entries.back().context = context;
+    m_handleCount++;
+
+    int handle = (int)m_entries.size();
+    m_byPath[path] = handle;
+    return handle;
+}
+
+const ExtensionString* PathHandleRegistry::Get(int handle) const
+{
+    if (handle < 1 || (size_t)handle > m_entries.size() || !m_entries[handle - 1].context.get())
+        return NULL;
+    return &m_entries[handle - 1].path;
+}
+
+bool PathHandleRegistry::Release(int handle)
+{
+    if (!Get(handle))
+        return false;
+
+    Entry& entry = m_entries[handle - 1];
+    std::map<ExtensionString, int>::iterator it = m_byPath.find(entry.path);
+    if (it != m_byPath.end() && it->second == handle)
+        m_byPath.erase(it);
+    ExtensionString().swap(entry.path);
+    entry.context = NULL;
+    m_handleCount--;
+    return true;
+}
+
+void PathHandleRegistry::ReleaseContext(CefRefPtr<CefV8Context> context)
+{
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        if (m_entries[i].context.get() && m_entries[i].context->IsSame(context))
+            Release((int)i + 1);
+    }
+}
+
+namespace {
+
+using namespace FileSystem;
+
+// Splits |path| into the directory that holds it and its name, which keeps
+// a trailing '/'. Returns false for paths with no directory to split off.
+bool SplitPath(const ExtensionString& path, ExtensionString& directory, ExtensionString& name)
+{
+    if (path.length() < 2)
+        return false;
+    size_t slash = path.rfind('/', path.length() - 2);
+    if (slash == ExtensionString::npos)
+        return false;
+
+    directory.assign(path, 0, slash == 0 ? 1 : slash);
+    name.assign(path, slash + 1, ExtensionString::npos);
+    return true;
+}
+
+} // namespace
+
+int ExecuteInternPaths(const CefV8ValueList& arguments,
+                       CefRefPtr<CefV8Value>& retval,
+                       CefString& exception)
+{
+    if (arguments.size() != 1 || !arguments[0]->IsArray())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<CefV8Value> paths = arguments[0];
+    int count = paths->GetArrayLength();
+    std::vector<ExtensionString> converted(count);
+    for (int i = 0; i < count; i++) {
+        CefRefPtr<CefV8Value> path = paths->GetValue(i);
+        if (!path->IsString())
+            return ERR_INVALID_PARAMS;
+        GetPathValue(path, converted[i]);
+        if (converted[i].empty())
+            return ERR_INVALID_PARAMS;
+    }
+
+    PathHandleRegistry& registry = PathHandleRegistry::GetInstance();
+    CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+    retval = CefV8Value::CreateArray();
+    for (int i = 0; i < count; i++)
+        retval->SetValue(i, CefV8Value::CreateInt(registry.Intern(converted[i], context)));
+    return NO_ERROR;
+}
+
+int ExecuteReleasePathHandles(const CefV8ValueList& arguments,
+                              CefRefPtr<CefV8Value>& retval,
+                              CefString& exception)
+{
+    if (arguments.size() != 1 || !arguments[0]->IsArray())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<CefV8Value> handles = arguments[0];
+    int count = handles->GetArrayLength();
+    for (int i = 0; i < count; i++) {
+        if (!handles->GetValue(i)->IsInt())
+            return ERR_INVALID_PARAMS;
+    }
+
+    int released = 0;
+    for (int i = 0; i < count; i++) {
+        if (PathHandleRegistry::GetInstance().Release(handles->GetValue(i)->GetIntValue()))
+            released++;
+    }
+    retval = CefV8Value::CreateInt(released);
+    return NO_ERROR;
+}
+
+int ExecuteStatPaths(const CefV8ValueList& arguments,
+                     CefRefPtr<CefV8Value>& retval,
+                     CefString& exception)
+{
+    bool bypassCache = false;
+    if (arguments.size() < 1 || arguments.size() > 2 || !arguments[0]->IsArray())
+        return ERR_INVALID_PARAMS;
+    if (arguments.size() == 2) {
+        if (!arguments[1]->IsBool())
+            return ERR_INVALID_PARAMS;
+        bypassCache = arguments[1]->GetBoolValue();
+    }
+
+    CefRefPtr<CefV8Value> values = arguments[0];
+    int count = values->GetArrayLength();
+    std::vector<ExtensionString> storage(count);
+    std::vector<const ExtensionString*> paths(count);
+    for (int i = 0; i < count; i++) {
+        paths[i] = GetPathValue(values->GetValue(i), storage[i]);
+        if (!paths[i])
+            return ERR_INVALID_PARAMS;
+    }
+
+    std::vector<FileInfo> infos(count);
+    std::vector<int> errors(count);
+    StatCache& cache = StatCache::GetInstance();
+    if (!bypassCache && cache.GetStats().active) {
+        for (int i = 0; i < count; i++)
+            errors[i] = cache.GetFileInfo(*paths[i], infos[i], false);
+    } else {
+        // Runs of entries of the same directory, which is how lists of
+        // paths usually come, are stat'ed together; on Linux that looks the
+        // directory up once for the whole run
+        ExtensionString directory, name, runDirectory;
+        std::vector<int> run;
+        std::vector<ExtensionString> names;
+        std::vector<FileInfo> runInfos;
+        std::vector<int> runErrors;
+        for (int i = 0; i <= count; i++) {
+            bool split = i < count && SplitPath(*paths[i], directory, name);
+            if (!run.empty() && (!split || directory != runDirectory)) {
+                GetFileInfosAt(runDirectory, names, runInfos, runErrors);
+                for (size_t j = 0; j < run.size(); j++) {
+                    infos[run[j]] = runInfos[j];
+                    errors[run[j]] = runErrors[j];
+                }
+                run.clear();
+                names.clear();
+            }
+            if (i == count)
+                break;
+
+            if (!split) {
+                errors[i] = GetFileInfo(*paths[i], infos[i]);
+                continue;
+            }
+            if (run.empty())
+                runDirectory.swap(directory);
+            run.push_back(i);
+            names.push_back(name);
+        }
+    }
+
+    retval = CefV8Value::CreateArray();
+    for (int i = 0; i < count; i++) {
+        if (errors[i] != NO_ERROR) {
+            retval->SetValue(i, CefV8Value::CreateInt(errors[i]));
+        } else {
+            CefRefPtr<CefV8Value> info = CefV8Value::CreateObject(NULL);
+            SetFileInfoValues(info, infos[i]);
+            retval->SetValue(i, info);
+        }
+    }
+    return NO_ERROR;
+}
+
+} // namespace Brackets
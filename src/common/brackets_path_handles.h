@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_PATH_HANDLES_H
+#define _BRACKETS_PATH_HANDLES_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+
+#include <map>
+#include <vector>
+
+namespace Brackets {
+
+/**
+ * Paths JS has interned, by handle. The native functions that take a path
+ * also take its handle, which saves converting the path from a V8 string on
+ * every call: the path is converted once, when it is interned, and kept in
+ * the native string type of the platform.
+ *
+ * Interning the same path again from the same V8 context gives the same
+ * handle. Handles belong to the context that interned them and go away with
+ * it; they are not reused. UI thread only.
+ */
+class PathHandleRegistry
+{
+public:
+    static PathHandleRegistry& GetInstance();
+
+    // Returns the handle of |path|, which must not be empty
+    int Intern(const ExtensionString& path, CefRefPtr<CefV8Context> context);
+
+    // The path of |handle|, or NULL. It stays valid until the handle is
+    // released.
+    const ExtensionString* Get(int handle) const;
+
+    // Returns false if |handle| was not interned
+    bool Release(int handle);
+
+    // Releases every handle interned from |context|
+    void ReleaseContext(CefRefPtr<CefV8Context> context);
+
+    size_t GetHandleCount() const { return m_handleCount; }
+
+private:
+    PathHandleRegistry();
+
+    struct Entry {
+        ExtensionString path;
+        CefRefPtr<CefV8Context> context;    // NULL once released
+    };
+
+    // Handle h is m_entries[h - 1]
+    std::vector<Entry> m_entries;
+    size_t m_handleCount;
+
+    // The latest handle of each path
+    std::map<ExtensionString, int> m_byPath;
+};
+
+// Native functions for path handles, registered by brackets_fs_extension.cpp
+int ExecuteInternPaths(const CefV8ValueList& arguments,
+                       CefRefPtr<CefV8Value>& retval,
+                       CefString& exception);
+int ExecuteReleasePathHandles(const CefV8ValueList& arguments,
+                              CefRefPtr<CefV8Value>& retval,
+                              CefString& exception);
+int ExecuteStatPaths(const CefV8ValueList& arguments,
+                     CefRefPtr<CefV8Value>& retval,
+                     CefString& exception);
+
+} // namespace Brackets
+
+#endif // _BRACKETS_PATH_HANDLES_H
@@ -0,0 +1,723 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_path_matcher.h"
+#include "common/brackets_fs_extension.h"
+#include "common/brackets_path_store.h"
+
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+// What a matched character is worth, and what skipping characters costs
+const int kScoreMatch = 16;
+const int kGapStart = -3;
+const int kGapExtension = -1;
+
+// Bonuses for where a matched character is. The first character of the
+// query gets its bonus twice, so that it prefers the start of a word.
+const int kBonusSegment = 10;           // after '/', or the start of the path
+const int kBonusWord = 8;               // after '_', '-', '.' or a space
+const int kBonusCamel = 7;              // an upper case letter after a lower case one, or a digit after a letter
+const int kBonusConsecutive = 5;        // at least this right after the previous match
+const int kBonusFileName = 4;           // in the last segment
+const int kFirstCharMultiplier = 2;
+
+// Largest boost frecency gives, about what three well placed characters
+// are worth, and the opens after which it stops growing
+const int kMaxFrecencyBoost = 48;
+const int kMaxCountedOpens = 5;
+
+// Scores below this don't come from a match
+const int kNoMatch = -1000000000;
+const int kMinMatch = kNoMatch / 2;
+
+// Removed paths are dropped once there are this many and they are half of
+// the paths
+const size_t kMinCompaction = 1024;
+
+enum CharClass {
+    CLASS_SEPARATOR,
+    CLASS_DELIMITER,
+    CLASS_LOWER,
+    CLASS_UPPER,
+    CLASS_DIGIT,
+    CLASS_OTHER,
+};
+
+inline unsigned char FoldByte(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+inline CharClass GetCharClass(unsigned char c)
+{
+    if (c == '/' || c == '\\')
+        return CLASS_SEPARATOR;
+    if (c == '_' || c == '-' || c == '.' || c == ' ')
+        return CLASS_DELIMITER;
+    if (c >= 'a' && c <= 'z')
+        return CLASS_LOWER;
+    if (c >= 'A' && c <= 'Z')
+        return CLASS_UPPER;
+    if (c >= '0' && c <= '9')
+        return CLASS_DIGIT;
+    return CLASS_OTHER;
+}
+
+int GetBonus(CharClass previous, CharClass current)
+{
+    if (previous == CLASS_SEPARATOR)
+        return kBonusSegment;
+    if (previous == CLASS_DELIMITER && current != CLASS_DELIMITER && current != CLASS_SEPARATOR)
+        return kBonusWord;
+    if ((previous == CLASS_LOWER && current == CLASS_UPPER) ||
+        (previous != CLASS_DIGIT && current == CLASS_DIGIT))
+        return kBonusCamel;
+    return 0;
+}
+
+// Letters and digits have a bit each; other bytes share the rest
+inline unsigned long long GetCharBit(unsigned char c)
+{
+    c = FoldByte(c);
+    if (c >= 'a' && c <= 'z')
+        return 1ULL << (c - 'a');
+    if (c >= '0' && c <= '9')
+        return 1ULL << (26 + c - '0');
+    return 1ULL << (36 + c % 28);
+}
+
+unsigned long long GetMask(const char* text, size_t length)
+{
+    unsigned long long mask = 0;
+    for (size_t i = 0; i < length; i++)
+        mask |= GetCharBit((unsigned char)text[i]);
+    return mask;
+}
+
+unsigned int HashPath(const char* path, size_t length)
+{
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)path[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Turns the sorted byte offsets in |positions| into UTF-16 offsets
+void ToUTF16Positions(const char* text, size_t length, std::vector<int>& positions)
+{
+    int units = 0;
+    size_t next = 0;
+    for (size_t i = 0; i < length && next < positions.size(); i++) {
+        unsigned char c = (unsigned char)text[i];
+        if ((c & 0xC0) == 0x80)
+            continue;
+        if ((int)i == positions[next])
+            positions[next++] = units;
+        units += c >= 0xF0 ? 2 : 1;
+    }
+}
+
+} // namespace
+
+PathMatcher::PathMatcher()
+    : m_removed(0)
+{
+}
+
+int PathMatcher::FindEntry(const char* path, size_t length) const
+{
+    if (m_slots.empty())
+        return -1;
+
+    size_t mask = m_slots.size() - 1;
+    for (size_t slot = HashPath(path, length) & mask; m_slots[slot] != -1; slot = (slot + 1) & mask) {
+        const Entry& entry = m_entries[m_slots[slot]];
+        if (entry.length == length && memcmp(&m_arena[entry.offset], path, length) == 0)
+            return m_slots[slot];
+    }
+    return -1;
+}
+
+void PathMatcher::InsertSlot(unsigned int entry)
+{
+    if (m_entries.size() * 2 > m_slots.size()) {
+        RebuildSlots();
+        return;
+    }
+
+    size_t mask = m_slots.size() - 1;
+    size_t slot = HashPath(&m_arena[m_entries[entry].offset], m_entries[entry].length) & mask;
+    while (m_slots[slot] != -1)
+        slot = (slot + 1) & mask;
+    m_slots[slot] = (int)entry;
+}
+
+void PathMatcher::RebuildSlots()
+{
+    size_t size = 16;
+    while (size < m_entries.size() * 2)
+        size *= 2;
+    m_slots.assign(size, -1);
+
+    size_t mask = size - 1;
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        size_t slot = HashPath(&m_arena[m_entries[i].offset], m_entries[i].length) & mask;
+        while (m_slots[slot] != -1)
+            slot = (slot + 1) & mask;
+        m_slots[slot] = (int)i;
+    }
+}
+
+void PathMatcher::AddPaths(const std::vector<std::string>& paths)
+{
+    for (size_t i = 0; i < paths.size(); i++) {
+        const std::string& path = paths[i];
+        if (path.empty())
+            continue;
+
+        int found = FindEntry(path.data(), path.length());
+        if (found >= 0) {
+            if (m_entries[found].removed) {
+                m_entries[found].removed = false;
+                m_removed--;
+            }
+            continue;
+        }
+
+        Entry entry;
+        entry.offset = (unsigned int)m_arena.length();
+        entry.length = (unsigned int)path.length();
+        size_t slash = path.find_last_of("/\\");
+        entry.nameStart = slash == std::string::npos ? 0 : (unsigned int)slash + 1;
+        entry.removed = false;
+        std::map<std::string, int>::const_iterator opened = m_openIndex.find(path);
+        entry.opened = opened == m_openIndex.end() ? -1 : opened->second;
+
+        m_arena += path;
+        m_entries.push_back(entry);
+        m_masks.push_back(GetMask(path.data(), path.length()));
+        InsertSlot((unsigned int)m_entries.size() - 1);
+    }
+    m_steps.clear();
+}
+
+void PathMatcher::RemovePaths(const std::vector<std::string>& paths)
+{
+    for (size_t i = 0; i < paths.size(); i++) {
+        int found = FindEntry(paths[i].data(), paths[i].length());
+        if (found >= 0 && !m_entries[found].removed) {
+            m_entries[found].removed = true;
+            m_removed++;
+        }
+    }
+    m_steps.clear();
+
+    if (m_removed >= kMinCompaction && m_removed * 2 >= m_entries.size())
+        Compact();
+}
+
+void PathMatcher::Compact()
+{
+    std::string arena;
+    std::vector<Entry> entries;
+    std::vector<unsigned long long> masks;
+    arena.reserve(m_arena.length());
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        if (m_entries[i].removed)
+            continue;
+        Entry entry = m_entries[i];
+        entry.offset = (unsigned int)arena.length();
+        arena.append(m_arena, m_entries[i].offset, m_entries[i].length);
+        entries.push_back(entry);
+        masks.push_back(m_masks[i]);
+    }
+    m_arena.swap(arena);
+    m_entries.swap(entries);
+    m_masks.swap(masks);
+    m_removed = 0;
+    RebuildSlots();
+}
+
+void PathMatcher::RecordOpened(const std::string& path, double time)
+{
+    std::map<std::string, int>::iterator found = m_openIndex.find(path);
+    if (found == m_openIndex.end()) {
+        OpenRecord record;
+        record.path = path;
+        record.lastOpened = time;
+        record.count = 0;
+        m_opens.push_back(record);
+        found = m_openIndex.insert(std::make_pair(path, (int)m_opens.size() - 1)).first;
+
+        int entry = FindEntry(path.data(), path.length());
+        if (entry >= 0)
+            m_entries[entry].opened = found->second;
+    }
+
+    OpenRecord& record = m_opens[found->second];
+    record.count++;
+    record.lastOpened = std::max(record.lastOpened, time);
+}
+
+int PathMatcher::GetFrecencyBoost(int opened, double now) const
+{
+    if (opened < 0)
+        return 0;
+
+    // Recency in the buckets browsers use for their history
+    const OpenRecord& record = m_opens[opened];
+    double age = now - record.lastOpened;
+    int recency;
+    if (age < 4 * 3600)
+        recency = 100;
+    else if (age < 24 * 3600)
+        recency = 70;
+    else if (age < 7 * 24 * 3600)
+        recency = 50;
+    else if (age < 30 * 24 * 3600)
+        recency = 30;
+    else
+        recency = 10;
+
+    int count = std::min(record.count, kMaxCountedOpens);
+    return kMaxFrecencyBoost * recency * count / (100 * kMaxCountedOpens);
+}
+
+bool PathMatcher::Score(unsigned int entryIndex, const std::string& query, int& score, std::vector<int>* positions)
+{
+    const Entry& entry = m_entries[entryIndex];
+    const unsigned char* path = (const unsigned char*)&m_arena[entry.offset];
+    size_t length = entry.length;
+    size_t m = query.length();
+
+    // The leftmost match tells where the first character can be at the
+    // earliest, and whether there is a match at all; the last character
+    // can be no further than its last occurrence
+    size_t first = 0;
+    size_t j = 0;
+    for (size_t i = 0; i < m; i++) {
+        while (j < length && FoldByte(path[j]) != (unsigned char)query[i])
+            j++;
+        if (j == length)
+            return false;
+        if (i == 0)
+            first = j;
+        j++;
+    }
+    size_t last = length - 1;
+    while (FoldByte(path[last]) != (unsigned char)query[m - 1])
+        last--;
+
+    size_t width = last - first + 1;
+    m_bonuses.resize(width);
+    CharClass previous = first == 0 ? CLASS_SEPARATOR : GetCharClass(path[first - 1]);
+    for (size_t k = 0; k < width; k++) {
+        CharClass current = GetCharClass(path[first + k]);
+        m_bonuses[k] = GetBonus(previous, current) + (first + k >= entry.nameStart ? kBonusFileName : 0);
+        previous = current;
+    }
+
+    // scores[i][k] is the best score of the first i + 1 characters of the
+    // query with the last of them at first + k. Only two rows are kept
+    // unless the positions are wanted.
+    size_t rows = positions ? m : 2;
+    m_scores.resize(rows * width);
+    int* row = &m_scores[0];
+    for (size_t k = 0; k < width; k++) {
+        row[k] = FoldByte(path[first + k]) == (unsigned char)query[0]
+                 ? kScoreMatch + m_bonuses[k] * kFirstCharMultiplier : kNoMatch;
+    }
+
+    for (size_t i = 1; i < m; i++) {
+        const int* above = &m_scores[((i - 1) % rows) * width];
+        row = &m_scores[(i % rows) * width];
+        unsigned char c = (unsigned char)query[i];
+
+        // Best score of a match above that leaves a gap before column k
+        int gapBest = kNoMatch;
+        row[0] = kNoMatch;
+        for (size_t k = 1; k < width; k++) {
+            if (k >= 2)
+                gapBest = std::max(gapBest + kGapExtension, above[k - 2] + kGapStart);
+            if (FoldByte(path[first + k]) != c) {
+                row[k] = kNoMatch;
+                continue;
+            }
+            int best = kNoMatch;
+            if (above[k - 1] > kMinMatch)
+                best = above[k - 1] + kScoreMatch + std::max(m_bonuses[k], kBonusConsecutive);
+            if (gapBest > kMinMatch)
+                best = std::max(best, gapBest + kScoreMatch + m_bonuses[k]);
+            row[k] = best;
+        }
+    }
+
+    size_t end = 0;
+    score = kNoMatch;
+    for (size_t k = 0; k < width; k++) {
+        if (row[k] > score) {
+            score = row[k];
+            end = k;
+        }
+    }
+    if (score <= kMinMatch)
+        return false;
+
+    if (positions) {
+        // Walks back through the table the way the best score was made
+        positions->resize(m);
+        size_t k = end;
+        (*positions)[m - 1] = (int)(first + k);
+        for (size_t i = m - 1; i > 0; i--) {
+            const int* above = &m_scores[(i - 1) * width];
+            int current = m_scores[i * width + k];
+            if (k > 0 && above[k - 1] > kMinMatch &&
+                above[k - 1] + kScoreMatch + std::max(m_bonuses[k], kBonusConsecutive) == current) {
+                k--;
+            } else {
+                size_t from = k;
+                for (k = from - 2; ; k--) {
+                    if (above[k] > kMinMatch &&
+                        above[k] + kGapStart + (int)(from - k - 2) * kGapExtension + kScoreMatch + m_bonuses[from] == current)
+                        break;
+                }
+            }
+            (*positions)[i - 1] = (int)(first + k);
+        }
+    }
+    return true;
+}
+
+bool PathMatcher::IsBetter(const Candidate& a, const Candidate& b)
+{
+    if (a.score != b.score)
+        return a.score > b.score;
+    if (a.length != b.length)
+        return a.length < b.length;
+    return a.entry < b.entry;
+}
+
+void PathMatcher::AddCandidate(std::vector<Candidate>& heap, size_t maxResults, const Candidate& candidate) const
+{
+    // The heap has the worst candidate on top
+    if (heap.size() < maxResults) {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end(), IsBetter);
+    } else if (IsBetter(candidate, heap.front())) {
+        std::pop_heap(heap.begin(), heap.end(), IsBetter);
+        heap.back() = candidate;
+        std::push_heap(heap.begin(), heap.end(), IsBetter);
+    }
+}
+
+void PathMatcher::Match(const std::string& query, size_t maxResults, double now, std::vector<PathMatch>& results)
+{
+    results.clear();
+    if (maxResults == 0)
+        return;
+
+    std::string folded(query);
+    for (size_t i = 0; i < folded.length(); i++)
+        folded[i] = (char)FoldByte((unsigned char)folded[i]);
+
+    std::vector<Candidate> heap;
+    if (folded.empty()) {
+        for (size_t i = 0; i < m_opens.size(); i++) {
+            int found = FindEntry(m_opens[i].path.data(), m_opens[i].path.length());
+            if (found < 0 || m_entries[found].removed)
+                continue;
+            Candidate candidate;
+            candidate.score = GetFrecencyBoost((int)i, now);
+            candidate.length = m_entries[found].length;
+            candidate.entry = (unsigned int)found;
+            AddCandidate(heap, maxResults, candidate);
+        }
+    } else {
+        // Starts from the paths that matched the longest earlier query this
+        // one extends
+        size_t keep = 0;
+        while (keep < m_steps.size() && m_steps[keep].query.length() <= folded.length() &&
+               folded.compare(0, m_steps[keep].query.length(), m_steps[keep].query) == 0)
+            keep++;
+        m_steps.resize(keep);
+        bool known = keep > 0 && m_steps.back().query == folded;
+        if (!known) {
+            m_steps.push_back(Step());
+            m_steps.back().query = folded;
+        }
+        Step& step = m_steps.back();
+        const std::vector<unsigned int>* from = known ? &step.candidates : keep > 0 ? &m_steps[keep - 1].candidates : NULL;
+        size_t count = from ? from->size() : m_entries.size();
+
+        unsigned long long mask = GetMask(folded.data(), folded.length());
+        std::vector<unsigned int> matched;
+        for (size_t i = 0; i < count; i++) {
+            unsigned int entry = from ? (*from)[i] : (unsigned int)i;
+            if ((m_masks[entry] & mask) != mask || m_entries[entry].removed)
+                continue;
+
+            Candidate candidate;
+            if (!Score(entry, folded, candidate.score, NULL))
+                continue;
+            matched.push_back(entry);
+            candidate.score += GetFrecencyBoost(m_entries[entry].opened, now);
+            candidate.length = m_entries[entry].length;
+            candidate.entry = entry;
+            AddCandidate(heap, maxResults, candidate);
+        }
+        if (!known)
+            step.candidates.swap(matched);
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), IsBetter);
+    results.resize(heap.size());
+    for (size_t i = 0; i < heap.size(); i++) {
+        const Entry& entry = m_entries[heap[i].entry];
+        PathMatch& result = results[i];
+        result.path.assign(m_arena, entry.offset, entry.length);
+        result.score = heap[i].score;
+        if (!folded.empty()) {
+            int score;
+            Score(heap[i].entry, folded, score, &result.positions);
+            ToUTF16Positions(result.path.data(), result.path.length(), result.positions);
+        }
+    }
+}
+
+} // namespace FileSystem
+
+///
+// PathMatcherRegistry
+///
+PathMatcherRegistry& PathMatcherRegistry::GetInstance()
+{
+    static PathMatcherRegistry instance;
+    return instance;
+}
+
+PathMatcherRegistry::PathMatcherRegistry() : m_nextHandle(1)
+{
+}
+
+int PathMatcherRegistry::Add(CefRefPtr<FileSystem::PathMatcher> matcher, CefRefPtr<CefV8Context> context)
+{
+    int handle = m_nextHandle++;
+    Entry& entry = m_matchers[handle];
+    entry.matcher = matcher;
+    entry.context = context;
+    return handle;
+}
+
+CefRefPtr<FileSystem::PathMatcher> PathMatcherRegistry::Get(int handle) const
+{
+    std::map<int, Entry>::const_iterator it = m_matchers.find(handle);
+    if (it == m_matchers.end())
+        return NULL;
+    return it->second.matcher;
+}
+
+bool PathMatcherRegistry::Remove(int handle)
+{
+    return m_matchers.erase(handle) > 0;
+}
+
+void PathMatcherRegistry::ReleaseContext(CefRefPtr<CefV8Context> context)
+{
+    std::map<int, Entry>::iterator it = m_matchers.begin();
+    while (it != m_matchers.end()) {
+        if (it->second.context->IsSame(context))
+            m_matchers.erase(it++);
+        else
+            ++it;
+    }
+}
+
+namespace {
+
+using FileSystem::PathMatch;
+using FileSystem::PathMatcher;
+
+// Most results MatchPaths returns at once, and longest query it scores
+const int kMaxResults = 10000;
+const size_t kMaxQueryLength = 256;
+
+// Reads an array of strings as UTF-8
+bool GetPathsArgument(CefRefPtr<CefV8Value> value, std::vector<std::string>& paths)
+{
+    if (!value->IsArray())
+        return false;
+
+    int count = value->GetArrayLength();
+    paths.resize(count);
+    for (int i = 0; i < count; i++) {
+        CefRefPtr<CefV8Value> path = value->GetValue(i);
+        if (!path->IsString())
+            return false;
+        FileSystem::GetUTF8StringValue(path, paths[i]);
+    }
+    return true;
+}
+
+CefRefPtr<PathMatcher> GetMatcherArgument(CefRefPtr<CefV8Value> value)
+{
+    if (!value->IsInt())
+        return NULL;
+    return PathMatcherRegistry::GetInstance().Get(value->GetIntValue());
+}
+
+double GetCurrentTime()
+{
+    return (double)time(NULL);
+}
+
+} // namespace
+
+int ExecuteCreatePathMatcher(const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception)
+{
+    std::vector<std::string> paths;
+    if (arguments.size() == 2 && arguments[1]->IsInt()) {
+        // The files below a directory of a PathStore
+        CefRefPtr<FileSystem::PathStore> store;
+        if (arguments[0]->IsInt())
+            store = PathStoreRegistry::GetInstance().Get(arguments[0]->GetIntValue());
+        if (!store.get())
+            return ERR_INVALID_PARAMS;
+        if (!store->IsValid(arguments[1]->GetIntValue()))
+            return ERR_NOT_FOUND;
+
+        std::vector<int> files;
+        store->GetFiles(arguments[1]->GetIntValue(), files);
+        paths.resize(files.size());
+        for (size_t i = 0; i < files.size(); i++)
+            paths[i] = store->GetPath(files[i]);
+    } else if (arguments.size() != 1 || !GetPathsArgument(arguments[0], paths)) {
+        return ERR_INVALID_PARAMS;
+    }
+
+    CefRefPtr<PathMatcher> matcher = new PathMatcher();
+    matcher->AddPaths(paths);
+    int handle = PathMatcherRegistry::GetInstance().Add(matcher, CefV8Context::GetCurrentContext());
+    retval = CefV8Value::CreateInt(handle);
+    return NO_ERROR;
+}
+
+int ExecuteUpdatePathMatcher(const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception)
+{
+    std::vector<std::string> added, removed;
+    if (arguments.size() != 3 || !GetPathsArgument(arguments[1], added) || !GetPathsArgument(arguments[2], removed))
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<PathMatcher> matcher = GetMatcherArgument(arguments[0]);
+    if (!matcher.get())
+        return ERR_INVALID_PARAMS;
+
+    matcher->RemovePaths(removed);
+    matcher->AddPaths(added);
+    return NO_ERROR;
+}
+
+int ExecuteRecordPathOpened(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception)
+{
+    if (arguments.size() < 2 || arguments.size() > 3 || !arguments[1]->IsString())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<PathMatcher> matcher = GetMatcherArgument(arguments[0]);
+    if (!matcher.get())
+        return ERR_INVALID_PARAMS;
+
+    // Times come from JS in milliseconds, as Date.now() gives them
+    double time = GetCurrentTime();
+    if (arguments.size() == 3) {
+        if (!arguments[2]->IsInt() && !arguments[2]->IsDouble())
+            return ERR_INVALID_PARAMS;
+        time = arguments[2]->GetDoubleValue() / 1000;
+    }
+
+    std::string path;
+    FileSystem::GetUTF8StringValue(arguments[1], path);
+    matcher->RecordOpened(path, time);
+    return NO_ERROR;
+}
+
+int ExecuteMatchPaths(const CefV8ValueList& arguments,
+                      CefRefPtr<CefV8Value>& retval,
+                      CefString& exception)
+{
+    if (arguments.size() != 3 || !arguments[1]->IsString() || !arguments[2]->IsInt() ||
+        arguments[2]->GetIntValue() < 1 || arguments[2]->GetIntValue() > kMaxResults)
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<PathMatcher> matcher = GetMatcherArgument(arguments[0]);
+    if (!matcher.get())
+        return ERR_INVALID_PARAMS;
+
+    std::string query;
+    FileSystem::GetUTF8StringValue(arguments[1], query);
+    if (query.length() > kMaxQueryLength)
+        return ERR_INVALID_PARAMS;
+
+    std::vector<PathMatch> results;
+    matcher->Match(query, (size_t)arguments[2]->GetIntValue(), GetCurrentTime(), results);
+
+    retval = CefV8Value::CreateArray();
+    for (size_t i = 0; i < results.size(); i++) {
+        CefRefPtr<CefV8Value> positions = CefV8Value::CreateArray();
+        for (size_t j = 0; j < results[i].positions.size(); j++)
+            positions->SetValue((int)j, CefV8Value::CreateInt(results[i].positions[j]));
+
+        CefRefPtr<CefV8Value> result = CefV8Value::CreateObject(NULL);
+        result->SetValue("path", CefV8Value::CreateString(results[i].path), V8_PROPERTY_ATTRIBUTE_NONE);
+        result->SetValue("score", CefV8Value::CreateInt(results[i].score), V8_PROPERTY_ATTRIBUTE_NONE);
+        result->SetValue("matches", positions, V8_PROPERTY_ATTRIBUTE_NONE);
+        retval->SetValue((int)i, result);
+    }
+    return NO_ERROR;
+}
+
+int ExecuteClosePathMatcher(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception)
+{
+    if (arguments.size() != 1 || !arguments[0]->IsInt())
+        return ERR_INVALID_PARAMS;
+
+    retval = CefV8Value::CreateBool(PathMatcherRegistry::GetInstance().Remove(arguments[0]->GetIntValue()));
+    return NO_ERROR;
+}
+
+} // namespace Brackets
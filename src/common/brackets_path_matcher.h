@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_PATH_MATCHER_H
+#define _BRACKETS_PATH_MATCHER_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Brackets {
+namespace FileSystem {
+
+// One result of PathMatcher::Match
+struct PathMatch {
+    std::string path;               // UTF-8
+    int score;
+    std::vector<int> positions;     // of the matched characters, in UTF-16 code units
+};
+
+/**
+ * Scores the paths of a project against what the user types in Quick Open.
+ * A path matches when the query is a subsequence of it, ignoring ASCII
+ * case. Of the ways it can match, the best scoring one counts: characters
+ * at the start of a path segment, a word after '_', '-', '.' or a space, or
+ * a camelCase hump score more, as do runs of consecutive characters and
+ * characters in the file name; gaps cost a little. Paths opened recently
+ * and often get a boost on top.
+ *
+ * Paths live end to end in one string, each with a bitmask of the
+ * characters it has. Most paths are ruled out by comparing their mask with
+ * the query's, one word per path, before the scoring looks at any text.
+ * The paths that matched each prefix of the last query are kept, so typing
+ * one more character, or deleting one, only scores paths that could still
+ * match.
+ *
+ * Not thread safe; JS uses it from the UI thread.
+ */
+class PathMatcher : public CefBase
+{
+public:
+    PathMatcher();
+
+    // Paths are UTF-8. Adding a path that is there already, or removing one
+    // that isn't, does nothing.
+    void AddPaths(const std::vector<std::string>& paths);
+    void RemovePaths(const std::vector<std::string>& paths);
+
+    size_t GetPathCount() const { return m_entries.size() - m_removed; }
+
+    // Notes that |path| was opened at |time|, in seconds since the epoch.
+    // Opens are remembered for paths that are not there yet.
+    void RecordOpened(const std::string& path, double time);
+
+    // The |maxResults| best matches of the UTF-8 |query|, best first, with
+    // opens counted as of |now|. An empty query matches the paths that were
+    // opened, most recent and frequent first.
+    void Match(const std::string& query, size_t maxResults, double now, std::vector<PathMatch>& results);
+
+private:
+    struct Entry {
+        unsigned int offset;            // in m_arena
+        unsigned int length;
+        unsigned int nameStart;         // offset of the file name in the path
+        bool removed;
+        int opened;                     // index in m_opens, or -1
+    };
+
+    // When a path was opened, and how many times
+    struct OpenRecord {
+        std::string path;
+        double lastOpened;
+        int count;
+    };
+
+    // Paths that matched one query, for the next one that extends it
+    struct Step {
+        std::string query;              // folded
+        std::vector<unsigned int> candidates;
+    };
+
+    // Ranked results while they are collected
+    struct Candidate {
+        int score;
+        unsigned int length;
+        unsigned int entry;
+    };
+
+    int FindEntry(const char* path, size_t length) const;
+    void InsertSlot(unsigned int entry);
+    void RebuildSlots();
+
+    // Drops removed paths once they are half of the entries
+    void Compact();
+
+    // Boost for the open record |opened| as of |now|
+    int GetFrecencyBoost(int opened, double now) const;
+
+    // Scores m_entries[entry] against |query|, folded. Returns false if
+    // the query is not a subsequence of it. |positions|, if not NULL, gets
+    // the byte offsets of the best match.
+    bool Score(unsigned int entry, const std::string& query, int& score, std::vector<int>* positions);
+
+    // Higher scores first, then shorter paths, then earlier ones
+    static bool IsBetter(const Candidate& a, const Candidate& b);
+
+    void AddCandidate(std::vector<Candidate>& heap, size_t maxResults, const Candidate& candidate) const;
+
+    std::string m_arena;
+    std::vector<Entry> m_entries;
+    std::vector<unsigned long long> m_masks;        // one per entry
+    std::vector<int> m_slots;                       // hash table of entries, -1 when empty
+    size_t m_removed;
+
+    std::vector<OpenRecord> m_opens;
+    std::map<std::string, int> m_openIndex;
+
+    std::vector<Step> m_steps;
+
+    // The scoring table and the bonus of each column, reused from path to
+    // path
+    std::vector<int> m_scores;
+    std::vector<int> m_bonuses;
+
+    IMPLEMENT_REFCOUNTING(PathMatcher);
+};
+
+} // namespace FileSystem
+
+/**
+ * The PathMatchers JS has made, by handle. They belong to the V8 context
+ * that made them and go away with it. UI thread only.
+ */
+class PathMatcherRegistry
+{
+public:
+    static PathMatcherRegistry& GetInstance();
+
+    // Registers |matcher| and returns its handle
+    int Add(CefRefPtr<FileSystem::PathMatcher> matcher, CefRefPtr<CefV8Context> context);
+
+    // Returns the matcher for |handle|, or NULL
+    CefRefPtr<FileSystem::PathMatcher> Get(int handle) const;
+
+    // Returns false if |handle| was not registered
+    bool Remove(int handle);
+
+    // Removes every matcher made from |context|
+    void ReleaseContext(CefRefPtr<CefV8Context> context);
+
+private:
+    PathMatcherRegistry();
+
+    struct Entry {
+        CefRefPtr<FileSystem::PathMatcher> matcher;
+        CefRefPtr<CefV8Context> context;
+    };
+
+    std::map<int, Entry> m_matchers;
+    int m_nextHandle;
+};
+
+// Native functions for Quick Open, registered by brackets_fs_extension.cpp
+int ExecuteCreatePathMatcher(const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception);
+int ExecuteUpdatePathMatcher(const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception);
+int ExecuteRecordPathOpened(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception);
+int ExecuteMatchPaths(const CefV8ValueList& arguments,
+                      CefRefPtr<CefV8Value>& retval,
+                      CefString& exception);
+int ExecuteClosePathMatcher(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception);
+
+} // namespace Brackets
+
+#endif // _BRACKETS_PATH_MATCHER_H
@@ -0,0 +1,834 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_path_store.h"
+#include "common/brackets_async.h"
+#include "common/brackets_fs_extension.h"
+#include "common/brackets_walker.h"
+
+#include <string.h>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+// Hash tables are kept at most half full
+const size_t kMinSlots = 64;
+
+unsigned int HashName(const char* name, size_t length)
+{
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+unsigned int HashChild(int parent, unsigned int name)
+{
+    unsigned int hash = (unsigned int)parent * 0x9E3779B1u ^ name * 0x85EBCA6Bu;
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+} // namespace
+
+PathStore::PathStore() : m_removed(0), m_childSlotsUsed(0)
+{
+    m_nameOffsets.push_back(0);
+    m_nameSlots.assign(kMinSlots, -1);
+    m_childSlots.assign(kMinSlots, -1);
+
+    // The root has the empty name, which "/a" also uses for its first
+    // segment; that is fine, as the root is never anyone's child
+    Node root = { AddName("", 0), NODE_DIRECTORY, -1, -1, -1 };
+    m_nodes.push_back(root);
+}
+
+int PathStore::FindName(const char* name, size_t length) const
+{
+    size_t mask = m_nameSlots.size() - 1;
+    for (size_t slot = HashName(name, length) & mask; ; slot = (slot + 1) & mask) {
+        int index = m_nameSlots[slot];
+        if (index < 0)
+            return -1;
+        unsigned int offset = m_nameOffsets[index];
+        if (m_nameOffsets[index + 1] - offset == length && !memcmp(m_names.data() + offset, name, length))
+            return index;
+    }
+}
+
+unsigned int PathStore::AddName(const char* name, size_t length)
+{
+    int index = FindName(name, length);
+    if (index >= 0)
+        return (unsigned int)index;
+
+    index = (int)m_nameOffsets.size() - 1;
+    m_names.append(name, length);
+    m_nameOffsets.push_back((unsigned int)m_names.length());
+    if ((size_t)index * 2 >= m_nameSlots.size())
+        RebuildNameSlots(m_nameSlots.size() * 2);
+    else {
+        size_t mask = m_nameSlots.size() - 1;
+        size_t slot = HashName(name, length) & mask;
+        while (m_nameSlots[slot] >= 0)
+            slot = (slot + 1) & mask;
+        m_nameSlots[slot] = index;
+    }
+    return (unsigned int)index;
+}
+
+void PathStore::RebuildNameSlots(size_t size)
+{
+    m_nameSlots.assign(size, -1);
+    size_t mask = size - 1;
+    for (size_t i = 0; i + 1 < m_nameOffsets.size(); i++) {
+        unsigned int offset = m_nameOffsets[i];
+        size_t slot = HashName(m_names.data() + offset, m_nameOffsets[i + 1] - offset) & mask;
+        while (m_nameSlots[slot] >= 0)
+            slot = (slot + 1) & mask;
+        m_nameSlots[slot] = (int)i;
+    }
+}
+
+int PathStore::FindChild(int parent, unsigned int name) const
+{
+    size_t mask = m_childSlots.size() - 1;
+    for (size_t slot = HashChild(parent, name) & mask; ; slot = (slot + 1) & mask) {
+        int node = m_childSlots[slot];
+        if (node == -1)
+            return -1;
+        if (node >= 0 && m_nodes[node].parent == parent && m_nodes[node].name == name)
+            return node;
+    }
+}
+
+void PathStore::InsertChild(int node)
+{
+    if ((m_childSlotsUsed + 1) * 2 > m_childSlots.size()) {
+        // Erased slots are dropped on the way; grow only if the live
+        // children need it
+        size_t live = m_nodes.size() - m_removed;
+        size_t size = m_childSlots.size();
+        while ((live + 1) * 2 > size)
+            size *= 2;
+        RebuildChildSlots(size);
+    }
+
+    size_t mask = m_childSlots.size() - 1;
+    size_t slot = HashChild(m_nodes[node].parent, m_nodes[node].name) & mask;
+    while (m_childSlots[slot] != -1)
+        slot = (slot + 1) & mask;
+    m_childSlots[slot] = node;
+    m_childSlotsUsed++;
+}
+
+void PathStore::EraseChild(int node)
+{
+    size_t mask = m_childSlots.size() - 1;
+    for (size_t slot = HashChild(m_nodes[node].parent, m_nodes[node].name) & mask; ; slot = (slot + 1) & mask) {
+        if (m_childSlots[slot] == node) {
+            m_childSlots[slot] = -2;
+            return;
+        }
+    }
+}
+
+void PathStore::RebuildChildSlots(size_t size)
+{
+    m_childSlots.assign(size, -1);
+    m_childSlotsUsed = 0;
+    size_t mask = size - 1;
+    for (size_t i = 1; i < m_nodes.size(); i++) {
+        if (m_nodes[i].flags & NODE_REMOVED)
+            continue;
+        size_t slot = HashChild(m_nodes[i].parent, m_nodes[i].name) & mask;
+        while (m_childSlots[slot] != -1)
+            slot = (slot + 1) & mask;
+        m_childSlots[slot] = (int)i;
+        m_childSlotsUsed++;
+    }
+}
+
+int PathStore::Add(const std::string& path)
+{
+    AutoLock lock(m_lock);
+    return AddLocked(path);
+}
+
+void PathStore::Add(const std::vector<std::string>& paths, std::vector<int>& ids)
+{
+    AutoLock lock(m_lock);
+    ids.resize(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+        ids[i] = AddLocked(paths[i]);
+}
+
+int PathStore::AddLocked(const std::string& path)
+{
+    if (path.empty())
+        return -1;
+
+    // "/" alone is the "" segment; any other trailing '/' only says that
+    // the path is a directory
+    size_t end = path.length();
+    bool isDirectory = false;
+    if (end > 1 && path[end - 1] == '/') {
+        end--;
+        isDirectory = true;
+    } else if (end == 1 && path[0] == '/') {
+        end = 0;
+        isDirectory = true;
+    }
+
+    int node = kRootId;
+    size_t start = 0;
+    for (;;) {
+        size_t slash = path.find('/', start);
+        if (slash == std::string::npos || slash > end)
+            slash = end;
+        bool last = slash == end;
+
+        unsigned int name = AddName(path.data() + start, slash - start);
+        int child = FindChild(node, name);
+        if (child < 0) {
+            child = (int)m_nodes.size();
+            Node added = { name, 0, node, -1, m_nodes[node].firstChild };
+            m_nodes.push_back(added);
+            m_nodes[node].firstChild = child;
+            InsertChild(child);
+        }
+        if (!last || isDirectory)
+            m_nodes[child].flags |= NODE_DIRECTORY;
+        node = child;
+
+        if (last)
+            return node;
+        start = slash + 1;
+    }
+}
+
+int PathStore::Find(const std::string& path) const
+{
+    AutoLock lock(m_lock);
+    return FindLocked(path);
+}
+
+int PathStore::FindLocked(const std::string& path) const
+{
+    if (path.empty())
+        return -1;
+
+    size_t end = path.length();
+    if (end > 1 && path[end - 1] == '/')
+        end--;
+    else if (end == 1 && path[0] == '/')
+        end = 0;
+
+    int node = kRootId;
+    size_t start = 0;
+    for (;;) {
+        size_t slash = path.find('/', start);
+        if (slash == std::string::npos || slash > end)
+            slash = end;
+
+        int name = FindName(path.data() + start, slash - start);
+        if (name < 0)
+            return -1;
+        node = FindChild(node, (unsigned int)name);
+        if (node < 0 || slash == end)
+            return node;
+        start = slash + 1;
+    }
+}
+
+size_t PathStore::Remove(int id)
+{
+    AutoLock lock(m_lock);
+    if (id <= kRootId || (size_t)id >= m_nodes.size() || (m_nodes[id].flags & NODE_REMOVED))
+        return 0;
+
+    // Unlink it from its parent, then mark everything below it
+    Node& parent = m_nodes[m_nodes[id].parent];
+    if (parent.firstChild == id) {
+        parent.firstChild = m_nodes[id].nextSibling;
+    } else {
+        int sibling = parent.firstChild;
+        while (m_nodes[sibling].nextSibling != id)
+            sibling = m_nodes[sibling].nextSibling;
+        m_nodes[sibling].nextSibling = m_nodes[id].nextSibling;
+    }
+
+    size_t removed = 0;
+    std::vector<int> pending(1, id);
+    while (!pending.empty()) {
+        int node = pending.back();
+        pending.pop_back();
+        for (int child = m_nodes[node].firstChild; child >= 0; child = m_nodes[child].nextSibling)
+            pending.push_back(child);
+
+        EraseChild(node);
+        m_nodes[node].flags |= NODE_REMOVED;
+        m_nodes[node].firstChild = -1;
+        m_nodes[node].nextSibling = -1;
+        removed++;
+    }
+    m_removed += removed;
+    return removed;
+}
+
+bool PathStore::IsValid(int id) const
+{
+    AutoLock lock(m_lock);
+    return id >= 0 && (size_t)id < m_nodes.size() && !(m_nodes[id].flags & NODE_REMOVED);
+}
+
+bool PathStore::IsDirectory(int id) const
+{
+    AutoLock lock(m_lock);
+    return id >= 0 && (size_t)id < m_nodes.size() &&
+           (m_nodes[id].flags & (NODE_DIRECTORY | NODE_REMOVED)) == NODE_DIRECTORY;
+}
+
+std::string PathStore::GetPath(int id) const
+{
+    AutoLock lock(m_lock);
+    std::string path;
+    if (id <= kRootId || (size_t)id >= m_nodes.size() || (m_nodes[id].flags & NODE_REMOVED))
+        return path;
+
+    // Measure first, then fill in from the end
+    size_t length = 0;
+    for (int node = id; node != kRootId; node = m_nodes[node].parent) {
+        unsigned int name = m_nodes[node].name;
+        length += m_nameOffsets[name + 1] - m_nameOffsets[name] + 1;
+    }
+    bool isDirectory = (m_nodes[id].flags & NODE_DIRECTORY) != 0;
+    path.resize(length - 1 + (isDirectory ? 1 : 0));
+
+    size_t end = length - 1;
+    if (isDirectory)
+        path[end] = '/';
+    for (int node = id; node != kRootId; node = m_nodes[node].parent) {
+        unsigned int name = m_nodes[node].name;
+        unsigned int nameLength = m_nameOffsets[name + 1] - m_nameOffsets[name];
+        end -= nameLength;
+        memcpy(&path[0] + end, m_names.data() + m_nameOffsets[name], nameLength);
+        if (end > 0)
+            path[--end] = '/';
+    }
+    return path;
+}
+
+std::string PathStore::GetName(int id) const
+{
+    AutoLock lock(m_lock);
+    if (id <= kRootId || (size_t)id >= m_nodes.size() || (m_nodes[id].flags & NODE_REMOVED))
+        return std::string();
+    unsigned int name = m_nodes[id].name;
+    return m_names.substr(m_nameOffsets[name], m_nameOffsets[name + 1] - m_nameOffsets[name]);
+}
+
+int PathStore::GetParent(int id) const
+{
+    AutoLock lock(m_lock);
+    if (id <= kRootId || (size_t)id >= m_nodes.size() || (m_nodes[id].flags & NODE_REMOVED))
+        return -1;
+    return m_nodes[id].parent;
+}
+
+void PathStore::GetChildren(int id, std::vector<int>& children) const
+{
+    AutoLock lock(m_lock);
+    children.clear();
+    if (id < 0 || (size_t)id >= m_nodes.size())
+        return;
+    for (int child = m_nodes[id].firstChild; child >= 0; child = m_nodes[child].nextSibling)
+        children.push_back(child);
+}
+
+void PathStore::GetFiles(int id, std::vector<int>& files) const
+{
+    AutoLock lock(m_lock);
+    files.clear();
+    if (id < 0 || (size_t)id >= m_nodes.size() || (m_nodes[id].flags & NODE_REMOVED))
+        return;
+
+    std::vector<int> pending(1, id);
+    while (!pending.empty()) {
+        int node = pending.back();
+        pending.pop_back();
+        if (!(m_nodes[node].flags & NODE_DIRECTORY))
+            files.push_back(node);
+        for (int child = m_nodes[node].firstChild; child >= 0; child = m_nodes[child].nextSibling)
+            pending.push_back(child);
+    }
+}
+
+size_t PathStore::GetPathCount() const
+{
+    AutoLock lock(m_lock);
+    return m_nodes.size() - m_removed - 1;
+}
+
+size_t PathStore::GetNameCount() const
+{
+    AutoLock lock(m_lock);
+    return m_nameOffsets.size() - 1;
+}
+
+size_t PathStore::GetMemoryUsage() const
+{
+    AutoLock lock(m_lock);
+    return sizeof(*this) +
+           m_nodes.capacity() * sizeof(Node) +
+           m_names.capacity() +
+           m_nameOffsets.capacity() * sizeof(unsigned int) +
+           m_nameSlots.capacity() * sizeof(int) +
+           m_childSlots.capacity() * sizeof(int);
+}
+
+} // namespace FileSystem
+
+///
+// PathStoreRegistry
+///
+PathStoreRegistry& PathStoreRegistry::GetInstance()
+{
+    static PathStoreRegistry instance;
+    return instance;
+}
+
+PathStoreRegistry::PathStoreRegistry() : m_nextHandle(1)
+{
+}
+
+int PathStoreRegistry::Add(CefRefPtr<FileSystem::PathStore> store, CefRefPtr<CefV8Context> context)
+{
+    int handle = m_nextHandle++;
+    Entry& entry = m_stores[handle];
+    entry.store = store;
+    entry.context = context;
+    return handle;
+}
+
+CefRefPtr<FileSystem::PathStore> PathStoreRegistry::Get(int handle) const
+{
+    std::map<int, Entry>::const_iterator it = m_stores.find(handle);
+    if (it == m_stores.end())
+        return NULL;
+    return it->second.store;
+}
+
+bool PathStoreRegistry::Remove(int handle)
+{
+    return m_stores.erase(handle) > 0;
+}
+
+void PathStoreRegistry::ReleaseContext(CefRefPtr<CefV8Context> context)
+{
+    std::map<int, Entry>::iterator it = m_stores.begin();
+    while (it != m_stores.end()) {
+        if (it->second.context->IsSame(context))
+            m_stores.erase(it++);
+        else
+            ++it;
+    }
+}
+
+namespace {
+
+using namespace FileSystem;
+
+// How often LoadPathStoreAsync reports progress
+const int kLoadProgressDelayMs = 100;
+
+CefRefPtr<PathStore> GetStoreArgument(CefRefPtr<CefV8Value> value)
+{
+    if (!value->IsInt())
+        return NULL;
+    return PathStoreRegistry::GetInstance().Get(value->GetIntValue());
+}
+
+// Reads an array of strings as UTF-8
+bool GetPathsArgument(CefRefPtr<CefV8Value> value, std::vector<std::string>& paths)
+{
+    if (!value->IsArray())
+        return false;
+
+    int count = value->GetArrayLength();
+    paths.resize(count);
+    for (int i = 0; i < count; i++) {
+        CefRefPtr<CefV8Value> path = value->GetValue(i);
+        if (!path->IsString())
+            return false;
+        GetUTF8StringValue(path, paths[i]);
+    }
+    return true;
+}
+
+bool GetIdsArgument(CefRefPtr<CefV8Value> value, std::vector<int>& ids)
+{
+    if (!value->IsArray())
+        return false;
+
+    int count = value->GetArrayLength();
+    ids.resize(count);
+    for (int i = 0; i < count; i++) {
+        CefRefPtr<CefV8Value> id = value->GetValue(i);
+        if (!id->IsInt())
+            return false;
+        ids[i] = id->GetIntValue();
+    }
+    return true;
+}
+
+CefRefPtr<CefV8Value> CreateIdArray(const std::vector<int>& ids)
+{
+    CefRefPtr<CefV8Value> array = CefV8Value::CreateArray();
+    for (size_t i = 0; i < ids.size(); i++)
+        array->SetValue((int)i, CefV8Value::CreateInt(ids[i]));
+    return array;
+}
+
+std::string ToUTF8(const ExtensionString& path)
+{
+#if defined(OS_WIN)
+    return CefString(path).ToString();
+#else
+    return path;
+#endif
+}
+
+/**
+ * Walks a directory into a PathStore. Each directory's entries are added
+ * under one lock, so JS can read the store while it fills.
+ */
+class LoadPathStoreOperation : public AsyncOperation, public WalkSink
+{
+public:
+    LoadPathStoreOperation(CefRefPtr<PathStore> store, const ExtensionString& root,
+                           const WalkOptions& walkOptions)
+        : m_store(store), m_root(root), m_walkOptions(walkOptions), m_rootId(-1),
+          m_files(0), m_directories(0), m_reported(0)
+    {
+    }
+
+    // WalkSink
+    virtual void AddEntries(size_t root, std::vector<DirEntry>& entries);
+    virtual bool IsCancelled() const { return AsyncOperation::IsCancelled(); }
+
+    // progress(paths)
+    virtual bool TakeProgress(CefV8ValueList& arguments);
+
+    virtual CefRefPtr<CefV8Value> GetResult();
+
+protected:
+    virtual int Run();
+
+private:
+    CefRefPtr<PathStore> m_store;
+    ExtensionString m_root;
+    WalkOptions m_walkOptions;
+    std::string m_rootPath;             // UTF-8, with a trailing '/'
+    int m_rootId;
+
+    Lock m_progressLock;
+    size_t m_files;
+    size_t m_directories;
+    size_t m_reported;                  // paths at the last progress call
+};
+
+void LoadPathStoreOperation::AddEntries(size_t root, std::vector<DirEntry>& entries)
+{
+    size_t files = 0;
+    std::vector<std::string> paths(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        paths[i] = m_rootPath;
+        paths[i] += ToUTF8(entries[i].name);
+        if (entries[i].info.isDirectory)
+            paths[i] += '/';
+        else
+            files++;
+    }
+
+    std::vector<int> ids;
+    m_store->Add(paths, ids);
+
+    {
+        AutoLock lock(m_progressLock);
+        m_files += files;
+        m_directories += entries.size() - files;
+    }
+    PostProgress(kLoadProgressDelayMs);
+}
+
+int LoadPathStoreOperation::Run()
+{
+    FileInfo info;
+    int error = GetFileInfo(m_root, info);
+    if (error != NO_ERROR)
+        return error;
+    if (!info.isDirectory)
+        return ERR_NOT_DIRECTORY;
+
+    m_rootPath = ToUTF8(m_root);
+    if (m_rootPath.empty() || m_rootPath[m_rootPath.length() - 1] != '/')
+        m_rootPath += '/';
+    m_rootId = m_store->Add(m_rootPath);
+
+    std::vector<ExtensionString> roots(1, m_root);
+    WalkStats stats;
+    error = WalkTree(roots, m_walkOptions, *this, stats);
+    if (error != NO_ERROR)
+        return error;
+    return stats.rootErrors[0];
+}
+
+bool LoadPathStoreOperation::TakeProgress(CefV8ValueList& arguments)
+{
+    size_t paths;
+    {
+        AutoLock lock(m_progressLock);
+        paths = m_files + m_directories;
+        if (paths == m_reported)
+            return false;
+        m_reported = paths;
+    }
+    arguments.push_back(CefV8Value::CreateDouble((double)paths));
+    return true;
+}
+
+CefRefPtr<CefV8Value> LoadPathStoreOperation::GetResult()
+{
+    CefRefPtr<CefV8Value> result = CefV8Value::CreateObject(NULL);
+    result->SetValue("id", CefV8Value::CreateInt(m_rootId), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("files", CefV8Value::CreateDouble((double)m_files), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("directories", CefV8Value::CreateDouble((double)m_directories), V8_PROPERTY_ATTRIBUTE_NONE);
+    return result;
+}
+
+} // namespace
+
+int ExecuteCreatePathStore(const CefV8ValueList& arguments,
+                           CefRefPtr<CefV8Value>& retval,
+                           CefString& exception)
+{
+    if (arguments.size() != 0)
+        return ERR_INVALID_PARAMS;
+
+    int handle = PathStoreRegistry::GetInstance().Add(new PathStore(), CefV8Context::GetCurrentContext());
+    retval = CefV8Value::CreateInt(handle);
+    return NO_ERROR;
+}
+
+int ExecuteAddStorePaths(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+{
+    std::vector<std::string> paths;
+    if (arguments.size() != 2 || !GetPathsArgument(arguments[1], paths))
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<PathStore> store = GetStoreArgument(arguments[0]);
+    if (!store.get())
+        return ERR_INVALID_PARAMS;
+
+    std::vector<int> ids;
+    store->Add(paths, ids);
+    retval = CreateIdArray(ids);
+    return NO_ERROR;
+}
+
+int ExecuteRemoveStorePaths(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception)
+{
+    std::vector<int> ids;
+    if (arguments.size() != 2 || !GetIdsArgument(arguments[1], ids))
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<PathStore> store = GetStoreArgument(arguments[0]);
+    if (!store.get())
+        return ERR_INVALID_PARAMS;
+
+    size_t removed = 0;
+    for (size_t i = 0; i < ids.size(); i++)
+        removed += store->Remove(ids[i]);
+    retval = CefV8Value::CreateDouble((double)removed);
+    return NO_ERROR;
+}
+
+int ExecuteFindStorePaths(const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception)
+{
+    std::vector<std::string> paths;
+    if (arguments.size() != 2 || !GetPathsArgument(arguments[1], paths))
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<PathStore> store = GetStoreArgument(arguments[0]);
+    if (!store.get())
+        return ERR_INVALID_PARAMS;
+
+    std::vector<int> ids(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+        ids[i] = store->Find(paths[i]);
+    retval = CreateIdArray(ids);
+    return NO_ERROR;
+}
+
+int ExecuteGetStorePaths(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+{
+    std::vector<int> ids;
+    if (arguments.size() != 2 || !GetIdsArgument(arguments[1], ids))
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<PathStore> store = GetStoreArgument(arguments[0]);
+    if (!store.get())
+        return ERR_INVALID_PARAMS;
+
+    retval = CefV8Value::CreateArray();
+    for (size_t i = 0; i < ids.size(); i++)
+        retval->SetValue((int)i, CefV8Value::CreateString(store->GetPath(ids[i])));
+    return NO_ERROR;
+}
+
+int ExecuteListStoreChildren(const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception)
+{
+    if (arguments.size() != 2 || !arguments[1]->IsInt())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<PathStore> store = GetStoreArgument(arguments[0]);
+    if (!store.get())
+        return ERR_INVALID_PARAMS;
+
+    int id = arguments[1]->GetIntValue();
+    if (!store->IsValid(id))
+        return ERR_NOT_FOUND;
+
+    std::vector<int> children;
+    store->GetChildren(id, children);
+
+    // Directory names end with '/', like their paths
+    CefRefPtr<CefV8Value> names = CefV8Value::CreateArray();
+    for (size_t i = 0; i < children.size(); i++) {
+        std::string name = store->GetName(children[i]);
+        if (store->IsDirectory(children[i]))
+            name += '/';
+        names->SetValue((int)i, CefV8Value::CreateString(name));
+    }
+
+    retval = CefV8Value::CreateObject(NULL);
+    retval->SetValue("ids", CreateIdArray(children), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("names", names, V8_PROPERTY_ATTRIBUTE_NONE);
+    return NO_ERROR;
+}
+
+int ExecuteListStoreFiles(const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception)
+{
+    if (arguments.size() != 2 || !arguments[1]->IsInt())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<PathStore> store = GetStoreArgument(arguments[0]);
+    if (!store.get())
+        return ERR_INVALID_PARAMS;
+
+    int id = arguments[1]->GetIntValue();
+    if (!store->IsValid(id))
+        return ERR_NOT_FOUND;
+
+    std::vector<int> files;
+    store->GetFiles(id, files);
+    retval = CreateIdArray(files);
+    return NO_ERROR;
+}
+
+int ExecuteGetPathStoreStats(const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception)
+{
+    if (arguments.size() != 1)
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<PathStore> store = GetStoreArgument(arguments[0]);
+    if (!store.get())
+        return ERR_INVALID_PARAMS;
+
+    retval = CefV8Value::CreateObject(NULL);
+    retval->SetValue("paths", CefV8Value::CreateDouble((double)store->GetPathCount()), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("names", CefV8Value::CreateDouble((double)store->GetNameCount()), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("bytes", CefV8Value::CreateDouble((double)store->GetMemoryUsage()), V8_PROPERTY_ATTRIBUTE_NONE);
+    return NO_ERROR;
+}
+
+int ExecuteLoadPathStoreAsync(const CefV8ValueList& arguments,
+                              CefRefPtr<CefV8Value>& retval,
+                              CefString& exception)
+{
+    if (arguments.size() < 5 || !arguments[1]->IsString())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<PathStore> store = GetStoreArgument(arguments[0]);
+    if (!store.get())
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString root = arguments[1]->GetStringValue();
+    while (root.length() > 1 && root[root.length() - 1] == '/')
+        root.erase(root.length() - 1);
+    if (root.empty())
+        return ERR_INVALID_PARAMS;
+
+    WalkOptions walkOptions;
+    if (!GetWalkOptions(arguments[2], walkOptions))
+        return ERR_INVALID_PARAMS;
+    walkOptions.withStats = false;
+
+    CefRefPtr<AsyncOperation> operation = new LoadPathStoreOperation(store, root, walkOptions);
+    return operation->Start(arguments, 3, 4, retval);
+}
+
+int ExecuteClosePathStore(const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception)
+{
+    if (arguments.size() != 1 || !arguments[0]->IsInt())
+        return ERR_INVALID_PARAMS;
+
+    retval = CefV8Value::CreateBool(PathStoreRegistry::GetInstance().Remove(arguments[0]->GetIntValue()));
+    return NO_ERROR;
+}
+
+} // namespace Brackets
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_PATH_STORE_H
+#define _BRACKETS_PATH_STORE_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_thread.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Brackets {
+namespace FileSystem {
+
+/**
+ * The paths of a project tree, held as a trie of path segments. Each path
+ * is a node with its parent, its name and its children; segment names are
+ * stored once however many directories use them ("src", "index.js", ...),
+ * so a path costs a node of a few words instead of a string of its whole
+ * length. Every path gets an integer id that stays the same for as long as
+ * the path is in the store; ids are not reused after a path is removed.
+ *
+ * Paths are UTF-8 with '/' separators and are split at every '/': "/a/b"
+ * is "", "a", "b" and "C:/a" is "C:", "a". A trailing '/' marks a
+ * directory, as does having children, and GetPath puts it back. Node 0 is
+ * the root above the first segment, with the empty path.
+ *
+ * Thread safe: a store is filled on a worker thread by LoadPathStoreAsync
+ * while JS may still be reading it.
+ */
+class PathStore : public CefBase
+{
+public:
+    static const int kRootId = 0;
+
+    PathStore();
+
+    // Adds |path| and the directories above it and returns its id, or the
+    // id it already had. Returns -1 for the empty path.
+    int Add(const std::string& path);
+    void Add(const std::vector<std::string>& paths, std::vector<int>& ids);
+
+    // The id of |path|, or -1. A trailing '/' is ignored.
+    int Find(const std::string& path) const;
+
+    // Removes |id| and everything below it. Returns the number of paths
+    // removed, 0 if |id| was not there.
+    size_t Remove(int id);
+
+    bool IsValid(int id) const;
+    bool IsDirectory(int id) const;
+
+    // The full path of |id|, with a trailing '/' for directories, or the
+    // empty string if it is not there
+    std::string GetPath(int id) const;
+
+    // The last segment of |id|
+    std::string GetName(int id) const;
+
+    // -1 for the root and for ids that are not there
+    int GetParent(int id) const;
+
+    // The ids of the paths right below |id|, in no particular order
+    void GetChildren(int id, std::vector<int>& children) const;
+
+    // The ids of the files anywhere below |id|, parents before children
+    void GetFiles(int id, std::vector<int>& files) const;
+
+    // Paths in the store, not counting the root
+    size_t GetPathCount() const;
+
+    // Distinct segment names
+    size_t GetNameCount() const;
+
+    // Bytes the store has allocated
+    size_t GetMemoryUsage() const;
+
+private:
+    enum NodeFlags {
+        NODE_DIRECTORY = 1,
+        NODE_REMOVED = 2,
+    };
+
+    struct Node {
+        unsigned int name : 30; // index in m_nameOffsets
+        unsigned int flags : 2;
+        int parent;
+        int firstChild;         // -1 if none
+        int nextSibling;        // -1 if none
+    };
+
+    // Segment names, end to end in m_names; name i is
+    // [m_nameOffsets[i], m_nameOffsets[i + 1])
+    int FindName(const char* name, size_t length) const;
+    unsigned int AddName(const char* name, size_t length);
+    void RebuildNameSlots(size_t size);
+
+    // Children by (parent, name) in m_childSlots
+    int FindChild(int parent, unsigned int name) const;
+    void InsertChild(int node);
+    void EraseChild(int node);
+    void RebuildChildSlots(size_t size);
+
+    int AddLocked(const std::string& path);
+    int FindLocked(const std::string& path) const;
+
+    mutable Lock m_lock;
+
+    std::vector<Node> m_nodes;
+    size_t m_removed;
+
+    std::string m_names;
+    std::vector<unsigned int> m_nameOffsets;
+    std::vector<int> m_nameSlots;           // -1 when empty
+
+    std::vector<int> m_childSlots;          // -1 when empty, -2 when erased
+    size_t m_childSlotsUsed;                // including erased ones
+
+    IMPLEMENT_REFCOUNTING(PathStore);
+};
+
+} // namespace FileSystem
+
+/**
+ * The PathStores JS has made, by handle. They belong to the V8 context that
+ * made them and go away with it. UI thread only.
+ */
+class PathStoreRegistry
+{
+public:
+    static PathStoreRegistry& GetInstance();
+
+    // Registers |store| and returns its handle
+    int Add(CefRefPtr<FileSystem::PathStore> store, CefRefPtr<CefV8Context> context);
+
+    // Returns the store for |handle|, or NULL
+    CefRefPtr<FileSystem::PathStore> Get(int handle) const;
+
+    // Returns false if |handle| was not registered
+    bool Remove(int handle);
+
+    // Removes every store made from |context|
+    void ReleaseContext(CefRefPtr<CefV8Context> context);
+
+private:
+    PathStoreRegistry();
+
+    struct Entry {
+        CefRefPtr<FileSystem::PathStore> store;
+        CefRefPtr<CefV8Context> context;
+    };
+
+    std::map<int, Entry> m_stores;
+    int m_nextHandle;
+};
+
+// Native functions for path stores, registered by brackets_fs_extension.cpp
+int ExecuteCreatePathStore(const CefV8ValueList& arguments,
+                           CefRefPtr<CefV8Value>& retval,
+                           CefString& exception);
+int ExecuteAddStorePaths(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception);
+int ExecuteRemoveStorePaths(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception);
+int ExecuteFindStorePaths(const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception);
+int ExecuteGetStorePaths(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception);
+int ExecuteListStoreChildren(const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception);
+int ExecuteListStoreFiles(const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception);
+int ExecuteGetPathStoreStats(const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception);
+int ExecuteLoadPathStoreAsync(const CefV8ValueList& arguments,
+                              CefRefPtr<CefV8Value>& retval,
+                              CefString& exception);
+int ExecuteClosePathStore(const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception);
+
+} // namespace Brackets
+
+#endif // _BRACKETS_PATH_STORE_H
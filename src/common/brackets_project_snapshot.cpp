@@ -0,0 +1,830 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_project_snapshot.h"
+#include "common/brackets_async.h"
+#include "common/brackets_fs_extension.h"
+#include "common/brackets_path_store.h"
+#include "common/brackets_thread.h"
+#include "common/brackets_walker.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <map>
+
+namespace Brackets {
+namespace FileSystem {
+
+/**
+ * Layout of a snapshot file, in the byte order of the machine that wrote it:
+ *
+ *   Header
+ *   DirectoryRecord[directoryCount]    sorted by path
+ *   EntryRecord[entryCount]            the entries of each directory in
+ *                                      turn, each directory's sorted by name
+ *   strings                            the root, then the paths and names,
+ *                                      each ending with a NUL
+ *
+ * A snapshot written on a machine with the other byte order fails the magic
+ * check and is made again.
+ */
+struct ProjectSnapshot::Header {
+    char magic[4];
+    unsigned int version;
+    unsigned int directoryCount;
+    unsigned int entryCount;
+    unsigned int directoriesOffset;
+    unsigned int entriesOffset;
+    unsigned int stringsOffset;
+    unsigned int totalSize;
+    long long listedSec;            // when the walk that made it started
+    unsigned long long rootHash;
+};
+
+struct ProjectSnapshot::DirectoryRecord {
+    unsigned int path;              // offset in the strings
+    unsigned int firstEntry;
+    unsigned int entryCount;
+    unsigned int mtimeNsec;
+    long long mtimeSec;
+    unsigned long long device;
+    unsigned long long index;
+    unsigned long long hash;
+};
+
+struct ProjectSnapshot::EntryRecord {
+    unsigned int name;              // offset in the strings
+    unsigned int flags;
+};
+
+namespace {
+
+const char kSnapshotMagic[4] = { 'B', 'R', 'T', 'S' };
+const unsigned int kSnapshotVersion = 1;
+
+// Directories changed less than this long before a walk started are listed
+// again by the next one. Covers the two second clock of FAT.
+const long long kRacySeconds = 2;
+
+const int kSyncProgressDelayMs = 100;
+
+inline size_t Align(size_t offset)
+{
+    return (offset + 7) & ~(size_t)7;
+}
+
+template <class T>
+void AppendRecord(std::string& out, const T& record)
+{
+    out.append((const char*)&record, sizeof(record));
+}
+
+// FNV-1a
+void HashBytes(unsigned long long& hash, const void* data, size_t length)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+const unsigned long long kHashSeed = 14695981039346656037ULL;
+
+std::string ToUTF8(const ExtensionString& path)
+{
+#if defined(OS_WIN)
+    return CefString(path).ToString();
+#else
+    return path;
+#endif
+}
+
+ExtensionString FromUTF8(const char* path)
+{
+#if defined(OS_WIN)
+    return CefString(path).ToWString();
+#else
+    return path;
+#endif
+}
+
+// One entry of a directory the walk went through
+struct ListedEntry {
+    ListedEntry() : isDirectory(false), included(false) {}
+
+    bool operator<(const ListedEntry& other) const { return name < other.name; }
+
+    ExtensionString name;
+    bool isDirectory;
+    bool included;
+};
+
+// What a directory held when it was listed, and when that was
+struct Listing {
+    FileInfo info;                  // of the directory, just before it was listed
+    FileId id;
+    std::vector<ListedEntry> entries;
+};
+
+typedef std::map<ExtensionString, Listing> ListingMap;     // by path relative to the root
+
+} // namespace
+
+///
+// ProjectSnapshot
+///
+ProjectSnapshot::ProjectSnapshot()
+    : m_header(NULL), m_directoryCount(0), m_directories(NULL), m_entryCount(0), m_entries(NULL), m_strings(NULL)
+{
+}
+
+ProjectSnapshot::~ProjectSnapshot()
+{
+    UnmapFile(m_mapped);
+}
+
+int ProjectSnapshot::Open(const ExtensionString& path, CefRefPtr<ProjectSnapshot>& snapshot)
+{
+    PlatformFile file;
+    int error = OpenFileForReading(path, file);
+    if (error != NO_ERROR)
+        return error;
+
+    unsigned long long size = 0;
+    error = GetOpenFileSize(file, size);
+    if (error == NO_ERROR && (size < sizeof(Header) || size > 0xFFFFFFFFu))
+        error = ERR_CANT_READ;
+
+    CefRefPtr<ProjectSnapshot> opened = new ProjectSnapshot();
+    if (error == NO_ERROR)
+        error = MapFile(file, (size_t)size, opened->m_mapped);
+    CloseFile(file);
+    if (error != NO_ERROR)
+        return error;
+
+    // Everything the lookups rely on is checked here, so that a damaged
+    // snapshot is refused rather than read past its end
+    const char* data = opened->m_mapped.data;
+    const Header* header = (const Header*)data;
+    size_t length = opened->m_mapped.length;
+    if (memcmp(header->magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+        header->version != kSnapshotVersion || header->totalSize != length ||
+        header->directoriesOffset != Align(sizeof(Header)) ||
+        header->entriesOffset < header->directoriesOffset ||
+        (header->entriesOffset - header->directoriesOffset) / sizeof(DirectoryRecord) < header->directoryCount ||
+        header->stringsOffset < header->entriesOffset ||
+        (header->stringsOffset - header->entriesOffset) / sizeof(EntryRecord) < header->entryCount ||
+        header->stringsOffset >= length || data[length - 1] != '\0')
+        return ERR_CANT_READ;
+
+    opened->m_header = header;
+    opened->m_directoryCount = header->directoryCount;
+    opened->m_directories = (const DirectoryRecord*)(data + header->directoriesOffset);
+    opened->m_entryCount = header->entryCount;
+    opened->m_entries = (const EntryRecord*)(data + header->entriesOffset);
+    opened->m_strings = data + header->stringsOffset;
+    opened->m_root = opened->m_strings;
+
+    size_t stringsLength = length - header->stringsOffset;
+    for (size_t i = 0; i < opened->m_directoryCount; i++) {
+        const DirectoryRecord& record = opened->m_directories[i];
+        if (record.path >= stringsLength || record.firstEntry > opened->m_entryCount ||
+            record.entryCount > opened->m_entryCount - record.firstEntry)
+            return ERR_CANT_READ;
+    }
+    for (size_t i = 0; i < opened->m_entryCount; i++) {
+        if (opened->m_entries[i].name >= stringsLength)
+            return ERR_CANT_READ;
+    }
+
+    snapshot = opened;
+    return NO_ERROR;
+}
+
+unsigned long long ProjectSnapshot::GetRootHash() const
+{
+    return m_header->rootHash;
+}
+
+int ProjectSnapshot::FindDirectory(const std::string& path) const
+{
+    size_t low = 0;
+    size_t high = m_directoryCount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        int order = strcmp(GetDirectoryPath((int)middle), path.c_str());
+        if (order == 0)
+            return (int)middle;
+        if (order < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return -1;
+}
+
+const char* ProjectSnapshot::GetDirectoryPath(int directory) const
+{
+    return m_strings + m_directories[directory].path;
+}
+
+FileId ProjectSnapshot::GetDirectoryId(int directory) const
+{
+    FileId id;
+    id.device = m_directories[directory].device;
+    id.index = m_directories[directory].index;
+    return id;
+}
+
+bool ProjectSnapshot::IsCurrent(int directory, const FileInfo& info) const
+{
+    const DirectoryRecord& record = m_directories[directory];
+    return info.isDirectory && record.mtimeSec == info.mtimeSec && record.mtimeNsec == (unsigned int)info.mtimeNsec &&
+           record.mtimeSec < m_header->listedSec - kRacySeconds;
+}
+
+void ProjectSnapshot::GetEntries(int directory, size_t& first, size_t& count) const
+{
+    first = m_directories[directory].firstEntry;
+    count = m_directories[directory].entryCount;
+}
+
+const char* ProjectSnapshot::GetEntryName(size_t entry) const
+{
+    return m_strings + m_entries[entry].name;
+}
+
+unsigned int ProjectSnapshot::GetEntryFlags(size_t entry) const
+{
+    return m_entries[entry].flags;
+}
+
+// Writes snapshots in the format ProjectSnapshot reads
+class ProjectSnapshotWriter
+{
+public:
+    // Sets |out| to the snapshot of |listings| and |rootHash| to its hash.
+    // Returns false if the snapshot would be too large for 32 bit offsets.
+    static bool Write(const std::string& root, long long listedSec, const ListingMap& listings,
+                      std::string& out, unsigned long long& rootHash);
+};
+
+namespace {
+
+// A directory of the snapshot on its way out, in UTF-8
+struct WrittenDirectory {
+    std::string path;
+    const Listing* listing;
+    std::vector<std::pair<std::string, unsigned int> > entries;    // name and flags
+    unsigned long long hash;
+};
+
+bool ComparePaths(const WrittenDirectory& a, const WrittenDirectory& b)
+{
+    return a.path < b.path;
+}
+
+} // namespace
+
+bool ProjectSnapshotWriter::Write(const std::string& root, long long listedSec, const ListingMap& listings,
+                               std::string& out, unsigned long long& rootHash)
+{
+    std::vector<WrittenDirectory> directories(listings.size());
+    size_t entryCount = 0;
+    size_t d = 0;
+    for (ListingMap::const_iterator it = listings.begin(); it != listings.end(); ++it, d++) {
+        WrittenDirectory& directory = directories[d];
+        directory.path = ToUTF8(it->first);
+        directory.listing = &it->second;
+        directory.hash = kHashSeed;
+
+        const std::vector<ListedEntry>& entries = it->second.entries;
+        directory.entries.resize(entries.size());
+        for (size_t i = 0; i < entries.size(); i++) {
+            directory.entries[i].first = ToUTF8(entries[i].name);
+            directory.entries[i].second = (entries[i].isDirectory ? ProjectSnapshot::ENTRY_DIRECTORY : 0) |
+                                          (entries[i].included ? ProjectSnapshot::ENTRY_INCLUDED : 0);
+        }
+        std::sort(directory.entries.begin(), directory.entries.end());
+        entryCount += entries.size();
+    }
+    std::sort(directories.begin(), directories.end(), ComparePaths);
+
+    // A directory's path sorts after its parent's, so going backwards every
+    // directory is hashed after the directories below it
+    std::map<std::string, unsigned long long> hashes;
+    for (size_t i = directories.size(); i-- > 0;) {
+        WrittenDirectory& directory = directories[i];
+        for (size_t j = 0; j < directory.entries.size(); j++) {
+            const std::string& name = directory.entries[j].first;
+            unsigned char flags = (unsigned char)directory.entries[j].second;
+            HashBytes(directory.hash, name.c_str(), name.length() + 1);
+            HashBytes(directory.hash, &flags, 1);
+            if (flags & ProjectSnapshot::ENTRY_DIRECTORY) {
+                std::map<std::string, unsigned long long>::const_iterator child =
+                    hashes.find(directory.path.empty() ? name : directory.path + '/' + name);
+                if (child != hashes.end())
+                    HashBytes(directory.hash, &child->second, sizeof(child->second));
+            }
+        }
+        hashes[directory.path] = directory.hash;
+    }
+    std::map<std::string, unsigned long long>::const_iterator top = hashes.find(std::string());
+    rootHash = top != hashes.end() ? top->second : kHashSeed;
+
+    ProjectSnapshot::Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.directoryCount = (unsigned int)directories.size();
+    header.entryCount = (unsigned int)entryCount;
+    header.listedSec = listedSec;
+    header.rootHash = rootHash;
+
+    unsigned long long offset = Align(sizeof(header));
+    header.directoriesOffset = (unsigned int)offset;
+    offset += directories.size() * sizeof(ProjectSnapshot::DirectoryRecord);
+    header.entriesOffset = (unsigned int)offset;
+    offset += entryCount * sizeof(ProjectSnapshot::EntryRecord);
+    header.stringsOffset = (unsigned int)offset;
+
+    std::string strings(root);
+    strings += '\0';
+    std::vector<ProjectSnapshot::DirectoryRecord> directoryRecords(directories.size());
+    std::vector<ProjectSnapshot::EntryRecord> entryRecords;
+    entryRecords.reserve(entryCount);
+    for (size_t i = 0; i < directories.size(); i++) {
+        const WrittenDirectory& directory = directories[i];
+        ProjectSnapshot::DirectoryRecord& record = directoryRecords[i];
+        memset(&record, 0, sizeof(record));
+        record.path = (unsigned int)strings.length();
+        strings += directory.path;
+        strings += '\0';
+        record.firstEntry = (unsigned int)entryRecords.size();
+        record.entryCount = (unsigned int)directory.entries.size();
+        record.mtimeSec = directory.listing->info.mtimeSec;
+        record.mtimeNsec = (unsigned int)directory.listing->info.mtimeNsec;
+        record.device = directory.listing->id.device;
+        record.index = directory.listing->id.index;
+        record.hash = directory.hash;
+
+        for (size_t j = 0; j < directory.entries.size(); j++) {
+            ProjectSnapshot::EntryRecord entry;
+            entry.name = (unsigned int)strings.length();
+            entry.flags = directory.entries[j].second;
+            entryRecords.push_back(entry);
+            strings += directory.entries[j].first;
+            strings += '\0';
+        }
+        if (offset + strings.length() > 0xFFFFFFFFu)
+            return false;
+    }
+    offset += strings.length();
+    header.totalSize = (unsigned int)offset;
+
+    out.clear();
+    out.reserve((size_t)offset);
+    AppendRecord(out, header);
+    out.resize(header.directoriesOffset, '\0');
+    for (size_t i = 0; i < directoryRecords.size(); i++)
+        AppendRecord(out, directoryRecords[i]);
+    for (size_t i = 0; i < entryRecords.size(); i++)
+        AppendRecord(out, entryRecords[i]);
+    out += strings;
+    return true;
+}
+
+namespace {
+
+/**
+ * Runs SyncProjectSnapshotAsync. Fills a PathStore from the snapshot, if there
+ * is a usable one, then walks the tree, taking the entries of directories
+ * that haven't changed from the snapshot instead of listing them, and
+ * queues the paths that were added and removed since as progress. Writes
+ * the snapshot again when the walk found anything it didn't have.
+ */
+class SyncProjectSnapshotOperation : public AsyncOperation, public WalkSink
+{
+public:
+    SyncProjectSnapshotOperation(CefRefPtr<PathStore> store, const ExtensionString& root,
+                              const ExtensionString& snapshotPath, const WalkOptions& walkOptions)
+        : m_store(store), m_root(root), m_snapshotPath(snapshotPath), m_walkOptions(walkOptions),
+          m_rootId(-1), m_listedSec(0), m_reused(0), m_listed(0), m_fromSnapshot(false), m_ready(false),
+          m_files(0), m_directories(0), m_paths(0), m_reported(0), m_added(0), m_removed(0), m_hash(0),
+          m_written(false), m_size(0)
+    {
+        if (snapshotPath.compare(0, root.length() + 1, root + ExtensionString(1, '/')) == 0)
+            m_snapshotName = snapshotPath.substr(root.length() + 1);
+    }
+
+    // WalkSink
+    virtual void AddEntries(size_t root, std::vector<DirEntry>& entries);
+    virtual bool IsCancelled() const { return AsyncOperation::IsCancelled(); }
+    virtual int ListEntries(size_t root, const ExtensionString& path, const ExtensionString& relative,
+                            bool withStats, std::vector<DirEntry>& entries, FileId& id);
+
+    // progress(paths, added, removed)
+    virtual bool TakeProgress(CefV8ValueList& arguments);
+
+    virtual CefRefPtr<CefV8Value> GetResult();
+
+protected:
+    virtual int Run();
+
+private:
+    // Adds the entries the snapshot says the walk kept to the store
+    void LoadSnapshot();
+
+    // Takes the ids of paths that the walk has found in the store
+    void AddIds(const std::vector<int>& ids);
+
+    CefRefPtr<PathStore> m_store;
+    ExtensionString m_root;
+    ExtensionString m_snapshotPath;
+    ExtensionString m_snapshotName;     // relative to m_root, if it is below it
+    WalkOptions m_walkOptions;
+    std::string m_rootPath;             // UTF-8, with a trailing '/'
+    int m_rootId;
+    CefRefPtr<ProjectSnapshot> m_snapshot;
+    long long m_listedSec;
+
+    // Filled in by the walk
+    Lock m_listingsLock;
+    ListingMap m_listings;
+    size_t m_reused;                    // directories taken from the snapshot
+    size_t m_listed;                    // directories read from disk
+
+    Lock m_progressLock;
+    bool m_fromSnapshot;
+    bool m_ready;                       // the snapshot is loaded and not reported yet
+    std::vector<unsigned char> m_known; // by id: 1 in the snapshot, 2 found again
+    size_t m_files;
+    size_t m_directories;
+    size_t m_paths;
+    size_t m_reported;                  // m_paths at the last progress call
+    std::vector<int> m_pendingAdded;
+    std::vector<int> m_pendingRemoved;
+    size_t m_added;
+    size_t m_removed;
+
+    unsigned long long m_hash;
+    bool m_written;
+    size_t m_size;
+};
+
+void SyncProjectSnapshotOperation::LoadSnapshot()
+{
+    std::vector<std::string> paths;
+    std::vector<int> ids;
+    for (size_t d = 0; d < m_snapshot->GetDirectoryCount(); d++) {
+        std::string prefix = m_rootPath + m_snapshot->GetDirectoryPath((int)d);
+        if (prefix[prefix.length() - 1] != '/')
+            prefix += '/';
+
+        size_t first, count;
+        m_snapshot->GetEntries((int)d, first, count);
+        paths.clear();
+        for (size_t e = first; e < first + count; e++) {
+            unsigned int flags = m_snapshot->GetEntryFlags(e);
+            if (!(flags & ProjectSnapshot::ENTRY_INCLUDED))
+                continue;
+            paths.push_back(prefix + m_snapshot->GetEntryName(e));
+            if (flags & ProjectSnapshot::ENTRY_DIRECTORY)
+                paths.back() += '/';
+        }
+        if (paths.empty())
+            continue;
+        m_store->Add(paths, ids);
+
+        AutoLock lock(m_progressLock);
+        for (size_t i = 0; i < ids.size(); i++) {
+            if (ids[i] < 0)
+                continue;
+            if ((size_t)ids[i] >= m_known.size())
+                m_known.resize(ids[i] + 1);
+            if (!m_known[ids[i]]) {
+                m_known[ids[i]] = 1;
+                m_paths++;
+            }
+        }
+    }
+
+    {
+        AutoLock lock(m_progressLock);
+        m_fromSnapshot = true;
+        m_ready = true;
+    }
+    PostProgress(0);
+}
+
+int SyncProjectSnapshotOperation::ListEntries(size_t root, const ExtensionString& path, const ExtensionString& relative,
+                                           bool withStats, std::vector<DirEntry>& entries, FileId& id)
+{
+    // The time is taken first: whatever changes the directory after this
+    // gives it a time the snapshot doesn't have
+    Listing listing;
+    int error = GetFileInfo(path, listing.info);
+    if (error != NO_ERROR)
+        return error;
+    if (!listing.info.isDirectory)
+        return ERR_NOT_DIRECTORY;
+
+    int found = m_snapshot.get() ? m_snapshot->FindDirectory(ToUTF8(relative)) : -1;
+    bool reused = found >= 0 && m_snapshot->IsCurrent(found, listing.info);
+    if (reused) {
+        listing.id = m_snapshot->GetDirectoryId(found);
+        size_t first, count;
+        m_snapshot->GetEntries(found, first, count);
+        listing.entries.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            listing.entries[i].name = FromUTF8(m_snapshot->GetEntryName(first + i));
+            listing.entries[i].isDirectory = (m_snapshot->GetEntryFlags(first + i) & ProjectSnapshot::ENTRY_DIRECTORY) != 0;
+        }
+    } else {
+        std::vector<DirEntry> listed;
+        error = ListDirectory(path, withStats, listed, listing.id);
+        if (error != NO_ERROR)
+            return error;
+        listing.entries.resize(listed.size());
+        for (size_t i = 0; i < listed.size(); i++) {
+            listing.entries[i].name.swap(listed[i].name);
+            listing.entries[i].isDirectory = listed[i].info.isDirectory;
+        }
+    }
+    // The snapshot has entries in UTF-8 order, which is already that of
+    // ExtensionString except on Windows
+#if !defined(OS_WIN)
+    if (!reused)
+#endif
+        std::sort(listing.entries.begin(), listing.entries.end());
+
+    id = listing.id;
+    entries.resize(listing.entries.size());
+    for (size_t i = 0; i < listing.entries.size(); i++) {
+        entries[i].name = listing.entries[i].name;
+        entries[i].info.isDirectory = listing.entries[i].isDirectory;
+    }
+
+    AutoLock lock(m_listingsLock);
+    Listing& kept = m_listings[relative];
+    kept.info = listing.info;
+    kept.id = listing.id;
+    kept.entries.swap(listing.entries);
+    if (reused)
+        m_reused++;
+    else
+        m_listed++;
+    return NO_ERROR;
+}
+
+void SyncProjectSnapshotOperation::AddEntries(size_t root, std::vector<DirEntry>& entries)
+{
+    // Every entry comes from the same directory, the one listed last for it
+    ExtensionString directory;
+    size_t slash = entries[0].name.rfind('/');
+    if (slash != ExtensionString::npos)
+        directory = entries[0].name.substr(0, slash);
+
+    size_t files = 0;
+    size_t nameStart = slash == ExtensionString::npos ? 0 : slash + 1;
+    std::vector<std::string> paths;
+    paths.reserve(entries.size());
+    {
+        AutoLock lock(m_listingsLock);
+        ListingMap::iterator listing = m_listings.find(directory);
+        ListedEntry key;
+        for (size_t i = 0; i < entries.size(); i++) {
+            // The snapshot may be kept under the root it describes
+            if (entries[i].name == m_snapshotName)
+                continue;
+
+            if (listing != m_listings.end()) {
+                key.name.assign(entries[i].name, nameStart, ExtensionString::npos);
+                std::vector<ListedEntry>& listed = listing->second.entries;
+                std::vector<ListedEntry>::iterator entry = std::lower_bound(listed.begin(), listed.end(), key);
+                if (entry != listed.end() && entry->name == key.name)
+                    entry->included = true;
+            }
+
+            paths.push_back(m_rootPath);
+            paths.back() += ToUTF8(entries[i].name);
+            if (entries[i].info.isDirectory)
+                paths.back() += '/';
+            else
+                files++;
+        }
+    }
+
+    std::vector<int> ids;
+    m_store->Add(paths, ids);
+
+    {
+        AutoLock lock(m_progressLock);
+        m_files += files;
+        m_directories += paths.size() - files;
+    }
+    AddIds(ids);
+}
+
+void SyncProjectSnapshotOperation::AddIds(const std::vector<int>& ids)
+{
+    {
+        AutoLock lock(m_progressLock);
+        for (size_t i = 0; i < ids.size(); i++) {
+            int id = ids[i];
+            if (id < 0)
+                continue;
+            if ((size_t)id < m_known.size() && m_known[id]) {
+                m_known[id] = 2;
+                continue;
+            }
+
+            m_paths++;
+            if (m_fromSnapshot) {
+                m_pendingAdded.push_back(id);
+                m_added++;
+            }
+        }
+    }
+    PostProgress(kSyncProgressDelayMs);
+}
+
+int SyncProjectSnapshotOperation::Run()
+{
+    FileInfo info;
+    int error = GetFileInfo(m_root, info);
+    if (error != NO_ERROR)
+        return error;
+    if (!info.isDirectory)
+        return ERR_NOT_DIRECTORY;
+
+    std::string root = ToUTF8(m_root);
+    m_rootPath = root;
+    if (m_rootPath.empty() || m_rootPath[m_rootPath.length() - 1] != '/')
+        m_rootPath += '/';
+    m_rootId = m_store->Add(m_rootPath);
+
+    // A snapshot of another root, or one that can't be read, is as good as
+    // none; the walk lists everything and it is written again
+    m_listedSec = (long long)time(NULL);
+    CefRefPtr<ProjectSnapshot> snapshot;
+    if (ProjectSnapshot::Open(m_snapshotPath, snapshot) == NO_ERROR && snapshot->GetRoot() == root) {
+        m_snapshot = snapshot;
+        LoadSnapshot();
+    }
+    snapshot = NULL;
+
+    std::vector<ExtensionString> roots(1, m_root);
+    WalkStats stats;
+    error = WalkTree(roots, m_walkOptions, *this, stats);
+    if (error != NO_ERROR)
+        return error;
+    if (stats.rootErrors[0] != NO_ERROR)
+        return stats.rootErrors[0];
+
+    // What the snapshot had and the walk didn't find is gone
+    std::vector<int> removed;
+    {
+        AutoLock lock(m_progressLock);
+        for (size_t id = 0; id < m_known.size(); id++) {
+            if (m_known[id] == 1)
+                removed.push_back((int)id);
+        }
+    }
+    for (size_t i = 0; i < removed.size(); i++)
+        m_store->Remove(removed[i]);
+    {
+        AutoLock lock(m_progressLock);
+        m_pendingRemoved.insert(m_pendingRemoved.end(), removed.begin(), removed.end());
+        m_removed = removed.size();
+        m_paths -= removed.size();
+    }
+    PostProgress(0);
+
+    std::string contents;
+    if (!ProjectSnapshotWriter::Write(root, m_listedSec, m_listings, contents, m_hash))
+        return ERR_OUT_OF_SPACE;
+    m_listings.clear();
+    m_size = contents.length();
+
+    // Directories that had to be listed have a newer time to record, and a
+    // changed .gitignore changes what was kept without touching any
+    // directory's time, but shows in the hash
+    bool changed = !m_snapshot.get() || m_listed > 0 || m_hash != m_snapshot->GetRootHash();
+    m_snapshot = NULL;
+    if (changed) {
+        error = WriteFile(m_snapshotPath, contents, "utf8", DURABILITY_NONE);
+        if (error != NO_ERROR)
+            return error;
+        m_written = true;
+    }
+    return NO_ERROR;
+}
+
+bool SyncProjectSnapshotOperation::TakeProgress(CefV8ValueList& arguments)
+{
+    size_t paths;
+    bool fromSnapshot;
+    std::vector<int> added, removed;
+    {
+        AutoLock lock(m_progressLock);
+        if (!m_ready && m_paths == m_reported && m_pendingAdded.empty() && m_pendingRemoved.empty())
+            return false;
+        m_ready = false;
+        paths = m_reported = m_paths;
+        fromSnapshot = m_fromSnapshot;
+        added.swap(m_pendingAdded);
+        removed.swap(m_pendingRemoved);
+    }
+
+    arguments.push_back(CefV8Value::CreateDouble((double)paths));
+    if (fromSnapshot) {
+        CefRefPtr<CefV8Value> addedIds = CefV8Value::CreateArray();
+        for (size_t i = 0; i < added.size(); i++)
+            addedIds->SetValue((int)i, CefV8Value::CreateInt(added[i]));
+        CefRefPtr<CefV8Value> removedIds = CefV8Value::CreateArray();
+        for (size_t i = 0; i < removed.size(); i++)
+            removedIds->SetValue((int)i, CefV8Value::CreateInt(removed[i]));
+        arguments.push_back(addedIds);
+        arguments.push_back(removedIds);
+    } else {
+        arguments.push_back(CefV8Value::CreateNull());
+        arguments.push_back(CefV8Value::CreateNull());
+    }
+    return true;
+}
+
+CefRefPtr<CefV8Value> SyncProjectSnapshotOperation::GetResult()
+{
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", m_hash);
+
+    CefRefPtr<CefV8Value> result = CefV8Value::CreateObject(NULL);
+    result->SetValue("id", CefV8Value::CreateInt(m_rootId), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("files", CefV8Value::CreateDouble((double)m_files), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("directories", CefV8Value::CreateDouble((double)m_directories), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("snapshot", CefV8Value::CreateBool(m_fromSnapshot), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("reused", CefV8Value::CreateDouble((double)m_reused), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("listed", CefV8Value::CreateDouble((double)m_listed), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("added", CefV8Value::CreateDouble((double)m_added), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("removed", CefV8Value::CreateDouble((double)m_removed), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("hash", CefV8Value::CreateString(hash), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("written", CefV8Value::CreateBool(m_written), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("size", CefV8Value::CreateDouble((double)m_size), V8_PROPERTY_ATTRIBUTE_NONE);
+    return result;
+}
+
+} // namespace
+
+int ExecuteSyncProjectSnapshotAsync(const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefString& exception)
+{
+    if (arguments.size() < 6 || !arguments[0]->IsInt() || !arguments[1]->IsString() || !arguments[2]->IsString())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<PathStore> store = PathStoreRegistry::GetInstance().Get(arguments[0]->GetIntValue());
+    if (!store.get())
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString root = arguments[1]->GetStringValue();
+    while (root.length() > 1 && root[root.length() - 1] == '/')
+        root.erase(root.length() - 1);
+    ExtensionString snapshotPath = arguments[2]->GetStringValue();
+    if (root.empty() || snapshotPath.empty())
+        return ERR_INVALID_PARAMS;
+
+    // Entries taken from a snapshot have no stats to give
+    WalkOptions walkOptions;
+    if (!GetWalkOptions(arguments[3], walkOptions) || walkOptions.withStats)
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<AsyncOperation> operation = new SyncProjectSnapshotOperation(store, root, snapshotPath, walkOptions);
+    return operation->Start(arguments, 4, 5, retval);
+}
+
+} // namespace FileSystem
+} // namespace Brackets
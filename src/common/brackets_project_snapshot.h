@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_PROJECT_SNAPSHOT_H
+#define _BRACKETS_PROJECT_SNAPSHOT_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+
+#include <string>
+
+namespace Brackets {
+namespace FileSystem {
+
+/**
+ * What a walk of a project tree found, kept in one file that is mapped
+ * rather than read, so that a project can be shown as it was when it was
+ * last opened before the tree is walked again.
+ *
+ * For each directory that was listed the snapshot has its modification time
+ * from just before it was listed, its entries, and a hash of its entries and
+ * of the hashes of the directories below it, so that the hash of the root
+ * changes with anything in the tree. Adding, removing or renaming an entry
+ * changes the modification time of its directory, so a directory that still
+ * has the time it had is known to hold the same entries without reading it.
+ * Entries the walk left out are kept too, marked as such, since the rules
+ * that left them out are applied again by every walk.
+ *
+ * Paths are UTF-8, relative to the root, with '/' separators. Read-only once
+ * opened and may be shared by threads.
+ */
+class ProjectSnapshot : public CefBase
+{
+public:
+    enum EntryFlags {
+        ENTRY_DIRECTORY = 1,
+        ENTRY_INCLUDED = 2,     // the walk kept it
+    };
+
+    // Maps the snapshot at |path|. Returns ERR_NOT_FOUND if there is none
+    // and ERR_CANT_READ if the file is not a snapshot this version
+    // understands.
+    static int Open(const ExtensionString& path, CefRefPtr<ProjectSnapshot>& snapshot);
+
+    virtual ~ProjectSnapshot();
+
+    // Root of the project, UTF-8
+    const std::string& GetRoot() const { return m_root; }
+
+    size_t GetDirectoryCount() const { return m_directoryCount; }
+    size_t GetSize() const { return m_mapped.length; }
+
+    unsigned long long GetRootHash() const;
+
+    // Index of the directory at |path|, relative to the root, or -1
+    int FindDirectory(const std::string& path) const;
+
+    const char* GetDirectoryPath(int directory) const;
+    FileId GetDirectoryId(int directory) const;
+
+    // Whether |info|, taken just now, shows that the directory holds what it
+    // held when it was listed. A directory that had been changed too shortly
+    // before it was listed could have been changed again within the same
+    // tick of the file system's clock, and is never taken to be unchanged.
+    bool IsCurrent(int directory, const FileInfo& info) const;
+
+    // The entries of |directory| are [first, first + count)
+    void GetEntries(int directory, size_t& first, size_t& count) const;
+    const char* GetEntryName(size_t entry) const;
+    unsigned int GetEntryFlags(size_t entry) const;
+
+private:
+    friend class ProjectSnapshotWriter;
+
+    struct Header;
+    struct DirectoryRecord;
+    struct EntryRecord;
+
+    ProjectSnapshot();
+
+    MappedFile m_mapped;
+    std::string m_root;
+    const Header* m_header;
+    size_t m_directoryCount;
+    const DirectoryRecord* m_directories;
+    size_t m_entryCount;
+    const EntryRecord* m_entries;
+    const char* m_strings;
+
+    IMPLEMENT_REFCOUNTING(ProjectSnapshot);
+};
+
+// SyncProjectSnapshotAsync, registered by brackets_fs_extension.cpp
+int ExecuteSyncProjectSnapshotAsync(const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefString& exception);
+
+} // namespace FileSystem
+} // namespace Brackets
+
+#endif // _BRACKETS_PROJECT_SNAPSHOT_H
@@ -0,0 +1,1334 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_regex.h"
+#include "common/brackets_fs.h"
+
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+
+namespace Brackets {
+
+namespace {
+
+typedef unsigned int CodePoint;
+
+const CodePoint kMaxCodePoint = 0x10FFFF;
+
+// Limits on what a pattern may expand to
+const int kMaxRepeat = 1000;
+const int kMaxNesting = 100;
+const size_t kMaxProgramSize = 100000;
+
+// DFA states kept before the cache is thrown away and built again
+const size_t kMaxDFAStates = 2000;
+
+// Entries of RegexMatcher::m_transitions that are not a state
+const int kUnknownTransition = -1;
+const int kMatchTransition = -2;
+
+enum Assertion {
+    ASSERT_LINE_START,
+    ASSERT_LINE_END,
+    ASSERT_WORD_BOUNDARY,
+    ASSERT_NOT_WORD_BOUNDARY,
+    ASSERT_NO_WORD_BEFORE,      // REGEX_WHOLE_WORD
+    ASSERT_NO_WORD_AFTER,
+};
+
+struct CodeRange {
+    CodeRange() : low(0), high(0) {}
+    CodeRange(CodePoint low, CodePoint high) : low(low), high(high) {}
+
+    bool operator<(const CodeRange& other) const { return low < other.low; }
+
+    CodePoint low;
+    CodePoint high;
+};
+
+typedef std::vector<CodeRange> CodeRanges;
+
+// Sorts |ranges| and merges the ones that overlap or touch
+void NormalizeRanges(CodeRanges& ranges)
+{
+    std::sort(ranges.begin(), ranges.end());
+    size_t count = 0;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        if (count > 0 && ranges[i].low <= ranges[count - 1].high + 1)
+            ranges[count - 1].high = std::max(ranges[count - 1].high, ranges[i].high);
+        else
+            ranges[count++] = ranges[i];
+    }
+    ranges.resize(count);
+}
+
+// Everything in 0..kMaxCodePoint that is not in the normalized |ranges|
+CodeRanges Complement(const CodeRanges& ranges)
+{
+    CodeRanges result;
+    CodePoint next = 0;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        if (ranges[i].low > next)
+            result.push_back(CodeRange(next, ranges[i].low - 1));
+        next = ranges[i].high + 1;
+    }
+    if (next <= kMaxCodePoint)
+        result.push_back(CodeRange(next, kMaxCodePoint));
+    return result;
+}
+
+// Removes |low|..|high| from the normalized |ranges|
+void RemoveRange(CodeRanges& ranges, CodePoint low, CodePoint high)
+{
+    CodeRanges result;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        const CodeRange& range = ranges[i];
+        if (range.high < low || range.low > high) {
+            result.push_back(range);
+            continue;
+        }
+        if (range.low < low)
+            result.push_back(CodeRange(range.low, low - 1));
+        if (range.high > high)
+            result.push_back(CodeRange(high + 1, range.high));
+    }
+    ranges.swap(result);
+}
+
+// Adds the other case of the ASCII letters in |ranges|
+void AddCaseFolds(CodeRanges& ranges)
+{
+    size_t count = ranges.size();
+    for (size_t i = 0; i < count; i++) {
+        CodePoint low = std::max(ranges[i].low, (CodePoint)'A');
+        CodePoint high = std::min(ranges[i].high, (CodePoint)'Z');
+        if (low <= high)
+            ranges.push_back(CodeRange(low - 'A' + 'a', high - 'A' + 'a'));
+        low = std::max(ranges[i].low, (CodePoint)'a');
+        high = std::min(ranges[i].high, (CodePoint)'z');
+        if (low <= high)
+            ranges.push_back(CodeRange(low - 'a' + 'A', high - 'a' + 'A'));
+    }
+    NormalizeRanges(ranges);
+}
+
+void AppendUTF8(CodePoint c, std::string& out)
+{
+    if (c < 0x80) {
+        out += (char)c;
+    } else if (c < 0x800) {
+        out += (char)(0xC0 | (c >> 6));
+        out += (char)(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        out += (char)(0xE0 | (c >> 12));
+        out += (char)(0x80 | ((c >> 6) & 0x3F));
+        out += (char)(0x80 | (c & 0x3F));
+    } else {
+        out += (char)(0xF0 | (c >> 18));
+        out += (char)(0x80 | ((c >> 12) & 0x3F));
+        out += (char)(0x80 | ((c >> 6) & 0x3F));
+        out += (char)(0x80 | (c & 0x3F));
+    }
+}
+
+struct ByteRange {
+    unsigned char low;
+    unsigned char high;
+};
+
+typedef std::vector<ByteRange> ByteSequence;
+
+// Appends to |sequences| the byte sequences that encode the code points
+// |low|..|high| in UTF-8. Ranges are split until every byte of a sequence
+// can vary independently of the others.
+void SplitUTF8Range(CodePoint low, CodePoint high, std::vector<ByteSequence>& sequences)
+{
+    static const CodePoint lengthLimits[] = { 0x7F, 0x7FF, 0xFFFF };
+    for (int i = 0; i < 3; i++) {
+        if (low <= lengthLimits[i] && high > lengthLimits[i]) {
+            SplitUTF8Range(low, lengthLimits[i], sequences);
+            SplitUTF8Range(lengthLimits[i] + 1, high, sequences);
+            return;
+        }
+    }
+
+    std::string lowBytes, highBytes;
+    AppendUTF8(low, lowBytes);
+    AppendUTF8(high, highBytes);
+    size_t length = lowBytes.length();
+
+    for (size_t i = 1; i < length; i++) {
+        CodePoint mask = (1u << (6 * i)) - 1;
+        if ((low & ~mask) != (high & ~mask)) {
+            if ((low & mask) != 0) {
+                SplitUTF8Range(low, low | mask, sequences);
+                SplitUTF8Range((low | mask) + 1, high, sequences);
+                return;
+            }
+            if ((high & mask) != mask) {
+                SplitUTF8Range(low, (high & ~mask) - 1, sequences);
+                SplitUTF8Range(high & ~mask, high, sequences);
+                return;
+            }
+        }
+    }
+
+    ByteSequence sequence(length);
+    for (size_t i = 0; i < length; i++) {
+        sequence[i].low = (unsigned char)lowBytes[i];
+        sequence[i].high = (unsigned char)highBytes[i];
+    }
+    sequences.push_back(sequence);
+}
+
+inline bool IsWordByte(unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+inline bool IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+int HexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Parsed pattern. Nodes refer to each other by index.
+struct Node {
+    enum Type { EMPTY, CLASS, CONCAT, ALTERNATE, REPEAT, ASSERT };
+
+    Node(Type type) : type(type), literal(-1), min(0), max(0), greedy(true), assertion(0) {}
+
+    Type type;
+    CodeRanges ranges;          // CLASS
+    int literal;                // CLASS: the single character it stands for, or -1
+    std::vector<int> children;  // CONCAT, ALTERNATE, REPEAT
+    int min;                    // REPEAT; max is -1 for no limit
+    int max;
+    bool greedy;
+    int assertion;              // ASSERT
+};
+
+// What a node says about the literal text of its matches
+struct LiteralInfo {
+    LiteralInfo() : exact(false) {}
+
+    bool exact;                 // every match is |text|
+    std::string text;
+    std::string required;       // every match contains this
+};
+
+void KeepLonger(std::string& best, const std::string& candidate)
+{
+    if (candidate.length() > best.length())
+        best = candidate;
+}
+
+} // namespace
+
+/**
+ * Parses a pattern into Nodes, then emits the program for them with
+ * Thompson's construction: each node becomes a fragment whose loose ends
+ * are patched to whatever follows it.
+ */
+class RegexCompiler
+{
+public:
+    RegexCompiler(const std::string& pattern, int flags)
+        : m_pattern(pattern), m_pos(0), m_ignoreCase((flags & Regex::REGEX_IGNORE_CASE) != 0),
+          m_hasNonASCII(false), m_depth(0), m_tooLarge(false) {}
+
+    int Compile(Regex& regex);
+
+private:
+    // Loose ends of a fragment: the |next| (even) or |arg| (odd) field of
+    // an instruction, as 2 * pc + field
+    typedef std::vector<int> Holes;
+
+    struct Fragment {
+        int start;
+        Holes holes;
+    };
+
+    int AddNode(const Node& node);
+    int AddClass(CodeRanges& ranges, bool negated);
+    int AddLiteral(CodePoint c);
+
+    // Each returns the index of the node it parsed, or -1 if the pattern is
+    // invalid or not supported
+    int ParseAlternation();
+    int ParseConcatenation();
+    int ParseAtom();
+    int ParseQuantifiers(int atom);
+    int ParseClass();
+    int ParseEscape();
+
+    // Parses "{n}", "{n,}" or "{n,m}" at m_pos. Returns false, leaving m_pos
+    // alone, if there is none.
+    bool ParseBraces(int& min, int& max);
+
+    // Reads the escape after a '\' that stands for characters, into
+    // |ranges|. Returns false for escapes that don't, or are unsupported.
+    bool ParseCharacterEscape(bool inClass, CodeRanges& ranges, bool& isSet);
+
+    CodePoint NextCodePoint();
+
+    LiteralInfo Analyze(int node) const;
+
+    int Emit(Regex::Opcode op, int next, int arg);
+    void Patch(const Holes& holes, int target);
+    Fragment EmitNode(int node);
+    Fragment EmitClass(const CodeRanges& ranges);
+    int AddByteSet(unsigned char low, unsigned char high);
+
+    std::string m_pattern;
+    size_t m_pos;
+    bool m_ignoreCase;
+    bool m_hasNonASCII;
+    int m_depth;
+    std::vector<Node> m_nodes;
+
+    Regex* m_regex;
+    bool m_tooLarge;
+};
+
+int RegexCompiler::AddNode(const Node& node)
+{
+    m_nodes.push_back(node);
+    return (int)m_nodes.size() - 1;
+}
+
+int RegexCompiler::AddClass(CodeRanges& ranges, bool negated)
+{
+    NormalizeRanges(ranges);
+    if (m_ignoreCase)
+        AddCaseFolds(ranges);
+    if (negated)
+        ranges = Complement(ranges);
+
+    // Matches never span lines, and surrogates can't be encoded in UTF-8
+    RemoveRange(ranges, '\n', '\n');
+    RemoveRange(ranges, 0xD800, 0xDFFF);
+
+    Node node(Node::CLASS);
+    node.ranges = ranges;
+    if (!m_ignoreCase && ranges.size() == 1 && ranges[0].low == ranges[0].high)
+        node.literal = (int)ranges[0].low;
+    return AddNode(node);
+}
+
+int RegexCompiler::AddLiteral(CodePoint c)
+{
+    if (c >= 0x80)
+        m_hasNonASCII = true;
+
+    CodeRanges ranges(1, CodeRange(c, c));
+    int node = AddClass(ranges, false);
+    if (m_nodes[node].ranges.empty())
+        return node;
+
+    // Under REGEX_IGNORE_CASE the literal is kept in lower case
+    if (m_ignoreCase)
+        m_nodes[node].literal = (c >= 'A' && c <= 'Z') ? (int)(c - 'A' + 'a') : (int)c;
+    return node;
+}
+
+CodePoint RegexCompiler::NextCodePoint()
+{
+    unsigned char c = (unsigned char)m_pattern[m_pos++];
+    if (c < 0x80)
+        return c;
+
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : 1;
+    CodePoint value = c & (0x3F >> extra);
+    for (int i = 0; i < extra && m_pos < m_pattern.length(); i++)
+        value = (value << 6) | ((unsigned char)m_pattern[m_pos++] & 0x3F);
+    return value;
+}
+
+int RegexCompiler::ParseAlternation()
+{
+    if (++m_depth > kMaxNesting)
+        return -1;
+
+    Node node(Node::ALTERNATE);
+    for (;;) {
+        int branch = ParseConcatenation();
+        if (branch < 0)
+            return -1;
+        node.children.push_back(branch);
+        if (m_pos >= m_pattern.length() || m_pattern[m_pos] != '|')
+            break;
+        m_pos++;
+    }
+
+    m_depth--;
+    return node.children.size() == 1 ? node.children[0] : AddNode(node);
+}
+
+int RegexCompiler::ParseConcatenation()
+{
+    Node node(Node::CONCAT);
+    while (m_pos < m_pattern.length() && m_pattern[m_pos] != '|' && m_pattern[m_pos] != ')') {
+        int atom = ParseAtom();
+        if (atom >= 0)
+            atom = ParseQuantifiers(atom);
+        if (atom < 0)
+            return -1;
+        node.children.push_back(atom);
+    }
+
+    if (node.children.empty())
+        return AddNode(Node(Node::EMPTY));
+    return node.children.size() == 1 ? node.children[0] : AddNode(node);
+}
+
+int RegexCompiler::ParseAtom()
+{
+    char c = m_pattern[m_pos];
+    switch (c) {
+    case '(': {
+        m_pos++;
+        if (m_pattern.compare(m_pos, 2, "?:") == 0)
+            m_pos += 2;
+        else if (m_pos < m_pattern.length() && m_pattern[m_pos] == '?')
+            return -1;      // lookaround and named groups
+
+        int inner = ParseAlternation();
+        if (inner < 0 || m_pos >= m_pattern.length() || m_pattern[m_pos] != ')')
+            return -1;
+        m_pos++;
+        return inner;
+    }
+
+    case '[':
+        return ParseClass();
+
+    case '.': {
+        m_pos++;
+        CodeRanges ranges;
+        ranges.push_back(CodeRange('\n', '\n'));
+        ranges.push_back(CodeRange('\r', '\r'));
+        ranges.push_back(CodeRange(0x2028, 0x2029));
+        return AddClass(ranges, true);
+    }
+
+    case '^':
+    case '$': {
+        m_pos++;
+        Node node(Node::ASSERT);
+        node.assertion = c == '^' ? ASSERT_LINE_START : ASSERT_LINE_END;
+        return AddNode(node);
+    }
+
+    case '\\':
+        m_pos++;
+        return ParseEscape();
+
+    case '*':
+    case '+':
+    case '?':
+        return -1;          // nothing to repeat
+
+    case '{': {
+        int min, max;
+        if (ParseBraces(min, max))
+            return -1;
+        m_pos++;
+        return AddLiteral('{');
+    }
+
+    default:
+        return AddLiteral(NextCodePoint());
+    }
+}
+
+bool RegexCompiler::ParseBraces(int& min, int& max)
+{
+    size_t pos = m_pos + 1;
+    size_t digits = pos;
+    long value = 0;
+    while (pos < m_pattern.length() && IsDigit(m_pattern[pos]))
+        value = std::min(value * 10 + (m_pattern[pos++] - '0'), (long)INT_MAX);
+    if (pos == digits)
+        return false;
+    min = max = (int)value;
+
+    if (pos < m_pattern.length() && m_pattern[pos] == ',') {
+        pos++;
+        digits = pos;
+        value = 0;
+        while (pos < m_pattern.length() && IsDigit(m_pattern[pos]))
+            value = std::min(value * 10 + (m_pattern[pos++] - '0'), (long)INT_MAX);
+        max = pos == digits ? -1 : (int)value;
+    }
+
+    if (pos >= m_pattern.length() || m_pattern[pos] != '}')
+        return false;
+    m_pos = pos + 1;
+    return true;
+}
+
+int RegexCompiler::ParseQuantifiers(int atom)
+{
+    if (m_pos >= m_pattern.length())
+        return atom;
+
+    int min, max;
+    char c = m_pattern[m_pos];
+    if (c == '*') {
+        min = 0;
+        max = -1;
+        m_pos++;
+    } else if (c == '+') {
+        min = 1;
+        max = -1;
+        m_pos++;
+    } else if (c == '?') {
+        min = 0;
+        max = 1;
+        m_pos++;
+    } else if (c != '{' || !ParseBraces(min, max)) {
+        return atom;
+    }
+
+    if (m_nodes[atom].type == Node::ASSERT || (max != -1 && min > max) || min > kMaxRepeat || max > kMaxRepeat)
+        return -1;
+
+    Node node(Node::REPEAT);
+    node.children.push_back(atom);
+    node.min = min;
+    node.max = max;
+    if (m_pos < m_pattern.length() && m_pattern[m_pos] == '?') {
+        node.greedy = false;
+        m_pos++;
+    }
+
+    // A quantifier can't follow another one
+    if (m_pos < m_pattern.length()) {
+        c = m_pattern[m_pos];
+        int otherMin, otherMax;
+        size_t pos = m_pos;
+        if (c == '*' || c == '+' || c == '?' || (c == '{' && ParseBraces(otherMin, otherMax))) {
+            m_pos = pos;
+            return -1;
+        }
+    }
+    return AddNode(node);
+}
+
+int RegexCompiler::ParseClass()
+{
+    m_pos++;
+    bool negated = m_pos < m_pattern.length() && m_pattern[m_pos] == '^';
+    if (negated)
+        m_pos++;
+
+    CodeRanges ranges;
+    for (;;) {
+        if (m_pos >= m_pattern.length())
+            return -1;
+        if (m_pattern[m_pos] == ']') {
+            m_pos++;
+            break;
+        }
+
+        // One character or set, and maybe a range to another character
+        CodeRanges low;
+        bool lowIsSet = false;
+        if (m_pattern[m_pos] == '\\') {
+            m_pos++;
+            if (!ParseCharacterEscape(true, low, lowIsSet))
+                return -1;
+        } else {
+            CodePoint c = NextCodePoint();
+            low.push_back(CodeRange(c, c));
+        }
+
+        if (!lowIsSet && m_pos + 1 < m_pattern.length() && m_pattern[m_pos] == '-' && m_pattern[m_pos + 1] != ']') {
+            m_pos++;
+            CodeRanges high;
+            bool highIsSet = false;
+            if (m_pattern[m_pos] == '\\') {
+                m_pos++;
+                if (!ParseCharacterEscape(true, high, highIsSet))
+                    return -1;
+            } else {
+                CodePoint c = NextCodePoint();
+                high.push_back(CodeRange(c, c));
+            }
+
+            if (!highIsSet) {
+                if (high[0].low < low[0].low)
+                    return -1;
+                low[0].high = high[0].low;
+            } else {
+                // "[a-\d]": the '-' is just a character
+                ranges.insert(ranges.end(), high.begin(), high.end());
+                ranges.push_back(CodeRange('-', '-'));
+            }
+        }
+
+        for (size_t i = 0; i < low.size(); i++) {
+            if (!lowIsSet && low[i].high >= 0x80)
+                m_hasNonASCII = true;
+        }
+        ranges.insert(ranges.end(), low.begin(), low.end());
+    }
+
+    return AddClass(ranges, negated);
+}
+
+bool RegexCompiler::ParseCharacterEscape(bool inClass, CodeRanges& ranges, bool& isSet)
+{
+    if (m_pos >= m_pattern.length())
+        return false;
+
+    isSet = false;
+    char c = m_pattern[m_pos++];
+    CodePoint value = c;
+    switch (c) {
+    case 'd':
+    case 'D':
+    case 'w':
+    case 'W':
+    case 's':
+    case 'S': {
+        CodeRanges set;
+        if (c == 'd' || c == 'D') {
+            set.push_back(CodeRange('0', '9'));
+        } else if (c == 'w' || c == 'W') {
+            set.push_back(CodeRange('0', '9'));
+            set.push_back(CodeRange('A', 'Z'));
+            set.push_back(CodeRange('_', '_'));
+            set.push_back(CodeRange('a', 'z'));
+        } else {
+            set.push_back(CodeRange('\t', '\r'));
+            set.push_back(CodeRange(' ', ' '));
+            set.push_back(CodeRange(0xA0, 0xA0));
+            set.push_back(CodeRange(0x1680, 0x1680));
+            set.push_back(CodeRange(0x2000, 0x200A));
+            set.push_back(CodeRange(0x2028, 0x2029));
+            set.push_back(CodeRange(0x202F, 0x202F));
+            set.push_back(CodeRange(0x205F, 0x205F));
+            set.push_back(CodeRange(0x3000, 0x3000));
+            set.push_back(CodeRange(0xFEFF, 0xFEFF));
+        }
+        NormalizeRanges(set);
+        if (c == 'D' || c == 'W' || c == 'S')
+            set = Complement(set);
+        ranges.insert(ranges.end(), set.begin(), set.end());
+        isSet = true;
+        return true;
+    }
+
+    case 't':   value = '\t';   break;
+    case 'n':   value = '\n';   break;
+    case 'r':   value = '\r';   break;
+    case 'f':   value = '\f';   break;
+    case 'v':   value = '\v';   break;
+    case 'b':
+        // Only a character in a class, an assertion elsewhere
+        if (!inClass)
+            return false;
+        value = '\b';
+        break;
+
+    case '0':
+        if (m_pos < m_pattern.length() && IsDigit(m_pattern[m_pos]))
+            return false;
+        value = 0;
+        break;
+
+    case 'c':
+        if (m_pos < m_pattern.length() && ((m_pattern[m_pos] | 0x20) >= 'a' && (m_pattern[m_pos] | 0x20) <= 'z')) {
+            value = m_pattern[m_pos++] & 31;
+        } else {
+            m_pos--;
+            value = '\\';
+        }
+        break;
+
+    case 'x':
+        if (m_pos + 1 < m_pattern.length() && HexValue(m_pattern[m_pos]) >= 0 && HexValue(m_pattern[m_pos + 1]) >= 0) {
+            value = HexValue(m_pattern[m_pos]) * 16 + HexValue(m_pattern[m_pos + 1]);
+            m_pos += 2;
+        }
+        break;
+
+    case 'u': {
+        if (m_pos + 3 >= m_pattern.length())
+            break;
+        CodePoint unit = 0;
+        size_t i;
+        for (i = 0; i < 4 && HexValue(m_pattern[m_pos + i]) >= 0; i++)
+            unit = unit * 16 + HexValue(m_pattern[m_pos + i]);
+        if (i < 4)
+            break;
+        m_pos += 4;
+        value = unit;
+
+        // A surrogate pair written as two escapes
+        if (unit >= 0xD800 && unit <= 0xDBFF && m_pattern.compare(m_pos, 2, "\\u") == 0 &&
+            m_pos + 5 < m_pattern.length()) {
+            CodePoint low = 0;
+            for (i = 0; i < 4 && HexValue(m_pattern[m_pos + 2 + i]) >= 0; i++)
+                low = low * 16 + HexValue(m_pattern[m_pos + 2 + i]);
+            if (i == 4 && low >= 0xDC00 && low <= 0xDFFF) {
+                value = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                m_pos += 6;
+            }
+        }
+        if (value >= 0xD800 && value <= 0xDFFF)
+            return false;
+        break;
+    }
+
+    default:
+        // Backreferences are not supported; anything else stands for itself
+        if (IsDigit(c))
+            return false;
+        m_pos--;
+        value = NextCodePoint();
+        break;
+    }
+
+    if (value >= 0x80)
+        m_hasNonASCII = true;
+    ranges.push_back(CodeRange(value, value));
+    return true;
+}
+
+int RegexCompiler::ParseEscape()
+{
+    if (m_pos < m_pattern.length() && (m_pattern[m_pos] == 'b' || m_pattern[m_pos] == 'B')) {
+        Node node(Node::ASSERT);
+        node.assertion = m_pattern[m_pos++] == 'b' ? ASSERT_WORD_BOUNDARY : ASSERT_NOT_WORD_BOUNDARY;
+        return AddNode(node);
+    }
+
+    CodeRanges ranges;
+    bool isSet;
+    if (!ParseCharacterEscape(false, ranges, isSet))
+        return -1;
+    if (!isSet)
+        return AddLiteral(ranges[0].low);
+    return AddClass(ranges, false);
+}
+
+LiteralInfo RegexCompiler::Analyze(int index) const
+{
+    const Node& node = m_nodes[index];
+    LiteralInfo info;
+
+    switch (node.type) {
+    case Node::EMPTY:
+    case Node::ASSERT:
+        // Zero-width, so the text on either side of it is contiguous
+        info.exact = true;
+        break;
+
+    case Node::CLASS:
+        if (node.literal >= 0) {
+            info.exact = true;
+            AppendUTF8((CodePoint)node.literal, info.text);
+            info.required = info.text;
+        }
+        break;
+
+    case Node::CONCAT: {
+        info.exact = true;
+        std::string run;
+        for (size_t i = 0; i < node.children.size(); i++) {
+            LiteralInfo child = Analyze(node.children[i]);
+            if (child.exact) {
+                run += child.text;
+            } else {
+                info.exact = false;
+                KeepLonger(info.required, run);
+                KeepLonger(info.required, child.required);
+                run.clear();
+            }
+        }
+        KeepLonger(info.required, run);
+        if (info.exact)
+            info.text = run;
+        break;
+    }
+
+    case Node::ALTERNATE: {
+        LiteralInfo first = Analyze(node.children[0]);
+        info.exact = first.exact;
+        for (size_t i = 1; i < node.children.size() && info.exact; i++) {
+            LiteralInfo child = Analyze(node.children[i]);
+            info.exact = child.exact && child.text == first.text;
+        }
+        if (info.exact)
+            info.required = info.text = first.text;
+        break;
+    }
+
+    case Node::REPEAT: {
+        if (node.min == 0)
+            break;
+        LiteralInfo child = Analyze(node.children[0]);
+        info.required = child.required;
+        if (child.exact && node.min == node.max && child.text.length() * node.min <= 256) {
+            info.exact = true;
+            for (int i = 0; i < node.min; i++)
+                info.text += child.text;
+            info.required = info.text;
+        }
+        break;
+    }
+    }
+    return info;
+}
+
+int RegexCompiler::Emit(Regex::Opcode op, int next, int arg)
+{
+    if (m_regex->m_program.size() >= kMaxProgramSize) {
+        m_tooLarge = true;
+        return 0;
+    }
+
+    Regex::Instruction instruction;
+    instruction.op = op;
+    instruction.next = next;
+    instruction.arg = arg;
+    m_regex->m_program.push_back(instruction);
+    return (int)m_regex->m_program.size() - 1;
+}
+
+void RegexCompiler::Patch(const Holes& holes, int target)
+{
+    std::vector<Regex::Instruction>& program = m_regex->m_program;
+    for (size_t i = 0; i < holes.size(); i++) {
+        Regex::Instruction& instruction = program[holes[i] / 2];
+        if (holes[i] % 2)
+            instruction.arg = target;
+        else
+            instruction.next = target;
+    }
+}
+
+int RegexCompiler::AddByteSet(unsigned char low, unsigned char high)
+{
+    Regex::ByteSet set;
+    memset(set.bits, 0, sizeof(set.bits));
+    for (int c = low; c <= high; c++)
+        set.bits[c >> 5] |= 1u << (c & 31);
+
+    std::vector<Regex::ByteSet>& sets = m_regex->m_byteSets;
+    for (size_t i = 0; i < sets.size(); i++) {
+        if (memcmp(sets[i].bits, set.bits, sizeof(set.bits)) == 0)
+            return (int)i;
+    }
+    sets.push_back(set);
+    return (int)sets.size() - 1;
+}
+
+RegexCompiler::Fragment RegexCompiler::EmitClass(const CodeRanges& ranges)
+{
+    // The ASCII part is one set of bytes, the rest one chain of byte ranges
+    // per UTF-8 sequence
+    Regex::ByteSet ascii;
+    memset(ascii.bits, 0, sizeof(ascii.bits));
+    bool hasASCII = false;
+    std::vector<ByteSequence> sequences;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        for (CodePoint c = ranges[i].low; c <= ranges[i].high && c < 0x80; c++) {
+            ascii.bits[c >> 5] |= 1u << (c & 31);
+            hasASCII = true;
+        }
+        if (ranges[i].high >= 0x80)
+            SplitUTF8Range(std::max(ranges[i].low, (CodePoint)0x80), ranges[i].high, sequences);
+    }
+
+    std::vector<Fragment> alternatives;
+    if (hasASCII) {
+        std::vector<Regex::ByteSet>& sets = m_regex->m_byteSets;
+        sets.push_back(ascii);
+        Fragment fragment;
+        fragment.start = Emit(Regex::OP_BYTES, -1, (int)sets.size() - 1);
+        fragment.holes.push_back(2 * fragment.start);
+        alternatives.push_back(fragment);
+    }
+    for (size_t i = 0; i < sequences.size(); i++) {
+        Fragment fragment;
+        fragment.start = -1;
+        int previous = -1;
+        for (size_t j = 0; j < sequences[i].size(); j++) {
+            int pc = Emit(Regex::OP_BYTES, -1, AddByteSet(sequences[i][j].low, sequences[i][j].high));
+            if (previous >= 0)
+                m_regex->m_program[previous].next = pc;
+            else
+                fragment.start = pc;
+            previous = pc;
+        }
+        fragment.holes.push_back(2 * previous);
+        alternatives.push_back(fragment);
+    }
+
+    // A class that matches nothing, such as [] or [^\s\S]
+    if (alternatives.empty()) {
+        Fragment fragment;
+        fragment.start = Emit(Regex::OP_BYTES, -1, AddByteSet(1, 0));
+        return fragment;
+    }
+
+    Fragment result = alternatives.back();
+    for (size_t i = alternatives.size() - 1; i > 0; i--) {
+        Fragment split;
+        split.start = Emit(Regex::OP_SPLIT, alternatives[i - 1].start, result.start);
+        split.holes = alternatives[i - 1].holes;
+        split.holes.insert(split.holes.end(), result.holes.begin(), result.holes.end());
+        result = split;
+    }
+    return result;
+}
+
+RegexCompiler::Fragment RegexCompiler::EmitNode(int index)
+{
+    const Node& node = m_nodes[index];
+    Fragment result;
+    if (m_tooLarge) {
+        result.start = 0;
+        return result;
+    }
+
+    switch (node.type) {
+    case Node::EMPTY:
+        result.start = Emit(Regex::OP_JUMP, -1, 0);
+        result.holes.push_back(2 * result.start);
+        break;
+
+    case Node::ASSERT:
+        result.start = Emit(Regex::OP_ASSERT, -1, node.assertion);
+        result.holes.push_back(2 * result.start);
+        break;
+
+    case Node::CLASS:
+        result = EmitClass(node.ranges);
+        break;
+
+    case Node::CONCAT:
+        result = EmitNode(node.children[0]);
+        for (size_t i = 1; i < node.children.size(); i++) {
+            Fragment next = EmitNode(node.children[i]);
+            Patch(result.holes, next.start);
+            result.holes = next.holes;
+        }
+        break;
+
+    case Node::ALTERNATE: {
+        // Earlier branches have priority
+        std::vector<Fragment> branches;
+        for (size_t i = 0; i < node.children.size(); i++)
+            branches.push_back(EmitNode(node.children[i]));
+        result = branches.back();
+        for (size_t i = branches.size() - 1; i > 0; i--) {
+            Fragment split;
+            split.start = Emit(Regex::OP_SPLIT, branches[i - 1].start, result.start);
+            split.holes = branches[i - 1].holes;
+            split.holes.insert(split.holes.end(), result.holes.begin(), result.holes.end());
+            result = split;
+        }
+        break;
+    }
+
+    case Node::REPEAT: {
+        // x{2,4} is x x (x (x)?)?, x{2,} is x x+ and x+ loops back on itself.
+        // A greedy split tries another x first, a lazy one what follows.
+        int child = node.children[0];
+        result.start = -1;
+        Holes holes;
+        int required = node.max == -1 && node.min > 0 ? node.min - 1 : node.min;
+        for (int i = 0; i < required && !m_tooLarge; i++) {
+            Fragment copy = EmitNode(child);
+            if (result.start < 0)
+                result.start = copy.start;
+            else
+                Patch(holes, copy.start);
+            holes = copy.holes;
+        }
+
+        if (node.max == -1) {
+            Fragment loop = EmitNode(child);
+            int split;
+            if (node.min > 0) {
+                split = Emit(Regex::OP_SPLIT, -1, -1);
+                Patch(loop.holes, split);
+                if (result.start < 0)
+                    result.start = loop.start;
+                else
+                    Patch(holes, loop.start);
+            } else {
+                split = Emit(Regex::OP_SPLIT, -1, -1);
+                Patch(loop.holes, split);
+                if (result.start < 0)
+                    result.start = split;
+                else
+                    Patch(holes, split);
+            }
+            // The split either goes around once more or leaves
+            Regex::Instruction& instruction = m_regex->m_program[split];
+            if (node.greedy) {
+                instruction.next = loop.start;
+                holes.assign(1, 2 * split + 1);
+            } else {
+                instruction.arg = loop.start;
+                holes.assign(1, 2 * split);
+            }
+        } else {
+            Holes exits;
+            for (int i = node.min; i < node.max && !m_tooLarge; i++) {
+                Fragment copy = EmitNode(child);
+                int split = node.greedy ? Emit(Regex::OP_SPLIT, copy.start, -1) : Emit(Regex::OP_SPLIT, -1, copy.start);
+                exits.push_back(node.greedy ? 2 * split + 1 : 2 * split);
+                if (result.start < 0)
+                    result.start = split;
+                else
+                    Patch(holes, split);
+                holes = copy.holes;
+            }
+            holes.insert(holes.end(), exits.begin(), exits.end());
+        }
+
+        // x{0} matches the empty string
+        if (result.start < 0) {
+            result.start = Emit(Regex::OP_JUMP, -1, 0);
+            holes.assign(1, 2 * result.start);
+        }
+        result.holes = holes;
+        break;
+    }
+    }
+    return result;
+}
+
+int RegexCompiler::Compile(Regex& regex)
+{
+    m_regex = &regex;
+
+    int root = ParseAlternation();
+    if (root < 0 || m_pos != m_pattern.length() || (m_ignoreCase && m_hasNonASCII))
+        return ERR_INVALID_PARAMS;
+
+    Fragment body = EmitNode(root);
+    int match = Emit(Regex::OP_MATCH, -1, 0);
+    int start = body.start;
+    if (regex.m_flags & Regex::REGEX_WHOLE_WORD) {
+        start = Emit(Regex::OP_ASSERT, body.start, ASSERT_NO_WORD_BEFORE);
+        int after = Emit(Regex::OP_ASSERT, match, ASSERT_NO_WORD_AFTER);
+        Patch(body.holes, after);
+    } else {
+        Patch(body.holes, match);
+    }
+    if (m_tooLarge)
+        return ERR_INVALID_PARAMS;
+
+    regex.m_start = start;
+    regex.m_requiredLiteral = Analyze(root).required;
+    return NO_ERROR;
+}
+
+///
+// Regex
+///
+int Regex::Compile(const std::string& pattern, int flags, CefRefPtr<Regex>& regex)
+{
+    CefRefPtr<Regex> compiled = new Regex();
+    compiled->m_flags = flags;
+
+    RegexCompiler compiler(pattern, flags);
+    int error = compiler.Compile(*compiled);
+    if (error != NO_ERROR)
+        return error;
+
+    regex = compiled;
+    return NO_ERROR;
+}
+
+///
+// RegexMatcher
+///
+RegexMatcher::RegexMatcher(CefRefPtr<Regex> regex)
+    : m_regex(regex), m_onList(regex->m_program.size(), -1), m_step(0)
+{
+    std::vector<int> pcs;
+    std::vector<bool> seen(m_regex->m_program.size());
+    AddClosure(m_regex->m_start, pcs, seen);
+    std::sort(pcs.begin(), pcs.end());
+
+    memset(m_firstBytes.bits, 0, sizeof(m_firstBytes.bits));
+    m_canSkip = true;
+    for (size_t i = 0; i < pcs.size(); i++) {
+        const Regex::Instruction& instruction = m_regex->m_program[pcs[i]];
+        if (instruction.op == Regex::OP_MATCH) {
+            m_canSkip = false;
+            continue;
+        }
+        const Regex::ByteSet& set = m_regex->m_byteSets[instruction.arg];
+        for (int j = 0; j < 8; j++)
+            m_firstBytes.bits[j] |= set.bits[j];
+    }
+
+    m_startState = FindState(pcs);
+}
+
+void RegexMatcher::AddThread(std::vector<Thread>& threads, int pc, const char* p, const char* lineStart,
+                             const char* lineEnd, const char* start)
+{
+    const std::vector<Regex::Instruction>& program = m_regex->m_program;
+
+    // Depth first, |next| before |arg|, so threads are added in priority
+    // order
+    m_stack.push_back(pc);
+    while (!m_stack.empty()) {
+        pc = m_stack.back();
+        m_stack.pop_back();
+        if (m_onList[pc] == m_step)
+            continue;
+        m_onList[pc] = m_step;
+
+        const Regex::Instruction& instruction = program[pc];
+        switch (instruction.op) {
+        case Regex::OP_JUMP:
+            m_stack.push_back(instruction.next);
+            break;
+
+        case Regex::OP_SPLIT:
+            m_stack.push_back(instruction.arg);
+            m_stack.push_back(instruction.next);
+            break;
+
+        case Regex::OP_ASSERT: {
+            bool wordBefore = p > lineStart && IsWordByte((unsigned char)p[-1]);
+            bool wordAfter = p < lineEnd && IsWordByte((unsigned char)*p);
+            bool holds;
+            switch (instruction.arg) {
+            case ASSERT_LINE_START:         holds = p == lineStart; break;
+            case ASSERT_LINE_END:           holds = p == lineEnd || (p + 1 == lineEnd && *p == '\r'); break;
+            case ASSERT_WORD_BOUNDARY:      holds = wordBefore != wordAfter; break;
+            case ASSERT_NOT_WORD_BOUNDARY:  holds = wordBefore == wordAfter; break;
+            case ASSERT_NO_WORD_BEFORE:     holds = !wordBefore; break;
+            default:                        holds = !wordAfter; break;
+            }
+            if (holds)
+                m_stack.push_back(instruction.next);
+            break;
+        }
+
+        default:
+            threads.push_back(Thread(pc, start));
+            break;
+        }
+    }
+}
+
+bool RegexMatcher::FindInLine(const char* lineStart, const char* lineEnd, const char* from,
+                              const char*& matchStart, const char*& matchEnd)
+{
+    const std::vector<Regex::Instruction>& program = m_regex->m_program;
+    const std::vector<Regex::ByteSet>& byteSets = m_regex->m_byteSets;
+
+    // Steps mark which instructions are on the list being built
+    if (m_step > INT_MAX - 2 * (lineEnd - from) - 2) {
+        std::fill(m_onList.begin(), m_onList.end(), -1);
+        m_step = 0;
+    }
+
+    bool matched = false;
+    m_current.clear();
+    m_step++;
+    for (const char* p = from; ; p++) {
+        if (m_current.empty() && !matched && m_canSkip && p < lineEnd && !m_firstBytes.Contains((unsigned char)*p)) {
+            while (p < lineEnd && !m_firstBytes.Contains((unsigned char)*p))
+                p++;
+            if (p == lineEnd)
+                break;
+
+            // Marks made at the old position don't hold here
+            m_step++;
+        }
+
+        // A new thread for a match starting here, behind the ones that
+        // started earlier. Once there is a match, later starts can't win.
+        if (!matched)
+            AddThread(m_current, m_regex->m_start, p, lineStart, lineEnd, p);
+        if (m_current.empty() && (matched || p == lineEnd))
+            break;
+
+        m_step++;
+        m_next.clear();
+        for (size_t i = 0; i < m_current.size(); i++) {
+            const Thread& thread = m_current[i];
+            const Regex::Instruction& instruction = program[thread.pc];
+            if (instruction.op == Regex::OP_MATCH) {
+                if (p == thread.start)
+                    continue;
+
+                // Threads after this one have lower priority
+                matched = true;
+                matchStart = thread.start;
+                matchEnd = p;
+                break;
+            }
+            if (p < lineEnd && byteSets[instruction.arg].Contains((unsigned char)*p))
+                AddThread(m_next, instruction.next, p + 1, lineStart, lineEnd, thread.start);
+        }
+        m_current.swap(m_next);
+        if (p == lineEnd)
+            break;
+    }
+    return matched;
+}
+
+void RegexMatcher::AddClosure(int pc, std::vector<int>& pcs, std::vector<bool>& seen)
+{
+    const std::vector<Regex::Instruction>& program = m_regex->m_program;
+
+    m_stack.push_back(pc);
+    while (!m_stack.empty()) {
+        pc = m_stack.back();
+        m_stack.pop_back();
+        if (seen[pc])
+            continue;
+        seen[pc] = true;
+
+        const Regex::Instruction& instruction = program[pc];
+        switch (instruction.op) {
+        case Regex::OP_JUMP:
+        case Regex::OP_ASSERT:
+            m_stack.push_back(instruction.next);
+            break;
+
+        case Regex::OP_SPLIT:
+            m_stack.push_back(instruction.arg);
+            m_stack.push_back(instruction.next);
+            break;
+
+        default:
+            pcs.push_back(pc);
+            break;
+        }
+    }
+}
+
+int RegexMatcher::FindState(std::vector<int>& pcs)
+{
+    std::map<std::vector<int>, int>::iterator found = m_stateIndex.find(pcs);
+    if (found != m_stateIndex.end())
+        return found->second;
+
+    m_states.push_back(DFAState());
+    DFAState& state = m_states.back();
+    state.pcs.swap(pcs);
+    state.isMatch = false;
+    for (size_t i = 0; i < state.pcs.size(); i++) {
+        if (m_regex->m_program[state.pcs[i]].op == Regex::OP_MATCH)
+            state.isMatch = true;
+    }
+    m_transitions.resize(m_transitions.size() + 256, kUnknownTransition);
+
+    int index = (int)m_states.size() - 1;
+    m_stateIndex[state.pcs] = index;
+    return index;
+}
+
+int RegexMatcher::ComputeNextState(int state, unsigned char c)
+{
+    const std::vector<Regex::Instruction>& program = m_regex->m_program;
+    const std::vector<Regex::ByteSet>& byteSets = m_regex->m_byteSets;
+
+    // The threads that can take |c|, plus a match starting after it. Lines
+    // are searched on their own, so a new one starts over.
+    std::vector<int> pcs;
+    if (c == '\n') {
+        pcs = m_states[m_startState].pcs;
+    } else {
+        std::vector<bool> seen(program.size());
+        const std::vector<int>& current = m_states[state].pcs;
+        for (size_t i = 0; i < current.size(); i++) {
+            const Regex::Instruction& instruction = program[current[i]];
+            if (instruction.op == Regex::OP_BYTES && byteSets[instruction.arg].Contains(c))
+                AddClosure(instruction.next, pcs, seen);
+        }
+        AddClosure(m_regex->m_start, pcs, seen);
+        std::sort(pcs.begin(), pcs.end());
+    }
+
+    if (m_states.size() >= kMaxDFAStates) {
+        std::vector<int> startPcs = m_states[m_startState].pcs;
+        m_states.clear();
+        m_stateIndex.clear();
+        m_transitions.clear();
+        m_startState = FindState(startPcs);
+        return FindState(pcs);
+    }
+
+    int next = FindState(pcs);
+    m_transitions[state * 256 + c] = m_states[next].isMatch ? kMatchTransition : next * 256;
+    return next;
+}
+
+const char* RegexMatcher::FindCandidate(const char* from, const char* end)
+{
+    // A pattern that matches the empty string leaves every line to the VM
+    if (m_states[m_startState].isMatch)
+        return from < end ? from : NULL;
+
+    // One lookup per byte, until a transition that isn't known yet or that
+    // reaches a state that matches. States are kept as their offset in the
+    // table.
+    const int* transitions = &m_transitions[0];
+    int offset = m_startState * 256;
+    for (const char* p = from; p < end; p++) {
+        unsigned char c = (unsigned char)*p;
+        int next = transitions[offset + c];
+        if (next < 0) {
+            if (next == kMatchTransition)
+                return p;
+            int state = ComputeNextState(offset / 256, c);
+            transitions = &m_transitions[0];
+            if (m_states[state].isMatch)
+                return p;
+            next = state * 256;
+        }
+        offset = next;
+    }
+    return NULL;
+}
+
+} // namespace Brackets
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_REGEX_H
+#define _BRACKETS_REGEX_H
+
+#include "include/cef.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Brackets {
+
+/**
+ * Regular expressions in the JavaScript syntax, for searching text a line
+ * at a time without going through V8.
+ *
+ * The pattern is compiled once into a program for a Thompson NFA. Matching
+ * a line runs the program as a Pike VM, which keeps the leftmost match and
+ * the greedy, lazy and alternation priorities of a backtracking engine, so
+ * matches are the ones JS would find, but never backtracks. A lazily built
+ * DFA of the same program picks out the lines worth running the VM on, and
+ * when every match must contain some literal text the search looks for that
+ * text with LiteralMatcher instead.
+ *
+ * Supported: literals, '.', classes, \d \w \s and their negations, \b \B,
+ * '^' and '$' at the ends of lines, groups, alternation, and greedy and lazy
+ * quantifiers. Backreferences, lookaround and named groups are not; Compile
+ * returns ERR_INVALID_PARAMS for them as for any bad pattern.
+ * Matches never span lines, so classes like [^a] don't match '\n'. With
+ * REGEX_IGNORE_CASE only ASCII letters are folded, and patterns with other
+ * characters are not supported. Unlike JS, a repeated group that can match
+ * the empty string, such as (\b|x)*, may take an empty pass through it.
+ */
+class Regex : public CefBase
+{
+public:
+    enum Flags {
+        REGEX_IGNORE_CASE = 1,
+        // Matches must not have word characters right before or after them
+        REGEX_WHOLE_WORD = 2,
+    };
+
+    // Compiles the UTF-8 |pattern|. Returns NO_ERROR or ERR_INVALID_PARAMS.
+    static int Compile(const std::string& pattern, int flags, CefRefPtr<Regex>& regex);
+
+    // Text that every match contains, lower case with REGEX_IGNORE_CASE.
+    // Empty if there is none.
+    const std::string& GetRequiredLiteral() const { return m_requiredLiteral; }
+
+    int GetFlags() const { return m_flags; }
+
+private:
+    friend class RegexMatcher;
+
+    enum Opcode {
+        OP_BYTES,       // consumes a byte in m_byteSets[arg], then goes to |next|
+        OP_SPLIT,       // goes to |next|, or failing that to |arg|
+        OP_JUMP,        // goes to |next|
+        OP_ASSERT,      // goes to |next| if assertion |arg| holds here
+        OP_MATCH,
+    };
+
+    struct Instruction {
+        Opcode op;
+        int next;
+        int arg;
+    };
+
+    struct ByteSet {
+        unsigned int bits[8];
+
+        bool Contains(unsigned char c) const { return (bits[c >> 5] >> (c & 31)) & 1; }
+    };
+
+    // Parses the pattern and builds m_program, see brackets_regex.cpp
+    friend class RegexCompiler;
+
+    Regex() : m_flags(0), m_start(0) {}
+
+    int m_flags;
+    std::vector<Instruction> m_program;
+    std::vector<ByteSet> m_byteSets;
+    int m_start;
+    std::string m_requiredLiteral;
+
+    IMPLEMENT_REFCOUNTING(Regex);
+};
+
+/**
+ * Runs a Regex over text. Keeps the scratch space of the VM and the states
+ * of the DFA from search to search, so a matcher must only be used by one
+ * thread at a time; make one per thread from the same Regex.
+ */
+class RegexMatcher
+{
+public:
+    explicit RegexMatcher(CefRefPtr<Regex> regex);
+
+    // Finds the first match that starts at or after |from| on the line
+    // [lineStart, lineEnd), which must not contain '\n'. Empty matches are
+    // skipped.
+    bool FindInLine(const char* lineStart, const char* lineEnd, const char* from,
+                    const char*& matchStart, const char*& matchEnd);
+
+    // Returns a position at or after |from| on the first line that may have
+    // a match starting at or after |from|, or NULL. The DFA treats \b and
+    // the other assertions as always true, so FindInLine has the last word.
+    const char* FindCandidate(const char* from, const char* end);
+
+private:
+    struct Thread {
+        Thread(int pc, const char* start) : pc(pc), start(start) {}
+
+        int pc;
+        const char* start;      // where the match it is trying started
+    };
+
+    // Adds the thread at |pc| and every thread it leads to without
+    // consuming a byte to |threads|, in priority order, as of position |p|
+    void AddThread(std::vector<Thread>& threads, int pc, const char* p, const char* lineStart,
+                   const char* lineEnd, const char* start);
+
+    // Index of the DFA state reached from |state| on byte |c|
+    int ComputeNextState(int state, unsigned char c);
+
+    // Index of the DFA state for the sorted set of instructions |pcs|
+    int FindState(std::vector<int>& pcs);
+
+    // Adds |pc| and what it reaches without consuming a byte to |pcs|,
+    // taking every assertion to hold
+    void AddClosure(int pc, std::vector<int>& pcs, std::vector<bool>& seen);
+
+    CefRefPtr<Regex> m_regex;
+
+    // Pike VM: the threads at the current and next position, in priority
+    // order
+    std::vector<Thread> m_current;
+    std::vector<Thread> m_next;
+    std::vector<int> m_onList;          // step at which each pc was last added
+    std::vector<int> m_stack;
+    int m_step;
+
+    struct DFAState {
+        std::vector<int> pcs;
+        bool isMatch;
+    };
+    std::vector<DFAState> m_states;
+
+    // 256 entries per state: the offset of the next state on each byte, -1
+    // until it is computed, or -2 for a state that matches
+    std::vector<int> m_transitions;
+    std::map<std::vector<int>, int> m_stateIndex;
+    int m_startState;
+
+    // Bytes a match can start with. The VM skips to the next one of them
+    // when it has no threads, unless the pattern can match the empty string.
+    Regex::ByteSet m_firstBytes;
+    bool m_canSkip;
+};
+
+} // namespace Brackets
+
+#endif // _BRACKETS_REGEX_H
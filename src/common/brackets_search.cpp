@@ -0,0 +1,769 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_search.h"
+#include "common/brackets_async.h"
+#include "common/brackets_fs_extension.h"
+#include "common/brackets_search_index.h"
+#include "common/brackets_thread.h"
+
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+// Bytes in rough order of how common they are in source code, most common
+// first. memchr looks for the byte of the needle that comes last here, or
+// better one that is not listed at all.
+const char kCommonBytes[] = " etaoinsrlcdhupmf\n;,.()=_\"'gbyv/-\t:wTxSk{}ECRAI0#1>*<2LNDOPMF[]";
+
+// A file with a NUL byte this close to the start is taken to be binary
+const size_t kBinarySniffLength = 8000;
+
+// Files smaller than this are read, larger ones are mapped
+const unsigned long long kMapThreshold = 1024 * 1024;
+
+// Lines longer than this are cut around the match for the preview
+const size_t kMaxPreviewLength = 250;
+const size_t kPreviewContext = 60;
+
+// Threads searching at once, the caller included, and files searched by
+// each of them before it takes more
+const int kMaxSearchThreads = 8;
+const size_t kFilesPerItem = 32;
+
+// Matches found within this many milliseconds go to JS in one batch
+const int kSearchBatchDelayMs = 50;
+
+inline unsigned char FoldByte(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+inline bool IsLetter(unsigned char c)
+{
+    return FoldByte(c) >= 'a' && FoldByte(c) <= 'z';
+}
+
+inline bool IsWordByte(unsigned char c)
+{
+    return IsLetter(c) || (c >= '0' && c <= '9') || c == '_';
+}
+
+inline bool IsContinuationByte(char c)
+{
+    return ((unsigned char)c & 0xC0) == 0x80;
+}
+
+// How common |c| is, 0 for bytes that are not in kCommonBytes
+int ByteRank(unsigned char c)
+{
+    const char* found = c ? strchr(kCommonBytes, c) : NULL;
+    return found ? (int)(sizeof(kCommonBytes) - (found - kCommonBytes)) : 0;
+}
+
+// Length of the UTF-8 text [begin, end) in UTF-16 code units
+int UTF16Length(const char* begin, const char* end)
+{
+    int length = 0;
+    for (const char* p = begin; p < end; p++) {
+        unsigned char c = (unsigned char)*p;
+        if ((c & 0xC0) != 0x80)
+            length += c >= 0xF0 ? 2 : 1;
+    }
+    return length;
+}
+
+// Sets the preview of |match|, which starts at |matchStart| on the line
+// [lineStart, lineEnd)
+void SetPreview(const char* lineStart, const char* lineEnd, const char* matchStart, SearchMatch& match)
+{
+    const char* start = lineStart;
+    const char* end = lineEnd;
+    if ((size_t)(end - start) > kMaxPreviewLength) {
+        if ((size_t)(matchStart - start) > kPreviewContext) {
+            start = matchStart - kPreviewContext;
+            while (start > lineStart && IsContinuationByte(*start))
+                start--;
+        }
+        if ((size_t)(end - start) > kMaxPreviewLength) {
+            end = start + kMaxPreviewLength;
+            while (end < lineEnd && IsContinuationByte(*end))
+                end++;
+        }
+    }
+    match.preview.assign(start, end);
+    match.previewCh = UTF16Length(start, matchStart);
+}
+
+} // namespace
+
+///
+// LiteralMatcher
+///
+LiteralMatcher::LiteralMatcher(const std::string& needle, bool ignoreCase)
+    : m_needle(needle), m_ignoreCase(ignoreCase), m_rareIndex(0), m_rare(0), m_rareUpper(0)
+{
+    size_t length = m_needle.length();
+    if (m_ignoreCase) {
+        for (size_t i = 0; i < length; i++)
+            m_needle[i] = (char)FoldByte((unsigned char)m_needle[i]);
+    }
+
+    int rarest = INT_MAX;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)m_needle[i];
+        int rank = ByteRank(c);
+
+        // A letter costs two memchrs when the case may differ
+        if (m_ignoreCase && IsLetter(c))
+            rank += ByteRank(c - 'a' + 'A') + 1;
+        if (rank < rarest) {
+            rarest = rank;
+            m_rareIndex = i;
+        }
+    }
+    if (length > 0) {
+        m_rare = m_rareUpper = (unsigned char)m_needle[m_rareIndex];
+        if (m_ignoreCase && IsLetter(m_rare))
+            m_rareUpper = m_rare - 'a' + 'A';
+    }
+}
+
+bool LiteralMatcher::Equals(const char* text) const
+{
+    if (!m_ignoreCase)
+        return memcmp(text, m_needle.data(), m_needle.length()) == 0;
+
+    for (size_t i = 0; i < m_needle.length(); i++) {
+        if (FoldByte((unsigned char)text[i]) != (unsigned char)m_needle[i])
+            return false;
+    }
+    return true;
+}
+
+const char* LiteralMatcher::Find(const char* begin, const char* end) const
+{
+    size_t length = m_needle.length();
+    if (length == 0 || (size_t)(end - begin) < length)
+        return NULL;
+
+    // Where the rare byte of a match can be
+    const char* first = begin + m_rareIndex;
+    const char* last = end - length + m_rareIndex + 1;
+
+    // The next hit of each case at or after |from|, NULL for none. The
+    // upper case is only looked for up to the lower case hit, so a case that
+    // doesn't show up is not looked for all the way to the end.
+    const char* lower = (const char*)memchr(first, m_rare, last - first);
+    const char* upper = NULL;
+    const char* upperScanned = first;
+
+    for (const char* from = first; from < last; ) {
+        if (lower && lower < from)
+            lower = (const char*)memchr(from, m_rare, last - from);
+
+        const char* hit = lower;
+        if (m_rareUpper != m_rare) {
+            if (upper && upper < from)
+                upper = NULL;
+            if (!upper) {
+                const char* scanFrom = std::max(from, upperScanned);
+                const char* scanTo = lower ? lower : last;
+                if (scanFrom < scanTo)
+                    upper = (const char*)memchr(scanFrom, m_rareUpper, scanTo - scanFrom);
+                upperScanned = upper ? upper + 1 : std::max(scanFrom, scanTo);
+            }
+            if (upper && (!hit || upper < hit))
+                hit = upper;
+        }
+        if (!hit)
+            return NULL;
+
+        const char* start = hit - m_rareIndex;
+        if (Equals(start))
+            return start;
+        from = hit + 1;
+    }
+    return NULL;
+}
+
+///
+// LiteralSearchMatcher
+///
+LiteralSearchMatcher::LiteralSearchMatcher(const std::string& needle, bool ignoreCase, bool wholeWord)
+    : m_matcher(needle, ignoreCase), m_wholeWord(wholeWord)
+{
+}
+
+bool LiteralSearchMatcher::FindNext(const char* begin, const char* end, const char* from,
+                                    const char*& matchStart, const char*& matchEnd)
+{
+    for (const char* p = from; (matchStart = m_matcher.Find(p, end)) != NULL; p = matchStart + 1) {
+        matchEnd = matchStart + m_matcher.GetLength();
+        if (!m_wholeWord)
+            return true;
+        if ((matchStart == begin || !IsWordByte((unsigned char)matchStart[-1])) &&
+            (matchEnd == end || !IsWordByte((unsigned char)*matchEnd)))
+            return true;
+    }
+    return false;
+}
+
+///
+// RegexSearchMatcher
+///
+RegexSearchMatcher::RegexSearchMatcher(CefRefPtr<Regex> regex)
+    : m_matcher(regex), m_literal(regex->GetRequiredLiteral(), (regex->GetFlags() & Regex::REGEX_IGNORE_CASE) != 0),
+      m_useLiteral(!regex->GetRequiredLiteral().empty()), m_lineStart(NULL), m_lineEnd(NULL)
+{
+}
+
+void RegexSearchMatcher::Reset()
+{
+    m_lineStart = m_lineEnd = NULL;
+}
+
+bool RegexSearchMatcher::FindNext(const char* begin, const char* end, const char* from,
+                                  const char*& matchStart, const char*& matchEnd)
+{
+    while (from <= end) {
+        // Skips to the next line that may have a match, unless |from| is
+        // still on the last one
+        if (!m_lineStart || from < m_lineStart || from > m_lineEnd) {
+            const char* candidate = m_useLiteral ? m_literal.Find(from, end) : m_matcher.FindCandidate(from, end);
+            if (!candidate)
+                return false;
+
+            m_lineStart = candidate;
+            while (m_lineStart > begin && m_lineStart[-1] != '\n')
+                m_lineStart--;
+            m_lineEnd = (const char*)memchr(candidate, '\n', end - candidate);
+            if (!m_lineEnd)
+                m_lineEnd = end;
+        }
+
+        if (m_matcher.FindInLine(m_lineStart, m_lineEnd, std::max(from, m_lineStart), matchStart, matchEnd))
+            return true;
+
+        from = m_lineEnd + 1;
+        m_lineStart = m_lineEnd = NULL;
+    }
+    return false;
+}
+
+///
+// Searching files
+///
+bool IsBinary(const char* data, size_t length)
+{
+    return memchr(data, 0, std::min(length, kBinarySniffLength)) != NULL;
+}
+
+SearchFileKind SearchBuffer(SearchMatcher& matcher, const char* data, size_t length,
+                            size_t maxMatches, std::vector<SearchMatch>& matches)
+{
+    if (IsBinary(data, length))
+        return SEARCH_BINARY;
+
+    matcher.Reset();
+
+    const char* end = data + length;
+    size_t first = matches.size();
+
+    // Lines are counted as matches are found, and columns from the previous
+    // match on the same line, so a file is only scanned once more however
+    // many matches it has
+    int line = 0;
+    const char* lineStart = data;
+    const char* lineEnd = NULL;
+    const char* counted = data;
+    const char* column = data;
+    int ch = 0;
+
+    for (const char* p = data; matches.size() - first < maxMatches; ) {
+        const char* matchStart;
+        const char* matchEnd;
+        if (!matcher.FindNext(data, end, p, matchStart, matchEnd))
+            break;
+
+        const char* newline;
+        while ((newline = (const char*)memchr(counted, '\n', matchStart - counted)) != NULL) {
+            line++;
+            counted = lineStart = newline + 1;
+        }
+        counted = matchStart;
+        if (column < lineStart) {
+            column = lineStart;
+            ch = 0;
+            lineEnd = NULL;
+        }
+        if (!lineEnd) {
+            lineEnd = (const char*)memchr(matchStart, '\n', end - matchStart);
+            if (!lineEnd)
+                lineEnd = end;
+        }
+
+        ch += UTF16Length(column, matchStart);
+        column = matchStart;
+
+        matches.push_back(SearchMatch());
+        SearchMatch& match = matches.back();
+        match.line = line;
+        match.ch = ch;
+        match.length = UTF16Length(matchStart, matchEnd);
+        const char* previewEnd = lineEnd;
+        if (previewEnd > lineStart && previewEnd[-1] == '\r')
+            previewEnd--;
+        SetPreview(lineStart, std::max(previewEnd, matchStart), matchStart, match);
+
+        p = matchEnd;
+    }
+
+    // Text that is not UTF-8 can't be shown, and ReadFile would refuse it
+    if (matches.size() > first && !IsValidUTF8(data, length)) {
+        matches.resize(first);
+        return SEARCH_NOT_UTF8;
+    }
+    return SEARCH_TEXT;
+}
+
+int SearchFile(const ExtensionString& path, SearchMatcher& matcher, size_t maxMatches,
+               std::vector<char>& buffer, std::vector<SearchMatch>& matches, SearchFileKind& kind)
+{
+    kind = SEARCH_TEXT;
+
+    PlatformFile file;
+    int error = OpenFileForReading(path, file);
+    if (error != NO_ERROR)
+        return error;
+
+    unsigned long long size = 0;
+    error = GetOpenFileSize(file, size);
+    if (error == NO_ERROR && size != (size_t)size)
+        error = ERR_CANT_READ;
+
+    if (error == NO_ERROR && size < kMapThreshold) {
+        if (buffer.size() < size + 1)
+            buffer.resize((size_t)size + 1);
+        size_t bytesRead = 0;
+        error = ReadFileAt(file, 0, &buffer[0], (size_t)size, bytesRead);
+        if (error == NO_ERROR)
+            kind = SearchBuffer(matcher, &buffer[0], bytesRead, maxMatches, matches);
+    } else if (error == NO_ERROR) {
+        MappedFile mapped;
+        error = MapFile(file, (size_t)size, mapped);
+        if (error == NO_ERROR) {
+            kind = SearchBuffer(matcher, mapped.data, mapped.length, maxMatches, matches);
+            UnmapFile(mapped);
+        }
+    }
+
+    CloseFile(file);
+    return error;
+}
+
+namespace {
+
+// The matches of one file, waiting to go to JS
+struct FileMatches {
+    ExtensionString path;
+    std::vector<SearchMatch> matches;
+};
+
+// Runs SearchFilesAsync: walks the directories it was given to find the
+// files, then searches them in parallel, kFilesPerItem at a time. With an
+// index, files it shows can't match are left out as they are found.
+class SearchFilesOperation : public AsyncOperation, public WalkSink, public ParallelWork
+{
+public:
+    // Searches for |regex| if there is one, otherwise for |query|
+    SearchFilesOperation(const std::vector<ExtensionString>& paths, const std::string& query, bool ignoreCase,
+                         bool wholeWord, CefRefPtr<Regex> regex, const WalkOptions& walkOptions,
+                         const std::vector<ExtensionString>& include, size_t maxMatches,
+                         CefRefPtr<SearchIndex> index)
+        : m_paths(paths), m_query(query), m_ignoreCase(ignoreCase), m_wholeWord(wholeWord), m_regex(regex),
+          m_walkOptions(walkOptions), m_include(include), m_maxMatches(maxMatches), m_index(index),
+          m_hasCandidates(false), m_searched(0), m_reported(0), m_matchedFiles(0), m_matchCount(0),
+          m_binary(0), m_unreadable(0), m_ruledOut(0) {}
+
+    // WalkSink
+    virtual void AddEntries(size_t root, std::vector<DirEntry>& entries);
+    virtual bool IsCancelled() const { return AsyncOperation::IsCancelled(); }
+
+    // ParallelWork
+    virtual void RunItem(size_t index);
+
+    // progress(results, searched, total)
+    virtual bool TakeProgress(CefV8ValueList& arguments);
+
+    virtual CefRefPtr<CefV8Value> GetResult();
+
+protected:
+    virtual int Run();
+
+private:
+    bool IsIncluded(const ExtensionString& relative) const;
+
+    // Whether the index shows that |entry|, under roots[root], has nothing
+    // to search
+    bool IsRuledOut(size_t root, const DirEntry& entry);
+
+    // Searches the files of item |index| with |matcher|
+    void SearchFiles(size_t index, SearchMatcher& matcher);
+
+    // Records what searching m_files[index] found
+    void AddResult(size_t index, int error, SearchFileKind kind, std::vector<SearchMatch>& matches);
+
+    std::vector<ExtensionString> m_paths;
+    std::vector<ExtensionString> m_roots;
+    std::string m_query;
+    bool m_ignoreCase;
+    bool m_wholeWord;
+    CefRefPtr<Regex> m_regex;
+    WalkOptions m_walkOptions;
+    std::vector<ExtensionString> m_include;
+    size_t m_maxMatches;
+
+    // Set up before the walk, then read-only
+    CefRefPtr<SearchIndex> m_index;
+    std::vector<bool> m_candidates;
+    bool m_hasCandidates;
+    std::vector<bool> m_rootIndexed;
+    std::vector<std::string> m_rootPrefixes;    // root relative to the index root, with a '/'
+
+    // Filled in by the walk, then read-only while the files are searched
+    Lock m_filesLock;
+    std::vector<ExtensionString> m_files;
+
+    Lock m_resultsLock;
+    std::vector<FileMatches> m_pending;
+    size_t m_searched;
+    size_t m_reported;                  // m_searched at the last progress call
+    size_t m_matchedFiles;
+    size_t m_matchCount;
+    size_t m_binary;
+    size_t m_unreadable;
+    size_t m_ruledOut;
+    AtomicFlag m_limitReached;
+};
+
+bool SearchFilesOperation::IsIncluded(const ExtensionString& relative) const
+{
+    if (m_include.empty())
+        return true;
+
+    // Patterns with a '/' match the path below the root, others the name
+    size_t slash = relative.rfind('/');
+    ExtensionString name = slash == ExtensionString::npos ? relative : relative.substr(slash + 1);
+    for (size_t i = 0; i < m_include.size(); i++) {
+        bool hasSlash = m_include[i].find('/') != ExtensionString::npos;
+        if (MatchGlob(m_include[i], hasSlash ? relative : name))
+            return true;
+    }
+    return false;
+}
+
+bool SearchFilesOperation::IsRuledOut(size_t root, const DirEntry& entry)
+{
+    if (!m_index.get() || !m_rootIndexed[root])
+        return false;
+
+    int file = m_index->FindFile(m_rootPrefixes[root] + ToIndexPath(entry.name));
+    if (file < 0 || !(m_index->GetFlags(file) & SearchIndex::FILE_INDEXED) || !m_index->IsCurrent(file, entry.info))
+        return false;
+
+    bool binary = (m_index->GetFlags(file) & SearchIndex::FILE_BINARY) != 0;
+    if (!binary && (!m_hasCandidates || m_candidates[file]))
+        return false;
+
+    AutoLock lock(m_resultsLock);
+    m_ruledOut++;
+    if (binary)
+        m_binary++;
+    return true;
+}
+
+void SearchFilesOperation::AddEntries(size_t root, std::vector<DirEntry>& entries)
+{
+    std::vector<ExtensionString> files;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!entries[i].info.isDirectory && IsIncluded(entries[i].name) && !IsRuledOut(root, entries[i]))
+            files.push_back(m_roots[root] + '/' + entries[i].name);
+    }
+
+    AutoLock lock(m_filesLock);
+    m_files.insert(m_files.end(), files.begin(), files.end());
+}
+
+int SearchFilesOperation::Run()
+{
+    // Directories are walked, files are searched as they are
+    for (size_t i = 0; i < m_paths.size(); i++) {
+        FileInfo info;
+        if (GetFileInfo(m_paths[i], info) != NO_ERROR) {
+            m_unreadable++;
+        } else if (info.isDirectory) {
+            ExtensionString root = m_paths[i];
+            while (root.length() > 1 && root[root.length() - 1] == '/')
+                root.erase(root.length() - 1);
+            m_roots.push_back(root);
+        } else {
+            m_files.push_back(m_paths[i]);
+        }
+    }
+
+    if (m_index.get()) {
+        // A regex is narrowed down by the literal all its matches contain
+        const std::string& text = m_regex.get() ? m_regex->GetRequiredLiteral() : m_query;
+        m_hasCandidates = m_index->FindCandidates(text, m_candidates);
+
+        const std::string& indexRoot = m_index->GetRoot();
+        for (size_t i = 0; i < m_roots.size(); i++) {
+            std::string root = ToIndexPath(m_roots[i]);
+            bool below = root.length() > indexRoot.length() && root.compare(0, indexRoot.length(), indexRoot) == 0 &&
+                         root[indexRoot.length()] == '/';
+            m_rootIndexed.push_back(root == indexRoot || below);
+            m_rootPrefixes.push_back(below ? root.substr(indexRoot.length() + 1) + '/' : std::string());
+        }
+    }
+
+    if (!m_roots.empty()) {
+        WalkStats stats;
+        int error = WalkTree(m_roots, m_walkOptions, *this, stats);
+        if (error != NO_ERROR)
+            return error;
+        m_unreadable += stats.unreadable;
+    }
+
+    PostProgress(kSearchBatchDelayMs);
+    ParallelFor(*this, (m_files.size() + kFilesPerItem - 1) / kFilesPerItem, kMaxSearchThreads);
+    return IsCancelled() ? ERR_CANCELLED : NO_ERROR;
+}
+
+void SearchFilesOperation::RunItem(size_t index)
+{
+    // Regex matchers keep scratch space and DFA states, so every item has
+    // its own
+    if (m_regex.get()) {
+        RegexSearchMatcher matcher(m_regex);
+        SearchFiles(index, matcher);
+    } else {
+        LiteralSearchMatcher matcher(m_query, m_ignoreCase, m_wholeWord);
+        SearchFiles(index, matcher);
+    }
+}
+
+void SearchFilesOperation::SearchFiles(size_t index, SearchMatcher& matcher)
+{
+    std::vector<char> buffer;
+    size_t end = std::min(m_files.size(), (index + 1) * kFilesPerItem);
+    for (size_t i = index * kFilesPerItem; i < end; i++) {
+        if (IsCancelled() || m_limitReached.IsSet())
+            return;
+
+        std::vector<SearchMatch> matches;
+        SearchFileKind kind;
+        int error = SearchFile(m_files[i], matcher, m_maxMatches, buffer, matches, kind);
+        AddResult(i, error, kind, matches);
+    }
+}
+
+void SearchFilesOperation::AddResult(size_t index, int error, SearchFileKind kind,
+                                     std::vector<SearchMatch>& matches)
+{
+    {
+        AutoLock lock(m_resultsLock);
+        m_searched++;
+        if (error != NO_ERROR)
+            m_unreadable++;
+        else if (kind != SEARCH_TEXT)
+            m_binary++;
+
+        if (!matches.empty()) {
+            // Other threads may have used up the limit in the meantime
+            size_t remaining = m_maxMatches - std::min(m_maxMatches, m_matchCount);
+            if (matches.size() >= remaining) {
+                matches.resize(remaining);
+                m_limitReached.Set();
+            }
+            if (!matches.empty()) {
+                m_pending.push_back(FileMatches());
+                m_pending.back().path = m_files[index];
+                m_pending.back().matches.swap(matches);
+                m_matchedFiles++;
+                m_matchCount += m_pending.back().matches.size();
+            }
+        }
+    }
+    PostProgress(kSearchBatchDelayMs);
+}
+
+bool SearchFilesOperation::TakeProgress(CefV8ValueList& arguments)
+{
+    std::vector<FileMatches> results;
+    size_t searched;
+    {
+        AutoLock lock(m_resultsLock);
+        if (m_pending.empty() && m_searched == m_reported)
+            return false;
+        results.swap(m_pending);
+        searched = m_reported = m_searched;
+    }
+
+    CefRefPtr<CefV8Value> resultArray = CefV8Value::CreateArray();
+    for (size_t i = 0; i < results.size(); i++) {
+        CefRefPtr<CefV8Value> matchArray = CefV8Value::CreateArray();
+        for (size_t j = 0; j < results[i].matches.size(); j++) {
+            const SearchMatch& match = results[i].matches[j];
+            CefRefPtr<CefV8Value> item = CefV8Value::CreateObject(NULL);
+            item->SetValue("line", CefV8Value::CreateInt(match.line), V8_PROPERTY_ATTRIBUTE_NONE);
+            item->SetValue("ch", CefV8Value::CreateInt(match.ch), V8_PROPERTY_ATTRIBUTE_NONE);
+            item->SetValue("length", CefV8Value::CreateInt(match.length), V8_PROPERTY_ATTRIBUTE_NONE);
+            item->SetValue("preview", CefV8Value::CreateString(match.preview), V8_PROPERTY_ATTRIBUTE_NONE);
+            item->SetValue("previewCh", CefV8Value::CreateInt(match.previewCh), V8_PROPERTY_ATTRIBUTE_NONE);
+            matchArray->SetValue((int)j, item);
+        }
+
+        CefRefPtr<CefV8Value> result = CefV8Value::CreateObject(NULL);
+        result->SetValue("path", CefV8Value::CreateString(results[i].path), V8_PROPERTY_ATTRIBUTE_NONE);
+        result->SetValue("matches", matchArray, V8_PROPERTY_ATTRIBUTE_NONE);
+        resultArray->SetValue((int)i, result);
+    }
+
+    arguments.push_back(resultArray);
+    arguments.push_back(CefV8Value::CreateDouble((double)searched));
+    arguments.push_back(CefV8Value::CreateDouble((double)m_files.size()));
+    return true;
+}
+
+CefRefPtr<CefV8Value> SearchFilesOperation::GetResult()
+{
+    CefRefPtr<CefV8Value> result = CefV8Value::CreateObject(NULL);
+    result->SetValue("files", CefV8Value::CreateDouble((double)(m_searched + m_ruledOut)), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("matchedFiles", CefV8Value::CreateDouble((double)m_matchedFiles), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("matches", CefV8Value::CreateDouble((double)m_matchCount), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("binary", CefV8Value::CreateDouble((double)m_binary), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("unreadable", CefV8Value::CreateDouble((double)m_unreadable), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("ruledOut", CefV8Value::CreateDouble((double)m_ruledOut), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("limitReached", CefV8Value::CreateBool(m_limitReached.IsSet()), V8_PROPERTY_ATTRIBUTE_NONE);
+    return result;
+}
+
+} // namespace
+
+int ExecuteSearchFilesAsync(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception)
+{
+    if (arguments.size() < 5 || !arguments[0]->IsArray() || !arguments[1]->IsString())
+        return ERR_INVALID_PARAMS;
+
+    std::vector<ExtensionString> paths;
+    for (int i = 0; i < arguments[0]->GetArrayLength(); i++) {
+        CefRefPtr<CefV8Value> path = arguments[0]->GetValue(i);
+        if (!path->IsString())
+            return ERR_INVALID_PARAMS;
+        paths.push_back(path->GetStringValue());
+    }
+
+    // Matches are reported by line, so the query can't span lines
+    std::string query;
+    GetUTF8StringValue(arguments[1], query);
+    if (query.empty() || query.find('\n') != std::string::npos)
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<CefV8Value> options = arguments[2];
+    WalkOptions walkOptions;
+    if (!GetWalkOptions(options, walkOptions))
+        return ERR_INVALID_PARAMS;
+
+    bool ignoreCase = true;
+    if (options->HasValue("caseSensitive")) {
+        if (!options->GetValue("caseSensitive")->IsBool())
+            return ERR_INVALID_PARAMS;
+        ignoreCase = !options->GetValue("caseSensitive")->GetBoolValue();
+    }
+
+    std::vector<ExtensionString> include;
+    if (options->HasValue("include")) {
+        CefRefPtr<CefV8Value> patterns = options->GetValue("include");
+        if (!patterns->IsArray())
+            return ERR_INVALID_PARAMS;
+        for (int i = 0; i < patterns->GetArrayLength(); i++) {
+            if (!patterns->GetValue(i)->IsString())
+                return ERR_INVALID_PARAMS;
+            include.push_back(patterns->GetValue(i)->GetStringValue());
+        }
+    }
+
+    bool wholeWord = false;
+    if (options->HasValue("wholeWord")) {
+        if (!options->GetValue("wholeWord")->IsBool())
+            return ERR_INVALID_PARAMS;
+        wholeWord = options->GetValue("wholeWord")->GetBoolValue();
+    }
+
+    // Patterns the engine doesn't support are refused up front, so the
+    // caller can fall back to searching with a JS RegExp
+    CefRefPtr<Regex> regex;
+    if (options->HasValue("regex")) {
+        if (!options->GetValue("regex")->IsBool())
+            return ERR_INVALID_PARAMS;
+        if (options->GetValue("regex")->GetBoolValue()) {
+            int flags = (ignoreCase ? Regex::REGEX_IGNORE_CASE : 0) | (wholeWord ? Regex::REGEX_WHOLE_WORD : 0);
+            int error = Regex::Compile(query, flags, regex);
+            if (error != NO_ERROR)
+                return error;
+        }
+    }
+
+    size_t maxMatches = 10000;
+    if (options->HasValue("maxMatches")) {
+        CefRefPtr<CefV8Value> value = options->GetValue("maxMatches");
+        if (!value->IsInt() || value->GetIntValue() < 1)
+            return ERR_INVALID_PARAMS;
+        maxMatches = (size_t)value->GetIntValue();
+    }
+
+    // An index that can't be opened only makes the search slower, so the
+    // search goes ahead without it
+    CefRefPtr<SearchIndex> index;
+    if (options->HasValue("index")) {
+        if (!options->GetValue("index")->IsString())
+            return ERR_INVALID_PARAMS;
+        if (GetSearchIndex(options->GetValue("index")->GetStringValue(), index) == NO_ERROR)
+            walkOptions.withStats = true;
+    }
+
+    CefRefPtr<AsyncOperation> operation =
+        new SearchFilesOperation(paths, query, ignoreCase, wholeWord, regex, walkOptions, include, maxMatches, index);
+    return operation->Start(arguments, 3, 4, retval);
+}
+
+} // namespace FileSystem
+} // namespace Brackets
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_SEARCH_H
+#define _BRACKETS_SEARCH_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_regex.h"
+#include "common/brackets_walker.h"
+
+#include <string>
+#include <vector>
+
+namespace Brackets {
+namespace FileSystem {
+
+/**
+ * Finds a literal string of bytes. Searches memchr for the byte of the
+ * needle that is least common in source code and compare the rest around
+ * each hit, which lets the C library's vectorized memchr skip over most of
+ * the text. When case is ignored and that byte is a letter, both of its
+ * cases are looked for, each with its own memchr. Read-only once built and
+ * may be shared by threads.
+ */
+class LiteralMatcher
+{
+public:
+    // With |ignoreCase|, ASCII letters match either case. Other bytes,
+    // UTF-8 sequences included, must be equal.
+    LiteralMatcher(const std::string& needle, bool ignoreCase);
+
+    // First match in [begin, end), or NULL
+    const char* Find(const char* begin, const char* end) const;
+
+    size_t GetLength() const { return m_needle.length(); }
+
+private:
+    bool Equals(const char* text) const;
+
+    std::string m_needle;       // lower case with |m_ignoreCase|
+    bool m_ignoreCase;
+    size_t m_rareIndex;         // byte of the needle memchr looks for
+    unsigned char m_rare;
+    unsigned char m_rareUpper;  // its upper case, or |m_rare|
+};
+
+/**
+ * What SearchBuffer looks for. Matches never span lines. A matcher may keep
+ * state from one call to the next, so each thread needs its own.
+ */
+class SearchMatcher
+{
+public:
+    virtual ~SearchMatcher() {}
+
+    // Called before searching the text at |begin|
+    virtual void Reset() {}
+
+    // Finds the first match in the text [begin, end) that starts at or after
+    // |from|, which is never inside an earlier match
+    virtual bool FindNext(const char* begin, const char* end, const char* from,
+                          const char*& matchStart, const char*& matchEnd) = 0;
+};
+
+// Finds a string with LiteralMatcher, optionally only as a whole word
+class LiteralSearchMatcher : public SearchMatcher
+{
+public:
+    LiteralSearchMatcher(const std::string& needle, bool ignoreCase, bool wholeWord);
+
+    virtual bool FindNext(const char* begin, const char* end, const char* from,
+                          const char*& matchStart, const char*& matchEnd);
+
+private:
+    LiteralMatcher m_matcher;
+    bool m_wholeWord;
+};
+
+// Finds matches of a Regex. Only the lines that have the literal every match
+// contains, or else that the DFA says may match, go through the VM.
+class RegexSearchMatcher : public SearchMatcher
+{
+public:
+    explicit RegexSearchMatcher(CefRefPtr<Regex> regex);
+
+    virtual void Reset();
+    virtual bool FindNext(const char* begin, const char* end, const char* from,
+                          const char*& matchStart, const char*& matchEnd);
+
+private:
+    RegexMatcher m_matcher;
+    LiteralMatcher m_literal;
+    bool m_useLiteral;
+
+    // The line the last candidate was on, NULL when there is none
+    const char* m_lineStart;
+    const char* m_lineEnd;
+};
+
+// One match. Lines and columns count from 0, columns and lengths in UTF-16
+// code units as in JS strings.
+struct SearchMatch {
+    int line;
+    int ch;
+    int length;
+    std::string preview;        // UTF-8 text of the line, cut when long
+    int previewCh;              // column of the match in |preview|
+};
+
+// Whether the |length| bytes at |data| look like a binary file rather than
+// text: there is a NUL byte near the start
+bool IsBinary(const char* data, size_t length);
+
+// How SearchBuffer and SearchFile saw a file
+enum SearchFileKind {
+    SEARCH_TEXT = 0,
+    SEARCH_BINARY,              // a NUL byte near the start
+    SEARCH_NOT_UTF8,            // has matches, but is not valid UTF-8
+};
+
+// Finds up to |maxMatches| non-overlapping matches in |length| bytes of
+// UTF-8 text at |data|
+SearchFileKind SearchBuffer(SearchMatcher& matcher, const char* data, size_t length,
+                            size_t maxMatches, std::vector<SearchMatch>& matches);
+
+// Same for the file at |path|. Small files are read into |buffer|, which is
+// reused from call to call, and large ones are mapped.
+int SearchFile(const ExtensionString& path, SearchMatcher& matcher, size_t maxMatches,
+               std::vector<char>& buffer, std::vector<SearchMatch>& matches, SearchFileKind& kind);
+
+// SearchFilesAsync, registered by brackets_fs_extension.cpp
+int ExecuteSearchFilesAsync(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception);
+
+} // namespace FileSystem
+} // namespace Brackets
+
+#endif // _BRACKETS_SEARCH_H
@@ -0,0 +1,860 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_search_index.h"
+#include "common/brackets_async.h"
+#include "common/brackets_fs_extension.h"
+#include "common/brackets_search.h"
+#include "common/brackets_thread.h"
+#include "common/brackets_walker.h"
+
+#include <string.h>
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+namespace Brackets {
+namespace FileSystem {
+
+/**
+ * Layout of an index file, in the byte order of the machine that wrote it:
+ *
+ *   Header
+ *   FileRecord[fileCount]          sorted by path
+ *   TrigramRecord[trigramCount]    sorted by trigram
+ *   postings                       per trigram, the indexes of its files in
+ *                                  increasing order, each as the difference
+ *                                  from the one before in LEB128
+ *   strings                        the root, then the paths, each ending
+ *                                  with a NUL
+ *
+ * An index written on a machine with the other byte order fails the magic
+ * check and is built again.
+ */
+struct SearchIndex::Header {
+    char magic[4];
+    unsigned int version;
+    unsigned int fileCount;
+    unsigned int trigramCount;
+    unsigned int filesOffset;
+    unsigned int trigramsOffset;
+    unsigned int postingsOffset;
+    unsigned int stringsOffset;
+    unsigned int totalSize;
+    unsigned int reserved;
+};
+
+struct SearchIndex::FileRecord {
+    unsigned int path;          // offset in the strings
+    unsigned int flags;
+    unsigned long long size;
+    long long mtimeSec;
+    unsigned int mtimeNsec;
+    unsigned int reserved;
+};
+
+struct SearchIndex::TrigramRecord {
+    unsigned int trigram;
+    unsigned int postings;      // offset in the postings
+    unsigned int count;
+};
+
+namespace {
+
+const char kIndexMagic[4] = { 'B', 'R', 'T', 'I' };
+const unsigned int kIndexVersion = 1;
+
+// Files larger than this are not indexed, and always searched
+const unsigned long long kDefaultMaxFileSize = 1024 * 1024;
+
+// Threads reading files at once, the caller included, and files read by
+// each of them before it takes more
+const int kMaxIndexThreads = 8;
+const size_t kFilesPerItem = 32;
+
+const int kIndexProgressDelayMs = 100;
+
+// Size of the table GetTrigrams weeds out repeated trigrams with
+const int kRecentTrigramBits = 12;
+const size_t kRecentTrigrams = 1 << kRecentTrigramBits;
+
+inline unsigned char FoldByte(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+inline size_t Align(size_t offset)
+{
+    return (offset + 7) & ~(size_t)7;
+}
+
+void AppendVarint(std::string& out, unsigned int value)
+{
+    while (value >= 0x80) {
+        out += (char)(0x80 | (value & 0x7F));
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+template <class T>
+void AppendRecord(std::string& out, const T& record)
+{
+    out.append((const char*)&record, sizeof(record));
+}
+
+// Keeps the indexes that are open, so searches don't map them again
+class SearchIndexCache
+{
+public:
+    static SearchIndexCache& GetInstance();
+
+    int Get(const ExtensionString& path, CefRefPtr<SearchIndex>& index);
+
+    // Lets go of the index at |path|, so that it can be replaced on Windows,
+    // where a file can't be while it is mapped
+    void Remove(const ExtensionString& path);
+
+private:
+    struct Entry {
+        CefRefPtr<SearchIndex> index;
+        FileInfo info;          // of the index file when it was opened
+    };
+
+    Lock m_lock;
+    std::map<ExtensionString, Entry> m_entries;
+};
+
+SearchIndexCache& SearchIndexCache::GetInstance()
+{
+    // Created on the UI thread by the first SearchFilesAsync or
+    // BuildSearchIndexAsync that names an index
+    static SearchIndexCache* s_instance = NULL;
+    if (!s_instance)
+        s_instance = new SearchIndexCache();
+    return *s_instance;
+}
+
+int SearchIndexCache::Get(const ExtensionString& path, CefRefPtr<SearchIndex>& index)
+{
+    FileInfo info;
+    int error = GetFileInfo(path, info);
+    AutoLock lock(m_lock);
+    if (error != NO_ERROR) {
+        m_entries.erase(path);
+        return error;
+    }
+
+    std::map<ExtensionString, Entry>::iterator found = m_entries.find(path);
+    if (found != m_entries.end() && found->second.info.size == info.size &&
+        found->second.info.mtimeSec == info.mtimeSec && found->second.info.mtimeNsec == info.mtimeNsec) {
+        index = found->second.index;
+        return NO_ERROR;
+    }
+
+    error = SearchIndex::Open(path, index);
+    if (error != NO_ERROR) {
+        m_entries.erase(path);
+        return error;
+    }
+    Entry& entry = m_entries[path];
+    entry.index = index;
+    entry.info = info;
+    return NO_ERROR;
+}
+
+void SearchIndexCache::Remove(const ExtensionString& path)
+{
+    AutoLock lock(m_lock);
+    m_entries.erase(path);
+}
+
+} // namespace
+
+///
+// SearchIndex
+///
+SearchIndex::SearchIndex()
+    : m_fileCount(0), m_trigramCount(0), m_files(NULL), m_trigrams(NULL), m_postings(NULL),
+      m_postingsEnd(NULL), m_strings(NULL), m_stringsLength(0)
+{
+}
+
+SearchIndex::~SearchIndex()
+{
+    UnmapFile(m_mapped);
+}
+
+int SearchIndex::Open(const ExtensionString& path, CefRefPtr<SearchIndex>& index)
+{
+    PlatformFile file;
+    int error = OpenFileForReading(path, file);
+    if (error != NO_ERROR)
+        return error;
+
+    unsigned long long size = 0;
+    error = GetOpenFileSize(file, size);
+    if (error == NO_ERROR && (size < sizeof(Header) || size > 0xFFFFFFFFu))
+        error = ERR_CANT_READ;
+
+    CefRefPtr<SearchIndex> opened = new SearchIndex();
+    if (error == NO_ERROR)
+        error = MapFile(file, (size_t)size, opened->m_mapped);
+    CloseFile(file);
+    if (error != NO_ERROR)
+        return error;
+
+    // Everything the lookups rely on is checked here, so that a damaged
+    // index is refused rather than read past its end
+    const char* data = opened->m_mapped.data;
+    const Header* header = (const Header*)data;
+    size_t length = opened->m_mapped.length;
+    if (memcmp(header->magic, kIndexMagic, sizeof(kIndexMagic)) != 0 || header->version != kIndexVersion ||
+        header->totalSize != length || header->filesOffset != Align(sizeof(Header)) ||
+        header->trigramsOffset < header->filesOffset || header->trigramsOffset % 4 != 0 ||
+        (header->trigramsOffset - header->filesOffset) / sizeof(FileRecord) < header->fileCount ||
+        header->postingsOffset < header->trigramsOffset ||
+        (header->postingsOffset - header->trigramsOffset) / sizeof(TrigramRecord) < header->trigramCount ||
+        header->stringsOffset < header->postingsOffset || header->stringsOffset >= length ||
+        data[length - 1] != '\0')
+        return ERR_CANT_READ;
+
+    opened->m_fileCount = header->fileCount;
+    opened->m_trigramCount = header->trigramCount;
+    opened->m_files = (const FileRecord*)(data + header->filesOffset);
+    opened->m_trigrams = (const TrigramRecord*)(data + header->trigramsOffset);
+    opened->m_postings = (const unsigned char*)data + header->postingsOffset;
+    opened->m_postingsEnd = (const unsigned char*)data + header->stringsOffset;
+    opened->m_strings = data + header->stringsOffset;
+    opened->m_stringsLength = length - header->stringsOffset;
+    opened->m_root = opened->m_strings;
+
+    for (size_t i = 0; i < opened->m_fileCount; i++) {
+        if (opened->m_files[i].path >= opened->m_stringsLength)
+            return ERR_CANT_READ;
+    }
+
+    index = opened;
+    return NO_ERROR;
+}
+
+const SearchIndex::FileRecord& SearchIndex::GetFile(int file) const
+{
+    return m_files[file];
+}
+
+const char* SearchIndex::GetPath(int file) const
+{
+    return m_strings + m_files[file].path;
+}
+
+unsigned int SearchIndex::GetFlags(int file) const
+{
+    return m_files[file].flags;
+}
+
+int SearchIndex::FindFile(const std::string& path) const
+{
+    size_t low = 0;
+    size_t high = m_fileCount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        int order = strcmp(GetPath((int)middle), path.c_str());
+        if (order == 0)
+            return (int)middle;
+        if (order < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return -1;
+}
+
+bool SearchIndex::IsCurrent(int file, const FileInfo& info) const
+{
+    const FileRecord& record = GetFile(file);
+    return !info.isDirectory && record.size == info.size && record.mtimeSec == info.mtimeSec &&
+           record.mtimeNsec == (unsigned int)info.mtimeNsec;
+}
+
+const SearchIndex::TrigramRecord* SearchIndex::FindTrigram(unsigned int trigram) const
+{
+    size_t low = 0;
+    size_t high = m_trigramCount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (m_trigrams[middle].trigram == trigram)
+            return &m_trigrams[middle];
+        if (m_trigrams[middle].trigram < trigram)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return NULL;
+}
+
+void SearchIndex::ReadPostings(const TrigramRecord& record, std::vector<int>& files) const
+{
+    if (record.postings >= (size_t)(m_postingsEnd - m_postings))
+        return;
+
+    const unsigned char* p = m_postings + record.postings;
+    unsigned int file = 0;
+    for (unsigned int i = 0; i < record.count && p < m_postingsEnd; i++) {
+        unsigned int delta = 0;
+        for (int shift = 0; p < m_postingsEnd && shift < 32; shift += 7) {
+            unsigned char c = *p++;
+            delta |= (unsigned int)(c & 0x7F) << shift;
+            if (!(c & 0x80))
+                break;
+        }
+        file += delta;
+        if (file >= m_fileCount)
+            return;
+        files.push_back((int)file);
+    }
+}
+
+bool SearchIndex::FindCandidates(const std::string& text, std::vector<bool>& candidates) const
+{
+    std::vector<unsigned int> trigrams;
+    GetTrigrams(text.data(), text.length(), trigrams);
+    if (trigrams.empty())
+        return false;
+
+    // Intersects the lists of the trigrams, starting from the shortest
+    std::vector<const TrigramRecord*> records;
+    for (size_t i = 0; i < trigrams.size(); i++) {
+        const TrigramRecord* record = FindTrigram(trigrams[i]);
+        if (!record) {
+            candidates.assign(m_fileCount, false);
+            return true;
+        }
+        records.push_back(record);
+    }
+    std::vector<std::pair<unsigned int, const TrigramRecord*> > bySize;
+    for (size_t i = 0; i < records.size(); i++)
+        bySize.push_back(std::make_pair(records[i]->count, records[i]));
+    std::sort(bySize.begin(), bySize.end());
+
+    std::vector<int> files, next, both;
+    ReadPostings(*bySize[0].second, files);
+    for (size_t i = 1; i < bySize.size() && !files.empty(); i++) {
+        next.clear();
+        ReadPostings(*bySize[i].second, next);
+        both.clear();
+        std::set_intersection(files.begin(), files.end(), next.begin(), next.end(), std::back_inserter(both));
+        files.swap(both);
+    }
+
+    candidates.assign(m_fileCount, false);
+    for (size_t i = 0; i < files.size(); i++)
+        candidates[files[i]] = true;
+    return true;
+}
+
+void SearchIndex::GetFileTrigrams(std::vector<std::vector<unsigned int> >& trigrams) const
+{
+    // The postings are read twice, to size each list and then to fill it
+    std::vector<unsigned int> counts(m_fileCount, 0);
+    std::vector<int> files;
+    for (size_t i = 0; i < m_trigramCount; i++) {
+        files.clear();
+        ReadPostings(m_trigrams[i], files);
+        for (size_t j = 0; j < files.size(); j++)
+            counts[files[j]]++;
+    }
+
+    trigrams.assign(m_fileCount, std::vector<unsigned int>());
+    for (size_t i = 0; i < m_fileCount; i++)
+        trigrams[i].reserve(counts[i]);
+    for (size_t i = 0; i < m_trigramCount; i++) {
+        files.clear();
+        ReadPostings(m_trigrams[i], files);
+        for (size_t j = 0; j < files.size(); j++)
+            trigrams[files[j]].push_back(m_trigrams[i].trigram);
+    }
+}
+
+void GetTrigrams(const char* data, size_t length, std::vector<unsigned int>& trigrams)
+{
+    trigrams.clear();
+    if (length < 3)
+        return;
+
+    // Source code repeats itself a lot, so most trigrams have been seen
+    // lately; a small table of recent ones keeps the list to sort short
+    unsigned int recent[kRecentTrigrams];
+    memset(recent, 0xFF, sizeof(recent));
+
+    const unsigned char* p = (const unsigned char*)data;
+    unsigned int trigram = (FoldByte(p[0]) << 8) | FoldByte(p[1]);
+    for (size_t i = 2; i < length; i++) {
+        trigram = ((trigram << 8) | FoldByte(p[i])) & 0xFFFFFF;
+        if (p[i] == '\n' || p[i - 1] == '\n' || p[i - 2] == '\n')
+            continue;
+        unsigned int& slot = recent[(trigram * 2654435761u) >> (32 - kRecentTrigramBits)];
+        if (slot != trigram) {
+            slot = trigram;
+            trigrams.push_back(trigram);
+        }
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+std::string ToIndexPath(const ExtensionString& path)
+{
+#if defined(OS_WIN)
+    return CefString(path).ToString();
+#else
+    return path;
+#endif
+}
+
+int GetSearchIndex(const ExtensionString& path, CefRefPtr<SearchIndex>& index)
+{
+    return SearchIndexCache::GetInstance().Get(path, index);
+}
+
+namespace {
+
+// A file on its way into the index
+struct IndexedFile {
+    IndexedFile() : flags(0) {}
+
+    std::string path;           // relative to the root, UTF-8
+    FileInfo info;
+    unsigned int flags;
+    std::vector<unsigned int> trigrams;
+};
+
+bool ComparePaths(const IndexedFile& a, const IndexedFile& b)
+{
+    return a.path < b.path;
+}
+
+} // namespace
+
+// Writes indexes in the format SearchIndex reads
+class SearchIndexWriter
+{
+public:
+    // Sets |out| to the index of |files|, which are sorted by path. Returns
+    // false if the index would be too large for 32 bit offsets.
+    static bool Write(const std::string& root, const std::vector<IndexedFile>& files, std::string& out,
+                      size_t& trigramCount);
+};
+
+bool SearchIndexWriter::Write(const std::string& root, const std::vector<IndexedFile>& files, std::string& out,
+                              size_t& trigramCount)
+{
+    std::string strings(root);
+    strings += '\0';
+    std::vector<unsigned int> pathOffsets(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        pathOffsets[i] = (unsigned int)strings.length();
+        strings += files[i].path;
+        strings += '\0';
+    }
+
+    // Posting lists go out one leading byte at a time: count how many files
+    // have each trigram starting with that byte, then fill in the lists.
+    // Files are visited in order, so the lists come out sorted. Each lead
+    // only visits the files that have trigrams starting with it, at the
+    // place in their lists where those begin.
+    std::vector<std::vector<std::pair<unsigned int, unsigned int> > > leadFiles(256);
+    for (size_t i = 0; i < files.size(); i++) {
+        const std::vector<unsigned int>& list = files[i].trigrams;
+        for (size_t j = 0; j < list.size(); j++) {
+            if (j == 0 || (list[j] >> 16) != (list[j - 1] >> 16))
+                leadFiles[list[j] >> 16].push_back(std::make_pair((unsigned int)i, (unsigned int)j));
+        }
+    }
+
+    std::vector<SearchIndex::TrigramRecord> trigrams;
+    std::string postings;
+    std::vector<unsigned int> counts(65536);
+    std::vector<unsigned int> starts(65536);
+    std::vector<unsigned int> filled;
+    for (unsigned int lead = 0; lead < 256; lead++) {
+        const std::vector<std::pair<unsigned int, unsigned int> >& leaders = leadFiles[lead];
+        if (leaders.empty())
+            continue;
+
+        std::fill(counts.begin(), counts.end(), 0);
+        size_t total = 0;
+        for (size_t f = 0; f < leaders.size(); f++) {
+            const std::vector<unsigned int>& list = files[leaders[f].first].trigrams;
+            for (size_t j = leaders[f].second; j < list.size() && (list[j] >> 16) == lead; j++) {
+                counts[list[j] & 0xFFFF]++;
+                total++;
+            }
+        }
+
+        unsigned int start = 0;
+        for (size_t t = 0; t < 65536; t++) {
+            starts[t] = start;
+            start += counts[t];
+        }
+        filled.resize(total);
+        for (size_t f = 0; f < leaders.size(); f++) {
+            const std::vector<unsigned int>& list = files[leaders[f].first].trigrams;
+            for (size_t j = leaders[f].second; j < list.size() && (list[j] >> 16) == lead; j++)
+                filled[starts[list[j] & 0xFFFF]++] = leaders[f].first;
+        }
+
+        size_t begin = 0;
+        for (size_t t = 0; t < 65536; t++) {
+            if (!counts[t])
+                continue;
+            SearchIndex::TrigramRecord record;
+            record.trigram = (lead << 16) | (unsigned int)t;
+            record.postings = (unsigned int)postings.length();
+            record.count = counts[t];
+            trigrams.push_back(record);
+
+            unsigned int previous = 0;
+            for (size_t k = begin; k < begin + counts[t]; k++) {
+                AppendVarint(postings, filled[k] - previous);
+                previous = filled[k];
+            }
+            begin += counts[t];
+        }
+        if (postings.length() > 0x7FFFFFFFu)
+            return false;
+    }
+
+    SearchIndex::Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+    header.version = kIndexVersion;
+    header.fileCount = (unsigned int)files.size();
+    header.trigramCount = (unsigned int)trigrams.size();
+
+    unsigned long long offset = Align(sizeof(header));
+    header.filesOffset = (unsigned int)offset;
+    offset += files.size() * sizeof(SearchIndex::FileRecord);
+    header.trigramsOffset = (unsigned int)offset;
+    offset += trigrams.size() * sizeof(SearchIndex::TrigramRecord);
+    header.postingsOffset = (unsigned int)offset;
+    offset += postings.length();
+    header.stringsOffset = (unsigned int)offset;
+    offset += strings.length();
+    if (offset > 0xFFFFFFFFu)
+        return false;
+    header.totalSize = (unsigned int)offset;
+
+    out.clear();
+    out.reserve((size_t)offset);
+    AppendRecord(out, header);
+    out.resize(header.filesOffset, '\0');
+    for (size_t i = 0; i < files.size(); i++) {
+        SearchIndex::FileRecord record;
+        memset(&record, 0, sizeof(record));
+        record.path = pathOffsets[i];
+        record.flags = files[i].flags;
+        record.size = files[i].info.size;
+        record.mtimeSec = files[i].info.mtimeSec;
+        record.mtimeNsec = (unsigned int)files[i].info.mtimeNsec;
+        AppendRecord(out, record);
+    }
+    for (size_t i = 0; i < trigrams.size(); i++)
+        AppendRecord(out, trigrams[i]);
+    out += postings;
+    out += strings;
+
+    trigramCount = trigrams.size();
+    return true;
+}
+
+namespace {
+
+// Runs BuildSearchIndexAsync: walks the root, takes the trigrams of files
+// that haven't changed from the previous index, reads the others in
+// parallel, kFilesPerItem at a time, and writes the new index
+class BuildSearchIndexOperation : public AsyncOperation, public WalkSink, public ParallelWork
+{
+public:
+    BuildSearchIndexOperation(const ExtensionString& root, const ExtensionString& indexPath,
+                              CefRefPtr<SearchIndex> previous, const WalkOptions& walkOptions,
+                              unsigned long long maxFileSize)
+        : m_root(root), m_indexPath(indexPath), m_previous(previous), m_walkOptions(walkOptions),
+          m_maxFileSize(maxFileSize), m_done(0), m_reported(0), m_read(0), m_reused(0), m_skipped(0),
+          m_trigramCount(0), m_size(0)
+    {
+        if (indexPath.compare(0, root.length() + 1, root + ExtensionString(1, '/')) == 0)
+            m_indexName = indexPath.substr(root.length() + 1);
+    }
+
+    // WalkSink
+    virtual void AddEntries(size_t root, std::vector<DirEntry>& entries);
+    virtual bool IsCancelled() const { return AsyncOperation::IsCancelled(); }
+
+    // ParallelWork
+    virtual void RunItem(size_t index);
+
+    // progress(done, total)
+    virtual bool TakeProgress(CefV8ValueList& arguments);
+
+    virtual CefRefPtr<CefV8Value> GetResult();
+
+protected:
+    virtual int Run();
+
+private:
+    // Reads m_files[index] and fills in its flags and trigrams
+    void IndexFile(size_t index, std::vector<char>& buffer);
+
+    ExtensionString m_root;
+    ExtensionString m_indexPath;
+    ExtensionString m_indexName;        // relative to m_root, if it is below it
+    CefRefPtr<SearchIndex> m_previous;
+    WalkOptions m_walkOptions;
+    unsigned long long m_maxFileSize;
+
+    // Filled in by the walk; while the files are read, each thread only
+    // touches its own items
+    Lock m_filesLock;
+    std::vector<IndexedFile> m_files;
+
+    // Indexes in m_files of the files that have to be read
+    std::vector<size_t> m_toRead;
+
+    Lock m_progressLock;
+    size_t m_done;
+    size_t m_reported;                  // m_done at the last progress call
+    size_t m_read;
+    size_t m_reused;
+    size_t m_skipped;
+    size_t m_trigramCount;
+    size_t m_size;
+};
+
+void BuildSearchIndexOperation::AddEntries(size_t root, std::vector<DirEntry>& entries)
+{
+    std::vector<IndexedFile> files;
+    for (size_t i = 0; i < entries.size(); i++) {
+        // The index may be kept under the root it indexes
+        if (entries[i].info.isDirectory || entries[i].name == m_indexName)
+            continue;
+        files.push_back(IndexedFile());
+        files.back().path = ToIndexPath(entries[i].name);
+        files.back().info = entries[i].info;
+    }
+
+    AutoLock lock(m_filesLock);
+    m_files.insert(m_files.end(), files.begin(), files.end());
+}
+
+int BuildSearchIndexOperation::Run()
+{
+    FileInfo info;
+    int error = GetFileInfo(m_root, info);
+    if (error != NO_ERROR)
+        return error;
+    if (!info.isDirectory)
+        return ERR_NOT_DIRECTORY;
+
+    std::vector<ExtensionString> roots(1, m_root);
+    WalkStats stats;
+    error = WalkTree(roots, m_walkOptions, *this, stats);
+    if (error != NO_ERROR)
+        return error;
+    if (stats.rootErrors[0] != NO_ERROR)
+        return stats.rootErrors[0];
+    std::sort(m_files.begin(), m_files.end(), ComparePaths);
+
+    // Files that still look the way they did keep what the previous index
+    // says about them. An index of another root, or of the same root under
+    // another name, says nothing.
+    std::string root = ToIndexPath(m_root);
+    std::vector<std::vector<unsigned int> > previousTrigrams;
+    if (m_previous.get() && m_previous->GetRoot() == root)
+        m_previous->GetFileTrigrams(previousTrigrams);
+
+    for (size_t i = 0; i < m_files.size(); i++) {
+        IndexedFile& file = m_files[i];
+        int previous = previousTrigrams.empty() ? -1 : m_previous->FindFile(file.path);
+        if (previous >= 0 && m_previous->IsCurrent(previous, file.info)) {
+            file.flags = m_previous->GetFlags(previous);
+            file.trigrams.swap(previousTrigrams[previous]);
+            m_reused++;
+        } else {
+            m_toRead.push_back(i);
+        }
+    }
+    previousTrigrams.clear();
+    m_previous = NULL;
+
+    {
+        AutoLock lock(m_progressLock);
+        m_done = m_reused;
+    }
+    PostProgress(kIndexProgressDelayMs);
+    ParallelFor(*this, (m_toRead.size() + kFilesPerItem - 1) / kFilesPerItem, kMaxIndexThreads);
+    if (IsCancelled())
+        return ERR_CANCELLED;
+
+    std::string contents;
+    if (!SearchIndexWriter::Write(root, m_files, contents, m_trigramCount))
+        return ERR_OUT_OF_SPACE;
+    m_files.clear();
+
+    // Searches still running keep their own reference to the old index
+    SearchIndexCache::GetInstance().Remove(m_indexPath);
+    error = WriteFile(m_indexPath, contents, "utf8", DURABILITY_NONE);
+    if (error != NO_ERROR)
+        return error;
+    m_size = contents.length();
+    return NO_ERROR;
+}
+
+void BuildSearchIndexOperation::RunItem(size_t index)
+{
+    std::vector<char> buffer;
+    size_t end = std::min(m_toRead.size(), (index + 1) * kFilesPerItem);
+    for (size_t i = index * kFilesPerItem; i < end; i++) {
+        if (IsCancelled())
+            return;
+        IndexFile(m_toRead[i], buffer);
+    }
+}
+
+void BuildSearchIndexOperation::IndexFile(size_t index, std::vector<char>& buffer)
+{
+    // Files that are too large or can't be read are recorded without
+    // FILE_INDEXED, so searches always read them
+    IndexedFile& file = m_files[index];
+    bool read = false;
+    if (file.info.size <= m_maxFileSize) {
+        PlatformFile handle;
+        ExtensionString path = m_root + ExtensionString(1, '/');
+#if defined(OS_WIN)
+        path += CefString(file.path).ToWString();
+#else
+        path += file.path;
+#endif
+        if (OpenFileForReading(path, handle) == NO_ERROR) {
+            // The size may have changed since the walk; what was read is
+            // what the index describes, so it takes the size that was read.
+            // The modification time can only be older than the contents,
+            // which at worst makes the next refresh read the file again.
+            size_t length = (size_t)file.info.size;
+            if (buffer.size() < length + 1)
+                buffer.resize(length + 1);
+            size_t bytesRead = 0;
+            if (ReadFileAt(handle, 0, &buffer[0], length, bytesRead) == NO_ERROR) {
+                file.info.size = bytesRead;
+                if (IsBinary(&buffer[0], bytesRead)) {
+                    file.flags = SearchIndex::FILE_INDEXED | SearchIndex::FILE_BINARY;
+                } else {
+                    file.flags = SearchIndex::FILE_INDEXED;
+                    GetTrigrams(&buffer[0], bytesRead, file.trigrams);
+                }
+                read = true;
+            }
+            CloseFile(handle);
+        }
+    }
+
+    {
+        AutoLock lock(m_progressLock);
+        m_done++;
+        if (read)
+            m_read++;
+        else
+            m_skipped++;
+    }
+    PostProgress(kIndexProgressDelayMs);
+}
+
+bool BuildSearchIndexOperation::TakeProgress(CefV8ValueList& arguments)
+{
+    size_t done;
+    {
+        AutoLock lock(m_progressLock);
+        if (m_done == m_reported)
+            return false;
+        done = m_reported = m_done;
+    }
+    arguments.push_back(CefV8Value::CreateDouble((double)done));
+    arguments.push_back(CefV8Value::CreateDouble((double)(m_reused + m_toRead.size())));
+    return true;
+}
+
+CefRefPtr<CefV8Value> BuildSearchIndexOperation::GetResult()
+{
+    CefRefPtr<CefV8Value> result = CefV8Value::CreateObject(NULL);
+    result->SetValue("files", CefV8Value::CreateDouble((double)(m_reused + m_toRead.size())),
+                     V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("read", CefV8Value::CreateDouble((double)m_read), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("reused", CefV8Value::CreateDouble((double)m_reused), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("skipped", CefV8Value::CreateDouble((double)m_skipped), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("trigrams", CefV8Value::CreateDouble((double)m_trigramCount), V8_PROPERTY_ATTRIBUTE_NONE);
+    result->SetValue("size", CefV8Value::CreateDouble((double)m_size), V8_PROPERTY_ATTRIBUTE_NONE);
+    return result;
+}
+
+} // namespace
+
+int ExecuteBuildSearchIndexAsync(const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefString& exception)
+{
+    if (arguments.size() < 5 || !arguments[0]->IsString() || !arguments[1]->IsString())
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString root = arguments[0]->GetStringValue();
+    while (root.length() > 1 && root[root.length() - 1] == '/')
+        root.erase(root.length() - 1);
+    ExtensionString indexPath = arguments[1]->GetStringValue();
+    if (root.empty() || indexPath.empty())
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<CefV8Value> options = arguments[2];
+    WalkOptions walkOptions;
+    if (!GetWalkOptions(options, walkOptions))
+        return ERR_INVALID_PARAMS;
+    walkOptions.withStats = true;
+
+    unsigned long long maxFileSize = kDefaultMaxFileSize;
+    if (options->HasValue("maxFileSize")) {
+        CefRefPtr<CefV8Value> value = options->GetValue("maxFileSize");
+        if (!value->IsInt() || value->GetIntValue() < 0)
+            return ERR_INVALID_PARAMS;
+        maxFileSize = (unsigned long long)value->GetIntValue();
+    }
+
+    // The previous index, if there is a usable one, is opened here so that
+    // the cache is only ever created on the UI thread
+    CefRefPtr<SearchIndex> previous;
+    GetSearchIndex(indexPath, previous);
+
+    CefRefPtr<AsyncOperation> operation =
+        new BuildSearchIndexOperation(root, indexPath, previous, walkOptions, maxFileSize);
+    return operation->Start(arguments, 3, 4, retval);
+}
+
+} // namespace FileSystem
+} // namespace Brackets
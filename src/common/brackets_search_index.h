@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_SEARCH_INDEX_H
+#define _BRACKETS_SEARCH_INDEX_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+
+#include <string>
+#include <vector>
+
+namespace Brackets {
+namespace FileSystem {
+
+/**
+ * Trigram index of the files under a project root, kept in one file that is
+ * mapped rather than read, so opening it costs about as much as a stat. For
+ * each run of three bytes it lists the files that contain it, with ASCII
+ * letters folded to lower case. A search for text with at least three bytes
+ * only has to read the files that contain all of its trigrams.
+ *
+ * The index also records the size and modification time each file had when
+ * it was read. A file that no longer has them may have any contents, and
+ * has to be searched as if there were no index; BuildSearchIndexAsync reads
+ * only those files again when it refreshes the index.
+ *
+ * Paths are UTF-8, relative to the root, with '/' separators. Read-only once
+ * opened and may be shared by threads.
+ */
+class SearchIndex : public CefBase
+{
+public:
+    enum FileFlags {
+        FILE_INDEXED = 1,       // its trigrams are in the index
+        FILE_BINARY = 2,        // has a NUL byte near the start, see IsBinary
+    };
+
+    // Maps the index at |path|. Returns ERR_NOT_FOUND if there is none and
+    // ERR_CANT_READ if the file is not an index this version understands.
+    static int Open(const ExtensionString& path, CefRefPtr<SearchIndex>& index);
+
+    virtual ~SearchIndex();
+
+    // Root of the project, UTF-8
+    const std::string& GetRoot() const { return m_root; }
+
+    size_t GetFileCount() const { return m_fileCount; }
+    size_t GetTrigramCount() const { return m_trigramCount; }
+    size_t GetSize() const { return m_mapped.length; }
+
+    // Index of the file at |path|, relative to the root, or -1
+    int FindFile(const std::string& path) const;
+
+    const char* GetPath(int file) const;
+    unsigned int GetFlags(int file) const;
+
+    // Whether the file still has the size and modification time it had when
+    // it was indexed
+    bool IsCurrent(int file, const FileInfo& info) const;
+
+    // Sets candidates[file] for each file that has every trigram of |text|,
+    // folded as in the index, and clears it for the others. Returns false,
+    // leaving |candidates| alone, if |text| is too short to rule anything out.
+    bool FindCandidates(const std::string& text, std::vector<bool>& candidates) const;
+
+    // The sorted trigrams of every file, for building the next index
+    void GetFileTrigrams(std::vector<std::vector<unsigned int> >& trigrams) const;
+
+private:
+    friend class SearchIndexWriter;
+
+    struct Header;
+    struct FileRecord;
+    struct TrigramRecord;
+
+    SearchIndex();
+
+    const FileRecord& GetFile(int file) const;
+    const TrigramRecord* FindTrigram(unsigned int trigram) const;
+
+    // Appends the files listed for |record| to |files|, in order
+    void ReadPostings(const TrigramRecord& record, std::vector<int>& files) const;
+
+    MappedFile m_mapped;
+    std::string m_root;
+    size_t m_fileCount;
+    size_t m_trigramCount;
+    const FileRecord* m_files;
+    const TrigramRecord* m_trigrams;
+    const unsigned char* m_postings;
+    const unsigned char* m_postingsEnd;
+    const char* m_strings;
+    size_t m_stringsLength;
+
+    IMPLEMENT_REFCOUNTING(SearchIndex);
+};
+
+// The trigrams of |length| bytes at |data| as the index stores them: ASCII
+// letters folded to lower case, leaving out the ones with a line break in
+// them, which no search can ask for. Sorted, without duplicates.
+void GetTrigrams(const char* data, size_t length, std::vector<unsigned int>& trigrams);
+
+// |path| the way the index stores paths, in UTF-8
+std::string ToIndexPath(const ExtensionString& path);
+
+// The index at |path|, opened on first use and shared from then on until the
+// file changes
+int GetSearchIndex(const ExtensionString& path, CefRefPtr<SearchIndex>& index);
+
+// BuildSearchIndexAsync, registered by brackets_fs_extension.cpp
+int ExecuteBuildSearchIndexAsync(const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefString& exception);
+
+} // namespace FileSystem
+} // namespace Brackets
+
+#endif // _BRACKETS_SEARCH_INDEX_H
@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_stat_cache.h"
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+// Past this many entries a map is emptied and starts over, which keeps a
+// walk of a huge tree from holding on to all of it
+const size_t kMaxCacheEntries = 200000;
+
+class StatCacheStartTask : public CefTask
+{
+public:
+    StatCacheStartTask(int generation, const ExtensionString& root)
+        : m_generation(generation), m_root(root) {}
+
+    virtual void Execute(CefThreadId threadId) { StatCache::GetInstance().StartBackend(m_generation, m_root); }
+
+private:
+    int m_generation;
+    ExtensionString m_root;
+
+    IMPLEMENT_REFCOUNTING(StatCacheStartTask);
+};
+
+} // namespace
+
+StatCache& StatCache::GetInstance()
+{
+    // Never deleted: the backend may still be calling it while the process exits
+    static StatCache* s_instance = NULL;
+    if (!s_instance)
+        s_instance = new StatCache();
+    return *s_instance;
+}
+
+StatCache::StatCache()
+    : m_backend(NULL),
+      m_generation(0),
+      m_backendGeneration(0),
+      m_active(false),
+      m_changeCount(0)
+{
+}
+
+void StatCache::SetRoot(const ExtensionString& root)
+{
+    ExtensionString rootStr = root;
+    while (rootStr.length() > 1 && rootStr[rootStr.length() - 1] == '/')
+        rootStr.erase(rootStr.length() - 1);
+
+    int generation;
+    {
+        AutoLock lock(m_lock);
+        m_root = GetKey(rootStr);
+        generation = ++m_generation;
+        Reset(false);
+    }
+
+    WorkerPool::GetInstance().PostTask(new StatCacheStartTask(generation, rootStr));
+}
+
+void StatCache::StartBackend(int generation, const ExtensionString& root)
+{
+    AutoLock backendLock(m_backendLock);
+
+    // The old backend sees IsStopping() from the moment SetRoot ran
+    if (m_backend) {
+        m_backend->Stop();
+        delete m_backend;
+        m_backend = NULL;
+    }
+
+    {
+        AutoLock lock(m_lock);
+        if (generation != m_generation || root.empty())
+            return;
+        m_backendGeneration = generation;
+    }
+
+    WatchBackend* backend = CreateNativeWatchBackend();
+    if (backend->Start(root, this) != NO_ERROR) {
+        // Without notifications nothing can be cached safely
+        delete backend;
+        return;
+    }
+    m_backend = backend;
+
+    AutoLock lock(m_lock);
+    if (generation == m_generation)
+        Reset(true);
+}
+
+int StatCache::GetFileInfo(const ExtensionString& path, FileInfo& info, bool bypass)
+{
+    return Lookup(m_infos, path, info, bypass, &FileSystem::GetFileInfo);
+}
+
+int StatCache::ReadDir(const ExtensionString& path, std::vector<ExtensionString>& contents, bool bypass)
+{
+    return Lookup(m_listings, path, contents, bypass, &FileSystem::ReadDir);
+}
+
+int StatCache::ReadDirWithStats(const ExtensionString& path, std::vector<DirEntry>& entries, bool bypass)
+{
+    return Lookup(m_entryListings, path, entries, bypass, &FileSystem::ReadDirWithStats);
+}
+
+template <class T>
+int StatCache::Lookup(std::map<ExtensionString, Entry<T> >& map, const ExtensionString& path, T& value,
+                      bool bypass, int (*read)(const ExtensionString&, T&))
+{
+    typedef typename std::map<ExtensionString, Entry<T> >::iterator Iterator;
+
+    ExtensionString key;
+    unsigned int changeCount = 0;
+    bool cacheable = false;
+    {
+        AutoLock lock(m_lock);
+        if (bypass) {
+            m_stats.bypassed++;
+        } else {
+            if (m_active) {
+                key = GetKey(path);
+                cacheable = IsCacheable(key);
+            }
+            if (cacheable) {
+                Iterator it = map.find(key);
+                if (it != map.end() && it->second.path == path) {
+                    m_stats.hits++;
+                    value = it->second.value;
+                    return it->second.error;
+                }
+            }
+            m_stats.misses++;
+            changeCount = m_changeCount;
+        }
+    }
+
+    int error = read(path, value);
+
+    // Only keep the answer if nothing changed while the file system was
+    // asked; it may predate the change
+    if (cacheable && (error == NO_ERROR || error == ERR_NOT_FOUND)) {
+        AutoLock lock(m_lock);
+        if (m_active && m_changeCount == changeCount) {
+            if (map.size() >= kMaxCacheEntries)
+                map.clear();
+
+            Entry<T>& entry = map[key];
+            entry.path = path;
+            entry.error = error;
+            entry.value = value;
+        }
+    }
+
+    return error;
+}
+
+void StatCache::AddChange(const ExtensionString& path, ChangeKind kind)
+{
+    ExtensionString key = GetKey(path);
+
+    AutoLock lock(m_lock);
+    m_changeCount++;
+    m_stats.invalidations++;
+
+    if (kind == CHANGE_MODIFIED) {
+        m_infos.erase(key);
+        m_listings.erase(key);
+        m_entryListings.erase(key);
+    } else {
+        EraseTree(m_infos, key);
+        EraseTree(m_listings, key);
+        EraseTree(m_entryListings, key);
+    }
+
+    // The parent's listing with stats has the size and time of |path|
+    ExtensionString parent = GetParentKey(key);
+    if (parent.empty())
+        return;
+    m_entryListings.erase(parent);
+
+    // The parent gains or loses an entry, and its modification time changes
+    if (kind == CHANGE_CREATED || kind == CHANGE_DELETED) {
+        m_infos.erase(parent);
+        m_listings.erase(parent);
+        m_entryListings.erase(GetParentKey(parent));
+    }
+}
+
+void StatCache::BackendFailed()
+{
+    // The backend stays in place but is no longer trusted, until the next
+    // SetRoot
+    AutoLock lock(m_lock);
+    Reset(false);
+}
+
+bool StatCache::IsStopping() const
+{
+    AutoLock lock(m_lock);
+    return m_backendGeneration != m_generation;
+}
+
+StatCache::Stats StatCache::GetStats() const
+{
+    AutoLock lock(m_lock);
+    Stats stats = m_stats;
+    stats.entries = m_infos.size() + m_listings.size() + m_entryListings.size();
+    stats.active = m_active;
+    return stats;
+}
+
+void StatCache::Reset(bool active)
+{
+    m_infos.clear();
+    m_listings.clear();
+    m_entryListings.clear();
+    m_active = active;
+
+    // Lookups in flight must not cache what they read before this
+    m_changeCount++;
+}
+
+ExtensionString StatCache::GetKey(const ExtensionString& path)
+{
+#if defined(OS_WIN) || defined(OS_MACOSX)
+    ExtensionString key = path;
+    for (size_t i = 0; i < key.length(); i++) {
+        if (key[i] >= 'A' && key[i] <= 'Z')
+            key[i] = key[i] - 'A' + 'a';
+    }
+    return key;
+#else
+    return path;
+#endif
+}
+
+ExtensionString StatCache::GetParentKey(const ExtensionString& key)
+{
+    size_t slash = key.rfind('/');
+    if (slash == ExtensionString::npos || slash == 0)
+        return ExtensionString();
+    return key.substr(0, slash);
+}
+
+bool StatCache::IsCacheable(const ExtensionString& key) const
+{
+    size_t rootLength = m_root.length();
+    if (rootLength == 0 || key.compare(0, rootLength, m_root) != 0)
+        return false;
+    if (key.length() > rootLength && key[rootLength] != '/')
+        return false;
+
+    // Paths the backend would report differently: "a//b", "a/./b", "a/../b",
+    // "a/" and, on Windows, "a\b"
+    for (size_t i = rootLength; i < key.length(); i++) {
+        if (key[i] == '\\')
+            return false;
+        if (key[i] != '/')
+            continue;
+
+        size_t end = key.find('/', i + 1);
+        if (end == ExtensionString::npos)
+            end = key.length();
+        size_t length = end - i - 1;
+        if (length == 0 ||
+            (length == 1 && key[i + 1] == '.') ||
+            (length == 2 && key[i + 1] == '.' && key[i + 2] == '.'))
+            return false;
+    }
+
+    return true;
+}
+
+template <class Map>
+void StatCache::EraseTree(Map& map, const ExtensionString& key)
+{
+    map.erase(key);
+
+    // Everything that starts with "key/" sorts between "key/" and "key0"
+    ExtensionString first = key;
+    first += '/';
+    ExtensionString last = key;
+    last += '0';
+    map.erase(map.lower_bound(first), map.lower_bound(last));
+}
+
+int ExecuteSetStatCacheRoot(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception)
+{
+    if (arguments.size() != 1 || !arguments[0]->IsString())
+        return ERR_INVALID_PARAMS;
+
+    ExtensionString pathStr = arguments[0]->GetStringValue();
+    if (!pathStr.empty()) {
+        bool isDirectory;
+        int error = IsDirectory(pathStr, isDirectory);
+        if (error != NO_ERROR)
+            return error;
+        if (!isDirectory)
+            return ERR_NOT_DIRECTORY;
+    }
+
+    StatCache::GetInstance().SetRoot(pathStr);
+    return NO_ERROR;
+}
+
+int ExecuteGetStatCacheStats(const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception)
+{
+    if (arguments.size() != 0)
+        return ERR_INVALID_PARAMS;
+
+    StatCache::Stats stats = StatCache::GetInstance().GetStats();
+
+    retval = CefV8Value::CreateObject(NULL);
+    retval->SetValue("hits", CefV8Value::CreateDouble((double)stats.hits), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("misses", CefV8Value::CreateDouble((double)stats.misses), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("bypassed", CefV8Value::CreateDouble((double)stats.bypassed), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("invalidations", CefV8Value::CreateDouble((double)stats.invalidations),
+                     V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("entries", CefV8Value::CreateDouble((double)stats.entries), V8_PROPERTY_ATTRIBUTE_NONE);
+    retval->SetValue("active", CefV8Value::CreateBool(stats.active), V8_PROPERTY_ATTRIBUTE_NONE);
+    return NO_ERROR;
+}
+
+} // namespace FileSystem
+} // namespace Brackets
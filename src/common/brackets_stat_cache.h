@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_STAT_CACHE_H
+#define _BRACKETS_STAT_CACHE_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_thread.h"
+#include "common/brackets_watcher.h"
+
+#include <map>
+#include <vector>
+
+namespace Brackets {
+namespace FileSystem {
+
+/**
+ * Remembers the type, size and modification time of paths, and the names in
+ * directories with or without those stats, for everything under one root
+ * directory (normally the open
+ * project). The editor asks about the same paths again and again while it
+ * draws the tree, checks for changes on disk and resolves modules; answers
+ * from the cache skip the system call.
+ *
+ * The cache watches the root with the native WatchBackend and drops entries
+ * as soon as the backend reports a change to them. Nothing is cached until
+ * the backend is running, nor if it can't start or fails later, so answers
+ * are never older than the last change notification. Failures are cached
+ * too when a path does not exist: it stays ERR_NOT_FOUND until it is
+ * created. Other errors are not cached.
+ * Changes made through the native functions (WriteFile,
+ * DeleteFileOrDirectory) are applied right away, without waiting for the
+ * backend.
+ *
+ * Only paths under the root, in the form the backend reports them ('/'
+ * separators, no '.', '..', doubled or trailing separators), are cached.
+ * Everything else goes straight to the file system. Thread safe.
+ */
+class StatCache : public ChangeSink
+{
+public:
+    static StatCache& GetInstance();
+
+    // Starts caching under |root|, dropping everything cached so far. An
+    // empty |root| turns the cache off. The backend starts on the WorkerPool;
+    // until it is running lookups go to the file system.
+    void SetRoot(const ExtensionString& root);
+
+    // Lookups. With |bypass| the file system is always asked and the cache
+    // is left alone.
+    int GetFileInfo(const ExtensionString& path, FileInfo& info, bool bypass);
+    int ReadDir(const ExtensionString& path, std::vector<ExtensionString>& contents, bool bypass);
+    int ReadDirWithStats(const ExtensionString& path, std::vector<DirEntry>& entries, bool bypass);
+
+    // Drops what is cached for |path| after the native functions changed it
+    void PathChanged(const ExtensionString& path, ChangeKind kind) { AddChange(path, kind); }
+
+    struct Stats {
+        Stats() : hits(0), misses(0), bypassed(0), invalidations(0), entries(0), active(false) {}
+
+        unsigned long long hits;            // lookups answered from the cache
+        unsigned long long misses;          // lookups that went to the file system
+        unsigned long long bypassed;        // lookups with |bypass| set
+        unsigned long long invalidations;   // changes from the backend or PathChanged
+        size_t entries;                     // paths and listings cached now
+        bool active;            // the backend is running
+    };
+
+    Stats GetStats() const;
+
+    // ChangeSink
+    virtual void AddChange(const ExtensionString& path, ChangeKind kind);
+    virtual void BackendFailed();
+    virtual bool IsStopping() const;
+
+    // Stops the current backend and starts one for |root| if |generation| is
+    // still the current one. Runs on the WorkerPool.
+    void StartBackend(int generation, const ExtensionString& root);
+
+private:
+    StatCache();
+
+    // |path| is kept as given, so that on case-insensitive systems a lookup
+    // only hits when the case matches too; keys are lowercased
+    template <class T>
+    struct Entry {
+        ExtensionString path;
+        int error;
+        T value;
+    };
+
+    typedef std::map<ExtensionString, Entry<FileInfo> > InfoMap;
+    typedef std::map<ExtensionString, Entry<std::vector<ExtensionString> > > ListingMap;
+    typedef std::map<ExtensionString, Entry<std::vector<DirEntry> > > EntryListingMap;
+
+    // Looks |path| up in |map|, or calls |read| and caches what it returns
+    template <class T>
+    int Lookup(std::map<ExtensionString, Entry<T> >& map, const ExtensionString& path, T& value,
+               bool bypass, int (*read)(const ExtensionString&, T&));
+
+    // The key for |path|, ASCII-lowercased on Windows and Mac
+    static ExtensionString GetKey(const ExtensionString& path);
+
+    // The key of the directory |key| is in, or an empty string at the top
+    static ExtensionString GetParentKey(const ExtensionString& key);
+
+    // Whether |key| is under the root in the form the backend reports
+    bool IsCacheable(const ExtensionString& key) const;
+
+    // Erases |key| and everything below it from |map|
+    template <class Map>
+    static void EraseTree(Map& map, const ExtensionString& key);
+
+    // Drops the cache when the backend can no longer be trusted. Called with
+    // m_lock held.
+    void Reset(bool active);
+
+    // Guards the backend, which is started and stopped on the WorkerPool
+    Lock m_backendLock;
+    WatchBackend* m_backend;
+
+    // Guards everything below
+    mutable Lock m_lock;
+    ExtensionString m_root;     // as a key
+    int m_generation;           // bumped by SetRoot
+    int m_backendGeneration;    // the root the backend is being started for
+    bool m_active;
+    unsigned int m_changeCount; // bumped by every change, see GetFileInfo
+    InfoMap m_infos;
+    ListingMap m_listings;
+    EntryListingMap m_entryListings;
+    Stats m_stats;
+
+    StatCache(const StatCache&);
+    StatCache& operator=(const StatCache&);
+};
+
+// Native functions for the cache, registered by brackets_fs_extension.cpp
+int ExecuteSetStatCacheRoot(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception);
+int ExecuteGetStatCacheStats(const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception);
+
+} // namespace FileSystem
+} // namespace Brackets
+
+#endif // _BRACKETS_STAT_CACHE_H
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#include "common/brackets_thread.h"
+
+#include <algorithm>
+
+namespace Brackets {
+
+WorkerPool& WorkerPool::GetInstance()
+{
+    static WorkerPool* s_instance = NULL;
+    if (!s_instance) {
+        int threadCount = GetProcessorCount();
+        if (threadCount < 2)
+            threadCount = 2;
+        else if (threadCount > 8)
+            threadCount = 8;
+
+        // Never deleted: the threads are left to end with the process
+        s_instance = new WorkerPool(threadCount);
+    }
+    return *s_instance;
+}
+
+void WorkerPool::PostTask(CefRefPtr<CefTask> task)
+{
+    {
+        AutoLock lock(m_lock);
+        m_tasks.push_back(task);
+    }
+    SignalTask();
+}
+
+bool WorkerPool::GetNextTask(CefRefPtr<CefTask>& task)
+{
+    AutoLock lock(m_lock);
+    while (m_tasks.empty() && !m_stopping)
+        WaitForTask();
+
+    if (m_tasks.empty())
+        return false;
+
+    task = m_tasks.front();
+    m_tasks.pop_front();
+    return true;
+}
+
+void WorkerPool::RunTasks()
+{
+    CefRefPtr<CefTask> task;
+    while (GetNextTask(task)) {
+        // Workers stand in for the file thread
+        task->Execute(TID_FILE);
+        task = NULL;
+    }
+}
+
+namespace {
+
+// State shared by ParallelFor and its helper tasks. Helpers that start after
+// every item is taken find nothing to do and never touch |work|, which may
+// be gone by then.
+class ParallelForState : public CefBase
+{
+public:
+    ParallelForState(ParallelWork& work, size_t count)
+        : m_work(work), m_count(count), m_next(0), m_done(0) {}
+
+    // Runs items until there are none left
+    void RunItems()
+    {
+        for (;;) {
+            size_t index;
+            {
+                AutoLock lock(m_lock);
+                if (m_next == m_count)
+                    return;
+                index = m_next++;
+            }
+
+            m_work.RunItem(index);
+
+            AutoLock lock(m_lock);
+            if (++m_done == m_count)
+                m_finished.Signal();
+        }
+    }
+
+    void WaitUntilDone() { m_finished.Wait(); }
+
+private:
+    ParallelWork& m_work;
+    size_t m_count;
+    size_t m_next;
+    size_t m_done;
+    Lock m_lock;
+    WaitableEvent m_finished;
+
+    IMPLEMENT_REFCOUNTING(ParallelForState);
+};
+
+class ParallelForTask : public CefTask
+{
+public:
+    explicit ParallelForTask(CefRefPtr<ParallelForState> state) : m_state(state) {}
+
+    virtual void Execute(CefThreadId threadId) { m_state->RunItems(); }
+
+private:
+    CefRefPtr<ParallelForState> m_state;
+
+    IMPLEMENT_REFCOUNTING(ParallelForTask);
+};
+
+} // namespace
+
+void ParallelFor(ParallelWork& work, size_t count, int maxThreads)
+{
+    if (count == 0)
+        return;
+
+    CefRefPtr<ParallelForState> state = new ParallelForState(work, count);
+    WorkerPool& pool = WorkerPool::GetInstance();
+    size_t helpers = std::min((size_t)std::min(maxThreads, pool.GetThreadCount() + 1), count) - 1;
+    for (size_t i = 0; i < helpers; i++)
+        pool.PostTask(new ParallelForTask(state));
+
+    state->RunItems();
+    state->WaitUntilDone();
+}
+
+} // namespace Brackets
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#ifndef _BRACKETS_THREAD_H
+#define _BRACKETS_THREAD_H
+
+#include "include/cef.h"
+
+#include <deque>
+#include <vector>
+
+#if defined(OS_WIN)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace Brackets {
+
+/**
+ * Mutual exclusion lock. Not recursive.
+ */
+class Lock
+{
+public:
+    Lock();
+    ~Lock();
+
+    void Acquire();
+    void Release();
+
+private:
+    friend class WorkerPool;
+
+#if defined(OS_WIN)
+    CRITICAL_SECTION m_lock;
+#else
+    pthread_mutex_t m_lock;
+#endif
+
+    // Not copyable
+    Lock(const Lock&);
+    Lock& operator=(const Lock&);
+};
+
+// Holds |lock| for the lifetime of the object
+class AutoLock
+{
+public:
+    explicit AutoLock(Lock& lock) : m_lock(lock) { m_lock.Acquire(); }
+    ~AutoLock() { m_lock.Release(); }
+
+private:
+    Lock& m_lock;
+
+    AutoLock(const AutoLock&);
+    AutoLock& operator=(const AutoLock&);
+};
+
+/**
+ * Flag that one thread sets and others poll, without taking a lock. Once set
+ * it stays set.
+ */
+class AtomicFlag
+{
+public:
+    AtomicFlag() : m_value(0) {}
+
+#if defined(OS_WIN)
+    void Set() { InterlockedExchange(&m_value, 1); }
+    bool IsSet() const { return InterlockedCompareExchange(&m_value, 0, 0) != 0; }
+#else
+    void Set() { __sync_lock_test_and_set(&m_value, 1); }
+    bool IsSet() const { return __sync_fetch_and_add(&m_value, 0) != 0; }
+#endif
+
+private:
+    mutable volatile long m_value;
+};
+
+/**
+ * Lets threads wait until another thread signals. Once signaled it stays
+ * signaled.
+ */
+class WaitableEvent
+{
+public:
+    WaitableEvent();
+    ~WaitableEvent();
+
+    void Signal();
+    void Wait();
+
+private:
+#if defined(OS_WIN)
+    HANDLE m_event;
+#else
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_signaled;
+    bool m_isSignaled;
+#endif
+
+    WaitableEvent(const WaitableEvent&);
+    WaitableEvent& operator=(const WaitableEvent&);
+};
+
+/**
+ * Runs CefTasks on a fixed set of background threads.
+ *
+ * TID_FILE is a single thread, so one slow operation there (a large file, a
+ * network share that does not answer) holds up every operation behind it.
+ * Native async operations are posted here instead, which lets several of
+ * them make progress at once. Tasks are started in the order they are
+ * posted. They must not touch V8 values; results go back to the UI thread
+ * with CefPostTask(TID_UI, ...).
+ */
+class WorkerPool
+{
+public:
+    explicit WorkerPool(int threadCount);
+
+    // Runs the tasks that are still queued, then stops the threads
+    ~WorkerPool();
+
+    // The pool shared by all native async operations. Created on first use
+    // with one thread per processor, between 2 and 8.
+    static WorkerPool& GetInstance();
+
+    void PostTask(CefRefPtr<CefTask> task);
+
+    int GetThreadCount() const { return (int)m_threads.size(); }
+
+private:
+    // Waits for the next task. Returns false when the pool is shutting down
+    // and the queue is empty.
+    bool GetNextTask(CefRefPtr<CefTask>& task);
+
+    // Runs tasks until the pool shuts down
+    void RunTasks();
+
+    // Platform parts. WaitForTask is called with m_lock held and returns
+    // with it held again.
+    void StartThreads(int threadCount);
+    void JoinThreads();
+    void SignalTask();
+    void SignalStop();
+    void WaitForTask();
+
+#if defined(OS_WIN)
+    static DWORD WINAPI ThreadMain(LPVOID param);
+#else
+    static void* ThreadMain(void* param);
+#endif
+
+    Lock m_lock;
+    std::deque<CefRefPtr<CefTask> > m_tasks;
+    bool m_stopping;
+
+#if defined(OS_WIN)
+    HANDLE m_taskSemaphore;
+    std::vector<HANDLE> m_threads;
+#else
+    pthread_cond_t m_taskAvailable;
+    std::vector<pthread_t> m_threads;
+#endif
+
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+};
+
+// Number of processors available to the process
+int GetProcessorCount();
+
+// Milliseconds on a clock that only moves forward, for measuring intervals
+long long GetMonotonicTimeMs();
+
+// Same in microseconds, for timing work that takes less than a millisecond
+long long GetMonotonicTimeUs();
+
+// Work made of independent items, for ParallelFor
+class ParallelWork
+{
+public:
+    virtual ~ParallelWork() {}
+    virtual void RunItem(size_t index) =0;
+};
+
+// Runs work.RunItem(i) for every i below |count| on the calling thread and on
+// up to |maxThreads| - 1 threads of the WorkerPool, and returns when every
+// item is done. Items are handed out one at a time. The calling thread takes
+// items too and only waits for items that have already started, so this can
+// be called from a task on the WorkerPool itself.
+void ParallelFor(ParallelWork& work, size_t count, int maxThreads);
+
+} // namespace Brackets
+
+#endif // _BRACKETS_THREAD_H
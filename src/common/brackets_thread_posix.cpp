@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#include "common/brackets_thread.h"
+
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace Brackets {
+
+Lock::Lock()
+{
+    pthread_mutex_init(&m_lock, NULL);
+}
+
+Lock::~Lock()
+{
+    pthread_mutex_destroy(&m_lock);
+}
+
+void Lock::Acquire()
+{
+    pthread_mutex_lock(&m_lock);
+}
+
+void Lock::Release()
+{
+    pthread_mutex_unlock(&m_lock);
+}
+
+WaitableEvent::WaitableEvent() : m_isSignaled(false)
+{
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_signaled, NULL);
+}
+
+WaitableEvent::~WaitableEvent()
+{
+    pthread_cond_destroy(&m_signaled);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+void WaitableEvent::Signal()
+{
+    pthread_mutex_lock(&m_mutex);
+    m_isSignaled = true;
+    pthread_cond_broadcast(&m_signaled);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void WaitableEvent::Wait()
+{
+    pthread_mutex_lock(&m_mutex);
+    while (!m_isSignaled)
+        pthread_cond_wait(&m_signaled, &m_mutex);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+WorkerPool::WorkerPool(int threadCount) : m_stopping(false)
+{
+    pthread_cond_init(&m_taskAvailable, NULL);
+    StartThreads(threadCount);
+}
+
+WorkerPool::~WorkerPool()
+{
+    SignalStop();
+    JoinThreads();
+    pthread_cond_destroy(&m_taskAvailable);
+}
+
+void* WorkerPool::ThreadMain(void* param)
+{
+    static_cast<WorkerPool*>(param)->RunTasks();
+    return NULL;
+}
+
+void WorkerPool::StartThreads(int threadCount)
+{
+    for (int i = 0; i < threadCount; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, ThreadMain, this) == 0)
+            m_threads.push_back(thread);
+    }
+}
+
+void WorkerPool::JoinThreads()
+{
+    for (size_t i = 0; i < m_threads.size(); i++)
+        pthread_join(m_threads[i], NULL);
+    m_threads.clear();
+}
+
+void WorkerPool::SignalTask()
+{
+    AutoLock lock(m_lock);
+    pthread_cond_signal(&m_taskAvailable);
+}
+
+void WorkerPool::SignalStop()
+{
+    AutoLock lock(m_lock);
+    m_stopping = true;
+    pthread_cond_broadcast(&m_taskAvailable);
+}
+
+void WorkerPool::WaitForTask()
+{
+    pthread_cond_wait(&m_taskAvailable, &m_lock.m_lock);
+}
+
+int GetProcessorCount()
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+long long GetMonotonicTimeMs()
+{
+#if defined(OS_LINUX)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#else
+    // Mac OS X has no clock_gettime
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (long long)now.tv_sec * 1000 + now.tv_usec / 1000;
+#endif
+}
+
+long long GetMonotonicTimeUs()
+{
+#if defined(OS_LINUX)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#else
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (long long)now.tv_sec * 1000000 + now.tv_usec;
+#endif
+}
+
+} // namespace Brackets
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#include "common/brackets_thread.h"
+
+#include <limits.h>
+
+namespace Brackets {
+
+Lock::Lock()
+{
+    InitializeCriticalSection(&m_lock);
+}
+
+Lock::~Lock()
+{
+    DeleteCriticalSection(&m_lock);
+}
+
+void Lock::Acquire()
+{
+    EnterCriticalSection(&m_lock);
+}
+
+void Lock::Release()
+{
+    LeaveCriticalSection(&m_lock);
+}
+
+WaitableEvent::WaitableEvent()
+{
+    m_event = CreateEvent(NULL, TRUE, FALSE, NULL);
+}
+
+WaitableEvent::~WaitableEvent()
+{
+    CloseHandle(m_event);
+}
+
+void WaitableEvent::Signal()
+{
+    SetEvent(m_event);
+}
+
+void WaitableEvent::Wait()
+{
+    WaitForSingleObject(m_event, INFINITE);
+}
+
+// Windows XP has no condition variables, so waiting threads block on a
+// semaphore that is released once per posted task. A thread that wakes up
+// to an empty queue simply waits again.
+WorkerPool::WorkerPool(int threadCount) : m_stopping(false)
+{
+    m_taskSemaphore = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+    StartThreads(threadCount);
+}
+
+WorkerPool::~WorkerPool()
+{
+    SignalStop();
+    JoinThreads();
+    CloseHandle(m_taskSemaphore);
+}
+
+DWORD WINAPI WorkerPool::ThreadMain(LPVOID param)
+{
+    static_cast<WorkerPool*>(param)->RunTasks();
+    return 0;
+}
+
+void WorkerPool::StartThreads(int threadCount)
+{
+    for (int i = 0; i < threadCount; i++) {
+        HANDLE thread = CreateThread(NULL, 0, ThreadMain, this, 0, NULL);
+        if (thread)
+            m_threads.push_back(thread);
+    }
+}
+
+void WorkerPool::JoinThreads()
+{
+    for (size_t i = 0; i < m_threads.size(); i++) {
+        WaitForSingleObject(m_threads[i], INFINITE);
+        CloseHandle(m_threads[i]);
+    }
+    m_threads.clear();
+}
+
+void WorkerPool::SignalTask()
+{
+    ReleaseSemaphore(m_taskSemaphore, 1, NULL);
+}
+
+void WorkerPool::SignalStop()
+{
+    {
+        AutoLock lock(m_lock);
+        m_stopping = true;
+    }
+    if (!m_threads.empty())
+        ReleaseSemaphore(m_taskSemaphore, (LONG)m_threads.size(), NULL);
+}
+
+void WorkerPool::WaitForTask()
+{
+    m_lock.Release();
+    WaitForSingleObject(m_taskSemaphore, INFINITE);
+    m_lock.Acquire();
+}
+
+int GetProcessorCount()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+long long GetMonotonicTimeMs()
+{
+    LARGE_INTEGER frequency, now;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    return (long long)(now.QuadPart / (frequency.QuadPart / 1000.0));
+}
+
+long long GetMonotonicTimeUs()
+{
+    LARGE_INTEGER frequency, now;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    return (long long)(now.QuadPart / (frequency.QuadPart / 1000000.0));
+}
+
+} // namespace Brackets
@@ -0,0 +1,603 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_walker.h"
+#include "common/brackets_async.h"
+#include "common/brackets_fs_extension.h"
+#include "common/brackets_thread.h"
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+typedef ExtensionString::value_type Char;
+
+// Threads listing one level of the tree at a time, the caller included
+const int kMaxWalkThreads = 8;
+
+// Entries found within this many milliseconds go to JS in one batch
+const int kWalkBatchDelayMs = 50;
+
+inline Char FoldCase(Char c)
+{
+#if defined(OS_WIN) || defined(OS_MACOSX)
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A' + 'a';
+#endif
+    return c;
+}
+
+// Matches the class starting after the '[' at |p|. Sets |end| past the ']'.
+// Returns false, leaving |end| alone, if the class is not closed.
+bool MatchClass(const Char* p, const Char* pEnd, Char c, bool& matched, const Char*& end)
+{
+    bool negated = p < pEnd && (*p == '!' || *p == '^');
+    if (negated)
+        p++;
+
+    matched = false;
+    c = FoldCase(c);
+    for (bool first = true; p < pEnd; first = false) {
+        // A ']' right after the '[' is part of the class
+        if (*p == ']' && !first) {
+            matched = matched != negated;
+            end = p + 1;
+            return true;
+        }
+        Char low = *p++;
+        if (low == '\\' && p < pEnd)
+            low = *p++;
+        Char high = low;
+        if (p + 1 < pEnd && *p == '-' && p[1] != ']') {
+            high = p[1];
+            p += 2;
+        }
+        if (c >= FoldCase(low) && c <= FoldCase(high))
+            matched = true;
+    }
+    return false;
+}
+
+bool MatchGlobAt(const Char* p, const Char* pEnd, const Char* t, const Char* tEnd)
+{
+    while (p < pEnd) {
+        if (*p == '*') {
+            if (p + 1 < pEnd && p[1] == '*') {
+                const Char* rest = p + 2;
+                if (rest < pEnd && *rest == '/') {
+                    // "**/" matches any number of whole segments, even none
+                    rest++;
+                    if (MatchGlobAt(rest, pEnd, t, tEnd))
+                        return true;
+                    for (const Char* s = t; s < tEnd; s++) {
+                        if (*s == '/' && MatchGlobAt(rest, pEnd, s + 1, tEnd))
+                            return true;
+                    }
+                    return false;
+                }
+                // Anywhere else "**" matches anything, '/' included
+                for (const Char* s = t; ; s++) {
+                    if (MatchGlobAt(rest, pEnd, s, tEnd))
+                        return true;
+                    if (s == tEnd)
+                        return false;
+                }
+            }
+
+            // '*' stops at the end of the segment
+            p++;
+            for (const Char* s = t; ; s++) {
+                if (MatchGlobAt(p, pEnd, s, tEnd))
+                    return true;
+                if (s == tEnd || *s == '/')
+                    return false;
+            }
+        }
+
+        if (t == tEnd)
+            return false;
+
+        if (*p == '?') {
+            if (*t == '/')
+                return false;
+        } else if (*p == '[') {
+            bool matched;
+            const Char* end;
+            if (MatchClass(p + 1, pEnd, *t, matched, end)) {
+                if (!matched || *t == '/')
+                    return false;
+                p = end;
+                t++;
+                continue;
+            }
+            if (*t != '[')
+                return false;
+        } else {
+            if (*p == '\\' && p + 1 < pEnd)
+                p++;
+            if (FoldCase(*p) != FoldCase(*t))
+                return false;
+        }
+        p++;
+        t++;
+    }
+    return t == tEnd;
+}
+
+bool EqualsFolded(const ExtensionString& a, const Char* b, size_t length)
+{
+    if (a.length() != length)
+        return false;
+    for (size_t i = 0; i < length; i++) {
+        if (FoldCase(a[i]) != FoldCase(b[i]))
+            return false;
+    }
+    return true;
+}
+
+// A directory on the way down from a root, for finding symlink cycles
+class WalkAncestor : public CefBase
+{
+public:
+    WalkAncestor(const FileId& id, CefRefPtr<WalkAncestor> parent) : m_id(id), m_parent(parent) {}
+
+    bool Contains(const FileId& id) const
+    {
+        for (const WalkAncestor* ancestor = this; ancestor; ancestor = ancestor->m_parent.get()) {
+            if (ancestor->m_id == id)
+                return true;
+        }
+        return false;
+    }
+
+private:
+    FileId m_id;
+    CefRefPtr<WalkAncestor> m_parent;
+
+    IMPLEMENT_REFCOUNTING(WalkAncestor);
+};
+
+struct WalkDir {
+    ExtensionString path;
+    ExtensionString relative;       // '' for a root
+    size_t root;
+    int depth;
+    CefRefPtr<IgnoreRules> rules;
+    CefRefPtr<WalkAncestor> ancestors;
+};
+
+// Lists one level of the tree. Each item is a directory; what it finds
+// below goes to its own slot of |next| and |stats|, so items share nothing.
+class WalkLevel : public ParallelWork
+{
+public:
+    WalkLevel(const std::vector<WalkDir>& dirs, const WalkOptions& options, WalkSink& sink)
+        : m_dirs(dirs), m_options(options), m_sink(sink), m_next(dirs.size()), m_stats(dirs.size()),
+          m_errors(dirs.size(), NO_ERROR) {}
+
+    virtual void RunItem(size_t index);
+
+    const std::vector<WalkDir>& m_dirs;
+    const WalkOptions& m_options;
+    WalkSink& m_sink;
+
+    std::vector<std::vector<WalkDir> > m_next;
+    std::vector<WalkStats> m_stats;
+    std::vector<int> m_errors;
+};
+
+void WalkLevel::RunItem(size_t index)
+{
+    if (m_sink.IsCancelled())
+        return;
+
+    const WalkDir& dir = m_dirs[index];
+    WalkStats& stats = m_stats[index];
+
+    std::vector<DirEntry> entries;
+    FileId id;
+    int error = m_sink.ListEntries(dir.root, dir.path, dir.relative, m_options.withStats, entries, id);
+    if (error != NO_ERROR) {
+        m_errors[index] = error;
+        stats.unreadable++;
+        return;
+    }
+
+    if (id.index != 0 && dir.ancestors.get() && dir.ancestors->Contains(id)) {
+        stats.cycles++;
+        return;
+    }
+    CefRefPtr<WalkAncestor> ancestors = dir.ancestors;
+    if (id.index != 0)
+        ancestors = new WalkAncestor(id, dir.ancestors);
+
+    CefRefPtr<IgnoreRules> rules = dir.rules;
+    if (m_options.useGitignore) {
+        static const Char kGitignore[] = { '.', 'g', 'i', 't', 'i', 'g', 'n', 'o', 'r', 'e' };
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].info.isDirectory ||
+                !EqualsFolded(entries[i].name, kGitignore, sizeof(kGitignore) / sizeof(kGitignore[0])))
+                continue;
+
+            std::string text;
+            if (ReadFile(dir.path + '/' + entries[i].name, CefString("utf8"), text) == NO_ERROR) {
+                CefRefPtr<IgnoreRules> nested = new IgnoreRules(rules, dir.relative);
+                nested->AddPatterns(text);
+                if (!nested->IsEmpty())
+                    rules = nested;
+            }
+            break;
+        }
+    }
+
+    std::vector<DirEntry> found;
+    found.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        DirEntry& entry = entries[i];
+        ExtensionString relative = dir.relative.empty() ? entry.name : dir.relative + '/' + entry.name;
+
+        if (rules.get() && rules->IsIgnored(relative, entry.info.isDirectory)) {
+            stats.excluded++;
+            continue;
+        }
+
+        if (entry.info.isDirectory) {
+            stats.directories++;
+            if (dir.depth + 1 < m_options.maxDepth) {
+                WalkDir child;
+                child.path = dir.path + '/' + entry.name;
+                child.relative = relative;
+                child.root = dir.root;
+                child.depth = dir.depth + 1;
+                child.rules = rules;
+                child.ancestors = ancestors;
+                m_next[index].push_back(child);
+            }
+        } else {
+            stats.files++;
+        }
+
+        found.push_back(DirEntry());
+        found.back().name.swap(relative);
+        found.back().info = entry.info;
+    }
+
+    if (!found.empty())
+        m_sink.AddEntries(dir.root, found);
+}
+
+// Runs WalkTree for WalkTreeAsync and queues what it finds as progress
+class WalkTreeOperation : public AsyncOperation, public WalkSink
+{
+public:
+    WalkTreeOperation(const std::vector<ExtensionString>& roots, const WalkOptions& options)
+        : m_roots(roots), m_options(options), m_pending(roots.size()) {}
+
+    // WalkSink
+    virtual void AddEntries(size_t root, std::vector<DirEntry>& entries)
+    {
+        {
+            AutoLock lock(m_pendingLock);
+            std::vector<DirEntry>& pending = m_pending[root];
+            if (pending.empty())
+                pending.swap(entries);
+            else
+                pending.insert(pending.end(), entries.begin(), entries.end());
+        }
+        PostProgress(kWalkBatchDelayMs);
+    }
+
+    virtual bool IsCancelled() const { return AsyncOperation::IsCancelled(); }
+
+    // progress(root, entries) for each root that has new entries
+    virtual bool TakeProgress(CefV8ValueList& arguments)
+    {
+        std::vector<DirEntry> entries;
+        size_t root;
+        {
+            AutoLock lock(m_pendingLock);
+            for (root = 0; root < m_pending.size() && m_pending[root].empty(); root++) {}
+            if (root == m_pending.size())
+                return false;
+            entries.swap(m_pending[root]);
+        }
+
+        arguments.push_back(CefV8Value::CreateString(m_roots[root]));
+        if (m_options.withStats) {
+            arguments.push_back(DirEntriesToV8Array(entries));
+        } else {
+            // Names alone, with a '/' after directories
+            std::vector<ExtensionString> names(entries.size());
+            for (size_t i = 0; i < entries.size(); i++) {
+                names[i].swap(entries[i].name);
+                if (entries[i].info.isDirectory)
+                    names[i] += '/';
+            }
+            arguments.push_back(StringListToV8Array(names));
+        }
+        return true;
+    }
+
+    virtual CefRefPtr<CefV8Value> GetResult()
+    {
+        CefRefPtr<CefV8Value> result = CefV8Value::CreateObject(NULL);
+        result->SetValue("files", CefV8Value::CreateDouble((double)m_stats.files), V8_PROPERTY_ATTRIBUTE_NONE);
+        result->SetValue("directories", CefV8Value::CreateDouble((double)m_stats.directories),
+                         V8_PROPERTY_ATTRIBUTE_NONE);
+        result->SetValue("excluded", CefV8Value::CreateDouble((double)m_stats.excluded), V8_PROPERTY_ATTRIBUTE_NONE);
+        result->SetValue("unreadable", CefV8Value::CreateDouble((double)m_stats.unreadable),
+                         V8_PROPERTY_ATTRIBUTE_NONE);
+        result->SetValue("cycles", CefV8Value::CreateDouble((double)m_stats.cycles), V8_PROPERTY_ATTRIBUTE_NONE);
+
+        CefRefPtr<CefV8Value> rootErrors = CefV8Value::CreateArray();
+        for (size_t i = 0; i < m_stats.rootErrors.size(); i++)
+            rootErrors->SetValue((int)i, CefV8Value::CreateInt(m_stats.rootErrors[i]));
+        result->SetValue("rootErrors", rootErrors, V8_PROPERTY_ATTRIBUTE_NONE);
+        return result;
+    }
+
+protected:
+    virtual int Run() { return WalkTree(m_roots, m_options, *this, m_stats); }
+
+private:
+    std::vector<ExtensionString> m_roots;
+    WalkOptions m_options;
+    WalkStats m_stats;
+
+    Lock m_pendingLock;
+    std::vector<std::vector<DirEntry> > m_pending;     // by root
+};
+
+} // namespace
+
+bool MatchGlob(const ExtensionString& pattern, const ExtensionString& text)
+{
+    const Char* p = pattern.data();
+    const Char* t = text.data();
+    return MatchGlobAt(p, p + pattern.length(), t, t + text.length());
+}
+
+///
+// IgnoreRules
+///
+IgnoreRules::IgnoreRules(CefRefPtr<IgnoreRules> parent, const ExtensionString& base)
+    : m_parent(parent), m_base(base)
+{
+}
+
+void IgnoreRules::AddPattern(const ExtensionString& line)
+{
+    ExtensionString glob = line;
+    if (!glob.empty() && glob[glob.length() - 1] == '\r')
+        glob.erase(glob.length() - 1);
+
+    // Trailing spaces are dropped unless quoted
+    while (!glob.empty() && glob[glob.length() - 1] == ' ' &&
+           !(glob.length() > 1 && glob[glob.length() - 2] == '\\'))
+        glob.erase(glob.length() - 1);
+
+    if (glob.empty() || glob[0] == '#')
+        return;
+
+    Pattern pattern;
+    pattern.negated = glob[0] == '!';
+    if (pattern.negated)
+        glob.erase(0, 1);
+    else if (glob.length() > 1 && glob[0] == '\\' && (glob[1] == '!' || glob[1] == '#'))
+        glob.erase(0, 1);
+
+    pattern.directoryOnly = !glob.empty() && glob[glob.length() - 1] == '/';
+    if (pattern.directoryOnly)
+        glob.erase(glob.length() - 1);
+
+    pattern.hasSlash = glob.find('/') != ExtensionString::npos;
+    if (pattern.hasSlash && glob[0] == '/')
+        glob.erase(0, 1);
+
+    if (glob.empty())
+        return;
+
+    pattern.literal = true;
+    for (size_t i = 0; i < glob.length() && pattern.literal; i++) {
+        if (glob[i] == '*' || glob[i] == '?' || glob[i] == '[' || glob[i] == '\\')
+            pattern.literal = false;
+    }
+
+    pattern.glob = glob;
+    m_patterns.push_back(pattern);
+}
+
+void IgnoreRules::AddPatterns(const std::string& text)
+{
+    size_t start = 0;
+    while (start < text.length()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos)
+            end = text.length();
+        if (end > start)
+            AddPattern(CefString(text.substr(start, end - start)));
+        start = end + 1;
+    }
+}
+
+bool IgnoreRules::IsIgnored(const ExtensionString& path, bool isDirectory) const
+{
+    for (const IgnoreRules* rules = this; rules; rules = rules->m_parent.get()) {
+        int result = rules->Match(path, isDirectory);
+        if (result != 0)
+            return result > 0;
+    }
+    return false;
+}
+
+int IgnoreRules::Match(const ExtensionString& path, bool isDirectory) const
+{
+    if (m_patterns.empty())
+        return 0;
+
+    // The part of |path| below |base|, and its last segment
+    size_t start = m_base.empty() ? 0 : m_base.length() + 1;
+    if (start > path.length())
+        return 0;
+    const Char* begin = path.data() + start;
+    const Char* end = path.data() + path.length();
+    size_t slash = path.rfind('/');
+    const Char* name = (slash == ExtensionString::npos || slash < start) ? begin : path.data() + slash + 1;
+
+    for (size_t i = m_patterns.size(); i > 0; i--) {
+        const Pattern& pattern = m_patterns[i - 1];
+        if (pattern.directoryOnly && !isDirectory)
+            continue;
+
+        const Char* text = pattern.hasSlash ? begin : name;
+        bool matched;
+        if (pattern.literal)
+            matched = EqualsFolded(pattern.glob, text, end - text);
+        else
+            matched = MatchGlobAt(pattern.glob.data(), pattern.glob.data() + pattern.glob.length(), text, end);
+
+        if (matched)
+            return pattern.negated ? -1 : 1;
+    }
+    return 0;
+}
+
+///
+// WalkTree
+///
+int WalkTree(const std::vector<ExtensionString>& roots, const WalkOptions& options,
+             WalkSink& sink, WalkStats& stats)
+{
+    CefRefPtr<IgnoreRules> rules;
+    if (!options.ignore.empty()) {
+        rules = new IgnoreRules(NULL, ExtensionString());
+        for (size_t i = 0; i < options.ignore.size(); i++)
+            rules->AddPattern(options.ignore[i]);
+    }
+
+    std::vector<WalkDir> level;
+    for (size_t i = 0; i < roots.size(); i++) {
+        WalkDir dir;
+        dir.path = roots[i];
+        while (dir.path.length() > 1 && dir.path[dir.path.length() - 1] == '/')
+            dir.path.erase(dir.path.length() - 1);
+        dir.root = i;
+        dir.depth = 0;
+        dir.rules = rules;
+        level.push_back(dir);
+    }
+    stats.rootErrors.assign(roots.size(), NO_ERROR);
+
+    for (bool first = true; !level.empty(); first = false) {
+        WalkLevel work(level, options, sink);
+        ParallelFor(work, level.size(), kMaxWalkThreads);
+        if (sink.IsCancelled())
+            return ERR_CANCELLED;
+
+        std::vector<WalkDir> next;
+        for (size_t i = 0; i < level.size(); i++) {
+            const WalkStats& itemStats = work.m_stats[i];
+            stats.files += itemStats.files;
+            stats.directories += itemStats.directories;
+            stats.excluded += itemStats.excluded;
+            stats.cycles += itemStats.cycles;
+
+            // A root that can't be listed is reported as its own error
+            if (first && work.m_errors[i] != NO_ERROR)
+                stats.rootErrors[i] = work.m_errors[i];
+            else
+                stats.unreadable += itemStats.unreadable;
+
+            next.insert(next.end(), work.m_next[i].begin(), work.m_next[i].end());
+        }
+        level.swap(next);
+    }
+
+    return NO_ERROR;
+}
+
+bool GetWalkOptions(CefRefPtr<CefV8Value> value, WalkOptions& options)
+{
+    if (!value->IsObject())
+        return false;
+
+    if (value->HasValue("ignore")) {
+        CefRefPtr<CefV8Value> ignore = value->GetValue("ignore");
+        if (!ignore->IsArray())
+            return false;
+        for (int i = 0; i < ignore->GetArrayLength(); i++) {
+            CefRefPtr<CefV8Value> pattern = ignore->GetValue(i);
+            if (!pattern->IsString())
+                return false;
+            options.ignore.push_back(pattern->GetStringValue());
+        }
+    }
+
+    if (value->HasValue("stats")) {
+        if (!value->GetValue("stats")->IsBool())
+            return false;
+        options.withStats = value->GetValue("stats")->GetBoolValue();
+    }
+
+    if (value->HasValue("gitignore")) {
+        if (!value->GetValue("gitignore")->IsBool())
+            return false;
+        options.useGitignore = value->GetValue("gitignore")->GetBoolValue();
+    }
+
+    if (value->HasValue("maxDepth")) {
+        CefRefPtr<CefV8Value> maxDepth = value->GetValue("maxDepth");
+        if (!maxDepth->IsInt() || maxDepth->GetIntValue() < 1 || maxDepth->GetIntValue() > 1024)
+            return false;
+        options.maxDepth = maxDepth->GetIntValue();
+    }
+
+    return true;
+}
+
+int ExecuteWalkTreeAsync(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+{
+    if (arguments.size() < 4 || !arguments[0]->IsArray() || arguments[0]->GetArrayLength() == 0)
+        return ERR_INVALID_PARAMS;
+
+    std::vector<ExtensionString> roots;
+    for (int i = 0; i < arguments[0]->GetArrayLength(); i++) {
+        CefRefPtr<CefV8Value> root = arguments[0]->GetValue(i);
+        if (!root->IsString())
+            return ERR_INVALID_PARAMS;
+        roots.push_back(root->GetStringValue());
+    }
+
+    WalkOptions options;
+    if (!GetWalkOptions(arguments[1], options))
+        return ERR_INVALID_PARAMS;
+
+    CefRefPtr<AsyncOperation> operation = new WalkTreeOperation(roots, options);
+    return operation->Start(arguments, 2, 3, retval);
+}
+
+} // namespace FileSystem
+} // namespace Brackets
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_WALKER_H
+#define _BRACKETS_WALKER_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+
+#include <string>
+#include <vector>
+
+namespace Brackets {
+namespace FileSystem {
+
+// Matches |text| against the glob |pattern|: '*' and '?' match within one
+// path segment, "**" matches across segments ("**/" also matches no segment
+// at all), "[a-z]" and "[!a-z]" match character classes and '\' quotes the
+// next character. Case-insensitive for ASCII on Windows and Mac.
+bool MatchGlob(const ExtensionString& pattern, const ExtensionString& text);
+
+/**
+ * Exclusion rules in the .gitignore format, for the part of a tree below
+ * |base|. Rules of nested directories are chained to those of their
+ * parents: the innermost rules that say anything about a path decide, and
+ * within one set of rules the last matching pattern wins, so "!pattern"
+ * brings back what an earlier pattern excluded.
+ *
+ * Patterns without a '/' match the name at any depth, patterns with one
+ * match the path relative to |base|, and a trailing '/' only matches
+ * directories. Rules are read-only once built and may be shared by threads.
+ */
+class IgnoreRules : public CefBase
+{
+public:
+    // |base| is relative to the root of the walk, '' for the root itself
+    IgnoreRules(CefRefPtr<IgnoreRules> parent, const ExtensionString& base);
+
+    // Adds one pattern, or every line of the UTF-8 |text| of a .gitignore
+    void AddPattern(const ExtensionString& line);
+    void AddPatterns(const std::string& text);
+
+    bool IsEmpty() const { return m_patterns.empty(); }
+
+    // Whether |path|, relative to the root of the walk with '/' separators,
+    // is excluded by these rules or those of their parents
+    bool IsIgnored(const ExtensionString& path, bool isDirectory) const;
+
+private:
+    struct Pattern {
+        ExtensionString glob;
+        bool negated;
+        bool directoryOnly;
+        bool hasSlash;      // matched against the whole path below |base|
+        bool literal;       // no wildcards, compared as is
+    };
+
+    // 1 if the last pattern matching |path| excludes it, -1 if it brings it
+    // back, 0 if no pattern matches
+    int Match(const ExtensionString& path, bool isDirectory) const;
+
+    CefRefPtr<IgnoreRules> m_parent;
+    ExtensionString m_base;
+    std::vector<Pattern> m_patterns;
+
+    IMPLEMENT_REFCOUNTING(IgnoreRules);
+};
+
+struct WalkOptions {
+    WalkOptions() : withStats(false), useGitignore(true), maxDepth(64) {}
+
+    // Patterns excluded under every root, below any .gitignore
+    std::vector<ExtensionString> ignore;
+
+    // Fill in size and modification time, which costs a stat per file
+    bool withStats;
+
+    // Read the .gitignore of every directory and apply it below it
+    bool useGitignore;
+
+    // Directories deeper than this are not listed
+    int maxDepth;
+};
+
+struct WalkStats {
+    WalkStats() : files(0), directories(0), excluded(0), unreadable(0), cycles(0) {}
+
+    unsigned long long files;
+    unsigned long long directories;
+    unsigned long long excluded;        // entries left out by the rules
+    unsigned long long unreadable;      // directories that could not be listed
+    unsigned long long cycles;          // symlinks back to a directory above them
+    std::vector<int> rootErrors;        // one per root
+};
+
+// Receives the entries WalkTree finds. Called from several threads at once.
+class WalkSink
+{
+public:
+    virtual ~WalkSink() {}
+
+    // Entries of one directory under roots[root]. Names are relative to the
+    // root, with '/' separators. |entries| may be taken over.
+    virtual void AddEntries(size_t root, std::vector<DirEntry>& entries) =0;
+
+    // The walk stops early when this returns true
+    virtual bool IsCancelled() const =0;
+
+    // Lists the directory at |path|, |relative| to roots[root]. The walk
+    // lists every directory through here, so a sink that already knows what
+    // a directory holds can answer without reading it.
+    virtual int ListEntries(size_t root, const ExtensionString& path, const ExtensionString& relative,
+                            bool withStats, std::vector<DirEntry>& entries, FileId& id)
+    {
+        return ListDirectory(path, withStats, entries, id);
+    }
+};
+
+/**
+ * Lists everything under |roots| on the WorkerPool, level by level: the
+ * directories found at one depth are listed in parallel, handed out to the
+ * threads one at a time, before the next depth starts. Symlinks are
+ * followed; a directory that is also one of its own ancestors, found by
+ * FileId, is not listed again. Returns ERR_CANCELLED if |sink| asked to stop,
+ * otherwise NO_ERROR with the error of each root in |stats|.
+ */
+int WalkTree(const std::vector<ExtensionString>& roots, const WalkOptions& options,
+             WalkSink& sink, WalkStats& stats);
+
+// Reads the ignore, gitignore, stats and maxDepth properties of the options
+// object |value| into |options|. Returns false if any of them is invalid.
+bool GetWalkOptions(CefRefPtr<CefV8Value> value, WalkOptions& options);
+
+// WalkTreeAsync, registered by brackets_fs_extension.cpp
+int ExecuteWalkTreeAsync(const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception);
+
+} // namespace FileSystem
+} // namespace Brackets
+
+#endif // _BRACKETS_WALKER_H
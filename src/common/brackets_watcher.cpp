@@ -0,0 +1,622 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_watcher.h"
+#include "common/brackets_async.h"
+
+#include <algorithm>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+// Directories nested deeper than this are not scanned, which also stops
+// symlink loops
+const int kMaxScanDepth = 64;
+
+// Polling intervals, see CreatePollingWatchBackend
+const int kMinPollIntervalMs = 1000;
+const int kMaxPollIntervalMs = 8000;
+
+// Beyond this many changed paths in one batch, the batch becomes a single
+// CHANGE_RESCAN of the root
+const size_t kMaxPendingChanges = 10000;
+
+inline ExtensionString ChildPath(const ExtensionString& directory, const ExtensionString& name)
+{
+    ExtensionString path = directory;
+    path += '/';
+    path += name;
+    return path;
+}
+
+// What a change that follows another one on the same path amounts to, or 0
+// if the two cancel out
+int CoalesceChanges(ChangeKind first, ChangeKind second)
+{
+    if (first == CHANGE_RESCAN || second == CHANGE_RESCAN)
+        return CHANGE_RESCAN;
+
+    switch (first) {
+    case CHANGE_CREATED:
+        return second == CHANGE_DELETED ? 0 : CHANGE_CREATED;
+    case CHANGE_DELETED:
+        return second == CHANGE_DELETED ? CHANGE_DELETED : CHANGE_MODIFIED;
+    default:
+        return second == CHANGE_DELETED ? CHANGE_DELETED : CHANGE_MODIFIED;
+    }
+}
+
+///
+// Polling backend
+///
+
+// State shared by PollingBackend and its tasks on TID_FILE. A poll holds
+// m_lock for the whole scan, so once Stop() has taken the lock no poll is
+// running and none will call the sink again.
+class PollingState : public CefBase, public ChangeSink
+{
+public:
+    PollingState(const ExtensionString& root, ChangeSink* sink, int minIntervalMs, int maxIntervalMs)
+        : m_root(root), m_sink(sink), m_minIntervalMs(minIntervalMs), m_maxIntervalMs(maxIntervalMs),
+          m_intervalMs(minIntervalMs), m_stopped(false), m_changed(false) {}
+
+    // Takes the first snapshot. Returns false if the watch was stopped.
+    bool Scan()
+    {
+        AutoLock lock(m_lock);
+        return m_snapshot.Scan(m_root, this);
+    }
+
+    void Poll();
+    void ScheduleNextPoll();
+
+    void Stop()
+    {
+        AutoLock lock(m_lock);
+        m_stopped = true;
+    }
+
+    // ChangeSink, wrapping the watcher's sink to see whether a poll found
+    // anything
+    virtual void AddChange(const ExtensionString& path, ChangeKind kind)
+    {
+        m_changed = true;
+        m_sink->AddChange(path, kind);
+    }
+    virtual void BackendFailed() {}
+    virtual bool IsStopping() const { return m_sink->IsStopping(); }
+
+private:
+    ExtensionString m_root;
+    ChangeSink* m_sink;
+    int m_minIntervalMs;
+    int m_maxIntervalMs;
+    int m_intervalMs;
+
+    Lock m_lock;
+    bool m_stopped;
+    bool m_changed;
+    TreeSnapshot m_snapshot;
+
+    IMPLEMENT_REFCOUNTING(PollingState);
+};
+
+class PollTask : public CefTask
+{
+public:
+    explicit PollTask(CefRefPtr<PollingState> state) : m_state(state) {}
+
+    virtual void Execute(CefThreadId threadId) { m_state->Poll(); }
+
+private:
+    CefRefPtr<PollingState> m_state;
+
+    IMPLEMENT_REFCOUNTING(PollTask);
+};
+
+void PollingState::ScheduleNextPoll()
+{
+    CefPostDelayedTask(TID_FILE, new PollTask(this), m_intervalMs);
+}
+
+void PollingState::Poll()
+{
+    AutoLock lock(m_lock);
+    if (m_stopped)
+        return;
+
+    long long start = GetMonotonicTimeMs();
+    m_changed = false;
+    if (!m_snapshot.Rescan(m_root, true, this))
+        return;
+    long long elapsed = GetMonotonicTimeMs() - start;
+
+    // Poll less often while the tree is quiet, and never spend more than a
+    // tenth of the time scanning
+    m_intervalMs = m_changed ? m_minIntervalMs : std::min(m_intervalMs * 2, m_maxIntervalMs);
+    m_intervalMs = (int)std::max((long long)m_intervalMs, elapsed * 10);
+    ScheduleNextPoll();
+}
+
+class PollingBackend : public WatchBackend
+{
+public:
+    PollingBackend(int minIntervalMs, int maxIntervalMs)
+        : m_minIntervalMs(minIntervalMs), m_maxIntervalMs(maxIntervalMs) {}
+    virtual ~PollingBackend() { Stop(); }
+
+    virtual int Start(const ExtensionString& root, ChangeSink* sink)
+    {
+        m_state = new PollingState(root, sink, m_minIntervalMs, m_maxIntervalMs);
+        if (!m_state->Scan()) {
+            m_state = NULL;
+            return ERR_CANCELLED;
+        }
+        m_state->ScheduleNextPoll();
+        return NO_ERROR;
+    }
+
+    virtual void Stop()
+    {
+        if (m_state.get()) {
+            m_state->Stop();
+            m_state = NULL;
+        }
+    }
+
+private:
+    int m_minIntervalMs;
+    int m_maxIntervalMs;
+    CefRefPtr<PollingState> m_state;
+};
+
+///
+// Tasks
+///
+
+// Starts or restarts the backend of a watcher on the WorkerPool
+class WatcherStartTask : public CefTask
+{
+public:
+    WatcherStartTask(CefRefPtr<FileWatcher> watcher, bool polling)
+        : m_watcher(watcher), m_polling(polling) {}
+
+    virtual void Execute(CefThreadId threadId) { m_watcher->StartBackend(m_polling); }
+
+private:
+    CefRefPtr<FileWatcher> m_watcher;
+    bool m_polling;
+
+    IMPLEMENT_REFCOUNTING(WatcherStartTask);
+};
+
+// Delivers a batch when its window closes. Only the handle is kept, so a
+// watcher that is closed meanwhile is simply not found.
+class WatcherFlushTask : public CefTask
+{
+public:
+    explicit WatcherFlushTask(int handle) : m_handle(handle) {}
+
+    virtual void Execute(CefThreadId threadId) { WatcherRegistry::GetInstance().Flush(m_handle); }
+
+private:
+    int m_handle;
+
+    IMPLEMENT_REFCOUNTING(WatcherFlushTask);
+};
+
+} // namespace
+
+WatchBackend* CreatePollingWatchBackend(int minIntervalMs, int maxIntervalMs)
+{
+    return new PollingBackend(minIntervalMs, maxIntervalMs);
+}
+
+///
+// TreeSnapshot
+///
+bool TreeSnapshot::Scan(const ExtensionString& root, ChangeSink* sink)
+{
+    m_entries.clear();
+    return Rescan(root, true, sink, false, 0);
+}
+
+bool TreeSnapshot::Rescan(const ExtensionString& directory, bool recursive, ChangeSink* sink)
+{
+    return Rescan(directory, recursive, sink, true, 0);
+}
+
+bool TreeSnapshot::Rescan(const ExtensionString& directory, bool recursive, ChangeSink* sink,
+                          bool report, int depth)
+{
+    if (sink->IsStopping())
+        return false;
+
+    // A directory that is gone or can't be read counts as empty
+    std::vector<DirEntry> entries;
+    if (depth <= kMaxScanDepth)
+        ReadDirWithStats(directory, entries);
+
+    ExtensionString prefix = ChildPath(directory, ExtensionString());
+
+    // Children that are no longer there. Entries directly in |directory|
+    // are the ones in [prefix, ...) without another separator.
+    std::vector<ExtensionString> names;
+    for (size_t i = 0; i < entries.size(); i++)
+        names.push_back(entries[i].name);
+    std::sort(names.begin(), names.end());
+
+    std::vector<ExtensionString> removed;
+    std::map<ExtensionString, FileInfo>::iterator it = m_entries.lower_bound(prefix);
+    for (; it != m_entries.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        ExtensionString name = it->first.substr(prefix.size());
+        if (name.find('/') == ExtensionString::npos && !std::binary_search(names.begin(), names.end(), name))
+            removed.push_back(it->first);
+    }
+    for (size_t i = 0; i < removed.size(); i++) {
+        if (m_entries[removed[i]].isDirectory)
+            RemoveChildren(removed[i], sink, report);
+        m_entries.erase(removed[i]);
+        if (report)
+            sink->AddChange(removed[i], CHANGE_DELETED);
+    }
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        const FileInfo& info = entries[i].info;
+        ExtensionString path = prefix + entries[i].name;
+
+        it = m_entries.find(path);
+        if (it == m_entries.end()) {
+            m_entries[path] = info;
+            if (report)
+                sink->AddChange(path, CHANGE_CREATED);
+            if (info.isDirectory && !Rescan(path, true, sink, report, depth + 1))
+                return false;
+            continue;
+        }
+
+        FileInfo& old = it->second;
+        if (old.isDirectory != info.isDirectory) {
+            // Replaced by something of another type
+            if (old.isDirectory)
+                RemoveChildren(path, sink, report);
+            old = info;
+            if (report)
+                sink->AddChange(path, CHANGE_MODIFIED);
+            if (info.isDirectory && !Rescan(path, true, sink, report, depth + 1))
+                return false;
+        } else if (info.isDirectory) {
+            old = info;
+            if (recursive && !Rescan(path, true, sink, report, depth + 1))
+                return false;
+        } else if (old.size != info.size || old.mtimeSec != info.mtimeSec || old.mtimeNsec != info.mtimeNsec) {
+            old = info;
+            if (report)
+                sink->AddChange(path, CHANGE_MODIFIED);
+        }
+    }
+
+    return true;
+}
+
+void TreeSnapshot::RemoveChildren(const ExtensionString& directory, ChangeSink* sink, bool report)
+{
+    // Everything below |directory| sorts between "directory/" and
+    // "directory0", '0' being the character after '/'
+    ExtensionString first = ChildPath(directory, ExtensionString());
+    ExtensionString last = directory;
+    last += '0';
+
+    std::map<ExtensionString, FileInfo>::iterator begin = m_entries.lower_bound(first);
+    std::map<ExtensionString, FileInfo>::iterator end = m_entries.lower_bound(last);
+    if (report) {
+        for (std::map<ExtensionString, FileInfo>::iterator it = begin; it != end; ++it)
+            sink->AddChange(it->first, CHANGE_DELETED);
+    }
+    m_entries.erase(begin, end);
+}
+
+///
+// FileWatcher
+///
+FileWatcher::FileWatcher(const ExtensionString& root, int latencyMs, bool forcePolling)
+    : m_root(root), m_latencyMs(latencyMs), m_handle(0), m_forcePolling(forcePolling),
+      m_backend(NULL), m_polling(false), m_flushPosted(false), m_fallbackPosted(false)
+{
+    // Paths are reported as m_root + '/' + relative path
+    while (m_root.size() > 1 && (m_root[m_root.size() - 1] == '/' || m_root[m_root.size() - 1] == '\\'))
+        m_root.erase(m_root.size() - 1);
+}
+
+FileWatcher::~FileWatcher()
+{
+    Stop();
+}
+
+void FileWatcher::Start(int handle)
+{
+    m_handle = handle;
+    WorkerPool::GetInstance().PostTask(new WatcherStartTask(this, m_forcePolling));
+}
+
+void FileWatcher::StartBackend(bool polling)
+{
+    AutoLock backendLock(m_backendLock);
+    if (IsStopping())
+        return;
+
+    // Replacing a backend that failed
+    bool fallback = m_backend != NULL;
+    if (m_backend) {
+        m_backend->Stop();
+        delete m_backend;
+        m_backend = NULL;
+    }
+
+    int error = ERR_UNKNOWN;
+    if (!polling) {
+        m_backend = CreateNativeWatchBackend();
+        error = m_backend->Start(m_root, this);
+        if (error != NO_ERROR) {
+            delete m_backend;
+            m_backend = NULL;
+        }
+    }
+
+    if (error != NO_ERROR && !IsStopping()) {
+        polling = true;
+        m_backend = CreatePollingWatchBackend(kMinPollIntervalMs, kMaxPollIntervalMs);
+        error = m_backend->Start(m_root, this);
+        if (error != NO_ERROR) {
+            delete m_backend;
+            m_backend = NULL;
+        }
+    }
+
+    {
+        AutoLock lock(m_lock);
+        m_polling = m_backend && polling;
+        m_fallbackPosted = false;
+    }
+
+    // Whatever happened between the failure and the new snapshot is lost
+    if (fallback && m_backend)
+        AddChange(m_root, CHANGE_RESCAN);
+}
+
+void FileWatcher::Stop()
+{
+    m_stopping.Set();
+
+    AutoLock backendLock(m_backendLock);
+    if (m_backend) {
+        m_backend->Stop();
+        delete m_backend;
+        m_backend = NULL;
+    }
+}
+
+bool FileWatcher::IsPolling() const
+{
+    AutoLock lock(m_lock);
+    return m_polling;
+}
+
+void FileWatcher::TakeChanges(std::vector<FileChange>& changes)
+{
+    AutoLock lock(m_lock);
+    for (std::map<ExtensionString, ChangeKind>::const_iterator it = m_pending.begin(); it != m_pending.end(); ++it) {
+        FileChange change;
+        change.path = it->first;
+        change.kind = it->second;
+        changes.push_back(change);
+    }
+    m_pending.clear();
+    m_flushPosted = false;
+}
+
+void FileWatcher::AddChange(const ExtensionString& path, ChangeKind kind)
+{
+    AutoLock lock(m_lock);
+    if (IsStopping())
+        return;
+
+    std::map<ExtensionString, ChangeKind>::iterator root = m_pending.find(m_root);
+    if (root != m_pending.end() && root->second == CHANGE_RESCAN) {
+        // Covered by the rescan of the whole tree
+    } else if (kind == CHANGE_RESCAN && path == m_root) {
+        m_pending.clear();
+        m_pending[m_root] = CHANGE_RESCAN;
+    } else {
+        std::map<ExtensionString, ChangeKind>::iterator it = m_pending.find(path);
+        if (it == m_pending.end()) {
+            if (m_pending.size() < kMaxPendingChanges) {
+                m_pending[path] = kind;
+            } else {
+                m_pending.clear();
+                m_pending[m_root] = CHANGE_RESCAN;
+            }
+        } else {
+            int coalesced = CoalesceChanges(it->second, kind);
+            if (coalesced)
+                it->second = (ChangeKind)coalesced;
+            else
+                m_pending.erase(it);
+        }
+    }
+
+    if (!m_flushPosted) {
+        m_flushPosted = true;
+        CefPostDelayedTask(TID_UI, new WatcherFlushTask(m_handle), m_latencyMs);
+    }
+}
+
+void FileWatcher::BackendFailed()
+{
+    AutoLock lock(m_lock);
+    if (m_fallbackPosted || IsStopping())
+        return;
+
+    m_fallbackPosted = true;
+    WorkerPool::GetInstance().PostTask(new WatcherStartTask(this, true));
+}
+
+} // namespace FileSystem
+
+///
+// WatcherRegistry
+///
+WatcherRegistry& WatcherRegistry::GetInstance()
+{
+    static WatcherRegistry instance;
+    return instance;
+}
+
+WatcherRegistry::WatcherRegistry() : m_nextHandle(1)
+{
+}
+
+int WatcherRegistry::Add(CefRefPtr<FileSystem::FileWatcher> watcher,
+                         CefRefPtr<CefV8Value> callback,
+                         CefRefPtr<CefV8Context> context)
+{
+    int handle = m_nextHandle++;
+    Entry& entry = m_watchers[handle];
+    entry.watcher = watcher;
+    entry.callback = callback;
+    entry.context = context;
+
+    watcher->Start(handle);
+    return handle;
+}
+
+bool WatcherRegistry::Close(int handle)
+{
+    std::map<int, Entry>::iterator it = m_watchers.find(handle);
+    if (it == m_watchers.end())
+        return false;
+
+    it->second.watcher->Stop();
+    m_watchers.erase(it);
+    return true;
+}
+
+void WatcherRegistry::ReleaseContext(CefRefPtr<CefV8Context> context)
+{
+    std::map<int, Entry>::iterator it = m_watchers.begin();
+    while (it != m_watchers.end()) {
+        if (it->second.context->IsSame(context)) {
+            it->second.watcher->Stop();
+            m_watchers.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void WatcherRegistry::Flush(int handle)
+{
+    std::map<int, Entry>::iterator it = m_watchers.find(handle);
+    if (it == m_watchers.end())
+        return;
+
+    std::vector<FileSystem::FileChange> changes;
+    it->second.watcher->TakeChanges(changes);
+    if (changes.empty())
+        return;
+
+    // The entry may go away while JS runs
+    Entry entry = it->second;
+
+    // This is a posted task, not a V8 callback, so the context has to be
+    // entered before the list can be made
+    if (!entry.context->Enter())
+        return;
+
+    CefRefPtr<CefV8Value> list = CefV8Value::CreateArray();
+    for (size_t i = 0; i < changes.size(); i++) {
+        CefRefPtr<CefV8Value> item = CefV8Value::CreateObject(NULL);
+        item->SetValue("path", CefV8Value::CreateString(changes[i].path), V8_PROPERTY_ATTRIBUTE_NONE);
+        item->SetValue("kind", CefV8Value::CreateInt(changes[i].kind), V8_PROPERTY_ATTRIBUTE_NONE);
+        list->SetValue((int)i, item);
+    }
+
+    CefV8ValueList args;
+    args.push_back(list);
+    args.push_back(CefV8Value::CreateBool(entry.watcher->IsPolling()));
+    InvokeCallback(entry.context, entry.callback, args);
+    entry.context->Exit();
+}
+
+///
+// Native functions
+///
+int ExecuteWatchPath(const CefV8ValueList& arguments,
+                     CefRefPtr<CefV8Value>& retval,
+                     CefString& exception)
+{
+    if (arguments.size() < 2 || arguments.size() > 4 || !arguments[0]->IsString() || !arguments[1]->IsFunction())
+        return ERR_INVALID_PARAMS;
+
+    int latencyMs = 100;
+    if (arguments.size() > 2) {
+        if (!arguments[2]->IsInt() || arguments[2]->GetIntValue() < 0 || arguments[2]->GetIntValue() > 60000)
+            return ERR_INVALID_PARAMS;
+        latencyMs = arguments[2]->GetIntValue();
+    }
+
+    bool forcePolling = false;
+    if (arguments.size() > 3) {
+        if (!arguments[3]->IsBool())
+            return ERR_INVALID_PARAMS;
+        forcePolling = arguments[3]->GetBoolValue();
+    }
+
+    ExtensionString pathStr = arguments[0]->GetStringValue();
+    bool isDirectory;
+    int error = FileSystem::IsDirectory(pathStr, isDirectory);
+    if (error != NO_ERROR)
+        return error;
+    if (!isDirectory)
+        return ERR_NOT_DIRECTORY;
+
+    CefRefPtr<FileSystem::FileWatcher> watcher = new FileSystem::FileWatcher(pathStr, latencyMs, forcePolling);
+    int handle = WatcherRegistry::GetInstance().Add(watcher, arguments[1], CefV8Context::GetCurrentContext());
+    retval = CefV8Value::CreateInt(handle);
+    return NO_ERROR;
+}
+
+int ExecuteUnwatchPath(const CefV8ValueList& arguments,
+                       CefRefPtr<CefV8Value>& retval,
+                       CefString& exception)
+{
+    if (arguments.size() != 1 || !arguments[0]->IsInt())
+        return ERR_INVALID_PARAMS;
+
+    retval = CefV8Value::CreateBool(WatcherRegistry::GetInstance().Close(arguments[0]->GetIntValue()));
+    return NO_ERROR;
+}
+
+} // namespace Brackets
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _BRACKETS_WATCHER_H
+#define _BRACKETS_WATCHER_H
+
+#include "include/cef.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_thread.h"
+
+#include <map>
+#include <vector>
+
+namespace Brackets {
+namespace FileSystem {
+
+// What happened to a path. Values are shared with brackets_extensions.js.
+enum ChangeKind {
+    CHANGE_CREATED  = 1,
+    CHANGE_MODIFIED = 2,
+    CHANGE_DELETED  = 3,
+    CHANGE_RESCAN   = 4,    // changes under the path were lost; read it again
+};
+
+struct FileChange {
+    ExtensionString path;
+    ChangeKind kind;
+};
+
+// Where a WatchBackend sends what it sees. Called from the backend's threads.
+class ChangeSink
+{
+public:
+    virtual ~ChangeSink() {}
+
+    virtual void AddChange(const ExtensionString& path, ChangeKind kind) =0;
+
+    // The backend can no longer see every change under the root, for
+    // instance because the system ran out of watch descriptors
+    virtual void BackendFailed() =0;
+
+    // Long scans check this and give up early when the watch is going away
+    virtual bool IsStopping() const =0;
+};
+
+/**
+ * A source of change notifications for a directory tree. Start() begins
+ * watching |root| and everything below it. Paths passed to the sink start
+ * with |root| and use '/' as the separator on every platform. Stop() returns
+ * once the backend has stopped calling the sink.
+ */
+class WatchBackend
+{
+public:
+    virtual ~WatchBackend() {}
+
+    virtual int Start(const ExtensionString& root, ChangeSink* sink) =0;
+    virtual void Stop() =0;
+};
+
+// inotify on Linux, FSEvents on Mac, ReadDirectoryChangesW on Windows.
+// Lives in brackets_watcher_<platform>.cpp.
+WatchBackend* CreateNativeWatchBackend();
+
+// Scans the tree with ReadDirWithStats every |minIntervalMs| or more: the
+// interval doubles while nothing changes, up to |maxIntervalMs|, and is never
+// less than ten times the time the last scan took
+WatchBackend* CreatePollingWatchBackend(int minIntervalMs, int maxIntervalMs);
+
+/**
+ * Sizes, modification times and types of everything under a directory, used
+ * to find changes by comparing scans. Backends that only learn which
+ * directories changed (polling, FSEvents) rescan those and report the
+ * difference.
+ */
+class TreeSnapshot
+{
+public:
+    // Takes a new snapshot of everything under |root|, reporting nothing.
+    // |sink| is only asked whether to stop. Returns false if it was stopped.
+    bool Scan(const ExtensionString& root, ChangeSink* sink);
+
+    // Reads |directory| again, and everything below it with |recursive|, and
+    // reports what changed since the last scan to |sink|. Subdirectories that
+    // appear or disappear are always scanned whole. Returns false if the scan
+    // was stopped.
+    bool Rescan(const ExtensionString& directory, bool recursive, ChangeSink* sink);
+
+    size_t GetEntryCount() const { return m_entries.size(); }
+
+private:
+    bool Rescan(const ExtensionString& directory, bool recursive, ChangeSink* sink, bool report, int depth);
+
+    // Removes the entries below |directory|
+    void RemoveChildren(const ExtensionString& directory, ChangeSink* sink, bool report);
+
+    // Full path to type, size and modification time
+    std::map<ExtensionString, FileInfo> m_entries;
+};
+
+/**
+ * Watches a directory tree and hands changes to JS in batches.
+ *
+ * Raw events from the backend are coalesced by path: a file written a
+ * hundred times is one CHANGE_MODIFIED, and a file created and deleted
+ * before JS hears of it is not reported at all. The first change after a
+ * batch is delivered starts a window of |latencyMs|; when it closes,
+ * everything that arrived meanwhile is sent in one batch. A flood of
+ * changes, more than JS could usefully handle one at a time, collapses into
+ * a single CHANGE_RESCAN of the root.
+ *
+ * The native backend is used when it can watch the whole tree. If it can't
+ * start, or fails later (Linux allows a limited number of inotify watches
+ * per user), the watcher falls back to polling and reports a CHANGE_RESCAN
+ * of the root, since changes may have been missed in between.
+ */
+class FileWatcher : public CefBase, public ChangeSink
+{
+public:
+    FileWatcher(const ExtensionString& root, int latencyMs, bool forcePolling);
+    virtual ~FileWatcher();
+
+    // Starts watching on the WorkerPool, so that walking a large tree does
+    // not hold up the caller. |handle| is the WatcherRegistry handle that
+    // batches are delivered to.
+    void Start(int handle);
+
+    // Stops the backend. No more batches are posted after this returns.
+    void Stop();
+
+    bool IsPolling() const;
+
+    // Moves the changes waiting for delivery to |changes|
+    void TakeChanges(std::vector<FileChange>& changes);
+
+    // ChangeSink
+    virtual void AddChange(const ExtensionString& path, ChangeKind kind);
+    virtual void BackendFailed();
+    virtual bool IsStopping() const { return m_stopping.IsSet(); }
+
+    // Starts the native backend, or polling if that fails. Runs on the
+    // WorkerPool.
+    void StartBackend(bool polling);
+
+private:
+    ExtensionString m_root;
+    int m_latencyMs;
+    int m_handle;
+    bool m_forcePolling;
+
+    // Guards the backend, which is started and stopped on different threads
+    Lock m_backendLock;
+    WatchBackend* m_backend;
+    bool m_polling;
+    AtomicFlag m_stopping;
+
+    // Guards the changes waiting for delivery
+    mutable Lock m_lock;
+    std::map<ExtensionString, ChangeKind> m_pending;
+    bool m_flushPosted;
+    bool m_fallbackPosted;
+
+    IMPLEMENT_REFCOUNTING(FileWatcher);
+};
+
+} // namespace FileSystem
+
+/**
+ * The FileWatchers that JS has started, by handle, with the JS function
+ * that gets their batches. Watchers belong to the V8 context that started
+ * them and are stopped with it. UI thread only.
+ */
+class WatcherRegistry
+{
+public:
+    static WatcherRegistry& GetInstance();
+
+    // Registers and starts |watcher|. Returns its handle.
+    int Add(CefRefPtr<FileSystem::FileWatcher> watcher,
+            CefRefPtr<CefV8Value> callback,
+            CefRefPtr<CefV8Context> context);
+
+    // Stops |handle|. Returns false if it was not watching.
+    bool Close(int handle);
+
+    // Stops every watcher started from |context|
+    void ReleaseContext(CefRefPtr<CefV8Context> context);
+
+    // Delivers the changes of |handle| that are waiting. Runs as a UI-thread
+    // task, posted when a batch window closes.
+    void Flush(int handle);
+
+    size_t GetWatcherCount() const { return m_watchers.size(); }
+
+private:
+    WatcherRegistry();
+
+    struct Entry {
+        CefRefPtr<FileSystem::FileWatcher> watcher;
+        CefRefPtr<CefV8Value> callback;
+        CefRefPtr<CefV8Context> context;
+    };
+
+    std::map<int, Entry> m_watchers;
+    int m_nextHandle;
+};
+
+// Native functions for watchers, registered by brackets_fs_extension.cpp
+int ExecuteWatchPath(const CefV8ValueList& arguments,
+                     CefRefPtr<CefV8Value>& retval,
+                     CefString& exception);
+int ExecuteUnwatchPath(const CefV8ValueList& arguments,
+                       CefRefPtr<CefV8Value>& retval,
+                       CefString& exception);
+
+} // namespace Brackets
+
+#endif // _BRACKETS_WATCHER_H
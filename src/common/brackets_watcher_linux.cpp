@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_watcher.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+const uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO |
+                            IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+const size_t kEventBufferSize = 64 * 1024;
+
+/**
+ * Watches a tree with inotify. inotify is not recursive, so every directory
+ * gets a watch of its own, added as directories appear. Watches are limited
+ * per user (fs.inotify.max_user_watches). When the tree needs more, Start()
+ * fails with ERR_OUT_OF_SPACE, or the sink is told the backend failed, and
+ * the watcher falls back to polling.
+ *
+ * Events are read on a thread of the backend's own, which Stop() wakes
+ * through a pipe.
+ */
+class InotifyBackend : public WatchBackend
+{
+public:
+    InotifyBackend() : m_fd(-1), m_sink(NULL), m_running(false), m_failed(false)
+    {
+        m_stopPipe[0] = m_stopPipe[1] = -1;
+    }
+
+    virtual ~InotifyBackend() { Stop(); }
+
+    virtual int Start(const ExtensionString& root, ChangeSink* sink);
+    virtual void Stop();
+
+private:
+    static void* ThreadMain(void* param);
+    void Run();
+    void HandleEvent(const struct inotify_event& event);
+
+    // Watches |directory| and every directory below it. With |report|, all
+    // that is found is reported as created: the directory just appeared and
+    // its contents may have been written before the watch was in place.
+    int AddWatches(const ExtensionString& directory, bool report);
+
+    // Drops the watches on |directory| and below, which was moved or deleted
+    void RemoveWatches(const ExtensionString& directory);
+    void RemoveWatch(std::map<ExtensionString, int>::iterator it);
+
+    void Close();
+
+    int m_fd;
+    int m_stopPipe[2];
+    pthread_t m_thread;
+    ExtensionString m_root;
+    ChangeSink* m_sink;
+    bool m_running;
+    bool m_failed;
+
+    // Watch descriptors and the directories they watch. Only used by Start()
+    // and then by the event thread.
+    std::map<int, ExtensionString> m_paths;
+    std::map<ExtensionString, int> m_watches;
+};
+
+int InotifyBackend::Start(const ExtensionString& root, ChangeSink* sink)
+{
+    m_root = root;
+    m_sink = sink;
+
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        // Too many inotify instances for this user
+        return errno == EMFILE ? ERR_OUT_OF_SPACE : ConvertErrnoCode(errno);
+    }
+
+    if (pipe2(m_stopPipe, O_CLOEXEC) == -1) {
+        int error = ConvertErrnoCode(errno);
+        Close();
+        return error;
+    }
+
+    int error = AddWatches(m_root, false);
+    if (error == NO_ERROR && m_watches.find(m_root) == m_watches.end())
+        error = ERR_NOT_FOUND;
+    if (error == NO_ERROR && pthread_create(&m_thread, NULL, ThreadMain, this) != 0)
+        error = ERR_UNKNOWN;
+
+    if (error != NO_ERROR) {
+        Close();
+        return error;
+    }
+
+    m_running = true;
+    return NO_ERROR;
+}
+
+void InotifyBackend::Stop()
+{
+    if (m_running) {
+        char wake = 0;
+        while (write(m_stopPipe[1], &wake, 1) == -1 && errno == EINTR)
+            ;
+        pthread_join(m_thread, NULL);
+        m_running = false;
+    }
+    Close();
+}
+
+void InotifyBackend::Close()
+{
+    // Closing the inotify descriptor drops all of its watches at once
+    if (m_fd >= 0)
+        close(m_fd);
+    if (m_stopPipe[0] >= 0)
+        close(m_stopPipe[0]);
+    if (m_stopPipe[1] >= 0)
+        close(m_stopPipe[1]);
+    m_fd = m_stopPipe[0] = m_stopPipe[1] = -1;
+    m_paths.clear();
+    m_watches.clear();
+}
+
+void* InotifyBackend::ThreadMain(void* param)
+{
+    static_cast<InotifyBackend*>(param)->Run();
+    return NULL;
+}
+
+void InotifyBackend::Run()
+{
+    std::vector<char> buffer(kEventBufferSize);
+
+    while (!m_failed) {
+        struct pollfd fds[2];
+        fds[0].fd = m_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = m_stopPipe[0];
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents)
+            break;
+
+        ssize_t length = read(m_fd, &buffer[0], buffer.size());
+        if (length <= 0) {
+            if (length == -1 && (errno == EAGAIN || errno == EINTR))
+                continue;
+            break;
+        }
+
+        // Events are variable length, and aligned for struct inotify_event
+        for (ssize_t offset = 0; offset < length; ) {
+            const struct inotify_event* event = (const struct inotify_event*)&buffer[offset];
+            HandleEvent(*event);
+            offset += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    if (m_failed)
+        m_sink->BackendFailed();
+}
+
+void InotifyBackend::HandleEvent(const struct inotify_event& event)
+{
+    if (event.mask & IN_Q_OVERFLOW) {
+        m_sink->AddChange(m_root, CHANGE_RESCAN);
+        return;
+    }
+
+    std::map<int, ExtensionString>::iterator it = m_paths.find(event.wd);
+    if (it == m_paths.end())
+        return;
+
+    if (event.mask & IN_IGNORED) {
+        // The directory is gone and the kernel removed its watch
+        m_watches.erase(it->second);
+        m_paths.erase(it);
+        return;
+    }
+
+    if (event.mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+        // Directories below the root are reported by their parent
+        if (it->second == m_root)
+            m_sink->AddChange(m_root, (event.mask & IN_DELETE_SELF) ? CHANGE_DELETED : CHANGE_RESCAN);
+        return;
+    }
+
+    if (event.len == 0)
+        return;
+
+    ExtensionString path = it->second + "/" + event.name;
+    bool isDirectory = (event.mask & IN_ISDIR) != 0;
+
+    if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+        m_sink->AddChange(path, CHANGE_CREATED);
+        if (isDirectory && AddWatches(path, true) == ERR_OUT_OF_SPACE)
+            m_failed = true;
+    } else if (event.mask & (IN_DELETE | IN_MOVED_FROM)) {
+        if (isDirectory)
+            RemoveWatches(path);
+        m_sink->AddChange(path, CHANGE_DELETED);
+    } else if (!isDirectory && (event.mask & (IN_MODIFY | IN_ATTRIB))) {
+        m_sink->AddChange(path, CHANGE_MODIFIED);
+    }
+}
+
+int InotifyBackend::AddWatches(const ExtensionString& directory, bool report)
+{
+    if (m_sink->IsStopping())
+        return ERR_CANCELLED;
+
+    int wd = inotify_add_watch(m_fd, directory.c_str(), kWatchMask);
+    if (wd < 0) {
+        if (errno == ENOSPC || errno == ENOMEM)
+            return ERR_OUT_OF_SPACE;
+
+        // Removed already, or not readable: nothing to watch
+        return NO_ERROR;
+    }
+
+    // A directory moved within the tree keeps its watch descriptor
+    std::map<int, ExtensionString>::iterator old = m_paths.find(wd);
+    if (old != m_paths.end())
+        m_watches.erase(old->second);
+    m_paths[wd] = directory;
+    m_watches[directory] = wd;
+
+    DIR* dir = opendir(directory.c_str());
+    if (!dir)
+        return NO_ERROR;
+
+    int error = NO_ERROR;
+    struct dirent* entry;
+    while (error == NO_ERROR && (entry = readdir(dir)) != NULL) {
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+            continue;
+
+        ExtensionString path = directory + "/" + entry->d_name;
+        if (report)
+            m_sink->AddChange(path, CHANGE_CREATED);
+
+        // Symlinks are not followed, so a link to a parent can't loop
+        bool isDirectory = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat buffer;
+            isDirectory = lstat(path.c_str(), &buffer) == 0 && S_ISDIR(buffer.st_mode);
+        }
+        if (isDirectory)
+            error = AddWatches(path, report);
+    }
+
+    closedir(dir);
+    return error;
+}
+
+void InotifyBackend::RemoveWatches(const ExtensionString& directory)
+{
+    std::map<ExtensionString, int>::iterator it = m_watches.find(directory);
+    if (it != m_watches.end())
+        RemoveWatch(it);
+
+    // Directories below sort between "directory/" and "directory0"
+    it = m_watches.lower_bound(directory + "/");
+    std::map<ExtensionString, int>::iterator end = m_watches.lower_bound(directory + "0");
+    while (it != end)
+        RemoveWatch(it++);
+}
+
+void InotifyBackend::RemoveWatch(std::map<ExtensionString, int>::iterator it)
+{
+    inotify_rm_watch(m_fd, it->second);
+    m_paths.erase(it->second);
+    m_watches.erase(it);
+}
+
+} // namespace
+
+WatchBackend* CreateNativeWatchBackend()
+{
+    return new InotifyBackend();
+}
+
+} // namespace FileSystem
+} // namespace Brackets
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_watcher.h"
+
+#include <CoreServices/CoreServices.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+// How long FSEvents gathers events before calling back. FileWatcher adds
+// its own window on top.
+const CFTimeInterval kStreamLatency = 0.05;
+
+// How often the run loop checks whether the backend is stopping
+const CFTimeInterval kRunLoopTimeout = 0.25;
+
+/**
+ * Watches a tree with FSEvents. One stream covers the whole tree, so there
+ * are no per-directory limits. Before 10.7 FSEvents only says which
+ * directories changed, not which files, so each directory it names is
+ * compared against a TreeSnapshot to find the files that changed.
+ *
+ * The stream is scheduled on the run loop of a thread of the backend's own.
+ */
+class FSEventsBackend : public WatchBackend
+{
+public:
+    FSEventsBackend() : m_sink(NULL), m_running(false), m_startError(NO_ERROR) {}
+    virtual ~FSEventsBackend() { Stop(); }
+
+    virtual int Start(const ExtensionString& root, ChangeSink* sink);
+    virtual void Stop();
+
+private:
+    static void* ThreadMain(void* param);
+    void Run();
+
+    static void StreamCallback(ConstFSEventStreamRef stream, void* info, size_t eventCount,
+                               void* eventPaths, const FSEventStreamEventFlags flags[],
+                               const FSEventStreamEventId ids[]);
+    void HandleEvent(const char* path, FSEventStreamEventFlags flags);
+
+    ExtensionString m_root;
+    ExtensionString m_realRoot;
+    ChangeSink* m_sink;
+    TreeSnapshot m_snapshot;
+
+    pthread_t m_thread;
+    bool m_running;
+    AtomicFlag m_stopping;
+    WaitableEvent m_started;
+    int m_startError;
+};
+
+int FSEventsBackend::Start(const ExtensionString& root, ChangeSink* sink)
+{
+    m_root = root;
+    m_sink = sink;
+
+    // FSEvents reports real paths: /tmp/x comes back as /private/tmp/x
+    char realPath[PATH_MAX];
+    if (!realpath(m_root.c_str(), realPath))
+        return ConvertErrnoCode(errno);
+    m_realRoot = realPath;
+
+    if (!m_snapshot.Scan(m_root, m_sink))
+        return ERR_CANCELLED;
+
+    if (pthread_create(&m_thread, NULL, ThreadMain, this) != 0)
+        return ERR_UNKNOWN;
+    m_running = true;
+
+    m_started.Wait();
+    if (m_startError != NO_ERROR)
+        Stop();
+    return m_startError;
+}
+
+void FSEventsBackend::Stop()
+{
+    if (m_running) {
+        m_stopping.Set();
+        pthread_join(m_thread, NULL);
+        m_running = false;
+    }
+}
+
+void* FSEventsBackend::ThreadMain(void* param)
+{
+    static_cast<FSEventsBackend*>(param)->Run();
+    return NULL;
+}
+
+void FSEventsBackend::Run()
+{
+    CFStringRef path = CFStringCreateWithCString(NULL, m_realRoot.c_str(), kCFStringEncodingUTF8);
+    CFArrayRef paths = CFArrayCreate(NULL, (const void**)&path, 1, &kCFTypeArrayCallBacks);
+
+    FSEventStreamContext context;
+    memset(&context, 0, sizeof(context));
+    context.info = this;
+
+    FSEventStreamRef stream = FSEventStreamCreate(NULL, &FSEventsBackend::StreamCallback, &context, paths,
+                                                  kFSEventStreamEventIdSinceNow, kStreamLatency,
+                                                  kFSEventStreamCreateFlagNoDefer |
+                                                  kFSEventStreamCreateFlagWatchRoot);
+    CFRelease(paths);
+    CFRelease(path);
+
+    if (stream) {
+        FSEventStreamScheduleWithRunLoop(stream, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
+        if (!FSEventStreamStart(stream)) {
+            FSEventStreamInvalidate(stream);
+            FSEventStreamRelease(stream);
+            stream = NULL;
+        }
+    }
+
+    m_startError = stream ? NO_ERROR : ERR_UNKNOWN;
+    m_started.Signal();
+    if (!stream)
+        return;
+
+    // Callbacks run inside CFRunLoopRunInMode, on this thread
+    while (!m_stopping.IsSet())
+        CFRunLoopRunInMode(kCFRunLoopDefaultMode, kRunLoopTimeout, false);
+
+    FSEventStreamStop(stream);
+    FSEventStreamInvalidate(stream);
+    FSEventStreamRelease(stream);
+}
+
+void FSEventsBackend::StreamCallback(ConstFSEventStreamRef stream, void* info, size_t eventCount,
+                                     void* eventPaths, const FSEventStreamEventFlags flags[],
+                                     const FSEventStreamEventId ids[])
+{
+    FSEventsBackend* backend = static_cast<FSEventsBackend*>(info);
+    const char* const* paths = static_cast<const char* const*>(eventPaths);
+    for (size_t i = 0; i < eventCount && !backend->m_stopping.IsSet(); i++)
+        backend->HandleEvent(paths[i], flags[i]);
+}
+
+void FSEventsBackend::HandleEvent(const char* path, FSEventStreamEventFlags flags)
+{
+    if (flags & kFSEventStreamEventFlagRootChanged) {
+        // The root was moved or deleted
+        m_snapshot.Rescan(m_root, true, m_sink);
+        m_sink->AddChange(m_root, CHANGE_RESCAN);
+        return;
+    }
+
+    // Map the real path back to the one JS watches
+    ExtensionString realPath = path;
+    while (realPath.size() > 1 && realPath[realPath.size() - 1] == '/')
+        realPath.erase(realPath.size() - 1);
+    if (realPath.compare(0, m_realRoot.size(), m_realRoot) != 0)
+        return;
+    ExtensionString directory = m_root + realPath.substr(m_realRoot.size());
+
+    // When events were dropped, everything below the directory may have
+    // changed
+    bool recursive = (flags & (kFSEventStreamEventFlagMustScanSubDirs |
+                               kFSEventStreamEventFlagUserDropped |
+                               kFSEventStreamEventFlagKernelDropped)) != 0;
+    m_snapshot.Rescan(directory, recursive, m_sink);
+}
+
+} // namespace
+
+WatchBackend* CreateNativeWatchBackend()
+{
+    return new FSEventsBackend();
+}
+
+} // namespace FileSystem
+} // namespace Brackets
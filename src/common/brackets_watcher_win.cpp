@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "common/brackets_watcher.h"
+
+#include <windows.h>
+
+namespace Brackets {
+namespace FileSystem {
+
+namespace {
+
+const DWORD kNotifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                            FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+// Network shares fail reads of more than 64 KB
+const size_t kEventBufferSize = 64 * 1024;
+
+/**
+ * Watches a tree with ReadDirectoryChangesW. One handle covers the whole
+ * tree, so there are no per-directory limits.
+ *
+ * Reads are overlapped and issued by a thread of the backend's own, which
+ * waits for either a read or the stop event. Pending I/O can only be
+ * cancelled by the thread that issued it, so that thread also cancels its
+ * last read before it exits. If reads fail (some file systems don't support
+ * change notifications at all) the sink is told the backend failed.
+ */
+class DirectoryChangesBackend : public WatchBackend
+{
+public:
+    DirectoryChangesBackend()
+        : m_sink(NULL), m_directory(INVALID_HANDLE_VALUE), m_stopEvent(NULL), m_thread(NULL),
+          m_buffer(kEventBufferSize / sizeof(DWORD))
+    {
+        memset(&m_overlapped, 0, sizeof(m_overlapped));
+    }
+
+    virtual ~DirectoryChangesBackend() { Stop(); }
+
+    virtual int Start(const ExtensionString& root, ChangeSink* sink);
+    virtual void Stop();
+
+private:
+    static DWORD WINAPI ThreadMain(LPVOID param);
+    void Run();
+    bool ReadChanges();
+    void HandleChanges(DWORD length);
+
+    ExtensionString m_root;
+    ChangeSink* m_sink;
+    HANDLE m_directory;
+    HANDLE m_stopEvent;
+    HANDLE m_thread;
+    OVERLAPPED m_overlapped;
+
+    // DWORD aligned, as ReadDirectoryChangesW requires
+    std::vector<DWORD> m_buffer;
+};
+
+int DirectoryChangesBackend::Start(const ExtensionString& root, ChangeSink* sink)
+{
+    m_root = root;
+    m_sink = sink;
+
+    ExtensionString path = root;
+    for (size_t i = 0; i < path.size(); i++) {
+        if (path[i] == '/')
+            path[i] = '\\';
+    }
+
+    m_directory = CreateFile(path.c_str(), FILE_LIST_DIRECTORY,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+                             FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (m_directory == INVALID_HANDLE_VALUE)
+        return ConvertWinErrorCode(GetLastError());
+
+    m_stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    m_overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (m_stopEvent && m_overlapped.hEvent)
+        m_thread = CreateThread(NULL, 0, ThreadMain, this, 0, NULL);
+
+    if (!m_thread) {
+        Stop();
+        return ERR_UNKNOWN;
+    }
+    return NO_ERROR;
+}
+
+void DirectoryChangesBackend::Stop()
+{
+    if (m_thread) {
+        SetEvent(m_stopEvent);
+        WaitForSingleObject(m_thread, INFINITE);
+        CloseHandle(m_thread);
+        m_thread = NULL;
+    }
+    if (m_directory != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_directory);
+        m_directory = INVALID_HANDLE_VALUE;
+    }
+    if (m_stopEvent) {
+        CloseHandle(m_stopEvent);
+        m_stopEvent = NULL;
+    }
+    if (m_overlapped.hEvent) {
+        CloseHandle(m_overlapped.hEvent);
+        m_overlapped.hEvent = NULL;
+    }
+}
+
+DWORD WINAPI DirectoryChangesBackend::ThreadMain(LPVOID param)
+{
+    static_cast<DirectoryChangesBackend*>(param)->Run();
+    return 0;
+}
+
+bool DirectoryChangesBackend::ReadChanges()
+{
+    ResetEvent(m_overlapped.hEvent);
+    return ReadDirectoryChangesW(m_directory, &m_buffer[0], (DWORD)(m_buffer.size() * sizeof(DWORD)),
+                                 TRUE, kNotifyFilter, NULL, &m_overlapped, NULL) != 0;
+}
+
+void DirectoryChangesBackend::Run()
+{
+    if (!ReadChanges()) {
+        m_sink->BackendFailed();
+        return;
+    }
+
+    HANDLE handles[2] = { m_stopEvent, m_overlapped.hEvent };
+    for (;;) {
+        if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) {
+            // Stopping. Wait for the cancelled read so that the kernel is
+            // done with the buffer.
+            DWORD length;
+            CancelIo(m_directory);
+            GetOverlappedResult(m_directory, &m_overlapped, &length, TRUE);
+            return;
+        }
+
+        DWORD length = 0;
+        if (!GetOverlappedResult(m_directory, &m_overlapped, &length, FALSE)) {
+            if (GetLastError() != ERROR_NOTIFY_ENUM_DIR) {
+                m_sink->BackendFailed();
+                return;
+            }
+            m_sink->AddChange(m_root, CHANGE_RESCAN);
+        } else if (length == 0) {
+            // More changes than fit in the buffer
+            m_sink->AddChange(m_root, CHANGE_RESCAN);
+        } else {
+            HandleChanges(length);
+        }
+
+        if (!ReadChanges()) {
+            m_sink->BackendFailed();
+            return;
+        }
+    }
+}
+
+void DirectoryChangesBackend::HandleChanges(DWORD length)
+{
+    const char* data = reinterpret_cast<const char*>(&m_buffer[0]);
+    for (DWORD offset = 0; offset < length; ) {
+        const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(data + offset);
+
+        // Names are relative to the root, not null-terminated
+        ExtensionString path = m_root + L"/";
+        path.append(info->FileName, info->FileNameLength / sizeof(WCHAR));
+        for (size_t i = m_root.size(); i < path.size(); i++) {
+            if (path[i] == '\\')
+                path[i] = '/';
+        }
+
+        switch (info->Action) {
+        case FILE_ACTION_ADDED:
+        case FILE_ACTION_RENAMED_NEW_NAME:
+            m_sink->AddChange(path, CHANGE_CREATED);
+            break;
+        case FILE_ACTION_REMOVED:
+        case FILE_ACTION_RENAMED_OLD_NAME:
+            m_sink->AddChange(path, CHANGE_DELETED);
+            break;
+        case FILE_ACTION_MODIFIED:
+            m_sink->AddChange(path, CHANGE_MODIFIED);
+            break;
+        }
+
+        if (info->NextEntryOffset == 0)
+            break;
+        offset += info->NextEntryOffset;
+    }
+}
+
+} // namespace
+
+WatchBackend* CreateNativeWatchBackend()
+{
+    return new DirectoryChangesBackend();
+}
+
+} // namespace FileSystem
+} // namespace Brackets
@@ -0,0 +1,84 @@
+# Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+#
+# Headless Linux host for the shared native code in ../common. It runs the
+# same CefV8Handler entry points as the desktop shells against the stub CEF
+# API in include/cef.h, for profiling and benchmarking on build machines.
+
+{
+  'variables': {
+    'brackets_common_sources': [
+      '../common/brackets_async.cpp',
+      '../common/brackets_async.h',
+      '../common/brackets_content_cache.cpp',
+      '../common/brackets_content_cache.h',
+      '../common/brackets_diff.cpp',
+      '../common/brackets_diff.h',
+      '../common/brackets_dispatch.h',
+      '../common/brackets_edit_journal.cpp',
+      '../common/brackets_edit_journal.h',
+      '../common/brackets_encoding.cpp',
+      '../common/brackets_encoding.h',
+      '../common/brackets_file_stream.cpp',
+      '../common/brackets_file_stream.h',
+      '../common/brackets_fs.cpp',
+      '../common/brackets_fs.h',
+      '../common/brackets_fs_extension.cpp',
+      '../common/brackets_fs_extension.h',
+      '../common/brackets_fs_posix.cpp',
+      '../common/brackets_hash.cpp',
+      '../common/brackets_hash.h',
+      '../common/brackets_path_handles.cpp',
+      '../common/brackets_path_handles.h',
+      '../common/brackets_path_matcher.cpp',
+      '../common/brackets_path_matcher.h',
+      '../common/brackets_path_store.cpp',
+      '../common/brackets_path_store.h',
+      '../common/brackets_project_snapshot.cpp',
+      '../common/brackets_project_snapshot.h',
+      '../common/brackets_regex.cpp',
+      '../common/brackets_regex.h',
+      '../common/brackets_search.cpp',
+      '../common/brackets_search.h',
+      '../common/brackets_search_index.cpp',
+      '../common/brackets_search_index.h',
+      '../common/brackets_stat_cache.cpp',
+      '../common/brackets_stat_cache.h',
+      '../common/brackets_thread.cpp',
+      '../common/brackets_thread.h',
+      '../common/brackets_thread_posix.cpp',
+      '../common/brackets_walker.cpp',
+      '../common/brackets_walker.h',
+      '../common/brackets_watcher.cpp',
+      '../common/brackets_watcher.h',
+      '../common/brackets_watcher_linux.cpp',
+    ],
+  },
+  'targets': [
+    {
+      'target_name': 'brackets_headless',
+      'type': 'executable',
+      'include_dirs': [
+        '.',
+        '..',
+      ],
+      'sources': [
+        '<@(brackets_common_sources)',
+        'headless/cef_stub.cpp',
+        'headless/headless_bench.cpp',
+        'headless/headless_bench.h',
+        'headless/headless_fixture.cpp',
+        'headless/headless_fixture.h',
+        'headless/headless_main.cpp',
+        'headless/headless_tests.cpp',
+        'headless/headless_tests.h',
+        'include/cef.h',
+      ],
+      'link_settings': {
+        'libraries': [
+          '-lpthread',
+          '-lrt',
+        ],
+      },
+    },
+  ],
+}
@@ -0,0 +1,483 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "include/cef.h"
+
+#include <assert.h>
+#include <deque>
+#include <map>
+#include <pthread.h>
+#include <sys/time.h>
+
+///
+// CefString
+///
+CefString::CefString(const std::wstring& src)
+{
+    for (size_t i = 0; i < src.size(); i++) {
+        unsigned long c = (unsigned long)src[i];
+        if (c < 0x80) {
+            str_ += (char)c;
+        } else if (c < 0x800) {
+            str_ += (char)(0xC0 | (c >> 6));
+            str_ += (char)(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            str_ += (char)(0xE0 | (c >> 12));
+            str_ += (char)(0x80 | ((c >> 6) & 0x3F));
+            str_ += (char)(0x80 | (c & 0x3F));
+        } else {
+            str_ += (char)(0xF0 | (c >> 18));
+            str_ += (char)(0x80 | ((c >> 12) & 0x3F));
+            str_ += (char)(0x80 | ((c >> 6) & 0x3F));
+            str_ += (char)(0x80 | (c & 0x3F));
+        }
+    }
+}
+
+CefString::CefString(const wchar_t* src)
+{
+    *this = CefString(std::wstring(src ? src : L""));
+}
+
+std::wstring CefString::ToWString() const
+{
+    std::wstring result;
+    const unsigned char* p = (const unsigned char*)str_.data();
+    const unsigned char* end = p + str_.size();
+
+    while (p < end) {
+        unsigned long c = *p++;
+        int trailing = 0;
+        if (c >= 0xF0) {
+            c &= 0x07;
+            trailing = 3;
+        } else if (c >= 0xE0) {
+            c &= 0x0F;
+            trailing = 2;
+        } else if (c >= 0xC0) {
+            c &= 0x1F;
+            trailing = 1;
+        }
+        for (; trailing > 0 && p < end; trailing--)
+            c = (c << 6) | (*p++ & 0x3F);
+        result += (wchar_t)c;
+    }
+
+    return result;
+}
+
+///
+// Threads and tasks
+///
+namespace {
+
+double WallTime()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// Number of times a V8 context has been entered and not yet exited on this
+// thread. As in CEF, objects, arrays and functions may only be created while
+// it is not 0.
+__thread int t_contextDepth = 0;
+
+// Task queue run by one thread
+class StubMessageLoop
+{
+public:
+    StubMessageLoop() : m_quit(false), m_running(false) {
+        pthread_mutex_init(&m_lock, NULL);
+        pthread_cond_init(&m_taskAvailable, NULL);
+    }
+
+    void PostTask(CefRefPtr<CefTask> task) {
+        pthread_mutex_lock(&m_lock);
+        m_tasks.push_back(task);
+        pthread_cond_signal(&m_taskAvailable);
+        pthread_mutex_unlock(&m_lock);
+    }
+
+    void PostDelayedTask(CefRefPtr<CefTask> task, long delayMs) {
+        pthread_mutex_lock(&m_lock);
+        m_delayedTasks.insert(std::make_pair(WallTime() + delayMs / 1000.0, task));
+        pthread_cond_signal(&m_taskAvailable);
+        pthread_mutex_unlock(&m_lock);
+    }
+
+    void Run(CefThreadId threadId) {
+        pthread_mutex_lock(&m_lock);
+        m_thread = pthread_self();
+        m_running = true;
+        while (!m_quit) {
+            // Queue delayed tasks that are due
+            double now = WallTime();
+            while (!m_delayedTasks.empty() && m_delayedTasks.begin()->first <= now) {
+                m_tasks.push_back(m_delayedTasks.begin()->second);
+                m_delayedTasks.erase(m_delayedTasks.begin());
+            }
+
+            if (m_tasks.empty()) {
+                if (m_delayedTasks.empty()) {
+                    pthread_cond_wait(&m_taskAvailable, &m_lock);
+                } else {
+                    double due = m_delayedTasks.begin()->first;
+                    struct timespec ts;
+                    ts.tv_sec = (time_t)due;
+                    ts.tv_nsec = (long)((due - ts.tv_sec) * 1e9);
+                    pthread_cond_timedwait(&m_taskAvailable, &m_lock, &ts);
+                }
+                continue;
+            }
+            CefRefPtr<CefTask> task = m_tasks.front();
+            m_tasks.pop_front();
+            pthread_mutex_unlock(&m_lock);
+            // Tasks run outside any V8 callback, even when the loop was
+            // started by code that had entered the context
+            int contextDepth = t_contextDepth;
+            t_contextDepth = 0;
+            task->Execute(threadId);
+            assert(t_contextDepth == 0);
+            t_contextDepth = contextDepth;
+            task = NULL;
+            pthread_mutex_lock(&m_lock);
+        }
+        m_running = false;
+        m_quit = false;
+        pthread_mutex_unlock(&m_lock);
+    }
+
+    void Quit() {
+        pthread_mutex_lock(&m_lock);
+        m_quit = true;
+        pthread_cond_signal(&m_taskAvailable);
+        pthread_mutex_unlock(&m_lock);
+    }
+
+    bool IsCurrent() {
+        pthread_mutex_lock(&m_lock);
+        bool current = m_running && pthread_equal(m_thread, pthread_self());
+        pthread_mutex_unlock(&m_lock);
+        return current;
+    }
+
+private:
+    pthread_mutex_t m_lock;
+    pthread_cond_t m_taskAvailable;
+    std::deque<CefRefPtr<CefTask> > m_tasks;
+    std::multimap<double, CefRefPtr<CefTask> > m_delayedTasks;
+    pthread_t m_thread;
+    bool m_quit;
+    bool m_running;
+};
+
+StubMessageLoop g_loops[TID_FILE + 1];
+pthread_once_t g_backgroundThreadsOnce = PTHREAD_ONCE_INIT;
+
+void* RunBackgroundLoop(void* param)
+{
+    CefThreadId threadId = (CefThreadId)(long)param;
+    g_loops[threadId].Run(threadId);
+    return NULL;
+}
+
+// TID_IO and TID_FILE run on their own threads for the life of the process
+void StartBackgroundThreads()
+{
+    for (long threadId = TID_IO; threadId <= TID_FILE; threadId++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, RunBackgroundLoop, (void*)threadId) == 0)
+            pthread_detach(thread);
+    }
+}
+
+} // namespace
+
+bool CefCurrentlyOn(CefThreadId threadId)
+{
+    return g_loops[threadId].IsCurrent();
+}
+
+bool CefPostTask(CefThreadId threadId, CefRefPtr<CefTask> task)
+{
+    if (threadId != TID_UI)
+        pthread_once(&g_backgroundThreadsOnce, StartBackgroundThreads);
+    g_loops[threadId].PostTask(task);
+    return true;
+}
+
+bool CefPostDelayedTask(CefThreadId threadId, CefRefPtr<CefTask> task,
+                        long delay_ms)
+{
+    if (threadId != TID_UI)
+        pthread_once(&g_backgroundThreadsOnce, StartBackgroundThreads);
+    g_loops[threadId].PostDelayedTask(task, delay_ms);
+    return true;
+}
+
+void CefRunMessageLoop()
+{
+    g_loops[TID_UI].Run(TID_UI);
+}
+
+void CefQuitMessageLoop()
+{
+    g_loops[TID_UI].Quit();
+}
+
+///
+// CefV8Value
+///
+namespace {
+
+// Plain value object standing in for a V8 handle
+class StubV8Value : public CefV8Value
+{
+public:
+    enum Type {
+        TYPE_UNDEFINED,
+        TYPE_NULL,
+        TYPE_BOOL,
+        TYPE_INT,
+        TYPE_DOUBLE,
+        TYPE_DATE,
+        TYPE_STRING,
+        TYPE_OBJECT,
+        TYPE_ARRAY,
+        TYPE_FUNCTION
+    };
+
+    explicit StubV8Value(Type type) : m_type(type), m_bool(false), m_int(0), m_double(0) {}
+
+    virtual bool IsUndefined() { return m_type == TYPE_UNDEFINED; }
+    virtual bool IsNull() { return m_type == TYPE_NULL; }
+    virtual bool IsBool() { return m_type == TYPE_BOOL; }
+    virtual bool IsInt() { return m_type == TYPE_INT; }
+    virtual bool IsDouble() { return m_type == TYPE_INT || m_type == TYPE_DOUBLE; }
+    virtual bool IsDate() { return m_type == TYPE_DATE; }
+    virtual bool IsString() { return m_type == TYPE_STRING; }
+    virtual bool IsObject() { return m_type == TYPE_OBJECT || m_type == TYPE_ARRAY || m_type == TYPE_DATE || m_type == TYPE_FUNCTION; }
+    virtual bool IsArray() { return m_type == TYPE_ARRAY; }
+    virtual bool IsFunction() { return m_type == TYPE_FUNCTION; }
+
+    virtual bool IsSame(CefRefPtr<CefV8Value> that) { return that.get() == this; }
+
+    virtual bool GetBoolValue() { return m_bool; }
+    virtual int GetIntValue() { return m_int; }
+    virtual double GetDoubleValue() { return m_double; }
+    virtual CefTime GetDateValue() { return CefTime(m_double); }
+    virtual CefString GetStringValue() { return m_string; }
+
+    virtual bool HasValue(const CefString& key) { return m_properties.find(key) != m_properties.end(); }
+    virtual bool HasValue(int index) { return index >= 0 && index < (int)m_elements.size(); }
+
+    virtual CefRefPtr<CefV8Value> GetValue(const CefString& key) {
+        std::map<CefString, CefRefPtr<CefV8Value> >::iterator it = m_properties.find(key);
+        return it != m_properties.end() ? it->second : NULL;
+    }
+    virtual CefRefPtr<CefV8Value> GetValue(int index) {
+        return HasValue(index) ? m_elements[index] : NULL;
+    }
+
+    virtual bool SetValue(const CefString& key, CefRefPtr<CefV8Value> value,
+                          PropertyAttribute attribute) {
+        if (!IsObject())
+            return false;
+        if (!HasValue(key))
+            m_keys.push_back(key);
+        m_properties[key] = value;
+        return true;
+    }
+    virtual bool SetValue(int index, CefRefPtr<CefV8Value> value) {
+        if (m_type != TYPE_ARRAY || index < 0)
+            return false;
+        if (index >= (int)m_elements.size())
+            m_elements.resize(index + 1, CefV8Value::CreateUndefined());
+        m_elements[index] = value;
+        return true;
+    }
+    virtual bool GetKeys(std::vector<CefString>& keys) {
+        keys = m_keys;
+        return true;
+    }
+
+    virtual int GetArrayLength() { return (int)m_elements.size(); }
+
+    virtual bool ExecuteFunction(CefRefPtr<CefV8Value> object,
+                                 const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefRefPtr<CefV8Exception>& exception,
+                                 bool rethrow_exception) {
+        CefString message;
+        if (m_type != TYPE_FUNCTION || !m_handler.get())
+            return false;
+        return m_handler->Execute(m_string, object, arguments, retval, message);
+    }
+    virtual bool ExecuteFunctionWithContext(CefRefPtr<CefV8Context> context,
+                                            CefRefPtr<CefV8Value> object,
+                                            const CefV8ValueList& arguments,
+                                            CefRefPtr<CefV8Value>& retval,
+                                            CefRefPtr<CefV8Exception>& exception,
+                                            bool rethrow_exception) {
+        if (!context->Enter())
+            return false;
+        bool result = ExecuteFunction(object, arguments, retval, exception, rethrow_exception);
+        context->Exit();
+        return result;
+    }
+
+    Type m_type;
+    bool m_bool;
+    int m_int;
+    double m_double;
+    CefString m_string;
+    CefRefPtr<CefV8Handler> m_handler;
+    std::vector<CefRefPtr<CefV8Value> > m_elements;
+    std::vector<CefString> m_keys;
+    std::map<CefString, CefRefPtr<CefV8Value> > m_properties;
+
+    IMPLEMENT_REFCOUNTING(StubV8Value);
+};
+
+} // namespace
+
+CefRefPtr<CefV8Value> CefV8Value::CreateUndefined()
+{
+    return new StubV8Value(StubV8Value::TYPE_UNDEFINED);
+}
+
+CefRefPtr<CefV8Value> CefV8Value::CreateNull()
+{
+    return new StubV8Value(StubV8Value::TYPE_NULL);
+}
+
+CefRefPtr<CefV8Value> CefV8Value::CreateBool(bool value)
+{
+    StubV8Value* result = new StubV8Value(StubV8Value::TYPE_BOOL);
+    result->m_bool = value;
+    return result;
+}
+
+CefRefPtr<CefV8Value> CefV8Value::CreateInt(int value)
+{
+    StubV8Value* result = new StubV8Value(StubV8Value::TYPE_INT);
+    result->m_int = value;
+    result->m_double = value;
+    return result;
+}
+
+CefRefPtr<CefV8Value> CefV8Value::CreateDouble(double value)
+{
+    StubV8Value* result = new StubV8Value(StubV8Value::TYPE_DOUBLE);
+    result->m_int = (int)value;
+    result->m_double = value;
+    return result;
+}
+
+CefRefPtr<CefV8Value> CefV8Value::CreateDate(const CefTime& date)
+{
+    StubV8Value* result = new StubV8Value(StubV8Value::TYPE_DATE);
+    result->m_double = date.GetDoubleT();
+    return result;
+}
+
+CefRefPtr<CefV8Value> CefV8Value::CreateString(const CefString& value)
+{
+    StubV8Value* result = new StubV8Value(StubV8Value::TYPE_STRING);
+    result->m_string = value;
+    return result;
+}
+
+CefRefPtr<CefV8Value> CefV8Value::CreateObject(CefRefPtr<CefBase> user_data)
+{
+    assert(t_contextDepth > 0);
+    return new StubV8Value(StubV8Value::TYPE_OBJECT);
+}
+
+CefRefPtr<CefV8Value> CefV8Value::CreateArray()
+{
+    assert(t_contextDepth > 0);
+    return new StubV8Value(StubV8Value::TYPE_ARRAY);
+}
+
+CefRefPtr<CefV8Value> CefV8Value::CreateFunction(const CefString& name,
+                                                 CefRefPtr<CefV8Handler> handler)
+{
+    assert(t_contextDepth > 0);
+    StubV8Value* result = new StubV8Value(StubV8Value::TYPE_FUNCTION);
+    result->m_string = name;
+    result->m_handler = handler;
+    return result;
+}
+
+///
+// CefV8Context
+///
+namespace {
+
+class StubV8Context : public CefV8Context
+{
+public:
+    StubV8Context() : m_global(new StubV8Value(StubV8Value::TYPE_OBJECT)) {}
+
+    virtual CefRefPtr<CefV8Value> GetGlobal() { return m_global; }
+    virtual bool Enter() {
+        t_contextDepth++;
+        return true;
+    }
+    virtual bool Exit() {
+        assert(t_contextDepth > 0);
+        t_contextDepth--;
+        return true;
+    }
+    virtual bool IsSame(CefRefPtr<CefV8Context> that) { return that.get() == this; }
+
+private:
+    CefRefPtr<CefV8Value> m_global;
+
+    IMPLEMENT_REFCOUNTING(StubV8Context);
+};
+
+CefRefPtr<CefV8Context> GetContext()
+{
+    static CefRefPtr<CefV8Context> s_context = new StubV8Context();
+    return s_context;
+}
+
+} // namespace
+
+CefRefPtr<CefV8Context> CefV8Context::GetCurrentContext()
+{
+    return GetContext();
+}
+
+CefRefPtr<CefV8Context> CefV8Context::GetEnteredContext()
+{
+    return GetContext();
+}
+
+bool CefV8Context::InContext()
+{
+    return t_contextDepth > 0;
+}
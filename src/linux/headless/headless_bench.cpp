@@ -0,0 +1,4021 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "headless_bench.h"
+#include "common/brackets_dispatch.h"
+#include "common/brackets_encoding.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_fs_extension.h"
+#include "common/brackets_hash.h"
+#include "common/brackets_path_handles.h"
+#include "common/brackets_path_store.h"
+#include "common/brackets_search_index.h"
+#include "common/brackets_watcher.h"
+
+#include <algorithm>
+#include <ctype.h>
+#include <fcntl.h>
+#include <iconv.h>
+#include <limits.h>
+#include <malloc.h>
+#include <map>
+#include <regex.h>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace Headless {
+
+int RunFileSystemBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    Project project;
+    double start = Now();
+    if (!MakeProject(options, project))
+        return 1;
+    const std::vector<std::string>& dirs = project.dirs;
+    PrintResult("create tree (WriteFile)", Now() - start, options.files);
+
+    for (int iteration = 0; iteration < options.iterations; iteration++) {
+        CefRefPtr<CefV8Value> retval;
+        std::vector<std::string> paths;
+        long calls = 0;
+
+        // What ProjectManager does when the tree is opened: readdir on every
+        // directory, then a stat (IsDirectory + GetFileModificationTime) on
+        // every entry.
+        start = Now();
+        for (size_t i = 0; i < dirs.size(); i++) {
+            if (Call(handler, "ReadDir", Args(CefV8Value::CreateString(dirs[i])), retval) != NO_ERROR)
+                return 1;
+            std::vector<std::string> names;
+            GetResultNames(retval, names);
+            for (size_t j = 0; j < names.size(); j++)
+                paths.push_back(dirs[i] + "/" + names[j]);
+            calls += 2;
+        }
+        PrintResult("ReadDir", Now() - start, calls);
+
+        start = Now();
+        calls = 0;
+        for (size_t i = 0; i < paths.size(); i++) {
+            CefRefPtr<CefV8Value> path = CefV8Value::CreateString(paths[i]);
+            if (Call(handler, "IsDirectory", Args(path), retval) != NO_ERROR ||
+                Call(handler, "GetFileModificationTime", Args(path), retval) != NO_ERROR)
+                return 1;
+            calls += 4;
+        }
+        PrintResult("stat (IsDirectory + mtime)", Now() - start, calls);
+
+        // The same listing with one native call per directory
+        start = Now();
+        calls = 0;
+        size_t entries = 0;
+        for (size_t i = 0; i < dirs.size(); i++) {
+            if (Call(handler, "ReadDirWithStats", Args(CefV8Value::CreateString(dirs[i])), retval) != NO_ERROR)
+                return 1;
+            std::vector<std::string> names;
+            GetResultNames(retval, names);
+            entries += names.size();
+            calls += 2;
+        }
+        PrintResult("ReadDirWithStats", Now() - start, calls);
+        if (entries != paths.size()) {
+            fprintf(stderr, "ReadDirWithStats returned %lu entries, expected %lu\n",
+                    (unsigned long)entries, (unsigned long)paths.size());
+            return 1;
+        }
+
+        start = Now();
+        calls = 0;
+        CefRefPtr<CefV8Value> encoding = CefV8Value::CreateString("utf8");
+        for (size_t i = 0; i < paths.size(); i++) {
+            if (Call(handler, "ReadFile", Args(CefV8Value::CreateString(paths[i]), encoding), retval) != NO_ERROR)
+                return 1;
+            calls += 2;
+        }
+        PrintResult("ReadFile", Now() - start, calls);
+
+        start = Now();
+        calls = 0;
+        for (size_t i = 0; i < paths.size(); i++) {
+            CefRefPtr<CefV8Value> contents = CefV8Value::CreateString("saved by brackets_headless\n");
+            if (Call(handler, "WriteFile", Args(CefV8Value::CreateString(paths[i]), contents, encoding), retval) != NO_ERROR)
+                return 1;
+            calls += 2;
+        }
+        PrintResult("WriteFile", Now() - start, calls);
+    }
+
+    return 0;
+}
+
+int RunMarshalBenchmark(const Options& options)
+{
+    static const size_t sizes[] = { 10, 100, 1000, 10000, 100000 };
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t size = sizes[s];
+
+        std::vector<std::string> list;
+        std::vector<DirEntry> entries;
+        for (size_t i = 0; i < size; i++) {
+            char name[32];
+            snprintf(name, sizeof(name), "file_%06lu.js", (unsigned long)i);
+            list.push_back(name);
+
+            DirEntry entry;
+            entry.name = name;
+            entry.info.isDirectory = false;
+            entry.info.size = 1024 + i;
+            entry.info.mtimeSec = 1330000000 + i;
+            entry.info.mtimeNsec = 0;
+            entries.push_back(entry);
+        }
+
+        // Repeat small lists so every row converts about a million names
+        long repeat = (long)(1000000 / size) * options.iterations;
+        char label[64];
+
+        double start = Now();
+        for (long r = 0; r < repeat; r++) {
+            std::vector<std::string> names;
+            GetResultNames(Brackets::FileSystem::StringListToV8Array(list), names);
+        }
+        snprintf(label, sizeof(label), "%lu names: V8 array", (unsigned long)size);
+        PrintResult(label, Now() - start, repeat);
+
+        start = Now();
+        for (long r = 0; r < repeat; r++) {
+            std::vector<std::string> names;
+            GetResultNames(Brackets::FileSystem::DirEntriesToV8Array(entries), names);
+        }
+        snprintf(label, sizeof(label), "%lu entries: V8 objects", (unsigned long)size);
+        PrintResult(label, Now() - start, repeat);
+    }
+
+    return 0;
+}
+
+namespace {
+
+// JS callback that counts completions and ends the message loop after the
+// last one
+class CompletionCounter : public CefV8Handler
+{
+public:
+    explicit CompletionCounter(long expected) : m_expected(expected), m_completed(0), m_errors(0) {}
+
+    virtual bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+    {
+        if (arguments.empty() || arguments[0]->GetIntValue() != NO_ERROR)
+            m_errors++;
+        if (++m_completed == m_expected)
+            CefQuitMessageLoop();
+        return true;
+    }
+
+    long GetErrors() const { return m_errors; }
+
+private:
+    long m_expected;
+    long m_completed;
+    long m_errors;
+
+    IMPLEMENT_REFCOUNTING(CompletionCounter);
+};
+
+// Starts |name| once per path and runs the message loop until every callback
+// has been called. |issueTime| is the time spent in the native calls
+// themselves, which is how long the UI thread was blocked. With |cancelEvery|
+// set, every n-th request is cancelled right after it starts, and those must
+// be the only ones that fail.
+bool RunAsync(CefRefPtr<CefV8Handler> handler, const char* name,
+              const std::vector<std::string>& paths, CefRefPtr<CefV8Value> extraArgument,
+              double& issueTime, size_t cancelEvery = 0)
+{
+    CefRefPtr<CompletionCounter> counter = new CompletionCounter((long)paths.size());
+    CefRefPtr<CefV8Value> callback = CefV8Value::CreateFunction("callback", counter.get());
+    CefRefPtr<CefV8Value> retval;
+    long cancelledCount = 0;
+
+    issueTime = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        CefV8ValueList args = Args(CefV8Value::CreateString(paths[i]));
+        if (extraArgument.get())
+            args.push_back(extraArgument);
+        args.push_back(callback);
+
+        double start = Now();
+        int error = Call(handler, name, args, retval);
+        issueTime += Now() - start;
+        if (error != NO_ERROR)
+            return false;
+
+        if (cancelEvery && i % cancelEvery == 0) {
+            CefRefPtr<CefV8Value> cancelled;
+            if (Call(handler, "CancelRequest", Args(retval), cancelled) != NO_ERROR)
+                return false;
+            cancelledCount += cancelled->GetBoolValue() ? 1 : 0;
+        }
+    }
+
+    if (!paths.empty())
+        CefRunMessageLoop();
+    return counter->GetErrors() == cancelledCount;
+}
+
+} // namespace
+
+int RunAsyncBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    Project project;
+    if (!MakeProject(options, project))
+        return 1;
+    const std::vector<std::string>& dirs = project.dirs;
+    const std::vector<std::string>& paths = project.files;
+
+    CefRefPtr<CefV8Value> retval;
+    CefRefPtr<CefV8Value> encoding = CefV8Value::CreateString("utf8");
+    for (int iteration = 0; iteration < options.iterations; iteration++) {
+        double start = Now();
+        for (size_t i = 0; i < dirs.size(); i++) {
+            if (Call(handler, "ReadDirWithStats", Args(CefV8Value::CreateString(dirs[i])), retval) != NO_ERROR)
+                return 1;
+        }
+        PrintResult("ReadDirWithStats", Now() - start, (long)dirs.size());
+
+        double issueTime = 0;
+        start = Now();
+        if (!RunAsync(handler, "ReadDirWithStatsAsync", dirs, NULL, issueTime))
+            return 1;
+        PrintResult("ReadDirWithStatsAsync", Now() - start, (long)dirs.size());
+        PrintResult("  time in native calls", issueTime, (long)dirs.size());
+
+        start = Now();
+        for (size_t i = 0; i < paths.size(); i++) {
+            if (Call(handler, "ReadFile", Args(CefV8Value::CreateString(paths[i]), encoding), retval) != NO_ERROR)
+                return 1;
+        }
+        PrintResult("ReadFile", Now() - start, (long)paths.size());
+
+        start = Now();
+        if (!RunAsync(handler, "ReadFileAsync", paths, encoding, issueTime))
+            return 1;
+        PrintResult("ReadFileAsync", Now() - start, (long)paths.size());
+        PrintResult("  time in native calls", issueTime, (long)paths.size());
+
+        start = Now();
+        if (!RunAsync(handler, "ReadFileAsync", paths, encoding, issueTime, 2)) {
+            fprintf(stderr, "Cancelled requests did not complete with ERR_CANCELLED\n");
+            return 1;
+        }
+        PrintResult("ReadFileAsync, half cancelled", Now() - start, (long)paths.size());
+    }
+
+    return 0;
+}
+
+namespace {
+
+// Every native function in brackets_extensions.js, in the order the old
+// if/else chains in BracketsExtensionHandler::Execute tested them
+const char* const kNativeFunctions[] = {
+    "OpenLiveBrowser", "CloseLiveBrowser", "ShowOpenDialog", "QuitApplication",
+    "ShowDeveloperTools", "GetElapsedMilliseconds", "GetLastError", "ReadDir",
+    "ReadDirWithStats", "IsDirectory", "ReadFile", "WriteFile",
+    "SetPosixPermissions", "GetFileModificationTime", "DeleteFileOrDirectory"
+};
+const int kNativeFunctionCount = sizeof(kNativeFunctions) / sizeof(kNativeFunctions[0]);
+
+int FindLinear(const CefString& name)
+{
+    for (int i = 0; i < kNativeFunctionCount; i++) {
+        if (name == kNativeFunctions[i])
+            return i + 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int RunDispatchBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    Brackets::NativeFunctionTable<int> table;
+    for (int i = 0; i < kNativeFunctionCount; i++)
+        table.Add(kNativeFunctions[i], i + 1);
+
+    const long lookups = 1000000L * options.iterations;
+    const char* const probes[] = { "GetLastError", "DeleteFileOrDirectory", "NotANativeFunction" };
+
+    for (size_t p = 0; p < sizeof(probes) / sizeof(probes[0]); p++) {
+        CefString name = probes[p];
+        int expected = FindLinear(name);
+        char label[64];
+        long found = 0;
+
+        double start = Now();
+        for (long i = 0; i < lookups; i++)
+            found += FindLinear(name) == expected;
+        snprintf(label, sizeof(label), "%s: if/else chain", probes[p]);
+        PrintResult(label, Now() - start, lookups);
+
+        start = Now();
+        for (long i = 0; i < lookups; i++)
+            found += table.Find(name) == expected;
+        snprintf(label, sizeof(label), "%s: table", probes[p]);
+        PrintResult(label, Now() - start, lookups);
+
+        if (found != lookups * 2) {
+            fprintf(stderr, "Lookup of %s returned the wrong function\n", probes[p]);
+            return 1;
+        }
+    }
+
+    CefRefPtr<CefV8Value> retval;
+    CefString exception;
+    CefString name = "GetLastError";
+    double start = Now();
+    for (long i = 0; i < lookups; i++)
+        handler->Execute(name, NULL, CefV8ValueList(), retval, exception);
+    PrintResult("GetLastError: Execute", Now() - start, lookups);
+
+    return 0;
+}
+
+namespace {
+
+// Peak resident set size of the process so far, in bytes
+long long PeakResidentSize()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (long long)usage.ru_maxrss * 1024;
+}
+
+// Writes |size| bytes of mostly ASCII text with some multibyte characters,
+// ending in |tail|
+bool MakeLargeFile(const std::string& path, long long size, const char* tail)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    std::string line;
+    for (int i = 0; i < 60; i++)
+        line += (char)('a' + i % 26);
+    line += "\xC3\xA9\xE2\x82\xAC\n";
+
+    size_t tailLength = strlen(tail);
+    long long written = 0;
+    bool ok = true;
+    while (ok && written + (long long)line.size() + (long long)tailLength <= size) {
+        ok = fwrite(line.data(), 1, line.size(), file) == line.size();
+        written += line.size();
+    }
+    ok = ok && fwrite(tail, 1, tailLength, file) == tailLength;
+    return fclose(file) == 0 && ok;
+}
+
+} // namespace
+
+int RunReadBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    const long long size = (long long)options.fileSizeMB * 1024 * 1024;
+    std::string path = options.root + "/large.txt";
+    std::string invalidPath = options.root + "/invalid.txt";
+
+    // A lone continuation byte at the very end makes the second file invalid
+    if (!MakeLargeFile(path, size, "\n") || !MakeLargeFile(invalidPath, size, "\x80")) {
+        fprintf(stderr, "Could not create %s\n", path.c_str());
+        return 1;
+    }
+
+    struct stat buffer;
+    if (stat(path.c_str(), &buffer) == -1) {
+        perror("stat");
+        return 1;
+    }
+    const size_t fileSize = (size_t)buffer.st_size;
+
+    for (int i = 0; i < options.iterations; i++) {
+        long long peakBefore = PeakResidentSize();
+        CefRefPtr<CefV8Value> retval;
+        double start = Now();
+        int error = Call(handler, "ReadFile",
+                         Args(CefV8Value::CreateString(path), CefV8Value::CreateString("utf8")), retval);
+        double seconds = Now() - start;
+
+        if (error != NO_ERROR || !retval.get() || retval->GetStringValue().length() != fileSize) {
+            fprintf(stderr, "ReadFile of %s failed with %d\n", path.c_str(), error);
+            return 1;
+        }
+        retval = NULL;
+
+        // The peak only grows on the first pass; later ones reuse the memory
+        printf("ReadFile %d MB: %.3f s, %.0f MB/s", options.fileSizeMB, seconds, options.fileSizeMB / seconds);
+        if (i == 0)
+            printf(", peak resident size grew %.2fx the file size", (double)(PeakResidentSize() - peakBefore) / fileSize);
+        printf("\n");
+    }
+
+    CefRefPtr<CefV8Value> retval;
+    double start = Now();
+    int error = Call(handler, "ReadFile",
+                     Args(CefV8Value::CreateString(invalidPath), CefV8Value::CreateString("utf8")), retval);
+    PrintResult("ReadFile, invalid UTF-8 in the last byte", Now() - start, 2);
+    if (error != ERR_UNSUPPORTED_ENCODING) {
+        fprintf(stderr, "ReadFile of invalid UTF-8 returned %d\n", error);
+        return 1;
+    }
+
+    return 0;
+}
+
+namespace {
+
+double ChunkNumber(CefRefPtr<CefV8Value> chunk, const char* key)
+{
+    return chunk->GetValue(key)->GetDoubleValue();
+}
+
+} // namespace
+
+int RunStreamBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    const long long size = (long long)options.fileSizeMB * 1024 * 1024;
+    std::string path = options.root + "/server.log";
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        perror("fopen");
+        return 1;
+    }
+    long lines = 0;
+    long long fileSize = 0;
+    while (fileSize < size) {
+        std::string line = LogLine(lines++);
+        fwrite(line.data(), 1, line.size(), file);
+        fileSize += line.size();
+    }
+    fclose(file);
+
+    CefRefPtr<CefV8Value> retval;
+    if (Call(handler, "OpenFileStream", Args(CefV8Value::CreateString(path)), retval) != NO_ERROR) {
+        fprintf(stderr, "OpenFileStream of %s failed\n", path.c_str());
+        return 1;
+    }
+    CefRefPtr<CefV8Value> stream = retval;
+    CefRefPtr<CefV8Value> maxBytes = CefV8Value::CreateInt(1024 * 1024);
+    CefRefPtr<CefV8Value> chunk;
+
+    // The first read of a line near the end scans the whole file and builds
+    // the line index. Later reads scan from the closest checkpoint.
+    const int reads = 1000 * options.iterations;
+    for (int i = 0; i <= reads; i++) {
+        long line = i == 0 ? lines - 10 : (long)((i * 7919L) % lines);
+        CefV8ValueList args = Args(stream, CefV8Value::CreateDouble((double)line), CefV8Value::CreateInt(5));
+        args.push_back(maxBytes);
+
+        double start = Now();
+        int error = CallAndWait(handler, "ReadFileStreamLinesAsync", args, chunk);
+        if (i <= 1)
+            PrintResult(i == 0 ? "ReadFileStreamLinesAsync, builds index" : "ReadFileStreamLinesAsync, indexed",
+                        Now() - start, 1);
+
+        std::string expected;
+        for (long j = line; j < line + 5 && j < lines; j++)
+            expected += LogLine(j);
+        if (error != NO_ERROR || chunk->GetValue("data")->GetStringValue().ToString() != expected ||
+            ChunkNumber(chunk, "firstLine") != line) {
+            fprintf(stderr, "ReadFileStreamLinesAsync of line %ld returned the wrong lines\n", line);
+            return 1;
+        }
+    }
+
+    double start = Now();
+    for (int i = 0; i < reads; i++) {
+        CefV8ValueList args = Args(stream, CefV8Value::CreateDouble((double)((i * 7919L) % lines)),
+                                   CefV8Value::CreateInt(5));
+        args.push_back(maxBytes);
+        CallAndWait(handler, "ReadFileStreamLinesAsync", args, chunk);
+    }
+    PrintResult("ReadFileStreamLinesAsync, random lines", Now() - start, reads);
+
+    // Sequential pages of whole lines must add up to the file
+    start = Now();
+    double offset = 0;
+    long chunks = 0;
+    long long total = 0;
+    bool eof = false;
+    while (!eof) {
+        CefV8ValueList args = Args(stream, CefV8Value::CreateDouble(offset), maxBytes);
+        args.push_back(CefV8Value::CreateBool(true));
+        if (CallAndWait(handler, "ReadFileStreamAsync", args, chunk) != NO_ERROR)
+            return 1;
+
+        std::string data = chunk->GetValue("data")->GetStringValue();
+        eof = chunk->GetValue("eof")->GetBoolValue();
+        if (ChunkNumber(chunk, "start") != offset || (!data.empty() && data[data.size() - 1] != '\n')) {
+            fprintf(stderr, "ReadFileStreamAsync chunk at %.0f does not end on a line\n", offset);
+            return 1;
+        }
+        offset = ChunkNumber(chunk, "end");
+        total += data.size();
+        chunks++;
+    }
+    double seconds = Now() - start;
+    PrintResult("ReadFileStreamAsync, 1 MB pages", seconds, chunks);
+    printf("  %.0f MB/s\n", total / seconds / (1024 * 1024));
+    if (total != fileSize) {
+        fprintf(stderr, "Pages add up to %lld bytes instead of %lld\n", total, fileSize);
+        return 1;
+    }
+
+    start = Now();
+    if (CallAndWait(handler, "ReadFileStreamTailAsync", Args(stream, CefV8Value::CreateInt(64 * 1024)), chunk) != NO_ERROR)
+        return 1;
+    PrintResult("ReadFileStreamTailAsync, 64 KB", Now() - start, 1);
+    std::string tail = chunk->GetValue("data")->GetStringValue();
+    if (tail.size() < 10 || tail[9] != ' ' || tail[tail.size() - 1] != '\n' ||
+        !chunk->GetValue("eof")->GetBoolValue()) {
+        fprintf(stderr, "ReadFileStreamTailAsync did not return whole lines up to the end\n");
+        return 1;
+    }
+
+    // Follow: append to the file and read again from the end of the last chunk
+    file = fopen(path.c_str(), "ab");
+    std::string appended = LogLine(lines) + LogLine(lines + 1);
+    fwrite(appended.data(), 1, appended.size(), file);
+    fclose(file);
+
+    CefV8ValueList args = Args(stream, CefV8Value::CreateDouble(offset), maxBytes);
+    args.push_back(CefV8Value::CreateBool(true));
+    if (CallAndWait(handler, "ReadFileStreamAsync", args, chunk) != NO_ERROR ||
+        chunk->GetValue("data")->GetStringValue().ToString() != appended) {
+        fprintf(stderr, "Reading past the old end did not return the appended lines\n");
+        return 1;
+    }
+
+    Call(handler, "CloseFileStream", Args(stream), retval);
+    if (!retval->GetBoolValue() || CallAndWait(handler, "ReadFileStreamAsync", args, chunk) != ERR_INVALID_PARAMS) {
+        fprintf(stderr, "The stream was still usable after CloseFileStream\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int RunWriteBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    std::string path = options.root + "/document.js";
+    std::string contents = MakeDocumentText(0, 64 * 1024);
+
+    CefRefPtr<CefV8Value> pathValue = CefV8Value::CreateString(path);
+    CefRefPtr<CefV8Value> contentsValue = CefV8Value::CreateString(contents);
+    CefRefPtr<CefV8Value> encoding = CefV8Value::CreateString("utf8");
+    CefRefPtr<CefV8Value> retval;
+
+    const int saves = 100 * options.iterations;
+    double start = Now();
+    for (int i = 0; i < saves; i++) {
+        if (!WriteInPlace(path, contents))
+            return 1;
+    }
+    PrintResult("64 KB save, in place (old WriteFile)", Now() - start, saves);
+
+    const char* const labels[] = { "DURABILITY_NONE", "DURABILITY_DATA", "DURABILITY_FULL" };
+    for (int mode = 0; mode < 3; mode++) {
+        CefV8ValueList args = Args(pathValue, contentsValue, encoding);
+        args.push_back(CefV8Value::CreateInt(mode));
+
+        start = Now();
+        for (int i = 0; i < saves; i++) {
+            if (Call(handler, "WriteFile", args, retval) != NO_ERROR) {
+                fprintf(stderr, "WriteFile with %s failed\n", labels[mode]);
+                return 1;
+            }
+        }
+        char label[64];
+        snprintf(label, sizeof(label), "64 KB save, %s", labels[mode]);
+        PrintResult(label, Now() - start, saves);
+    }
+
+    // The file is replaced, but keeps its permissions and the symlinks to it
+    std::string link = options.root + "/link.js";
+    std::string readBack;
+    chmod(path.c_str(), 0640);
+    symlink(path.c_str(), link.c_str());
+    CefRefPtr<CefV8Value> changed = CefV8Value::CreateString("changed\n");
+    struct stat buffer;
+    if (Call(handler, "WriteFile", Args(CefV8Value::CreateString(link), changed, encoding), retval) != NO_ERROR ||
+        lstat(link.c_str(), &buffer) == -1 || !S_ISLNK(buffer.st_mode) ||
+        stat(path.c_str(), &buffer) == -1 || (buffer.st_mode & 07777) != 0640 ||
+        !ReadWhole(path, readBack) || readBack != "changed\n") {
+        fprintf(stderr, "WriteFile through a symlink did not keep the link and the permissions\n");
+        return 1;
+    }
+
+    // Saving over a read-only file fails, as it did before
+    chmod(path.c_str(), 0444);
+    int error = Call(handler, "WriteFile", Args(pathValue, contentsValue, encoding), retval);
+    chmod(path.c_str(), 0644);
+    if (error != ERR_CANT_WRITE && geteuid() != 0) {
+        fprintf(stderr, "WriteFile over a read-only file returned %d\n", error);
+        return 1;
+    }
+
+    // No temporary files are left behind
+    if (Call(handler, "ReadDir", Args(CefV8Value::CreateString(options.root)), retval) != NO_ERROR)
+        return 1;
+    std::vector<std::string> names;
+    GetResultNames(retval, names);
+    if (names.size() != 2) {
+        fprintf(stderr, "WriteFile left %d extra files behind\n", (int)names.size() - 2);
+        return 1;
+    }
+
+    return 0;
+}
+
+int RunSaveAllBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    const int documents = 40;
+    CefRefPtr<CefV8Value> paths = CefV8Value::CreateArray();
+    CefRefPtr<CefV8Value> datas = CefV8Value::CreateArray();
+    for (int i = 0; i < documents; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "/document%02d.js", i);
+        std::string contents = MakeDocumentText(i, 16 * 1024);
+        paths->SetValue(i, CefV8Value::CreateString(options.root + name));
+        datas->SetValue(i, CefV8Value::CreateString(contents));
+    }
+
+    CefRefPtr<CefV8Value> encoding = CefV8Value::CreateString("utf8");
+    CefRefPtr<CefV8Value> retval;
+    CefRefPtr<CefV8Value> result;
+
+    const char* const labels[] = { "DURABILITY_NONE", "DURABILITY_DATA", "DURABILITY_FULL" };
+    for (int mode = 0; mode < 3; mode++) {
+        CefRefPtr<CefV8Value> durability = CefV8Value::CreateInt(mode);
+        char label[96];
+
+        double start = Now();
+        for (int n = 0; n < options.iterations; n++) {
+            for (int i = 0; i < documents; i++) {
+                CefV8ValueList args = Args(paths->GetValue(i), datas->GetValue(i), encoding);
+                args.push_back(durability);
+                if (Call(handler, "WriteFile", args, retval) != NO_ERROR) {
+                    fprintf(stderr, "WriteFile with %s failed\n", labels[mode]);
+                    return 1;
+                }
+            }
+        }
+        snprintf(label, sizeof(label), "one by one, %s", labels[mode]);
+        PrintResult(label, Now() - start, options.iterations);
+
+        start = Now();
+        for (int n = 0; n < options.iterations; n++) {
+            CefV8ValueList args = Args(paths, datas, encoding);
+            args.push_back(durability);
+            if (CallAndWait(handler, "WriteFilesAsync", args, result) != NO_ERROR ||
+                !result.get() || result->GetArrayLength() != documents) {
+                fprintf(stderr, "WriteFilesAsync with %s failed\n", labels[mode]);
+                return 1;
+            }
+            for (int i = 0; i < documents; i++) {
+                if (result->GetValue(i)->GetIntValue() != NO_ERROR) {
+                    fprintf(stderr, "WriteFilesAsync failed for file %d with %s\n", i, labels[mode]);
+                    return 1;
+                }
+            }
+        }
+        snprintf(label, sizeof(label), "WriteFilesAsync, %s", labels[mode]);
+        PrintResult(label, Now() - start, options.iterations);
+    }
+
+    // A file that can't be saved fails alone and the rest of the batch is
+    // still written
+    CefRefPtr<CefV8Value> mixedPaths = CefV8Value::CreateArray();
+    CefRefPtr<CefV8Value> mixedDatas = CefV8Value::CreateArray();
+    mixedPaths->SetValue(0, paths->GetValue(0));
+    mixedPaths->SetValue(1, CefV8Value::CreateString(options.root + "/missing/document.js"));
+    mixedDatas->SetValue(0, CefV8Value::CreateString("saved\n"));
+    mixedDatas->SetValue(1, CefV8Value::CreateString("lost\n"));
+    std::string readBack;
+    if (CallAndWait(handler, "WriteFilesAsync", Args(mixedPaths, mixedDatas, encoding), result) != NO_ERROR ||
+        result->GetValue(0)->GetIntValue() != NO_ERROR || result->GetValue(1)->GetIntValue() != ERR_NOT_FOUND ||
+        !ReadWhole(paths->GetValue(0)->GetStringValue(), readBack) || readBack != "saved\n") {
+        fprintf(stderr, "WriteFilesAsync did not report errors per file\n");
+        return 1;
+    }
+
+    // No temporary files are left behind
+    if (Call(handler, "ReadDir", Args(CefV8Value::CreateString(options.root)), retval) != NO_ERROR)
+        return 1;
+    std::vector<std::string> names;
+    GetResultNames(retval, names);
+    if (names.size() != (size_t)documents) {
+        fprintf(stderr, "WriteFilesAsync left %d extra files behind\n", (int)names.size() - documents);
+        return 1;
+    }
+
+    return 0;
+}
+
+namespace {
+
+// Runs one watcher over the tree under |root| and checks what it reports
+int RunWatcher(CefRefPtr<CefV8Handler> handler, const std::string& root, bool polling,
+               const std::vector<std::string>& dirs)
+{
+    const char* mode = polling ? "polling" : "native";
+    const int latencyMs = 50;
+    const int timeoutMs = polling ? 30000 : 5000;
+    char label[96];
+
+    CefRefPtr<ChangeCollector> collector = new ChangeCollector();
+    CefV8ValueList args = Args(CefV8Value::CreateString(root),
+                               CefV8Value::CreateFunction("onChange", collector.get()),
+                               CefV8Value::CreateInt(latencyMs));
+    args.push_back(CefV8Value::CreateBool(polling));
+
+    CefRefPtr<CefV8Value> retval;
+    double start = Now();
+    if (Call(handler, "WatchPath", args, retval) != NO_ERROR) {
+        fprintf(stderr, "WatchPath failed\n");
+        return 1;
+    }
+    int watcher = retval->GetIntValue();
+    snprintf(label, sizeof(label), "%s: WatchPath call", mode);
+    PrintResult(label, Now() - start, 1);
+
+    // The tree is walked in the background. Touch a file until the watcher
+    // sees it, to time how long it takes to start.
+    std::string marker = root + "/marker.txt";
+    int kind = 0;
+    for (int i = 0; !kind && Now() - start < 120; i++) {
+        WriteInPlace(marker, LogLine(i));
+        kind = WaitForChange(collector, marker, polling ? 500 : 50);
+    }
+    if (!kind) {
+        fprintf(stderr, "%s watcher never saw a change\n", mode);
+        return 1;
+    }
+    snprintf(label, sizeof(label), "%s: first change seen", mode);
+    PrintResult(label, Now() - start, 1);
+    if (collector->m_polling != polling) {
+        fprintf(stderr, "%s watcher reports polling = %d\n", mode, (int)collector->m_polling);
+        return 1;
+    }
+
+    // A burst of writes to one file is a single change
+    collector->Clear();
+    std::string storm = root + "/storm.txt";
+    start = Now();
+    for (int i = 0; i < 200; i++)
+        WriteInPlace(storm, LogLine(i));
+    kind = WaitForChange(collector, storm, timeoutMs);
+    snprintf(label, sizeof(label), "%s: 200 writes to a new file", mode);
+    PrintResult(label, Now() - start, 200);
+    if (kind != Brackets::FileSystem::CHANGE_CREATED || collector->Count(storm) != 1) {
+        fprintf(stderr, "%s watcher reported the new file %d times, last as %d\n", mode,
+                collector->Count(storm), kind);
+        return 1;
+    }
+
+    // A file written in the project
+    collector->Clear();
+    std::string file = dirs[dirs.size() / 2] + "/file-modified.js";
+    WriteInPlace(file, "one\n");
+    WaitForChange(collector, file, timeoutMs);
+    collector->Clear();
+    start = Now();
+    WriteInPlace(file, "two\n");
+    kind = WaitForChange(collector, file, timeoutMs);
+    snprintf(label, sizeof(label), "%s: one write, until reported", mode);
+    PrintResult(label, Now() - start, 1);
+    if (kind != Brackets::FileSystem::CHANGE_MODIFIED) {
+        fprintf(stderr, "%s watcher reported a write as %d\n", mode, kind);
+        return 1;
+    }
+
+    // A new directory and what is written in it right away
+    collector->Clear();
+    std::string newDir = root + "/new";
+    start = Now();
+    mkdir(newDir.c_str(), 0777);
+    for (int i = 0; i < 10; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "/%d.js", i);
+        WriteInPlace(newDir + name, "new\n");
+    }
+    kind = WaitForChange(collector, newDir + "/9.js", timeoutMs);
+    snprintf(label, sizeof(label), "%s: new directory of 10 files", mode);
+    PrintResult(label, Now() - start, 11);
+    if (kind != Brackets::FileSystem::CHANGE_CREATED || collector->Find(newDir) != Brackets::FileSystem::CHANGE_CREATED) {
+        fprintf(stderr, "%s watcher missed the new directory\n", mode);
+        return 1;
+    }
+
+    // A file created and deleted within one window is not worth reporting
+    collector->Clear();
+    std::string transient = root + "/transient.txt";
+    WriteInPlace(transient, "gone\n");
+    unlink(transient.c_str());
+    RemoveTree(newDir);
+    kind = WaitForChange(collector, newDir, timeoutMs);
+    if (kind != Brackets::FileSystem::CHANGE_DELETED) {
+        fprintf(stderr, "%s watcher reported a deleted directory as %d\n", mode, kind);
+        return 1;
+    }
+    printf("%s: %d changes in %d batches for a file created and deleted, and a directory removed\n",
+           mode, (int)collector->m_changes.size(), collector->m_batches);
+
+    // Nothing comes after UnwatchPath
+    if (Call(handler, "UnwatchPath", Args(CefV8Value::CreateInt(watcher)), retval) != NO_ERROR ||
+        !retval->GetBoolValue()) {
+        fprintf(stderr, "UnwatchPath failed\n");
+        return 1;
+    }
+    collector->Clear();
+    WriteInPlace(marker, "after\n");
+    if (WaitForChange(collector, marker, polling ? 2000 : 300) != 0) {
+        fprintf(stderr, "%s watcher reported a change after UnwatchPath\n", mode);
+        return 1;
+    }
+
+    unlink(marker.c_str());
+    unlink(storm.c_str());
+    unlink(file.c_str());
+    return 0;
+}
+
+// Looks up every path in |paths| with GetFileInfo
+bool StatAll(CefRefPtr<CefV8Handler> handler, const std::vector<std::string>& paths, bool bypassCache)
+{
+    CefRefPtr<CefV8Value> retval;
+    CefRefPtr<CefV8Value> bypass = CefV8Value::CreateBool(bypassCache);
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (Call(handler, "GetFileInfo", Args(CefV8Value::CreateString(paths[i]), bypass), retval) != NO_ERROR)
+            return false;
+    }
+    return true;
+}
+
+// Lists every directory in |dirs| with ReadDir or ReadDirWithStats
+bool ReadAll(CefRefPtr<CefV8Handler> handler, const char* function, const std::vector<std::string>& dirs,
+             bool bypassCache)
+{
+    CefRefPtr<CefV8Value> retval;
+    CefRefPtr<CefV8Value> bypass = CefV8Value::CreateBool(bypassCache);
+    for (size_t i = 0; i < dirs.size(); i++) {
+        if (Call(handler, function, Args(CefV8Value::CreateString(dirs[i]), bypass), retval) != NO_ERROR)
+            return false;
+    }
+    return true;
+}
+
+// The size ReadDirWithStats gives for |name| in |directory|, or -1
+double GetListedSize(CefRefPtr<CefV8Handler> handler, const std::string& directory, const std::string& name)
+{
+    CefRefPtr<CefV8Value> retval;
+    if (Call(handler, "ReadDirWithStats", Args(CefV8Value::CreateString(directory)), retval) != NO_ERROR)
+        return -1;
+    for (int i = 0; i < retval->GetArrayLength(); i++) {
+        CefRefPtr<CefV8Value> entry = retval->GetValue(i);
+        if (entry->GetValue("name")->GetStringValue() == name)
+            return entry->GetValue("size")->GetDoubleValue();
+    }
+    return -1;
+}
+
+CefRefPtr<CefV8Value> GetCacheStats(CefRefPtr<CefV8Handler> handler)
+{
+    CefRefPtr<CefV8Value> stats;
+    Call(handler, "GetStatCacheStats", CefV8ValueList(), stats);
+    return stats;
+}
+
+// Polls GetFileInfo on |path| until it fails with |error|, or succeeds with
+// a size of |size| when |error| is NO_ERROR. Returns the seconds that took,
+// or -1 after |timeoutMs|.
+double WaitForInfo(CefRefPtr<CefV8Handler> handler, const std::string& path, int error, double size, int timeoutMs)
+{
+    double start = Now();
+    CefRefPtr<CefV8Value> retval;
+    while (Now() - start < timeoutMs / 1000.0) {
+        int result = Call(handler, "GetFileInfo", Args(CefV8Value::CreateString(path)), retval);
+        if (result == error && (error != NO_ERROR || retval->GetValue("size")->GetDoubleValue() == size))
+            return Now() - start;
+        usleep(1000);
+    }
+    return -1;
+}
+
+} // namespace
+
+int RunStatCacheBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    Project project;
+    if (!MakeProject(options, project))
+        return 1;
+    const std::vector<std::string>& dirs = project.dirs;
+    const std::vector<std::string>& paths = project.files;
+
+    CefRefPtr<CefV8Value> retval;
+    long statCalls = (long)paths.size() * 2 * options.iterations;
+    long readCalls = (long)dirs.size() * 2 * options.iterations;
+
+    // Without a root every lookup goes to the file system
+    double start = Now();
+    for (int n = 0; n < options.iterations; n++) {
+        if (!StatAll(handler, paths, false))
+            return 1;
+    }
+    PrintResult("GetFileInfo, no cache", Now() - start, statCalls);
+
+    start = Now();
+    for (int n = 0; n < options.iterations; n++) {
+        if (!ReadAll(handler, "ReadDir", dirs, false))
+            return 1;
+    }
+    PrintResult("ReadDir, no cache", Now() - start, readCalls);
+
+    start = Now();
+    for (int n = 0; n < options.iterations; n++) {
+        if (!ReadAll(handler, "ReadDirWithStats", dirs, false))
+            return 1;
+    }
+    PrintResult("ReadDirWithStats, no cache", Now() - start, readCalls);
+
+    start = Now();
+    if (Call(handler, "SetStatCacheRoot", Args(CefV8Value::CreateString(options.root)), retval) != NO_ERROR)
+        return 1;
+    while (!GetCacheStats(handler)->GetValue("active")->GetBoolValue()) {
+        if (Now() - start > 30) {
+            fprintf(stderr, "The stat cache did not start\n");
+            return 1;
+        }
+        usleep(1000);
+    }
+    PrintResult("SetStatCacheRoot until active", Now() - start, 1);
+
+    start = Now();
+    if (!StatAll(handler, paths, false) || !ReadAll(handler, "ReadDir", dirs, false) ||
+        !ReadAll(handler, "ReadDirWithStats", dirs, false))
+        return 1;
+    PrintResult("first pass, filling the cache", Now() - start, (long)(paths.size() + dirs.size() * 2) * 2);
+
+    start = Now();
+    for (int n = 0; n < options.iterations; n++) {
+        if (!StatAll(handler, paths, false))
+            return 1;
+    }
+    PrintResult("GetFileInfo, cached", Now() - start, statCalls);
+
+    start = Now();
+    for (int n = 0; n < options.iterations; n++) {
+        for (size_t i = 0; i < paths.size(); i++) {
+            CefRefPtr<CefV8Value> path = CefV8Value::CreateString(paths[i]);
+            if (Call(handler, "IsDirectory", Args(path), retval) != NO_ERROR ||
+                Call(handler, "GetFileModificationTime", Args(path), retval) != NO_ERROR)
+                return 1;
+        }
+    }
+    PrintResult("IsDirectory + mtime, cached", Now() - start, statCalls * 2);
+
+    start = Now();
+    for (int n = 0; n < options.iterations; n++) {
+        if (!ReadAll(handler, "ReadDir", dirs, false))
+            return 1;
+    }
+    PrintResult("ReadDir, cached", Now() - start, readCalls);
+
+    start = Now();
+    for (int n = 0; n < options.iterations; n++) {
+        if (!ReadAll(handler, "ReadDirWithStats", dirs, false))
+            return 1;
+    }
+    PrintResult("ReadDirWithStats, cached", Now() - start, readCalls);
+
+    start = Now();
+    for (int n = 0; n < options.iterations; n++) {
+        if (!ReadAll(handler, "ReadDirWithStats", dirs, true))
+            return 1;
+    }
+    PrintResult("ReadDirWithStats, bypassCache", Now() - start, readCalls);
+
+    start = Now();
+    for (int n = 0; n < options.iterations; n++) {
+        if (!StatAll(handler, paths, true))
+            return 1;
+    }
+    PrintResult("GetFileInfo, bypassCache", Now() - start, statCalls);
+
+    // Changes made by other programs reach the cache through the watcher
+    const std::string& file = paths[0];
+    std::string contents = "modified outside brackets\n";
+    if (!WriteInPlace(file, contents))
+        return 1;
+    double seen = WaitForInfo(handler, file, NO_ERROR, (double)contents.size(), 5000);
+    if (seen < 0) {
+        fprintf(stderr, "The cache kept the old size of %s\n", file.c_str());
+        return 1;
+    }
+    printf("%-40s %10.2f ms\n", "outside write seen after", seen * 1000);
+
+    // The listing with stats of its directory has the new size too
+    if (GetListedSize(handler, dirs[0], file.substr(dirs[0].size() + 1)) != (double)contents.size()) {
+        fprintf(stderr, "ReadDirWithStats kept the old size of %s\n", file.c_str());
+        return 1;
+    }
+
+    // A missing file is cached as missing until it is created
+    std::string created = dirs[0] + "/created.js";
+    if (Call(handler, "GetFileInfo", Args(CefV8Value::CreateString(created)), retval) != ERR_NOT_FOUND)
+        return 1;
+    if (!WriteInPlace(created, contents))
+        return 1;
+    seen = WaitForInfo(handler, created, NO_ERROR, (double)contents.size(), 5000);
+    std::vector<std::string> names;
+    if (seen < 0 || Call(handler, "ReadDir", Args(CefV8Value::CreateString(dirs[0])), retval) != NO_ERROR ||
+        !GetResultNames(retval, names) || std::find(names.begin(), names.end(), "created.js") == names.end()) {
+        fprintf(stderr, "The cache missed the creation of %s\n", created.c_str());
+        return 1;
+    }
+    printf("%-40s %10.2f ms\n", "outside create seen after", seen * 1000);
+
+    if (unlink(created.c_str()) != 0)
+        return 1;
+    seen = WaitForInfo(handler, created, ERR_NOT_FOUND, 0, 5000);
+    if (seen < 0) {
+        fprintf(stderr, "The cache missed the deletion of %s\n", created.c_str());
+        return 1;
+    }
+    printf("%-40s %10.2f ms\n", "outside delete seen after", seen * 1000);
+
+    // Saving through WriteFile is seen right away, without waiting for the
+    // watcher
+    std::string saved = "saved through WriteFile, a little longer\n";
+    if (Call(handler, "WriteFile", Args(CefV8Value::CreateString(file), CefV8Value::CreateString(saved),
+                                        CefV8Value::CreateString("utf8")), retval) != NO_ERROR ||
+        Call(handler, "GetFileInfo", Args(CefV8Value::CreateString(file)), retval) != NO_ERROR ||
+        retval->GetValue("size")->GetDoubleValue() != (double)saved.size()) {
+        fprintf(stderr, "GetFileInfo returned a stale size right after WriteFile\n");
+        return 1;
+    }
+
+    CefRefPtr<CefV8Value> stats = GetCacheStats(handler);
+    printf("hits %.0f, misses %.0f, bypassed %.0f, invalidations %.0f, entries %.0f\n",
+           stats->GetValue("hits")->GetDoubleValue(), stats->GetValue("misses")->GetDoubleValue(),
+           stats->GetValue("bypassed")->GetDoubleValue(), stats->GetValue("invalidations")->GetDoubleValue(),
+           stats->GetValue("entries")->GetDoubleValue());
+
+    Call(handler, "SetStatCacheRoot", Args(CefV8Value::CreateString("")), retval);
+    return 0;
+}
+
+int RunWatchBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    Project project;
+    if (!MakeProject(options, project))
+        return 1;
+
+    if (RunWatcher(handler, options.root, false, project.dirs) != 0)
+        return 1;
+    return RunWatcher(handler, options.root, true, project.dirs);
+}
+
+namespace {
+
+// Progress function passed to WalkTreeAsync. Counts what it is given and
+// keeps the paths when asked to.
+class WalkCollector : public CefV8Handler
+{
+public:
+    explicit WalkCollector(bool keepPaths) : m_keepPaths(keepPaths), m_batches(0), m_entries(0) {}
+
+    virtual bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+    {
+        std::vector<std::string> paths;
+        GetResultNames(arguments[1], paths);
+        m_batches++;
+        m_entries += (long)paths.size();
+        if (m_keepPaths)
+            m_paths.insert(m_paths.end(), paths.begin(), paths.end());
+        return true;
+    }
+
+    bool Has(const std::string& path) const
+    {
+        return std::find(m_paths.begin(), m_paths.end(), path) != m_paths.end();
+    }
+
+    bool m_keepPaths;
+    int m_batches;
+    long m_entries;
+    std::vector<std::string> m_paths;
+
+    IMPLEMENT_REFCOUNTING(WalkCollector);
+};
+
+// What the JS side did before WalkTree: readdir, then a stat per entry,
+// one directory at a time
+long WalkSerially(CefRefPtr<CefV8Handler> handler, const std::string& dir)
+{
+    CefRefPtr<CefV8Value> retval;
+    if (Call(handler, "ReadDir", Args(CefV8Value::CreateString(dir)), retval) != NO_ERROR)
+        return 0;
+    std::vector<std::string> names;
+    GetResultNames(retval, names);
+
+    long files = 0;
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == ".git" || names[i] == "node_modules" || names[i] == "build" || names[i] == "loop")
+            continue;
+        CefRefPtr<CefV8Value> path = CefV8Value::CreateString(dir + "/" + names[i]);
+        if (Call(handler, "IsDirectory", Args(path), retval) != NO_ERROR)
+            continue;
+        bool isDirectory = retval->GetBoolValue();
+        Call(handler, "GetFileModificationTime", Args(path), retval);
+        if (isDirectory)
+            files += WalkSerially(handler, dir + "/" + names[i]);
+        else
+            files++;
+    }
+    return files;
+}
+
+} // namespace
+
+int RunWalkBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    double start = Now();
+    long expected = MakeMonorepo(options.root, options.files);
+    if (expected < 0) {
+        fprintf(stderr, "Could not create the project\n");
+        return 1;
+    }
+    PrintResult("create project", Now() - start, expected);
+
+    start = Now();
+    long files = WalkSerially(handler, options.root);
+    PrintResult("readdir + stat per entry, serially", Now() - start, files);
+
+    CefRefPtr<CefV8Value> ignore = CefV8Value::CreateArray();
+    ignore->SetValue(0, CefV8Value::CreateString(".git"));
+    ignore->SetValue(1, CefV8Value::CreateString("node_modules"));
+
+    CefRefPtr<CefV8Value> roots = CefV8Value::CreateArray();
+    roots->SetValue(0, CefV8Value::CreateString(options.root));
+
+    const char* const labels[] = { "WalkTreeAsync", "WalkTreeAsync with stats" };
+    CefRefPtr<CefV8Value> summary;
+    for (int withStats = 0; withStats < 2; withStats++) {
+        CefRefPtr<CefV8Value> walkOptions = CefV8Value::CreateObject(NULL);
+        walkOptions->SetValue("ignore", ignore, V8_PROPERTY_ATTRIBUTE_NONE);
+        walkOptions->SetValue("stats", CefV8Value::CreateBool(withStats != 0), V8_PROPERTY_ATTRIBUTE_NONE);
+
+        for (int n = 0; n < options.iterations; n++) {
+            CefRefPtr<WalkCollector> collector = new WalkCollector(withStats == 0 && n == 0);
+            start = Now();
+            if (CallAndWait(handler, "WalkTreeAsync",
+                            Args(roots, walkOptions, CefV8Value::CreateFunction("progress", collector.get())),
+                            summary) != NO_ERROR) {
+                fprintf(stderr, "%s failed\n", labels[withStats]);
+                return 1;
+            }
+            double elapsed = Now() - start;
+
+            long found = (long)summary->GetValue("files")->GetDoubleValue();
+            long dirs = (long)summary->GetValue("directories")->GetDoubleValue();
+            PrintResult(labels[withStats], elapsed, found + dirs);
+            if (found != expected || collector->m_entries != found + dirs) {
+                fprintf(stderr, "%s found %ld files (%ld entries), expected %ld\n",
+                        labels[withStats], found, collector->m_entries, expected);
+                return 1;
+            }
+            if (n == 0)
+                printf("  %d batches, %.0f excluded, %.0f symlink cycles skipped\n", collector->m_batches,
+                       summary->GetValue("excluded")->GetDoubleValue(), summary->GetValue("cycles")->GetDoubleValue());
+
+            if (collector->m_keepPaths &&
+                (!collector->Has("packages/p000/keep.log") || collector->Has("packages/p000/other.log") ||
+                 collector->Has("debug.log") || !collector->Has("packages/p000/src/") ||
+                 !collector->Has("packages/p000/src/loop/"))) {
+                fprintf(stderr, "WalkTreeAsync did not apply the .gitignore rules\n");
+                return 1;
+            }
+        }
+    }
+
+    // Several roots in one walk, one of them missing
+    CefRefPtr<CefV8Value> twoRoots = CefV8Value::CreateArray();
+    twoRoots->SetValue(0, CefV8Value::CreateString(options.root + "/packages/p000"));
+    twoRoots->SetValue(1, CefV8Value::CreateString(options.root + "/missing"));
+    CefRefPtr<WalkCollector> collector = new WalkCollector(false);
+    if (CallAndWait(handler, "WalkTreeAsync",
+                    Args(twoRoots, CefV8Value::CreateObject(NULL), CefV8Value::CreateFunction("progress", collector.get())),
+                    summary) != NO_ERROR ||
+        summary->GetValue("rootErrors")->GetValue(0)->GetIntValue() != NO_ERROR ||
+        summary->GetValue("rootErrors")->GetValue(1)->GetIntValue() != ERR_NOT_FOUND) {
+        fprintf(stderr, "WalkTreeAsync did not report the missing root\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+namespace {
+
+// Progress function passed to SearchFilesAsync. Counts the matches and keeps
+// the first one of each file.
+class SearchCollector : public CefV8Handler
+{
+public:
+    SearchCollector() : m_batches(0), m_matches(0), m_searched(0), m_total(0) {}
+
+    virtual bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+    {
+        CefRefPtr<CefV8Value> results = arguments[0];
+        for (int i = 0; i < results->GetArrayLength(); i++) {
+            CefRefPtr<CefV8Value> matches = results->GetValue(i)->GetValue("matches");
+            m_matches += matches->GetArrayLength();
+            m_first[results->GetValue(i)->GetValue("path")->GetStringValue()] = matches->GetValue(0);
+        }
+        m_batches++;
+        m_searched = (long)arguments[1]->GetDoubleValue();
+        m_total = (long)arguments[2]->GetDoubleValue();
+        return true;
+    }
+
+    int m_batches;
+    long m_matches;
+    long m_searched;
+    long m_total;
+    std::map<std::string, CefRefPtr<CefV8Value> > m_first;
+
+    IMPLEMENT_REFCOUNTING(SearchCollector);
+};
+
+// Line of generated code for the search corpus
+std::string CodeLine(int file, int line)
+{
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "    var value%d = compute(%d, \"caf\xC3\xA9 text\"); // step %d\n",
+             line, file, line % 7);
+    return buffer;
+}
+
+// The line every 50th file of the corpus has at kNeedleLine, with the
+// match at UTF-16 column 15: U+1F600 takes two code units
+const char kNeedleText[] = "    /* caf\xC3\xA9 \xF0\x9F\x98\x80 FIXME: needle */\n";
+const int kNeedleLine = 30;
+const int kNeedleCh = 15;
+
+// Writes the files the search benchmark looks through: |options.files|
+// files of 60 lines, |options.filesPerDir| per directory, every 50th with
+// kNeedleText in it. Next to them go a binary file and a file in
+// node_modules that mention FIXME too, and one large log, which is mapped
+// instead of read, with FIXME on its last line. Returns the paths of the
+// files a search should visit, or false.
+bool MakeSearchCorpus(const std::string& root, const Options& options, std::vector<std::string>& paths)
+{
+    char name[64];
+    std::string dir;
+    for (int i = 0; i < options.files; i++) {
+        if (i % options.filesPerDir == 0) {
+            snprintf(name, sizeof(name), "/dir%05d", i / options.filesPerDir);
+            dir = root + name;
+            if (mkdir(dir.c_str(), 0777) == -1)
+                return false;
+        }
+
+        std::string contents;
+        for (int line = 0; line < 60; line++)
+            contents += (i % 50 == 0 && line == kNeedleLine) ? kNeedleText : CodeLine(i, line);
+        snprintf(name, sizeof(name), "/file%06d.js", i);
+        paths.push_back(dir + name);
+        if (!WriteSmallFile(paths.back(), contents.c_str()))
+            return false;
+    }
+
+    std::string blob("\x89PNG\0\0FIXME", 11);
+    paths.push_back(root + "/blob.bin");
+    if (Brackets::FileSystem::WriteFile(paths.back(), blob, "utf8", Brackets::FileSystem::DURABILITY_NONE) != NO_ERROR)
+        return false;
+
+    std::string log;
+    for (int line = 0; line < 50000; line++)
+        log += LogLine(line);
+    log += "FIXME\n";
+    paths.push_back(root + "/big.log");
+    if (!WriteSmallFile(paths.back(), log.c_str()))
+        return false;
+
+    mkdir((root + "/node_modules").c_str(), 0777);
+    return WriteSmallFile(root + "/node_modules/dep.js", "// FIXME\n");
+}
+
+// What the JS side did before SearchFilesAsync: ReadFile every file and
+// search the string, one file at a time. Returns the number of matches.
+long SearchByReading(CefRefPtr<CefV8Handler> handler, const std::vector<std::string>& paths,
+                     const std::string& query)
+{
+    long matches = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        CefRefPtr<CefV8Value> retval;
+        if (Call(handler, "ReadFile", Args(CefV8Value::CreateString(paths[i]), CefV8Value::CreateString("utf8")),
+                 retval) != NO_ERROR)
+            continue;
+
+        // Like a case-insensitive regular expression over the contents
+        std::string text = retval->GetStringValue();
+        std::transform(text.begin(), text.end(), text.begin(), tolower);
+        for (size_t pos = text.find(query); pos != std::string::npos; pos = text.find(query, pos + query.length()))
+            matches++;
+    }
+    return matches;
+}
+
+} // namespace
+
+int RunSearchBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    std::vector<std::string> paths;
+    double start = Now();
+    if (!MakeSearchCorpus(options.root, options, paths)) {
+        fprintf(stderr, "Could not create the files to search\n");
+        return 1;
+    }
+    PrintResult("create files", Now() - start, (long)paths.size());
+
+    // One match in every 50th file and one in the log
+    long expected = (options.files + 49) / 50 + 1;
+
+    start = Now();
+    long found = SearchByReading(handler, paths, "fixme");
+    PrintResult("ReadFile + search per file, serially", Now() - start, found);
+
+    CefRefPtr<CefV8Value> roots = CefV8Value::CreateArray();
+    roots->SetValue(0, CefV8Value::CreateString(options.root));
+    CefRefPtr<CefV8Value> ignore = CefV8Value::CreateArray();
+    ignore->SetValue(0, CefV8Value::CreateString("node_modules"));
+
+    const char* const labels[] = { "SearchFilesAsync", "SearchFilesAsync, case-sensitive" };
+    CefRefPtr<CefV8Value> summary;
+    for (int caseSensitive = 0; caseSensitive < 2; caseSensitive++) {
+        CefRefPtr<CefV8Value> searchOptions = CefV8Value::CreateObject(NULL);
+        searchOptions->SetValue("ignore", ignore, V8_PROPERTY_ATTRIBUTE_NONE);
+        searchOptions->SetValue("caseSensitive", CefV8Value::CreateBool(caseSensitive != 0),
+                                V8_PROPERTY_ATTRIBUTE_NONE);
+
+        for (int n = 0; n < options.iterations; n++) {
+            CefRefPtr<SearchCollector> collector = new SearchCollector();
+            start = Now();
+            if (CallAndWait(handler, "SearchFilesAsync",
+                            Args(roots, CefV8Value::CreateString("fixme"), searchOptions,
+                                 CefV8Value::CreateFunction("progress", collector.get())),
+                            summary) != NO_ERROR) {
+                fprintf(stderr, "%s failed\n", labels[caseSensitive]);
+                return 1;
+            }
+            PrintResult(labels[caseSensitive], Now() - start, collector->m_matches);
+
+            long wanted = caseSensitive ? 0 : expected;
+            if (collector->m_matches != wanted || (long)summary->GetValue("matches")->GetDoubleValue() != wanted ||
+                (long)summary->GetValue("files")->GetDoubleValue() != (long)paths.size() ||
+                summary->GetValue("binary")->GetDoubleValue() != 1 || collector->m_searched != collector->m_total) {
+                fprintf(stderr, "%s found %ld matches in %.0f files, expected %ld in %ld\n", labels[caseSensitive],
+                        collector->m_matches, summary->GetValue("files")->GetDoubleValue(), wanted,
+                        (long)paths.size());
+                return 1;
+            }
+            if (n == 0)
+                printf("  %d batches\n", collector->m_batches);
+
+            if (!caseSensitive) {
+                CefRefPtr<CefV8Value> match = collector->m_first[paths[0]];
+                CefRefPtr<CefV8Value> last = collector->m_first[options.root + "/big.log"];
+                if (!match.get() || match->GetValue("line")->GetIntValue() != kNeedleLine ||
+                    match->GetValue("ch")->GetIntValue() != kNeedleCh ||
+                    match->GetValue("preview")->GetStringValue() != std::string(kNeedleText, strlen(kNeedleText) - 1) ||
+                    !last.get() || last->GetValue("line")->GetIntValue() != 50000) {
+                    fprintf(stderr, "SearchFilesAsync reported the wrong positions\n");
+                    return 1;
+                }
+            }
+        }
+    }
+
+    // Stopping at maxMatches, and cancelling
+    CefRefPtr<CefV8Value> searchOptions = CefV8Value::CreateObject(NULL);
+    searchOptions->SetValue("maxMatches", CefV8Value::CreateInt(10), V8_PROPERTY_ATTRIBUTE_NONE);
+    CefRefPtr<SearchCollector> collector = new SearchCollector();
+    if (CallAndWait(handler, "SearchFilesAsync",
+                    Args(roots, CefV8Value::CreateString("compute"), searchOptions,
+                         CefV8Value::CreateFunction("progress", collector.get())),
+                    summary) != NO_ERROR ||
+        collector->m_matches != 10 || !summary->GetValue("limitReached")->GetBoolValue()) {
+        fprintf(stderr, "SearchFilesAsync did not stop at maxMatches\n");
+        return 1;
+    }
+
+    CefRefPtr<ResultCallback> callback = new ResultCallback();
+    CefV8ValueList arguments = Args(roots, CefV8Value::CreateString("fixme"), CefV8Value::CreateObject(NULL));
+    arguments.push_back(CefV8Value::CreateFunction("progress", new SearchCollector()));
+    arguments.push_back(CefV8Value::CreateFunction("callback", callback.get()));
+    CefRefPtr<CefV8Value> requestId, cancelled;
+    if (Call(handler, "SearchFilesAsync", arguments, requestId) != NO_ERROR ||
+        Call(handler, "CancelRequest", Args(requestId), cancelled) != NO_ERROR) {
+        fprintf(stderr, "Could not start and cancel a search\n");
+        return 1;
+    }
+    CefRunMessageLoop();
+    if (callback->m_error != ERR_CANCELLED) {
+        fprintf(stderr, "A cancelled search finished with %d\n", callback->m_error);
+        return 1;
+    }
+
+    // The search stops at the next file it looks at. Give it time to, before
+    // the files go away.
+    RunMessageLoopFor(200);
+
+    return 0;
+}
+
+
+namespace {
+
+// Line of generated code for the regex corpus. Now and then it has a TODO
+// comment, a date, or a name starting with "widget".
+std::string RegexCorpusLine(unsigned int& seed, int line)
+{
+    static const char* const owners[] = { "ana", "bo", "chen", "dmitri" };
+    static const char* const suffixes[] = { "", "s", "ry", "_id", "s2" };
+
+    char buffer[128];
+    unsigned int kind = NextRandom(seed) % 100;
+    if (kind == 0) {
+        snprintf(buffer, sizeof(buffer), "    // TODO(%s): fix %u\n", owners[NextRandom(seed) % 4],
+                 NextRandom(seed));
+    } else if (kind == 1) {
+        snprintf(buffer, sizeof(buffer), "    log(\"%04u-%02u-%02u started\");\n", 2000 + NextRandom(seed) % 30,
+                 1 + NextRandom(seed) % 12, 1 + NextRandom(seed) % 28);
+    } else if (kind < 4) {
+        const char* suffix = suffixes[NextRandom(seed) % 5];
+        snprintf(buffer, sizeof(buffer), "    var widget%s = new Widget(\"caf\xC3\xA9 %d\");\n", suffix, line);
+    } else {
+        snprintf(buffer, sizeof(buffer), "    total%d += compute(%u, \"caf\xC3\xA9 text\"); // step %d\n",
+                 line % 10, NextRandom(seed), line % 7);
+    }
+    return buffer;
+}
+
+// Writes files of about 128 KB, |options.filesPerDir| per directory, until
+// there are |options.fileSizeMB| MB of them. Returns their paths, or false.
+bool MakeRegexCorpus(const std::string& root, const Options& options, std::vector<std::string>& paths)
+{
+    const size_t fileSize = 128 * 1024;
+    unsigned long long total = (unsigned long long)options.fileSizeMB * 1024 * 1024;
+    unsigned int seed = 1;
+    char name[64];
+    std::string dir;
+    for (int i = 0; (unsigned long long)i * fileSize < total; i++) {
+        if (i % options.filesPerDir == 0) {
+            snprintf(name, sizeof(name), "/dir%05d", i / options.filesPerDir);
+            dir = root + name;
+            if (mkdir(dir.c_str(), 0777) == -1)
+                return false;
+        }
+
+        std::string contents;
+        for (int line = 0; contents.length() < fileSize; line++)
+            contents += RegexCorpusLine(seed, line);
+        snprintf(name, sizeof(name), "/file%06d.js", i);
+        paths.push_back(dir + name);
+        if (!WriteSmallFile(paths.back(), contents.c_str()))
+            return false;
+    }
+    return true;
+}
+
+// Stands in for what the JS side does without native regex search: ReadFile
+// every file, then run a regular expression over it. V8's RegExp engine is
+// not available here, so the expression is the POSIX equivalent of the JS
+// one, run with regexec a line at a time. Returns the number of matches, or
+// -1 if |pattern| does not compile.
+long RegexSearchByReading(CefRefPtr<CefV8Handler> handler, const std::vector<std::string>& paths,
+                          const char* pattern, int flags)
+{
+    regex_t regex;
+    if (regcomp(&regex, pattern, REG_EXTENDED | flags) != 0)
+        return -1;
+
+    long matches = 0;
+    std::string line;
+    for (size_t i = 0; i < paths.size(); i++) {
+        CefRefPtr<CefV8Value> retval;
+        if (Call(handler, "ReadFile", Args(CefV8Value::CreateString(paths[i]), CefV8Value::CreateString("utf8")),
+                 retval) != NO_ERROR)
+            continue;
+
+        std::string text = retval->GetStringValue();
+        for (size_t start = 0; start < text.length(); ) {
+            size_t end = text.find('\n', start);
+            if (end == std::string::npos)
+                end = text.length();
+            line.assign(text, start, end - start);
+
+            regmatch_t match;
+            for (size_t offset = 0; offset < line.length(); ) {
+                if (regexec(&regex, line.c_str() + offset, 1, &match, offset ? REG_NOTBOL : 0) != 0)
+                    break;
+                if (match.rm_eo == match.rm_so) {
+                    offset += match.rm_so + 1;
+                    continue;
+                }
+                matches++;
+                offset += match.rm_eo;
+            }
+            start = end + 1;
+        }
+    }
+
+    regfree(&regex);
+    return matches;
+}
+
+} // namespace
+
+int RunRegexBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    std::vector<std::string> paths;
+    double start = Now();
+    if (!MakeRegexCorpus(options.root, options, paths)) {
+        fprintf(stderr, "Could not create the files to search\n");
+        return 1;
+    }
+    PrintResult("create files", Now() - start, (long)paths.size());
+
+    // Each query as JS would write it and as a POSIX extended expression:
+    // one with a literal every match contains, one with none, and a
+    // case-insensitive whole-word one
+    struct Query {
+        const char* label;
+        const char* pattern;
+        const char* posixPattern;
+        bool ignoreCase;
+        bool wholeWord;
+    };
+    static const Query queries[] = {
+        { "TODO, literal prefilter", "TODO\\((\\w+)\\): fix \\d+", "TODO\\(([[:alnum:]_]+)\\): fix [0-9]+",
+          false, false },
+        { "date, DFA prefilter", "\\d{4}[-/]\\d{2}[-/]\\d{2}", "[0-9]{4}[-/][0-9]{2}[-/][0-9]{2}", false, false },
+        { "whole word, ignore case", "widgets?", "\\<widgets?\\>", true, true },
+    };
+
+    CefRefPtr<CefV8Value> roots = CefV8Value::CreateArray();
+    roots->SetValue(0, CefV8Value::CreateString(options.root));
+
+    char label[128];
+    CefRefPtr<CefV8Value> summary;
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        const Query& query = queries[q];
+        printf("/%s/%s%s\n", query.pattern, query.ignoreCase ? "i" : "", query.wholeWord ? ", whole word" : "");
+
+        start = Now();
+        long expected = RegexSearchByReading(handler, paths, query.posixPattern, query.ignoreCase ? REG_ICASE : 0);
+        PrintResult("ReadFile + regexec per line, serially", Now() - start, expected);
+
+        CefRefPtr<CefV8Value> searchOptions = CefV8Value::CreateObject(NULL);
+        searchOptions->SetValue("regex", CefV8Value::CreateBool(true), V8_PROPERTY_ATTRIBUTE_NONE);
+        searchOptions->SetValue("caseSensitive", CefV8Value::CreateBool(!query.ignoreCase), V8_PROPERTY_ATTRIBUTE_NONE);
+        searchOptions->SetValue("wholeWord", CefV8Value::CreateBool(query.wholeWord), V8_PROPERTY_ATTRIBUTE_NONE);
+        searchOptions->SetValue("maxMatches", CefV8Value::CreateInt(INT_MAX), V8_PROPERTY_ATTRIBUTE_NONE);
+
+        for (int n = 0; n < options.iterations; n++) {
+            CefRefPtr<SearchCollector> collector = new SearchCollector();
+            start = Now();
+            if (CallAndWait(handler, "SearchFilesAsync",
+                            Args(roots, CefV8Value::CreateString(query.pattern), searchOptions,
+                                 CefV8Value::CreateFunction("progress", collector.get())),
+                            summary) != NO_ERROR) {
+                fprintf(stderr, "SearchFilesAsync failed for /%s/\n", query.pattern);
+                return 1;
+            }
+            snprintf(label, sizeof(label), "SearchFilesAsync, %s", query.label);
+            PrintResult(label, Now() - start, collector->m_matches);
+            if (collector->m_matches != expected) {
+                fprintf(stderr, "SearchFilesAsync found %ld matches for /%s/, regexec %ld\n", collector->m_matches,
+                        query.pattern, expected);
+                return 1;
+            }
+            if (n == 0)
+                printf("  %d batches\n", collector->m_batches);
+        }
+    }
+
+    // Patterns the engine doesn't take are refused before the search starts
+    static const char* const unsupported[] = { "(a)\\1", "(?<=a)b", "a(?!b)", "(?<name>a)", "a{2,1}", "(ab" };
+    for (size_t i = 0; i < sizeof(unsupported) / sizeof(unsupported[0]); i++) {
+        CefRefPtr<CefV8Value> searchOptions = CefV8Value::CreateObject(NULL);
+        searchOptions->SetValue("regex", CefV8Value::CreateBool(true), V8_PROPERTY_ATTRIBUTE_NONE);
+        CefRefPtr<CefV8Value> retval;
+        CefV8ValueList arguments = Args(roots, CefV8Value::CreateString(unsupported[i]), searchOptions,
+                                        CefV8Value::CreateFunction("progress", new SearchCollector()));
+        arguments.push_back(CefV8Value::CreateFunction("callback", new ResultCallback()));
+        if (Call(handler, "SearchFilesAsync", arguments, retval) != ERR_INVALID_PARAMS) {
+            fprintf(stderr, "SearchFilesAsync accepted /%s/\n", unsupported[i]);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+namespace {
+
+// Counts the progress calls of BuildSearchIndexAsync
+class IndexProgress : public CefV8Handler
+{
+public:
+    IndexProgress() : m_calls(0), m_done(0), m_total(0) {}
+
+    virtual bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+    {
+        m_calls++;
+        m_done = (long)arguments[0]->GetDoubleValue();
+        m_total = (long)arguments[1]->GetDoubleValue();
+        return true;
+    }
+
+    int m_calls;
+    long m_done;
+    long m_total;
+
+    IMPLEMENT_REFCOUNTING(IndexProgress);
+};
+
+double SummaryCount(CefRefPtr<CefV8Value> summary, const char* key)
+{
+    return summary->GetValue(key)->GetDoubleValue();
+}
+
+// Builds or refreshes the index and prints what it did. Returns the summary,
+// or NULL.
+CefRefPtr<CefV8Value> BuildIndex(CefRefPtr<CefV8Handler> handler, const char* label, CefRefPtr<CefV8Value> root,
+                                 CefRefPtr<CefV8Value> indexPath, CefRefPtr<CefV8Value> buildOptions)
+{
+    CefRefPtr<IndexProgress> progress = new IndexProgress();
+    CefRefPtr<CefV8Value> summary;
+    double start = Now();
+    if (CallAndWait(handler, "BuildSearchIndexAsync",
+                    Args(root, indexPath, buildOptions, CefV8Value::CreateFunction("progress", progress.get())),
+                    summary) != NO_ERROR) {
+        fprintf(stderr, "%s failed\n", label);
+        return NULL;
+    }
+    PrintResult(label, Now() - start, (long)SummaryCount(summary, "files"));
+    printf("  %.0f read, %.0f reused, %.0f skipped, %.0f trigrams, %.1f MB, %d progress calls\n",
+           SummaryCount(summary, "read"), SummaryCount(summary, "reused"), SummaryCount(summary, "skipped"),
+           SummaryCount(summary, "trigrams"), SummaryCount(summary, "size") / (1024 * 1024), progress->m_calls);
+    if (progress->m_done != progress->m_total) {
+        fprintf(stderr, "%s stopped reporting progress at %ld of %ld\n", label, progress->m_done, progress->m_total);
+        return NULL;
+    }
+    return summary;
+}
+
+// Searches for |query| with |searchOptions| and checks the number of
+// matches. Returns the summary, or NULL.
+CefRefPtr<CefV8Value> SearchWithIndex(CefRefPtr<CefV8Handler> handler, const char* label, CefRefPtr<CefV8Value> roots,
+                                      const char* query, CefRefPtr<CefV8Value> searchOptions, int iterations,
+                                      long expected)
+{
+    CefRefPtr<CefV8Value> summary;
+    for (int n = 0; n < iterations; n++) {
+        CefRefPtr<SearchCollector> collector = new SearchCollector();
+        double start = Now();
+        if (CallAndWait(handler, "SearchFilesAsync",
+                        Args(roots, CefV8Value::CreateString(query), searchOptions,
+                             CefV8Value::CreateFunction("progress", collector.get())),
+                        summary) != NO_ERROR) {
+            fprintf(stderr, "%s failed\n", label);
+            return NULL;
+        }
+        PrintResult(label, Now() - start, collector->m_matches);
+        if (collector->m_matches != expected) {
+            fprintf(stderr, "%s found %ld matches, expected %ld\n", label, collector->m_matches, expected);
+            return NULL;
+        }
+    }
+    printf("  %.0f files, %.0f ruled out by the index\n", SummaryCount(summary, "files"),
+           SummaryCount(summary, "ruledOut"));
+    return summary;
+}
+
+} // namespace
+
+int RunIndexBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    std::vector<std::string> paths;
+    double start = Now();
+    if (!MakeSearchCorpus(options.root, options, paths)) {
+        fprintf(stderr, "Could not create the files to search\n");
+        return 1;
+    }
+    PrintResult("create files", Now() - start, (long)paths.size());
+
+    // The index is kept under the root, as it would be in a project that
+    // has one, so the build must leave it out
+    std::string indexFile = options.root + "/.brackets-index";
+    CefRefPtr<CefV8Value> root = CefV8Value::CreateString(options.root);
+    CefRefPtr<CefV8Value> indexPath = CefV8Value::CreateString(indexFile);
+    CefRefPtr<CefV8Value> roots = CefV8Value::CreateArray();
+    roots->SetValue(0, root);
+    CefRefPtr<CefV8Value> ignore = CefV8Value::CreateArray();
+    ignore->SetValue(0, CefV8Value::CreateString("node_modules"));
+
+    CefRefPtr<CefV8Value> buildOptions = CefV8Value::CreateObject(NULL);
+    buildOptions->SetValue("ignore", ignore, V8_PROPERTY_ATTRIBUTE_NONE);
+    CefRefPtr<CefV8Value> summary = BuildIndex(handler, "BuildSearchIndexAsync, cold", root, indexPath, buildOptions);
+    if (!summary.get())
+        return 1;
+    // The log is larger than maxFileSize, so it is listed but not read
+    if (SummaryCount(summary, "files") != (double)paths.size() || SummaryCount(summary, "skipped") != 1 ||
+        SummaryCount(summary, "read") != (double)(paths.size() - 1)) {
+        fprintf(stderr, "The index has %.0f files, expected %ld\n", SummaryCount(summary, "files"), (long)paths.size());
+        return 1;
+    }
+
+    summary = BuildIndex(handler, "BuildSearchIndexAsync, unchanged", root, indexPath, buildOptions);
+    if (!summary.get())
+        return 1;
+    if (SummaryCount(summary, "read") != 0 || SummaryCount(summary, "reused") != (double)paths.size()) {
+        fprintf(stderr, "Refreshing an unchanged index read %.0f files\n", SummaryCount(summary, "read"));
+        return 1;
+    }
+
+    // What reopening the project costs, without the cache the searches share
+    const int opens = 100;
+    start = Now();
+    for (int i = 0; i < opens; i++) {
+        CefRefPtr<Brackets::FileSystem::SearchIndex> index;
+        if (Brackets::FileSystem::SearchIndex::Open(indexFile, index) != NO_ERROR ||
+            index->GetFileCount() != paths.size()) {
+            fprintf(stderr, "Could not open the index\n");
+            return 1;
+        }
+    }
+    PrintResult("SearchIndex::Open", (Now() - start) / opens, 1);
+
+    // One match in every 50th file and one in the log
+    long expected = (options.files + 49) / 50 + 1;
+
+    // A project would have its .gitignore leave the index out of searches
+    CefRefPtr<CefV8Value> searchIgnore = CefV8Value::CreateArray();
+    searchIgnore->SetValue(0, CefV8Value::CreateString("node_modules"));
+    searchIgnore->SetValue(1, CefV8Value::CreateString(".brackets-index"));
+
+    CefRefPtr<CefV8Value> plainOptions = CefV8Value::CreateObject(NULL);
+    plainOptions->SetValue("ignore", searchIgnore, V8_PROPERTY_ATTRIBUTE_NONE);
+    CefRefPtr<CefV8Value> indexOptions = CefV8Value::CreateObject(NULL);
+    indexOptions->SetValue("ignore", searchIgnore, V8_PROPERTY_ATTRIBUTE_NONE);
+    indexOptions->SetValue("index", indexPath, V8_PROPERTY_ATTRIBUTE_NONE);
+
+    if (!SearchWithIndex(handler, "SearchFilesAsync, no index", roots, "needle", plainOptions, options.iterations,
+                         expected - 1).get())
+        return 1;
+    summary = SearchWithIndex(handler, "SearchFilesAsync, index", roots, "needle", indexOptions, options.iterations,
+                              expected - 1);
+    if (!summary.get())
+        return 1;
+    if (SummaryCount(summary, "files") != (double)paths.size() ||
+        SummaryCount(summary, "ruledOut") < (double)(paths.size() - expected) ||
+        SummaryCount(summary, "binary") != 1) {
+        fprintf(stderr, "The index ruled out %.0f of %ld files\n", SummaryCount(summary, "ruledOut"),
+                (long)paths.size());
+        return 1;
+    }
+
+    CefRefPtr<CefV8Value> regexOptions = CefV8Value::CreateObject(NULL);
+    regexOptions->SetValue("ignore", searchIgnore, V8_PROPERTY_ATTRIBUTE_NONE);
+    regexOptions->SetValue("index", indexPath, V8_PROPERTY_ATTRIBUTE_NONE);
+    regexOptions->SetValue("regex", CefV8Value::CreateBool(true), V8_PROPERTY_ATTRIBUTE_NONE);
+    if (!SearchWithIndex(handler, "SearchFilesAsync, index, regex", roots, "FIXME: ne+dle", regexOptions,
+                         options.iterations, expected - 1).get())
+        return 1;
+
+    // A file changed after the build is searched all the same, and is the
+    // only one the next refresh reads
+    if (!WriteSmallFile(paths[1], "// one more needle\n")) {
+        fprintf(stderr, "Could not change %s\n", paths[1].c_str());
+        return 1;
+    }
+    if (!SearchWithIndex(handler, "SearchFilesAsync, index, one file changed", roots, "needle", indexOptions, 1,
+                         expected).get())
+        return 1;
+    summary = BuildIndex(handler, "BuildSearchIndexAsync, one file changed", root, indexPath, buildOptions);
+    if (!summary.get())
+        return 1;
+    if (SummaryCount(summary, "read") != 1) {
+        fprintf(stderr, "Refreshing the index read %.0f files, expected 1\n", SummaryCount(summary, "read"));
+        return 1;
+    }
+    if (!SearchWithIndex(handler, "SearchFilesAsync, refreshed index", roots, "needle", indexOptions, 1,
+                         expected).get())
+        return 1;
+
+    // A damaged index is ignored rather than trusted
+    if (Brackets::FileSystem::WriteFile(indexFile, "BRTI", "utf8", Brackets::FileSystem::DURABILITY_NONE) != NO_ERROR ||
+        !SearchWithIndex(handler, "SearchFilesAsync, damaged index", roots, "needle", indexOptions, 1,
+                         expected).get())
+        return 1;
+
+    return 0;
+}
+
+namespace {
+
+// Paths like the ones of a large web project, |count| of them
+void MakeProjectPaths(int count, std::vector<std::string>& paths)
+{
+    static const char* const areas[] = { "src", "lib", "test", "tools", "docs", "extensions" };
+    static const char* const words[] = {
+        "Document", "Editor", "Project", "Manager", "File", "View", "Panel", "Search", "Quick", "Open",
+        "Command", "Menu", "Utils", "Index", "Cache", "Model", "Language", "Code", "Hint", "Inline",
+        "Widget", "Dialog", "Status", "Bar", "Theme", "Preferences", "Live", "Development", "Server", "Http"
+    };
+    static const char* const extensions[] = { ".js", ".js", ".js", ".css", ".less", ".html", ".json", ".md" };
+    const int wordCount = sizeof(words) / sizeof(words[0]);
+
+    unsigned int seed = 7;
+    char buffer[256];
+    for (int i = 0; i < count; i++) {
+        const char* area = areas[NextRandom(seed) % 6];
+        const char* module = words[NextRandom(seed) % wordCount];
+        const char* first = words[NextRandom(seed) % wordCount];
+        const char* second = words[NextRandom(seed) % wordCount];
+        snprintf(buffer, sizeof(buffer), "/projects/brackets/%s/%s%d/%s%s%d%s", area, module, i % 97, first, second,
+                 i, extensions[NextRandom(seed) % 8]);
+        paths.push_back(buffer);
+    }
+}
+
+// What the JS side does for every path on every keystroke: lower-case the
+// path, find the characters of the query in order, score the match and
+// sort all of them. Returns the number of matches.
+long MatchByScanning(const std::vector<std::string>& paths, const std::string& query, std::string& best)
+{
+    std::vector<std::pair<int, size_t> > matches;
+    for (size_t i = 0; i < paths.size(); i++) {
+        std::string lower = paths[i];
+        std::transform(lower.begin(), lower.end(), lower.begin(), tolower);
+        size_t slash = lower.rfind('/');
+
+        int score = 0;
+        size_t from = 0;
+        size_t previous = std::string::npos;
+        bool matched = true;
+        for (size_t q = 0; q < query.length() && matched; q++) {
+            size_t found = lower.find(query[q], from);
+            if (found == std::string::npos) {
+                matched = false;
+                break;
+            }
+            score += 10;
+            if (previous != std::string::npos && found == previous + 1)
+                score += 5;
+            if (found == 0 || lower[found - 1] == '/' || isupper((unsigned char)paths[i][found]))
+                score += 8;
+            if (found > slash)
+                score += 4;
+            previous = found;
+            from = found + 1;
+        }
+        if (matched)
+            matches.push_back(std::make_pair(-score, i));
+    }
+    std::sort(matches.begin(), matches.end());
+    best = matches.empty() ? "" : paths[matches[0].second];
+    return (long)matches.size();
+}
+
+CefRefPtr<CefV8Value> MatchPaths(CefRefPtr<CefV8Handler> handler, CefRefPtr<CefV8Value> matcher,
+                                 const std::string& query, int maxResults)
+{
+    CefRefPtr<CefV8Value> results;
+    if (Call(handler, "MatchPaths", Args(matcher, CefV8Value::CreateString(query), CefV8Value::CreateInt(maxResults)),
+             results) != NO_ERROR)
+        return NULL;
+    return results;
+}
+
+std::string ResultPath(CefRefPtr<CefV8Value> results, int index)
+{
+    if (index >= results->GetArrayLength())
+        return "";
+    return results->GetValue(index)->GetValue("path")->GetStringValue();
+}
+
+} // namespace
+
+int RunQuickOpenBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    std::vector<std::string> paths;
+    MakeProjectPaths(options.files, paths);
+
+    CefRefPtr<CefV8Value> pathArray = CefV8Value::CreateArray();
+    for (size_t i = 0; i < paths.size(); i++)
+        pathArray->SetValue((int)i, CefV8Value::CreateString(paths[i]));
+
+    CefRefPtr<CefV8Value> matcher;
+    double start = Now();
+    if (Call(handler, "CreatePathMatcher", Args(pathArray), matcher) != NO_ERROR) {
+        fprintf(stderr, "CreatePathMatcher failed\n");
+        return 1;
+    }
+    PrintResult("CreatePathMatcher", Now() - start, (long)paths.size());
+
+    // Typing a query one character at a time, as Quick Open sees it
+    const std::string typed = "qoview";
+    double scanTotal = 0, matchTotal = 0, worstMatch = 0;
+    for (int n = 0; n < options.iterations; n++) {
+        // Starting over, so that every round scores the whole list for the
+        // first character
+        MatchPaths(handler, matcher, "#", 1);
+        for (size_t length = 1; length <= typed.length(); length++) {
+            std::string query = typed.substr(0, length);
+            std::string best;
+            start = Now();
+            long scanned = MatchByScanning(paths, query, best);
+            scanTotal += Now() - start;
+
+            start = Now();
+            CefRefPtr<CefV8Value> results = MatchPaths(handler, matcher, query, 50);
+            double elapsed = Now() - start;
+            matchTotal += elapsed;
+            worstMatch = std::max(worstMatch, elapsed);
+            if (!results.get() || (scanned > 0) != (results->GetArrayLength() > 0)) {
+                fprintf(stderr, "MatchPaths disagrees with the scan on whether \"%s\" matches\n", query.c_str());
+                return 1;
+            }
+            if (n == 0)
+                printf("  \"%s\": %ld matches, best %s\n", query.c_str(), scanned, ResultPath(results, 0).c_str());
+        }
+    }
+    long keystrokes = (long)(typed.length() * options.iterations);
+    PrintResult("scan and sort every path, per keystroke", scanTotal / keystrokes, 1);
+    PrintResult("MatchPaths, per keystroke", matchTotal / keystrokes, 1);
+    PrintResult("MatchPaths, slowest keystroke", worstMatch, 1);
+
+    // Deleting a character goes back to the paths of the shorter query
+    start = Now();
+    if (!MatchPaths(handler, matcher, "qovie", 50).get()) {
+        fprintf(stderr, "MatchPaths failed\n");
+        return 1;
+    }
+    PrintResult("MatchPaths, after a backspace", Now() - start, 1);
+
+    // Segment starts and camelCase humps beat scattered letters
+    CefRefPtr<CefV8Value> results = MatchPaths(handler, matcher, "edpa", 1);
+    std::string best = ResultPath(results, 0);
+    size_t name = best.rfind('/') + 1;
+    if (best.compare(name, 6, "Editor") != 0 || best.find("Panel", name) == std::string::npos) {
+        fprintf(stderr, "\"edpa\" matched %s first\n", best.c_str());
+        return 1;
+    }
+    CefRefPtr<CefV8Value> matches = results->GetValue(0)->GetValue("matches");
+    if (matches->GetArrayLength() != 4 || matches->GetValue(0)->GetIntValue() != (int)name) {
+        fprintf(stderr, "\"edpa\" reported the wrong positions in %s\n", best.c_str());
+        return 1;
+    }
+
+    // A path opened often and lately moves up among paths that match about
+    // as well, and an empty query lists it
+    results = MatchPaths(handler, matcher, "editorpanel", 20);
+    if (!results.get() || results->GetArrayLength() < 20) {
+        fprintf(stderr, "Too few matches for \"editorpanel\"\n");
+        return 1;
+    }
+    std::string opened = ResultPath(results, 19);
+    CefRefPtr<CefV8Value> retval;
+    for (int i = 0; i < 5; i++) {
+        if (Call(handler, "RecordPathOpened", Args(matcher, CefV8Value::CreateString(opened)), retval) != NO_ERROR) {
+            fprintf(stderr, "RecordPathOpened failed\n");
+            return 1;
+        }
+    }
+    if (ResultPath(MatchPaths(handler, matcher, "editorpanel", 20), 0) != opened ||
+        ResultPath(MatchPaths(handler, matcher, "", 20), 0) != opened) {
+        fprintf(stderr, "Opening %s did not move it up\n", opened.c_str());
+        return 1;
+    }
+
+    // Removed paths stop matching, and come back when added again
+    CefRefPtr<CefV8Value> changed = CefV8Value::CreateArray();
+    changed->SetValue(0, CefV8Value::CreateString(opened));
+    if (Call(handler, "UpdatePathMatcher", Args(matcher, CefV8Value::CreateArray(), changed), retval) != NO_ERROR ||
+        ResultPath(MatchPaths(handler, matcher, "editorpanel", 20), 0) == opened ||
+        Call(handler, "UpdatePathMatcher", Args(matcher, changed, CefV8Value::CreateArray()), retval) != NO_ERROR ||
+        ResultPath(MatchPaths(handler, matcher, "editorpanel", 20), 0) != opened) {
+        fprintf(stderr, "UpdatePathMatcher did not remove and add %s\n", opened.c_str());
+        return 1;
+    }
+
+    if (Call(handler, "ClosePathMatcher", Args(matcher), retval) != NO_ERROR || !retval->GetBoolValue() ||
+        Call(handler, "MatchPaths", Args(matcher, CefV8Value::CreateString("a"), CefV8Value::CreateInt(1)),
+             retval) != ERR_INVALID_PARAMS) {
+        fprintf(stderr, "ClosePathMatcher did not close the matcher\n");
+        return 1;
+    }
+    return 0;
+}
+
+namespace {
+
+const char* const kProjectRoot = "/Users/developer/Projects/brackets-app/";
+
+// Bytes malloc has handed out and not had back
+size_t HeapInUse()
+{
+    return mallinfo2().uordblks;
+}
+
+// Paths shaped like a checkout of a web project: a long root, sources in
+// a few areas, and packages in node_modules that all have the same few
+// file names
+void MakeCheckoutPaths(int count, std::vector<std::string>& paths)
+{
+    static const char* const areas[] = { "src", "test", "tools", "docs" };
+    static const char* const words[] = {
+        "document", "editor", "project", "manager", "file", "view", "panel", "search", "quick", "open",
+        "command", "menu", "utils", "index", "cache", "model", "language", "code", "hint", "inline",
+        "widget", "dialog", "status", "bar", "theme", "preferences", "live", "development", "server", "http"
+    };
+    static const char* const common[] = { "index.js", "package.json", "README.md", "LICENSE", "CHANGELOG.md" };
+    static const char* const subdirs[] = { "lib", "src", "test", "dist" };
+    const int wordCount = sizeof(words) / sizeof(words[0]);
+    const int filesPerPackage = 40;
+
+    char buffer[512];
+    for (int i = 0; i < count; i++) {
+        int package = i / filesPerPackage;
+        int file = i % filesPerPackage;
+
+        std::string path = kProjectRoot;
+        if (package % 4 == 0) {
+            snprintf(buffer, sizeof(buffer), "%s/%s%d/", areas[package / 4 % 4], words[package % wordCount], package);
+        } else if (package % 2) {
+            snprintf(buffer, sizeof(buffer), "node_modules/%s-%s-%d/", words[package % wordCount],
+                     words[package / wordCount % wordCount], package);
+        } else {
+            // A dependency of a dependency
+            snprintf(buffer, sizeof(buffer), "node_modules/%s-%s-%d/node_modules/%s-%d/", words[package % wordCount],
+                     words[package / wordCount % wordCount], package - 1, words[package * 7 % wordCount], package);
+        }
+        path += buffer;
+
+        if (file < 5)
+            path += common[file];
+        else {
+            snprintf(buffer, sizeof(buffer), "%s/%s%s.js", subdirs[file % 4], words[file % wordCount],
+                     words[file * 7 % wordCount]);
+            path += buffer;
+        }
+        paths.push_back(path);
+    }
+
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+}
+
+// Progress function passed to LoadPathStoreAsync
+class StoreProgress : public CefV8Handler
+{
+public:
+    StoreProgress() : m_calls(0), m_paths(0) {}
+
+    virtual bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+    {
+        m_calls++;
+        m_paths = (long)arguments[0]->GetDoubleValue();
+        return true;
+    }
+
+    int m_calls;
+    long m_paths;
+
+    IMPLEMENT_REFCOUNTING(StoreProgress);
+};
+
+void PrintMemory(const char* label, size_t bytes, size_t count)
+{
+    printf("%-40s %10.1f MB  %8lu paths  %10.1f bytes/path\n",
+           label, bytes / (1024.0 * 1024.0), (unsigned long)count, count ? (double)bytes / count : 0.0);
+}
+
+} // namespace
+
+int RunPathStoreBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    using Brackets::FileSystem::PathStore;
+
+    std::vector<std::string> paths;
+    MakeCheckoutPaths(options.files, paths);
+    size_t characters = 0;
+    for (size_t i = 0; i < paths.size(); i++)
+        characters += paths[i].length();
+    printf("%lu paths, %.1f characters on average\n", (unsigned long)paths.size(),
+           paths.empty() ? 0.0 : (double)characters / paths.size());
+
+    // What the project tree holds today: one string per path, as
+    // ExtensionString is on Mac (std::string) and on Windows (std::wstring;
+    // wchar_t is 4 bytes here, 2 there)
+    size_t before = HeapInUse();
+    std::vector<std::string>* narrow = new std::vector<std::string>(paths.begin(), paths.end());
+    size_t narrowBytes = HeapInUse() - before;
+    delete narrow;
+
+    before = HeapInUse();
+    std::vector<std::wstring>* wide = new std::vector<std::wstring>();
+    wide->reserve(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+        wide->push_back(std::wstring(paths[i].begin(), paths[i].end()));
+    size_t wideBytes = HeapInUse() - before;
+    delete wide;
+
+    std::vector<int> ids;
+    ids.reserve(paths.size());
+    before = HeapInUse();
+    CefRefPtr<PathStore> store = new PathStore();
+    double start = Now();
+    store->Add(paths, ids);
+    double addTime = Now() - start;
+    size_t storeBytes = HeapInUse() - before;
+
+    PrintMemory("std::string per path", narrowBytes, paths.size());
+    PrintMemory("std::wstring per path", wideBytes, paths.size());
+    PrintMemory("PathStore", storeBytes, paths.size());
+    printf("  %lu nodes, %lu distinct names, %.1f MB by GetMemoryUsage, %.1fx smaller than std::string\n",
+           (unsigned long)store->GetPathCount(), (unsigned long)store->GetNameCount(),
+           store->GetMemoryUsage() / (1024.0 * 1024.0), storeBytes ? (double)narrowBytes / storeBytes : 0.0);
+    PrintResult("PathStore::Add", addTime, (long)paths.size());
+
+    // Every path comes back as it went in, under the id it was given
+    start = Now();
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (store->Find(paths[i]) != ids[i]) {
+            fprintf(stderr, "PathStore::Find did not find %s\n", paths[i].c_str());
+            return 1;
+        }
+    }
+    PrintResult("PathStore::Find", Now() - start, (long)paths.size());
+
+    start = Now();
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (store->GetPath(ids[i]) != paths[i]) {
+            fprintf(stderr, "PathStore::GetPath gave %s for %s\n", store->GetPath(ids[i]).c_str(), paths[i].c_str());
+            return 1;
+        }
+    }
+    PrintResult("PathStore::GetPath", Now() - start, (long)paths.size());
+
+    int project = store->Find(kProjectRoot);
+    std::vector<int> files;
+    start = Now();
+    store->GetFiles(project, files);
+    PrintResult("PathStore::GetFiles of the project", Now() - start, (long)files.size());
+    if (files.size() != paths.size() || store->GetPath(project) != kProjectRoot) {
+        fprintf(stderr, "PathStore::GetFiles listed %lu files of %lu\n", (unsigned long)files.size(),
+                (unsigned long)paths.size());
+        return 1;
+    }
+
+    // Removing a directory takes what is below it, and leaves the ids of
+    // everything else alone; adding a path again gives it a new id
+    int modules = store->Find(std::string(kProjectRoot) + "node_modules");
+    size_t pathCount = store->GetPathCount();
+    size_t removed = store->Remove(modules);
+    size_t kept = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        bool inModules = paths[i].find("/node_modules/") != std::string::npos;
+        int id = store->Find(paths[i]);
+        if (inModules ? id != -1 : id != ids[i]) {
+            fprintf(stderr, "Removing node_modules changed the id of %s\n", paths[i].c_str());
+            return 1;
+        }
+        if (!inModules)
+            kept++;
+    }
+    if (store->GetPathCount() != pathCount - removed || store->IsValid(modules) ||
+        store->Add(std::string(kProjectRoot) + "node_modules/") == modules) {
+        fprintf(stderr, "PathStore::Remove left node_modules behind\n");
+        return 1;
+    }
+    printf("  removed node_modules: %lu paths, %lu files kept\n", (unsigned long)removed, (unsigned long)kept);
+    store = NULL;
+
+    // Through the native functions, and into a PathMatcher
+    CefRefPtr<CefV8Value> pathArray = CefV8Value::CreateArray();
+    for (size_t i = 0; i < paths.size(); i++)
+        pathArray->SetValue((int)i, CefV8Value::CreateString(paths[i]));
+
+    CefRefPtr<CefV8Value> handle, retval;
+    if (Call(handler, "CreatePathStore", CefV8ValueList(), handle) != NO_ERROR) {
+        fprintf(stderr, "CreatePathStore failed\n");
+        return 1;
+    }
+    start = Now();
+    if (Call(handler, "AddStorePaths", Args(handle, pathArray), retval) != NO_ERROR ||
+        retval->GetArrayLength() != (int)paths.size()) {
+        fprintf(stderr, "AddStorePaths failed\n");
+        return 1;
+    }
+    PrintResult("AddStorePaths", Now() - start, (long)paths.size());
+
+    // The project lists the areas and node_modules
+    std::set<std::string> top;
+    size_t rootLength = strlen(kProjectRoot);
+    for (size_t i = 0; i < paths.size(); i++)
+        top.insert(paths[i].substr(rootLength, paths[i].find('/', rootLength) - rootLength));
+
+    CefRefPtr<CefV8Value> projectId = CefV8Value::CreateInt(project);
+    if (Call(handler, "ListStoreChildren", Args(handle, projectId), retval) != NO_ERROR ||
+        retval->GetValue("names")->GetArrayLength() != (int)top.size()) {
+        fprintf(stderr, "ListStoreChildren did not list the project\n");
+        return 1;
+    }
+    for (int i = 0; i < (int)top.size(); i++) {
+        std::string name = retval->GetValue("names")->GetValue(i)->GetStringValue();
+        if (!top.count(name.substr(0, name.length() - 1)) || name[name.length() - 1] != '/') {
+            fprintf(stderr, "ListStoreChildren listed %s in the project\n", name.c_str());
+            return 1;
+        }
+    }
+
+    CefRefPtr<CefV8Value> matcher;
+    start = Now();
+    if (Call(handler, "CreatePathMatcher", Args(handle, projectId), matcher) != NO_ERROR) {
+        fprintf(stderr, "CreatePathMatcher from a store failed\n");
+        return 1;
+    }
+    PrintResult("CreatePathMatcher from the store", Now() - start, (long)paths.size());
+    if (Call(handler, "MatchPaths", Args(matcher, CefV8Value::CreateString("pkgjson"), CefV8Value::CreateInt(1)),
+             retval) != NO_ERROR || retval->GetArrayLength() != 1) {
+        fprintf(stderr, "The matcher made from the store found nothing\n");
+        return 1;
+    }
+    Call(handler, "ClosePathMatcher", Args(matcher), retval);
+
+    if (Call(handler, "ClosePathStore", Args(handle), retval) != NO_ERROR || !retval->GetBoolValue()) {
+        fprintf(stderr, "ClosePathStore failed\n");
+        return 1;
+    }
+
+    // Loading a tree on disk, which WalkTreeAsync lists just the same
+    Options treeOptions = options;
+    treeOptions.files = std::min(options.files, 20000);
+    Project tree;
+    if (!MakeProject(treeOptions, tree))
+        return 1;
+    const std::vector<std::string>& dirs = tree.dirs;
+
+    Call(handler, "CreatePathStore", CefV8ValueList(), handle);
+    CefRefPtr<StoreProgress> progress = new StoreProgress();
+    CefRefPtr<CefV8Value> summary;
+    start = Now();
+    if (CallAndWait(handler, "LoadPathStoreAsync",
+                    Args(handle, CefV8Value::CreateString(options.root), CefV8Value::CreateObject(NULL),
+                         CefV8Value::CreateFunction("progress", progress.get())),
+                    summary) != NO_ERROR) {
+        fprintf(stderr, "LoadPathStoreAsync failed\n");
+        return 1;
+    }
+    double loaded = SummaryCount(summary, "files");
+    PrintResult("LoadPathStoreAsync", Now() - start, (long)loaded);
+    if ((int)loaded != treeOptions.files || (size_t)SummaryCount(summary, "directories") != dirs.size() ||
+        progress->m_paths != treeOptions.files + (long)dirs.size()) {
+        fprintf(stderr, "LoadPathStoreAsync added %.0f files and %.0f directories, expected %d and %lu\n",
+                loaded, SummaryCount(summary, "directories"), treeOptions.files, (unsigned long)dirs.size());
+        return 1;
+    }
+
+    CefRefPtr<CefV8Value> found;
+    CefRefPtr<CefV8Value> dirArray = CefV8Value::CreateArray();
+    dirArray->SetValue(0, CefV8Value::CreateString(dirs[0]));
+    if (Call(handler, "FindStorePaths", Args(handle, dirArray), found) != NO_ERROR ||
+        Call(handler, "ListStoreChildren", Args(handle, found->GetValue(0)), retval) != NO_ERROR ||
+        retval->GetValue("ids")->GetArrayLength() != std::min(treeOptions.files, treeOptions.filesPerDir) ||
+        Call(handler, "GetStorePaths", Args(handle, found), retval) != NO_ERROR ||
+        retval->GetValue(0)->GetStringValue() != dirs[0] + "/") {
+        fprintf(stderr, "The loaded store does not list %s\n", dirs[0].c_str());
+        return 1;
+    }
+    Call(handler, "ClosePathStore", Args(handle), retval);
+    return 0;
+}
+
+namespace {
+
+// Calls |name| with each of |paths| as its only argument, plus |extra| if
+// it is set. Returns false if a call fails.
+bool CallForEach(CefRefPtr<CefV8Handler> handler, const char* name, const std::vector<CefRefPtr<CefV8Value> >& paths,
+                 CefRefPtr<CefV8Value> extra, double& seconds)
+{
+    CefRefPtr<CefV8Value> retval;
+    double start = Now();
+    for (size_t i = 0; i < paths.size(); i++) {
+        CefV8ValueList arguments = extra.get() ? Args(paths[i], extra) : Args(paths[i]);
+        if (Call(handler, name, arguments, retval) != NO_ERROR)
+            return false;
+    }
+    seconds = Now() - start;
+    return true;
+}
+
+} // namespace
+
+int RunHandlesBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    Project project;
+    if (!MakeProject(options, project))
+        return 1;
+
+    // Paths as JS holds them, as V8 strings made once
+    std::vector<CefRefPtr<CefV8Value> > strings;
+    CefRefPtr<CefV8Value> stringArray = CefV8Value::CreateArray();
+    for (int i = 0; i < options.files; i++) {
+        strings.push_back(CefV8Value::CreateString(project.files[i]));
+        stringArray->SetValue(i, strings.back());
+    }
+
+    CefRefPtr<CefV8Value> handleArray;
+    double start = Now();
+    if (Call(handler, "InternPaths", Args(stringArray), handleArray) != NO_ERROR ||
+        handleArray->GetArrayLength() != options.files) {
+        fprintf(stderr, "InternPaths failed\n");
+        return 1;
+    }
+    PrintResult("InternPaths", Now() - start, options.files);
+
+    std::vector<CefRefPtr<CefV8Value> > handles;
+    for (int i = 0; i < options.files; i++)
+        handles.push_back(handleArray->GetValue(i));
+
+    // The calls the project tree and the editor make most, by path and by
+    // handle
+    const char* const functions[] = { "GetFileInfo", "IsDirectory", "GetFileModificationTime", "ReadFile" };
+    CefRefPtr<CefV8Value> encoding = CefV8Value::CreateString("utf8");
+    for (int n = 0; n < options.iterations; n++) {
+        for (size_t f = 0; f < sizeof(functions) / sizeof(functions[0]); f++) {
+            CefRefPtr<CefV8Value> extra = strcmp(functions[f], "ReadFile") ? NULL : encoding;
+            double byPath, byHandle;
+            if (!CallForEach(handler, functions[f], strings, extra, byPath) ||
+                !CallForEach(handler, functions[f], handles, extra, byHandle)) {
+                fprintf(stderr, "%s failed\n", functions[f]);
+                return 1;
+            }
+            std::string label = std::string(functions[f]) + ", by path";
+            PrintResult(label.c_str(), byPath, options.files);
+            label = std::string(functions[f]) + ", by handle";
+            PrintResult(label.c_str(), byHandle, options.files);
+        }
+
+        // One call for every file
+        CefRefPtr<CefV8Value> byPath, byHandle;
+        start = Now();
+        if (Call(handler, "StatPaths", Args(stringArray), byPath) != NO_ERROR) {
+            fprintf(stderr, "StatPaths failed\n");
+            return 1;
+        }
+        PrintResult("StatPaths, by path", Now() - start, options.files);
+        start = Now();
+        if (Call(handler, "StatPaths", Args(handleArray), byHandle) != NO_ERROR) {
+            fprintf(stderr, "StatPaths failed\n");
+            return 1;
+        }
+        PrintResult("StatPaths, by handle", Now() - start, options.files);
+
+        // Both agree with GetFileInfo
+        for (int i = 0; i < options.files; i += std::max(1, options.files / 100)) {
+            CefRefPtr<CefV8Value> info;
+            Call(handler, "GetFileInfo", Args(strings[i]), info);
+            if (!byPath->GetValue(i)->IsObject() || !byHandle->GetValue(i)->IsObject() ||
+                byHandle->GetValue(i)->GetValue("size")->GetDoubleValue() != info->GetValue("size")->GetDoubleValue() ||
+                byHandle->GetValue(i)->GetValue("mtimeNsec")->GetIntValue() != info->GetValue("mtimeNsec")->GetIntValue() ||
+                byPath->GetValue(i)->GetValue("size")->GetDoubleValue() != info->GetValue("size")->GetDoubleValue()) {
+                fprintf(stderr, "StatPaths disagrees with GetFileInfo on %s\n",
+                        strings[i]->GetStringValue().ToString().c_str());
+                return 1;
+            }
+        }
+    }
+
+    // With the stat cache answering, no system call hides what converting
+    // the path costs
+    CefRefPtr<CefV8Value> retval;
+    start = Now();
+    if (Call(handler, "SetStatCacheRoot", Args(CefV8Value::CreateString(options.root)), retval) != NO_ERROR)
+        return 1;
+    while (!GetCacheStats(handler)->GetValue("active")->GetBoolValue()) {
+        if (Now() - start > 30) {
+            fprintf(stderr, "The stat cache did not start\n");
+            return 1;
+        }
+        usleep(1000);
+    }
+    double byPath, byHandle, ignored;
+    if (!CallForEach(handler, "GetFileInfo", strings, NULL, ignored) ||
+        !CallForEach(handler, "GetFileInfo", strings, NULL, byPath) ||
+        !CallForEach(handler, "GetFileInfo", handles, NULL, byHandle)) {
+        fprintf(stderr, "GetFileInfo failed\n");
+        return 1;
+    }
+    PrintResult("GetFileInfo cached, by path", byPath, options.files);
+    PrintResult("GetFileInfo cached, by handle", byHandle, options.files);
+    Call(handler, "SetStatCacheRoot", Args(CefV8Value::CreateString("")), retval);
+
+    // Interning a path again gives the same handle; a path that is not
+    // there gets its error; a released handle is refused
+    CefRefPtr<CefV8Value> again;
+    CefRefPtr<CefV8Value> one = CefV8Value::CreateArray();
+    one->SetValue(0, strings[0]);
+    CefRefPtr<CefV8Value> missing = CefV8Value::CreateArray();
+    missing->SetValue(0, CefV8Value::CreateString(options.root + "/missing/file.js"));
+    missing->SetValue(1, CefV8Value::CreateString("/"));
+    if (Call(handler, "InternPaths", Args(one), again) != NO_ERROR ||
+        again->GetValue(0)->GetIntValue() != handles[0]->GetIntValue() ||
+        Call(handler, "StatPaths", Args(missing), retval) != NO_ERROR ||
+        !retval->GetValue(0)->IsInt() || retval->GetValue(0)->GetIntValue() != ERR_NOT_FOUND ||
+        !retval->GetValue(1)->IsObject() || !retval->GetValue(1)->GetValue("isDirectory")->GetBoolValue()) {
+        fprintf(stderr, "InternPaths or StatPaths got a path wrong\n");
+        return 1;
+    }
+    size_t before = Brackets::PathHandleRegistry::GetInstance().GetHandleCount();
+    if (Call(handler, "ReleasePathHandles", Args(handleArray), retval) != NO_ERROR ||
+        retval->GetIntValue() != options.files ||
+        Brackets::PathHandleRegistry::GetInstance().GetHandleCount() != before - options.files ||
+        Call(handler, "GetFileInfo", Args(handles[0]), retval) != ERR_INVALID_PARAMS) {
+        fprintf(stderr, "ReleasePathHandles did not release the handles\n");
+        return 1;
+    }
+    return 0;
+}
+
+namespace {
+
+// Progress function passed to SyncProjectSnapshotAsync
+class SnapshotProgress : public CefV8Handler
+{
+public:
+    SnapshotProgress() : m_firstCall(0), m_calls(0), m_paths(0), m_added(0), m_removed(0), m_lists(false) {}
+
+    virtual bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+    {
+        if (!m_calls++)
+            m_firstCall = Now();
+        m_paths = (long)arguments[0]->GetDoubleValue();
+        if (arguments[1]->IsArray()) {
+            m_lists = true;
+            m_added += arguments[1]->GetArrayLength();
+            m_removed += arguments[2]->GetArrayLength();
+        }
+        return true;
+    }
+
+    double m_firstCall;
+    int m_calls;
+    long m_paths;
+    long m_added;
+    long m_removed;
+    bool m_lists;
+
+    IMPLEMENT_REFCOUNTING(SnapshotProgress);
+};
+
+// Sets the modification time of |path| and of the directories below it an
+// hour back, as if the project had been checked out a while ago
+void AgeDirectories(const std::string& path)
+{
+    struct stat buffer;
+    if (lstat(path.c_str(), &buffer) != 0 || !S_ISDIR(buffer.st_mode))
+        return;
+
+    std::vector<std::string> contents;
+    Brackets::FileSystem::ReadDir(path, contents);
+    for (size_t i = 0; i < contents.size(); i++)
+        AgeDirectories(path + "/" + contents[i]);
+
+    struct timeval times[2];
+    gettimeofday(&times[0], NULL);
+    times[0].tv_sec -= 3600;
+    times[1] = times[0];
+    utimes(path.c_str(), times);
+}
+
+// Syncs a new store with the snapshot and prints how long it took for the
+// store to be ready and for the sync to finish. Returns the summary, or NULL.
+CefRefPtr<CefV8Value> SyncSnapshot(CefRefPtr<CefV8Handler> handler, const char* label, const std::string& root,
+                                   const std::string& snapshotPath, CefRefPtr<CefV8Value> walkOptions,
+                                   CefRefPtr<CefV8Value>& store, CefRefPtr<SnapshotProgress>& progress)
+{
+    Call(handler, "CreatePathStore", CefV8ValueList(), store);
+    progress = new SnapshotProgress();
+    CefRefPtr<CefV8Value> summary;
+    double start = Now();
+    CefV8ValueList arguments = Args(store, CefV8Value::CreateString(root), CefV8Value::CreateString(snapshotPath),
+                                    walkOptions);
+    arguments.push_back(CefV8Value::CreateFunction("progress", progress.get()));
+    if (CallAndWait(handler, "SyncProjectSnapshotAsync", arguments, summary) != NO_ERROR) {
+        fprintf(stderr, "%s failed\n", label);
+        return NULL;
+    }
+    double elapsed = Now() - start;
+
+    long paths = (long)(SummaryCount(summary, "files") + SummaryCount(summary, "directories"));
+    PrintResult(label, elapsed, paths);
+    printf("  %s, %.0f directories reused, %.0f listed, %.0f added, %.0f removed, snapshot %s\n",
+           summary->GetValue("snapshot")->GetBoolValue() ? "from the snapshot" : "without a snapshot",
+           SummaryCount(summary, "reused"), SummaryCount(summary, "listed"), SummaryCount(summary, "added"),
+           SummaryCount(summary, "removed"), summary->GetValue("written")->GetBoolValue() ? "written" : "kept");
+    if (summary->GetValue("snapshot")->GetBoolValue())
+        printf("  store ready after %.2f ms\n", (progress->m_firstCall - start) * 1000);
+    return summary;
+}
+
+// The paths of the files below |id| in |store|, sorted
+bool GetStoreFiles(CefRefPtr<CefV8Handler> handler, CefRefPtr<CefV8Value> store, CefRefPtr<CefV8Value> id,
+                   std::vector<std::string>& paths)
+{
+    CefRefPtr<CefV8Value> ids;
+    CefRefPtr<CefV8Value> retval;
+    if (Call(handler, "ListStoreFiles", Args(store, id), ids) != NO_ERROR ||
+        Call(handler, "GetStorePaths", Args(store, ids), retval) != NO_ERROR)
+        return false;
+    paths.resize(retval->GetArrayLength());
+    for (size_t i = 0; i < paths.size(); i++)
+        paths[i] = retval->GetValue((int)i)->GetStringValue();
+    std::sort(paths.begin(), paths.end());
+    return true;
+}
+
+} // namespace
+
+int RunSnapshotBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    std::string root = options.root + "/project";
+    std::string snapshotPath = options.root + "/project.snapshot";
+    mkdir(root.c_str(), 0777);
+    double start = Now();
+    long expected = MakeMonorepo(root, options.files);
+    if (expected < 0) {
+        fprintf(stderr, "Could not create the project\n");
+        return 1;
+    }
+    AgeDirectories(root);
+    PrintResult("create project", Now() - start, expected);
+
+    CefRefPtr<CefV8Value> ignore = CefV8Value::CreateArray();
+    ignore->SetValue(0, CefV8Value::CreateString(".git"));
+    ignore->SetValue(1, CefV8Value::CreateString("node_modules"));
+    CefRefPtr<CefV8Value> walkOptions = CefV8Value::CreateObject(NULL);
+    walkOptions->SetValue("ignore", ignore, V8_PROPERTY_ATTRIBUTE_NONE);
+
+    // What opening the project costs without a snapshot
+    CefRefPtr<CefV8Value> store;
+    CefRefPtr<CefV8Value> summary;
+    CefRefPtr<CefV8Value> retval;
+    Call(handler, "CreatePathStore", CefV8ValueList(), store);
+    CefRefPtr<StoreProgress> loadProgress = new StoreProgress();
+    start = Now();
+    if (CallAndWait(handler, "LoadPathStoreAsync",
+                    Args(store, CefV8Value::CreateString(root), walkOptions,
+                         CefV8Value::CreateFunction("progress", loadProgress.get())),
+                    summary) != NO_ERROR) {
+        fprintf(stderr, "LoadPathStoreAsync failed\n");
+        return 1;
+    }
+    PrintResult("LoadPathStoreAsync", Now() - start,
+                (long)(SummaryCount(summary, "files") + SummaryCount(summary, "directories")));
+    Call(handler, "ClosePathStore", Args(store), retval);
+
+    CefRefPtr<SnapshotProgress> progress;
+    summary = SyncSnapshot(handler, "SyncProjectSnapshotAsync, first open", root, snapshotPath, walkOptions, store,
+                           progress);
+    if (!summary.get())
+        return 1;
+    std::string hash = summary->GetValue("hash")->GetStringValue();
+    printf("  snapshot of %.1f KB, hash %s\n", SummaryCount(summary, "size") / 1024, hash.c_str());
+    if (summary->GetValue("snapshot")->GetBoolValue() || !summary->GetValue("written")->GetBoolValue() ||
+        (long)SummaryCount(summary, "files") != expected || progress->m_lists) {
+        fprintf(stderr, "The first open found %.0f files, expected %ld, or did not write the snapshot\n",
+                SummaryCount(summary, "files"), expected);
+        return 1;
+    }
+    Call(handler, "ClosePathStore", Args(store), retval);
+
+    // Nothing changed: every directory comes from the snapshot and it is
+    // not written again
+    for (int n = 0; n < options.iterations; n++) {
+        summary = SyncSnapshot(handler, "SyncProjectSnapshotAsync, reopen", root, snapshotPath, walkOptions, store,
+                               progress);
+        if (!summary.get())
+            return 1;
+        if (!summary->GetValue("snapshot")->GetBoolValue() || SummaryCount(summary, "listed") != 0 ||
+            SummaryCount(summary, "added") != 0 || SummaryCount(summary, "removed") != 0 ||
+            summary->GetValue("written")->GetBoolValue() || summary->GetValue("hash")->GetStringValue() != hash ||
+            progress->m_paths != expected + (long)SummaryCount(summary, "directories")) {
+            fprintf(stderr, "Reopening the unchanged project did not come from the snapshot\n");
+            return 1;
+        }
+        Call(handler, "ClosePathStore", Args(store), retval);
+    }
+
+    // Changes made while the project was closed: a file added and one
+    // deleted, a directory added and one deleted, and a .gitignore edited
+    // in place, which leaves its directory's time alone
+    std::string src = root + "/packages/p000/src";
+    struct stat buffer;
+    if (stat((src + "/m04").c_str(), &buffer) != 0) {
+        fprintf(stderr, "The project needs --files 500 or more\n");
+        return 1;
+    }
+    mkdir((src + "/m02/added").c_str(), 0777);
+    if (!WriteSmallFile(src + "/m00/new.js", "new\n") || !WriteSmallFile(src + "/m02/added/a.js", "a\n") ||
+        !WriteSmallFile(src + "/m02/added/b.js", "b\n") ||
+        !WriteInPlace(root + "/packages/p000/.gitignore", "!keep.log\nsrc/m04/\n")) {
+        fprintf(stderr, "Could not change the project\n");
+        return 1;
+    }
+    unlink((src + "/m01/file000100.js").c_str());
+    RemoveTree(src + "/m03");
+
+    summary = SyncSnapshot(handler, "SyncProjectSnapshotAsync, changed", root, snapshotPath, walkOptions, store,
+                           progress);
+    if (!summary.get())
+        return 1;
+    // new.js, added/ and its two files; file000100.js, m03/ and m04/ with
+    // a hundred files each
+    if (SummaryCount(summary, "added") != 4 || SummaryCount(summary, "removed") != 203 ||
+        progress->m_added != 4 || progress->m_removed != 203 || !summary->GetValue("written")->GetBoolValue() ||
+        summary->GetValue("hash")->GetStringValue() == hash) {
+        fprintf(stderr, "The changes were reported as %.0f added and %.0f removed, expected 4 and 203\n",
+                SummaryCount(summary, "added"), SummaryCount(summary, "removed"));
+        return 1;
+    }
+
+    // The store ends up with what a walk from scratch finds
+    std::vector<std::string> synced, walked;
+    CefRefPtr<CefV8Value> fresh;
+    CefRefPtr<CefV8Value> loaded;
+    Call(handler, "CreatePathStore", CefV8ValueList(), fresh);
+    if (!GetStoreFiles(handler, store, summary->GetValue("id"), synced) ||
+        CallAndWait(handler, "LoadPathStoreAsync",
+                    Args(fresh, CefV8Value::CreateString(root), walkOptions,
+                         CefV8Value::CreateFunction("progress", loadProgress.get())),
+                    loaded) != NO_ERROR ||
+        !GetStoreFiles(handler, fresh, loaded->GetValue("id"), walked) || synced != walked ||
+        SummaryCount(summary, "directories") != SummaryCount(loaded, "directories")) {
+        fprintf(stderr, "The synced store has %lu files, a walk finds %lu\n", (unsigned long)synced.size(),
+                (unsigned long)walked.size());
+        return 1;
+    }
+    Call(handler, "ClosePathStore", Args(fresh), retval);
+    Call(handler, "ClosePathStore", Args(store), retval);
+
+    // The next open only lists again what changed shortly before the last
+    summary = SyncSnapshot(handler, "SyncProjectSnapshotAsync, after changes", root, snapshotPath, walkOptions,
+                           store, progress);
+    if (!summary.get())
+        return 1;
+    if (SummaryCount(summary, "added") != 0 || SummaryCount(summary, "removed") != 0) {
+        fprintf(stderr, "Reopening after the changes reported changes again\n");
+        return 1;
+    }
+    Call(handler, "ClosePathStore", Args(store), retval);
+    return 0;
+}
+
+namespace {
+
+// What the JS side worked out from the text of a file after reading it: the
+// line starts, line endings and indentation, found here by walking the text
+// as UTF-16 code units the way a JS string is indexed
+struct ReferenceLayout {
+    ReferenceLayout() : lf(0), crlf(0), cr(0), tabLines(0), spaceLines(0) {}
+
+    std::vector<unsigned int> lineStarts;
+    int lf, crlf, cr;
+    int tabLines, spaceLines;
+};
+
+void ScanLayout(const std::vector<unsigned short>& units, ReferenceLayout& layout)
+{
+    size_t start = 0;
+    layout.lineStarts.push_back(0);
+    for (size_t i = 0; i <= units.size(); i++) {
+        bool atEnd = i == units.size();
+        if (!atEnd && units[i] != '\n' && units[i] != '\r')
+            continue;
+
+        size_t indent = start;
+        while (indent < i && (units[indent] == ' ' || units[indent] == '\t'))
+            indent++;
+        if (indent > start && indent < i) {
+            if (units[start] == '\t')
+                layout.tabLines++;
+            else
+                layout.spaceLines++;
+        }
+        if (atEnd)
+            break;
+
+        if (units[i] == '\r' && i + 1 < units.size() && units[i + 1] == '\n') {
+            layout.crlf++;
+            i++;
+        } else if (units[i] == '\r') {
+            layout.cr++;
+        } else {
+            layout.lf++;
+        }
+        start = i + 1;
+        layout.lineStarts.push_back((unsigned int)start);
+    }
+}
+
+// Reads the line starts of a ReadFile result, a list either way
+bool GetLineStarts(CefRefPtr<CefV8Value> result, std::vector<unsigned int>& starts)
+{
+    starts.clear();
+    CefRefPtr<CefV8Value> list = result->GetValue("lineStarts");
+    if (list->IsString()) {
+        std::string json = list->GetStringValue();
+        const char* p = json.c_str();
+        while (*p && *p != ']') {
+            p++;
+            if (*p == ']')
+                break;
+            char* end = NULL;
+            starts.push_back((unsigned int)strtoul(p, &end, 10));
+            p = end;
+        }
+        return true;
+    }
+    if (!list->IsArray())
+        return false;
+    for (int i = 0; i < list->GetArrayLength(); i++)
+        starts.push_back((unsigned int)list->GetValue(i)->GetIntValue());
+    return true;
+}
+
+// Reads |path| with its layout and checks it against ScanLayout
+bool CheckLayout(CefRefPtr<CefV8Handler> handler, const std::string& path, const char* name)
+{
+    CefRefPtr<CefV8Value> retval;
+    int error = Call(handler, "ReadFile",
+                     Args(CefV8Value::CreateString(path), CefV8Value::CreateString("utf8"),
+                          CefV8Value::CreateBool(true)), retval);
+    if (error != NO_ERROR || !retval.get() || !retval->IsObject()) {
+        fprintf(stderr, "ReadFile of %s with its layout failed with %d\n", name, error);
+        return false;
+    }
+
+    std::vector<unsigned short> units;
+    ToUTF16(retval->GetValue("data")->GetStringValue(), units);
+    ReferenceLayout expected;
+    ScanLayout(units, expected);
+
+    std::vector<unsigned int> starts;
+    if (!GetLineStarts(retval, starts) || starts != expected.lineStarts ||
+        retval->GetValue("lf")->GetIntValue() != expected.lf ||
+        retval->GetValue("crlf")->GetIntValue() != expected.crlf ||
+        retval->GetValue("cr")->GetIntValue() != expected.cr ||
+        retval->GetValue("tabLines")->GetIntValue() != expected.tabLines ||
+        retval->GetValue("spaceLines")->GetIntValue() != expected.spaceLines) {
+        fprintf(stderr, "The layout of %s has %lu lines, %d LF, %d CRLF, %d CR; expected %lu, %d, %d, %d\n",
+                name, (unsigned long)starts.size(), retval->GetValue("lf")->GetIntValue(),
+                retval->GetValue("crlf")->GetIntValue(), retval->GetValue("cr")->GetIntValue(),
+                (unsigned long)expected.lineStarts.size(), expected.lf, expected.crlf, expected.cr);
+        return false;
+    }
+    return true;
+}
+
+// Writes |size| bytes of code indented with four spaces, with CRLF line
+// endings except for every hundredth line, accented letters and characters
+// outside the BMP, which are two code units in JS
+bool MakeSourceFile(const std::string& path, long long size)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    bool ok = true;
+    long long written = 0;
+    for (long i = 0; ok && written < size; i++) {
+        char block[512];
+        int length = snprintf(block, sizeof(block),
+                              "function handler%06ld(request) {\r\n"
+                              "    if (request.path === \"/caf\xC3\xA9/%ld\") {\r\n"
+                              "        return respond(request, \"\xF0\x9F\x98\x80 \xE2\x82\xAC%ld\");\r\n"
+                              "    }\r\n"
+                              "\r\n"
+                              "    // Falls back to the default handler%s"
+                              "    return next(request);\r\n"
+                              "}\r\n",
+                              i, i % 977, i % 31, i % 100 == 0 ? "\n" : "\r\n");
+        ok = fwrite(block, 1, length, file) == (size_t)length;
+        written += length;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+} // namespace
+
+int RunLayoutBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    const char* cases[][2] = {
+        { "empty", "" },
+        { "one line", "no line ending" },
+        { "LF", "a\nb\n" },
+        { "CR at the end", "a\r" },
+        { "mixed endings", "a\rb\r\nc\n\r\r\nd" },
+        { "blank lines", "\n\r\n  \n\t\n" },
+        { "tabs", "x {\n\ty;\n\t\tz;\n\t \tw;\n}\n" },
+        { "multibyte", "\xC3\xA9\n\xE2\x82\xAC\xF0\x9F\x98\x80\r\n  \xF0\x9F\x98\x80\r" },
+    };
+    std::string path = options.root + "/layout.txt";
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (!WriteInPlace(path, cases[i][1]) || !CheckLayout(handler, path, cases[i][0]))
+            return 1;
+    }
+
+    // A CRLF split between the 1 MB chunks ReadFile reads
+    std::string split(1024 * 1024 - 1, 'a');
+    split += "\r\nb";
+    if (!WriteInPlace(path, split) || !CheckLayout(handler, path, "a CRLF across chunks"))
+        return 1;
+
+    std::string sourcePath = options.root + "/source.js";
+    if (!MakeSourceFile(sourcePath, (long long)options.fileSizeMB * 1024 * 1024)) {
+        fprintf(stderr, "Could not create %s\n", sourcePath.c_str());
+        return 1;
+    }
+    if (!CheckLayout(handler, sourcePath, "the source file"))
+        return 1;
+
+    for (int i = 0; i < options.iterations; i++) {
+        CefRefPtr<CefV8Value> retval;
+        double start = Now();
+        int error = Call(handler, "ReadFile",
+                         Args(CefV8Value::CreateString(sourcePath), CefV8Value::CreateString("utf8")), retval);
+        double readSeconds = Now() - start;
+        if (error != NO_ERROR) {
+            fprintf(stderr, "ReadFile of %s failed with %d\n", sourcePath.c_str(), error);
+            return 1;
+        }
+
+        // The text as JS sees it, scanned again for lines afterwards
+        std::vector<unsigned short> units;
+        ToUTF16(retval->GetStringValue(), units);
+        retval = NULL;
+        ReferenceLayout expected;
+        start = Now();
+        ScanLayout(units, expected);
+        double scanSeconds = Now() - start;
+
+        start = Now();
+        error = Call(handler, "ReadFile",
+                     Args(CefV8Value::CreateString(sourcePath), CefV8Value::CreateString("utf8"),
+                          CefV8Value::CreateBool(true)), retval);
+        double layoutSeconds = Now() - start;
+        if (error != NO_ERROR) {
+            fprintf(stderr, "ReadFile of %s with its layout failed with %d\n", sourcePath.c_str(), error);
+            return 1;
+        }
+
+        printf("%lu lines, %d CRLF, %d LF, indent %s %d\n", (unsigned long)expected.lineStarts.size(),
+               retval->GetValue("crlf")->GetIntValue(), retval->GetValue("lf")->GetIntValue(),
+               retval->GetValue("indent")->IsString() ?
+               retval->GetValue("indent")->GetStringValue().ToString().c_str() : "none",
+               retval->GetValue("indentSize")->GetIntValue());
+        if (retval->GetValue("lineEnding")->GetStringValue() != "\r\n" ||
+            retval->GetValue("indent")->GetStringValue() != "spaces" ||
+            retval->GetValue("indentSize")->GetIntValue() != 4) {
+            fprintf(stderr, "The source file was not found to use CRLF and four spaces\n");
+            return 1;
+        }
+
+        PrintResult("ReadFile", readSeconds, 1);
+        PrintResult("  then a scan of the UTF-16 text", scanSeconds, 1);
+        PrintResult("ReadFile with its layout", layoutSeconds, 1);
+    }
+
+    return 0;
+}
+
+namespace {
+
+void SplitLines(const std::string& text, std::vector<std::string>& lines)
+{
+    lines.clear();
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        end = end == std::string::npos ? text.size() : end + 1;
+        lines.push_back(text.substr(start, end - start));
+        start = end;
+    }
+}
+
+std::string JoinLines(const std::vector<std::string>& lines)
+{
+    std::string text;
+    for (size_t i = 0; i < lines.size(); i++)
+        text += lines[i];
+    return text;
+}
+
+// Diffs |oldText| against the file at |path| with DiffFileAsync and checks
+// that its hunks turn one into the other. Returns the result, or NULL.
+CefRefPtr<CefV8Value> DiffAndCheck(CefRefPtr<CefV8Handler> handler, const char* label, const std::string& path,
+                                   const std::string& oldText, const std::string& newText)
+{
+    CefRefPtr<CefV8Value> result;
+    double start = Now();
+    int error = CallAndWait(handler, "DiffFileAsync",
+                            Args(CefV8Value::CreateString(path), CefV8Value::CreateString(oldText),
+                                 CefV8Value::CreateString("utf8")), result);
+    double seconds = Now() - start;
+    if (error != NO_ERROR || !result.get()) {
+        fprintf(stderr, "%s: DiffFileAsync failed with %d\n", label, error);
+        return NULL;
+    }
+
+    CefRefPtr<CefV8Value> hunks = result->GetValue("hunks");
+    CefRefPtr<CefV8Value> texts = result->GetValue("texts");
+    std::vector<std::string> lines, added;
+    SplitLines(oldText, lines);
+    std::string applied;
+    size_t next = 0;
+    long changed = 0;
+    for (int i = 0; i < texts->GetArrayLength(); i++) {
+        size_t oldStart = (size_t)hunks->GetValue(i * 4)->GetIntValue();
+        size_t oldCount = (size_t)hunks->GetValue(i * 4 + 1)->GetIntValue();
+        std::string text = texts->GetValue(i)->GetStringValue();
+        SplitLines(text, added);
+        if ((int)added.size() != hunks->GetValue(i * 4 + 3)->GetIntValue() || oldStart < next ||
+            oldStart + oldCount > lines.size()) {
+            fprintf(stderr, "%s: hunk %d does not fit\n", label, i);
+            return NULL;
+        }
+        for (; next < oldStart; next++)
+            applied += lines[next];
+        applied += text;
+        next += oldCount;
+        changed += (long)(oldCount + added.size());
+    }
+    for (; next < lines.size(); next++)
+        applied += lines[next];
+    if (applied != newText) {
+        fprintf(stderr, "%s: the hunks do not turn the document into the file\n", label);
+        return NULL;
+    }
+
+    char line[128];
+    snprintf(line, sizeof(line), "DiffFileAsync, %s", label);
+    PrintResult(line, seconds, 1);
+    printf("  %d hunks, %ld lines removed or added\n", texts->GetArrayLength(), changed);
+    return result;
+}
+
+} // namespace
+
+int RunDiffBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    std::string path = options.root + "/source.js";
+    std::string original;
+    if (!MakeSourceFile(path, (long long)options.fileSizeMB * 1024 * 1024) || !ReadWhole(path, original)) {
+        fprintf(stderr, "Could not create %s\n", path.c_str());
+        return 1;
+    }
+    std::vector<std::string> lines;
+    SplitLines(original, lines);
+    printf("%lu lines\n", (unsigned long)lines.size());
+
+    // What the JS side started with: the whole file read back in
+    CefRefPtr<CefV8Value> retval;
+    double start = Now();
+    int error = Call(handler, "ReadFile",
+                     Args(CefV8Value::CreateString(path), CefV8Value::CreateString("utf8")), retval);
+    PrintResult("ReadFile", Now() - start, 1);
+    if (error != NO_ERROR) {
+        fprintf(stderr, "ReadFile of %s failed with %d\n", path.c_str(), error);
+        return 1;
+    }
+    retval = NULL;
+
+    CefRefPtr<CefV8Value> result = DiffAndCheck(handler, "unchanged", path, original, original);
+    if (!result.get())
+        return 1;
+    if (result->GetValue("texts")->GetArrayLength() != 0) {
+        fprintf(stderr, "An unchanged file has hunks\n");
+        return 1;
+    }
+
+    // Twenty edits spread over the file, each a hunk of its own: ten lines
+    // replaced, five inserted and five deleted
+    std::vector<std::string> edited = lines;
+    for (int k = 19; k >= 0; k--) {
+        size_t at = lines.size() / 20 * k + 3;
+        char text[64];
+        snprintf(text, sizeof(text), "edit %d\r\n", k);
+        if (k % 2 == 0)
+            edited[at] = text;
+        else if (k % 4 == 1)
+            edited.insert(edited.begin() + at, text);
+        else
+            edited.erase(edited.begin() + at);
+    }
+    std::string text = JoinLines(edited);
+    if (!WriteInPlace(path, text))
+        return 1;
+    result = DiffAndCheck(handler, "twenty edits", path, original, text);
+    if (!result.get())
+        return 1;
+    if (result->GetValue("texts")->GetArrayLength() != 20) {
+        fprintf(stderr, "Twenty edits came back as %d hunks\n", result->GetValue("texts")->GetArrayLength());
+        return 1;
+    }
+
+    // Every hundredth line changed, as after a reformat
+    edited = lines;
+    for (size_t i = 0; i < edited.size(); i += 100)
+        edited[i] = "// reformatted\r\n";
+    text = JoinLines(edited);
+    if (!WriteInPlace(path, text) || !DiffAndCheck(handler, "every 100th line", path, original, text).get())
+        return 1;
+
+    // No line in common, every one of them set aside before the diff
+    edited = lines;
+    for (size_t i = 0; i < edited.size(); i++)
+        edited[i] = "\t" + edited[i];
+    text = JoinLines(edited);
+    if (!WriteInPlace(path, text) || !DiffAndCheck(handler, "every line", path, original, text).get())
+        return 1;
+
+    return 0;
+}
+
+
+namespace {
+
+// Hashes |path| with HashFileAsync, prints the time it took and checks the
+// digest against |expected|. Returns the result, or NULL.
+CefRefPtr<CefV8Value> HashAndCheck(CefRefPtr<CefV8Handler> handler, const char* label, const std::string& path,
+                                   const char* algorithm, CefRefPtr<CefV8Value> hashOptions,
+                                   const std::string& expected)
+{
+    CefRefPtr<CefV8Value> result;
+    double start = Now();
+    int error = CallAndWait(handler, "HashFileAsync",
+                            Args(CefV8Value::CreateString(path), CefV8Value::CreateString(algorithm), hashOptions),
+                            result);
+    double seconds = Now() - start;
+    if (error != NO_ERROR || !result.get()) {
+        fprintf(stderr, "%s: HashFileAsync failed with %d\n", label, error);
+        return NULL;
+    }
+    if (result->GetValue("hash")->GetStringValue().ToString() != expected) {
+        fprintf(stderr, "%s: HashFileAsync gave %s instead of %s\n", label,
+                result->GetValue("hash")->GetStringValue().ToString().c_str(), expected.c_str());
+        return NULL;
+    }
+
+    PrintResult(label, seconds, 1);
+    double bytes = result->GetValue("length")->GetDoubleValue();
+    double time = result->GetValue("time")->GetDoubleValue();
+    if (result->GetValue("cached")->GetBoolValue())
+        printf("  cached\n");
+    else if (time > 0 && bytes >= 1024 * 1024)
+        printf("  %.0f MB hashed at %.0f MB/s\n", bytes / (1024 * 1024), bytes / (1024 * 1024) / (time / 1000));
+    return result;
+}
+
+CefRefPtr<CefV8Value> HashOptions(bool bypassCache)
+{
+    CefRefPtr<CefV8Value> hashOptions = CefV8Value::CreateObject(NULL);
+    hashOptions->SetValue("bypassCache", CefV8Value::CreateBool(bypassCache), V8_PROPERTY_ATTRIBUTE_NONE);
+    return hashOptions;
+}
+
+} // namespace
+
+int RunHashBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    using Brackets::FileSystem::HashAlgorithm;
+    using Brackets::FileSystem::HashData;
+
+    // Digests published for each algorithm
+    struct {
+        const char* algorithm;
+        const char* text;
+        const char* digest;
+    } const vectors[] = {
+        { "xxh3", "", "2d06800538d394c2" },
+        { "sha1", "abc", "a9993e364706816aba3e25717850c26c9cd0d89d" },
+        { "sha256", "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+    };
+    const size_t algorithmCount = sizeof(vectors) / sizeof(vectors[0]);
+    CefRefPtr<CefV8Value> retval;
+    for (size_t a = 0; a < algorithmCount; a++) {
+        if (Call(handler, "HashText", Args(CefV8Value::CreateString(vectors[a].text),
+                                           CefV8Value::CreateString(vectors[a].algorithm)), retval) != NO_ERROR ||
+            retval->GetStringValue().ToString() != vectors[a].digest) {
+            fprintf(stderr, "HashText gets the %s digest of \"%s\" wrong\n", vectors[a].algorithm, vectors[a].text);
+            return 1;
+        }
+    }
+
+    std::string path = options.root + "/source.js";
+    std::string original;
+    if (!MakeSourceFile(path, (long long)options.fileSizeMB * 1024 * 1024) || !ReadWhole(path, original)) {
+        fprintf(stderr, "Could not create %s\n", path.c_str());
+        return 1;
+    }
+    AgeFile(path, 3600);
+
+    for (size_t a = 0; a < algorithmCount; a++) {
+        const char* algorithm = vectors[a].algorithm;
+        std::string expected = HashData((HashAlgorithm)a, original.data(), original.size());
+
+        // What the JS side would do without it: read the file in and hash
+        // the text
+        double start = Now();
+        if (Call(handler, "ReadFile", Args(CefV8Value::CreateString(path), CefV8Value::CreateString("utf8")),
+                 retval) != NO_ERROR ||
+            Call(handler, "HashText", Args(retval, CefV8Value::CreateString(algorithm)), retval) != NO_ERROR ||
+            retval->GetStringValue().ToString() != expected) {
+            fprintf(stderr, "ReadFile and HashText of %s failed\n", path.c_str());
+            return 1;
+        }
+        std::string label = std::string("ReadFile and HashText, ") + algorithm;
+        PrintResult(label.c_str(), Now() - start, 2);
+        retval = NULL;
+
+        label = std::string("HashFileAsync, ") + algorithm;
+        if (!HashAndCheck(handler, label.c_str(), path, algorithm, HashOptions(true), expected).get())
+            return 1;
+        // Bypassing leaves the cache alone, so the first lookup fills it
+        label = std::string("HashFileAsync, ") + algorithm + " filling the cache";
+        if (!HashAndCheck(handler, label.c_str(), path, algorithm, HashOptions(false), expected).get())
+            return 1;
+        label = std::string("HashFileAsync, ") + algorithm + " again";
+        CefRefPtr<CefV8Value> result = HashAndCheck(handler, label.c_str(), path, algorithm, HashOptions(false),
+                                                    expected);
+        if (!result.get())
+            return 1;
+        if (!result->GetValue("cached")->GetBoolValue()) {
+            fprintf(stderr, "The %s digest of an unchanged file was not cached\n", algorithm);
+            return 1;
+        }
+    }
+
+    // A range in the middle, and one that runs past the end
+    size_t offset = original.size() / 3 - 5;
+    CefRefPtr<CefV8Value> range = CefV8Value::CreateObject(NULL);
+    range->SetValue("offset", CefV8Value::CreateDouble((double)offset), V8_PROPERTY_ATTRIBUTE_NONE);
+    range->SetValue("length", CefV8Value::CreateInt(1024 * 1024), V8_PROPERTY_ATTRIBUTE_NONE);
+    std::string expected = HashData(Brackets::FileSystem::HASH_XXH3, original.data() + offset,
+                                    std::min(original.size() - offset, (size_t)1024 * 1024));
+    if (!HashAndCheck(handler, "HashFileAsync, a range", path, "xxh3", range, expected).get())
+        return 1;
+    range->SetValue("offset", CefV8Value::CreateDouble(original.size() - 100.0), V8_PROPERTY_ATTRIBUTE_NONE);
+    expected = HashData(Brackets::FileSystem::HASH_XXH3, original.data() + original.size() - 100, 100);
+    CefRefPtr<CefV8Value> result = HashAndCheck(handler, "HashFileAsync, past the end", path, "xxh3", range, expected);
+    if (!result.get())
+        return 1;
+    if (result->GetValue("length")->GetDoubleValue() != 100) {
+        fprintf(stderr, "A range past the end was not cut\n");
+        return 1;
+    }
+
+    // A change that keeps the size is found by the modification time
+    std::string changed = original;
+    changed[changed.size() / 2] = changed[changed.size() / 2] == 'x' ? 'y' : 'x';
+    if (!WriteInPlace(path, changed))
+        return 1;
+    AgeFile(path, 1800);
+    expected = HashData(Brackets::FileSystem::HASH_XXH3, changed.data(), changed.size());
+    result = HashAndCheck(handler, "HashFileAsync, changed", path, "xxh3", HashOptions(false), expected);
+    if (!result.get())
+        return 1;
+    if (result->GetValue("cached")->GetBoolValue()) {
+        fprintf(stderr, "A changed file got the digest of its old contents\n");
+        return 1;
+    }
+
+    // A file written just now could still change within the same
+    // modification time, so its digest is not kept
+    std::string fresh = options.root + "/fresh.js";
+    if (!WriteInPlace(fresh, "var fresh = true;\n"))
+        return 1;
+    expected = HashData(Brackets::FileSystem::HASH_XXH3, "var fresh = true;\n", 18);
+    if (!HashAndCheck(handler, "HashFileAsync, a new file", fresh, "xxh3", HashOptions(false), expected).get())
+        return 1;
+    result = HashAndCheck(handler, "HashFileAsync, a new file again", fresh, "xxh3", HashOptions(false), expected);
+    if (!result.get())
+        return 1;
+    if (result->GetValue("cached")->GetBoolValue()) {
+        fprintf(stderr, "The digest of a file written just now was cached\n");
+        return 1;
+    }
+
+    // The files of a project, as when the window gets the focus back
+    Project project;
+    if (!MakeProject(options, project))
+        return 1;
+    const std::vector<std::string>& paths = project.files;
+    CefRefPtr<CefV8Value> pathArray = CefV8Value::CreateArray();
+    for (int i = 0; i < options.files; i++) {
+        AgeFile(paths[i], 3600);
+        pathArray->SetValue(i, CefV8Value::CreateString(paths[i]));
+    }
+
+    std::vector<CefString> digests;
+    double start = Now();
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (CallAndWait(handler, "HashFileAsync", Args(CefV8Value::CreateString(paths[i]),
+                                                       CefV8Value::CreateString("xxh3"), HashOptions(true)),
+                        result) != NO_ERROR) {
+            fprintf(stderr, "HashFileAsync of %s failed\n", paths[i].c_str());
+            return 1;
+        }
+        digests.push_back(result->GetValue("hash")->GetStringValue());
+    }
+    PrintResult("HashFileAsync, one file at a time", Now() - start, options.files);
+
+    const char* const passes[] = { "HashFilesAsync", "HashFilesAsync filling the cache", "HashFilesAsync again" };
+    for (int pass = 0; pass < 3; pass++) {
+        start = Now();
+        CefRefPtr<CefV8Value> results;
+        if (CallAndWait(handler, "HashFilesAsync", Args(pathArray, CefV8Value::CreateString("xxh3"),
+                                                        HashOptions(pass == 0)), results) != NO_ERROR ||
+            results->GetArrayLength() != options.files) {
+            fprintf(stderr, "HashFilesAsync failed\n");
+            return 1;
+        }
+        PrintResult(passes[pass], Now() - start, options.files);
+
+        for (int i = 0; i < options.files; i++) {
+            CefRefPtr<CefV8Value> item = results->GetValue(i);
+            if (!item->IsObject() || (pass == 2 && !item->GetValue("cached")->GetBoolValue())) {
+                fprintf(stderr, "HashFilesAsync did not hash %s%s\n", paths[i].c_str(),
+                        item->IsObject() ? " from the cache" : "");
+                return 1;
+            }
+            if (item->GetValue("hash")->GetStringValue() != digests[i]) {
+                fprintf(stderr, "HashFilesAsync and HashFileAsync disagree on %s\n", paths[i].c_str());
+                return 1;
+            }
+        }
+    }
+
+    Call(handler, "GetHashCacheStats", CefV8ValueList(), retval);
+    double bytes = retval->GetValue("bytes")->GetDoubleValue();
+    double time = retval->GetValue("time")->GetDoubleValue();
+    printf("Hash cache: %.0f hits, %.0f misses, %.0f bypassed, %.0f entries, %.0f MB read at %.0f MB/s\n",
+           retval->GetValue("hits")->GetDoubleValue(), retval->GetValue("misses")->GetDoubleValue(),
+           retval->GetValue("bypassed")->GetDoubleValue(), retval->GetValue("entries")->GetDoubleValue(),
+           bytes / (1024 * 1024), time > 0 ? bytes / (1024 * 1024) / (time / 1000) : 0.0);
+    return 0;
+}
+
+namespace {
+
+// Reads |path| with ReadFile and checks that it gives |expected|
+bool ReadAndCheck(CefRefPtr<CefV8Handler> handler, const std::string& path, const std::string& expected)
+{
+    CefRefPtr<CefV8Value> retval;
+    if (Call(handler, "ReadFile", Args(CefV8Value::CreateString(path), CefV8Value::CreateString("utf8")),
+             retval) != NO_ERROR) {
+        fprintf(stderr, "ReadFile of %s failed\n", path.c_str());
+        return false;
+    }
+    if (retval->GetStringValue().ToString() != expected) {
+        fprintf(stderr, "ReadFile of %s gave the wrong contents\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+double GetCounter(CefRefPtr<CefV8Handler> handler, const char* name)
+{
+    CefRefPtr<CefV8Value> stats;
+    Call(handler, "GetContentCacheStats", CefV8ValueList(), stats);
+    return stats->GetValue(name)->GetDoubleValue();
+}
+
+} // namespace
+
+int RunContentCacheBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    const int documents = 200;
+    const size_t documentSize = 64 * 1024;
+    std::vector<std::string> paths;
+    std::vector<std::string> texts;
+    for (int i = 0; i < documents; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "/document%03d.js", i);
+        std::string contents = MakeDocumentText(i * 10000L, documentSize);
+        paths.push_back(options.root + name);
+        texts.push_back(contents);
+        if (!WriteInPlace(paths.back(), contents)) {
+            fprintf(stderr, "Could not create %s\n", paths.back().c_str());
+            return 1;
+        }
+        AgeFile(paths.back(), 3600);
+    }
+
+    CefRefPtr<CefV8Value> retval;
+    const char* const labels[] = { "ReadFile, no cache", "ReadFile, filling the cache", "ReadFile, cached" };
+    for (int pass = 0; pass < 3; pass++) {
+        Call(handler, "SetContentCacheBudget",
+             Args(CefV8Value::CreateDouble(pass == 0 ? 0 : 64.0 * 1024 * 1024)), retval);
+        double start = Now();
+        for (int n = 0; n < (pass == 1 ? 1 : options.iterations); n++) {
+            for (int i = 0; i < documents; i++) {
+                if (!ReadAndCheck(handler, paths[i], texts[i]))
+                    return 1;
+            }
+        }
+        PrintResult(labels[pass], Now() - start, documents * 2 * (pass == 1 ? 1 : options.iterations));
+    }
+    if (GetCounter(handler, "entries") != documents) {
+        fprintf(stderr, "The cache did not keep every document\n");
+        return 1;
+    }
+
+    // Every window's reads go through the same cache, from any thread
+    double hits = GetCounter(handler, "hits");
+    double issueTime;
+    double start = Now();
+    if (!RunAsync(handler, "ReadFileAsync", paths, CefV8Value::CreateString("utf8"), issueTime)) {
+        fprintf(stderr, "ReadFileAsync failed\n");
+        return 1;
+    }
+    PrintResult("ReadFileAsync, all at once, cached", Now() - start, documents);
+    if (GetCounter(handler, "hits") - hits != documents) {
+        fprintf(stderr, "ReadFileAsync did not read from the cache\n");
+        return 1;
+    }
+
+    // A change that keeps the size is found by the modification time
+    std::string changed = texts[0];
+    changed[changed.size() / 2] = changed[changed.size() / 2] == 'x' ? 'y' : 'x';
+    if (!WriteInPlace(paths[0], changed))
+        return 1;
+    AgeFile(paths[0], 1800);
+    if (!ReadAndCheck(handler, paths[0], changed))
+        return 1;
+    if (GetCounter(handler, "stale") != 1) {
+        fprintf(stderr, "The changed file was not found stale\n");
+        return 1;
+    }
+    texts[0] = changed;
+
+    // A save drops the file, and a file written just now is not kept
+    if (Call(handler, "WriteFile", Args(CefV8Value::CreateString(paths[1]), CefV8Value::CreateString("saved"),
+                                        CefV8Value::CreateString("utf8")), retval) != NO_ERROR ||
+        !ReadAndCheck(handler, paths[1], "saved") || !ReadAndCheck(handler, paths[1], "saved")) {
+        fprintf(stderr, "A file saved through WriteFile was not read back\n");
+        return 1;
+    }
+    if (GetCounter(handler, "entries") != documents - 1) {
+        fprintf(stderr, "A file written just now was cached\n");
+        return 1;
+    }
+    if (!WriteInPlace(paths[1], texts[1]))
+        return 1;
+    AgeFile(paths[1], 3600);
+
+    // Deleted files are dropped too
+    std::string deleted = options.root + "/deleted.js";
+    if (!WriteInPlace(deleted, "var deleted;\n"))
+        return 1;
+    AgeFile(deleted, 3600);
+    if (!ReadAndCheck(handler, deleted, "var deleted;\n") ||
+        Call(handler, "DeleteFileOrDirectory", Args(CefV8Value::CreateString(deleted)), retval) != NO_ERROR ||
+        Call(handler, "ReadFile", Args(CefV8Value::CreateString(deleted), CefV8Value::CreateString("utf8")),
+             retval) != ERR_NOT_FOUND) {
+        fprintf(stderr, "A deleted file could still be read\n");
+        return 1;
+    }
+
+    // With room for ten documents, the one read longest ago goes first
+    Call(handler, "SetContentCacheBudget", Args(CefV8Value::CreateDouble(10.5 * documentSize)), retval);
+    if (GetCounter(handler, "entries") > 10) {
+        fprintf(stderr, "Lowering the budget did not evict\n");
+        return 1;
+    }
+    for (int i = 0; i < 10; i++) {
+        if (!ReadAndCheck(handler, paths[i], texts[i]))
+            return 1;
+    }
+    double evictions = GetCounter(handler, "evictions");
+    hits = GetCounter(handler, "hits");
+    if (!ReadAndCheck(handler, paths[0], texts[0]) || !ReadAndCheck(handler, paths[10], texts[10]) ||
+        !ReadAndCheck(handler, paths[0], texts[0]) || !ReadAndCheck(handler, paths[2], texts[2]))
+        return 1;
+    if (GetCounter(handler, "hits") - hits != 3 || GetCounter(handler, "evictions") - evictions != 1) {
+        fprintf(stderr, "The cache did not evict the document read longest ago\n");
+        return 1;
+    }
+    if (!ReadAndCheck(handler, paths[1], texts[1]) || GetCounter(handler, "hits") - hits != 3) {
+        fprintf(stderr, "The evicted document was still cached\n");
+        return 1;
+    }
+
+    start = Now();
+    for (int n = 0; n < options.iterations; n++) {
+        for (int i = 0; i < documents; i++) {
+            if (!ReadAndCheck(handler, paths[i], texts[i]))
+                return 1;
+        }
+    }
+    PrintResult("ReadFile, budget of ten documents", Now() - start, documents * 2 * options.iterations);
+
+    Call(handler, "SetContentCacheBudget", Args(CefV8Value::CreateDouble(64.0 * 1024 * 1024)), retval);
+    Call(handler, "GetContentCacheStats", CefV8ValueList(), retval);
+    printf("Content cache: %.0f hits, %.0f misses, hit ratio %.2f, %.0f stale, %.0f evictions, "
+           "%.0f entries, %.0f KB\n",
+           retval->GetValue("hits")->GetDoubleValue(), retval->GetValue("misses")->GetDoubleValue(),
+           retval->GetValue("hitRatio")->GetDoubleValue(), retval->GetValue("stale")->GetDoubleValue(),
+           retval->GetValue("evictions")->GetDoubleValue(), retval->GetValue("entries")->GetDoubleValue(),
+           retval->GetValue("bytes")->GetDoubleValue() / 1024);
+    return 0;
+}
+
+namespace {
+
+// A document being edited, as the JS side knows it: its text in UTF-16 code
+// units, which is what edit offsets count
+struct EditedDocument {
+    std::string path;
+    std::vector<unsigned short> units;
+
+    std::string GetText() const
+    {
+        std::string text;
+        Brackets::FileSystem::UTF16ToUTF8(units.empty() ? NULL : &units[0], units.size(), text);
+        return text;
+    }
+};
+
+// Makes a keystroke at a random place in |document|, mostly typing a
+// character, some of them not ASCII, and now and then deleting one, and
+// records it with JournalEdit, adding the time the call took to |callTime|.
+// Returns false if JournalEdit fails.
+bool Type(CefRefPtr<CefV8Handler> handler, EditedDocument& document, unsigned int& seed, double& callTime)
+{
+    const char* const keys[] = { "a", "e", " ", "\n", "x", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80" };
+    size_t offset = NextRandom(seed) % (document.units.size() + 1);
+    // Never splits a surrogate pair
+    while (offset > 0 && offset < document.units.size() && (document.units[offset] & 0xFC00) == 0xDC00)
+        offset--;
+
+    size_t removed = 0;
+    std::string text;
+    if (NextRandom(seed) % 8 == 0 && offset < document.units.size() &&
+        (document.units[offset] & 0xF800) != 0xD800)
+        removed = 1;
+    else
+        text = keys[NextRandom(seed) % (sizeof(keys) / sizeof(keys[0]))];
+
+    std::vector<unsigned short> inserted;
+    ToUTF16(text, inserted);
+    document.units.erase(document.units.begin() + offset, document.units.begin() + offset + removed);
+    document.units.insert(document.units.begin() + offset, inserted.begin(), inserted.end());
+
+    CefV8ValueList arguments = Args(CefV8Value::CreateString(document.path), CefV8Value::CreateDouble((double)offset),
+                                    CefV8Value::CreateDouble((double)removed), CefV8Value::CreateString(text));
+    CefRefPtr<CefV8Value> retval;
+    double start = Now();
+    int error = Call(handler, "JournalEdit", arguments, retval);
+    callTime += Now() - start;
+    return error == NO_ERROR;
+}
+
+// Replays the journal at |path| and returns the documents it recovered, by
+// path, or false if ReplayEditJournalAsync fails
+bool Replay(CefRefPtr<CefV8Handler> handler, const std::string& path,
+            std::map<std::string, CefRefPtr<CefV8Value> >& documents, bool& truncated)
+{
+    CefRefPtr<CefV8Value> result;
+    int error = CallAndWait(handler, "ReplayEditJournalAsync", Args(CefV8Value::CreateString(path)), result);
+    if (error != NO_ERROR) {
+        fprintf(stderr, "ReplayEditJournalAsync of %s failed with %d\n", path.c_str(), error);
+        return false;
+    }
+    documents.clear();
+    CefRefPtr<CefV8Value> list = result->GetValue("documents");
+    for (int i = 0; i < list->GetArrayLength(); i++) {
+        CefRefPtr<CefV8Value> document = list->GetValue(i);
+        documents[document->GetValue("path")->GetStringValue().ToString()] = document;
+    }
+    truncated = result->GetValue("truncated")->GetBoolValue();
+    return true;
+}
+
+// Checks that |documents| recovered |document| with its current text
+bool CheckRecovered(std::map<std::string, CefRefPtr<CefV8Value> >& documents, const EditedDocument& document,
+                    const char* label)
+{
+    std::map<std::string, CefRefPtr<CefV8Value> >::iterator it = documents.find(document.path);
+    if (it == documents.end() || !it->second->GetValue("text")->IsString()) {
+        fprintf(stderr, "%s: %s was not recovered\n", label, document.path.c_str());
+        return false;
+    }
+    if (it->second->GetValue("text")->GetStringValue().ToString() != document.GetText()) {
+        fprintf(stderr, "%s: %s was recovered with the wrong text\n", label, document.path.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int RunJournalBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    std::string journal = options.root + "/session.journal";
+    CefRefPtr<CefV8Value> journalValue = CefV8Value::CreateString(journal);
+    CefRefPtr<CefV8Value> retval;
+    unsigned int seed = 25;
+
+    // Autosaving a burst of ten keystrokes: the whole document with
+    // WriteFile, or the edits with the journal, waiting in both cases until
+    // they are on disk
+    const int bursts = 100 * options.iterations;
+    const size_t sizes[] = { 64 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+    const char* const sizeLabels[] = { "64 KB", "1 MB", "4 MB" };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        EditedDocument document;
+        document.path = options.root + "/document.js";
+        std::string text = MakeDocumentText(0, sizes[s]);
+        ToUTF16(text, document.units);
+
+        CefV8ValueList save = Args(CefV8Value::CreateString(document.path), CefV8Value::CreateString(""),
+                                   CefV8Value::CreateString("utf8"));
+        save.push_back(CefV8Value::CreateInt(Brackets::FileSystem::DURABILITY_DATA));
+        double start = Now();
+        for (int i = 0; i < bursts; i++) {
+            save[1] = CefV8Value::CreateString(document.GetText());
+            if (Call(handler, "WriteFile", save, retval) != NO_ERROR) {
+                fprintf(stderr, "WriteFile of %s failed\n", document.path.c_str());
+                return 1;
+            }
+        }
+        char label[96];
+        snprintf(label, sizeof(label), "%s document, WriteFile autosave", sizeLabels[s]);
+        PrintResult(label, Now() - start, bursts * 2);
+        printf("  %.1f MB written\n", (double)text.size() * bursts / (1024 * 1024));
+
+        if (Call(handler, "OpenEditJournal", Args(journalValue), retval) != NO_ERROR ||
+            Call(handler, "JournalSnapshot", Args(CefV8Value::CreateString(document.path),
+                                                  CefV8Value::CreateString(text)), retval) != NO_ERROR ||
+            CallAndWait(handler, "FlushEditJournalAsync", CefV8ValueList(), retval) != NO_ERROR) {
+            fprintf(stderr, "Could not start the journal at %s\n", journal.c_str());
+            return 1;
+        }
+        // Only the native calls are timed, not keeping the text here
+        double callTime = 0;
+        for (int i = 0; i < bursts; i++) {
+            for (int key = 0; key < 10; key++) {
+                if (!Type(handler, document, seed, callTime)) {
+                    fprintf(stderr, "JournalEdit failed\n");
+                    return 1;
+                }
+            }
+            start = Now();
+            if (CallAndWait(handler, "FlushEditJournalAsync", CefV8ValueList(), retval) != NO_ERROR) {
+                fprintf(stderr, "FlushEditJournalAsync failed\n");
+                return 1;
+            }
+            callTime += Now() - start;
+        }
+        snprintf(label, sizeof(label), "%s document, journaled autosave", sizeLabels[s]);
+        PrintResult(label, callTime, bursts * 22);
+        Call(handler, "GetEditJournalStats", CefV8ValueList(), retval);
+        printf("  %.1f KB written after the snapshot\n",
+               (retval->GetValue("bytes")->GetDoubleValue() - text.size()) / 1024);
+
+        std::map<std::string, CefRefPtr<CefV8Value> > documents;
+        bool truncated;
+        if (!Replay(handler, journal, documents, truncated) || !CheckRecovered(documents, document, sizeLabels[s]))
+            return 1;
+        if (Call(handler, "CloseEditJournal", Args(CefV8Value::CreateBool(true)), retval) != NO_ERROR ||
+            access(journal.c_str(), F_OK) == 0) {
+            fprintf(stderr, "Closing the journal did not discard it\n");
+            return 1;
+        }
+    }
+
+    // Typing at 200 keystrokes a second into two documents: the commit
+    // delay gathers the keystrokes into a few writes
+    EditedDocument typed;
+    typed.path = options.root + "/typed.js";
+    ToUTF16("function typed() {\n}\n", typed.units);
+    EditedDocument based;
+    based.path = options.root + "/based.js";
+    std::string basedText;
+    for (long line = 0; line < 2000; line++)
+        basedText += LogLine(line);
+    ToUTF16(basedText, based.units);
+    EditedDocument cleaned;
+    cleaned.path = options.root + "/cleaned.js";
+    ToUTF16("var cleaned;\n", cleaned.units);
+    if (!WriteInPlace(based.path, basedText))
+        return 1;
+    std::string digest = Brackets::FileSystem::HashData(Brackets::FileSystem::HASH_XXH3, basedText.data(),
+                                                        basedText.size());
+
+    if (Call(handler, "OpenEditJournal", Args(journalValue), retval) != NO_ERROR ||
+        Call(handler, "JournalSnapshot", Args(CefV8Value::CreateString(typed.path),
+                                              CefV8Value::CreateString(typed.GetText())), retval) != NO_ERROR ||
+        Call(handler, "JournalBase", Args(CefV8Value::CreateString(based.path),
+                                          CefV8Value::CreateString(digest)), retval) != NO_ERROR ||
+        Call(handler, "JournalSnapshot", Args(CefV8Value::CreateString(cleaned.path),
+                                              CefV8Value::CreateString(cleaned.GetText())), retval) != NO_ERROR) {
+        fprintf(stderr, "Could not start the journal at %s\n", journal.c_str());
+        return 1;
+    }
+    const int keystrokes = 400;
+    double callTime = 0;
+    for (int i = 0; i < keystrokes; i++) {
+        EditedDocument& document = i % 4 == 0 ? based : i % 4 == 1 ? cleaned : typed;
+        if (!Type(handler, document, seed, callTime)) {
+            fprintf(stderr, "JournalEdit failed\n");
+            return 1;
+        }
+        usleep(5000);
+    }
+    PrintResult("JournalEdit, typing", callTime, keystrokes * 2);
+    if (Call(handler, "JournalClean", Args(CefV8Value::CreateString(cleaned.path)), retval) != NO_ERROR ||
+        CallAndWait(handler, "FlushEditJournalAsync", CefV8ValueList(), retval) != NO_ERROR) {
+        fprintf(stderr, "JournalClean failed\n");
+        return 1;
+    }
+    Call(handler, "GetEditJournalStats", CefV8ValueList(), retval);
+    double recordsPerFlush = retval->GetValue("recordsPerFlush")->GetDoubleValue();
+    printf("  %.0f records in %.0f writes, %.1f per write, %.1f ms writing\n",
+           retval->GetValue("records")->GetDoubleValue(), retval->GetValue("flushes")->GetDoubleValue(),
+           recordsPerFlush, retval->GetValue("time")->GetDoubleValue());
+    if (recordsPerFlush < 2) {
+        fprintf(stderr, "The journal did not gather keystrokes into one write\n");
+        return 1;
+    }
+
+    // The session crashes: the journal is never closed
+    std::map<std::string, CefRefPtr<CefV8Value> > documents;
+    bool truncated;
+    double start = Now();
+    if (!Replay(handler, journal, documents, truncated))
+        return 1;
+    PrintResult("ReplayEditJournalAsync", Now() - start, 1);
+    if (!CheckRecovered(documents, typed, "Replay") || !CheckRecovered(documents, based, "Replay"))
+        return 1;
+    if (documents.size() != 2 || truncated) {
+        fprintf(stderr, "Replay recovered a document marked clean or found the journal cut short\n");
+        return 1;
+    }
+
+    // A crash in the middle of a write loses the last record and no more
+    std::vector<unsigned short> beforeLast = typed.units;
+    if (!Type(handler, typed, seed, callTime) ||
+        CallAndWait(handler, "FlushEditJournalAsync", CefV8ValueList(), retval) != NO_ERROR) {
+        fprintf(stderr, "JournalEdit failed\n");
+        return 1;
+    }
+    std::string contents;
+    std::string cut = options.root + "/cut.journal";
+    if (!ReadWhole(journal, contents) || !WriteInPlace(cut, contents.substr(0, contents.size() - 3)) ||
+        !Replay(handler, cut, documents, truncated))
+        return 1;
+    typed.units.swap(beforeLast);
+    if (!truncated || !CheckRecovered(documents, typed, "Truncated replay")) {
+        fprintf(stderr, "A journal cut short was not replayed up to its last whole record\n");
+        return 1;
+    }
+    typed.units.swap(beforeLast);
+
+    // A document recorded by its file's digest can't be rebuilt once the
+    // file changes
+    if (!WriteInPlace(based.path, "changed\n") || !Replay(handler, journal, documents, truncated))
+        return 1;
+    if (!documents[based.path]->GetValue("damaged")->GetBoolValue() ||
+        !documents[based.path]->GetValue("text")->IsNull() || !CheckRecovered(documents, typed, "Replay")) {
+        fprintf(stderr, "A document whose file changed was not reported damaged\n");
+        return 1;
+    }
+
+    if (CallAndWait(handler, "ReplayEditJournalAsync", Args(CefV8Value::CreateString(based.path)),
+                    retval) != ERR_CANT_READ) {
+        fprintf(stderr, "A file that is not a journal was replayed\n");
+        return 1;
+    }
+
+    Call(handler, "CloseEditJournal", Args(CefV8Value::CreateBool(true)), retval);
+    if (Call(handler, "JournalEdit", Args(CefV8Value::CreateString(typed.path), CefV8Value::CreateInt(0),
+                                          CefV8Value::CreateInt(0), CefV8Value::CreateString("x")),
+             retval) != ERR_CANT_WRITE) {
+        fprintf(stderr, "JournalEdit worked with no journal open\n");
+        return 1;
+    }
+    return 0;
+}
+
+namespace {
+
+// Text like source code with a comment in French here and there, and for
+// encodings that can hold them a euro sign and an emoji
+std::string MakeEncodingText(size_t size, bool latin1)
+{
+    std::string text;
+    text.reserve(size + 128);
+    char line[128];
+    for (long i = 0; text.size() < size; i++) {
+        if (i % 10 == 0)
+            snprintf(line, sizeof(line), "    // r\xC3\xA9sultat %ld d\xC3\xA9j\xC3\xA0 calcul\xC3\xA9%s\n", i,
+                     latin1 ? "" : " \xE2\x82\xAC \xF0\x9F\x98\x80");
+        else
+            snprintf(line, sizeof(line), "    var value%ld = compute(%ld, options);\n", i, i % 97);
+        text += line;
+    }
+    return text;
+}
+
+// Converts |input| with iconv, the converter the system has, standing in for
+// the one a platform string class would use
+bool ConvertWithIconv(const char* to, const char* from, const std::string& input, std::string& output)
+{
+    iconv_t converter = iconv_open(to, from);
+    if (converter == (iconv_t)-1)
+        return false;
+    output.resize(input.size() * 2 + 16);
+    char* in = const_cast<char*>(input.data());
+    size_t inLeft = input.size();
+    char* out = &output[0];
+    size_t outLeft = output.size();
+    size_t result = iconv(converter, &in, &inLeft, &out, &outLeft);
+    iconv_close(converter);
+    if (result == (size_t)-1 || inLeft != 0)
+        return false;
+    output.resize(output.size() - outLeft);
+    return true;
+}
+
+void PrintThroughput(const char* label, double seconds, size_t bytes)
+{
+    printf("%-40s %10.2f ms %9.2f GB/s\n", label, seconds * 1000, bytes / seconds / (1024.0 * 1024 * 1024));
+}
+
+// Reads |path| with ReadFile in |encoding| and checks the text and the
+// encoding it reports
+bool ReadEncodedAndCheck(CefRefPtr<CefV8Handler> handler, const std::string& path, const char* encoding,
+                         const std::string& expected, const char* expectedEncoding)
+{
+    CefRefPtr<CefV8Value> retval;
+    int error = Call(handler, "ReadFile", Args(CefV8Value::CreateString(path), CefV8Value::CreateString(encoding)),
+                     retval);
+    if (error != NO_ERROR) {
+        fprintf(stderr, "ReadFile of %s as %s failed with %d\n", path.c_str(), encoding, error);
+        return false;
+    }
+    CefRefPtr<CefV8Value> data = retval->IsString() ? retval : retval->GetValue("data");
+    std::string found = retval->IsString() ? "utf8" : retval->GetValue("encoding")->GetStringValue().ToString();
+    if (data->GetStringValue().ToString() != expected || found != expectedEncoding) {
+        fprintf(stderr, "ReadFile of %s as %s gave the wrong text, or %s instead of %s\n", path.c_str(), encoding,
+                found.c_str(), expectedEncoding);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int RunEncodingBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    using Brackets::FileSystem::TextEncoding;
+
+    size_t size = (size_t)std::min(options.fileSizeMB, 64) * 1024 * 1024;
+    std::string text = MakeEncodingText(size, false);
+    std::string latin1Text = MakeEncodingText(size, true);
+
+    struct {
+        const char* name;
+        const char* iconvName;
+        const char* mark;
+        size_t markLength;
+        TextEncoding encoding;
+    } const encodings[] = {
+        { "utf8", "UTF-8", "", 0, Brackets::FileSystem::ENCODING_UTF8 },
+        { "utf8bom", "UTF-8", "\xEF\xBB\xBF", 3, Brackets::FileSystem::ENCODING_UTF8_BOM },
+        { "utf16le", "UTF-16LE", "\xFF\xFE", 2, Brackets::FileSystem::ENCODING_UTF16LE },
+        { "utf16be", "UTF-16BE", "\xFE\xFF", 2, Brackets::FileSystem::ENCODING_UTF16BE },
+        { "latin1", "ISO-8859-1", "", 0, Brackets::FileSystem::ENCODING_LATIN1 },
+    };
+
+    for (size_t e = 0; e < sizeof(encodings) / sizeof(encodings[0]); e++) {
+        const char* name = encodings[e].name;
+        const std::string& source = encodings[e].encoding == Brackets::FileSystem::ENCODING_LATIN1 ? latin1Text : text;
+        std::string reference;
+        if (!ConvertWithIconv(encodings[e].iconvName, "UTF-8", source, reference)) {
+            fprintf(stderr, "iconv can't convert to %s\n", encodings[e].iconvName);
+            return 1;
+        }
+        reference.insert(0, encodings[e].mark, encodings[e].markLength);
+        printf("%s, %.1f MB on disk\n", name, reference.size() / (1024.0 * 1024));
+
+        // Transcoding alone, against copying the bytes and against iconv
+        std::string bytes = reference;
+        std::string copy(reference.size(), '\0');
+        double start = Now();
+        for (int n = 0; n < options.iterations; n++)
+            memcpy(&copy[0], reference.data(), reference.size());
+        PrintThroughput("  byte copy", (Now() - start) / options.iterations, reference.size());
+
+        std::string converted;
+        start = Now();
+        for (int n = 0; n < options.iterations; n++) {
+            if (!ConvertWithIconv("UTF-8", encodings[e].iconvName, reference.substr(encodings[e].markLength),
+                                  converted))
+                return 1;
+        }
+        PrintThroughput("  iconv to UTF-8", (Now() - start) / options.iterations, reference.size());
+
+        TextEncoding detected;
+        double decodeTime = 0;
+        for (int n = 0; n < options.iterations; n++) {
+            bytes = reference;
+            start = Now();
+            bool decoded = Brackets::FileSystem::DecodeText(bytes, Brackets::FileSystem::ENCODING_AUTO, converted,
+                                                            detected);
+            decodeTime += Now() - start;
+            if (!decoded || converted != source || detected != encodings[e].encoding) {
+                fprintf(stderr, "DecodeText of %s failed\n", name);
+                return 1;
+            }
+        }
+        PrintThroughput("  DecodeText, auto", decodeTime / options.iterations, reference.size());
+
+        start = Now();
+        for (int n = 0; n < options.iterations; n++) {
+            if (!Brackets::FileSystem::EncodeText(source, encodings[e].encoding, bytes) || bytes != reference) {
+                fprintf(stderr, "EncodeText to %s gave the wrong bytes\n", name);
+                return 1;
+            }
+        }
+        PrintThroughput("  EncodeText", (Now() - start) / options.iterations, reference.size());
+
+        // Through the native functions, with the disk and the copies into
+        // and out of V8
+        std::string path = options.root + "/" + name + ".txt";
+        if (!WriteInPlace(path, reference))
+            return 1;
+        start = Now();
+        for (int n = 0; n < options.iterations; n++) {
+            if (!ReadEncodedAndCheck(handler, path, "auto", source, name))
+                return 1;
+        }
+        PrintThroughput("  ReadFile, auto", (Now() - start) / options.iterations, reference.size());
+
+        CefRefPtr<CefV8Value> retval;
+        CefV8ValueList save = Args(CefV8Value::CreateString(path), CefV8Value::CreateString(source),
+                                   CefV8Value::CreateString(name));
+        save.push_back(CefV8Value::CreateInt(Brackets::FileSystem::DURABILITY_NONE));
+        start = Now();
+        for (int n = 0; n < options.iterations; n++) {
+            if (Call(handler, "WriteFile", save, retval) != NO_ERROR) {
+                fprintf(stderr, "WriteFile as %s failed\n", name);
+                return 1;
+            }
+        }
+        PrintThroughput("  WriteFile", (Now() - start) / options.iterations, reference.size());
+        if (!ReadWhole(path, bytes) || bytes != reference) {
+            fprintf(stderr, "WriteFile as %s did not save the file as it was read\n", name);
+            return 1;
+        }
+    }
+
+    // What each encoding makes of files it was not meant for
+    std::string path = options.root + "/odd.txt";
+    CefRefPtr<CefV8Value> retval;
+    struct {
+        const char* contents;
+        size_t length;
+        const char* encoding;
+        int error;
+        const char* text;
+        size_t textLength;
+        const char* detected;
+    } const cases[] = {
+        // 'utf8' keeps the byte order mark, 'utf8bom' only drops it
+        { "\xEF\xBB\xBFvar a;", 9, "utf8", NO_ERROR, "\xEF\xBB\xBFvar a;", 9, "utf8" },
+        { "\xEF\xBB\xBFvar a;", 9, "utf8bom", NO_ERROR, "var a;", 6, "utf8bom" },
+        { "var a;", 6, "utf8bom", NO_ERROR, "var a;", 6, "utf8" },
+        { "caf\xE9", 4, "auto", NO_ERROR, "caf\xC3\xA9", 5, "latin1" },
+        { "caf\xE9", 4, "utf8", ERR_UNSUPPORTED_ENCODING, NULL, 0, NULL },
+        // A lone surrogate, and an odd number of bytes, which 'auto' reads
+        // as Latin-1 despite the byte order mark
+        { "\xFF\xFE" "a\0\x00\xD8", 6, "utf16le", ERR_UNSUPPORTED_ENCODING, NULL, 0, NULL },
+        { "\xFE\xFF\0a\0", 5, "utf16be", ERR_UNSUPPORTED_ENCODING, NULL, 0, NULL },
+        { "\xFE\xFF\0a\0", 5, "auto", NO_ERROR, "\xC3\xBE\xC3\xBF\0a\0", 7, "latin1" },
+        { "\0a\0b", 4, "utf16be", NO_ERROR, "ab", 2, "utf16be" },
+        { "var a;", 6, "ebcdic", ERR_UNSUPPORTED_ENCODING, NULL, 0, NULL },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (!WriteInPlace(path, std::string(cases[i].contents, cases[i].length)))
+            return 1;
+        if (cases[i].error != NO_ERROR) {
+            int error = Call(handler, "ReadFile", Args(CefV8Value::CreateString(path),
+                                                       CefV8Value::CreateString(cases[i].encoding)), retval);
+            if (error != cases[i].error) {
+                fprintf(stderr, "Case %d: ReadFile as %s gave %d instead of %d\n", (int)i, cases[i].encoding, error,
+                        cases[i].error);
+                return 1;
+            }
+            continue;
+        }
+        std::string expected(cases[i].text, cases[i].textLength);
+        if (!ReadEncodedAndCheck(handler, path, cases[i].encoding, expected, cases[i].detected))
+            return 1;
+    }
+
+    // Text an encoding can't hold is refused, not mangled
+    const char* const unsaveable[][2] = { { "latin1", "5 \xE2\x82\xAC" }, { "latin1", "\xF0\x9F\x98\x80" },
+                                          { "auto", "var a;" } };
+    for (size_t i = 0; i < sizeof(unsaveable) / sizeof(unsaveable[0]); i++) {
+        if (Call(handler, "WriteFile", Args(CefV8Value::CreateString(path),
+                                            CefV8Value::CreateString(unsaveable[i][1]),
+                                            CefV8Value::CreateString(unsaveable[i][0])), retval) !=
+            ERR_UNSUPPORTED_ENCODING) {
+            fprintf(stderr, "WriteFile as %s saved what it can't hold\n", unsaveable[i][0]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+} // namespace Headless
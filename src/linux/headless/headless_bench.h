@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _HEADLESS_BENCH_H
+#define _HEADLESS_BENCH_H
+
+#include "headless_fixture.h"
+
+/**
+ * The headless benchmarks, one per suite of brackets_headless bench. Each
+ * works in |options.root| and returns 0, or 1 with what went wrong printed
+ * on stderr.
+ */
+namespace Headless {
+
+int RunFileSystemBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Times building results as V8 arrays and objects, for lists of increasing
+// size
+int RunMarshalBenchmark(const Options& options);
+
+// Reads and lists the synthetic project through the synchronous functions
+// and through their Async versions with every operation in flight at once
+int RunAsyncBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Times native function lookup by name: the dispatch table against the chain
+// of string compares it replaced, and a full GetLastError round trip
+int RunDispatchBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Reads one large file through ReadFile and reports throughput and how much
+// the peak resident size of the process grew
+int RunReadBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Pages through a large log with the file stream functions: by line, from the
+// end, in sequential chunks, and following it as it grows
+int RunStreamBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Times saving a document through WriteFile with each durability mode, next
+// to a plain in-place rewrite, and checks what a save must preserve
+int RunWriteBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Saves a set of open documents one WriteFile at a time and as a single
+// WriteFilesAsync batch, for each durability mode
+int RunSaveAllBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Watches the synthetic project with WatchPath, natively and by polling,
+// and times how long changes take to be reported and how they are batched
+int RunWatchBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Stats and lists the synthetic project with and without the StatCache, and
+// checks that changes made outside the native functions reach the cache
+int RunStatCacheBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Lists a synthetic monorepo the way the JS side used to, with readdir and a
+// stat per entry, and with WalkTreeAsync, and checks the ignore rules
+int RunWalkBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Searches files for a string by reading each one through ReadFile, the way
+// the JS side used to, and with SearchFilesAsync, and checks what it reports
+int RunSearchBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Searches a corpus of --size MB for regular expressions with regexec over
+// the text ReadFile returns, standing in for a JS RegExp, and with the
+// regex option of SearchFilesAsync, and checks that the counts agree
+int RunRegexBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Builds a search index of the search corpus, cold and refreshed, and
+// searches with and without it, checking that files changed since the
+// build are still found
+int RunIndexBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Scores --files project paths against a query typed one character at a
+// time, by scanning them all and with MatchPaths, and checks the ranking
+int RunQuickOpenBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Measures the memory of --files project paths held one string each and in
+// a PathStore, checks that ids and paths survive the trip, and loads a tree
+// on disk with LoadPathStoreAsync
+int RunPathStoreBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Calls the most frequent file functions on the synthetic project by path
+// and by a handle from InternPaths, and stats it with one StatPaths call
+int RunHandlesBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Opens a synthetic monorepo with a walk and with SyncProjectSnapshotAsync,
+// first without a snapshot and then from the one it left, and checks the
+// changes it reports after the project is changed on disk
+int RunSnapshotBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Reads a --size MB source file with ReadFile and then scans its text for
+// lines, against ReadFile finding its layout as it reads, and checks the line
+// starts, line endings and indentation it reports
+int RunLayoutBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Transcodes up to 64 MB of text between UTF-8 and each encoding ReadFile
+// takes, against copying the bytes and iconv, reads and saves it through
+// ReadFile and WriteFile, and checks byte order marks and malformed files
+int RunEncodingBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Changes a --size MB source file on disk in a few places, in many and
+// everywhere, diffs it against its old text with DiffFileAsync, and checks
+// that the hunks turn the old text into the new
+int RunDiffBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Hashes a --size MB source file with each algorithm, reading it in and with
+// HashFileAsync, then again from the cache, and the synthetic project's files
+// one at a time and with HashFilesAsync, checking when the cache is trusted
+int RunHashBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Reads 200 documents of 64 KB again and again with ReadFile, with and
+// without the ContentCache, and checks that changed, saved and deleted files
+// are not served from it and that it evicts the document read longest ago
+int RunContentCacheBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Autosaves documents of 64 KB to 4 MB with WriteFile and with the edit
+// journal, times typing into the journal, and checks what replaying it
+// recovers after a crash, a write cut short and a change to a base file
+int RunJournalBenchmark(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+} // namespace Headless
+
+#endif // _HEADLESS_BENCH_H
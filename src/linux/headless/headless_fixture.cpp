@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#include "headless_fixture.h"
+#include "common/brackets_fs.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace Headless {
+
+namespace {
+
+int s_waitGeneration = 0;
+
+// Ends the message loop when a wait times out, unless a newer wait started
+class QuitTask : public CefTask
+{
+public:
+    explicit QuitTask(int generation) : m_generation(generation) {}
+
+    virtual void Execute(CefThreadId threadId)
+    {
+        if (m_generation == s_waitGeneration)
+            CefQuitMessageLoop();
+    }
+
+private:
+    int m_generation;
+
+    IMPLEMENT_REFCOUNTING(QuitTask);
+};
+
+} // namespace
+
+double Now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int Call(CefRefPtr<CefV8Handler> handler, const char* name,
+         const CefV8ValueList& arguments, CefRefPtr<CefV8Value>& retval)
+{
+    CefString exception;
+    retval = NULL;
+    if (!handler->Execute(name, NULL, arguments, retval, exception))
+        return -1;
+
+    CefRefPtr<CefV8Value> lastError;
+    handler->Execute("GetLastError", NULL, CefV8ValueList(), lastError, exception);
+    return lastError.get() ? lastError->GetIntValue() : -1;
+}
+
+CefV8ValueList Args(CefRefPtr<CefV8Value> a)
+{
+    CefV8ValueList args;
+    args.push_back(a);
+    return args;
+}
+
+CefV8ValueList Args(CefRefPtr<CefV8Value> a, CefRefPtr<CefV8Value> b)
+{
+    CefV8ValueList args = Args(a);
+    args.push_back(b);
+    return args;
+}
+
+CefV8ValueList Args(CefRefPtr<CefV8Value> a, CefRefPtr<CefV8Value> b, CefRefPtr<CefV8Value> c)
+{
+    CefV8ValueList args = Args(a, b);
+    args.push_back(c);
+    return args;
+}
+
+CefV8ValueList Args(CefRefPtr<CefV8Value> a, CefRefPtr<CefV8Value> b, CefRefPtr<CefV8Value> c,
+                    CefRefPtr<CefV8Value> d)
+{
+    CefV8ValueList args = Args(a, b, c);
+    args.push_back(d);
+    return args;
+}
+
+int CallAndWait(CefRefPtr<CefV8Handler> handler, const char* name,
+                CefV8ValueList arguments, CefRefPtr<CefV8Value>& result)
+{
+    CefRefPtr<ResultCallback> callback = new ResultCallback();
+    arguments.push_back(CefV8Value::CreateFunction("callback", callback.get()));
+
+    CefRefPtr<CefV8Value> retval;
+    int error = Call(handler, name, arguments, retval);
+    if (error != NO_ERROR)
+        return error;
+
+    CefRunMessageLoop();
+    result = callback->m_result;
+    return callback->m_error;
+}
+
+void RunMessageLoopFor(int timeoutMs)
+{
+    CefPostDelayedTask(TID_UI, new QuitTask(++s_waitGeneration), timeoutMs);
+    CefRunMessageLoop();
+
+    // A callback may have ended the loop first. Its QuitTask must not end
+    // the next one.
+    s_waitGeneration++;
+}
+
+bool GetResultNames(CefRefPtr<CefV8Value> result, std::vector<std::string>& names)
+{
+    if (!result.get() || !result->IsArray())
+        return false;
+
+    int length = result->GetArrayLength();
+    for (int i = 0; i < length; i++) {
+        CefRefPtr<CefV8Value> item = result->GetValue(i);
+        if (item->IsObject())
+            item = item->GetValue("name");
+        names.push_back(item->GetStringValue());
+    }
+    return true;
+}
+
+void PrintResult(const char* label, double seconds, long count)
+{
+    printf("%-40s %10.2f ms  %8ld calls  %10.0f ns/call\n",
+           label, seconds * 1000, count, count ? seconds * 1e9 / count : 0.0);
+}
+
+bool ResultCallback::Execute(const CefString& name,
+                             CefRefPtr<CefV8Value> object,
+                             const CefV8ValueList& arguments,
+                             CefRefPtr<CefV8Value>& retval,
+                             CefString& exception)
+{
+    m_error = arguments.empty() ? -1 : arguments[0]->GetIntValue();
+    m_result = arguments.size() > 1 ? arguments[1] : NULL;
+    m_calls++;
+    CefQuitMessageLoop();
+    return true;
+}
+
+bool ChangeCollector::Execute(const CefString& name,
+                              CefRefPtr<CefV8Value> object,
+                              const CefV8ValueList& arguments,
+                              CefRefPtr<CefV8Value>& retval,
+                              CefString& exception)
+{
+    CefRefPtr<CefV8Value> list = arguments[0];
+    for (int i = 0; i < list->GetArrayLength(); i++) {
+        CefRefPtr<CefV8Value> change = list->GetValue(i);
+        m_changes.push_back(std::make_pair(std::string(change->GetValue("path")->GetStringValue()),
+                                           change->GetValue("kind")->GetIntValue()));
+    }
+    m_batches++;
+    m_polling = arguments[1]->GetBoolValue();
+    CefQuitMessageLoop();
+    return true;
+}
+
+int ChangeCollector::Find(const std::string& path) const
+{
+    for (size_t i = m_changes.size(); i > 0; i--) {
+        if (m_changes[i - 1].first == path)
+            return m_changes[i - 1].second;
+    }
+    return 0;
+}
+
+int ChangeCollector::Count(const std::string& path) const
+{
+    int count = 0;
+    for (size_t i = 0; i < m_changes.size(); i++)
+        count += m_changes[i].first == path;
+    return count;
+}
+
+void ChangeCollector::Clear()
+{
+    m_changes.clear();
+    m_batches = 0;
+}
+
+int WaitForChange(CefRefPtr<ChangeCollector> collector, const std::string& path, int timeoutMs)
+{
+    double deadline = Now() + timeoutMs / 1000.0;
+    for (;;) {
+        int kind = collector->Find(path);
+        if (kind)
+            return kind;
+
+        double left = deadline - Now();
+        if (left <= 0)
+            return 0;
+        RunMessageLoopFor((int)(left * 1000) + 1);
+    }
+}
+
+bool MakeProject(const Options& options, Project& project)
+{
+    const std::string contents = "/* generated by brackets_headless */\nfunction f() { return 42; }\n";
+    char name[64];
+
+    bool ok = true;
+    for (int i = 0; ok && i < options.files; i++) {
+        if (i % options.filesPerDir == 0) {
+            snprintf(name, sizeof(name), "/dir%05d", i / options.filesPerDir);
+            project.dirs.push_back(options.root + name);
+            ok = mkdir(project.dirs.back().c_str(), 0777) == 0;
+        }
+        snprintf(name, sizeof(name), "/file%06d.js", i);
+        project.files.push_back(project.dirs.back() + name);
+        ok = ok && Brackets::FileSystem::WriteFile(project.files.back(), contents, "utf8",
+                                                   Brackets::FileSystem::DURABILITY_NONE) == NO_ERROR;
+    }
+
+    if (!ok)
+        fprintf(stderr, "Unable to create the project in %s\n", options.root.c_str());
+    return ok;
+}
+
+long MakeMonorepo(const std::string& root, int files)
+{
+    long expected = 0;
+    std::string dir;
+    char name[128];
+
+    for (int i = 0; i < files; i++) {
+        if (i % 100 == 0) {
+            snprintf(name, sizeof(name), "/packages/p%03d", i / 2000);
+            mkdir((root + "/packages").c_str(), 0777);
+            mkdir((root + name).c_str(), 0777);
+            mkdir((root + name + "/src").c_str(), 0777);
+            snprintf(name + strlen(name), sizeof(name) - strlen(name), "/src/m%02d", (i / 100) % 20);
+            dir = root + name;
+            if (mkdir(dir.c_str(), 0777) == -1)
+                return -1;
+        }
+        snprintf(name, sizeof(name), "/file%06d.js", i);
+        if (!WriteSmallFile(dir + name, "function f() { return 42; }\n"))
+            return -1;
+        expected++;
+    }
+
+    // Left out by the default ignore patterns and by .gitignore
+    const char* const ignored[] = {
+        "/.git", "/.git/objects", "/node_modules", "/node_modules/dep", "/packages/p000/build"
+    };
+    for (size_t i = 0; i < sizeof(ignored) / sizeof(ignored[0]); i++)
+        mkdir((root + ignored[i]).c_str(), 0777);
+    const char* const homes[] = { "/.git/objects", "/node_modules/dep", "/packages/p000/build" };
+    for (int i = 0; i < files / 20; i++) {
+        snprintf(name, sizeof(name), "%s/f%06d", homes[i % 3], i);
+        if (!WriteSmallFile(root + name, "x\n"))
+            return -1;
+    }
+    if (!WriteSmallFile(root + "/.gitignore", "# build output\n*.log\nbuild/\n") ||
+        !WriteSmallFile(root + "/debug.log", "ignored\n") ||
+        !WriteSmallFile(root + "/packages/p000/.gitignore", "!keep.log\n") ||
+        !WriteSmallFile(root + "/packages/p000/keep.log", "kept\n") ||
+        !WriteSmallFile(root + "/packages/p000/other.log", "ignored\n"))
+        return -1;
+    expected += 3;  // both .gitignore files and keep.log
+
+    if (symlink("../..", (root + "/packages/p000/src/loop").c_str()) != 0)
+        return -1;
+
+    return expected;
+}
+
+std::string LogLine(long line)
+{
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%09ld INFO request handled in %ld ms, caf\xC3\xA9 \xE2\x82\xAC\n",
+             line, line % 997);
+    return buffer;
+}
+
+std::string MakeDocumentText(long firstLine, size_t size)
+{
+    std::string text;
+    for (long line = firstLine; text.size() < size; line++)
+        text += LogLine(line);
+    return text;
+}
+
+bool WriteSmallFile(const std::string& path, const char* contents)
+{
+    return Brackets::FileSystem::WriteFile(path, contents, "utf8", Brackets::FileSystem::DURABILITY_NONE) == NO_ERROR;
+}
+
+bool WriteInPlace(const std::string& path, const std::string& contents)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
+        return false;
+    bool ok = write(fd, contents.data(), contents.size()) == (ssize_t)contents.size();
+    return close(fd) == 0 && ok;
+}
+
+bool ReadWhole(const std::string& path, std::string& contents)
+{
+    std::vector<char> buffer(1024 * 1024);
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    contents.clear();
+    size_t count;
+    while ((count = fread(&buffer[0], 1, buffer.size(), file)) > 0)
+        contents.append(&buffer[0], count);
+    fclose(file);
+    return true;
+}
+
+void AgeFile(const std::string& path, int seconds)
+{
+    struct timeval times[2];
+    gettimeofday(&times[0], NULL);
+    times[0].tv_sec -= seconds;
+    times[1] = times[0];
+    utimes(path.c_str(), times);
+}
+
+void RemoveTree(const std::string& path)
+{
+    bool isDirectory = false;
+    if (Brackets::FileSystem::IsDirectory(path, isDirectory) != NO_ERROR)
+        return;
+
+    if (isDirectory) {
+        std::vector<std::string> contents;
+        Brackets::FileSystem::ReadDir(path, contents);
+        for (size_t i = 0; i < contents.size(); i++)
+            RemoveTree(path + "/" + contents[i]);
+    }
+    Brackets::FileSystem::DeleteFileOrDirectory(path);
+}
+
+void ToUTF16(const std::string& text, std::vector<unsigned short>& units)
+{
+    units.clear();
+    units.reserve(text.size());
+    const unsigned char* p = (const unsigned char*)text.data();
+    const unsigned char* end = p + text.size();
+    while (p < end) {
+        unsigned int c = *p++;
+        int trailing = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+        c &= trailing ? 0x3F >> trailing : 0x7F;
+        while (trailing-- && p < end)
+            c = (c << 6) | (*p++ & 0x3F);
+        if (c >= 0x10000) {
+            units.push_back((unsigned short)(0xD800 + ((c - 0x10000) >> 10)));
+            units.push_back((unsigned short)(0xDC00 + ((c - 0x10000) & 0x3FF)));
+        } else {
+            units.push_back((unsigned short)c);
+        }
+    }
+}
+
+unsigned int NextRandom(unsigned int& seed)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7FFF;
+}
+
+} // namespace Headless
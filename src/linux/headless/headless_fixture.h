@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#ifndef _HEADLESS_FIXTURE_H
+#define _HEADLESS_FIXTURE_H
+
+#include "include/cef.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * What the headless benchmarks and tests share: calling the native functions
+ * the same way brackets_extensions.js does, through CefV8Handler::Execute
+ * with CefV8Value arguments followed by a GetLastError call, waiting for
+ * their callbacks, and the files they work on.
+ */
+namespace Headless {
+
+struct Options {
+    Options() : files(100000), filesPerDir(1000), iterations(1), fileSizeMB(256), keep(false) {}
+
+    int files;
+    int filesPerDir;
+    int iterations;
+    int fileSizeMB;
+    bool keep;
+    std::string root;
+};
+
+// Monotonic clock in seconds
+double Now();
+
+// Calls |name| on |handler| and returns the value of GetLastError
+int Call(CefRefPtr<CefV8Handler> handler, const char* name,
+         const CefV8ValueList& arguments, CefRefPtr<CefV8Value>& retval);
+
+CefV8ValueList Args(CefRefPtr<CefV8Value> a);
+CefV8ValueList Args(CefRefPtr<CefV8Value> a, CefRefPtr<CefV8Value> b);
+CefV8ValueList Args(CefRefPtr<CefV8Value> a, CefRefPtr<CefV8Value> b, CefRefPtr<CefV8Value> c);
+CefV8ValueList Args(CefRefPtr<CefV8Value> a, CefRefPtr<CefV8Value> b, CefRefPtr<CefV8Value> c,
+                    CefRefPtr<CefV8Value> d);
+
+// Calls the async function |name| with a callback added to |arguments| and
+// waits for it. Returns the error passed to the callback, or the error of
+// the call itself.
+int CallAndWait(CefRefPtr<CefV8Handler> handler, const char* name,
+                CefV8ValueList arguments, CefRefPtr<CefV8Value>& result);
+
+// Runs the message loop for |timeoutMs|, or until a callback ends it
+void RunMessageLoopFor(int timeoutMs);
+
+// Collects the names in a ReadDir or ReadDirWithStats result
+bool GetResultNames(CefRefPtr<CefV8Value> result, std::vector<std::string>& names);
+
+void PrintResult(const char* label, double seconds, long count);
+
+// JS callback that keeps the arguments of the last call, counts the calls
+// and ends the message loop
+class ResultCallback : public CefV8Handler
+{
+public:
+    ResultCallback() : m_error(-1), m_calls(0) {}
+
+    virtual bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception);
+
+    int m_error;
+    int m_calls;
+    CefRefPtr<CefV8Value> m_result;
+
+    IMPLEMENT_REFCOUNTING(ResultCallback);
+};
+
+// JS function passed to WatchPath. Keeps every change it is given and ends
+// the message loop after each batch.
+class ChangeCollector : public CefV8Handler
+{
+public:
+    ChangeCollector() : m_batches(0), m_polling(false) {}
+
+    virtual bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception);
+
+    // The last kind reported for |path|, or 0
+    int Find(const std::string& path) const;
+
+    // How many times |path| was reported
+    int Count(const std::string& path) const;
+
+    void Clear();
+
+    std::vector<std::pair<std::string, int> > m_changes;
+    int m_batches;
+    bool m_polling;
+
+    IMPLEMENT_REFCOUNTING(ChangeCollector);
+};
+
+// Runs the message loop until |collector| has a change for |path|, or for
+// |timeoutMs|. Returns the kind of the change, or 0.
+int WaitForChange(CefRefPtr<ChangeCollector> collector, const std::string& path, int timeoutMs);
+
+// The synthetic project most suites work on: |options.files| small files,
+// |options.filesPerDir| per directory, in directories under |options.root|
+struct Project {
+    std::vector<std::string> dirs;
+    std::vector<std::string> files;
+};
+
+// Creates the project, or prints why it could not
+bool MakeProject(const Options& options, Project& project);
+
+// Builds a project laid out like a monorepo: |files| sources in packages of
+// 2000, 100 per directory, three levels down. Around them are what a walk
+// should leave out: .git, node_modules, a build directory and logs ignored
+// by .gitignore, and a symlink back up the tree. Returns the number of
+// files the walk should report, or -1.
+long MakeMonorepo(const std::string& root, int files);
+
+// Line |line| of a log, with a few characters that are not ASCII
+std::string LogLine(long line);
+
+// Log lines from |firstLine| on, up to at least |size| bytes: the text of
+// the documents the suites open and save
+std::string MakeDocumentText(long firstLine, size_t size);
+
+bool WriteSmallFile(const std::string& path, const char* contents);
+
+// The old WriteFile: truncate the file and write it again
+bool WriteInPlace(const std::string& path, const std::string& contents);
+
+bool ReadWhole(const std::string& path, std::string& contents);
+
+// Sets the modification time of |path| |seconds| back, as if the file had
+// been there a while. The HashCache and the ContentCache only trust such
+// files.
+void AgeFile(const std::string& path, int seconds);
+
+// Recursively deletes |path|
+void RemoveTree(const std::string& path);
+
+// |text| as the UTF-16 code units a JS string holds
+void ToUTF16(const std::string& text, std::vector<unsigned short>& units);
+
+// Next value of the generator the generated text and edits are made with
+unsigned int NextRandom(unsigned int& seed);
+
+} // namespace Headless
+
+#endif // _HEADLESS_FIXTURE_H
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#include "include/cef.h"
+#include "common/brackets_dispatch.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_fs_extension.h"
+#include "headless_bench.h"
+#include "headless_tests.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+namespace {
+
+/**
+ * Headless counterpart of BracketsExtensionHandler. It only knows about the
+ * shared native functions, which is what the benchmarks exercise.
+ */
+class HeadlessExtensionHandler : public CefV8Handler
+{
+public:
+    HeadlessExtensionHandler() : lastError(0) {
+        m_functions.Add("GetLastError", &HeadlessExtensionHandler::ExecuteGetLastError);
+    }
+
+    virtual bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception)
+    {
+        int errorCode = -1;
+
+        NativeFunction function = m_functions.Find(name);
+        if (function)
+            errorCode = (this->*function)(arguments, retval, exception);
+        else
+            errorCode = Brackets::FileSystem::Execute(name, arguments, retval, exception);
+
+        if (errorCode != -1)
+        {
+            lastError = errorCode;
+            return true;
+        }
+
+        return false;
+    }
+
+    int ExecuteGetLastError(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception)
+    {
+        retval = CefV8Value::CreateInt(lastError);
+
+        // Returning lastError leaves it unchanged
+        return lastError;
+    }
+
+private:
+    typedef int (HeadlessExtensionHandler::*NativeFunction)(const CefV8ValueList& arguments,
+                                                           CefRefPtr<CefV8Value>& retval,
+                                                           CefString& exception);
+
+    int lastError;
+    Brackets::NativeFunctionTable<NativeFunction> m_functions;
+
+    IMPLEMENT_REFCOUNTING(HeadlessExtensionHandler);
+};
+
+void PrintValue(CefRefPtr<CefV8Value> value)
+{
+    if (!value.get() || value->IsUndefined())
+        printf("undefined\n");
+    else if (value->IsBool())
+        printf("%s\n", value->GetBoolValue() ? "true" : "false");
+    else if (value->IsInt())
+        printf("%d\n", value->GetIntValue());
+    else if (value->IsDate())
+        printf("Date(%.3f)\n", value->GetDateValue().GetDoubleT());
+    else if (value->IsDouble())
+        printf("%f\n", value->GetDoubleValue());
+    else if (value->IsString())
+        printf("%s\n", value->GetStringValue().c_str());
+    else
+        printf("[object]\n");
+}
+
+// Runs a single native function. Arguments that look like integers are passed
+// as ints, everything else as strings.
+int RunCall(CefRefPtr<CefV8Handler> handler, int argc, char* argv[])
+{
+    CefV8ValueList arguments;
+    for (int i = 1; i < argc; i++) {
+        char* end = NULL;
+        long number = strtol(argv[i], &end, 0);
+        if (*argv[i] && *end == '\0')
+            arguments.push_back(CefV8Value::CreateInt((int)number));
+        else
+            arguments.push_back(CefV8Value::CreateString(argv[i]));
+    }
+
+    CefRefPtr<CefV8Value> retval;
+    int error = Headless::Call(handler, argv[0], arguments, retval);
+    if (error == -1) {
+        fprintf(stderr, "Unknown native function %s\n", argv[0]);
+        return 1;
+    }
+
+    printf("error: %d\n", error);
+    PrintValue(retval);
+    return error == NO_ERROR ? 0 : 1;
+}
+
+int RunBenchmark(CefRefPtr<CefV8Handler> handler, int argc, char* argv[])
+{
+    Headless::Options options;
+    std::string suite = "fs";
+
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--files") && i + 1 < argc)
+            options.files = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--per-dir") && i + 1 < argc)
+            options.filesPerDir = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+            options.iterations = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)
+            options.fileSizeMB = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--root") && i + 1 < argc)
+            options.root = argv[++i];
+        else if (!strcmp(argv[i], "--keep"))
+            options.keep = true;
+        else
+            suite = argv[i];
+    }
+
+    if (options.files <= 0 || options.filesPerDir <= 0 || options.iterations <= 0 ||
+        options.fileSizeMB <= 0) {
+        fprintf(stderr, "Invalid benchmark options\n");
+        return 1;
+    }
+
+    bool madeRoot = false;
+    if (options.root.empty()) {
+        char tmpl[] = "/tmp/brackets_bench_XXXXXX";
+        if (!mkdtemp(tmpl)) {
+            perror("mkdtemp");
+            return 1;
+        }
+        options.root = tmpl;
+        madeRoot = true;
+    }
+
+    printf("%s benchmark: %d files, %d per directory, root %s\n",
+           suite.c_str(), options.files, options.filesPerDir, options.root.c_str());
+
+    int result;
+    if (suite == "fs") {
+        result = Headless::RunFileSystemBenchmark(handler, options);
+    } else if (suite == "async") {
+        result = Headless::RunAsyncBenchmark(handler, options);
+    } else if (suite == "dispatch") {
+        result = Headless::RunDispatchBenchmark(handler, options);
+    } else if (suite == "stream") {
+        result = Headless::RunStreamBenchmark(handler, options);
+    } else if (suite == "write") {
+        result = Headless::RunWriteBenchmark(handler, options);
+    } else if (suite == "saveall") {
+        result = Headless::RunSaveAllBenchmark(handler, options);
+    } else if (suite == "watch") {
+        result = Headless::RunWatchBenchmark(handler, options);
+    } else if (suite == "walk") {
+        result = Headless::RunWalkBenchmark(handler, options);
+    } else if (suite == "search") {
+        result = Headless::RunSearchBenchmark(handler, options);
+    } else if (suite == "regex") {
+        result = Headless::RunRegexBenchmark(handler, options);
+    } else if (suite == "index") {
+        result = Headless::RunIndexBenchmark(handler, options);
+    } else if (suite == "quickopen") {
+        result = Headless::RunQuickOpenBenchmark(handler, options);
+    } else if (suite == "handles") {
+        result = Headless::RunHandlesBenchmark(handler, options);
+    } else if (suite == "snapshot") {
+        result = Headless::RunSnapshotBenchmark(handler, options);
+    } else if (suite == "pathstore") {
+        result = Headless::RunPathStoreBenchmark(handler, options);
+    } else if (suite == "statcache") {
+        result = Headless::RunStatCacheBenchmark(handler, options);
+    } else if (suite == "read") {
+        result = Headless::RunReadBenchmark(handler, options);
+    } else if (suite == "layout") {
+        result = Headless::RunLayoutBenchmark(handler, options);
+    } else if (suite == "encoding") {
+        result = Headless::RunEncodingBenchmark(handler, options);
+    } else if (suite == "diff") {
+        result = Headless::RunDiffBenchmark(handler, options);
+    } else if (suite == "hash") {
+        result = Headless::RunHashBenchmark(handler, options);
+    } else if (suite == "contentcache") {
+        result = Headless::RunContentCacheBenchmark(handler, options);
+    } else if (suite == "journal") {
+        result = Headless::RunJournalBenchmark(handler, options);
+    } else if (suite == "marshal") {
+        result = Headless::RunMarshalBenchmark(options);
+    } else {
+        fprintf(stderr, "Unknown benchmark %s\n", suite.c_str());
+        result = 1;
+    }
+
+    if (madeRoot && !options.keep)
+        Headless::RemoveTree(options.root);
+
+    return result;
+}
+
+// Runs the named tests, or all of them, each in a directory of its own
+int RunTests(CefRefPtr<CefV8Handler> handler, int argc, char* argv[])
+{
+    typedef int (*Test)(CefRefPtr<CefV8Handler> handler, const Headless::Options& options);
+    const char* const names[] = { "save", "cancel", "overflow", "encoding", "journal" };
+    const Test tests[] = {
+        Headless::RunSaveTest, Headless::RunCancelTest, Headless::RunWatchOverflowTest,
+        Headless::RunEncodingTest, Headless::RunJournalTest
+    };
+    const int count = sizeof(tests) / sizeof(tests[0]);
+
+    Headless::Options options;
+    std::vector<std::string> selected;
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--root") && i + 1 < argc)
+            options.root = argv[++i];
+        else if (!strcmp(argv[i], "--keep"))
+            options.keep = true;
+        else
+            selected.push_back(argv[i]);
+    }
+    for (size_t i = 0; i < selected.size(); i++) {
+        int j = 0;
+        while (j < count && selected[i] != names[j])
+            j++;
+        if (j == count) {
+            fprintf(stderr, "Unknown test %s\n", selected[i].c_str());
+            return 1;
+        }
+    }
+
+    bool madeRoot = false;
+    if (options.root.empty()) {
+        char tmpl[] = "/tmp/brackets_test_XXXXXX";
+        if (!mkdtemp(tmpl)) {
+            perror("mkdtemp");
+            return 1;
+        }
+        options.root = tmpl;
+        madeRoot = true;
+
+        // Run as root, the save test checks permissions as another user,
+        // who has to be able to reach its files
+        chmod(options.root.c_str(), 0755);
+    }
+    const std::string root = options.root;
+
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), names[i]) == selected.end())
+            continue;
+        options.root = root + "/" + names[i];
+        if (mkdir(options.root.c_str(), 0777) == -1) {
+            perror(options.root.c_str());
+            return 1;
+        }
+        printf("%s\n", names[i]);
+        double start = Headless::Now();
+        int result = tests[i](handler, options);
+        printf("%s %s (%.0f ms)\n", result == 0 ? "PASS" : "FAIL", names[i], (Headless::Now() - start) * 1000);
+        failed += result != 0;
+    }
+
+    if (madeRoot && !options.keep)
+        Headless::RemoveTree(root);
+
+    return failed ? 1 : 0;
+}
+
+void PrintUsage()
+{
+    fprintf(stderr,
+            "usage: brackets_headless call <NativeFunction> [args...]\n"
+            "       brackets_headless bench [fs|async|read|layout|encoding|diff|hash|contentcache|\n"
+            "                                journal|write|saveall|stream|watch|statcache|walk|\n"
+            "                                search|regex|index|quickopen|pathstore|handles|\n"
+            "                                snapshot|marshal|dispatch]\n"
+            "                               [--files N] [--per-dir N] [--iterations N] [--size MB]\n"
+            "                               [--root DIR] [--keep]\n"
+            "       brackets_headless test [save|cancel|overflow|encoding|journal...]\n"
+            "                              [--root DIR] [--keep]\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    CefRefPtr<CefV8Handler> handler = new HeadlessExtensionHandler();
+
+    // The host stands in for the page's JS, which calls the natives from
+    // inside its context
+    CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+    context->Enter();
+
+    int result = 1;
+    if (argc >= 3 && !strcmp(argv[1], "call"))
+        result = RunCall(handler, argc - 2, argv + 2);
+    else if (argc >= 2 && !strcmp(argv[1], "bench"))
+        result = RunBenchmark(handler, argc - 2, argv + 2);
+    else if (argc >= 2 && !strcmp(argv[1], "test"))
+        result = RunTests(handler, argc - 2, argv + 2);
+    else
+        PrintUsage();
+
+    context->Exit();
+    return result;
+}
@@ -0,0 +1,513 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#include "headless_tests.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_watcher.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Headless {
+
+namespace {
+
+// Who the permission checks run as when the tests run as root, which may
+// write anything
+const uid_t kNobody = 65534;
+
+int Save(CefRefPtr<CefV8Handler> handler, const std::string& path, const std::string& text,
+         const char* encoding = "utf8")
+{
+    CefRefPtr<CefV8Value> retval;
+    return Call(handler, "WriteFile", Args(CefV8Value::CreateString(path), CefV8Value::CreateString(text),
+                                           CefV8Value::CreateString(encoding)), retval);
+}
+
+bool HasText(const std::string& path, const std::string& text)
+{
+    std::string contents;
+    return ReadWhole(path, contents) && contents == text;
+}
+
+// The inode of |path|, which a save that replaces the file changes, or 0
+ino_t GetInode(const std::string& path)
+{
+    struct stat buffer;
+    return stat(path.c_str(), &buffer) == 0 ? buffer.st_ino : 0;
+}
+
+// Whether a save left one of its temporary files in |dir|
+bool HasTempFiles(const std::string& dir)
+{
+    std::vector<std::string> names;
+    Brackets::FileSystem::ReadDir(dir, names);
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i][0] == '.' && names[i].size() > 4 && names[i].compare(names[i].size() - 4, 4, ".tmp") == 0)
+            return true;
+    }
+    return false;
+}
+
+// Starts the async function |name| with |callback| added to |arguments| and
+// returns the error of the call. |id| is the request's id.
+int Start(CefRefPtr<CefV8Handler> handler, const char* name, CefV8ValueList arguments,
+          CefRefPtr<ResultCallback> callback, int& id)
+{
+    arguments.push_back(CefV8Value::CreateFunction("callback", callback.get()));
+    CefRefPtr<CefV8Value> retval;
+    int error = Call(handler, name, arguments, retval);
+    id = error == NO_ERROR ? retval->GetIntValue() : 0;
+    return error;
+}
+
+bool CancelRequest(CefRefPtr<CefV8Handler> handler, int id)
+{
+    CefRefPtr<CefV8Value> retval;
+    return Call(handler, "CancelRequest", Args(CefV8Value::CreateInt(id)), retval) == NO_ERROR &&
+           retval->GetBoolValue();
+}
+
+// Reads |path| with ReadFile in |encoding|. |found| is the encoding ReadFile
+// reported, for 'auto'.
+int ReadText(CefRefPtr<CefV8Handler> handler, const std::string& path, const char* encoding,
+             std::string& text, std::string& found)
+{
+    CefRefPtr<CefV8Value> retval;
+    int error = Call(handler, "ReadFile", Args(CefV8Value::CreateString(path), CefV8Value::CreateString(encoding)),
+                     retval);
+    if (error != NO_ERROR)
+        return error;
+    if (retval->IsString()) {
+        text = retval->GetStringValue();
+        found = encoding;
+    } else {
+        text = retval->GetValue("data")->GetStringValue();
+        found = retval->GetValue("encoding")->GetStringValue();
+    }
+    return NO_ERROR;
+}
+
+// Replays the journal at |path|, which must have recorded one document.
+// |text| is the text it got back.
+int ReplayOne(CefRefPtr<CefV8Handler> handler, const std::string& path, std::string& text, bool& truncated)
+{
+    CefRefPtr<CefV8Value> result;
+    int error = CallAndWait(handler, "ReplayEditJournalAsync", Args(CefV8Value::CreateString(path)), result);
+    if (error != NO_ERROR)
+        return error;
+    CefRefPtr<CefV8Value> documents = result->GetValue("documents");
+    if (documents->GetArrayLength() != 1 || !documents->GetValue(0)->GetValue("text")->IsString())
+        return ERR_UNKNOWN;
+    text = documents->GetValue(0)->GetValue("text")->GetStringValue();
+    truncated = result->GetValue("truncated")->GetBoolValue();
+    return NO_ERROR;
+}
+
+} // namespace
+
+int RunSaveTest(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    const std::string& root = options.root;
+
+    // A save replaces the file with a new one
+    std::string path = root + "/plain.txt";
+    WriteInPlace(path, "old\n");
+    ino_t inode = GetInode(path);
+    if (Save(handler, path, "new\n") != NO_ERROR || !HasText(path, "new\n") || GetInode(path) == inode) {
+        fprintf(stderr, "WriteFile did not replace the file\n");
+        return 1;
+    }
+
+    // Replacing one of several hard links would split it from the others
+    std::string linked = root + "/linked.txt";
+    link(path.c_str(), linked.c_str());
+    inode = GetInode(path);
+    if (Save(handler, linked, "both\n") != NO_ERROR || GetInode(linked) != inode || !HasText(path, "both\n")) {
+        fprintf(stderr, "WriteFile to a hard link did not write the file in place\n");
+        return 1;
+    }
+
+    // A symlink to a file that is not there yet, through another symlink
+    std::string first = root + "/first.txt";
+    std::string created = root + "/created.txt";
+    symlink("dangling.txt", first.c_str());
+    symlink("created.txt", (root + "/dangling.txt").c_str());
+    struct stat buffer;
+    if (Save(handler, first, "created\n") != NO_ERROR || !HasText(created, "created\n") ||
+        lstat(first.c_str(), &buffer) != 0 || !S_ISLNK(buffer.st_mode)) {
+        fprintf(stderr, "WriteFile through a dangling symlink did not create its target\n");
+        return 1;
+    }
+
+    std::string loop = root + "/loop.txt";
+    symlink("loop.txt", loop.c_str());
+    int error = Save(handler, loop, "loop\n");
+    if (error == NO_ERROR || lstat(loop.c_str(), &buffer) != 0 || !S_ISLNK(buffer.st_mode)) {
+        fprintf(stderr, "WriteFile through a symlink loop returned %d\n", error);
+        return 1;
+    }
+
+    mkdir((root + "/directory").c_str(), 0777);
+    if ((error = Save(handler, root + "/directory", "text\n")) != ERR_NOT_FILE) {
+        fprintf(stderr, "WriteFile over a directory returned %d\n", error);
+        return 1;
+    }
+    if ((error = Save(handler, root + "/missing/file.txt", "text\n")) != ERR_NOT_FOUND) {
+        fprintf(stderr, "WriteFile into a missing directory returned %d\n", error);
+        return 1;
+    }
+
+    // What a user can't replace. Root can, so as root these run as nobody,
+    // who owns the locked directory and its file, but not the others.
+    bool asRoot = geteuid() == 0;
+    std::string locked = root + "/locked";
+    std::string lockedPath = locked + "/document.txt";
+    std::string theirs = root + "/theirs.txt";
+    std::string readOnly = root + "/readonly.txt";
+    mkdir(locked.c_str(), 0777);
+    WriteInPlace(lockedPath, "old\n");
+    WriteInPlace(theirs, "old\n");
+    WriteInPlace(readOnly, "old\n");
+    chmod(theirs.c_str(), 0666);
+    chmod(readOnly.c_str(), 0444);
+    if (asRoot) {
+        chmod(root.c_str(), 0777);
+        chown(locked.c_str(), kNobody, kNobody);
+        chown(lockedPath.c_str(), kNobody, kNobody);
+    }
+    chmod(locked.c_str(), 0555);
+
+    if (asRoot && setresuid(kNobody, kNobody, 0) != 0) {
+        perror("setresuid");
+        return 1;
+    }
+    ino_t lockedInode = GetInode(lockedPath);
+    int lockedError = Save(handler, lockedPath, "new\n");
+    ino_t theirsInode = GetInode(theirs);
+    int theirsError = asRoot ? Save(handler, theirs, "new\n") : NO_ERROR;
+    int readOnlyError = Save(handler, readOnly, "new\n");
+    if (asRoot && setresuid(0, 0, 0) != 0) {
+        perror("setresuid");
+        return 1;
+    }
+    chmod(locked.c_str(), 0777);
+
+    // The file may be writable in a directory that isn't
+    if (lockedError != NO_ERROR || GetInode(lockedPath) != lockedInode || !HasText(lockedPath, "new\n")) {
+        fprintf(stderr, "WriteFile in a directory that can't be written returned %d, or replaced the file\n",
+                lockedError);
+        return 1;
+    }
+    // The new file can't be given the old one's owner
+    if (!asRoot) {
+        printf("  not run as root: skipped saving a file owned by another user\n");
+    } else if (theirsError != NO_ERROR || GetInode(theirs) != theirsInode || !HasText(theirs, "new\n") ||
+               stat(theirs.c_str(), &buffer) != 0 || buffer.st_uid != 0) {
+        fprintf(stderr, "WriteFile of a file owned by another user returned %d, or changed its owner\n",
+                theirsError);
+        return 1;
+    }
+    if (readOnlyError != ERR_CANT_WRITE || !HasText(readOnly, "old\n")) {
+        fprintf(stderr, "WriteFile over a read-only file returned %d\n", readOnlyError);
+        return 1;
+    }
+
+    if (HasTempFiles(root) || HasTempFiles(locked)) {
+        fprintf(stderr, "WriteFile left a temporary file behind\n");
+        return 1;
+    }
+    return 0;
+}
+
+int RunCancelTest(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    // Large enough that hashing it takes a while. Sparse, so it is quick to
+    // make.
+    std::string path = options.root + "/large.bin";
+    if (!WriteInPlace(path, "") || truncate(path.c_str(), (off_t)options.fileSizeMB * 1024 * 1024) != 0) {
+        fprintf(stderr, "Could not create %s\n", path.c_str());
+        return 1;
+    }
+    CefRefPtr<CefV8Value> bypassCache = CefV8Value::CreateObject(NULL);
+    bypassCache->SetValue("bypassCache", CefV8Value::CreateBool(true), V8_PROPERTY_ATTRIBUTE_NONE);
+    CefV8ValueList hash = Args(CefV8Value::CreateString(path), CefV8Value::CreateString("xxh3"), bypassCache);
+
+    // The callback is called from CancelRequest, and never again
+    CefRefPtr<ResultCallback> callback = new ResultCallback();
+    int id;
+    if (Start(handler, "HashFileAsync", hash, callback, id) != NO_ERROR || !CancelRequest(handler, id) ||
+        callback->m_calls != 1 || callback->m_error != ERR_CANCELLED) {
+        fprintf(stderr, "A cancelled request did not report ERR_CANCELLED\n");
+        return 1;
+    }
+    // Takes the quit the callback left for a loop that was not running
+    CefRunMessageLoop();
+    RunMessageLoopFor(500);
+    if (callback->m_calls != 1 || CancelRequest(handler, id)) {
+        fprintf(stderr, "A cancelled request was reported again, or could be cancelled again\n");
+        return 1;
+    }
+
+    // A request that runs out of time
+    CefV8ValueList timed = hash;
+    callback = new ResultCallback();
+    timed.push_back(CefV8Value::CreateFunction("callback", callback.get()));
+    timed.push_back(CefV8Value::CreateInt(1));
+    CefRefPtr<CefV8Value> retval;
+    if (Call(handler, "HashFileAsync", timed, retval) != NO_ERROR)
+        return 1;
+    CefRunMessageLoop();
+    RunMessageLoopFor(500);
+    if (callback->m_calls != 1 || callback->m_error != ERR_TIMEOUT) {
+        fprintf(stderr, "A request that ran out of time was reported %d times, with %d\n", callback->m_calls,
+                callback->m_error);
+        return 1;
+    }
+
+    // One that finishes in time is not timed out later
+    std::string small = options.root + "/small.txt";
+    WriteInPlace(small, "small\n");
+    CefV8ValueList read = Args(CefV8Value::CreateString(small), CefV8Value::CreateString("utf8"));
+    timed = read;
+    callback = new ResultCallback();
+    timed.push_back(CefV8Value::CreateFunction("callback", callback.get()));
+    timed.push_back(CefV8Value::CreateInt(200));
+    if (Call(handler, "ReadFileAsync", timed, retval) != NO_ERROR)
+        return 1;
+    CefRunMessageLoop();
+    RunMessageLoopFor(500);
+    if (callback->m_calls != 1 || callback->m_error != NO_ERROR ||
+        callback->m_result->GetStringValue().ToString() != "small\n") {
+        fprintf(stderr, "A request that finished in time was reported %d times, with %d\n", callback->m_calls,
+                callback->m_error);
+        return 1;
+    }
+
+    // A timeout that is not a number is refused, and the callback not called
+    timed = read;
+    callback = new ResultCallback();
+    timed.push_back(CefV8Value::CreateFunction("callback", callback.get()));
+    timed.push_back(CefV8Value::CreateString("soon"));
+    int error = Call(handler, "ReadFileAsync", timed, retval);
+    RunMessageLoopFor(100);
+    if (error != ERR_INVALID_PARAMS || callback->m_calls != 0) {
+        fprintf(stderr, "ReadFileAsync with a timeout that is not a number returned %d\n", error);
+        return 1;
+    }
+    return 0;
+}
+
+int RunWatchOverflowTest(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    // Long enough to create every file inside the first window
+    const int latencyMs = 3000;
+    const int files = 10001;
+
+    const std::string& root = options.root;
+    CefRefPtr<ChangeCollector> collector = new ChangeCollector();
+    CefRefPtr<CefV8Value> retval;
+    if (Call(handler, "WatchPath", Args(CefV8Value::CreateString(root),
+                                        CefV8Value::CreateFunction("onChange", collector.get()),
+                                        CefV8Value::CreateInt(latencyMs)), retval) != NO_ERROR) {
+        fprintf(stderr, "WatchPath failed\n");
+        return 1;
+    }
+    CefRefPtr<CefV8Value> watcher = retval;
+
+    // Wait for the watcher to start
+    std::string marker = root + "/marker.txt";
+    int kind = 0;
+    for (int i = 0; !kind && i < 10; i++) {
+        WriteInPlace(marker, LogLine(i));
+        kind = WaitForChange(collector, marker, latencyMs + 1000);
+    }
+    if (!kind) {
+        fprintf(stderr, "The watcher never saw a change\n");
+        return 1;
+    }
+
+    collector->Clear();
+    double start = Now();
+    char name[64];
+    for (int i = 0; i < files; i++) {
+        snprintf(name, sizeof(name), "/file%05d.txt", i);
+        if (!WriteInPlace(root + name, "x\n")) {
+            fprintf(stderr, "Could not create %s\n", name);
+            return 1;
+        }
+    }
+    if (Now() - start > latencyMs / 1000.0) {
+        printf("  creating %d files took longer than the window: skipped\n", files);
+    } else {
+        kind = WaitForChange(collector, root, latencyMs + 5000);
+        if (kind != Brackets::FileSystem::CHANGE_RESCAN || collector->m_changes.size() != 1) {
+            fprintf(stderr, "%d new files were reported as %lu changes, the root as %d\n", files,
+                    (unsigned long)collector->m_changes.size(), kind);
+            return 1;
+        }
+    }
+
+    // Changes after the rescan are reported one by one again
+    collector->Clear();
+    std::string after = root + "/after.txt";
+    WriteInPlace(after, "after\n");
+    kind = WaitForChange(collector, after, latencyMs + 5000);
+    if (kind != Brackets::FileSystem::CHANGE_CREATED || collector->m_changes.size() != 1) {
+        fprintf(stderr, "A file created after the rescan was reported as %d, among %lu changes\n", kind,
+                (unsigned long)collector->m_changes.size());
+        return 1;
+    }
+
+    Call(handler, "UnwatchPath", Args(watcher), retval);
+    return 0;
+}
+
+int RunEncodingTest(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    const std::string text = "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80\r\nline two\n";
+    const char* const encodings[] = { "utf8", "utf8bom", "utf16le", "utf16be" };
+    const std::string boms[] = { "", "\xEF\xBB\xBF", "\xFF\xFE", "\xFE\xFF" };
+    std::string path = options.root + "/text.txt";
+    std::string bytes;
+    std::string again;
+    std::string readBack;
+    std::string found;
+    int error;
+
+    // Saved with its byte order mark, read back the same, and found again by
+    // 'auto', so saving it with what 'auto' found gives the same bytes
+    for (size_t i = 0; i < sizeof(encodings) / sizeof(encodings[0]); i++) {
+        if ((error = Save(handler, path, text, encodings[i])) != NO_ERROR || !ReadWhole(path, bytes) ||
+            bytes.compare(0, boms[i].size(), boms[i]) != 0 || bytes.size() <= boms[i].size() + text.size() / 2) {
+            fprintf(stderr, "WriteFile in %s returned %d, or wrote the wrong bytes\n", encodings[i], error);
+            return 1;
+        }
+        if ((error = ReadText(handler, path, encodings[i], readBack, found)) != NO_ERROR || readBack != text) {
+            fprintf(stderr, "ReadFile in %s returned %d, or the wrong text\n", encodings[i], error);
+            return 1;
+        }
+        if ((error = ReadText(handler, path, "auto", readBack, found)) != NO_ERROR || readBack != text ||
+            found != encodings[i]) {
+            fprintf(stderr, "ReadFile with 'auto' of a %s file returned %d, found %s\n", encodings[i], error,
+                    found.c_str());
+            return 1;
+        }
+        if (Save(handler, path, readBack, found.c_str()) != NO_ERROR || !ReadWhole(path, again) ||
+            again != bytes) {
+            fprintf(stderr, "A %s file did not come back the same after a round trip\n", encodings[i]);
+            return 1;
+        }
+    }
+
+    // Latin-1 is a byte per character, and what isn't UTF-8 is taken for it
+    const std::string latin1Text = "caf\xC3\xA9 na\xC3\xAFve\n";
+    if (Save(handler, path, latin1Text, "latin1") != NO_ERROR || !HasText(path, "caf\xE9 na\xEFve\n") ||
+        ReadText(handler, path, "latin1", readBack, found) != NO_ERROR || readBack != latin1Text ||
+        ReadText(handler, path, "auto", readBack, found) != NO_ERROR || found != "latin1") {
+        fprintf(stderr, "Latin-1 text did not survive a round trip\n");
+        return 1;
+    }
+    // Text Latin-1 can't hold is refused, and the file left alone
+    if ((error = Save(handler, path, text, "latin1")) != ERR_UNSUPPORTED_ENCODING ||
+        !HasText(path, "caf\xE9 na\xEFve\n")) {
+        fprintf(stderr, "WriteFile in Latin-1 of a euro sign returned %d\n", error);
+        return 1;
+    }
+
+    // Files that are not valid in the encoding they are read in. 'auto'
+    // takes an odd number of bytes for Latin-1 despite the byte order mark.
+    WriteInPlace(path, std::string("\xFF\xFE" "a\0b", 5));
+    if ((error = ReadText(handler, path, "utf16le", readBack, found)) != ERR_UNSUPPORTED_ENCODING ||
+        (error = ReadText(handler, path, "auto", readBack, found)) != NO_ERROR || found != "latin1") {
+        fprintf(stderr, "ReadFile of an odd number of UTF-16 bytes returned %d\n", error);
+        return 1;
+    }
+    WriteInPlace(path, "caf\xE9\n");
+    if ((error = ReadText(handler, path, "utf8", readBack, found)) != ERR_UNSUPPORTED_ENCODING) {
+        fprintf(stderr, "ReadFile in UTF-8 of a Latin-1 file returned %d\n", error);
+        return 1;
+    }
+
+    if ((error = ReadText(handler, path, "ebcdic", readBack, found)) != ERR_UNSUPPORTED_ENCODING ||
+        (error = Save(handler, path, text, "ebcdic")) != ERR_UNSUPPORTED_ENCODING ||
+        (error = Save(handler, path, text, "auto")) != ERR_UNSUPPORTED_ENCODING) {
+        fprintf(stderr, "An encoding that can't be used returned %d\n", error);
+        return 1;
+    }
+    return 0;
+}
+
+int RunJournalTest(CefRefPtr<CefV8Handler> handler, const Options& options)
+{
+    std::string journal = options.root + "/session.journal";
+    std::string cut = options.root + "/cut.journal";
+    CefRefPtr<CefV8Value> document = CefV8Value::CreateString(options.root + "/document.js");
+    CefRefPtr<CefV8Value> retval;
+
+    // Two flushes, so the last record is written on its own
+    if (Call(handler, "OpenEditJournal", Args(CefV8Value::CreateString(journal)), retval) != NO_ERROR ||
+        Call(handler, "JournalSnapshot", Args(document, CefV8Value::CreateString("hello\n")), retval) != NO_ERROR ||
+        Call(handler, "JournalEdit", Args(document, CefV8Value::CreateInt(5), CefV8Value::CreateInt(0),
+                                          CefV8Value::CreateString(" world")), retval) != NO_ERROR ||
+        CallAndWait(handler, "FlushEditJournalAsync", CefV8ValueList(), retval) != NO_ERROR) {
+        fprintf(stderr, "Could not write the journal\n");
+        return 1;
+    }
+    std::string contents;
+    ReadWhole(journal, contents);
+    size_t whole = contents.size();
+    if (Call(handler, "JournalEdit", Args(document, CefV8Value::CreateInt(0), CefV8Value::CreateInt(0),
+                                          CefV8Value::CreateString("// ")), retval) != NO_ERROR ||
+        Call(handler, "CloseEditJournal", CefV8ValueList(), retval) != NO_ERROR || !ReadWhole(journal, contents) ||
+        contents.size() <= whole) {
+        fprintf(stderr, "Could not write the last record of the journal\n");
+        return 1;
+    }
+
+    std::string text;
+    bool truncated;
+    int error = ReplayOne(handler, journal, text, truncated);
+    if (error != NO_ERROR || text != "// hello world\n" || truncated) {
+        fprintf(stderr, "Replaying the whole journal returned %d\n", error);
+        return 1;
+    }
+
+    // Cut anywhere in the last record, the journal gives back all the
+    // records before it
+    for (size_t size = whole; size < contents.size(); size++) {
+        WriteInPlace(cut, contents.substr(0, size));
+        error = ReplayOne(handler, cut, text, truncated);
+        if (error != NO_ERROR || text != "hello world\n" || truncated != (size > whole)) {
+            fprintf(stderr, "Replaying the journal cut at %lu of %lu bytes returned %d, truncated %d\n",
+                    (unsigned long)size, (unsigned long)contents.size(), error, (int)truncated);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+} // namespace Headless
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+
+#ifndef _HEADLESS_TESTS_H
+#define _HEADLESS_TESTS_H
+
+#include "headless_fixture.h"
+
+/**
+ * Correctness tests for the error paths of the native functions, the ones
+ * the benchmarks only pass through: run by brackets_headless test. Each
+ * works in |options.root| and returns 0, or 1 with what went wrong printed
+ * on stderr.
+ */
+namespace Headless {
+
+// Saves with WriteFile where the file can't simply be replaced: through
+// hard links and symlinks, dangling or in a loop, over a directory, into a
+// directory that is missing or can't be written, over a file whose owner
+// can't be kept and over a read-only file
+int RunSaveTest(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Cancels an async request right after it starts and lets others time out,
+// checking that each callback is called once and with the right error
+int RunCancelTest(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Creates more files inside one WatchPath window than the watcher keeps,
+// which must be reported as a single rescan of the root
+int RunWatchOverflowTest(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Saves and reads back text in each encoding, and checks the files and the
+// text that must be refused
+int RunEncodingTest(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+// Replays an edit journal cut off at every byte of its last record
+int RunJournalTest(CefRefPtr<CefV8Handler> handler, const Options& options);
+
+} // namespace Headless
+
+#endif // _HEADLESS_TESTS_H
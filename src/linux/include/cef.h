@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2012 Adobe Systems Incorporated. All rights reserved.
+ *  
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ *  
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *  
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ * 
+ */ 
+
+#ifndef _CEF_H
+#define _CEF_H
+
+// Minimal stand-in for the CEF1 API used by the shared Brackets native code.
+// It declares only what src/common needs, with the same signatures as the
+// real include/cef.h, so the file system bridge can be built and profiled
+// headless on Linux. Strings are stored as UTF-8.
+
+#include "include/internal/cef_build.h"
+
+#include <string>
+#include <vector>
+#include <time.h>
+
+///
+// Reference counting
+///
+class CefBase
+{
+public:
+    virtual int AddRef() =0;
+    virtual int Release() =0;
+    virtual int GetRefCt() =0;
+
+protected:
+    virtual ~CefBase() {}
+};
+
+class CefRefCount
+{
+public:
+    CefRefCount() : refct_(0) {}
+
+    int AddRef() { return __sync_add_and_fetch(&refct_, 1); }
+    int Release() { return __sync_sub_and_fetch(&refct_, 1); }
+    int GetRefCt() { return refct_; }
+
+private:
+    volatile int refct_;
+};
+
+#define IMPLEMENT_REFCOUNTING(ClassName)            \
+  public:                                           \
+    int AddRef() { return refct_.AddRef(); }        \
+    int Release() {                                 \
+      int retval = refct_.Release();                \
+      if (retval == 0)                              \
+        delete this;                                \
+      return retval;                                \
+    }                                               \
+    int GetRefCt() { return refct_.GetRefCt(); }    \
+  private:                                          \
+    CefRefCount refct_;
+
+template <class T>
+class CefRefPtr
+{
+public:
+    CefRefPtr() : ptr_(NULL) {}
+    CefRefPtr(T* p) : ptr_(p) { if (ptr_) ptr_->AddRef(); }
+    CefRefPtr(const CefRefPtr<T>& r) : ptr_(r.ptr_) { if (ptr_) ptr_->AddRef(); }
+    template <class U>
+    CefRefPtr(const CefRefPtr<U>& r) : ptr_(r.get()) { if (ptr_) ptr_->AddRef(); }
+    ~CefRefPtr() { if (ptr_) ptr_->Release(); }
+
+    T* get() const { return ptr_; }
+    operator T*() const { return ptr_; }
+    T* operator->() const { return ptr_; }
+
+    CefRefPtr<T>& operator=(T* p) {
+        if (p)
+            p->AddRef();
+        T* old = ptr_;
+        ptr_ = p;
+        if (old)
+            old->Release();
+        return *this;
+    }
+    CefRefPtr<T>& operator=(const CefRefPtr<T>& r) { return *this = r.ptr_; }
+
+private:
+    T* ptr_;
+};
+
+///
+// UTF-8 backed CefString with the implicit conversions the real one has
+///
+class CefString
+{
+public:
+    CefString() {}
+    CefString(const char* src) : str_(src ? src : "") {}
+    CefString(const std::string& src) : str_(src) {}
+    CefString(const std::wstring& src);
+    CefString(const wchar_t* src);
+
+    operator std::string() const { return str_; }
+    operator std::wstring() const { return ToWString(); }
+
+    std::string ToString() const { return str_; }
+    std::wstring ToWString() const;
+
+    const char* c_str() const { return str_.c_str(); }
+    size_t length() const { return str_.length(); }
+    bool empty() const { return str_.empty(); }
+
+    bool operator<(const CefString& other) const { return str_ < other.str_; }
+
+private:
+    std::string str_;
+};
+
+inline bool operator==(const CefString& a, const CefString& b) { return a.ToString() == b.ToString(); }
+inline bool operator!=(const CefString& a, const CefString& b) { return !(a == b); }
+
+struct CefTime
+{
+    CefTime() : time(0) {}
+    CefTime(time_t r) : time((double)r) {}
+    CefTime(double r) : time(r) {}
+
+    time_t GetTimeT() const { return (time_t)time; }
+    double GetDoubleT() const { return time; }
+
+    // Seconds since the epoch
+    double time;
+};
+
+///
+// Threads and tasks
+///
+enum cef_thread_id_t
+{
+    TID_UI      = 0,
+    TID_IO      = 1,
+    TID_FILE    = 2
+};
+typedef cef_thread_id_t CefThreadId;
+
+class CefTask : public virtual CefBase
+{
+public:
+    virtual void Execute(CefThreadId threadId) =0;
+};
+
+bool CefCurrentlyOn(CefThreadId threadId);
+bool CefPostTask(CefThreadId threadId, CefRefPtr<CefTask> task);
+bool CefPostDelayedTask(CefThreadId threadId, CefRefPtr<CefTask> task,
+                        long delay_ms);
+
+// Runs tasks posted to TID_UI on the calling thread until CefQuitMessageLoop
+void CefRunMessageLoop();
+void CefQuitMessageLoop();
+
+///
+// V8
+///
+class CefV8Value;
+class CefV8Context;
+class CefV8Exception;
+
+typedef std::vector<CefRefPtr<CefV8Value> > CefV8ValueList;
+
+enum cef_v8_propertyattribute_t
+{
+    V8_PROPERTY_ATTRIBUTE_NONE       = 0,
+    V8_PROPERTY_ATTRIBUTE_READONLY   = 1 << 0,
+    V8_PROPERTY_ATTRIBUTE_DONTENUM   = 1 << 1,
+    V8_PROPERTY_ATTRIBUTE_DONTDELETE = 1 << 2
+};
+
+class CefV8Handler : public virtual CefBase
+{
+public:
+    virtual bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception) =0;
+};
+
+// There is a single context in the headless host
+class CefV8Context : public virtual CefBase
+{
+public:
+    static CefRefPtr<CefV8Context> GetCurrentContext();
+    static CefRefPtr<CefV8Context> GetEnteredContext();
+    static bool InContext();
+
+    virtual CefRefPtr<CefV8Value> GetGlobal() =0;
+    virtual bool Enter() =0;
+    virtual bool Exit() =0;
+    virtual bool IsSame(CefRefPtr<CefV8Context> that) =0;
+};
+
+class CefV8Exception : public virtual CefBase
+{
+public:
+    virtual CefString GetMessage() =0;
+};
+
+class CefV8Value : public virtual CefBase
+{
+public:
+    typedef cef_v8_propertyattribute_t PropertyAttribute;
+
+    static CefRefPtr<CefV8Value> CreateUndefined();
+    static CefRefPtr<CefV8Value> CreateNull();
+    static CefRefPtr<CefV8Value> CreateBool(bool value);
+    static CefRefPtr<CefV8Value> CreateInt(int value);
+    static CefRefPtr<CefV8Value> CreateDouble(double value);
+    static CefRefPtr<CefV8Value> CreateDate(const CefTime& date);
+    static CefRefPtr<CefV8Value> CreateString(const CefString& value);
+    static CefRefPtr<CefV8Value> CreateObject(CefRefPtr<CefBase> user_data);
+    static CefRefPtr<CefV8Value> CreateArray();
+    static CefRefPtr<CefV8Value> CreateFunction(const CefString& name,
+                                                CefRefPtr<CefV8Handler> handler);
+
+    virtual bool IsUndefined() =0;
+    virtual bool IsNull() =0;
+    virtual bool IsBool() =0;
+    virtual bool IsInt() =0;
+    virtual bool IsDouble() =0;
+    virtual bool IsDate() =0;
+    virtual bool IsString() =0;
+    virtual bool IsObject() =0;
+    virtual bool IsArray() =0;
+    virtual bool IsFunction() =0;
+
+    virtual bool IsSame(CefRefPtr<CefV8Value> that) =0;
+
+    virtual bool GetBoolValue() =0;
+    virtual int GetIntValue() =0;
+    virtual double GetDoubleValue() =0;
+    virtual CefTime GetDateValue() =0;
+    virtual CefString GetStringValue() =0;
+
+    virtual bool HasValue(const CefString& key) =0;
+    virtual bool HasValue(int index) =0;
+    virtual CefRefPtr<CefV8Value> GetValue(const CefString& key) =0;
+    virtual CefRefPtr<CefV8Value> GetValue(int index) =0;
+    virtual bool SetValue(const CefString& key, CefRefPtr<CefV8Value> value,
+                          PropertyAttribute attribute) =0;
+    virtual bool SetValue(int index, CefRefPtr<CefV8Value> value) =0;
+    virtual bool GetKeys(std::vector<CefString>& keys) =0;
+
+    virtual int GetArrayLength() =0;
+
+    virtual bool ExecuteFunction(CefRefPtr<CefV8Value> object,
+                                 const CefV8ValueList& arguments,
+                                 CefRefPtr<CefV8Value>& retval,
+                                 CefRefPtr<CefV8Exception>& exception,
+                                 bool rethrow_exception) =0;
+    virtual bool ExecuteFunctionWithContext(CefRefPtr<CefV8Context> context,
+                                            CefRefPtr<CefV8Value> object,
+                                            const CefV8ValueList& arguments,
+                                            CefRefPtr<CefV8Value>& retval,
+                                            CefRefPtr<CefV8Exception>& exception,
+                                            bool rethrow_exception) =0;
+};
+
+#endif // _CEF_H
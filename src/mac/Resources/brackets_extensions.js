@@ -24,7 +24,8 @@
 // This is the JavaScript code for bridging to native functionality
 // See brackets_extentions.mm for implementation of native methods.
 //
-// Note: All file native file i/o functions are synchronous, but are exposed
+// Note: readdir, readdirWithStats, readFile, writeFile and the stream reads run
+// natively off the UI thread. The remaining file i/o functions are synchronous, but are exposed
 // here as asynchronous calls. 
 
 /*jslint vars: true, plusplus: true, devel: true, browser: true, nomen: true, indent: 4, forin: true, maxerr: 50, regexp: true */
@@ -104,6 +105,51 @@ if (!brackets.app) {
      * @constant Specified path does not point to a directory.
      */
     brackets.fs.ERR_NOT_DIRECTORY           = 9;
+    
+    /**
+     * @constant The operation was cancelled before it completed.
+     */
+    brackets.fs.ERR_CANCELLED               = 10;
+    
+    /**
+     * @constant The operation did not complete within its timeout.
+     */
+    brackets.fs.ERR_TIMEOUT                 = 11;
+    
+    /**
+     * @constant writeFile does not wait for the data to reach the disk.
+     */
+    brackets.fs.DURABILITY_NONE             = 0;
+    
+    /**
+     * @constant writeFile flushes the file's data to disk before replacing the old file. The default.
+     */
+    brackets.fs.DURABILITY_DATA             = 1;
+    
+    /**
+     * @constant writeFile also flushes the directory and the disk's own cache, where the system allows.
+     */
+    brackets.fs.DURABILITY_FULL             = 2;
+    
+    /**
+     * @constant A file or directory was created, or moved into the watched directory.
+     */
+    brackets.fs.CHANGE_CREATED              = 1;
+    
+    /**
+     * @constant A file was written to, or its attributes changed.
+     */
+    brackets.fs.CHANGE_MODIFIED             = 2;
+    
+    /**
+     * @constant A file or directory was deleted, or moved out of the watched directory.
+     */
+    brackets.fs.CHANGE_DELETED              = 3;
+    
+    /**
+     * @constant Changes under the path were missed. Read the path again.
+     */
+    brackets.fs.CHANGE_RESCAN               = 4;
         
     /**
      * Invoke a callback function.
@@ -126,6 +172,14 @@ if (!brackets.app) {
         }
     }
     
+    /**
+     * Returns the list a native function returned, or an empty array if there
+     * was no result.
+     */
+    function toList(result) {
+        return result || [];
+    }
+    
     /**
      * Display the OS File Open dialog, allowing the user to select
      * files or directories.
@@ -150,10 +204,10 @@ if (!brackets.app) {
     native function ShowOpenDialog();
     brackets.fs.showOpenDialog = function (allowMultipleSelection, chooseDirectory, title, initialPath, fileTypes, callback) {
         setTimeout(function () {
-            var resultString = ShowOpenDialog(allowMultipleSelection, chooseDirectory,
-                                             title || 'Open', initialPath || '',
-                                             fileTypes ? fileTypes.join(' ') : '');
-            var result = JSON.parse(resultString || '[]');
+            var selection = ShowOpenDialog(allowMultipleSelection, chooseDirectory,
+                                          title || 'Open', initialPath || '',
+                                          fileTypes ? fileTypes.join(' ') : '');
+            var result = toList(selection);
             invokeCallback(callback, getLastError(), result);
         }, 0);
     };
@@ -162,6 +216,8 @@ if (!brackets.app) {
      * Reads the contents of a directory. 
      *
      * @param {string} path The path of the directory to read.
+     * @param {boolean=} bypassCache Optional. true to read the directory even if the stat cache
+     *        (see brackets.fs.setCacheRoot) has it.
      * @param {function(err, files)} callback Asynchronous callback function. The callback gets two arguments 
      *        (err, files) where files is an array of the names of the files
      *        in the directory excluding '.' and '..'.
@@ -172,21 +228,288 @@ if (!brackets.app) {
      *          ERR_NOT_FOUND
      *          ERR_CANT_READ
      *                 
-     * @return None. This is an asynchronous call that sends all return information to the callback.
+     * @return {number} Request id that can be passed to brackets.fs.cancel. This is an asynchronous
+     *         call that sends all return information to the callback.
      */
-    native function ReadDir();
-    brackets.fs.readdir = function (path, callback) {
-        var resultString = ReadDir(path);
-        var result = JSON.parse(resultString || '[]');
-        invokeCallback(callback, getLastError(), result);
+    native function ReadDirAsync();
+    brackets.fs.readdir = function (path, bypassCache, callback) {
+        if (typeof bypassCache === "function") {
+            callback = bypassCache;
+            bypassCache = false;
+        }
+        var requestId = ReadDirAsync(path, !!bypassCache, function (err, result) {
+            invokeCallback(callback, err, toList(result));
+        });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err, []);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Reads the contents of a directory together with the stats of every entry.
+     * This is a single native call, instead of a readdir followed by a stat
+     * for each entry.
+     *
+     * @param {string} path The path of the directory to read.
+     * @param {boolean=} bypassCache Optional. true to read the directory even if the stat cache
+     *        (see brackets.fs.setCacheRoot) has it.
+     * @param {function(err, entries)} callback Asynchronous callback function. The callback gets two arguments 
+     *        (err, entries) where entries is an array of {name, stats} objects, excluding '.' and '..'.
+     *        stats has the same isFile(), isDirectory() and mtime members as the result of
+     *        brackets.fs.stat, plus size (in bytes) and mtimeNsec (nanoseconds within the
+     *        second of mtime). Directories come first, then files, each sorted by name.
+     *        Possible error values:
+     *          NO_ERROR
+     *          ERR_UNKNOWN
+     *          ERR_INVALID_PARAMS
+     *          ERR_NOT_FOUND
+     *          ERR_CANT_READ
+     *                 
+     * @return {number} Request id that can be passed to brackets.fs.cancel. This is an asynchronous
+     *         call that sends all return information to the callback.
+     */
+    native function ReadDirWithStatsAsync();
+    function toDirEntries(result) {
+        return toList(result).map(function (entry) {
+            var isDir = entry.isDirectory;
+            return {
+                name: entry.name,
+                stats: {
+                    isFile: function () {
+                        return !isDir;
+                    },
+                    isDirectory: function () {
+                        return isDir;
+                    },
+                    mtime: new Date(entry.mtime),
+                    mtimeNsec: entry.mtimeNsec,
+                    size: entry.size
+                }
+            };
+        });
+    }
+    brackets.fs.readdirWithStats = function (path, bypassCache, callback) {
+        if (typeof bypassCache === "function") {
+            callback = bypassCache;
+            bypassCache = false;
+        }
+        var requestId = ReadDirWithStatsAsync(path, !!bypassCache, function (err, result) {
+            invokeCallback(callback, err, toDirEntries(result));
+        });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err, []);
+        }
+        return requestId;
+    };
+    
+    /**
+     * List everything under one or more directories, such as the folders of a project, in a
+     * single native call that reads directories in parallel. Excluded paths are never read:
+     * options.ignore and the .gitignore files found on the way are applied natively.
+     *
+     * @param {string|Array.<string>} roots The directory or directories to list.
+     * @param {{ignore: Array.<string>, gitignore: boolean, stats: boolean, maxDepth: number}=} options
+     *        Optional. ignore lists .gitignore-style patterns to leave out under every root, by
+     *        default [".git", "node_modules"]. gitignore (default true) applies .gitignore files.
+     *        stats (default false) adds size and mtime to every entry, at the cost of a stat per
+     *        file. maxDepth (default 64) limits how deep the walk goes.
+     * @param {function(root, entries)} onEntries Called with batches of entries as they are found,
+     *        always before callback. Paths are relative to root. Without stats, entries are paths
+     *        and directories end with '/'; with stats they are {name, stats} objects as in
+     *        readdirWithStats, name being the relative path.
+     * @param {function(err, summary)} callback Called when the walk is done. summary has counts of
+     *        files, directories, excluded entries, unreadable directories and symlink cycles that
+     *        were skipped, and rootErrors, the error code of each root.
+     *        Possible error values:
+     *          NO_ERROR
+     *          ERR_INVALID_PARAMS
+     *          ERR_CANCELLED
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel.
+     */
+    native function WalkTreeAsync();
+    brackets.fs.walk = function (roots, options, onEntries, callback) {
+        if (typeof options === "function") {
+            callback = onEntries;
+            onEntries = options;
+            options = {};
+        }
+        options = options || {};
+        var nativeOptions = {
+            ignore: options.ignore === undefined ? [".git", "node_modules"] : options.ignore,
+            gitignore: options.gitignore !== false,
+            stats: !!options.stats
+        };
+        if (options.maxDepth !== undefined) {
+            nativeOptions.maxDepth = options.maxDepth;
+        }
+        var requestId = WalkTreeAsync(typeof roots === "string" ? [roots] : roots, nativeOptions,
+            function (root, entries) {
+                invokeCallback(onEntries, root, nativeOptions.stats ? toDirEntries(entries) : toList(entries));
+            },
+            function (err, summary) {
+                invokeCallback(callback, err, summary);
+            });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Find a string or regular expression in every file under one or more directories, natively and
+     * in parallel, instead of reading each file into JS. Binary files are skipped. Files are chosen
+     * as in brackets.fs.walk, and options.include narrows them down further.
+     *
+     * @param {string|Array.<string>} paths Directories to search under, or files to search.
+     * @param {string} query The text to find, or with options.regex the source of a regular
+     *        expression. It can't contain a newline, and matches never span lines.
+     * @param {{caseSensitive: boolean, wholeWord: boolean, regex: boolean, include: Array.<string>,
+     *          maxMatches: number, index: string, ignore: Array.<string>, gitignore: boolean}=} options Optional.
+     *        caseSensitive defaults to false. wholeWord skips matches next to a letter, digit or
+     *        '_'. regex treats query as a regular expression; backreferences, lookaround and
+     *        case-insensitive patterns with non-ASCII characters are not supported and give
+     *        ERR_INVALID_PARAMS, in which case search the files with a RegExp instead. include
+     *        lists globs such as "*.js"; only matching files are searched. maxMatches (default
+     *        10000) stops the search once that many are found. index is the path of an index
+     *        written by brackets.fs.buildSearchIndex; files it shows can't match are not read, and
+     *        files changed since it was built are searched as usual. ignore and gitignore are as in
+     *        brackets.fs.walk.
+     * @param {function(results, searched, total)} onResults Called with batches of results as they
+     *        are found, and with how many of the total files have been searched. Each result is
+     *        {path, matches}, each match {line, ch, length, preview, previewCh}. line and ch count
+     *        from 0; preview is the text of the line, cut when it is long, with the match at
+     *        previewCh.
+     * @param {function(err, summary)} callback Called when the search is done. summary has counts
+     *        of files searched, matchedFiles, matches, binary and unreadable files, ruledOut, the
+     *        files the index answered for without reading them, and limitReached, true if the
+     *        search stopped at maxMatches.
+     *        Possible error values:
+     *          NO_ERROR
+     *          ERR_INVALID_PARAMS
+     *          ERR_CANCELLED
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel.
+     */
+    native function SearchFilesAsync();
+    brackets.fs.findInFiles = function (paths, query, options, onResults, callback) {
+        if (typeof options === "function") {
+            callback = onResults;
+            onResults = options;
+            options = {};
+        }
+        options = options || {};
+        var nativeOptions = {
+            ignore: options.ignore === undefined ? [".git", "node_modules"] : options.ignore,
+            gitignore: options.gitignore !== false,
+            caseSensitive: !!options.caseSensitive,
+            wholeWord: !!options.wholeWord,
+            regex: !!options.regex
+        };
+        if (options.include !== undefined) {
+            nativeOptions.include = options.include;
+        }
+        if (options.maxMatches !== undefined) {
+            nativeOptions.maxMatches = options.maxMatches;
+        }
+        if (options.index !== undefined) {
+            nativeOptions.index = options.index;
+        }
+        var requestId = SearchFilesAsync(typeof paths === "string" ? [paths] : paths, query, nativeOptions,
+            function (results, searched, total) {
+                invokeCallback(onResults, results, searched, total);
+            },
+            function (err, summary) {
+                invokeCallback(callback, err, summary);
+            });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Build or refresh the search index of a project, for the index option of brackets.fs.findInFiles.
+     * Files are read natively and in parallel. When indexPath already has an index of root, only
+     * files whose size or modification time changed since are read again, so call this again
+     * whenever the project is opened or has changed. Files are chosen as in brackets.fs.walk.
+     *
+     * @param {string} root The project directory.
+     * @param {string} indexPath Where to keep the index, for instance in the app's cache directory.
+     * @param {{maxFileSize: number, ignore: Array.<string>, gitignore: boolean}=} options Optional.
+     *        Files larger than maxFileSize bytes (default 1 MB) are not indexed, and always
+     *        searched. ignore and gitignore are as in brackets.fs.walk.
+     * @param {function(done, total)} onProgress Called now and then with how many of the total
+     *        files have been indexed.
+     * @param {function(err, summary)} callback Called when the index has been written. summary has
+     *        counts of files, files read, reused from the previous index and skipped, trigrams,
+     *        and the size of the index in bytes.
+     *        Possible error values:
+     *          NO_ERROR
+     *          ERR_INVALID_PARAMS
+     *          ERR_NOT_FOUND
+     *          ERR_NOT_DIRECTORY
+     *          ERR_CANT_WRITE
+     *          ERR_CANCELLED
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel.
+     */
+    native function BuildSearchIndexAsync();
+    brackets.fs.buildSearchIndex = function (root, indexPath, options, onProgress, callback) {
+        if (typeof options === "function") {
+            callback = onProgress;
+            onProgress = options;
+            options = {};
+        }
+        options = options || {};
+        var nativeOptions = {
+            ignore: options.ignore === undefined ? [".git", "node_modules"] : options.ignore,
+            gitignore: options.gitignore !== false
+        };
+        if (options.maxFileSize !== undefined) {
+            nativeOptions.maxFileSize = options.maxFileSize;
+        }
+        var requestId = BuildSearchIndexAsync(root, indexPath, nativeOptions,
+            function (done, total) {
+                invokeCallback(onProgress, done, total);
+            },
+            function (err, summary) {
+                invokeCallback(callback, err, summary);
+            });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Cancel a pending readdir, readdirWithStats, walk, findInFiles, buildSearchIndex, readFile or writeFile. Its callback is called
+     * right away with ERR_CANCELLED. The operation itself stops if it has not started yet.
+     *
+     * @param {number} requestId The value returned by the call to cancel.
+     *
+     * @return {boolean} true if the call was still pending.
+     */
+    native function CancelRequest();
+    brackets.fs.cancel = function (requestId) {
+        return CancelRequest(requestId);
     };
     
     /**
      * Get information for the selected file or directory.
      *
      * @param {string} path The path of the file or directory to read.
+     * @param {boolean=} bypassCache Optional. true to ask the file system even if the stat cache
+     *        (see brackets.fs.setCacheRoot) has the answer.
      * @param {function(err, stats)} callback Asynchronous callback function. The callback gets two arguments 
-     *        (err, stats) where stats is an object with isFile() and isDirectory() functions.
+     *        (err, stats) where stats is an object with isFile() and isDirectory() functions,
+     *        mtime, mtimeNsec and size, like the stats of brackets.fs.readdirWithStats.
      *        Possible error values:
      *          NO_ERROR
      *          ERR_UNKNOWN
@@ -195,11 +518,14 @@ if (!brackets.app) {
      *                 
      * @return None. This is an asynchronous call that sends all return information to the callback.
      */
-    native function IsDirectory();
-    native function GetFileModificationTime();
-    brackets.fs.stat = function (path, callback) {
-        var isDir = IsDirectory(path);
-        var modtime = GetFileModificationTime(path);
+    native function GetFileInfo();
+    brackets.fs.stat = function (path, bypassCache, callback) {
+        if (typeof bypassCache === "function") {
+            callback = bypassCache;
+            bypassCache = false;
+        }
+        var info = GetFileInfo(path, !!bypassCache) || {};
+        var isDir = !!info.isDirectory;
         invokeCallback(callback, getLastError(), {
             isFile: function () {
                 return !isDir;
@@ -207,7 +533,9 @@ if (!brackets.app) {
             isDirectory: function () {
                 return isDir;
             },
-            mtime: modtime
+            mtime: info.mtime,
+            mtimeNsec: info.mtimeNsec,
+            size: info.size
         });
     };
  
@@ -231,31 +559,243 @@ if (!brackets.app) {
      * Reads the entire contents of a file. 
      *
      * @param {string} path The path of the file to read.
-     * @param {string} encoding The encoding for the file. The only supported encoding is 'utf8'.
-     * @param {function(err, data)} callback Asynchronous callback function. The callback gets two arguments 
-     *        (err, data) where data is the contents of the file.
+     * @param {string} encoding The encoding of the file: 'utf8', 'utf8bom', 'utf16le', 'utf16be',
+     *        'latin1', or 'auto' to go by the byte order mark, else UTF-8 if the file is valid UTF-8,
+     *        else Latin-1. 'utf8' keeps a byte order mark as part of data; the others drop it.
+     * @param {{layout: boolean}=} options Optional. Set layout to also find, in the same pass as the
+     *        read, where each line starts, the line endings and the indentation of the file.
+     * @param {function(err, data, layout)} callback Asynchronous callback function. The callback gets
+     *        two arguments (err, data) where data is the contents of the file. With options.layout or
+     *        an encoding other than 'utf8' it gets a third, layout, an object with the encoding the
+     *        file was found in, which writeFile takes to save it the same way, and with
+     *        options.layout these properties:
+     *          lineStarts  Array of the offset in data of the start of each line. A file that ends
+     *                      with a line ending has an empty last line, as with data.split.
+     *          lineEnding  The most common line ending, "\n", "\r\n" or "\r", or null if the
+     *                      file is a single line.
+     *          lf, crlf, cr  The number of each line ending; more than one is non-zero if the
+     *                      endings are mixed.
+     *          indent      "tabs" or "spaces", whichever indents more lines, or null.
+     *          indentSize  The most common step in indentation with spaces, or 0.
+     *          tabLines, spaceLines  The number of lines indented with each.
+     *          encoding    "utf8", "utf8bom", "utf16le", "utf16be" or "latin1".
      *        Possible error values:
      *          NO_ERROR
      *          ERR_UNKNOWN
      *          ERR_INVALID_PARAMS
      *          ERR_NOT_FOUND
      *          ERR_CANT_READ
-     *          ERR_UNSUPPORTED_ENCODING
+     *          ERR_UNSUPPORTED_ENCODING (also for a file that is not valid in encoding)
      *                 
-     * @return None. This is an asynchronous call that sends all return information to the callback.
+     * @return {number} Request id that can be passed to brackets.fs.cancel. This is an asynchronous
+     *         call that sends all return information to the callback.
+     */
+    native function ReadFileAsync();
+    brackets.fs.readFile = function (path, encoding, options, callback) {
+        if (typeof options === "function") {
+            callback = options;
+            options = {};
+        }
+        options = options || {};
+        var requestId;
+        if (options.layout || encoding !== "utf8") {
+            var done = function (err, result) {
+                if (err !== brackets.fs.NO_ERROR) {
+                    invokeCallback(callback, err);
+                    return;
+                }
+                var data = result.data;
+                delete result.data;
+                invokeCallback(callback, err, data, result);
+            };
+            if (options.layout) {
+                requestId = ReadFileAsync(path, encoding, true, done);
+            } else {
+                requestId = ReadFileAsync(path, encoding, done);
+            }
+        } else {
+            requestId = ReadFileAsync(path, encoding, function (err, contents) {
+                invokeCallback(callback, err, contents);
+            });
+        }
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Compare the text of an open document with its file as it is on disk now, line by line, without
+     * reading the file into JS. Lines end after each "\n" and include it. Only the lines that
+     * changed are passed back, so a file that changed on disk can be reloaded into the document hunk
+     * by hunk, which keeps cursors and undo history in the unchanged parts.
+     *
+     * @param {string} path The path of the file.
+     * @param {string} text The text of the document.
+     * @param {string} encoding The encoding of the file, as for brackets.fs.readFile.
+     * @param {function(err, hunks, lineCounts)} callback Asynchronous callback function. The
+     *        callback gets three arguments (err, hunks, lineCounts). hunks is an array of
+     *        {oldStart, oldCount, newStart, newCount, text} objects, in order: oldCount lines of
+     *        the document from line oldStart (from 0) become the newCount lines of the file from
+     *        line newStart, whose text is text. Applying the hunks to the document, last first,
+     *        gives the contents of the file; none means they are the same. lineCounts is
+     *        {oldLines, newLines}. Hunks are the fewest lines that change, except in regions with
+     *        thousands of changes.
+     *        Possible error values:
+     *          NO_ERROR
+     *          ERR_UNKNOWN
+     *          ERR_INVALID_PARAMS
+     *          ERR_NOT_FOUND
+     *          ERR_CANT_READ
+     *          ERR_UNSUPPORTED_ENCODING
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel. This is an asynchronous
+     *         call that sends all return information to the callback.
+     */
+    native function DiffFileAsync();
+    brackets.fs.diffFile = function (path, text, encoding, callback) {
+        var requestId = DiffFileAsync(path, text, encoding, function (err, result) {
+            if (err !== brackets.fs.NO_ERROR) {
+                invokeCallback(callback, err);
+                return;
+            }
+            var hunks = [], i;
+            for (i = 0; i < result.texts.length; i++) {
+                hunks.push({
+                    oldStart: result.hunks[i * 4],
+                    oldCount: result.hunks[i * 4 + 1],
+                    newStart: result.hunks[i * 4 + 2],
+                    newCount: result.hunks[i * 4 + 3],
+                    text: result.texts[i]
+                });
+            }
+            invokeCallback(callback, err, hunks, { oldLines: result.oldLines, newLines: result.newLines });
+        });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Compute a digest of a file, or of a range of it, without reading the file into JS. Digests
+     * are cached by the file's identity, size and modification time, so asking again about a file
+     * that hasn't changed, such as the open documents when the window gets the focus, doesn't read
+     * it again. Compare the digest with brackets.fs.hashText of a document to tell whether the file
+     * still has the document's text.
+     *
+     * @param {string|number} path The path of the file, or a handle from brackets.fs.internPaths.
+     * @param {string} algorithm "xxh3" (fast, for telling whether a file changed), "sha1" or
+     *        "sha256".
+     * @param {{offset: number, length: number, bypassCache: boolean}=} options Optional. offset
+     *        and length select the bytes to hash (default the whole file); the range is cut to the
+     *        end of the file. Set bypassCache to read the file even if its digest is cached.
+     * @param {function(err, result)} callback Asynchronous callback function. The callback gets two
+     *        arguments (err, result). result is {hash, offset, length, isDirectory, size, mtime,
+     *        mtimeNsec, cached, time}: the digest as lowercase hex, the range hashed, the file's
+     *        stats, whether the digest came from the cache and the milliseconds spent reading
+     *        and hashing the file.
+     *        Possible error values:
+     *          NO_ERROR
+     *          ERR_UNKNOWN
+     *          ERR_INVALID_PARAMS
+     *          ERR_NOT_FOUND
+     *          ERR_CANT_READ
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel. This is an asynchronous
+     *         call that sends all return information to the callback.
      */
-    native function ReadFile();
-    brackets.fs.readFile = function (path, encoding, callback) {
-        var contents = ReadFile(path, encoding);
-        invokeCallback(callback, getLastError(), contents);
+    native function HashFileAsync();
+    brackets.fs.hashFile = function (path, algorithm, options, callback) {
+        if (typeof options === "function") {
+            callback = options;
+            options = {};
+        }
+        var requestId = HashFileAsync(path, algorithm, options || {}, function (err, result) {
+            invokeCallback(callback, err, result);
+        });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
     };
     
     /**
-     * Write data to a file, replacing the file if it already exists. 
+     * Compute the digests of several files in one call, a few files at a time, as with
+     * brackets.fs.hashFile.
+     *
+     * @param {Array.<string|number>} paths The paths of the files, or handles from
+     *        brackets.fs.internPaths.
+     * @param {string} algorithm "xxh3", "sha1" or "sha256".
+     * @param {{offset: number, length: number, bypassCache: boolean}=} options Optional. As for
+     *        brackets.fs.hashFile, for every file.
+     * @param {function(err, results)} callback Asynchronous callback function. The callback gets two
+     *        arguments (err, results). err is NO_ERROR, ERR_INVALID_PARAMS or ERR_CANCELLED;
+     *        results has the result of each file, as for brackets.fs.hashFile, or the error for
+     *        files that could not be read.
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel. This is an asynchronous
+     *         call that sends all return information to the callback.
+     */
+    native function HashFilesAsync();
+    brackets.fs.hashFiles = function (paths, algorithm, options, callback) {
+        if (typeof options === "function") {
+            callback = options;
+            options = {};
+        }
+        var requestId = HashFilesAsync(paths, algorithm, options || {}, function (err, results) {
+            invokeCallback(callback, err, results);
+        });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Compute the digest of a string, encoded as UTF-8. It is the digest brackets.fs.hashFile gives
+     * for a UTF-8 file with that text, so documents can be compared with their files, or with each
+     * other to find identical ones, by digest.
+     *
+     * @param {string} text The text to hash.
+     * @param {string} algorithm "xxh3", "sha1" or "sha256".
+     *
+     * @return {?string} The digest as lowercase hex, or null if algorithm is not one of these.
+     */
+    native function HashText();
+    brackets.fs.hashText = function (text, algorithm) {
+        var hash = HashText(text, algorithm);
+        return getLastError() === brackets.fs.NO_ERROR ? hash : null;
+    };
+    
+    /**
+     * Counters of the digest cache of brackets.fs.hashFile, for checking that it helps.
+     *
+     * @return {{hits: number, misses: number, bypassed: number, bytes: number, time: number,
+     *           entries: number}} Digests answered from the cache, files that were read, files
+     *         read with bypassCache, the bytes read and hashed and the milliseconds that took
+     *         (bytes / time is the throughput), and the digests cached now.
+     */
+    native function GetHashCacheStats();
+    brackets.fs.getHashCacheStats = function () {
+        return GetHashCacheStats();
+    };
+    
+    /**
+     * Write data to a file, replacing the file if it already exists. The data is written to a
+     * temporary file that then replaces the old one, so a crash never leaves a partly written file.
      *
      * @param {string} path The path of the file to write.
      * @param {string} data The data to write to the file.
-     * @param {string} encoding The encoding for the file. The only supported encoding is 'utf8'.
+     * @param {string} encoding The encoding for the file: any encoding brackets.fs.readFile takes
+     *        but 'auto', normally the one it found. 'utf8bom' and UTF-16 are written with a byte
+     *        order mark. Text that 'latin1' can't hold fails with ERR_UNSUPPORTED_ENCODING.
+     * @param {number=} durability Optional. DURABILITY_NONE, DURABILITY_DATA (the default) or
+     *        DURABILITY_FULL: how much is flushed to disk before the callback is called.
      * @param {function(err)} callback Asynchronous callback function. The callback gets one argument (err).
      *        Possible error values:
      *          NO_ERROR
@@ -264,15 +804,900 @@ if (!brackets.app) {
      *          ERR_UNSUPPORTED_ENCODING
      *          ERR_CANT_WRITE
      *          ERR_OUT_OF_SPACE
+     *          ERR_NOT_FILE
      *                 
+     * @return {number} Request id that can be passed to brackets.fs.cancel. This is an asynchronous
+     *         call that sends all return information to the callback.
+     */
+    native function WriteFileAsync();
+    brackets.fs.writeFile = function (path, data, encoding, durability, callback) {
+        if (typeof durability === "function" || durability === undefined) {
+            callback = durability;
+            durability = brackets.fs.DURABILITY_DATA;
+        }
+        var requestId = WriteFileAsync(path, data, encoding, durability, function (err) {
+            if (callback) {
+                invokeCallback(callback, err);
+            }
+        });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR && callback) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Write several files at once, as when saving every open document. Each file is replaced the
+     * same way writeFile replaces it, but the whole batch shares one flush to disk: every file is
+     * written and flushed, in parallel, before any of them replaces its old version. This is much
+     * faster than saving the files one after another.
+     *
+     * @param {Array.<string>} paths The paths of the files to write.
+     * @param {Array.<string>} datas The data to write, one string per path.
+     * @param {string} encoding The encoding for the files, as for brackets.fs.writeFile.
+     * @param {number=} durability Optional. DURABILITY_NONE, DURABILITY_DATA (the default) or
+     *        DURABILITY_FULL, as for writeFile.
+     * @param {function(err, errors)} callback Asynchronous callback function. The callback gets two
+     *        arguments (err, errors). err is NO_ERROR, ERR_INVALID_PARAMS or ERR_CANCELLED; errors
+     *        is an array with the error code of each file, with the same values as writeFile.
+     *        A file that failed keeps its old contents.
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel. This is an asynchronous
+     *         call that sends all return information to the callback.
+     */
+    native function WriteFilesAsync();
+    brackets.fs.writeFiles = function (paths, datas, encoding, durability, callback) {
+        if (typeof durability === "function" || durability === undefined) {
+            callback = durability;
+            durability = brackets.fs.DURABILITY_DATA;
+        }
+        var requestId = WriteFilesAsync(paths, datas, encoding, durability, function (err, errors) {
+            if (callback) {
+                invokeCallback(callback, err, errors);
+            }
+        });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR && callback) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Watch a directory and everything below it for changes made by other programs, instead of
+     * polling files for their modification time. Changes are gathered for a short time after the
+     * first one and then passed to onChange together, with repeated changes to the same file
+     * combined. onChange gets two arguments (changes, polling):
+     *   changes  An array of {path, kind} objects, where kind is CHANGE_CREATED, CHANGE_MODIFIED,
+     *            CHANGE_DELETED or CHANGE_RESCAN. When a directory is deleted, its contents may or
+     *            may not be listed as well. CHANGE_RESCAN means that changes under path were
+     *            missed, for instance because too many happened at once, and that path should be
+     *            read again.
+     *   polling  true if the tree is being scanned every few seconds because the system could
+     *            not watch it, in which case changes are seen later.
+     *
+     * @param {string} path The directory to watch.
+     * @param {{latency: number, polling: boolean}=} options Optional. latency is how long to
+     *        gather changes, in milliseconds (default 100). Set polling to scan the tree instead
+     *        of using the system's change notifications, which miss changes on some network drives.
+     * @param {function(changes, polling)} onChange Called with each batch of changes.
+     * @param {function(err, watcher)} callback Asynchronous callback function. The callback gets two
+     *        arguments (err, watcher) where watcher is the handle to pass to brackets.fs.unwatch.
+     *        Possible error values:
+     *          NO_ERROR
+     *          ERR_INVALID_PARAMS
+     *          ERR_NOT_FOUND
+     *          ERR_NOT_DIRECTORY
+     *
+     * @return None. This is an asynchronous call that sends all return information to the callback.
+     */
+    native function WatchPath();
+    brackets.fs.watch = function (path, options, onChange, callback) {
+        if (typeof options === "function") {
+            callback = onChange;
+            onChange = options;
+            options = {};
+        }
+        options = options || {};
+        var latency = options.latency === undefined ? 100 : options.latency;
+        var watcher = WatchPath(path, function (changes, polling) {
+            invokeCallback(onChange, changes, polling);
+        }, latency, !!options.polling);
+        invokeCallback(callback, getLastError(), watcher);
+    };
+    
+    /**
+     * Stop a watcher started with brackets.fs.watch. Watchers are also stopped when the page unloads.
+     *
+     * @param {number} watcher The watcher to stop.
+     *
+     * @return {boolean} true if the watcher was running.
+     */
+    native function UnwatchPath();
+    brackets.fs.unwatch = function (watcher) {
+        return UnwatchPath(watcher);
+    };
+    
+    /**
+     * Cache what stat, readdir and the native IsDirectory and GetFileModificationTime return for
+     * everything under a directory, normally the project root. The cache watches the directory
+     * for changes made by any program and drops what they touch, so answers stay current; repeated
+     * stats of the same paths then skip the file system. Calling it again replaces the root.
+     *
+     * @param {string} path The directory to cache, or '' to turn the cache off.
+     *
+     * @return {number} Error code: NO_ERROR, ERR_INVALID_PARAMS, ERR_NOT_FOUND or ERR_NOT_DIRECTORY.
+     */
+    native function SetStatCacheRoot();
+    brackets.fs.setCacheRoot = function (path) {
+        SetStatCacheRoot(path);
+        return getLastError();
+    };
+    
+    /**
+     * Counters of the stat cache, for checking that it helps.
+     *
+     * @return {{hits: number, misses: number, bypassed: number, invalidations: number,
+     *           entries: number, active: boolean}} Lookups answered from the cache and from the
+     *         file system, lookups that asked to bypass it, changes that dropped entries, entries
+     *         cached now, and whether the cache is in use (it is off until its watcher is running).
+     */
+    native function GetStatCacheStats();
+    brackets.fs.getCacheStats = function () {
+        return GetStatCacheStats();
+    };
+    
+    /**
+     * Set how much memory the native cache of file contents may use. brackets.fs.readFile and
+     * brackets.fs.diffFile keep the files they read last in it, shared by every window, and check
+     * each file's size and modification time before answering from it, so switching back to a
+     * file or reopening a project doesn't read the files from disk again. The files read longest
+     * ago are evicted when the cache is full.
+     *
+     * @param {number} bytes The budget, 64 MB by default, or 0 to turn the cache off.
+     *
+     * @return {number} Error code: NO_ERROR or ERR_INVALID_PARAMS.
+     */
+    native function SetContentCacheBudget();
+    brackets.fs.setContentCacheBudget = function (bytes) {
+        SetContentCacheBudget(bytes);
+        return getLastError();
+    };
+    
+    /**
+     * Counters of the file contents cache, for checking that it helps.
+     *
+     * @return {{hits: number, misses: number, hitRatio: number, stale: number, evictions: number,
+     *           bytes: number, budget: number, entries: number}} Reads answered from memory and
+     *         from the disk, the share from memory, entries dropped because their file changed
+     *         and to stay within the budget, and the bytes and files cached now.
+     */
+    native function GetContentCacheStats();
+    brackets.fs.getContentCacheStats = function () {
+        return GetContentCacheStats();
+    };
+    
+    /**
+     * Start a journal of unsaved changes, so that they can be recovered with
+     * brackets.fs.replayJournal if the shell crashes. Record where each dirty document starts from
+     * with brackets.fs.journalSnapshot or brackets.fs.journalBase, then each edit with
+     * brackets.fs.journalEdit, instead of saving the whole document. Records are written and synced
+     * together in the background, so however fast edits come there is one write at a time.
+     * Replaces the journal open before and any file at path.
+     *
+     * @param {string} path The journal file, normally one per session.
+     * @param {number=} commitDelay Optional. Milliseconds to wait after the first record before
+     *        writing, to gather the records that follow it (default 50).
+     *
+     * @return {number} Error code: NO_ERROR, ERR_INVALID_PARAMS or ERR_CANT_WRITE.
+     */
+    native function OpenEditJournal();
+    brackets.fs.openJournal = function (path, commitDelay) {
+        if (commitDelay === undefined) {
+            OpenEditJournal(path);
+        } else {
+            OpenEditJournal(path, commitDelay);
+        }
+        return getLastError();
+    };
+    
+    /**
+     * Write what is left of the journal and close it.
+     *
+     * @param {boolean=} discard Optional. Delete the journal too, when every document was saved or
+     *        closed and there is nothing to recover.
+     *
+     * @return {number} Error code: NO_ERROR, ERR_INVALID_PARAMS or ERR_CANT_WRITE.
+     */
+    native function CloseEditJournal();
+    brackets.fs.closeJournal = function (discard) {
+        CloseEditJournal(!!discard);
+        return getLastError();
+    };
+    
+    /**
+     * Record the whole text of a document, which edits recorded after it apply to. Take a new
+     * snapshot when the edits recorded since the last one add up to more than the document.
+     *
+     * @param {string} path The path of the document.
+     * @param {string} text The text of the document.
+     *
+     * @return {number} Error code: NO_ERROR, ERR_INVALID_PARAMS or ERR_CANT_WRITE if no journal is
+     *         open or the last write failed.
+     */
+    native function JournalSnapshot();
+    brackets.fs.journalSnapshot = function (path, text) {
+        JournalSnapshot(path, text);
+        return getLastError();
+    };
+    
+    /**
+     * Record that a document has the text of its file, as when it was just opened or saved, so that
+     * no snapshot of it has to be written. The text is read back from the file on replay, if the
+     * file still has this digest.
+     *
+     * @param {string} path The path of the document.
+     * @param {string} digest The "xxh3" digest of the file from brackets.fs.hashFile, or of the
+     *        document's text from brackets.fs.hashText.
+     *
+     * @return {number} Error code: NO_ERROR, ERR_INVALID_PARAMS or ERR_CANT_WRITE.
+     */
+    native function JournalBase();
+    brackets.fs.journalBase = function (path, digest) {
+        JournalBase(path, digest);
+        return getLastError();
+    };
+    
+    /**
+     * Record an edit to a document, as a change event of the editor reports it.
+     *
+     * @param {string} path The path of the document.
+     * @param {number} offset Where the edit starts, in characters (UTF-16 code units) from the start
+     *        of the document.
+     * @param {number} removed How many characters it removed.
+     * @param {string} text The text it inserted.
+     *
+     * @return {?number} The bytes recorded for the document since its last snapshot or base, or null
+     *         if no journal is open or the last write failed.
+     */
+    native function JournalEdit();
+    brackets.fs.journalEdit = function (path, offset, removed, text) {
+        var sinceSnapshot = JournalEdit(path, offset, removed, text);
+        return getLastError() === brackets.fs.NO_ERROR ? sinceSnapshot : null;
+    };
+    
+    /**
+     * Record that a document was saved or closed, so that it is not recovered.
+     *
+     * @param {string} path The path of the document.
+     *
+     * @return {number} Error code: NO_ERROR, ERR_INVALID_PARAMS or ERR_CANT_WRITE.
+     */
+    native function JournalClean();
+    brackets.fs.journalClean = function (path) {
+        JournalClean(path);
+        return getLastError();
+    };
+    
+    /**
+     * Wait until every record made so far is on disk, for example before closing a window.
+     *
+     * @param {function(err)} callback Asynchronous callback function. The callback gets one argument
+     *        (err): NO_ERROR, ERR_CANT_WRITE or ERR_CANCELLED.
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel. This is an asynchronous
+     *         call that sends all return information to the callback.
+     */
+    native function FlushEditJournalAsync();
+    brackets.fs.flushJournal = function (callback) {
+        var requestId = FlushEditJournalAsync(function (err) {
+            invokeCallback(callback, err);
+        });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Replay a journal left by a session that didn't close it, and get back the documents that
+     * had unsaved changes.
+     *
+     * @param {string} path The journal file.
+     * @param {function(err, result)} callback Asynchronous callback function. The callback gets two
+     *        arguments (err, result). result is {documents, truncated}: documents has
+     *        {path, text, edits, damaged} for each document with unsaved changes, in the order they
+     *        were first recorded, where text is null if it could not be rebuilt, as when the file
+     *        of a journalBase record has changed since; truncated is set if the journal ends in a
+     *        record cut short by the crash, whose edit is lost.
+     *        Possible error values:
+     *          NO_ERROR
+     *          ERR_UNKNOWN
+     *          ERR_INVALID_PARAMS
+     *          ERR_NOT_FOUND
+     *          ERR_CANT_READ
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel. This is an asynchronous
+     *         call that sends all return information to the callback.
+     */
+    native function ReplayEditJournalAsync();
+    brackets.fs.replayJournal = function (path, callback) {
+        var requestId = ReplayEditJournalAsync(path, function (err, result) {
+            invokeCallback(callback, err, result);
+        });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Counters of the journal, for checking what autosave costs.
+     *
+     * @return {{records: number, bytes: number, flushes: number, recordsPerFlush: number,
+     *           time: number, pending: number}} Records made since the journal was opened and
+     *         their size, the writes that carried them, the milliseconds those took, and the bytes
+     *         waiting for the next write.
+     */
+    native function GetEditJournalStats();
+    brackets.fs.getJournalStats = function () {
+        return GetEditJournalStats();
+    };
+    
+    /**
+     * Keep the paths of a project natively for Quick Open, so that brackets.fs.matchPaths can score
+     * them as the user types without going through every path in JS. Close the matcher with
+     * brackets.fs.closePathMatcher when the project closes; matchers also go away when the page
+     * unloads.
+     *
+     * @param {Array.<string>|number} paths Every path Quick Open should offer, or a path store
+     *        made with brackets.fs.createPathStore, which saves passing the paths through JS.
+     * @param {number=} id With a path store, the directory whose files Quick Open should offer.
+     * @param {function(err, matcher)} callback Asynchronous callback function. The callback gets two
+     *        arguments (err, matcher) where matcher is the handle to pass to the other path
+     *        matcher functions.
+     *        Possible error values:
+     *          NO_ERROR
+     *          ERR_INVALID_PARAMS
+     *          ERR_NOT_FOUND
+     *
+     * @return None. This is an asynchronous call that sends all return information to the callback.
+     */
+    native function CreatePathMatcher();
+    brackets.fs.createPathMatcher = function (paths, id, callback) {
+        var matcher;
+        if (typeof id === "function") {
+            callback = id;
+            matcher = CreatePathMatcher(paths);
+        } else {
+            matcher = CreatePathMatcher(paths, id);
+        }
+        invokeCallback(callback, getLastError(), matcher);
+    };
+    
+    /**
+     * Add and remove paths of a matcher as files are created and deleted.
+     *
+     * @param {number} matcher The matcher to update.
+     * @param {Array.<string>} added Paths to add.
+     * @param {Array.<string>} removed Paths to remove.
+     *
+     * @return {boolean} false if the matcher is closed or the paths are not strings.
+     */
+    native function UpdatePathMatcher();
+    brackets.fs.updatePathMatcher = function (matcher, added, removed) {
+        UpdatePathMatcher(matcher, added || [], removed || []);
+        return getLastError() === brackets.fs.NO_ERROR;
+    };
+    
+    /**
+     * Note that a file was opened, so that it ranks higher in brackets.fs.matchPaths the more
+     * recently and often it is opened. To carry this over from an earlier session, call it again
+     * with the times the files were opened then.
+     *
+     * @param {number} matcher The matcher of the project.
+     * @param {string} path The path that was opened.
+     * @param {number=} time Optional. When it was opened, as given by Date.now(); default now.
+     *
+     * @return {boolean} false if the matcher is closed.
+     */
+    native function RecordPathOpened();
+    brackets.fs.recordPathOpened = function (matcher, path, time) {
+        if (time === undefined) {
+            RecordPathOpened(matcher, path);
+        } else {
+            RecordPathOpened(matcher, path, time);
+        }
+        return getLastError() === brackets.fs.NO_ERROR;
+    };
+    
+    /**
+     * Find the paths that have the characters of query in order, ignoring case, best first. A
+     * match scores higher when its characters start path segments, words or camelCase humps,
+     * follow each other, or are in the file name, and when the file was opened recently and often.
+     * Typing more of a query, or deleting from its end, only scores paths that can still match,
+     * so call this on every keystroke.
+     *
+     * @param {number} matcher The matcher of the project.
+     * @param {string} query What the user typed. An empty query lists the files that were opened.
+     * @param {number=} maxResults Optional. How many results to return, up to 10000 (default 100).
+     *
+     * @return {?Array.<{path: string, score: number, matches: Array.<number>}>} The results, where
+     *         matches has the indexes in path of the matched characters, for highlighting them.
+     *         null if the matcher is closed or the query is longer than 256 bytes.
+     */
+    native function MatchPaths();
+    brackets.fs.matchPaths = function (matcher, query, maxResults) {
+        var results = MatchPaths(matcher, query, maxResults || 100);
+        return getLastError() === brackets.fs.NO_ERROR ? results : null;
+    };
+    
+    /**
+     * Close a matcher made with brackets.fs.createPathMatcher.
+     *
+     * @param {number} matcher The matcher to close.
+     *
+     * @return {boolean} true if the matcher was open.
+     */
+    native function ClosePathMatcher();
+    brackets.fs.closePathMatcher = function (matcher) {
+        return ClosePathMatcher(matcher);
+    };
+    
+    /**
+     * Keep the paths of a project tree natively, as a trie of path segments, instead of one JS string
+     * per path. Each path gets an integer id that stays the same until the path is removed; ids are
+     * not reused. Directory paths end with '/'. Id 0 is the root above every path. Close the store
+     * with brackets.fs.closePathStore when the project closes; stores also go away when the page
+     * unloads.
+     *
+     * @return {number} The handle to pass to the other path store functions.
+     */
+    native function CreatePathStore();
+    brackets.fs.createPathStore = function () {
+        return CreatePathStore();
+    };
+    
+    /**
+     * Fill a path store with everything under a directory, walked natively and in parallel. The
+     * store can be read while it fills. Files are chosen as in brackets.fs.walk.
+     *
+     * @param {number} store The store to fill.
+     * @param {string} root The directory to walk.
+     * @param {{ignore: Array.<string>, gitignore: boolean, maxDepth: number}=} options Optional. As in
+     *        brackets.fs.walk.
+     * @param {function(paths)} onProgress Called now and then with how many paths have been added.
+     * @param {function(err, summary)} callback Called when the walk is done. summary is
+     *        {id, files, directories}: the id of root, and how many files and directories were added.
+     *        Possible error values:
+     *          NO_ERROR
+     *          ERR_INVALID_PARAMS
+     *          ERR_NOT_FOUND
+     *          ERR_NOT_DIRECTORY
+     *          ERR_CANCELLED
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel.
+     */
+    native function LoadPathStoreAsync();
+    brackets.fs.loadPathStore = function (store, root, options, onProgress, callback) {
+        if (typeof options === "function") {
+            callback = onProgress;
+            onProgress = options;
+            options = {};
+        }
+        options = options || {};
+        var nativeOptions = {
+            ignore: options.ignore === undefined ? [".git", "node_modules"] : options.ignore,
+            gitignore: options.gitignore !== false
+        };
+        if (options.maxDepth !== undefined) {
+            nativeOptions.maxDepth = options.maxDepth;
+        }
+        var requestId = LoadPathStoreAsync(store, root, nativeOptions,
+            function (paths) {
+                invokeCallback(onProgress, paths);
+            },
+            function (err, summary) {
+                invokeCallback(callback, err, summary);
+            });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Fill a path store with everything under a directory, like brackets.fs.loadPathStore, but
+     * starting from a snapshot of the tree that the last call for the same directory left in
+     * snapshotPath. The paths of the snapshot are in the store by the first call to onProgress,
+     * so the project can be shown right away. The tree is then checked in the background:
+     * directories that have not changed since are not read again, and onProgress is called with
+     * the paths added and removed since the snapshot was taken. The snapshot is written again if
+     * anything changed. Keep snapshotPath outside the directory, for instance next to the other
+     * files the application keeps for the project.
+     *
+     * @param {number} store The store to fill.
+     * @param {string} root The directory to walk.
+     * @param {string} snapshotPath Where the snapshot is kept. If there is no snapshot, or it is
+     *        damaged or of another directory, the whole tree is read and a new one is written.
+     * @param {{ignore: Array.<string>, gitignore: boolean, maxDepth: number}=} options Optional. As in
+     *        brackets.fs.walk.
+     * @param {function(paths, added, removed)} onProgress Called now and then with how many paths
+     *        below root are in the store, and the arrays of ids added and removed since the last
+     *        call. added and removed are null when there was no snapshot to start from.
+     * @param {function(err, summary)} callback Called when the check is done. summary is
+     *        {id, files, directories, snapshot, reused, listed, added, removed, hash, written, size}:
+     *        the id of root, how many files and directories the tree has, whether the store started
+     *        from a snapshot, how many directories were taken from it and how many were read, how
+     *        many paths were added and removed, a hash of the whole tree as a string, which stays the
+     *        same for as long as the tree does, whether the snapshot was written and its size.
+     *        Possible error values:
+     *          NO_ERROR
+     *          ERR_INVALID_PARAMS
+     *          ERR_NOT_FOUND
+     *          ERR_NOT_DIRECTORY
+     *          ERR_CANT_WRITE
+     *          ERR_CANCELLED
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel.
+     */
+    native function SyncProjectSnapshotAsync();
+    brackets.fs.syncProjectSnapshot = function (store, root, snapshotPath, options, onProgress, callback) {
+        if (typeof options === "function") {
+            callback = onProgress;
+            onProgress = options;
+            options = {};
+        }
+        options = options || {};
+        var nativeOptions = {
+            ignore: options.ignore === undefined ? [".git", "node_modules"] : options.ignore,
+            gitignore: options.gitignore !== false
+        };
+        if (options.maxDepth !== undefined) {
+            nativeOptions.maxDepth = options.maxDepth;
+        }
+        var requestId = SyncProjectSnapshotAsync(store, root, snapshotPath, nativeOptions,
+            function (paths, added, removed) {
+                invokeCallback(onProgress, paths, added, removed);
+            },
+            function (err, summary) {
+                invokeCallback(callback, err, summary);
+            });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Add paths to a store, with the directories above them, as files are created.
+     *
+     * @param {number} store The store.
+     * @param {Array.<string>} paths The paths to add. End directories with '/'.
+     *
+     * @return {?Array.<number>} The ids of paths, or null if the store is closed.
+     */
+    native function AddStorePaths();
+    brackets.fs.addStorePaths = function (store, paths) {
+        var ids = AddStorePaths(store, paths);
+        return getLastError() === brackets.fs.NO_ERROR ? ids : null;
+    };
+    
+    /**
+     * Remove paths from a store, with everything below them, as files are deleted.
+     *
+     * @param {number} store The store.
+     * @param {Array.<number>} ids The ids of the paths to remove.
+     *
+     * @return {number} How many paths were removed.
+     */
+    native function RemoveStorePaths();
+    brackets.fs.removeStorePaths = function (store, ids) {
+        var removed = RemoveStorePaths(store, ids);
+        return getLastError() === brackets.fs.NO_ERROR ? removed : 0;
+    };
+    
+    /**
+     * Look up the ids of paths.
+     *
+     * @param {number} store The store.
+     * @param {Array.<string>} paths The paths to look up. A trailing '/' makes no difference.
+     *
+     * @return {?Array.<number>} The ids of paths, -1 for those not in the store, or null if the
+     *         store is closed.
+     */
+    native function FindStorePaths();
+    brackets.fs.findStorePaths = function (store, paths) {
+        var ids = FindStorePaths(store, paths);
+        return getLastError() === brackets.fs.NO_ERROR ? ids : null;
+    };
+    
+    /**
+     * Get the paths of ids, directories ending with '/'.
+     *
+     * @param {number} store The store.
+     * @param {Array.<number>} ids The ids.
+     *
+     * @return {?Array.<string>} The paths, "" for ids not in the store, or null if the store is closed.
+     */
+    native function GetStorePaths();
+    brackets.fs.getStorePaths = function (store, ids) {
+        var paths = GetStorePaths(store, ids);
+        return getLastError() === brackets.fs.NO_ERROR ? paths : null;
+    };
+    
+    /**
+     * List the paths right below a directory, for showing it in the project tree.
+     *
+     * @param {number} store The store.
+     * @param {number} id The directory, or 0 for the root above every path.
+     *
+     * @return {?{ids: Array.<number>, names: Array.<string>}} The ids and names of the paths, in no
+     *         particular order, the names of directories ending with '/'. null if the store is closed
+     *         or id is not in it.
+     */
+    native function ListStoreChildren();
+    brackets.fs.listStoreChildren = function (store, id) {
+        var children = ListStoreChildren(store, id);
+        return getLastError() === brackets.fs.NO_ERROR ? children : null;
+    };
+    
+    /**
+     * List the files anywhere below a directory.
+     *
+     * @param {number} store The store.
+     * @param {number} id The directory.
+     *
+     * @return {?Array.<number>} The ids of the files, or null if the store is closed or id is not in it.
+     */
+    native function ListStoreFiles();
+    brackets.fs.listStoreFiles = function (store, id) {
+        var files = ListStoreFiles(store, id);
+        return getLastError() === brackets.fs.NO_ERROR ? files : null;
+    };
+    
+    /**
+     * How large a store is.
+     *
+     * @param {number} store The store.
+     *
+     * @return {?{paths: number, names: number, bytes: number}} The paths in the store, the distinct
+     *         names of their segments and the memory it holds, or null if the store is closed.
+     */
+    native function GetPathStoreStats();
+    brackets.fs.getPathStoreStats = function (store) {
+        var stats = GetPathStoreStats(store);
+        return getLastError() === brackets.fs.NO_ERROR ? stats : null;
+    };
+    
+    /**
+     * Close a store made with brackets.fs.createPathStore. Matchers made from it keep their paths.
+     *
+     * @param {number} store The store to close.
+     *
+     * @return {boolean} true if the store was open.
+     */
+    native function ClosePathStore();
+    brackets.fs.closePathStore = function (store) {
+        return ClosePathStore(store);
+    };
+    
+    /**
+     * Get handles for paths that are used often, such as the files of the project. readdir,
+     * readdirWithStats, stat, readFile, writeFile, writeFiles, chmod, unlink and statPaths accept
+     * a handle wherever they take a path, which saves converting the path on every call. Interning the same path again gives the same handle. Handles last
+     * until brackets.fs.releasePathHandles or until the page unloads.
+     *
+     * @param {Array.<string>} paths The paths to intern.
+     *
+     * @return {?Array.<number>} A handle for each path, or null if a path is empty or not a string.
+     */
+    native function InternPaths();
+    brackets.fs.internPaths = function (paths) {
+        var handles = InternPaths(paths);
+        return getLastError() === brackets.fs.NO_ERROR ? handles : null;
+    };
+    
+    /**
+     * Release handles from brackets.fs.internPaths. Released handles are not reused; passing one
+     * to a path function fails with ERR_INVALID_PARAMS.
+     *
+     * @param {Array.<number>} handles The handles to release.
+     *
+     * @return {number} How many of the handles were still interned.
+     */
+    native function ReleasePathHandles();
+    brackets.fs.releasePathHandles = function (handles) {
+        return ReleasePathHandles(handles);
+    };
+    
+    /**
+     * Get information for many files or directories in one call, such as the files of an open
+     * project. Uses the stat cache like brackets.fs.stat.
+     *
+     * @param {Array.<string|number>} paths The paths, or handles from brackets.fs.internPaths.
+     * @param {boolean=} bypassCache Optional. true to ask the file system even if the stat cache
+     *        has the answer.
+     *
+     * @return {?Array.<{isDirectory: boolean, size: number, mtime: Date, mtimeNsec: number}|number>}
+     *         The information for each path, or the error for paths that could not be read, such
+     *         as ERR_NOT_FOUND. null if paths is not an array of paths and handles.
+     */
+    native function StatPaths();
+    brackets.fs.statPaths = function (paths, bypassCache) {
+        var infos = StatPaths(paths, !!bypassCache);
+        return getLastError() === brackets.fs.NO_ERROR ? infos : null;
+    };
+    
+    /**
+     * Open a file for reading a range at a time, for files too large to read whole with readFile,
+     * such as logs. Other programs may keep writing to the file while it is open. Close the stream
+     * with brackets.fs.closeStream when done; streams are also closed when the page unloads.
+     *
+     * @param {string} path The path of the file to open.
+     * @param {function(err, stream)} callback Asynchronous callback function. The callback gets two
+     *        arguments (err, stream) where stream is the handle to pass to the other stream functions.
+     *        Possible error values:
+     *          NO_ERROR
+     *          ERR_UNKNOWN
+     *          ERR_INVALID_PARAMS
+     *          ERR_NOT_FOUND
+     *          ERR_CANT_READ
+     *
      * @return None. This is an asynchronous call that sends all return information to the callback.
      */
-    native function WriteFile();
-    brackets.fs.writeFile = function (path, data, encoding, callback) {
-        WriteFile(path, data, encoding);
-        if (callback) {
-            invokeCallback(callback, getLastError());
+    native function OpenFileStream();
+    brackets.fs.openStream = function (path, callback) {
+        var stream = OpenFileStream(path);
+        invokeCallback(callback, getLastError(), stream);
+    };
+    
+    /**
+     * Close a stream opened with brackets.fs.openStream.
+     *
+     * @param {number} stream The stream to close.
+     *
+     * @return {boolean} true if the stream was open.
+     */
+    native function CloseFileStream();
+    brackets.fs.closeStream = function (stream) {
+        return CloseFileStream(stream);
+    };
+    
+    /**
+     * Read part of an open stream. The callback gets (err, chunk) where chunk is an object:
+     *   data       The text that was read. It never splits a character and, when reading whole
+     *              lines, ends on a line break unless it reaches the end of the file.
+     *   start, end Byte offsets of data in the file. Read again from end to get the next chunk.
+     *   size       Size of the file, in bytes, when it was read.
+     *   eof        true if data reaches the end of the file.
+     *   firstLine  Zero-based line number of the first line in data, when it is known.
+     *   lineCount  Number of lines in data, for readStreamLines.
+     *
+     * Possible error values:
+     *   NO_ERROR
+     *   ERR_UNKNOWN
+     *   ERR_INVALID_PARAMS
+     *   ERR_CANT_READ
+     *   ERR_UNSUPPORTED_ENCODING
+     *
+     * @param {number} stream The stream returned by brackets.fs.openStream.
+     * @param {number} offset Byte offset to start reading at.
+     * @param {number} maxBytes Most bytes to read, from 4 bytes to 64 MB.
+     * @param {boolean} wholeLines true to end the chunk on a line break.
+     * @param {function(err, chunk)} callback Asynchronous callback function.
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel. This is an asynchronous
+     *         call that sends all return information to the callback.
+     */
+    native function ReadFileStreamAsync();
+    brackets.fs.readStream = function (stream, offset, maxBytes, wholeLines, callback) {
+        var requestId = ReadFileStreamAsync(stream, offset, maxBytes, !!wholeLines, function (err, chunk) {
+            invokeCallback(callback, err, chunk);
+        });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
         }
+        return requestId;
+    };
+    
+    /**
+     * Read lines of an open stream. Lines are found with an index that the stream builds as it
+     * goes, so paging anywhere through a large file stays fast. The chunk passed to the callback
+     * is the same as for readStream. Past the last line, chunk.data is empty.
+     *
+     * @param {number} stream The stream returned by brackets.fs.openStream.
+     * @param {number} firstLine Zero-based number of the first line to read.
+     * @param {number} lineCount Most lines to read.
+     * @param {number} maxBytes Most bytes to read, from 4 bytes to 64 MB.
+     * @param {function(err, chunk)} callback Asynchronous callback function.
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel.
+     */
+    native function ReadFileStreamLinesAsync();
+    brackets.fs.readStreamLines = function (stream, firstLine, lineCount, maxBytes, callback) {
+        var requestId = ReadFileStreamLinesAsync(stream, firstLine, lineCount, maxBytes, function (err, chunk) {
+            invokeCallback(callback, err, chunk);
+        });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Read the end of an open stream, starting on a whole line. The chunk passed to the callback
+     * is the same as for readStream.
+     *
+     * @param {number} stream The stream returned by brackets.fs.openStream.
+     * @param {number} maxBytes Most bytes to read, from 4 bytes to 64 MB.
+     * @param {function(err, chunk)} callback Asynchronous callback function.
+     *
+     * @return {number} Request id that can be passed to brackets.fs.cancel.
+     */
+    native function ReadFileStreamTailAsync();
+    brackets.fs.readStreamTail = function (stream, maxBytes, callback) {
+        var requestId = ReadFileStreamTailAsync(stream, maxBytes, function (err, chunk) {
+            invokeCallback(callback, err, chunk);
+        });
+        var err = getLastError();
+        if (err !== brackets.fs.NO_ERROR) {
+            invokeCallback(callback, err);
+        }
+        return requestId;
+    };
+    
+    /**
+     * Follow an open stream as it grows, like tail -f. Reads from offset in whole lines and calls
+     * back with every chunk that has data. Once the end of the file is reached, checks again every
+     * interval milliseconds. Stops on the first error, which is passed to the callback.
+     *
+     * @param {number} stream The stream returned by brackets.fs.openStream.
+     * @param {number} offset Byte offset to start at, usually the end of the last chunk read.
+     * @param {number} interval Milliseconds to wait at the end of the file before reading again.
+     * @param {function(err, chunk)} callback Called for every chunk, as for readStream.
+     *
+     * @return {function()} Call to stop following.
+     */
+    brackets.fs.followStream = function (stream, offset, interval, callback) {
+        var stopped = false;
+        
+        function readNext() {
+            if (stopped) {
+                return;
+            }
+            brackets.fs.readStream(stream, offset, 1024 * 1024, true, function (err, chunk) {
+                if (stopped) {
+                    return;
+                }
+                if (err !== brackets.fs.NO_ERROR) {
+                    stopped = true;
+                    callback(err);
+                    return;
+                }
+                offset = chunk.end;
+                if (chunk.data.length > 0) {
+                    callback(err, chunk);
+                }
+                if (chunk.eof || chunk.data.length === 0) {
+                    setTimeout(readNext, interval);
+                } else {
+                    readNext();
+                }
+            });
+        }
+        
+        readNext();
+        return function () {
+            stopped = true;
+        };
     };
     
     /**
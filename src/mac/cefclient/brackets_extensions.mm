@@ -24,6 +24,10 @@
 
 #include "brackets_extensions.h"
 #include "client_handler.h"
+#include "common/brackets_async.h"
+#include "common/brackets_dispatch.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_fs_extension.h"
 
 #import <Cocoa/Cocoa.h>
 
@@ -34,21 +38,6 @@
 extern CefRefPtr<ClientHandler> g_handler;
 extern CFAbsoluteTime g_appStartupTime;
 
-// Error values. These MUST be in sync with the error values
-// in brackets_extensions.js
-static const int NO_ERROR                   = 0;
-static const int ERR_UNKNOWN                = 1;
-static const int ERR_INVALID_PARAMS         = 2;
-static const int ERR_NOT_FOUND              = 3;
-static const int ERR_CANT_READ              = 4;
-static const int ERR_UNSUPPORTED_ENCODING   = 5;
-static const int ERR_CANT_WRITE             = 6;
-static const int ERR_OUT_OF_SPACE           = 7;
-static const int ERR_NOT_FILE               = 8;
-static const int ERR_NOT_DIRECTORY          = 9;
-
-
-
 @interface ChromeWindowsTerminatedObserver : NSObject
 - (void)appTerminated:(NSNotification *)note;
 - (void)timeoutTimer:(NSTimer*)timer;
@@ -62,6 +51,7 @@ class BracketsExtensionHandler : public CefV8Handler
 public:
     BracketsExtensionHandler() : lastError(0), m_chromeTerminateObserver(nil), m_closeLiveBrowserTimeoutTimer(nil) {
         s_instance = this;
+        RegisterFunctions();
     }
     
     virtual ~BracketsExtensionHandler() {
@@ -79,223 +69,14 @@ public:
     {
         int errorCode = -1;
         
-        if (name == "OpenLiveBrowser")
-        {
-            // OpenLiveBrowser(url)
-            //
-            // Inputs:
-            //  url - url of the document or website to open
-            //
-            // Error:
-            //  NO_ERROR
-            //  ERR_INVALID_PARAMS - invalid parameters
-            //  ERR_UNKNOWN - unable to launch the browser
-            
-            errorCode = OpenLiveBrowser(arguments, retval, exception);
-        }
-        else if (name == "CloseLiveBrowser")
-        {
-            // CloseLiveBrowser()
-            //
-            // Inputs:
-            //  callback - the function to callback when the window has closed or timed out
-            //
-            // Error:
-            //  NO_ERROR - retuned by the function it means the windows where told to close, returned
-            //             in the callback it means the windows are closed
-            //  ERR_INVALID_PARAMS - invalid parameters (the callback is either null or must be a function)
-            //  ERR_UNKNOWN - the timeout expired without the windows closing
-            
-            errorCode = CloseLiveBrowser(arguments, retval, exception);
-        }
-        else if (name == "ShowOpenDialog") 
-        {
-            // showOpenDialog(allowMultipleSelection, chooseDirectory, title, initialPath, fileTypes)
-            //
-            // Inputs:
-            //  allowMultipleSelection - Boolean
-            //  chooseDirectory - Boolean. Choose directory if true, choose file if false
-            //  title - title of the dialog
-            //  initialPath - initial path to display. Pass "" to show default.
-            //  fileTypes - space-delimited string of file extensions, without '.' Pass null to show all file types
-            //
-            // Output:
-            //  "" if no file/directory was selected
-            //  JSON-formatted array of full path names if one or more files were selected
-            //
-            // Error:
-            //  NO_ERROR
-            //  ERR_INVALID_PARAMS - invalid parameters
-            
-            errorCode = ExecuteShowOpenDialog(arguments, retval, exception);
-        }
-        else if (name == "ReadDir")
-        {
-            // ReadDir(path)
-            //
-            // Inputs:
-            //  path - full path of directory to be read
-            //
-            // Outputs:
-            //  JSON-formatted array of the names of the files in the directory, not including '.' and '..'.
-            //
-            // Error:
-            //   NO_ERROR - no error
-            //   ERR_UNKNOWN - unknown error
-            //   ERR_INVALID_PARAMS - invalid parameters
-            //   ERR_NOT_FOUND - directory could not be found
-            //   ERR_CANT_READ - could not read directory
-            
-            errorCode = ExecuteReadDir(arguments, retval, exception);
-        }
-        else if (name == "IsDirectory")
-        {
-            // IsDirectory(path)
-            //
-            // Inputs:
-            //  path - full path of directory to test
-            //
-            // Outputs:
-            //  true if path is a directory, false if error or it is a file
-            //
-            // Error:
-            //  NO_ERROR - no error
-            //  ERR_INVALID_PARAMS - invalid parameters
-            //  ERR_NOT_FOUND - file/directory could not be found
-            
-            errorCode = ExecuteIsDirectory(arguments, retval, exception);
-        }
-        else if (name == "ReadFile")
-        {
-            // ReadFile(path, encoding)
-            //
-            // Inputs:
-            //  path - full path of file to read
-            //  encoding - 'utf8' is the only supported format for now
-            //
-            // Output:
-            //  String - contents of the file
-            //
-            // Error:
-            //  NO_ERROR - no error
-            //  ERR_UNKNOWN - unknown error
-            //  ERR_INVALID_PARAMS - invalid parameters
-            //  ERR_NOT_FOUND - file could not be found
-            //  ERR_CANT_READ - file could not be read
-            //  ERR_UNSUPPORTED_ENCODING - unsupported encoding value 
-            
-            errorCode = ExecuteReadFile(arguments, retval, exception);
-        }
-        else if (name == "WriteFile")
-        {
-            // WriteFile(path, data, encoding)
-            //
-            // Inputs:
-            //  path - full path of file to write
-            //  data - data to write to file
-            //  encoding - 'utf8' is the only supported format for now
-            //
-            // Output:
-            //  none
-            //
-            // Error:
-            //  NO_ERROR - no error
-            //  ERR_UNKNOWN - unknown error
-            //  ERR_INVALID_PARAMS - invalid parameters
-            //  ERR_UNSUPPORTED_ENCODING - unsupported encoding value
-            //  ERR_CANT_WRITE - file could not be written
-            //  ERR_OUT_OF_SPACE - no more space for file
-            
-            errorCode = ExecuteWriteFile(arguments, retval, exception);
-        }
-        else if (name == "SetPosixPermissions")
-        {
-            // SetPosixPermissions(path, mode)
-            //
-            // Inputs:
-            //  path - full path of file or directory
-            //  mode - permissions for file or directory, in numeric format
-            //
-            // Output:
-            //  none
-            //
-            // Errors
-            //  NO_ERROR - no error
-            //  ERR_UNKNOWN - unknown error
-            //  ERR_INVALID_PARAMS - invalid parameters
-            //  ERR_NOT_FOUND - can't file file/directory
-            //  ERR_UNSUPPORTED_ENCODING - unsupported encoding value
-            //  ERR_CANT_WRITE - permissions could not be written
-            
-            errorCode = ExecuteSetPosixPermissions(arguments, retval, exception);
-            
-        }
-        else if ( name == "GetFileModificationTime")
-        {
-            // Returns the time stamp for a file or directory
-            // 
-            // Inputs:
-            //  path - full path of file or directory
-            //
-            // Outputs:
-            // Date - timestamp of file
-            // 
-            // Possible error values:
-            //    NO_ERROR
-            //    ERR_UNKNOWN
-            //    ERR_INVALID_PARAMS
-            //    ERR_NOT_FOUND
-            
-            errorCode = ExecuteGetFileModificationTime( arguments, retval, exception);
-        }
-        else if (name == "DeleteFileOrDirectory")
-        {
-            // DeleteFileOrDirectory(path)
-            //
-            // Inputs:
-            //  path - full path of file or directory
-            //
-            // Ouput:
-            //  none
-            //
-            // Errors
-            //  NO_ERROR - no error
-            //  ERR_UNKNOWN - unknown error
-            //  ERR_INVALID_PARAMS - invalid parameters
-            //  ERR_NOT_FOUND - can't file file/directory
-            
-            errorCode = ExecuteDeleteFileOrDirectory(arguments, retval, exception);
-        }
-        else if (name == "QuitApplication")
-        {
-            // QuitApplication
-            //
-            // Inputs: none
-            // Output: none
-            errorCode = ExecuteQuitApplication(arguments, retval, exception);
-        }
-        else if (name == "ShowDeveloperTools")
-        {
-            errorCode = ExecuteShowDeveloperTools(arguments, retval, exception);
-        }
-        else if (name == "GetElapsedMilliseconds")
+        NativeFunction function = m_functions.Find(name);
+        if (function)
         {
-            // Get
-            //
-            // Inputs: 
-            //  none
-            // Output: 
-            //  Number of milliseconds that have elapsed since the application
-            //  was launched.
-            errorCode = ExecuteGetElapsedMilliseconds(arguments, retval, exception); 
+            errorCode = (this->*function)(arguments, retval, exception);
         }
-        else if (name == "GetLastError")
+        else
         {
-            // Special case private native function to return the last error code.
-            retval = CefV8Value::CreateInt(lastError);
-            
-            // Early exit since we are just returning the last error code
-            return true;
+            errorCode = Brackets::FileSystem::Execute(name, arguments, retval, exception);
         }
         
         if (errorCode != -1) 
@@ -307,6 +88,82 @@ public:
         return false;
     }
     
+    // Binds each native function declared in brackets_extensions.js to the
+    // method that implements it. File system functions are looked up in
+    // Brackets::FileSystem::Execute.
+    void RegisterFunctions()
+    {
+        // OpenLiveBrowser(url)
+        //
+        // Inputs:
+        //  url - url of the document or website to open
+        //
+        // Error:
+        //  NO_ERROR
+        //  ERR_INVALID_PARAMS - invalid parameters
+        //  ERR_UNKNOWN - unable to launch the browser
+        m_functions.Add("OpenLiveBrowser", &BracketsExtensionHandler::OpenLiveBrowser);
+
+        // CloseLiveBrowser()
+        //
+        // Inputs:
+        //  callback - the function to callback when the window has closed or timed out
+        //
+        // Error:
+        //  NO_ERROR - retuned by the function it means the windows where told to close, returned
+        //             in the callback it means the windows are closed
+        //  ERR_INVALID_PARAMS - invalid parameters (the callback is either null or must be a function)
+        //  ERR_UNKNOWN - the timeout expired without the windows closing
+        m_functions.Add("CloseLiveBrowser", &BracketsExtensionHandler::CloseLiveBrowser);
+
+        // showOpenDialog(allowMultipleSelection, chooseDirectory, title, initialPath, fileTypes)
+        //
+        // Inputs:
+        //  allowMultipleSelection - Boolean
+        //  chooseDirectory - Boolean. Choose directory if true, choose file if false
+        //  title - title of the dialog
+        //  initialPath - initial path to display. Pass "" to show default.
+        //  fileTypes - space-delimited string of file extensions, without '.' Pass null to show all file types
+        //
+        // Output:
+        //  Array of full path names. Empty if no file/directory was selected
+        //
+        // Error:
+        //  NO_ERROR
+        //  ERR_INVALID_PARAMS - invalid parameters
+        m_functions.Add("ShowOpenDialog", &BracketsExtensionHandler::ExecuteShowOpenDialog);
+
+        // QuitApplication
+        //
+        // Inputs: none
+        // Output: none
+        m_functions.Add("QuitApplication", &BracketsExtensionHandler::ExecuteQuitApplication);
+
+        m_functions.Add("ShowDeveloperTools", &BracketsExtensionHandler::ExecuteShowDeveloperTools);
+
+        // Get
+        //
+        // Inputs: 
+        //  none
+        // Output: 
+        //  Number of milliseconds that have elapsed since the application
+        //  was launched.
+        m_functions.Add("GetElapsedMilliseconds", &BracketsExtensionHandler::ExecuteGetElapsedMilliseconds);
+
+        // Special case private native function to return the last error code.
+        m_functions.Add("GetLastError", &BracketsExtensionHandler::ExecuteGetLastError);
+    }
+    
+    int ExecuteGetLastError(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception)
+    {
+        retval = CefV8Value::CreateInt(lastError);
+        
+        // Returning lastError leaves it unchanged
+        return lastError;
+    }
+    
     int OpenLiveBrowser(const CefV8ValueList& args,
                               CefRefPtr<CefV8Value>& retval,
                               CefString& exception)
@@ -388,13 +245,10 @@ public:
         CloseLiveBrowserKillTimers();
         
         CefRefPtr<CefV8Context> context = g_handler->GetBrowser()->GetMainFrame()->GetV8Context();
-        CefRefPtr<CefV8Value> objectForThis = context->GetGlobal();
         CefV8ValueList args;
         args.push_back( CefV8Value::CreateInt( valToSend ) );
-        CefRefPtr<CefV8Value> r;
-        CefRefPtr<CefV8Exception> e;
         
-        m_closeLiveBrowserCallback->ExecuteFunctionWithContext( context , objectForThis, args, r, e, false );
+        Brackets::InvokeCallback(context, m_closeLiveBrowserCallback, args);
         
         m_closeLiveBrowserCallback = NULL;
     }
@@ -496,7 +350,7 @@ public:
         std::string title = arguments[2]->GetStringValue();
         std::string initialPath = arguments[3]->GetStringValue();
         std::string fileTypesStr = arguments[4]->GetStringValue();
-        std::string result = "";
+        std::vector<std::string> results;
         
         NSArray* allowedFileTypes = nil;
         
@@ -523,181 +377,18 @@ public:
         
         if ([openPanel runModal] == NSOKButton)
         {
-            NSArrayToJSONString([openPanel filenames], result);
+            NSArray* filenames = [openPanel filenames];
+            for (NSUInteger i = 0; i < [filenames count]; i++)
+                results.push_back([[filenames objectAtIndex:i] UTF8String]);
         }
         
-        retval = CefV8Value::CreateString(result);
+        retval = Brackets::FileSystem::StringListToV8Array(results);
         
         return NO_ERROR;
         
         
     }
     
-    int ExecuteReadDir(const CefV8ValueList& arguments,
-                       CefRefPtr<CefV8Value>& retval,
-                       CefString& exception)
-    {
-        if (arguments.size() != 1 || !arguments[0]->IsString())
-            return ERR_INVALID_PARAMS;
-        
-        std::string pathStr = arguments[0]->GetStringValue();
-        std::string result = "";
-        NSString* path = [NSString stringWithUTF8String:pathStr.c_str()];
-        NSError* error = nil;
-        
-        NSArray* contents = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:path error:&error];
-        
-        if (contents != nil)
-        {
-            NSArrayToJSONString(contents, result);
-            retval = CefV8Value::CreateString(result);
-            return NO_ERROR; 
-        }
-        
-        return ConvertNSErrorCode(error, true);
-    }
-    
-    int ExecuteIsDirectory(const CefV8ValueList& arguments,
-                            CefRefPtr<CefV8Value>& retval,
-                            CefString& exception)
-    {
-        if (arguments.size() != 1 || !arguments[0]->IsString())
-            return ERR_INVALID_PARAMS;
-        
-        std::string pathStr = arguments[0]->GetStringValue();
-        NSString* path = [NSString stringWithUTF8String:pathStr.c_str()];
-        BOOL isDirectory;
-        
-        if ([[NSFileManager defaultManager] fileExistsAtPath:path isDirectory:&isDirectory])
-        {
-            retval = CefV8Value::CreateBool(isDirectory);
-            return NO_ERROR;
-        }
-        
-        return ERR_NOT_FOUND;
-    }
-    
-    int ExecuteReadFile(const CefV8ValueList& arguments,
-                       CefRefPtr<CefV8Value>& retval,
-                       CefString& exception)
-    {
-        if (arguments.size() != 2 || !arguments[0]->IsString() || !arguments[1]->IsString())
-            return ERR_INVALID_PARAMS;
-
-        std::string pathStr = arguments[0]->GetStringValue();
-        std::string encodingStr = arguments[1]->GetStringValue();
-        NSString* path = [NSString stringWithUTF8String:pathStr.c_str()];
-        
-        NSStringEncoding encoding;
-        NSError* error = nil;
-        
-        if (encodingStr == "utf8")
-            encoding = NSUTF8StringEncoding;
-        else
-            return ERR_UNSUPPORTED_ENCODING; 
-        
-        NSString* contents = [NSString stringWithContentsOfFile:path encoding:encoding error:&error];
-        
-        if (contents) 
-        {
-            retval = CefV8Value::CreateString([contents UTF8String]);
-            return NO_ERROR;
-        }
-        
-        return ConvertNSErrorCode(error, true);
-    }
-    
-    int ExecuteWriteFile(const CefV8ValueList& arguments,
-                       CefRefPtr<CefV8Value>& retval,
-                       CefString& exception)
-    {
-        if (arguments.size() != 3 || !arguments[0]->IsString() || !arguments[1]->IsString() || !arguments[2]->IsString())
-            return ERR_INVALID_PARAMS;
-
-        std::string pathStr = arguments[0]->GetStringValue();
-        std::string contentsStr = arguments[1]->GetStringValue();
-        std::string encodingStr = arguments[2]->GetStringValue();
-        
-        NSString* path = [NSString stringWithUTF8String:pathStr.c_str()];
-        NSString* contents = [NSString stringWithUTF8String:contentsStr.c_str()];
-        NSStringEncoding encoding;
-        NSError* error = nil;
-        
-        if (encodingStr == "utf8")
-            encoding = NSUTF8StringEncoding;
-        else
-            return ERR_UNSUPPORTED_ENCODING;
-        
-        const NSData* encodedContents = [ contents dataUsingEncoding:encoding ];
-        NSUInteger len = [ encodedContents length ];
-        NSOutputStream* oStream = [NSOutputStream outputStreamToFileAtPath:path append:NO ];
-        
-        [ oStream open ];
-        NSInteger res = [ oStream write:(const uint8_t*)[encodedContents bytes] maxLength:len];
-        [ oStream close ];
-        
-        if (res == -1) {
-            error = [ oStream streamError ];
-        }        
-        return ConvertNSErrorCode(error, false);
-    }
-    
-    int ExecuteGetFileModificationTime(const CefV8ValueList& arguments,
-                                       CefRefPtr<CefV8Value>& retval,
-                                       CefString& exception)
-    {
-        if (arguments.size() != 1 || !arguments[0]->IsString())
-            return ERR_INVALID_PARAMS;
-        
-        std::string pathStr = arguments[0]->GetStringValue();
-        NSString* path = [NSString stringWithUTF8String:pathStr.c_str()];
-        
-        NSError* error = nil;
-        NSDictionary* fileAttribs = [[NSFileManager defaultManager] attributesOfItemAtPath:path error:&error];
-        NSDate *modDate = [fileAttribs valueForKey:NSFileModificationDate];
-        retval = CefV8Value::CreateDate(CefTime([modDate timeIntervalSince1970]));
-        
-        return ConvertNSErrorCode(error, true);
-    }
-    
-    int ExecuteSetPosixPermissions(const CefV8ValueList& arguments,
-                       CefRefPtr<CefV8Value>& retval,
-                       CefString& exception)
-    {
-        if (arguments.size() != 2 || !arguments[0]->IsString() || !arguments[1]->IsInt())
-            return ERR_INVALID_PARAMS;
-        
-        std::string pathStr = arguments[0]->GetStringValue();
-        int mode = arguments[1]->GetIntValue();
-        NSError* error = nil;
-        
-        NSString* path = [NSString stringWithUTF8String:pathStr.c_str()];
-        NSDictionary* attrs = [NSDictionary dictionaryWithObject:[NSNumber numberWithInt:mode] forKey:NSFilePosixPermissions];
-        
-        if ([[NSFileManager defaultManager] setAttributes:attrs ofItemAtPath:path error:&error])
-            return NO_ERROR;
-        
-        return ConvertNSErrorCode(error, false);
-    }
-    
-    int ExecuteDeleteFileOrDirectory(const CefV8ValueList& arguments,
-                       CefRefPtr<CefV8Value>& retval,
-                       CefString& exception)
-    {
-        if (arguments.size() != 1 || !arguments[0]->IsString())
-            return ERR_INVALID_PARAMS;
-        
-        std::string pathStr = arguments[0]->GetStringValue();
-        NSError* error = nil;
-        
-        NSString* path = [NSString stringWithUTF8String:pathStr.c_str()];
-        
-        if ([[NSFileManager defaultManager] removeItemAtPath:path error:&error])
-            return NO_ERROR;
-        
-        return ConvertNSErrorCode(error, false);
-    }
-  
     int ExecuteQuitApplication(const CefV8ValueList& arguments,
                                CefRefPtr<CefV8Value>& retval,
                                CefString& exception)
@@ -732,106 +423,13 @@ public:
         return NO_ERROR;
     }
 
-    // Escapes characters that have special meaning in JSON
-    void EscapeJSONString(const std::string& str, std::string& result) {
-        result = "";
-        
-        for(size_t pos = 0; pos != str.size(); ++pos) {
-                switch(str[pos]) {
-                    case '\a':  result.append("\\a");   break;
-                    case '\b':  result.append("\\b");   break;
-                    case '\f':  result.append("\\f");   break;
-                    case '\n':  result.append("\\n");   break;
-                    case '\r':  result.append("\\r");   break;
-                    case '\t':  result.append("\\t");   break;
-                    case '\v':  result.append("\\v");   break;
-                    // Note: single quotes are OK for JSON
-                    case '\"':  result.append("\\\"");  break; // double quote
-                    case '\\':  result.append("\\\\");  break; // backslash
-                        
-                        
-                default:   result.append( 1, str[pos]); break;
-                        
-            }
-        }
-    }
-
-    
-    void NSArrayToJSONString(NSArray* array, std::string& result)
-    {        
-        int numItems = [array count];
-        std::string escapedStr = "";
-        
-        result = "[";
-        std::string item;
-        for (int i = 0; i < numItems; i++)
-        {
-            result += "\"";
-            
-            item = [[array objectAtIndex:i] UTF8String];
-            EscapeJSONString(item, escapedStr);
-            
-            result += escapedStr + "\"";
-            
-            if (i < numItems - 1)
-                result += ", ";
-        }
-        result += "]";
-    }
-    
-    int ConvertNSErrorCode(NSError* error, bool isReading)
-    {
-        if (!error)
-            return NO_ERROR;
-        
-        if( [[error domain] isEqualToString: NSPOSIXErrorDomain] )
-        {
-            switch ([error code]) 
-            {
-                case ENOENT:
-                    return ERR_NOT_FOUND;
-                    break;
-                case EPERM:
-                case EACCES:
-                    return (isReading ? ERR_CANT_READ : ERR_CANT_WRITE);
-                    break;
-                case EROFS:
-                    return ERR_CANT_WRITE;
-                    break;
-                case ENOSPC:
-                    return ERR_OUT_OF_SPACE;
-                    break;
-            }
-            
-        }
-        
-            
-        switch ([error code]) 
-        {
-            case NSFileNoSuchFileError:
-            case NSFileReadNoSuchFileError:
-                return ERR_NOT_FOUND;
-                break;
-            case NSFileReadNoPermissionError:
-                return ERR_CANT_READ;
-                break;
-            case NSFileReadInapplicableStringEncodingError:
-                return ERR_UNSUPPORTED_ENCODING;
-                break;
-            case NSFileWriteNoPermissionError:
-                return ERR_CANT_WRITE;
-                break;
-            case NSFileWriteOutOfSpaceError:
-                return ERR_OUT_OF_SPACE;
-                break;
-        }
-        
-        // Unknown error
-        return ERR_UNKNOWN;
-    }
-    
 private:
+    typedef int (BracketsExtensionHandler::*NativeFunction)(const CefV8ValueList& arguments,
+                                                           CefRefPtr<CefV8Value>& retval,
+                                                           CefString& exception);
+    
     int lastError;
+    Brackets::NativeFunctionTable<NativeFunction> m_functions;
     ChromeWindowsTerminatedObserver* m_chromeTerminateObserver;
     NSTimer* m_closeLiveBrowserTimeoutTimer;
     CefRefPtr<CefV8Value> m_closeLiveBrowserCallback;
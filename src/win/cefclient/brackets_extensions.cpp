@@ -24,6 +24,10 @@
 #include "brackets_extensions.h"
 #include "Resource.h"
 #include "client_handler.h"
+#include "common/brackets_async.h"
+#include "common/brackets_dispatch.h"
+#include "common/brackets_fs.h"
+#include "common/brackets_fs_extension.h"
 
 #include <stdio.h>
 #include <sys/types.h>
@@ -40,21 +44,6 @@
 extern CefRefPtr<ClientHandler> g_handler;
 extern DWORD g_appStartupTime;
 
-// Error values. These MUST be in sync with the error values
-// in brackets_extensions.js
-//static const int NO_ERROR                   = 0;
-static const int ERR_UNKNOWN                = 1;
-static const int ERR_INVALID_PARAMS         = 2;
-static const int ERR_NOT_FOUND              = 3;
-static const int ERR_CANT_READ              = 4;
-static const int ERR_UNSUPPORTED_ENCODING   = 5;
-static const int ERR_CANT_WRITE             = 6;
-static const int ERR_OUT_OF_SPACE           = 7;
-static const int ERR_NOT_FILE               = 8;
-static const int ERR_NOT_DIRECTORY          = 9;
-
-
-
 /**
  * Class for implementing native calls from Brackets JavaScript code to native windows functionality
  */
@@ -64,6 +53,7 @@ public:
     BracketsExtensionHandler() : lastError(0), m_closeLiveBrowserHeartbeatTimerId(0), m_closeLiveBrowserTimeoutTimerId(0) {
         ASSERT(s_instance == NULL);
         s_instance = this;
+        RegisterFunctions();
     }
     virtual ~BracketsExtensionHandler() {
         s_instance = NULL;
@@ -79,223 +69,14 @@ public:
     {
         int errorCode = -1;
         
-        if (name == "OpenLiveBrowser")
-        {
-            // OpenLiveBrowser(url)
-            //
-            // Inputs:
-            //  url - url of the document or website to open
-            //
-            // Error:
-            //  NO_ERROR
-            //  ERR_INVALID_PARAMS - invalid parameters
-            //  ERR_UNKNOWN - unable to launch the browser
-            
-            errorCode = OpenLiveBrowser(arguments, retval, exception);
-        }
-        else if ( name == "CloseLiveBrowser" )
-        {
-            // CloseLiveBrowser()
-            //
-            // Inputs:
-            //  callback - the function to callback when the window has closed or timed out
-            //
-            // Error:
-            //  NO_ERROR - retuned by the function it means the windows where told to close, returned
-            //             in the callback it means the windows are closed
-            //  ERR_INVALID_PARAMS - invalid parameters (the callback is either null or must be a function)
-            //  ERR_UNKNOWN - the timeout expired without the windows closing
-
-            errorCode = CloseLiveBrowser(arguments, retval, exception);
-        }
-        else if (name == "ShowOpenDialog") 
-        {
-            // showOpenDialog(allowMultipleSelection, chooseDirectory, title, initialPath, fileTypes)
-            //
-            // Inputs:
-            //  allowMultipleSelection - Boolean
-            //  chooseDirectory - Boolean. Choose directory if true, choose file if false
-            //  title - title of the dialog
-            //  initialPath - initial path to display. Pass null to show all file types
-            //  fileTypes - space-delimited string of file extensions, without '.'
-            //
-            // Output:
-            //  "" if no file/directory was selected
-            //  JSON-formatted array of full path names if one or more files were selected
-            //
-            // Error:
-            //  NO_ERROR
-            //  ERR_INVALID_PARAMS - invalid parameters
-            
-            errorCode = ExecuteShowOpenDialog(arguments, retval, exception);
-        }
-        else if (name == "ReadDir")
+        NativeFunction function = m_functions.Find(name);
+        if (function)
         {
-            // ReadDir(path)
-            //
-            // Inputs:
-            //  path - full path of directory to be read
-            //
-            // Outputs:
-            //  JSON-formatted array of the names of the files in the directory, not including '.' and '..'.
-            //
-            // Error:
-            //   NO_ERROR - no error
-            //   ERR_UNKNOWN - unknown error
-            //   ERR_INVALID_PARAMS - invalid parameters
-            //   ERR_NOT_FOUND - directory could not be found
-            //   ERR_CANT_READ - could not read directory
-            
-            errorCode = ExecuteReadDir(arguments, retval, exception);
+            errorCode = (this->*function)(arguments, retval, exception);
         }
-        else if (name == "IsDirectory")
-        {
-            // IsDirectory(path)
-            //
-            // Inputs:
-            //  path - full path of directory to test
-            //
-            // Outputs:
-            //  true if path is a directory, false if error or it is a file
-            //
-            // Error:
-            //  NO_ERROR - no error
-            //  ERR_INVALID_PARAMS - invalid parameters
-            //  ERR_NOT_FOUND - file/directory could not be found
-            
-            errorCode = ExecuteIsDirectory(arguments, retval, exception);
-        }
-        else if (name == "ReadFile")
-        {
-            // ReadFile(path, encoding)
-            //
-            // Inputs:
-            //  path - full path of file to read
-            //  encoding - 'utf8' is the only supported format for now
-            //
-            // Output:
-            //  String - contents of the file
-            //
-            // Error:
-            //  NO_ERROR - no error
-            //  ERR_UNKNOWN - unknown error
-            //  ERR_INVALID_PARAMS - invalid parameters
-            //  ERR_NOT_FOUND - file could not be found
-            //  ERR_CANT_READ - file could not be read
-            //  ERR_UNSUPPORTED_ENCODING - unsupported encoding value 
-            
-            errorCode = ExecuteReadFile(arguments, retval, exception);
-        }
-        else if (name == "WriteFile")
-        {
-            // WriteFile(path, data, encoding)
-            //
-            // Inputs:
-            //  path - full path of file to write
-            //  data - data to write to file
-            //  encoding - 'utf8' is the only supported format for now
-            //
-            // Output:
-            //  none
-            //
-            // Error:
-            //  NO_ERROR - no error
-            //  ERR_UNKNOWN - unknown error
-            //  ERR_INVALID_PARAMS - invalid parameters
-            //  ERR_UNSUPPORTED_ENCODING - unsupported encoding value
-            //  ERR_CANT_WRITE - file could not be written
-            //  ERR_OUT_OF_SPACE - no more space for file
-            
-            errorCode = ExecuteWriteFile(arguments, retval, exception);
-        }
-        else if (name == "SetPosixPermissions")
-        {
-            // SetPosixPermissions(path, mode)
-            //
-            // Inputs:
-            //  path - full path of file or directory
-            //  mode - permissions for file or directory, in numeric format
-            //
-            // Output:
-            //  none
-            //
-            // Errors
-            //  NO_ERROR - no error
-            //  ERR_UNKNOWN - unknown error
-            //  ERR_INVALID_PARAMS - invalid parameters
-            //  ERR_NOT_FOUND - can't file file/directory
-            //  ERR_UNSUPPORTED_ENCODING - unsupported encoding value
-            //  ERR_CANT_WRITE - permissions could not be written
-            
-            errorCode = ExecuteSetPosixPermissions(arguments, retval, exception);
-            
-        }
-        else if ( name == "GetFileModificationTime")
-        {
-            // Returns the time stamp for a file or directory
-            // 
-            // Inputs:
-            //  path - full path of file or directory
-            //
-            // Outputs:
-            // Date - timestamp of file
-            // 
-            // Possible error values:
-            //    NO_ERROR
-            //    ERR_UNKNOWN
-            //    ERR_INVALID_PARAMS
-            //    ERR_NOT_FOUND
-             
-            errorCode = ExecuteGetFileModificationTime( arguments, retval, exception);
-        }
-        else if (name == "DeleteFileOrDirectory")
-        {
-            // DeleteFileOrDirectory(path)
-            //
-            // Inputs:
-            //  path - full path of file or directory
-            //
-            // Ouput:
-            //  none
-            //
-            // Errors
-            //  NO_ERROR - no error
-            //  ERR_UNKNOWN - unknown error
-            //  ERR_INVALID_PARAMS - invalid parameters
-            //  ERR_NOT_FOUND - can't file file/directory
-            
-            errorCode = ExecuteDeleteFileOrDirectory(arguments, retval, exception);
-        }
-        else if (name == "QuitApplication")
-        {
-            // QuitApplication
-            //
-            // Inputs: none
-            // Output: none
-            errorCode = ExecuteQuitApplication(arguments, retval, exception);
-        }
-        else if (name == "ShowDeveloperTools")
-        {
-            errorCode = ExecuteShowDeveloperTools(arguments, retval, exception);
-        }
-        else if (name == "GetElapsedMilliseconds")
-        {
-            // Get
-            //
-            // Inputs: 
-            //  none
-            // Output: 
-            //  Number of milliseconds that have elapsed since the application
-            //  was launched.
-            errorCode = ExecuteGetElapsedMilliseconds(arguments, retval, exception); 
-        }
-        else if (name == "GetLastError")
+        else
         {
-            // Special case private native function to return the last error code.
-            retval = CefV8Value::CreateInt(lastError);
-            
-            // Early exit since we are just returning the last error code
-            return true;
+            errorCode = Brackets::FileSystem::Execute(name, arguments, retval, exception);
         }
         
         if (errorCode != -1) 
@@ -306,6 +87,82 @@ public:
         
         return false;
     }
+    
+    // Binds each native function declared in brackets_extensions.js to the
+    // method that implements it. File system functions are looked up in
+    // Brackets::FileSystem::Execute.
+    void RegisterFunctions()
+    {
+        // OpenLiveBrowser(url)
+        //
+        // Inputs:
+        //  url - url of the document or website to open
+        //
+        // Error:
+        //  NO_ERROR
+        //  ERR_INVALID_PARAMS - invalid parameters
+        //  ERR_UNKNOWN - unable to launch the browser
+        m_functions.Add("OpenLiveBrowser", &BracketsExtensionHandler::OpenLiveBrowser);
+
+        // CloseLiveBrowser()
+        //
+        // Inputs:
+        //  callback - the function to callback when the window has closed or timed out
+        //
+        // Error:
+        //  NO_ERROR - retuned by the function it means the windows where told to close, returned
+        //             in the callback it means the windows are closed
+        //  ERR_INVALID_PARAMS - invalid parameters (the callback is either null or must be a function)
+        //  ERR_UNKNOWN - the timeout expired without the windows closing
+        m_functions.Add("CloseLiveBrowser", &BracketsExtensionHandler::CloseLiveBrowser);
+
+        // showOpenDialog(allowMultipleSelection, chooseDirectory, title, initialPath, fileTypes)
+        //
+        // Inputs:
+        //  allowMultipleSelection - Boolean
+        //  chooseDirectory - Boolean. Choose directory if true, choose file if false
+        //  title - title of the dialog
+        //  initialPath - initial path to display. Pass null to show all file types
+        //  fileTypes - space-delimited string of file extensions, without '.'
+        //
+        // Output:
+        //  Array of full path names of the selected files. Empty if no file/directory was selected
+        //
+        // Error:
+        //  NO_ERROR
+        //  ERR_INVALID_PARAMS - invalid parameters
+        m_functions.Add("ShowOpenDialog", &BracketsExtensionHandler::ExecuteShowOpenDialog);
+
+        // QuitApplication
+        //
+        // Inputs: none
+        // Output: none
+        m_functions.Add("QuitApplication", &BracketsExtensionHandler::ExecuteQuitApplication);
+
+        m_functions.Add("ShowDeveloperTools", &BracketsExtensionHandler::ExecuteShowDeveloperTools);
+
+        // Get
+        //
+        // Inputs: 
+        //  none
+        // Output: 
+        //  Number of milliseconds that have elapsed since the application
+        //  was launched.
+        m_functions.Add("GetElapsedMilliseconds", &BracketsExtensionHandler::ExecuteGetElapsedMilliseconds);
+
+        // Special case private native function to return the last error code.
+        m_functions.Add("GetLastError", &BracketsExtensionHandler::ExecuteGetLastError);
+    }
+    
+    int ExecuteGetLastError(const CefV8ValueList& arguments,
+                            CefRefPtr<CefV8Value>& retval,
+                            CefString& exception)
+    {
+        retval = CefV8Value::CreateInt(lastError);
+        
+        // Returning lastError leaves it unchanged
+        return lastError;
+    }
 
     static std::wstring GetPathToLiveBrowser() 
     {
@@ -347,7 +204,7 @@ public:
         //is to use the shortpath. It doesn't look as nice, but it always works and never has a space
         if( !ConvertToShortPathName(appPath) ) {
             //If the shortpath failed, we need to bail since we don't know what to call now
-            return ConvertWinErrorCode(GetLastError());
+            return Brackets::FileSystem::ConvertWinErrorCode(GetLastError());
         }
 
 
@@ -370,7 +227,7 @@ public:
         //Send the whole command in through the args param. Windows will parse the first token up to a space
         //as the processes and feed the rest in as the argument string. 
         if (!CreateProcess(NULL, argsBuf.get(), NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
-            return ConvertWinErrorCode(GetLastError());
+            return Brackets::FileSystem::ConvertWinErrorCode(GetLastError());
         }
         
         CloseHandle(pi.hProcess);
@@ -476,13 +333,10 @@ public:
         CloseLiveBrowserKillTimers();
 
         CefRefPtr<CefV8Context> context = g_handler->GetBrowser()->GetMainFrame()->GetV8Context();
-        CefRefPtr<CefV8Value> objectForThis = context->GetGlobal();
         CefV8ValueList args;
         args.push_back( CefV8Value::CreateInt( valToSend ) );
-        CefRefPtr<CefV8Value> r;
-        CefRefPtr<CefV8Exception> e;
 
-        m_closeLiveBrowserCallback->ExecuteFunctionWithContext( context , objectForThis, args, r, e, false );
+        Brackets::InvokeCallback(context, m_closeLiveBrowserCallback, args);
 
         m_closeLiveBrowserCallback = NULL;
     }
@@ -591,7 +445,7 @@ public:
         std::wstring wtitle = arguments[2]->GetStringValue();
         std::wstring initialPath = arguments[3]->GetStringValue();
         std::wstring fileTypesStr = arguments[4]->GetStringValue();
-        std::wstring results = L"[";
+        std::vector<std::wstring> results;
 
         FixFilename(initialPath);
 
@@ -628,11 +482,7 @@ public:
             LPITEMIDLIST pidl = SHBrowseForFolder(&bi);
             if (pidl != 0) {
                 if (SHGetPathFromIDList(pidl, szFile)) {
-                    // Escape the directory path and add it to the JSON array
-                    std::wstring dirPath(szFile);
-                    std::wstring escaped;
-                    EscapeJSONString(dirPath, escaped);
-                    results += L"\"" + escaped + L"\"";
+                    results.push_back(szFile);
                 }
                 IMalloc* pMalloc = NULL;
                 SHGetMalloc(&pMalloc);
@@ -672,15 +522,11 @@ public:
                     // Check for two null terminators, which signal that only one file
                     // was selected
                     if (szFile[dir.length() + 1] == '\0') {
-                        // Escape the single file path and add it to the JSON array
-                        std::wstring escaped;
-                        EscapeJSONString(dir, escaped);
-                        results += L"\"" + escaped + L"\"";
+                        results.push_back(dir);
                     } else {
                         // Multiple files are selected
 
                         wchar_t fullPath[MAX_PATH];
-                        bool firstFile = true;
                         for (int i = dir.length() + 1;;) {
                             // Get the next file name
                             std::wstring file(&szFile[i]);
@@ -692,18 +538,7 @@ public:
                             // The filename is relative to the directory that was specified as
                             // the first string
                             if (PathCombine(fullPath, dir.c_str(), file.c_str()) != NULL)
-                            {
-                                // Append a comma separator if it is not the first file in the list
-                                if (firstFile)
-                                    firstFile = false;
-                                else
-                                    results += L",";
-
-                                // Escape the path and add it to the list
-                                std::wstring escaped;
-                                EscapeJSONString(std::wstring(fullPath), escaped);
-                                results += L"\"" + escaped + L"\"";
-                            }
+                                results.push_back(fullPath);
 
                             // Go to the start of the next file name
                             i += file.length() + 1;
@@ -711,192 +546,20 @@ public:
                     }
                 } else {
                     // If multiple files are not allowed, add the single file
-                    std::wstring escaped;
-                    EscapeJSONString(std::wstring(szFile), escaped);
-                    results += L"\"" + escaped + L"\"";
+                    results.push_back(szFile);
                 }
             }
         }
 
-        results += L"]";
-        retval = CefV8Value::CreateString(results);
-
-        return NO_ERROR;
-    }
-    
-    int ExecuteReadDir(const CefV8ValueList& arguments,
-                       CefRefPtr<CefV8Value>& retval,
-                       CefString& exception)
-    {
-        if (arguments.size() != 1 || !arguments[0]->IsString())
-            return ERR_INVALID_PARAMS;
-        
-        std::wstring pathStr = arguments[0]->GetStringValue();
-        std::wstring resultDirs;
-        std::wstring resultFiles;
-        bool addedOneDir = false;
-        bool addedOneFile = false;
-
-        FixFilename(pathStr);
-        pathStr += L"\\*";
-
-        WIN32_FIND_DATA ffd;
-        HANDLE hFind = FindFirstFile(pathStr.c_str(), &ffd);
+        // Brackets expects forward slashes in paths
+        for (size_t i = 0; i < results.size(); i++)
+            std::replace(results[i].begin(), results[i].end(), '\\', '/');
 
-        if (hFind != INVALID_HANDLE_VALUE) 
-        {
-            do
-            {
-                // Ignore '.' and '..'
-                if (!wcscmp(ffd.cFileName, L".") || !wcscmp(ffd.cFileName, L".."))
-                    continue;
-
-                std::wstring filename;
-                EscapeJSONString(ffd.cFileName, filename);
-
-                // Collect file and directory names separately
-                if (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-                {
-                    if (addedOneDir)
-                        resultDirs += L",";
-                    else
-                        addedOneDir = true;
-                    resultDirs += L"\"" + filename + L"\"";
-                }
-                else
-                {
-                    if (addedOneFile)
-                        resultFiles += L",";
-                    else
-                        addedOneFile = true;
-                    resultFiles += L"\"" + filename + L"\"";
-                }
-            }
-            while (FindNextFile(hFind, &ffd) != 0);
-
-            FindClose(hFind);
-        } 
-        else {
-            return ConvertWinErrorCode(GetLastError());
-        }
+        retval = Brackets::FileSystem::StringListToV8Array(results);
 
-        // On Windows, list directories first, then files
-        std::wstring result = L"[";
-        if (addedOneDir)
-        {
-            result += resultDirs;
-            if (addedOneFile)
-                result += L",";
-        }
-        if (addedOneFile)
-            result += resultFiles;
-        result += L"]";
-        retval = CefV8Value::CreateString(result);
         return NO_ERROR;
     }
     
-    int ExecuteIsDirectory(const CefV8ValueList& arguments,
-                            CefRefPtr<CefV8Value>& retval,
-                            CefString& exception)
-    {
-        if (arguments.size() != 1 || !arguments[0]->IsString())
-            return ERR_INVALID_PARAMS;
-        
-        std::wstring pathStr = arguments[0]->GetStringValue();
-        FixFilename(pathStr);
-
-        DWORD dwAttr = GetFileAttributes(pathStr.c_str());
-
-        if (dwAttr == INVALID_FILE_ATTRIBUTES) {
-            return ConvertWinErrorCode(GetLastError()); 
-        }
-
-        retval = CefV8Value::CreateBool((dwAttr & FILE_ATTRIBUTE_DIRECTORY) != 0);
-        return NO_ERROR;
-    }
-    
-    int ExecuteReadFile(const CefV8ValueList& arguments,
-                       CefRefPtr<CefV8Value>& retval,
-                       CefString& exception)
-    {
-        if (arguments.size() != 2 || !arguments[0]->IsString() || !arguments[1]->IsString())
-            return ERR_INVALID_PARAMS;
-
-        std::wstring pathStr = arguments[0]->GetStringValue();
-        std::wstring encodingStr = arguments[1]->GetStringValue();
-
-        if (encodingStr != L"utf8")
-            return ERR_UNSUPPORTED_ENCODING;
-
-        FixFilename(pathStr);
-        
-        DWORD dwAttr;
-        dwAttr = GetFileAttributes(pathStr.c_str());
-        if (INVALID_FILE_ATTRIBUTES == dwAttr)
-            return ConvertWinErrorCode(GetLastError());
-
-        if (dwAttr & FILE_ATTRIBUTE_DIRECTORY)
-            return ERR_CANT_READ;
-
-        HANDLE hFile = CreateFile(pathStr.c_str(), GENERIC_READ,
-            0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-        int error = NO_ERROR;
-
-        if (INVALID_HANDLE_VALUE == hFile)
-            return ConvertWinErrorCode(GetLastError()); 
-
-        DWORD dwFileSize = GetFileSize(hFile, NULL);
-        DWORD dwBytesRead;
-        char* buffer = (char*)malloc(dwFileSize);
-        if (buffer && ReadFile(hFile, buffer, dwFileSize, &dwBytesRead, NULL)) {
-            std::string contents(buffer, dwFileSize);
-            retval = CefV8Value::CreateString(contents.c_str());
-        }
-        else {
-            if (!buffer)
-                error = ERR_UNKNOWN;
-            else
-                error = ConvertWinErrorCode(GetLastError());
-        }
-        CloseHandle(hFile);
-        if (buffer)
-            free(buffer);
-
-        return error; 
-    }
-    
-    int ExecuteWriteFile(const CefV8ValueList& arguments,
-                       CefRefPtr<CefV8Value>& retval,
-                       CefString& exception)
-    {
-        if (arguments.size() != 3 || !arguments[0]->IsString() || !arguments[1]->IsString() || !arguments[2]->IsString())
-            return ERR_INVALID_PARAMS;
-
-        std::wstring pathStr = arguments[0]->GetStringValue();
-        std::string contentsStr = arguments[1]->GetStringValue();
-        std::wstring encodingStr = arguments[2]->GetStringValue();
-        FixFilename(pathStr);
-
-        if (encodingStr != L"utf8")
-            return ERR_UNSUPPORTED_ENCODING;
-
-        HANDLE hFile = CreateFile(pathStr.c_str(), GENERIC_WRITE,
-            0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-        DWORD dwBytesWritten;
-        int error = NO_ERROR;
-
-        if (INVALID_HANDLE_VALUE == hFile)
-            return ConvertWinErrorCode(GetLastError(), false); 
-
-        // TODO (issue 67) -  Should write to temp file and handle encoding
-        if (!WriteFile(hFile, contentsStr.c_str(), contentsStr.length(), &dwBytesWritten, NULL)) {
-            error = ConvertWinErrorCode(GetLastError(), false);
-        }
-
-        CloseHandle(hFile);
-        return error;
-    }
-
   int ExecuteQuitApplication(const CefV8ValueList& arguments,
                              CefRefPtr<CefV8Value>& retval,
                              CefString& exception)
@@ -924,89 +587,6 @@ public:
         return NO_ERROR;
     }
 
-    int ExecuteGetFileModificationTime(const CefV8ValueList& arguments,
-                                       CefRefPtr<CefV8Value>& retval,
-                                       CefString& exception)
-    {
-        if (arguments.size() != 1 || !arguments[0]->IsString())
-            return ERR_INVALID_PARAMS;
-
-        std::wstring pathStr = arguments[0]->GetStringValue();
-        FixFilename(pathStr);
-
-    // Remove trailing "\", if present. _wstat will fail with a "file not found"
-    // error if a directory has a trailing '\' in the name.
-    if (pathStr[pathStr.length() - 1] == '\\')
-      pathStr[pathStr.length() - 1] = 0;
-
-        /* Alternative implementation
-        WIN32_FILE_ATTRIBUTE_DATA attribData;
-        GET_FILEEX_INFO_LEVELS FileInfosLevel;
-        GetFileAttributesEx( pathStr.c_str(), GetFileExInfoStandard, &attribData);*/
-
-
-        struct _stat buffer;
-        if(_wstat(pathStr.c_str(), &buffer) == -1) {
-            return ConvertErrnoCode(errno); 
-        }
-
-        retval = CefV8Value::CreateDate(buffer.st_mtime);
-
-        return NO_ERROR;
-    }
-    
-    int ExecuteSetPosixPermissions(const CefV8ValueList& arguments,
-                       CefRefPtr<CefV8Value>& retval,
-                       CefString& exception)
-    {
-        if (arguments.size() != 2 || !arguments[0]->IsString() || !arguments[1]->IsInt())
-            return ERR_INVALID_PARAMS;
-        
-        std::wstring pathStr = arguments[0]->GetStringValue();
-        int mode = arguments[1]->GetIntValue();
-        FixFilename(pathStr);
-
-        // Note, Windows cannot set read-only on directories.
-        // See http://support.microsoft.com/kb/326549
-        DWORD dwAttr = GetFileAttributes(pathStr.c_str());
-        if (dwAttr == INVALID_FILE_ATTRIBUTES) {
-            return ConvertWinErrorCode(GetLastError()); 
-        }
-        bool isDir = (dwAttr & FILE_ATTRIBUTE_DIRECTORY) != 0;
-        if(isDir) {
-            return NO_ERROR;
-        }
-
-        // For now only extract permissions for "owner"
-        bool write = (mode & 0200) != 0; 
-        bool read = (mode & 0400) != 0;
-        int mask = (write ? _S_IWRITE : 0) | (read ? _S_IREAD : 0);
-
-        // Note _wchmod only supports setting FILE_ATTRIBUTE_READONLY so 
-        // _S_IREAD is ignored.
-        if (_wchmod(pathStr.c_str(), mask) == -1) {
-            return ConvertErrnoCode(errno); 
-        }
-
-        return NO_ERROR;
-    }
-    
-    int ExecuteDeleteFileOrDirectory(const CefV8ValueList& arguments,
-                       CefRefPtr<CefV8Value>& retval,
-                       CefString& exception)
-    {
-        if (arguments.size() != 1 || !arguments[0]->IsString())
-            return ERR_INVALID_PARAMS;
-        
-        std::wstring pathStr = arguments[0]->GetStringValue();
-        FixFilename(pathStr);
-
-        if (!DeleteFile(pathStr.c_str()))
-            return ConvertWinErrorCode(GetLastError());
-
-        return NO_ERROR;
-    }
-    
     int ExecuteGetElapsedMilliseconds(const CefV8ValueList& arguments,
                                CefRefPtr<CefV8Value>& retval,
                                CefString& exception)
@@ -1040,70 +620,13 @@ public:
         return temp;
     }
 
-    // Escapes characters that have special meaning in JSON
-    void EscapeJSONString(const std::wstring& str, std::wstring& finalResult) {
-        std::wstring result;
-        
-        for(size_t pos = 0; pos != str.size(); ++pos) {
-            switch(str[pos]) {
-                case '\a':  result.append(L"\\a");   break;
-                case '\b':  result.append(L"\\b");   break;
-                case '\f':  result.append(L"\\f");   break;
-                case '\n':  result.append(L"\\n");   break;
-                case '\r':  result.append(L"\\r");   break;
-                case '\t':  result.append(L"\\t");   break;
-                case '\v':  result.append(L"\\v");   break;
-                // Note: single quotes are OK for JSON
-                case '\"':  result.append(L"\\\"");  break; // double quote
-                case '\\':  result.append(L"/");     break; // backslash                        
-                        
-                default:   result.append(1, str[pos]); break;
-            }
-        }
-
-        finalResult = result;
-    }
-
-    // Maps errors from errno.h to the brackets error codes
-    // found in brackets_extensions.js
-    int ConvertErrnoCode(int errorCode, bool isReading = true)
-    {
-        switch (errorCode) {
-        case NO_ERROR:
-            return NO_ERROR;
-        case EINVAL:
-            return ERR_INVALID_PARAMS;
-        case ENOENT:
-            return ERR_NOT_FOUND;
-        default:
-            return ERR_UNKNOWN;
-        }
-    }
-
-    // Maps errors from  WinError.h to the brackets error codes
-    // found in brackets_extensions.js
-    int ConvertWinErrorCode(int errorCode, bool isReading = true)
-    {
-        switch (errorCode) {
-        case NO_ERROR:
-            return NO_ERROR;
-        case ERROR_PATH_NOT_FOUND:
-        case ERROR_FILE_NOT_FOUND:
-            return ERR_NOT_FOUND;
-        case ERROR_ACCESS_DENIED:
-            return isReading ? ERR_CANT_READ : ERR_CANT_WRITE;
-        case ERROR_WRITE_PROTECT:
-            return ERR_CANT_WRITE;
-        case ERROR_HANDLE_DISK_FULL:
-            return ERR_OUT_OF_SPACE;
-        default:
-            return ERR_UNKNOWN;
-        }
-    }
-
-
 private:
+    typedef int (BracketsExtensionHandler::*NativeFunction)(const CefV8ValueList& arguments,
+                                                           CefRefPtr<CefV8Value>& retval,
+                                                           CefString& exception);
+
     int lastError;
+    Brackets::NativeFunctionTable<NativeFunction> m_functions;
     UINT                    m_closeLiveBrowserHeartbeatTimerId;
     UINT                    m_closeLiveBrowserTimeoutTimerId;
     CefRefPtr<CefV8Value>   m_closeLiveBrowserCallback;
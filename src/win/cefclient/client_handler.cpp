@@ -5,6 +5,12 @@
 #include "include/cef.h"
 #include "brackets_extensions.h"
 #include "client_handler.h"
+#include "common/brackets_async.h"
+#include "common/brackets_file_stream.h"
+#include "common/brackets_path_handles.h"
+#include "common/brackets_path_matcher.h"
+#include "common/brackets_path_store.h"
+#include "common/brackets_watcher.h"
 #include "binding_test.h"
 #include "cefclient.h"
 #include "download_handler.h"
@@ -318,6 +324,23 @@ void ClientHandler::OnContextCreated(CefRefPtr<CefBrowser> browser,
   InitBindingTest(browser, frame, context->GetGlobal());
 }
 
+void ClientHandler::OnContextReleased(CefRefPtr<CefBrowser> browser,
+                                      CefRefPtr<CefFrame> frame,
+                                      CefRefPtr<CefV8Context> context)
+{
+  REQUIRE_UI_THREAD();
+
+  // Forget the async requests started from this context, whose callbacks
+  // must not be called once it is gone, close the files it streams, stop
+  // its watchers and drop its path matchers.
+  Brackets::RequestRegistry::GetInstance().ReleaseContext(context);
+  Brackets::FileStreamRegistry::GetInstance().ReleaseContext(context);
+  Brackets::WatcherRegistry::GetInstance().ReleaseContext(context);
+  Brackets::PathMatcherRegistry::GetInstance().ReleaseContext(context);
+  Brackets::PathStoreRegistry::GetInstance().ReleaseContext(context);
+  Brackets::PathHandleRegistry::GetInstance().ReleaseContext(context);
+}
+
 bool ClientHandler::OnDragStart(CefRefPtr<CefBrowser> browser,
                                 CefRefPtr<CefDragData> dragData,
                                 DragOperationsMask mask)